@@ -1,10 +1,9 @@
-#define STB_IMAGE_IMPLEMENTATION
 #include "Application.hpp"
 #include "CommandQueue.hpp"
 
 #include <d3dx12_barriers.h>
+#include <filesystem>
 #include <stdexcept>
-#include "../libs/stb/stb_image.hpp"
 
 Application::Application(HINSTANCE hInstance) : m_hInstance(hInstance),
                                                 m_window(nullptr),
@@ -24,6 +23,22 @@ Application::~Application() {
 }
 
 bool Application::init() {
+    m_jobSystem = std::make_unique<JobSystem>();
+    m_derivedDataCache = std::make_unique<DerivedDataCache>();
+    if (!m_derivedDataCache->open(kDerivedDataCacheDirectory, kDerivedDataCacheMaxSize)) {
+        OutputDebugStringW(L"Warning: derived-data cache unavailable, assets are processed on every run.\n");
+        m_derivedDataCache.reset(); // Loaders treat a null cache as "no caching"
+    }
+    m_fileSystem = std::make_unique<VirtualFileSystem>();
+    if (m_fileSystem->mount(kAssetPackFile)) {
+        OutputDebugStringA((std::string("Mounted ") + kAssetPackFile + "\n").c_str());
+    }
+    m_fileWatcher = std::make_unique<FileWatcher>();
+    if (!m_fileWatcher->open(kAssetDirectory)) {
+        OutputDebugStringW(L"Warning: cannot watch the asset files, hot reload is disabled.\n");
+        m_fileWatcher.reset();
+    }
+
     m_window = std::make_unique<Window>(m_hInstance, L"DX12 Framework", 1280, 720);
     if (!m_window || !m_window->create()) {
         MessageBoxW(nullptr, L"Window creation failed", L"Error", MB_OK | MB_ICONERROR);
@@ -38,6 +53,10 @@ bool Application::init() {
 
     m_rendererRaster = std::make_unique<RenderRaster>();
     m_rendererRayTracing = std::make_unique<RenderRayTracing>();
+    m_rendererRaster->setDerivedDataCache(m_derivedDataCache.get());
+    m_rendererRayTracing->setDerivedDataCache(m_derivedDataCache.get());
+    m_rendererRaster->setFileSystem(m_fileSystem.get());
+    m_rendererRayTracing->setFileSystem(m_fileSystem.get());
     if (!m_rendererRaster || !m_rendererRaster->init(m_device.get(), m_commandQueue.get(), m_swapChain.get(),
                                                      SwapChain::kBackBufferCount)) {
         MessageBoxW(nullptr, L"Failed to create Renderer Raster!", L"Error", MB_OK | MB_ICONERROR);
@@ -55,7 +74,6 @@ bool Application::init() {
         return false;
     }
     updateMatrices();
-    m_rendererRayTracing->buildAccelerationStructures(m_modelMesh.get());
     m_window->show(SW_SHOWDEFAULT);
     return true;
 }
@@ -76,11 +94,18 @@ int Application::run() {
 
         if (m_isRunning) {
             float deltaTime = calculateDeltaTime();
+            updateHotReload();
+            updateLoads();
             update(deltaTime);
-            if (m_useRaytracing) {
-                m_rendererRayTracing->render(deltaTime, m_camera.get(), m_modelMesh.get(), m_textureRayTracing.get());
+            // Placeholders stand in for textures that are still streaming; ray tracing needs the mesh's
+            // acceleration structures, so the raster path (which only clears without a mesh) runs until then
+            Texture* textureRaster = m_textureRaster ? m_textureRaster.get() : m_placeholderRaster.get();
+            Texture* textureRayTracing =
+                    m_textureRayTracing ? m_textureRayTracing.get() : m_placeholderRayTracing.get();
+            if (m_useRaytracing && m_modelMesh) {
+                m_rendererRayTracing->render(deltaTime, m_camera.get(), m_modelMesh.get(), textureRayTracing);
             } else {
-                m_rendererRaster->render(deltaTime, m_camera.get(), m_modelMesh.get(), m_textureRaster.get());
+                m_rendererRaster->render(deltaTime, m_camera.get(), m_modelMesh.get(), textureRaster);
             }
         }
     }
@@ -89,10 +114,26 @@ int Application::run() {
 }
 
 void Application::shutdown() {
+    // Stop streaming first: waits for decode jobs and copies, then drops the unfinished load tasks
+    if (m_assetLoader) {
+        m_assetLoader->shutdown();
+    }
+    m_loadTasks.clear();
+    m_assetLoader.reset();
+    m_fileWatcher.reset();
+
     // Ensure GPU is idle before releasing anything
-    waitForGpuIdleAndClearUploads(); // Use helper
+    if (m_commandQueue) {
+        m_commandQueue->join(); // Wait for all commands to complete
+    }
+
+    // Textures free their SRVs in the renderers' heaps
+    m_textureRaster.reset();
+    m_textureRayTracing.reset();
+    m_placeholderRaster.reset();
+    m_placeholderRayTracing.reset();
 
-    // Shutdown renderer first (releases its DX objects)
+    // Then the renderers (releases their DX objects)
     if (m_rendererRaster) {
         m_rendererRaster->shutdown();
         m_rendererRaster.reset();
@@ -104,7 +145,6 @@ void Application::shutdown() {
 
     // Release Application owned resources
     m_modelMesh.reset();
-    m_textureRaster.reset();
     m_camera.reset();
     m_swapChain.reset(); // Release before queue/device
     m_commandQueue.reset();
@@ -114,6 +154,9 @@ void Application::shutdown() {
         m_window->destroy();
     }
     m_window.reset();
+    m_jobSystem.reset(); // Joins the worker threads
+    m_derivedDataCache.reset();
+    m_fileSystem.reset(); // Unmaps the packs once no loader can read from them
 }
 
 HWND Application::getWindowHandle() {
@@ -201,74 +244,166 @@ bool Application::initDirectX() {
 }
 
 bool Application::loadAssets() {
-    ID3D12Device* device = m_device->getDevice();
-
-    // Need a temporary command list/allocator for asset uploads
-    ComPtr<ID3D12CommandAllocator> allocator;
-    HRESULT hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&allocator));
-    if (FAILED(hr)) return false;
-    allocator->SetName(L"Asset Load Allocator");
-
-    ComPtr<ID3D12GraphicsCommandList> commandList;
-    hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr,
-                                   IID_PPV_ARGS(&commandList));
-    if (FAILED(hr)) return false;
-    commandList->SetName(L"Asset Load Command List");
-
-    m_uploadBuffers.clear(); // Clear previous tracking
-
-    try {
-        m_modelMesh = std::make_unique<Mesh>();
-        // Replace "model.obj" with the path to your OBJ file
-        auto meshUploadBuffers = m_modelMesh->LoadFromObjFile(device, commandList.Get(), "mitsuba.obj");
-        if (meshUploadBuffers.first) {
-            trackUploadBuffer(meshUploadBuffers.first);
-        }
-        if (meshUploadBuffers.second) {
-            trackUploadBuffer(meshUploadBuffers.second);
-        }
-        m_textureRaster = std::make_unique<Texture>();
-        m_textureRayTracing = std::make_unique<Texture>();
-
-        ComPtr<ID3D12Resource> texUploadBufferRaster = m_textureRaster->LoadFromFile(
-            device, commandList.Get(), m_rendererRaster->getSrvHeap().get(), L"texture.png",
-            "Texture Raster"); // Use Renderer's heap
-        trackUploadBuffer(texUploadBufferRaster);
-        
-        ComPtr<ID3D12Resource> texUploadBufferRayTracing = m_textureRayTracing->LoadFromFile(
-            device, commandList.Get(), m_rendererRayTracing->getSrvHeap().get(), L"texture_raytracing.png",
-            "Texture Ray Tracing"); // Use Renderer's heap
-        trackUploadBuffer(texUploadBufferRayTracing);
-    } catch (const std::exception& e) {
-        OutputDebugStringA("Error loading assets: ");
-        OutputDebugStringA(e.what());
-        OutputDebugStringA("\n");
-        // Need to close command list even on error? Maybe just return false
+    m_assetLoader = std::make_unique<AssetLoader>();
+    if (!m_assetLoader->init(m_device->getDevice(), m_commandQueue.get(), m_jobSystem.get(),
+                             m_derivedDataCache.get(), m_fileSystem.get())) {
         return false;
     }
-    // --- Execute Asset Upload Commands ---
-    hr = commandList->Close();
-    if (FAILED(hr)) return false;
-    ID3D12CommandList* ppCommandLists[] = {commandList.Get()};
-    m_commandQueue->executeCommandLists(1, ppCommandLists);
 
-    // Wait for GPU to finish uploads and clear tracking list
-    waitForGpuIdleAndClearUploads();
+    // Nothing waits here: decoding runs on the job system, and each task finishes in updateLoads() once
+    // the GPU has executed its copy
+    startLoad(loadPlaceholders());
+    startLoad(loadModel());
+    startLoad(loadTextures());
+    return true;
+}
 
+void Application::startLoad(Task<void> task) {
+    m_loadTasks.push_back(std::move(task));
+    m_loadTasks.back().start();
+}
 
-    return true;
+Task<void> Application::loadPlaceholders() {
+    TextureImage white;
+    white.width = 1;
+    white.height = 1;
+    white.pixels = {255, 255, 255, 255};
+    m_placeholderRaster = co_await m_assetLoader->uploadTexture(white, m_rendererRaster->getSrvHeap().get(),
+                                                                "Placeholder Raster");
+    m_placeholderRayTracing = co_await m_assetLoader->uploadTexture(
+        white, m_rendererRayTracing->getSrvHeap().get(), "Placeholder Ray Tracing");
 }
 
-void Application::trackUploadBuffer(const ComPtr<ID3D12Resource>& uploadBuffer) {
-    if (uploadBuffer) m_uploadBuffers.push_back(uploadBuffer);
+Task<void> Application::loadModel() {
+    const uint64_t generation = ++m_modelGeneration;
+    MeshImportOptions meshOptions;
+    meshOptions.vertexFormat = kCompactVertexFormat; // 16-byte vertices; both renderers follow the format
+    meshOptions.vertexFormat.splitPositions = true; // 8-byte position stream for the BLAS and depth prepass
+    meshOptions.derivedDataCache = m_derivedDataCache.get();
+    meshOptions.fileSystem = m_fileSystem.get();
+    std::unique_ptr<Mesh> mesh = co_await m_assetLoader->loadMesh(kModelFile, meshOptions);
+    if (generation != m_modelGeneration) {
+        co_return; // The file changed again meanwhile; the newer load replaces the mesh
+    }
+    // Frames in flight may still draw the previous mesh. Of the renderer state only the ray tracing
+    // structures (BLAS, TLAS and hit records) depend on it; the raster path picks the new mesh up as is.
+    m_assetLoader->retire(std::move(m_modelMesh));
+    m_modelMesh = std::move(mesh);
+    // Frames rendered from here on trace the new mesh: the queue runs its acceleration structure build first
+    co_await m_rendererRayTracing->buildAccelerationStructures(m_modelMesh.get(), m_assetLoader->getScheduler());
 }
 
-// Wait for GPU Idle and Clear Upload Buffers
-void Application::waitForGpuIdleAndClearUploads() {
-    if (m_commandQueue) {
-        m_commandQueue->join(); // Wait for all commands to complete
+Task<void> Application::loadTextures() {
+    std::unique_ptr<Texture>* slots[] = {&m_textureRaster, &m_textureRayTracing};
+    uint64_t* generations[] = {&m_textureRasterGeneration, &m_textureRayTracingGeneration};
+    const uint64_t loadGenerations[] = {++m_textureRasterGeneration, ++m_textureRayTracingGeneration};
+    const std::string rasterFile = kTextureRasterFile;
+    const std::string rayTracingFile = kTextureRayTracingFile;
+    std::vector<TextureLoadRequest> requests = {
+        {std::wstring(rasterFile.begin(), rasterFile.end()), m_rendererRaster->getSrvHeap().get(),
+         "Texture Raster"}, // Use Renderer's heap
+        {std::wstring(rayTracingFile.begin(), rayTracingFile.end()), m_rendererRayTracing->getSrvHeap().get(),
+         "Texture Ray Tracing"},
+    };
+    co_await m_assetLoader->loadTextures(std::move(requests), kTextureMemoryBudget,
+                                         [&](size_t index, std::unique_ptr<Texture> texture) {
+        if (loadGenerations[index] != *generations[index]) {
+            return; // Reloaded meanwhile; the newer load replaces it
+        }
+        m_assetLoader->retire(std::move(*slots[index])); // Its SRV is freed once no frame in flight samples it
+        *slots[index] = std::move(texture);
+    });
+}
+
+Task<void> Application::loadTexture(std::unique_ptr<Texture>& texture, uint64_t& generation, const char* filename,
+                                    DescriptorHeap* descriptorHeap, std::string name) {
+    const uint64_t loadGeneration = ++generation;
+    const std::string narrowFilename = filename;
+    std::unique_ptr<Texture> loaded = co_await m_assetLoader->loadTexture(
+        std::wstring(narrowFilename.begin(), narrowFilename.end()), descriptorHeap, std::move(name));
+    if (loadGeneration != generation) {
+        co_return;
+    }
+    m_assetLoader->retire(std::move(texture)); // Its SRV is freed once no frame in flight samples it
+    texture = std::move(loaded);
+}
+
+void Application::updateLoads() {
+    if (!m_assetLoader) {
+        return;
+    }
+    m_assetLoader->update();
+    for (size_t i = 0; i < m_loadTasks.size();) {
+        if (!m_loadTasks[i].isDone()) {
+            ++i;
+            continue;
+        }
+        try {
+            m_loadTasks[i].result();
+        } catch (const std::exception& e) {
+            OutputDebugStringA("Error loading assets: ");
+            OutputDebugStringA(e.what());
+            OutputDebugStringA("\n");
+        }
+        m_loadTasks.erase(m_loadTasks.begin() + i);
+    }
+}
+
+void Application::updateHotReload() {
+    if (!m_fileWatcher || !m_assetLoader) {
+        return;
+    }
+    m_changedFiles.clear();
+    if (m_fileWatcher->poll(m_changedFiles) == 0) {
+        return;
+    }
+    bool reloadModel = false;
+    bool reloadTextureRaster = false;
+    bool reloadTextureRayTracing = false;
+    bool reloadRasterShaders = false;
+    bool reloadRayTracingShaders = false;
+    for (const std::string& path : m_changedFiles) {
+        const std::string extension = std::filesystem::path(path).extension().string();
+        const bool reloadable = path == kModelFile || path == kTextureRasterFile ||
+                                path == kTextureRayTracingFile || extension == ".mtl" || extension == ".hlsl";
+        if (!reloadable) {
+            continue; // Caches written next to the sources and unrelated files
+        }
+        if (m_fileSystem->isPacked(path)) {
+            OutputDebugStringA(("Changed: " + path + " (served from " + kAssetPackFile + ", not reloaded)\n")
+                .c_str());
+            continue;
+        }
+        OutputDebugStringA(("Changed: " + path + "\n").c_str());
+        if (extension == ".hlsl") {
+            // Each renderer has its own shader file; any other one may be included by both
+            reloadRasterShaders |= path != "Raytracing.hlsl";
+            reloadRayTracingShaders |= path != "SimpleShaders.hlsl";
+        }
+        reloadModel |= path == kModelFile || extension == ".mtl";
+        reloadTextureRaster |= path == kTextureRasterFile;
+        reloadTextureRayTracing |= path == kTextureRayTracingFile;
+    }
+
+    // Assets are reprocessed on the job system and swapped in once uploaded, like the first load
+    if (reloadModel) {
+        startLoad(loadModel());
+    }
+    if (reloadTextureRaster) {
+        startLoad(loadTexture(m_textureRaster, m_textureRasterGeneration, kTextureRasterFile,
+                              m_rendererRaster->getSrvHeap().get(), "Texture Raster"));
+    }
+    if (reloadTextureRayTracing) {
+        startLoad(loadTexture(m_textureRayTracing, m_textureRayTracingGeneration, kTextureRayTracingFile,
+                              m_rendererRayTracing->getSrvHeap().get(), "Texture Ray Tracing"));
+    }
+    // Shaders are compiled here; the pipelines are swapped once the frames in flight have completed
+    if (reloadRasterShaders) {
+        m_rendererRaster->reloadShaders();
+    }
+    if (reloadRayTracingShaders) {
+        m_rendererRayTracing->reloadShaders(m_modelMesh.get());
     }
-    m_uploadBuffers.clear(); // Release upload buffers now
 }
 
 void Application::updateMatrices() {
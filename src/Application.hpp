@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AssetLoader.hpp"
 #include "CommandQueue.hpp"
 #include "DX12Device.hpp"
 #include "PipelineStateObject.hpp"
@@ -9,6 +10,11 @@
 #include "Mesh.hpp"
 //#include "Renderer.hpp"
 #include "Texture.hpp"
+#include "asset/DerivedDataCache.hpp"
+#include "asset/VirtualFileSystem.hpp"
+#include "core/FileWatcher.hpp"
+#include "core/JobSystem.hpp"
+#include "core/Task.hpp"
 #include "renderer/RenderRaster.hpp"
 #include "renderer/RenderRayTracing.hpp"
 
@@ -45,6 +51,23 @@ private:
     std::unique_ptr<Window> m_window;
     bool m_isRunning = true;
 
+    // --- CPU jobs (asset import; per-frame systems can use it too) ---
+    std::unique_ptr<JobSystem> m_jobSystem;
+
+    // --- Processed assets (meshes, decoded textures, shader bytecode) reused across runs ---
+    static constexpr const char* kDerivedDataCacheDirectory = "DerivedDataCache";
+    static constexpr uint64_t kDerivedDataCacheMaxSize = uint64_t(2) << 30; // LRU entries evicted beyond 2 GiB
+    std::unique_ptr<DerivedDataCache> m_derivedDataCache;
+
+    // --- Asset files: the pack (built with assetpack) when it exists, then loose files next to the exe ---
+    static constexpr const char* kAssetPackFile = "Assets.pack";
+    std::unique_ptr<VirtualFileSystem> m_fileSystem;
+
+    // --- Hot reload: loose asset files edited while running are reprocessed (packed ones need a new pack) ---
+    static constexpr const char* kAssetDirectory = ".";
+    std::unique_ptr<FileWatcher> m_fileWatcher;
+    std::vector<std::string> m_changedFiles; // Reused every frame
+
     // --- Core DX12 Components (Still owned by Application) ---
     std::unique_ptr<DX12Device> m_device;
     std::unique_ptr<CommandQueue> m_commandQueue;
@@ -55,9 +78,22 @@ private:
     std::unique_ptr<RenderRayTracing> m_rendererRayTracing;
 
     // --- High-Level Assets (Owned by Application) ---
+    // Streamed in by m_loadTasks; until they arrive frames render with the 1x1 placeholders (and no mesh)
+    std::unique_ptr<AssetLoader> m_assetLoader;
+    // A reload started while an older one of the same asset is still running supersedes it
+    static constexpr const char* kModelFile = "mitsuba.obj";
+    static constexpr const char* kTextureRasterFile = "texture.png";
+    static constexpr const char* kTextureRayTracingFile = "texture_raytracing.png";
+    static constexpr uint64_t kTextureMemoryBudget = uint64_t(256) << 20; // Decoded textures awaiting upload
+    std::vector<Task<void>> m_loadTasks;
+    uint64_t m_modelGeneration = 0; // Loads of the model started so far
+    uint64_t m_textureRasterGeneration = 0;
+    uint64_t m_textureRayTracingGeneration = 0;
     std::unique_ptr<Mesh> m_modelMesh;
     std::unique_ptr<Texture> m_textureRaster;
     std::unique_ptr<Texture> m_textureRayTracing;
+    std::unique_ptr<Texture> m_placeholderRaster;
+    std::unique_ptr<Texture> m_placeholderRayTracing;
 
     // --- Camera ---
     std::unique_ptr<Camera> m_camera;
@@ -67,17 +103,29 @@ private:
     LARGE_INTEGER m_frequency = {};
     // float m_totalTime = 0.0f; // Time might be managed by Renderer or passed in
 
-    // Keep upload buffers alive until GPU is done with copies
-    std::vector<ComPtr<ID3D12Resource>> m_uploadBuffers;
     bool m_useRaytracing = true;
 
-    void trackUploadBuffer(const ComPtr<ID3D12Resource>& uploadBuffer);
+    bool initDirectX(); // Creates Device, Queue, SwapChain
 
-    void waitForGpuIdleAndClearUploads(); // Helper to wait and clear
+    bool loadAssets(); // Starts streaming the mesh and textures in
 
-    bool initDirectX(); // Creates Device, Queue, SwapChain
+    Task<void> loadPlaceholders();
+
+    // Loads (or reloads) the model and rebuilds the acceleration structures for it
+    Task<void> loadModel();
+
+    // Loads both textures as one batch, each swapped into its slot as soon as it has been uploaded
+    Task<void> loadTextures();
+
+    // Loads (or reloads) one of the textures into its slot
+    Task<void> loadTexture(std::unique_ptr<Texture>& texture, uint64_t& generation, const char* filename,
+                           DescriptorHeap* descriptorHeap, std::string name);
+
+    void startLoad(Task<void> task);
+
+    void updateLoads(); // Advances the load tasks; called once per frame
 
-    bool loadAssets(); // Creates Mesh, Texture (and their upload buffers)
+    void updateHotReload(); // Starts reloads for the files that changed; called once per frame
 
     void updateMatrices(); // Updates Camera Projection
 
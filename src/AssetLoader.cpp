@@ -0,0 +1,236 @@
+#include "AssetLoader.hpp"
+
+#include <stdexcept>
+#include <utility>
+
+using namespace Microsoft::WRL;
+
+AssetLoader::AssetLoader() {
+}
+
+AssetLoader::~AssetLoader() {
+    shutdown();
+}
+
+bool AssetLoader::init(ID3D12Device* device, CommandQueue* commandQueue, JobSystem* jobSystem,
+                       DerivedDataCache* derivedDataCache, const VirtualFileSystem* fileSystem) {
+    if (!device || !commandQueue || !jobSystem) {
+        return false;
+    }
+    m_device = device;
+    m_commandQueue = commandQueue;
+    m_jobSystem = jobSystem;
+    m_derivedDataCache = derivedDataCache;
+    m_fileSystem = fileSystem;
+    return true;
+}
+
+void AssetLoader::shutdown() {
+    if (m_jobSystem) {
+        try {
+            m_jobSystem->wait(m_decodeJobs); // Each job ends by queuing its task on the scheduler
+        } catch (const std::exception&) {
+            // Decode failures are reported through the tasks themselves
+        }
+    }
+    if (m_commandQueue) {
+        m_commandQueue->join(); // Copies in flight still reference their upload buffers
+    }
+    m_scheduler.clear();
+    m_freeUploadContexts.clear();
+    m_retiredAssets.clear();
+    m_jobSystem = nullptr;
+    m_derivedDataCache = nullptr;
+    m_fileSystem = nullptr;
+    m_commandQueue = nullptr;
+    m_device.Reset();
+}
+
+void AssetLoader::update() {
+    if (!m_commandQueue) {
+        return;
+    }
+    const UINT64 completedFenceValue = m_commandQueue->getFence()->GetCompletedValue();
+    m_scheduler.poll(completedFenceValue);
+    m_retiredAssets.release(completedFenceValue);
+}
+
+void AssetLoader::retire(std::shared_ptr<void> asset) {
+    if (!asset) {
+        return;
+    }
+    if (!m_commandQueue) {
+        return; // Shut down: the GPU is idle, so the asset goes right away
+    }
+    m_retiredAssets.retire(m_commandQueue->signal(), std::move(asset));
+}
+
+bool AssetLoader::isIdle() const {
+    return m_decodeJobs.isDone() && m_scheduler.getWaitingCount() == 0;
+}
+
+Task<std::unique_ptr<Mesh>> AssetLoader::loadMesh(std::string filename, MeshImportOptions options) {
+    // Parse (or map the cache) on a worker; the import itself fans out over the job system
+    co_await resumeOn(*m_jobSystem, m_decodeJobs);
+    options.jobSystem = m_jobSystem;
+    ImportedMesh imported;
+    ::loadMesh(filename, options, imported);
+    OutputDebugStringA(("Mesh " + filename + (imported.fromCache ? ": loaded from cache\n" : ": imported from OBJ\n"))
+        .c_str());
+
+    // The view may point into the mapped cache, which stays open until the upload has been recorded
+    auto mesh = std::make_unique<Mesh>();
+    co_await submitUpload([&](ID3D12GraphicsCommandList* commandList) {
+        return mesh->upload(m_device.Get(), commandList, imported.view, filename);
+    });
+    co_return mesh;
+}
+
+Task<std::unique_ptr<Texture>> AssetLoader::loadTexture(std::wstring filename, DescriptorHeap* descriptorHeap,
+                                                        std::string name) {
+    // Decoded straight into the upload buffer on a worker; only the copy is recorded on the main thread
+    co_await resumeOn(*m_jobSystem, m_decodeJobs);
+    DecodedTexture decoded = Texture::decodeFile(m_device.Get(), filename, m_derivedDataCache, m_fileSystem,
+                                                 m_jobSystem);
+    auto texture = std::make_unique<Texture>();
+    co_await submitUpload([&](ID3D12GraphicsCommandList* commandList) {
+        return UploadBuffers{texture->upload(m_device.Get(), commandList, descriptorHeap, decoded, name)};
+    });
+    co_return texture;
+}
+
+Task<void> AssetLoader::loadTextures(std::vector<TextureLoadRequest> requests, uint64_t memoryBudget,
+                                     std::function<void(size_t index, std::unique_ptr<Texture> texture)> onLoaded) {
+    // The decodes outlive shutdown() until this task is destroyed, so they hold their own references
+    std::vector<DecodedTexture> decoded(requests.size());
+    TextureBatch batch(*m_jobSystem, requests.size(), memoryBudget,
+                       [&requests, &decoded, device = m_device, derivedDataCache = m_derivedDataCache,
+                        fileSystem = m_fileSystem, jobSystem = m_jobSystem](size_t index) {
+                           decoded[index] = Texture::decodeFile(device.Get(), requests[index].filename,
+                                                                derivedDataCache, fileSystem, jobSystem);
+                           return decoded[index].layout.size;
+                       });
+    std::vector<Task<void>> uploads; // One per frame that had textures to hand over, in flight at once
+    std::exception_ptr firstError;
+    auto collectUploads = [&]() {
+        for (size_t i = 0; i < uploads.size();) {
+            if (!uploads[i].isDone()) {
+                ++i;
+                continue;
+            }
+            try {
+                uploads[i].result();
+            } catch (...) {
+                if (!firstError) {
+                    firstError = std::current_exception();
+                }
+            }
+            uploads.erase(uploads.begin() + i);
+        }
+    };
+    while (!batch.isDone() || !uploads.empty()) {
+        co_await m_scheduler.nextPoll();
+        collectUploads();
+        std::vector<TextureBatchResult> finished;
+        batch.poll(finished);
+        if (!finished.empty()) {
+            uploads.push_back(uploadDecodedTextures(std::move(finished), requests, decoded, onLoaded));
+            uploads.back().start();
+        }
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+Task<void> AssetLoader::uploadDecodedTextures(std::vector<TextureBatchResult> finished,
+                                              const std::vector<TextureLoadRequest>& requests,
+                                              std::vector<DecodedTexture>& decoded,
+                                              const std::function<void(size_t, std::unique_ptr<Texture>)>& onLoaded) {
+    std::exception_ptr firstError;
+    std::vector<std::pair<size_t, std::unique_ptr<Texture>>> textures;
+    for (const TextureBatchResult& result : finished) {
+        if (!result.error) {
+            textures.emplace_back(result.index, std::make_unique<Texture>());
+        } else if (!firstError) {
+            firstError = result.error;
+        }
+    }
+    if (!textures.empty()) {
+        co_await submitUpload([&](ID3D12GraphicsCommandList* commandList) {
+            UploadBuffers uploadBuffers;
+            for (auto& [index, texture] : textures) {
+                const TextureLoadRequest& request = requests[index];
+                uploadBuffers.push_back(texture->upload(m_device.Get(), commandList, request.descriptorHeap,
+                                                        decoded[index], request.name));
+                decoded[index] = DecodedTexture(); // The upload buffer is released with the copy
+            }
+            return uploadBuffers;
+        });
+        for (auto& [index, texture] : textures) {
+            onLoaded(index, std::move(texture));
+        }
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+Task<std::unique_ptr<Texture>> AssetLoader::uploadTexture(TextureImage image, DescriptorHeap* descriptorHeap,
+                                                          std::string name) {
+    auto texture = std::make_unique<Texture>();
+    co_await submitUpload([&](ID3D12GraphicsCommandList* commandList) {
+        return UploadBuffers{texture->upload(m_device.Get(), commandList, descriptorHeap, image, name)};
+    });
+    co_return texture;
+}
+
+Task<void> AssetLoader::submitUpload(std::function<UploadBuffers(ID3D12GraphicsCommandList*)> record) {
+    // Command lists, the queue and the descriptor heaps are only used from the main thread
+    co_await m_scheduler.nextPoll();
+
+    UploadContext context;
+    if (!acquireUploadContext(context)) {
+        throw std::runtime_error("Failed to create an upload command list.");
+    }
+    UploadBuffers uploadBuffers;
+    try {
+        uploadBuffers = record(context.commandList.Get());
+    } catch (...) {
+        context.commandList->Close(); // Never executed, so the context can be reused right away
+        m_freeUploadContexts.push_back(std::move(context));
+        throw;
+    }
+    if (FAILED(context.commandList->Close())) {
+        throw std::runtime_error("Failed to close the upload command list.");
+    }
+    ID3D12CommandList* commandLists[] = {context.commandList.Get()};
+    m_commandQueue->executeCommandLists(1, commandLists);
+    const UINT64 fenceValue = m_commandQueue->signal();
+
+    // Resumed by update() once the copy has executed; frames keep being rendered meanwhile
+    co_await m_scheduler.waitForFence(fenceValue);
+    m_freeUploadContexts.push_back(std::move(context));
+}
+
+bool AssetLoader::acquireUploadContext(UploadContext& context) {
+    if (!m_freeUploadContexts.empty()) {
+        context = std::move(m_freeUploadContexts.back());
+        m_freeUploadContexts.pop_back();
+        return SUCCEEDED(context.allocator->Reset()) &&
+               SUCCEEDED(context.commandList->Reset(context.allocator.Get(), nullptr));
+    }
+    HRESULT hr = m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+                                                  IID_PPV_ARGS(&context.allocator));
+    if (FAILED(hr)) {
+        return false;
+    }
+    context.allocator->SetName(L"Asset Upload Allocator");
+    hr = m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, context.allocator.Get(), nullptr,
+                                     IID_PPV_ARGS(&context.commandList));
+    if (FAILED(hr)) {
+        return false;
+    }
+    context.commandList->SetName(L"Asset Upload Command List");
+    return true;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <d3d12.h>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <wrl/client.h>
+
+#include "CommandQueue.hpp"
+#include "DescriptorHeap.hpp"
+#include "Mesh.hpp"
+#include "Texture.hpp"
+#include "asset/DerivedDataCache.hpp"
+#include "asset/TextureBatch.hpp"
+#include "asset/VirtualFileSystem.hpp"
+#include "core/FrameScheduler.hpp"
+#include "core/RetireQueue.hpp"
+#include "core/JobSystem.hpp"
+#include "core/Task.hpp"
+
+// One texture of AssetLoader::loadTextures
+struct TextureLoadRequest {
+    std::wstring filename;
+    DescriptorHeap* descriptorHeap; // Gets the SRV
+    std::string name;
+};
+
+// Asynchronous asset loading: file I/O and decoding run as jobs, then the upload is recorded on the main
+// thread and the task completes once the copy queue fence has passed, without draining the queue.
+// Tasks complete inside update(), which the application calls once per frame on the main thread, so the
+// code after co_await loadMesh()/loadTexture() may use the renderer freely.
+class AssetLoader {
+public:
+    AssetLoader();
+
+    ~AssetLoader();
+
+    // derivedDataCache is optional; textures decoded before are then taken from it. So is fileSystem,
+    // through which textures are read (meshes use MeshImportOptions::fileSystem).
+    bool init(ID3D12Device* device, CommandQueue* commandQueue, JobSystem* jobSystem,
+              DerivedDataCache* derivedDataCache = nullptr, const VirtualFileSystem* fileSystem = nullptr);
+
+    // Waits for in-flight decode jobs and GPU copies; tasks that have not finished are never resumed, so
+    // their owners must destroy them afterwards
+    void shutdown();
+
+    // Resumes the tasks whose stage is ready: decoded assets get their uploads recorded, and finished
+    // copies complete their task
+    void update();
+
+    Task<std::unique_ptr<Mesh>> loadMesh(std::string filename, MeshImportOptions options);
+
+    Task<std::unique_ptr<Texture>> loadTexture(std::wstring filename, DescriptorHeap* descriptorHeap,
+                                               std::string name);
+
+    // Loads many textures at once: they decode in parallel on the job system with at most memoryBudget bytes
+    // decoded and waiting for their upload (see TextureBatch), and every frame the textures decoded since the
+    // last one are uploaded together. onLoaded(index, texture) runs on the main thread once a texture's copy
+    // has executed. A texture that fails does not stop the others; the task rethrows the first failure once
+    // they are all done.
+    Task<void> loadTextures(std::vector<TextureLoadRequest> requests, uint64_t memoryBudget,
+                            std::function<void(size_t index, std::unique_ptr<Texture> texture)> onLoaded);
+
+    // Uploads already decoded pixels (e.g. a placeholder)
+    Task<std::unique_ptr<Texture>> uploadTexture(TextureImage image, DescriptorHeap* descriptorHeap,
+                                                 std::string name);
+
+    // Keeps an asset that frames in flight may still read (e.g. a mesh just replaced by a reload) alive until
+    // the work submitted so far has executed; update() releases it then, without waiting for the GPU
+    void retire(std::shared_ptr<void> asset);
+
+    // Polled by update(), so other GPU work (e.g. an acceleration structure build) can be awaited like uploads
+    FrameScheduler& getScheduler() {
+        return m_scheduler;
+    }
+
+    bool isIdle() const;
+
+private:
+    using UploadBuffers = std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>>;
+
+    // Command allocator and list for one upload, reused once its fence has completed
+    struct UploadContext {
+        Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+        Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList;
+    };
+
+    // Records the upload on the main thread, submits it and completes once the GPU has executed it; the
+    // upload buffers returned by record are released then
+    Task<void> submitUpload(std::function<UploadBuffers(ID3D12GraphicsCommandList*)> record);
+
+    // Uploads textures of a batch in one command list and hands them over once the copy has executed
+    Task<void> uploadDecodedTextures(std::vector<TextureBatchResult> finished,
+                                     const std::vector<TextureLoadRequest>& requests,
+                                     std::vector<DecodedTexture>& decoded,
+                                     const std::function<void(size_t, std::unique_ptr<Texture>)>& onLoaded);
+
+    bool acquireUploadContext(UploadContext& context);
+
+    Microsoft::WRL::ComPtr<ID3D12Device> m_device;
+    CommandQueue* m_commandQueue = nullptr;
+    JobSystem* m_jobSystem = nullptr;
+    DerivedDataCache* m_derivedDataCache = nullptr;
+    const VirtualFileSystem* m_fileSystem = nullptr;
+    JobCounter m_decodeJobs; // Decode stages running on the job system
+    FrameScheduler m_scheduler;
+    std::vector<UploadContext> m_freeUploadContexts;
+    RetireQueue m_retiredAssets;
+};
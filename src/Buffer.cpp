@@ -61,6 +61,23 @@ ComPtr<ID3D12Resource> Buffer::createAndUploadDefaultBuffer(ID3D12Device* device
     if (!device || !cmdList || !data || size == 0) {
         throw std::invalid_argument("Invalid arguments provided to createAndUploadDefaultBuffer.");
     }
+    return createAndUploadDefaultBuffer(device, cmdList, {{data, size, 0}}, size, finalState);
+}
+
+ComPtr<ID3D12Resource> Buffer::createAndUploadDefaultBuffer(ID3D12Device* device,
+                                                            ID3D12GraphicsCommandList* cmdList,
+                                                            std::initializer_list<UploadRegion> regions,
+                                                            size_t size,
+                                                            D3D12_RESOURCE_STATES finalState) {
+    if (!device || !cmdList || size == 0) {
+        throw std::invalid_argument("Invalid arguments provided to createAndUploadDefaultBuffer.");
+    }
+    for (const UploadRegion& region : regions) {
+        if ((!region.data && !region.write && region.size > 0) || region.offset > size ||
+            region.size > size - region.offset) {
+            throw std::invalid_argument("Upload region outside of the buffer in createAndUploadDefaultBuffer.");
+        }
+    }
 
     // 1. Create the default buffer (target)
     if (!create(device, size, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COPY_DEST, false,
@@ -86,13 +103,24 @@ ComPtr<ID3D12Resource> Buffer::createAndUploadDefaultBuffer(ID3D12Device* device
     }
     uploadBuffer->SetName(L"Upload Buffer (Intermediate)");
 
-    // 3. Map, Copy data to upload buffer, unmap
+    // 3. Map, Copy each region to its offset in the upload buffer (gaps are left as-is), unmap
     void* mappedData = nullptr;
     hr = uploadBuffer->Map(0, nullptr, &mappedData);
     if (FAILED(hr)) {
         throw std::runtime_error("Failed to map upload buffer.");
     }
-    memcpy(mappedData, data, size);
+    for (const UploadRegion& region : regions) {
+        if (region.size == 0) { // Empty regions may have no data
+            continue;
+        }
+        uint8_t* destination = static_cast<uint8_t*>(mappedData) + region.offset;
+        if (!region.write) {
+            memcpy(destination, region.data, region.size);
+        } else if (!region.write(destination)) {
+            uploadBuffer->Unmap(0, nullptr);
+            throw std::runtime_error("Failed to write upload region in createAndUploadDefaultBuffer.");
+        }
+    }
     uploadBuffer->Unmap(0, nullptr);
 
     // 4. Record command to copy from upload buffer to default buffer
@@ -1,5 +1,7 @@
 #pragma once
 #include <d3d12.h>
+#include <functional>
+#include <initializer_list>
 #include <wrl/client.h>
 
 // Helper function to calculate aligned buffer sizes
@@ -29,6 +31,21 @@ public:
         ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const void* data, size_t size,
         D3D12_RESOURCE_STATES finalState);
 
+    // One piece of a default buffer filled from several CPU arrays (e.g. split vertex streams)
+    struct UploadRegion {
+        const void* data;
+        size_t size;
+        size_t offset; // Destination byte offset; regions must not overlap
+        // Optional: writes the size bytes itself instead of copying data (e.g. decompresses a stream straight
+        // into the upload buffer, which is write-combined: write sequentially, never read). False on failure.
+        std::function<bool(void* destination)> write = nullptr;
+    };
+
+    // Same as above, but copies each region into place through a single upload buffer of the given size
+    Microsoft::WRL::ComPtr<ID3D12Resource> createAndUploadDefaultBuffer(
+        ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, std::initializer_list<UploadRegion> regions,
+        size_t size, D3D12_RESOURCE_STATES finalState);
+
     void* map();
 
     void unmap(size_t writtenSize = -1);
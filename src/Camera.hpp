@@ -26,6 +26,14 @@ public:
 
     glm::vec3 getPosition() const;
 
+    float getFovY() const {
+        return m_fovYRadians;
+    }
+
+    float getNearZ() const {
+        return m_nearZ;
+    }
+
 private:
     float m_radius = 5.0f; // Distance from the camera to the target
     float m_theta = 0.0f; // Horizontal angle
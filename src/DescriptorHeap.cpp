@@ -23,6 +23,7 @@ bool DescriptorHeap::create(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE typ
     m_numDescriptorsInHeap = numDescriptors;
     m_shaderVisible = shaderVisible;
     m_currentDescriptorIndex = 0;
+    m_freeDescriptors.clear();
 
     D3D12_DESCRIPTOR_HEAP_DESC desc = {};
     desc.NumDescriptors = numDescriptors;
@@ -68,6 +69,16 @@ bool DescriptorHeap::create(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE typ
 
 bool DescriptorHeap::allocateDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE& outCPUHandle,
                                         D3D12_GPU_DESCRIPTOR_HANDLE& outGPUHandle) {
+    if (m_heap && !m_freeDescriptors.empty()) {
+        const UINT index = m_freeDescriptors.back();
+        m_freeDescriptors.pop_back();
+        outCPUHandle = CD3DX12_CPU_DESCRIPTOR_HANDLE(m_startCPU, index, m_descriptorSize);
+        outGPUHandle = {0};
+        if (m_shaderVisible) {
+            outGPUHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(m_startGPU, index, m_descriptorSize);
+        }
+        return true;
+    }
     if (!m_heap || m_currentDescriptorIndex >= m_numDescriptorsInHeap) {
         outCPUHandle = {0};
         outGPUHandle = {0};
@@ -88,3 +99,13 @@ bool DescriptorHeap::allocateDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE& outCPUHandl
     m_currentDescriptorIndex++;
     return true;
 }
+
+void DescriptorHeap::freeDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle) {
+    if (!m_heap || cpuHandle.ptr < m_startCPU.ptr || m_descriptorSize == 0) {
+        return;
+    }
+    const UINT index = static_cast<UINT>((cpuHandle.ptr - m_startCPU.ptr) / m_descriptorSize);
+    if (index < static_cast<UINT>(m_currentDescriptorIndex)) {
+        m_freeDescriptors.push_back(index);
+    }
+}
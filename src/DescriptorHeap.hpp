@@ -1,5 +1,6 @@
 #pragma once
 #include <d3d12.h>
+#include <vector>
 #include <wrl/client.h>
 
 
@@ -14,6 +15,10 @@ public:
     bool allocateDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE& outCPUHandle,
                             D3D12_GPU_DESCRIPTOR_HANDLE& outGPUHandle);
 
+    // Returns a descriptor to the heap for the next allocation. The GPU must be done with it (e.g. the
+    // texture that owned it was released once its last frame completed).
+    void freeDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle);
+
     // Getters
     ID3D12DescriptorHeap* getHeapPointer() const {
         return m_heap.Get();
@@ -32,7 +37,7 @@ public:
 
     UINT getCurrentSize() const {
         return m_currentDescriptorIndex;
-    } // How many allocated
+    } // High-water mark, including freed descriptors
 
 private:
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_heap;
@@ -44,6 +49,7 @@ private:
     D3D12_CPU_DESCRIPTOR_HANDLE m_startCPU;
     D3D12_GPU_DESCRIPTOR_HANDLE m_startGPU; 
 
-    // Simple linear allocator state
+    // Simple linear allocator state; freed descriptors are reused first
     INT m_currentDescriptorIndex;
+    std::vector<UINT> m_freeDescriptors;
 };
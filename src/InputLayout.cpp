@@ -0,0 +1,88 @@
+#include "InputLayout.hpp"
+
+#include <array>
+
+namespace {
+    // Every VertexFormat maps to one index in [0, kVertexFormatCount) so the runtime lookup below can
+    // be a table of per-format instantiations
+    constexpr size_t kVertexFormatCount = 2 * 2 * 3 * 2 * 2;
+
+    constexpr VertexFormat vertexFormatFromIndex(size_t index) {
+        VertexFormat format;
+        format.splitPositions = (index % 2) != 0;
+        format.color = ((index / 2) % 2) != 0;
+        format.texCoord = static_cast<TexCoordEncoding>((index / 4) % 3);
+        format.normal = static_cast<NormalEncoding>((index / 12) % 2);
+        format.position = static_cast<PositionEncoding>((index / 24) % 2);
+        return format;
+    }
+
+    constexpr size_t vertexFormatIndex(const VertexFormat& format) {
+        return size_t(format.splitPositions) + 2 * size_t(format.color) + 4 * size_t(format.texCoord) +
+               12 * size_t(format.normal) + 24 * size_t(format.position);
+    }
+
+    // The template layouts and the encoder layout (getVertexLayout) must agree byte for byte
+    template <VertexFormat F>
+    constexpr bool matchesVertexLayout() {
+        using Input = VertexInputLayout<F>;
+        constexpr VertexLayout layout = getVertexLayout(F);
+        using Main = typename Input::AttributeStream;
+        if (F.splitPositions) {
+            return Input::PositionStream::stride == layout.positionStride &&
+                   Input::PositionStream::offsetOf("POSITION") == layout.positionOffset &&
+                   Main::stride == layout.stride &&
+                   Main::offsetOf("COLOR") == layout.colorOffset &&
+                   Main::offsetOf("TEXCOORD") == layout.texCoordOffset &&
+                   Main::offsetOf("NORMAL") == layout.normalOffset;
+        }
+        using Interleaved = typename Input::InterleavedStream;
+        return layout.positionStride == 0 &&
+               Interleaved::stride == layout.stride &&
+               Interleaved::offsetOf("POSITION") == layout.positionOffset &&
+               Interleaved::offsetOf("COLOR") == layout.colorOffset &&
+               Interleaved::offsetOf("TEXCOORD") == layout.texCoordOffset &&
+               Interleaved::offsetOf("NORMAL") == layout.normalOffset;
+    }
+
+    template <size_t... I>
+    constexpr bool allLayoutsMatch(std::index_sequence<I...>) {
+        return (matchesVertexLayout<vertexFormatFromIndex(I)>() && ...);
+    }
+
+    static_assert(allLayoutsMatch(std::make_index_sequence<kVertexFormatCount>()),
+                  "VertexInputLayout disagrees with getVertexLayout");
+
+    template <size_t... I>
+    constexpr bool indicesRoundTrip(std::index_sequence<I...>) {
+        return ((vertexFormatIndex(vertexFormatFromIndex(I)) == I) && ...);
+    }
+
+    static_assert(indicesRoundTrip(std::make_index_sequence<kVertexFormatCount>()));
+
+    using ElementDescsFunction = std::vector<D3D12_INPUT_ELEMENT_DESC> (*)(bool positionOnly);
+
+    template <VertexFormat F>
+    std::vector<D3D12_INPUT_ELEMENT_DESC> buildElementDescs(bool positionOnly) {
+        return positionOnly
+                   ? VertexInputLayout<F>::PositionLayout::getElementDescs()
+                   : VertexInputLayout<F>::Layout::getElementDescs();
+    }
+
+    template <size_t... I>
+    constexpr std::array<ElementDescsFunction, sizeof...(I)> makeElementDescsTable(std::index_sequence<I...>) {
+        return {&buildElementDescs<vertexFormatFromIndex(I)>...};
+    }
+
+    constexpr auto kElementDescsTable = makeElementDescsTable(std::make_index_sequence<kVertexFormatCount>());
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> getInputElementDescs(const VertexFormat& format, bool positionOnly) {
+    return kElementDescsTable[vertexFormatIndex(format)](positionOnly);
+}
+
+DXGI_FORMAT getPositionFormat(const VertexFormat& format) {
+    return format.position == PositionEncoding::Float32
+               ? PositionElement<PositionEncoding::Float32>::type::format
+               : PositionElement<PositionEncoding::Snorm16>::type::format;
+}
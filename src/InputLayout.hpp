@@ -0,0 +1,138 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <d3d12.h>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "asset/VertexFormat.hpp"
+
+// Compile-time vertex input layouts. A layout is described once as streams of typed, named elements;
+// strides, offsets and the D3D12_INPUT_ELEMENT_DESC array are all derived from that single definition.
+// Element types carry their byte size and the DXGI format the input assembler reads them with.
+
+template <DXGI_FORMAT Format, uint32_t Size>
+struct InputElementType {
+    static constexpr DXGI_FORMAT format = Format;
+    static constexpr uint32_t size = Size;
+};
+
+using Float2Element = InputElementType<DXGI_FORMAT_R32G32_FLOAT, 8>;
+using Float3Element = InputElementType<DXGI_FORMAT_R32G32B32_FLOAT, 12>;
+using Float4Element = InputElementType<DXGI_FORMAT_R32G32B32A32_FLOAT, 16>;
+using Half2Element = InputElementType<DXGI_FORMAT_R16G16_FLOAT, 4>;
+using Unorm16x2Element = InputElementType<DXGI_FORMAT_R16G16_UNORM, 4>;
+using Snorm16x2Element = InputElementType<DXGI_FORMAT_R16G16_SNORM, 4>;
+using Snorm16x4Element = InputElementType<DXGI_FORMAT_R16G16B16A16_SNORM, 8>;
+
+// String literal usable as a template argument, e.g. InputElement<"NORMAL", Float3Element>
+template <size_t N>
+struct SemanticName {
+    char value[N] = {};
+
+    constexpr SemanticName(const char (&name)[N]) {
+        for (size_t i = 0; i < N; ++i) {
+            value[i] = name[i];
+        }
+    }
+};
+
+template <SemanticName Name, typename Type, UINT SemanticIndex = 0>
+struct InputElement {
+    using type = Type;
+    static constexpr const char* semantic = Name.value; // Template parameter objects have static storage
+    static constexpr UINT semanticIndex = SemanticIndex;
+};
+
+// Tightly packed elements bound to one vertex buffer slot, in declaration order
+template <typename... Elements>
+struct InputStream {
+    static constexpr uint32_t elementCount = sizeof...(Elements);
+    static constexpr uint32_t stride = (0u + ... + Elements::type::size);
+
+    // Byte offset of the element with this semantic, kNoVertexAttribute if the stream has none
+    static constexpr uint32_t offsetOf(std::string_view semantic) {
+        uint32_t offset = 0;
+        uint32_t found = kNoVertexAttribute;
+        ((found = (found == kNoVertexAttribute && semantic == Elements::semantic) ? offset : found,
+          offset += Elements::type::size), ...);
+        return found;
+    }
+
+    static void appendElements(std::vector<D3D12_INPUT_ELEMENT_DESC>& elements, UINT slot) {
+        UINT offset = 0;
+        ((elements.push_back({
+              Elements::semantic, Elements::semanticIndex, Elements::type::format, slot, offset,
+              D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
+          }),
+          offset += Elements::type::size), ...);
+    }
+};
+
+// Streams in slot order (slot = position in the pack)
+template <typename... Streams>
+struct InputLayout {
+    static constexpr uint32_t streamCount = sizeof...(Streams);
+
+    static std::vector<D3D12_INPUT_ELEMENT_DESC> getElementDescs() {
+        std::vector<D3D12_INPUT_ELEMENT_DESC> elements;
+        elements.reserve((0u + ... + Streams::elementCount));
+        UINT slot = 0;
+        (Streams::appendElements(elements, slot++), ...);
+        return elements;
+    }
+};
+
+namespace InputLayoutDetail {
+    template <typename A, typename B>
+    struct ConcatStreams;
+
+    template <typename... A, typename... B>
+    struct ConcatStreams<InputStream<A...>, InputStream<B...>> {
+        using type = InputStream<A..., B...>;
+    };
+}
+
+// --- VertexFormat -> layout ---
+// Every encoding in VertexFormat.hpp maps to exactly one element type here; InputLayout.cpp checks the
+// resulting strides and offsets against getVertexLayout for all format combinations.
+
+template <PositionEncoding E>
+using PositionElement = InputElement<"POSITION",
+    std::conditional_t<E == PositionEncoding::Float32, Float3Element, Snorm16x4Element>>;
+
+template <NormalEncoding E>
+using NormalElement = InputElement<"NORMAL",
+    std::conditional_t<E == NormalEncoding::Float32, Float3Element, Snorm16x2Element>>;
+
+template <TexCoordEncoding E>
+using TexCoordElement = InputElement<"TEXCOORD",
+    std::conditional_t<E == TexCoordEncoding::Float32, Float2Element,
+                       std::conditional_t<E == TexCoordEncoding::Half, Half2Element, Unorm16x2Element>>>;
+
+using ColorElement = InputElement<"COLOR", Float4Element>;
+
+template <VertexFormat F>
+struct VertexInputLayout {
+    using PositionStream = InputStream<PositionElement<F.position>>;
+    using AttributeStream = typename InputLayoutDetail::ConcatStreams<
+        std::conditional_t<F.color, InputStream<ColorElement>, InputStream<>>,
+        InputStream<TexCoordElement<F.texCoord>, NormalElement<F.normal>>>::type;
+    using InterleavedStream = typename InputLayoutDetail::ConcatStreams<PositionStream, AttributeStream>::type;
+
+    using Layout = std::conditional_t<F.splitPositions,
+        InputLayout<PositionStream, AttributeStream>,
+        InputLayout<InterleavedStream>>;
+    // Depth-only and other position-only passes. Positions sit at offset 0 of slot 0 in both layouts;
+    // the bound vertex buffer view supplies the stride.
+    using PositionLayout = InputLayout<PositionStream>;
+};
+
+// Runtime entry points for formats only known after loading a mesh. With positionOnly, returns just
+// the POSITION element (slot 0) for passes that bind the position stream alone.
+std::vector<D3D12_INPUT_ELEMENT_DESC> getInputElementDescs(const VertexFormat& format, bool positionOnly = false);
+
+// Vertex format of the position attribute, as consumed by the IA and the DXR BLAS build
+DXGI_FORMAT getPositionFormat(const VertexFormat& format);
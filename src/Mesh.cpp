@@ -1,35 +1,35 @@
 #include "Mesh.hpp"
 
+#include <atomic>
 #include <iostream>
 #include <stdexcept>
-#include <unordered_map>
 
-#define TINYOBJLOADER_IMPLEMENTATION 
-#include "libs/tiny_obj_loader/tiny_obj_loader.h"
+#include "asset/MeshCodec.hpp"
+
 using namespace Microsoft::WRL;
 
-namespace std {
-    template<>
-    struct hash<tinyobj::index_t> {
-        size_t operator()(const tinyobj::index_t& k) const noexcept {
-            size_t h1 = std::hash<int>()(k.vertex_index);
-            size_t h2 = std::hash<int>()(k.normal_index);
-            size_t h3 = std::hash<int>()(k.texcoord_index);
-            // Combine hashes (boost::hash_combine style)
-            size_t seed = 0;
-            seed ^= h1 + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            seed ^= h2 + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            seed ^= h3 + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            return seed;
+namespace {
+    std::atomic<uint64_t> nextMeshGeneration{1};
+
+    // Copies a plain stream, or decompresses a MeshCodec-compressed one straight into the upload buffer
+    Buffer::UploadRegion makeVertexRegion(const void* data, const CompressedStream& compressed, size_t count,
+                                          uint32_t stride, size_t offset) {
+        if (!compressed.data) {
+            return {data, count * stride, offset};
         }
-    };
-}
+        return {nullptr, count * stride, offset, [=](void* destination) {
+            return decodeVertexBuffer(destination, count, stride, compressed.data, compressed.size);
+        }};
+    }
 
-namespace tinyobj {
-    inline bool operator==(const index_t& a, const index_t& b) {
-        return a.vertex_index == b.vertex_index &&
-               a.normal_index == b.normal_index &&
-               a.texcoord_index == b.texcoord_index;
+    Buffer::UploadRegion makeIndexRegion(const void* data, const CompressedStream& compressed, size_t count,
+                                         uint32_t indexSize, size_t offset) {
+        if (!compressed.data) {
+            return {data, count * indexSize, offset};
+        }
+        return {nullptr, count * indexSize, offset, [=](void* destination) {
+            return decodeIndexBuffer(destination, count, indexSize, compressed.data, compressed.size);
+        }};
     }
 }
 
@@ -39,126 +39,240 @@ Mesh::Mesh() {
 Mesh::~Mesh() {
 }
 
-std::pair<ComPtr<ID3D12Resource>, ComPtr<ID3D12Resource>> Mesh::LoadFromObjFile(
+std::vector<ComPtr<ID3D12Resource>> Mesh::LoadFromObjFile(
     ID3D12Device* device,
     ID3D12GraphicsCommandList* commandList,
-    const std::string& filename) {
+    const std::string& filename,
+    const MeshImportOptions& options) {
     if (!device || !commandList || filename.empty()) {
         throw std::invalid_argument("Invalid arguments for Mesh::LoadFromObjFile");
     }
 
-    ComPtr<ID3D12Resource> vbUploadBuffer = nullptr;
-    ComPtr<ID3D12Resource> ibUploadBuffer = nullptr;
+    // Uses "<filename>.meshcache" when it is up to date, otherwise parses the OBJ and writes the cache
+    ImportedMesh imported;
+    loadMesh(filename, options, imported);
+    OutputDebugStringA(("Mesh " + filename + (imported.fromCache ? ": loaded from cache\n" : ": imported from OBJ\n"))
+        .c_str());
+
+    // Vertex/index data may point straight into the mapped cache file; it stays mapped until upload returns
+    return upload(device, commandList, imported.view, filename);
+}
 
-    tinyobj::attrib_t attrib;
-    std::vector<tinyobj::shape_t> shapes;
-    std::vector<tinyobj::material_t> materials;
-    std::string warn, err;
-
-    bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filename.c_str());
-    if (!warn.empty()) {
-        std::cout << "TinyObj Warning: " << warn << std::endl;
-        OutputDebugStringA(("TinyObj Warning: " + warn + "\n").c_str());
-    }
-    if (!err.empty()) {
-        std::cerr << "TinyObj Error: " << err << std::endl;
-        OutputDebugStringA(("TinyObj Error: " + err + "\n").c_str());
-    }
-    if (!ret) {
-        throw std::runtime_error("Failed to load OBJ file: " + filename);
-    }
-
-    // --- Process vertices and indices ---
-    std::vector<Vertex> finalVertices;
-    std::vector<uint32_t> finalIndices; // Use 32-bit indices
-    std::unordered_map<tinyobj::index_t, uint32_t> uniqueVertices;
-
-    for (const auto& shape: shapes) {
-        for (const auto& index: shape.mesh.indices) {
-            // Check if this combination of pos/norm/uv index is already added
-            if (uniqueVertices.count(index) == 0) {
-                // If not found, create a new Vertex and add it
-                uniqueVertices[index] = static_cast<uint32_t>(finalVertices.size());
-
-                Vertex vertex = {};
-                // Position
-                vertex.position = {
-                    attrib.vertices[3 * index.vertex_index + 0],
-                    attrib.vertices[3 * index.vertex_index + 1],
-                    attrib.vertices[3 * index.vertex_index + 2]
-                };
-                // Normals (check if present)
-                if (index.normal_index >= 0) {
-                    vertex.normal = {
-                        attrib.normals[3 * index.normal_index + 0],
-                        attrib.normals[3 * index.normal_index + 1],
-                        attrib.normals[3 * index.normal_index + 2]
-                    };
-                } else {
-                    // Provide default normal if none exists (e.g., facing up)
-                    vertex.normal = {0.0f, 1.0f, 0.0f};
-                }
-                // Texture Coordinates (check if present)
-                if (index.texcoord_index >= 0) {
-                    vertex.texCoord = {
-                        attrib.texcoords[2 * index.texcoord_index + 0],
-                        // OBJ UVs often have Y inverted compared to DX, flip it
-                        1.0f - attrib.texcoords[2 * index.texcoord_index + 1]
-                    };
-                } else {
-                    vertex.texCoord = {0.0f, 0.0f}; // Default UV
-                }
-                // Color (set default or potentially load from material later)
-                vertex.color = {1.0f, 1.0f, 1.0f, 1.0f}; // Default white
-
-                finalVertices.push_back(vertex);
-            }
-            // Add index (either newly created or existing) to final index list
-            finalIndices.push_back(uniqueVertices[index]);
+std::vector<ComPtr<ID3D12Resource>> Mesh::LoadFromGltfFile(
+    ID3D12Device* device,
+    ID3D12GraphicsCommandList* commandList,
+    const std::string& filename,
+    std::vector<std::unique_ptr<Mesh>>& outMeshes,
+    std::vector<GltfInstance>* outInstances,
+    const VirtualFileSystem* fileSystem) {
+    if (!device || !commandList || filename.empty()) {
+        throw std::invalid_argument("Invalid arguments for Mesh::LoadFromGltfFile");
+    }
+
+    // The views point into the mapped file (or the converted data), which stays alive until upload returns
+    GltfModel model;
+    loadGltfFile(filename, model, fileSystem);
+    std::vector<ComPtr<ID3D12Resource>> uploadBuffers;
+    outMeshes.clear();
+    for (size_t i = 0; i < model.meshes.size(); ++i) {
+        const GltfMesh& gltfMesh = model.meshes[i];
+        if (gltfMesh.view.vertexCount == 0 || gltfMesh.view.indexCount == 0) {
+            outMeshes.push_back(nullptr);
+            continue;
         }
+        const std::string name = filename + "#" + (gltfMesh.name.empty() ? std::to_string(i) : gltfMesh.name);
+        OutputDebugStringA(("Mesh " + name + (gltfMesh.zeroCopyVertices && gltfMesh.zeroCopyIndices
+                                                  ? ": uploaded from the glTF buffers\n"
+                                                  : ": converted to the Vertex layout\n")).c_str());
+        auto mesh = std::make_unique<Mesh>();
+        std::vector<ComPtr<ID3D12Resource>> meshUploads = mesh->upload(device, commandList, gltfMesh.view, name);
+        uploadBuffers.insert(uploadBuffers.end(), meshUploads.begin(), meshUploads.end());
+        outMeshes.push_back(std::move(mesh));
+    }
+    if (outInstances) {
+        *outInstances = std::move(model.instances);
     }
+    return uploadBuffers;
+}
+
+std::vector<ComPtr<ID3D12Resource>> Mesh::upload(
+    ID3D12Device* device,
+    ID3D12GraphicsCommandList* commandList,
+    const MeshView& mesh,
+    const std::string& name) {
+    if (!device || !commandList) {
+        throw std::invalid_argument("Invalid arguments for Mesh::upload");
+    }
+
+    ComPtr<ID3D12Resource> vbUploadBuffer = nullptr;
+    ComPtr<ID3D12Resource> ibUploadBuffer = nullptr;
 
     // --- Create Vertex Buffer ---
-    if (finalVertices.empty()) {
-        throw std::runtime_error("Failed to load OBJ file: " + filename);
+    if ((!mesh.vertices && !mesh.compressedVertices.data) || mesh.vertexCount == 0) {
+        throw std::runtime_error("No vertices in mesh: " + name);
+    }
+
+    m_vertexFormat = mesh.vertexFormat;
+    m_vertexQuantization = mesh.quantization;
+    const VertexLayout layout = getVertexLayout(m_vertexFormat);
+    m_vertexStride = layout.stride;
+
+    // Split positions share one resource with the attributes: positions first, then the attribute
+    // stream starting on a multiple of its stride so DXR can view it as a structured buffer
+    const size_t vertexBytes = mesh.vertexCount * m_vertexStride;
+    size_t positionBytes = 0;
+    m_attributeOffset = 0;
+    if (m_vertexFormat.splitPositions) {
+        if (!mesh.positions && !mesh.compressedPositions.data) {
+            throw std::runtime_error("No position stream in mesh: " + name);
+        }
+        positionBytes = mesh.vertexCount * layout.positionStride;
+        m_attributeOffset = (positionBytes + m_vertexStride - 1) / m_vertexStride * m_vertexStride;
     }
 
+    // Compressed streams (from a mesh cache) are decoded straight into the upload buffer
     m_vertexBuffer = std::make_unique<Buffer>();
-    vbUploadBuffer = m_vertexBuffer->createAndUploadDefaultBuffer(
-        device, commandList,
-        finalVertices.data(), finalVertices.size() * sizeof(Vertex),
-        D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
-    );
+    const Buffer::UploadRegion vertexRegion = makeVertexRegion(mesh.vertices, mesh.compressedVertices,
+                                                               mesh.vertexCount, m_vertexStride,
+                                                               static_cast<size_t>(m_attributeOffset));
+    if (m_vertexFormat.splitPositions) {
+        vbUploadBuffer = m_vertexBuffer->createAndUploadDefaultBuffer(
+            device, commandList,
+            {makeVertexRegion(mesh.positions, mesh.compressedPositions, mesh.vertexCount, layout.positionStride, 0),
+             vertexRegion},
+            static_cast<size_t>(m_attributeOffset) + vertexBytes,
+            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
+        );
+    } else {
+        vbUploadBuffer = m_vertexBuffer->createAndUploadDefaultBuffer(
+            device, commandList, {vertexRegion}, vertexBytes,
+            D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER
+        );
+    }
 
     if (!m_vertexBuffer->getResource()) {
         throw std::runtime_error("Failed to create vertex buffer upload resource");
     }
-    m_vertexBuffer->getResource()->SetName((L"Mesh VB: " + std::wstring(filename.begin(), filename.end())).c_str());
-    m_vertexStride = sizeof(Vertex);
-    m_vertexCount = static_cast<UINT>(finalVertices.size());
+    m_vertexBuffer->getResource()->SetName((L"Mesh VB: " + std::wstring(name.begin(), name.end())).c_str());
+    m_vertexCount = static_cast<UINT>(mesh.vertexCount);
     m_vertexBufferView = m_vertexBuffer->getVertexBufferView(m_vertexStride);
+    m_positionBufferView = m_vertexBufferView;
+    if (m_vertexFormat.splitPositions) {
+        m_positionBufferView.SizeInBytes = static_cast<UINT>(positionBytes);
+        m_positionBufferView.StrideInBytes = layout.positionStride;
+        m_vertexBufferView.BufferLocation += m_attributeOffset;
+        m_vertexBufferView.SizeInBytes = static_cast<UINT>(vertexBytes);
+    }
 
     // --- Create Index Buffer ---
-    if (finalIndices.empty()) {
-        throw std::runtime_error("No indices loaded from OBJ file: " + filename);
+    if ((!mesh.indices && !mesh.compressedIndices.data) || mesh.indexCount == 0) {
+        throw std::runtime_error("No indices in mesh: " + name);
     }
+    if (mesh.indexSize != sizeof(uint16_t) && mesh.indexSize != sizeof(uint32_t)) {
+        throw std::runtime_error("Unsupported index size in mesh: " + name);
+    }
+    // Coarser LODs follow LOD0 in the same index buffer, so every level draws with the same view. The size
+    // is padded to 4 bytes for the raw (ByteAddressBuffer) view the hit shaders read 16-bit indices through.
+    const size_t lod0Bytes = mesh.indexCount * mesh.indexSize;
+    const bool hasLodIndices = mesh.lodIndices || mesh.compressedLodIndices.data;
+    const size_t lodIndexCount = hasLodIndices ? mesh.lodIndexCount : 0;
+    const size_t lodBytes = lodIndexCount * mesh.indexSize;
     m_indexBuffer = std::make_unique<Buffer>();
     ibUploadBuffer = m_indexBuffer->createAndUploadDefaultBuffer(
-        device, commandList, finalIndices.data(), finalIndices.size() * sizeof(uint32_t),
-        D3D12_RESOURCE_STATE_INDEX_BUFFER
+        device, commandList,
+        {makeIndexRegion(mesh.indices, mesh.compressedIndices, mesh.indexCount, mesh.indexSize, 0),
+         makeIndexRegion(mesh.lodIndices, mesh.compressedLodIndices, lodIndexCount, mesh.indexSize, lod0Bytes)},
+        alignUp(lod0Bytes + lodBytes, 4), D3D12_RESOURCE_STATE_INDEX_BUFFER
     );
     if (!m_indexBuffer->getResource()) {
-        throw std::runtime_error("Failed to create mesh index buffer from OBJ.");
+        throw std::runtime_error("Failed to create mesh index buffer.");
     }
-    m_indexBuffer->getResource()->SetName((L"Mesh IB: " + std::wstring(filename.begin(), filename.end())).c_str());
-    m_indexFormat = DXGI_FORMAT_R32_UINT; // Using 32-bit indices
-    m_indexCount = static_cast<UINT>(finalIndices.size());
+    m_indexBuffer->getResource()->SetName((L"Mesh IB: " + std::wstring(name.begin(), name.end())).c_str());
+    m_indexFormat = mesh.indexSize == sizeof(uint16_t) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    m_indexCount = static_cast<UINT>(mesh.indexCount);
+    m_totalIndexCount = static_cast<UINT>((lod0Bytes + lodBytes) / mesh.indexSize);
     m_indexBufferView = m_indexBuffer->getIndexBufferView(m_indexFormat);
 
+    // Without submeshes the mesh is a single one with the default material, and without generated levels
+    // every submesh is its own single LOD
+    m_lods.assign(mesh.lods, mesh.lods + mesh.lodCount);
+    if (mesh.submeshCount > 0) {
+        m_submeshes.assign(mesh.submeshes, mesh.submeshes + mesh.submeshCount);
+    } else {
+        Submesh submesh = {};
+        submesh.indexCount = m_indexCount;
+        submesh.materialIndex = kNoMaterial;
+        submesh.lodCount = static_cast<uint32_t>(mesh.lodCount);
+        submesh.meshletCount = static_cast<uint32_t>(mesh.meshletCount);
+        submesh.bounds = mesh.bounds;
+        m_submeshes.assign(1, submesh);
+    }
+    m_lodErrors.clear();
+    for (Submesh& submesh : m_submeshes) {
+        if (submesh.lodCount == 0) {
+            submesh.lodOffset = static_cast<uint32_t>(m_lods.size());
+            submesh.lodCount = 1;
+            m_lods.push_back(MeshLod{submesh.indexOffset, submesh.indexCount, 0.0f, 0});
+        }
+        m_lodErrors.resize(std::max<size_t>(m_lodErrors.size(), submesh.lodCount), 0.0f);
+    }
+    // A submesh with a shorter chain stays at its coarsest level, so its error counts for all later levels
+    for (const Submesh& submesh : m_submeshes) {
+        for (size_t lod = 0; lod < m_lodErrors.size(); ++lod) {
+            m_lodErrors[lod] = std::max(m_lodErrors[lod], getSubmeshLod(submesh, lod).error);
+        }
+    }
+    m_materials.assign(mesh.materials, mesh.materials + mesh.materialCount);
+    m_generation = nextMeshGeneration++;
+    m_materialStrings.assign(mesh.materialStrings, mesh.materialStrings + mesh.materialStringsSize);
+    if (m_materialStrings.empty()) {
+        m_materialStrings.assign(1, '\0');
+    }
+    m_bounds = mesh.bounds;
+
     m_topology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST; // Assuming triangles
 
     // Return upload buffers for lifetime management by caller
-    return {vbUploadBuffer, ibUploadBuffer};
+    std::vector<ComPtr<ID3D12Resource>> uploadBuffers = {vbUploadBuffer, ibUploadBuffer};
+
+    // --- Create Meshlet Buffers (optional) ---
+    m_meshlets.clear();
+    m_meshletBounds.clear();
+    m_meshletBuffer.reset();
+    m_meshletBoundsBuffer.reset();
+    m_meshletVertexBuffer.reset();
+    m_meshletTriangleBuffer.reset();
+    if (mesh.meshletCount > 0) {
+        const std::wstring wideName(name.begin(), name.end());
+        m_meshlets.assign(mesh.meshlets, mesh.meshlets + mesh.meshletCount);
+        m_meshletBounds.assign(mesh.meshletBounds, mesh.meshletBounds + mesh.meshletCount);
+
+        m_meshletBuffer = std::make_unique<Buffer>();
+        uploadBuffers.push_back(m_meshletBuffer->createAndUploadDefaultBuffer(
+            device, commandList, mesh.meshlets, mesh.meshletCount * sizeof(Meshlet),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+        m_meshletBuffer->getResource()->SetName((L"Mesh Meshlets: " + wideName).c_str());
+
+        m_meshletBoundsBuffer = std::make_unique<Buffer>();
+        uploadBuffers.push_back(m_meshletBoundsBuffer->createAndUploadDefaultBuffer(
+            device, commandList, mesh.meshletBounds, mesh.meshletCount * sizeof(MeshletBounds),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+        m_meshletBoundsBuffer->getResource()->SetName((L"Mesh Meshlet Bounds: " + wideName).c_str());
+
+        m_meshletVertexBuffer = std::make_unique<Buffer>();
+        uploadBuffers.push_back(m_meshletVertexBuffer->createAndUploadDefaultBuffer(
+            device, commandList, mesh.meshletVertices, mesh.meshletVertexCount * sizeof(uint32_t),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+        m_meshletVertexBuffer->getResource()->SetName((L"Mesh Meshlet Vertices: " + wideName).c_str());
+
+        // ByteAddressBuffer views need a multiple of 4 bytes; the tail is left as padding
+        m_meshletTriangleBuffer = std::make_unique<Buffer>();
+        uploadBuffers.push_back(m_meshletTriangleBuffer->createAndUploadDefaultBuffer(
+            device, commandList, {{mesh.meshletTriangles, mesh.indexCount, 0}}, alignUp(mesh.indexCount, 4),
+            D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE));
+        m_meshletTriangleBuffer->getResource()->SetName((L"Mesh Meshlet Triangles: " + wideName).c_str());
+    }
+    return uploadBuffers;
 }
 
 void Mesh::setupInputAssembler(ID3D12GraphicsCommandList* commandList) const {
@@ -167,23 +281,84 @@ void Mesh::setupInputAssembler(ID3D12GraphicsCommandList* commandList) const {
     }
     commandList->IASetPrimitiveTopology(m_topology);
     if (m_vertexBuffer) {
-        commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
+        if (m_vertexFormat.splitPositions) {
+            const D3D12_VERTEX_BUFFER_VIEW views[] = {m_positionBufferView, m_vertexBufferView};
+            commandList->IASetVertexBuffers(0, 2, views);
+        } else {
+            commandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
+        }
     }
     if (m_indexBuffer) {
         commandList->IASetIndexBuffer(&m_indexBufferView);
     }
 }
 
+void Mesh::setupPositionInputAssembler(ID3D12GraphicsCommandList* commandList) const {
+    if (!commandList || !m_vertexBuffer || !m_indexBuffer) {
+        return;
+    }
+    commandList->IASetPrimitiveTopology(m_topology);
+    commandList->IASetVertexBuffers(0, 1, &m_positionBufferView);
+    commandList->IASetIndexBuffer(&m_indexBufferView);
+}
+
 void Mesh::draw(ID3D12GraphicsCommandList* commandList, UINT instanceCount = 1) const {
     if (!commandList || instanceCount == 0) return;
 
     // Assumes IA state is already set via SetupInputAssembler
 
     if (m_indexBuffer) {
-        // Draw indexed
-        commandList->DrawIndexedInstanced(m_indexCount, instanceCount, 0, 0, 0);
+        // Draw indexed; submeshes may have their own base vertex
+        drawLod(commandList, 0, instanceCount);
     } else if (m_vertexBuffer) {
         // Draw non-indexed (less common for complex meshes)
         commandList->DrawInstanced(m_vertexCount, instanceCount, 0, 0);
     }
 }
+
+void Mesh::drawLod(ID3D12GraphicsCommandList* commandList, size_t lod, UINT instanceCount) const {
+    if (!commandList || !m_indexBuffer || instanceCount == 0) return;
+
+    // Adjacent submesh ranges with the same base vertex (all of LOD0 when the mesh has a single vertex
+    // range, and most of the coarser levels) merge into one draw
+    UINT indexOffset = 0;
+    UINT indexCount = 0;
+    UINT baseVertex = 0;
+    for (const Submesh& submesh : m_submeshes) {
+        const MeshLod& level = getSubmeshLod(submesh, lod);
+        if (indexCount > 0 && indexOffset + indexCount == level.indexOffset && baseVertex == submesh.baseVertex) {
+            indexCount += level.indexCount;
+            continue;
+        }
+        drawIndices(commandList, indexOffset, indexCount, baseVertex, instanceCount);
+        indexOffset = level.indexOffset;
+        indexCount = level.indexCount;
+        baseVertex = submesh.baseVertex;
+    }
+    drawIndices(commandList, indexOffset, indexCount, baseVertex, instanceCount);
+}
+
+void Mesh::drawIndices(ID3D12GraphicsCommandList* commandList, UINT indexOffset, UINT indexCount, INT baseVertex,
+                       UINT instanceCount) const {
+    if (!commandList || !m_indexBuffer || indexCount == 0 || instanceCount == 0) return;
+
+    commandList->DrawIndexedInstanced(indexCount, instanceCount, indexOffset, baseVertex, 0);
+}
+
+void Mesh::drawMeshlets(ID3D12GraphicsCommandList* commandList, const uint32_t* meshletIndices, size_t count,
+                        INT baseVertex) const {
+    if (!commandList || !m_indexBuffer || m_meshlets.empty()) return;
+
+    size_t i = 0;
+    while (i < count) {
+        const Meshlet& first = m_meshlets[meshletIndices[i]];
+        UINT triangleCount = first.triangleCount;
+        size_t next = i + 1;
+        while (next < count && meshletIndices[next] == meshletIndices[next - 1] + 1) {
+            triangleCount += m_meshlets[meshletIndices[next]].triangleCount;
+            next++;
+        }
+        commandList->DrawIndexedInstanced(triangleCount * 3, 1, first.triangleOffset * 3, baseVertex, 0);
+        i = next;
+    }
+}
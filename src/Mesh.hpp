@@ -1,19 +1,18 @@
 #pragma once
+#include <algorithm>
+#include <cstdint>
 #include <d3d12.h>
 #include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 #include <wrl/client.h>
 
 #include "Buffer.hpp"
-#include "glm/glm.hpp"
-
-struct Vertex {
-    glm::vec3 position;
-    glm::vec4 color;
-    glm::vec2 texCoord;
-    glm::vec3 normal;
-};
+#include "InputLayout.hpp"
+#include "asset/GltfImport.hpp"
+#include "asset/MeshData.hpp"
+#include "asset/MeshImport.hpp"
 
 class Mesh {
 public:
@@ -21,16 +20,56 @@ public:
 
     ~Mesh();
 
-    std::pair<Microsoft::WRL::ComPtr<ID3D12Resource>, Microsoft::WRL::ComPtr<ID3D12Resource>> LoadFromObjFile(
+    // Both loaders return the upload buffers, which must stay alive until the recorded copies have executed
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> LoadFromObjFile(
+        ID3D12Device* pDevice,
+        ID3D12GraphicsCommandList* pCmdList,
+        const std::string& filename,
+        const MeshImportOptions& options = {}
+    );
+
+    // Loads every mesh of a glTF 2.0 file (.glb, or .gltf with external buffers) into outMeshes, indexed like
+    // the file's meshes (null for a mesh without triangles), and the mesh nodes of its scene into outInstances.
+    // Vertices and indices already in the Vertex layout are copied to the upload buffers straight from the
+    // mapped file.
+    static std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> LoadFromGltfFile(
         ID3D12Device* pDevice,
         ID3D12GraphicsCommandList* pCmdList,
-        const std::string& filename // Use std::string for tinyobj compatibility
+        const std::string& filename,
+        std::vector<std::unique_ptr<Mesh>>& outMeshes,
+        std::vector<GltfInstance>* outInstances = nullptr,
+        const VirtualFileSystem* fileSystem = nullptr
     );
 
+    // Creates the GPU buffers from already imported vertex/index data (e.g. a memory-mapped mesh cache)
+    std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> upload(
+        ID3D12Device* pDevice,
+        ID3D12GraphicsCommandList* pCmdList,
+        const MeshView& mesh,
+        const std::string& name
+    );
+
+    // Binds every vertex stream of the mesh (slot 0, plus slot 1 for attributes when positions are split)
     void setupInputAssembler(ID3D12GraphicsCommandList* commandList) const;
 
+    // Binds positions only (slot 0), for depth-only passes using getInputElementDescs(format, true)
+    void setupPositionInputAssembler(ID3D12GraphicsCommandList* commandList) const;
+
     void draw(ID3D12GraphicsCommandList* commandList, UINT instanceCount) const;
 
+    // Draws every submesh at one level of detail (0 = full resolution) regardless of material; the input
+    // assembler setup is shared by all levels
+    void drawLod(ID3D12GraphicsCommandList* commandList, size_t lod, UINT instanceCount = 1) const;
+
+    // Draws a range of the index buffer, e.g. one SubmeshDraw; indices are relative to baseVertex
+    void drawIndices(ID3D12GraphicsCommandList* commandList, UINT indexOffset, UINT indexCount, INT baseVertex = 0,
+                     UINT instanceCount = 1) const;
+
+    // Draws only the listed meshlets (ascending, e.g. from cullMeshlets) of one submesh, whose base vertex
+    // is given; runs of consecutive meshlets are merged into a single draw since their index ranges are adjacent
+    void drawMeshlets(ID3D12GraphicsCommandList* commandList, const uint32_t* meshletIndices, size_t count,
+                      INT baseVertex = 0) const;
+
     ID3D12Resource* getVertexBufferResource() const {
         return m_vertexBuffer ? m_vertexBuffer->getResource() : nullptr;
     }
@@ -39,10 +78,25 @@ public:
         return m_indexBuffer ? m_indexBuffer->getResource() : nullptr;
     }
 
+    // Main vertex stream: the interleaved vertices, or the attributes when positions are split
     D3D12_GPU_VIRTUAL_ADDRESS getVertexBufferGPUVirtualAddress() const {
         return m_vertexBufferView.BufferLocation;
     }
 
+    // Byte offset of the main stream inside the vertex buffer resource (a multiple of the vertex stride)
+    UINT64 getVertexBufferOffset() const {
+        return m_attributeOffset;
+    }
+
+    // Position stream; the same memory as the main stream when positions are interleaved
+    D3D12_GPU_VIRTUAL_ADDRESS getPositionBufferGPUVirtualAddress() const {
+        return m_positionBufferView.BufferLocation;
+    }
+
+    UINT getPositionStride() const {
+        return m_positionBufferView.StrideInBytes;
+    }
+
     D3D12_GPU_VIRTUAL_ADDRESS getIndexBufferGPUVirtualAddress() const {
         return m_indexBufferView.BufferLocation;
     }
@@ -59,20 +113,130 @@ public:
         return m_indexCount;
     }
 
+    // Every index in the index buffer: LOD0 followed by the coarser levels
+    UINT getTotalIndexCount() const {
+        return m_totalIndexCount;
+    }
+
+    // R16_UINT or R32_UINT, picked at import; drives the IA binding and the DXR index loads
     DXGI_FORMAT getIndexFormat() const {
         return m_indexFormat;
     }
 
+    UINT getIndexSize() const {
+        return m_indexFormat == DXGI_FORMAT_R16_UINT ? 2 : 4;
+    }
+
+    const VertexFormat& getVertexFormat() const {
+        return m_vertexFormat;
+    }
+
+    const VertexQuantization& getVertexQuantization() const {
+        return m_vertexQuantization;
+    }
+
+    // Always at least one submesh, in index buffer order (sorted by material)
+    const std::vector<Submesh>& getSubmeshes() const {
+        return m_submeshes;
+    }
+
+    // Per-submesh LOD chains, indexed through the submeshes; every submesh has at least one level
+    const std::vector<MeshLod>& getLods() const {
+        return m_lods;
+    }
+
+    // Level lod of a submesh, clamped to its chain
+    const MeshLod& getSubmeshLod(const Submesh& submesh, size_t lod) const {
+        return m_lods[submesh.lodOffset + std::min<size_t>(lod, submesh.lodCount - 1)];
+    }
+
+    // Number of mesh-wide levels (the longest submesh chain)
+    size_t getLodCount() const {
+        return m_lodErrors.size();
+    }
+
+    // Largest submesh error at each mesh-wide level, for selectMeshLod
+    const std::vector<float>& getLodErrors() const {
+        return m_lodErrors;
+    }
+
+    const std::vector<MeshMaterial>& getMaterials() const {
+        return m_materials;
+    }
+
+    // Changes with every upload and is never reused by another mesh (unlike the address, which a reload can
+    // get back), so renderer state derived from the mesh can be keyed on it
+    uint64_t getGeneration() const {
+        return m_generation;
+    }
+
+    // Name or texture path of a material (MeshMaterial::nameOffset etc.)
+    const char* getMaterialString(uint32_t offset) const {
+        return offset < m_materialStrings.size() ? &m_materialStrings[offset] : "";
+    }
+
+    const MeshBounds& getBounds() const {
+        return m_bounds;
+    }
+
+    bool hasMeshlets() const {
+        return !m_meshlets.empty();
+    }
+
+    const std::vector<Meshlet>& getMeshlets() const {
+        return m_meshlets;
+    }
+
+    const std::vector<MeshletBounds>& getMeshletBounds() const {
+        return m_meshletBounds;
+    }
+
+    // StructuredBuffer<Meshlet>, StructuredBuffer<MeshletBounds>, StructuredBuffer<uint> and a
+    // ByteAddressBuffer of packed uint8 triangles, for GPU culling / mesh shaders
+    ID3D12Resource* getMeshletBufferResource() const {
+        return m_meshletBuffer ? m_meshletBuffer->getResource() : nullptr;
+    }
+
+    ID3D12Resource* getMeshletBoundsBufferResource() const {
+        return m_meshletBoundsBuffer ? m_meshletBoundsBuffer->getResource() : nullptr;
+    }
+
+    ID3D12Resource* getMeshletVertexBufferResource() const {
+        return m_meshletVertexBuffer ? m_meshletVertexBuffer->getResource() : nullptr;
+    }
+
+    ID3D12Resource* getMeshletTriangleBufferResource() const {
+        return m_meshletTriangleBuffer ? m_meshletTriangleBuffer->getResource() : nullptr;
+    }
+
 private:
     std::unique_ptr<Buffer> m_vertexBuffer;
     std::unique_ptr<Buffer> m_indexBuffer; // Can be nullptr if not indexed
+    std::unique_ptr<Buffer> m_meshletBuffer; // Meshlet buffers are nullptr if the mesh has no meshlets
+    std::unique_ptr<Buffer> m_meshletBoundsBuffer;
+    std::unique_ptr<Buffer> m_meshletVertexBuffer;
+    std::unique_ptr<Buffer> m_meshletTriangleBuffer;
+    std::vector<Meshlet> m_meshlets; // CPU copies for cluster culling
+    std::vector<MeshletBounds> m_meshletBounds;
+    std::vector<MeshLod> m_lods;
+    std::vector<float> m_lodErrors;
+    std::vector<Submesh> m_submeshes;
+    std::vector<MeshMaterial> m_materials;
+    std::vector<char> m_materialStrings;
+    MeshBounds m_bounds = {};
+    uint64_t m_generation = 0; // 0 until the first upload
 
     D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
+    D3D12_VERTEX_BUFFER_VIEW m_positionBufferView; // Equal to m_vertexBufferView unless positions are split
     D3D12_INDEX_BUFFER_VIEW m_indexBufferView; // Only valid if m_indexBuffer exists
 
     UINT m_vertexCount; // Needed if drawing non-indexed
     UINT m_indexCount; // Number of indices to draw
+    UINT m_totalIndexCount; // Including the LOD index ranges after LOD0
     UINT m_vertexStride;
+    UINT64 m_attributeOffset = 0; // Positions come first in the vertex buffer when they are split
+    VertexFormat m_vertexFormat;
+    VertexQuantization m_vertexQuantization; // Shaders decode positions/UVs with this scale and offset
     DXGI_FORMAT m_indexFormat;
     D3D12_PRIMITIVE_TOPOLOGY m_topology;
 };
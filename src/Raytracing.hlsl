@@ -1,5 +1,7 @@
 // Raytracing.hlsl (Corrected)
 
+#include "VertexDecode.hlsl"
+
 // Define payload structure
 struct RayPayload {
     float4 color;
@@ -19,20 +21,82 @@ cbuffer CameraParams : register(b1) {
 Texture2D g_texture : register(t1);
 SamplerState g_sampler : register(s0); // Ensure this is used with g_texture
 
+// Mirrors getVertexLayout() for the mesh's VertexFormat. Split positions live in their own stream,
+// which only the BLAS reads; this buffer then holds the attribute stream alone.
 struct Vertex {
+#if SPLIT_POSITIONS
+#elif POSITION_SNORM16
+    uint2 position; // snorm16 x, y, z, unused w
+#else
     float3 position;
-    float4 color; // If you have per-vertex color, ensure it's used or remove
+#endif
+#if VERTEX_COLOR
+    float4 color;
+#endif
+#if TEXCOORD_HALF || TEXCOORD_UNORM16
+    uint texCoord; // Two 16-bit values
+#else
     float2 texCoord;
+#endif
+#if NORMAL_OCT16
+    uint normal; // snorm16 x2 octahedral
+#else
     float3 normal;
+#endif
 };
 StructuredBuffer<Vertex> g_vertexBuffer : register(t2);
 ByteAddressBuffer g_indexBuffer : register(t3);
+ByteAddressBuffer g_positionBuffer : register(t4); // Split position stream (8 bytes snorm16 or 12 bytes float)
 
 cbuffer DXRObjectConstants : register(b2) {
     float4x4 worldMatrix;
     float4x4 invTransposeWorldMatrix;
+    float4 positionScale; // Vertex dequantization, identity for float positions/UVs
+    float4 positionOffset;
+    float4 texCoordScaleOffset; // xy = scale, zw = offset
 };
 
+#if !SPLIT_POSITIONS
+float3 decodePosition(Vertex v) {
+#if POSITION_SNORM16
+    float3 position = float3(snorm16ToFloat(v.position.x), snorm16ToFloat(v.position.x >> 16),
+                             snorm16ToFloat(v.position.y));
+#else
+    float3 position = v.position;
+#endif
+    return position * positionScale.xyz + positionOffset.xyz;
+}
+#else
+float3 loadPosition(uint vertexIndex) {
+#if POSITION_SNORM16
+    uint2 packed = g_positionBuffer.Load2(vertexIndex * 8);
+    float3 position = float3(snorm16ToFloat(packed.x), snorm16ToFloat(packed.x >> 16), snorm16ToFloat(packed.y));
+#else
+    float3 position = asfloat(g_positionBuffer.Load3(vertexIndex * 12));
+#endif
+    return position * positionScale.xyz + positionOffset.xyz;
+}
+#endif
+
+float3 decodeNormal(Vertex v) {
+#if NORMAL_OCT16
+    return octahedralDecode(float2(snorm16ToFloat(v.normal), snorm16ToFloat(v.normal >> 16)));
+#else
+    return v.normal;
+#endif
+}
+
+float2 decodeTexCoord(Vertex v) {
+#if TEXCOORD_HALF
+    float2 texCoord = float2(f16tof32(v.texCoord), f16tof32(v.texCoord >> 16));
+#elif TEXCOORD_UNORM16
+    float2 texCoord = float2(unorm16ToFloat(v.texCoord), unorm16ToFloat(v.texCoord >> 16));
+#else
+    float2 texCoord = v.texCoord;
+#endif
+    return texCoord * texCoordScaleOffset.xy + texCoordScaleOffset.zw;
+}
+
 cbuffer LightConstants : register(b3) {
     float4 ambientColor;
     float4 lightColor;
@@ -40,27 +104,59 @@ cbuffer LightConstants : register(b3) {
     // float3 _pad1; // Padding defined in C++, not needed here if offsets are correct
 };
 
-cbuffer MaterialConstants : register(b4) {
+// Local root constants of the hit record (DXRGeometryConstants in C++): one per submesh and LOD
+cbuffer GeometryConstants : register(b0, space1) {
+    uint firstIndex; // Start of the submesh LOD in g_indexBuffer
+    uint baseVertex; // Added to the submesh's indices
+    uint indexSizeInBytes; // 2 (R16_UINT) or 4 (R32_UINT)
+    uint geometryPadding;
+    float4 diffuseColor; // Material
     float4 specularColor;
+    float3 emissiveColor;
     float specularPower;
 };
 
 
+// World-space direction of the primary ray through a point of the output, in pixels
+float3 getPrimaryRayDirection(float2 pixel) {
+    float2 size = (float2)DispatchRaysDimensions().xy;
+    float ndcX = pixel.x / size.x * 2.0f - 1.0f;
+    float ndcY = pixel.y / size.y * -2.0f + 1.0f;
+
+    float4 nearPointWorld = mul(invViewProjection, float4(ndcX, ndcY, 0.0f, 1.0f));
+    nearPointWorld /= nearPointWorld.w;
+    return normalize(nearPointWorld.xyz - cameraPosition);
+}
+
+// Texture LOD of a primary ray hit with ray cones (Akenine-Moller et al., "Texture Level of Detail Strategies
+// for Real-Time Ray Tracing"): the cone grows by the angle between neighboring pixels, and its width where it
+// meets the triangle, over the cosine of the incidence, is converted to texels with the triangle's density
+float computeTextureLod(float3 worldEdge1, float3 worldEdge2, float2 uv0, float2 uv1, float2 uv2) {
+    float2 pixel = (float2)DispatchRaysIndex().xy + 0.5f;
+    float3 direction = WorldRayDirection();
+    float spreadAngle = acos(saturate(dot(direction, getPrimaryRayDirection(pixel + float2(0.0f, 1.0f)))));
+    float coneWidth = RayTCurrent() * spreadAngle;
+
+    uint width, height, mipCount;
+    g_texture.GetDimensions(0, width, height, mipCount);
+    float2 uvEdge1 = uv1 - uv0;
+    float2 uvEdge2 = uv2 - uv0;
+    float texelArea = abs(uvEdge1.x * uvEdge2.y - uvEdge2.x * uvEdge1.y) * width * height;
+    float3 faceNormal = cross(worldEdge1, worldEdge2);
+    float worldArea = length(faceNormal);
+
+    float lod = 0.5f * log2(max(texelArea, 1e-12f) / max(worldArea, 1e-12f));
+    lod += log2(coneWidth / max(abs(dot(direction, faceNormal / max(worldArea, 1e-12f))), 1e-4f));
+    return lod;
+}
+
 // --- Ray Generation Shader ---
 [shader("raygeneration")]
 void RayGen() {
     uint2 dispatchIndex = DispatchRaysIndex().xy;
-    uint2 size = DispatchRaysDimensions().xy;
-
-    float ndcX = ((float)dispatchIndex.x + 0.5f) / (float)size.x * 2.0f - 1.0f;
-    float ndcY = ((float)dispatchIndex.y + 0.5f) / (float)size.y * -2.0f + 1.0f;
-
-    float4 nearPointNDC = float4(ndcX, ndcY, 0.0f, 1.0f);
-    float4 nearPointWorld = mul(invViewProjection, nearPointNDC);
-    nearPointWorld /= nearPointWorld.w;
 
     float3 calculatedRayOrigin = cameraPosition;
-    float3 calculatedRayDirection = normalize(nearPointWorld.xyz - calculatedRayOrigin);
+    float3 calculatedRayDirection = getPrimaryRayDirection((float2)dispatchIndex + 0.5f);
 
     RayPayload payload;
     payload.color = float4(0.0f, 0.0f, 0.0f, 1.0f); // Initialize color
@@ -77,7 +173,7 @@ void RayGen() {
         RAY_FLAG_NONE,
         0xFF,
         0, // Ray Contribution To Hit Group Index (Primary hit group)
-        1, // Multiplier for Geometry Index
+        2, // Multiplier for Geometry Index (primary + shadow record per submesh)
         0, // Miss Shader Index (Primary miss shader)
         ray,
         payload
@@ -92,29 +188,51 @@ void Miss(inout RayPayload payload) {
     payload.color = float4(0.1f, 0.1f, 0.1f, 1.0f); // Dark blue/grey for primary miss
 }
 
+// Indices of a triangle of the current submesh LOD, relative to baseVertex
+uint3 loadTriangleIndices(uint primitiveIdx) {
+    uint indexOffset = (firstIndex + primitiveIdx * 3) * indexSizeInBytes;
+    if (indexSizeInBytes == 2) {
+        // Raw loads are 4-byte aligned: the three 16-bit indices lie in the two words from the aligned offset
+        uint2 words = g_indexBuffer.Load2(indexOffset & ~3u);
+        if (indexOffset & 2) {
+            return uint3(words.x >> 16, words.y & 0xFFFF, words.y >> 16);
+        }
+        return uint3(words.x & 0xFFFF, words.x >> 16, words.y & 0xFFFF);
+    }
+    return g_indexBuffer.Load3(indexOffset);
+}
+
 // --- Closest Hit Shader (Primary Rays) ---
 // Exported as "ClosestHit" in C++, used by Primary HitGroup
 [shader("closesthit")]
 void ClosestHit(inout RayPayload payload, BuiltInTriangleIntersectionAttributes attribs) {
     // 1. Calculate actual hit point attributes (worldPosition, worldNormal)
     float3 bary = float3(1.0 - attribs.barycentrics.x - attribs.barycentrics.y, attribs.barycentrics.x, attribs.barycentrics.y);
-    uint primitiveIdx = PrimitiveIndex();
-    uint indexSizeInBytes = 4; // Assuming R32_UINT indices
-    uint indexOffset = primitiveIdx * 3 * indexSizeInBytes;
-
-    uint i0 = g_indexBuffer.Load(indexOffset);
-    uint i1 = g_indexBuffer.Load(indexOffset + indexSizeInBytes);
-    uint i2 = g_indexBuffer.Load(indexOffset + indexSizeInBytes * 2);
-
-    Vertex v0 = g_vertexBuffer[i0];
-    Vertex v1 = g_vertexBuffer[i1];
-    Vertex v2 = g_vertexBuffer[i2];
-
-    float3 objectNormal = v0.normal * bary.x + v1.normal * bary.y + v2.normal * bary.z;
-    float3 objectPosition = v0.position * bary.x + v1.position * bary.y + v2.position * bary.z;
-    float2 hitTexCoord = v0.texCoord * bary.x + v1.texCoord * bary.y + v2.texCoord * bary.z; // For texturing later
-
+    uint3 indices = loadTriangleIndices(PrimitiveIndex()) + baseVertex;
+
+    Vertex v0 = g_vertexBuffer[indices.x];
+    Vertex v1 = g_vertexBuffer[indices.y];
+    Vertex v2 = g_vertexBuffer[indices.z];
+
+    float3 objectNormal = decodeNormal(v0) * bary.x + decodeNormal(v1) * bary.y + decodeNormal(v2) * bary.z;
+    float2 uv0 = decodeTexCoord(v0);
+    float2 uv1 = decodeTexCoord(v1);
+    float2 uv2 = decodeTexCoord(v2);
+    float2 hitTexCoord = uv0 * bary.x + uv1 * bary.y + uv2 * bary.z;
+
+#if SPLIT_POSITIONS
+    float3 p0 = loadPosition(indices.x); // No positions in g_vertexBuffer
+    float3 p1 = loadPosition(indices.y);
+    float3 p2 = loadPosition(indices.z);
+#else
+    float3 p0 = decodePosition(v0);
+    float3 p1 = decodePosition(v1);
+    float3 p2 = decodePosition(v2);
+#endif
+    float3 objectPosition = p0 * bary.x + p1 * bary.y + p2 * bary.z;
     float3 worldPosition = mul(worldMatrix, float4(objectPosition, 1.0)).xyz;
+    float textureLod = computeTextureLod(mul((float3x3)worldMatrix, p1 - p0), mul((float3x3)worldMatrix, p2 - p0),
+                                         uv0, uv1, uv2);
     float3 worldNormal = normalize(mul((float3x3)invTransposeWorldMatrix, objectNormal));
 
     // 2. --- Shadow Ray Tracing Section ---
@@ -141,7 +259,7 @@ void ClosestHit(inout RayPayload payload, BuiltInTriangleIntersectionAttributes
         RAY_FLAG_FORCE_NON_OPAQUE, // Standard shadow flags
         0xFF,       // Instance Mask
         1,          // Ray Contribution To Hit Group Index (ShadowHitGroup - SBT Index 1)
-        1,          // Multiplier for Geometry Index
+        2,          // Multiplier for Geometry Index
         1,          // Miss Shader Index (ShadowMiss - SBT Miss Index 1)
         shadowRay,
         payload     // payload.color and .visibility will be set by ShadowAnyHit or ShadowMiss
@@ -158,9 +276,9 @@ void ClosestHit(inout RayPayload payload, BuiltInTriangleIntersectionAttributes
 
     float4 lighting = ambient + (diffuse + specular) * payload.visibility;
 
-    float4 textureColor = g_texture.SampleLevel(g_sampler, hitTexCoord, 0.0f);
+    float4 textureColor = g_texture.SampleLevel(g_sampler, hitTexCoord, textureLod);
 
-    payload.color = saturate(textureColor * lighting);
+    payload.color = saturate(textureColor * diffuseColor * lighting + float4(emissiveColor, 0.0f));
 }
 // --- Shadow Miss Shader ---
 [shader("miss")] // This must match the export name "ShadowMiss" from C++
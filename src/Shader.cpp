@@ -1,7 +1,55 @@
 #include "Shader.hpp"
 #include <d3dcompiler.h>
 #include <d3dx12_core.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+
+#include "asset/DerivedDataCache.hpp"
+#include "asset/Hash.hpp"
+#include "asset/VirtualFileSystem.hpp"
+
+using namespace Microsoft::WRL;
+
+namespace {
+    // Bump whenever the compile step changes its output so cached bytecode gets rebuilt
+    constexpr uint64_t kShaderCompileRevision = 1;
+
+    // Resolves #include through the virtual file system, relative to the directory of the compiled shader
+    class VirtualFileInclude : public ID3DInclude {
+    public:
+        VirtualFileInclude(const VirtualFileSystem* fileSystem, std::filesystem::path directory)
+            : m_fileSystem(fileSystem), m_directory(std::move(directory)) {
+        }
+
+        HRESULT __stdcall Open(D3D_INCLUDE_TYPE, LPCSTR fileName, LPCVOID, LPCVOID* outData, UINT* outBytes) override {
+            auto file = std::make_unique<VirtualFile>();
+            if (!m_fileSystem->open((m_directory / fileName).string(), *file)) {
+                return E_FAIL;
+            }
+            *outData = file->data();
+            *outBytes = static_cast<UINT>(file->size());
+            m_files.push_back(std::move(file));
+            return S_OK;
+        }
+
+        HRESULT __stdcall Close(LPCVOID data) override {
+            auto it = std::find_if(m_files.begin(), m_files.end(),
+                                   [&](const std::unique_ptr<VirtualFile>& file) { return file->data() == data; });
+            if (it != m_files.end()) {
+                m_files.erase(it);
+            }
+            return S_OK;
+        }
+
+    private:
+        const VirtualFileSystem* m_fileSystem;
+        std::filesystem::path m_directory;
+        std::vector<std::unique_ptr<VirtualFile>> m_files; // Open includes, closed by the compiler
+    };
+}
 
 Shader::Shader() {
 }
@@ -9,7 +57,9 @@ Shader::Shader() {
 Shader::~Shader() {
 }
 
-bool Shader::loadAndCompile(const std::wstring& fileName, const std::string& entryPoint, const std::string& target) {
+bool Shader::loadAndCompile(const std::wstring& fileName, const std::string& entryPoint, const std::string& target,
+                            const std::vector<std::string>& defines, DerivedDataCache* derivedDataCache,
+                            const VirtualFileSystem* fileSystem) {
     UINT compileFlags = 0;
 
 #if defined(_DEBUG) || defined(DEBUG)
@@ -18,17 +68,61 @@ bool Shader::loadAndCompile(const std::wstring& fileName, const std::string& ent
     compileFlags = D3DCOMPILE_OPTIMIZATION_LEVEL3;
 #endif
 
-    HRESULT hr = D3DCompileFromFile(fileName.c_str(),
-                                    nullptr,
-                                    D3D_COMPILE_STANDARD_FILE_INCLUDE,
-                                    entryPoint.c_str(),
-                                    target.c_str(),
-                                    compileFlags,
-                                    0,
-                                    &m_shaderBlob,
-                                    &m_errorBlob);
+    std::vector<D3D_SHADER_MACRO> macros;
+    for (const std::string& define: defines) {
+        macros.push_back({define.c_str(), "1"});
+    }
+    macros.push_back({nullptr, nullptr});
+
+    // The source and its includes come from a pack when the file system has them, otherwise from disk
+    size_t convertedChars = 0;
+    char narrowFileName[MAX_PATH];
+    wcstombs_s(&convertedChars, narrowFileName, sizeof(narrowFileName), fileName.c_str(), _TRUNCATE);
+    VirtualFile source;
+    if (!openFile(fileSystem, narrowFileName, source)) {
+        OutputDebugStringW((L"Failed to open shader file: " + fileName + L"\n").c_str());
+        std::cerr << "Failed to open shader file: " << narrowFileName << std::endl;
+        return false;
+    }
+    VirtualFileInclude virtualFileInclude(fileSystem, std::filesystem::path(narrowFileName).parent_path());
+    ID3DInclude* include = fileSystem ? &virtualFileInclude : D3D_COMPILE_STANDARD_FILE_INCLUDE;
+
+    // Defines are already applied by the preprocessor, so the key only adds what the compiler itself sees.
+    // Preprocessing covers every file the shader includes, so an edited include misses.
+    uint64_t cacheKey = 0;
+    ComPtr<ID3DBlob> preprocessed;
+    ComPtr<ID3DBlob> preprocessErrors;
+    if (derivedDataCache && SUCCEEDED(D3DPreprocess(source.data(), source.size(), narrowFileName, macros.data(),
+                                                    include, &preprocessed, &preprocessErrors))) {
+        uint64_t options = hashCombine(hash64(entryPoint.data(), entryPoint.size()),
+                                       hash64(target.data(), target.size()));
+        options = hashCombine(options, compileFlags);
+        options = hashCombine(options, D3D_COMPILER_VERSION);
+        cacheKey = makeDerivedDataKey("shader-fxc", kShaderCompileRevision,
+                                      hash64(preprocessed->GetBufferPointer(), preprocessed->GetBufferSize()),
+                                      options);
+        std::vector<uint8_t> bytecode;
+        if (derivedDataCache->load(cacheKey, bytecode) && !bytecode.empty() &&
+            SUCCEEDED(D3DCreateBlob(bytecode.size(), &m_shaderBlob))) {
+            memcpy(m_shaderBlob->GetBufferPointer(), bytecode.data(), bytecode.size());
+            OutputDebugStringW((L"Shader loaded from cache: " + fileName + L"\n").c_str());
+            return true;
+        }
+    }
 
-    OutputDebugStringW((L"D3DCompileFromFile Result for " + fileName + L": " + std::to_wstring(hr) + L"\n").c_str());
+    HRESULT hr = D3DCompile(source.data(),
+                            source.size(),
+                            narrowFileName,
+                            macros.data(),
+                            include,
+                            entryPoint.c_str(),
+                            target.c_str(),
+                            compileFlags,
+                            0,
+                            &m_shaderBlob,
+                            &m_errorBlob);
+
+    OutputDebugStringW((L"D3DCompile Result for " + fileName + L": " + std::to_wstring(hr) + L"\n").c_str());
 
     if (FAILED(hr)) {
         OutputDebugStringW(L"Shader compilation failed!\n");
@@ -59,6 +153,9 @@ bool Shader::loadAndCompile(const std::wstring& fileName, const std::string& ent
         (L"Shader compilation SUCCEEDED for " + fileName + L". Size: " + std::to_wstring(m_shaderBlob->GetBufferSize())
          + L"\n").c_str());
     m_errorBlob.Reset(); // Release error blob if it exists
+    if (cacheKey != 0) {
+        derivedDataCache->store(cacheKey, m_shaderBlob->GetBufferPointer(), m_shaderBlob->GetBufferSize());
+    }
     return true;
 }
 
@@ -3,7 +3,10 @@
 #include <d3dx12_core.h>
 #include <wrl/client.h> // ComPtr
 #include <string>
+#include <vector>
 
+class DerivedDataCache;
+class VirtualFileSystem;
 
 class Shader {
 public:
@@ -11,7 +14,12 @@ public:
 
     ~Shader();
 
-    bool loadAndCompile(const std::wstring& fileName, const std::string& entryPoint, const std::string& target);
+    // defines are passed as "NAME=1" macros (e.g. the vertex format selection). With a derived-data cache,
+    // bytecode compiled before from the same preprocessed source, entry point, target and flags is reused.
+    // With a file system, the source and its includes are read through it (from packs first).
+    bool loadAndCompile(const std::wstring& fileName, const std::string& entryPoint, const std::string& target,
+                        const std::vector<std::string>& defines = {}, DerivedDataCache* derivedDataCache = nullptr,
+                        const VirtualFileSystem* fileSystem = nullptr);
 
     // Getters
     ID3DBlob* getBlob() const {
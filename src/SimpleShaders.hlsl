@@ -1,8 +1,13 @@
 
+#include "VertexDecode.hlsl"
+
 cbuffer ObjectConstants : register(b0)
 {
     float4x4 model;
     float4x4 mvp;
+    float4 positionScale; // Vertex dequantization, identity for float positions/UVs
+    float4 positionOffset;
+    float4 texCoordScaleOffset; // xy = scale, zw = offset
 };
 
 cbuffer LightConstants : register(b2)
@@ -16,7 +21,9 @@ cbuffer LightConstants : register(b2)
 
 
 cbuffer MaterialConstants : register(b3) {
+    float4 diffuseColor; // Tints the texture
     float4 specularColor;
+    float3 emissiveColor;
     float specularPower;
 };
 
@@ -27,15 +34,46 @@ Texture2D g_texture : register(t0);
 SamplerState g_sampler : register(s0);
 
 
-// Simple vertex structure matching our input layour
+// Simple vertex structure matching our input layour (getInputElementDescs for the mesh's VertexFormat)
 struct VertexInput
 {
+#if POSITION_SNORM16
+    float4 position : POSITION; // snorm16 relative to the mesh bounds, w unused
+#else
     float3 position : POSITION;
+#endif
+#if VERTEX_COLOR
     float4 color : COLOR;
-    float2 texcoord : TEXCOORD;
+#endif
+    float2 texcoord : TEXCOORD; // float, half or unorm16, expanded by the input assembler
+#if NORMAL_OCT16
+    float2 normal : NORMAL; // Octahedral
+#else
     float3 normal : NORMAL;
+#endif
 };
 
+// Position stream alone (depth prepass); same POSITION element as VertexInput
+struct VertexPositionInput
+{
+#if POSITION_SNORM16
+    float4 position : POSITION;
+#else
+    float3 position : POSITION;
+#endif
+};
+
+// Shared by both vertex shaders so the prepass and main pass produce bit-identical depth
+float3 decodePosition(float3 encoded) {
+    precise float3 position = encoded * positionScale.xyz + positionOffset.xyz;
+    return position;
+}
+
+float4 clipPosition(float3 position) {
+    precise float4 clip = mul(mvp, float4(position, 1.0f));
+    return clip;
+}
+
 // Data passed from Vertex Shader to Pixel Shader
 struct VertexOutput
 {
@@ -50,15 +88,30 @@ struct VertexOutput
 VertexOutput VSMain(VertexInput input) {
     VertexOutput output;
 
-    output.position = mul(mvp, float4(input.position, 1.0f));
+    float3 position = decodePosition(input.position.xyz);
+#if NORMAL_OCT16
+    float3 normal = octahedralDecode(input.normal);
+#else
+    float3 normal = input.normal;
+#endif
+
+    output.position = clipPosition(position);
+#if VERTEX_COLOR
     output.color = input.color;
-    output.texcoord = input.texcoord;
-    output.normal = input.normal;
-    output.worldNormal = mul((float3x3)model, input.normal);
-    output.worldPos = mul(model, float4(input.position, 1.0f)).xyz;
+#else
+    output.color = float4(1.0f, 1.0f, 1.0f, 1.0f);
+#endif
+    output.texcoord = input.texcoord * texCoordScaleOffset.xy + texCoordScaleOffset.zw;
+    output.normal = normal;
+    output.worldNormal = mul((float3x3)model, normal);
+    output.worldPos = mul(model, float4(position, 1.0f)).xyz;
     return output;
 }
 
+float4 VSDepth(VertexPositionInput input) : SV_POSITION {
+    return clipPosition(decodePosition(input.position.xyz));
+}
+
 float4 PSMain(VertexOutput input) : SV_TARGET {
     float3 normal = normalize(input.worldNormal);
     float3 lightDir = normalize(lightPosition - input.worldPos);
@@ -75,7 +128,7 @@ float4 PSMain(VertexOutput input) : SV_TARGET {
 
     float4 textureColor = g_texture.Sample(g_sampler, input.texcoord);
     
-    float4 finalColor = saturate(textureColor * lighting);
+    float4 finalColor = saturate(textureColor * diffuseColor * lighting + float4(emissiveColor, 0.0f));
         
     return finalColor;
 }
\ No newline at end of file
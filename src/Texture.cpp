@@ -6,11 +6,54 @@
 
 #include "d3dx12_barriers.h"
 #include "d3dx12_core.h"
-#include "d3dx12_resource_helpers.h"
-#include "../libs/stb/stb_image.hpp"
 
 using namespace Microsoft::WRL;
 
+namespace {
+    DXGI_FORMAT getDxgiFormat(TextureFormat format) {
+        switch (format) {
+            case TextureFormat::Bc1:
+                return DXGI_FORMAT_BC1_UNORM;
+            case TextureFormat::Bc3:
+                return DXGI_FORMAT_BC3_UNORM;
+            case TextureFormat::Bc5:
+                return DXGI_FORMAT_BC5_UNORM;
+            case TextureFormat::Bc7:
+                return DXGI_FORMAT_BC7_UNORM;
+            case TextureFormat::Rgba8:
+                break;
+        }
+        return DXGI_FORMAT_R8G8B8A8_UNORM;
+    }
+
+    // Created mapped: the caller writes the texture and unmaps it
+    ComPtr<ID3D12Resource> createUploadBuffer(ID3D12Device* device, const TextureUploadLayout& layout,
+                                              const std::wstring& name, uint8_t*& outData) {
+        ComPtr<ID3D12Resource> uploadBuffer;
+        auto uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
+        auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(layout.size);
+        HRESULT hr = device->CreateCommittedResource(
+            &uploadHeapProps,
+            D3D12_HEAP_FLAG_NONE,
+            &uploadBufferDesc,
+            D3D12_RESOURCE_STATE_GENERIC_READ,
+            nullptr,
+            IID_PPV_ARGS(&uploadBuffer));
+        if (FAILED(hr)) {
+            throw std::runtime_error("Failed to create upload buffer");
+        }
+        uploadBuffer->SetName(name.c_str());
+
+        D3D12_RANGE readRange = {0, 0}; // Written only
+        void* data = nullptr;
+        if (FAILED(uploadBuffer->Map(0, &readRange, &data))) {
+            throw std::runtime_error("Failed to map upload buffer");
+        }
+        outData = static_cast<uint8_t*>(data);
+        return uploadBuffer;
+    }
+}
+
 Texture::Texture() : m_srvHandleCPU({0}),
                      m_srvHandleGPU({0}),
                      m_width(0),
@@ -19,37 +62,70 @@ Texture::Texture() : m_srvHandleCPU({0}),
 }
 
 Texture::~Texture() {
+    if (m_descriptorHeap) {
+        m_descriptorHeap->freeDescriptor(m_srvHandleCPU);
+    }
 }
 
 ComPtr<ID3D12Resource> Texture::LoadFromFile(ID3D12Device* device,
                                              ID3D12GraphicsCommandList* commandList,
                                              DescriptorHeap* descriptorHeap,
                                              const std::wstring& filename,
-                                             const std::string& name) {
+                                             const std::string& name,
+                                             DerivedDataCache* derivedDataCache,
+                                             const VirtualFileSystem* fileSystem) {
     if (!device || !commandList || !descriptorHeap || filename.empty()) {
         throw std::invalid_argument("Invalid arguments for Texture::LoadFromFile");
     }
+    return upload(device, commandList, descriptorHeap, decodeFile(device, filename, derivedDataCache, fileSystem),
+                  name);
+}
 
-    m_name = name;
-
-    // --- 1. Load Image Data (stb_image) ---
-    int width, height, channels;
+DecodedTexture Texture::decodeFile(ID3D12Device* device, const std::wstring& filename,
+                                   DerivedDataCache* derivedDataCache, const VirtualFileSystem* fileSystem,
+                                   JobSystem* jobSystem) {
     size_t convertedChars = 0;
     char narrowFilename[MAX_PATH];
     wcstombs_s(&convertedChars, narrowFilename, sizeof(narrowFilename), filename.c_str(), _TRUNCATE);
 
-    unsigned char* pixels = stbi_load(narrowFilename, &width, &height, &channels, STBI_rgb_alpha);
-    if (!pixels) {
-        throw std::runtime_error("Failed to load texture file: " + std::string(narrowFilename));
+    // Uses "<filename>.texcache" (e.g. prebuilt by assetc) or the derived-data cache when up to date
+    TextureImportOptions options;
+    options.derivedDataCache = derivedDataCache;
+    options.fileSystem = fileSystem;
+    options.jobSystem = jobSystem;
+    DecodedTexture decoded;
+    loadTextureForUpload(narrowFilename, options, [&](const TextureUploadLayout& layout) {
+        uint8_t* data = nullptr;
+        decoded.uploadBuffer = createUploadBuffer(device, layout, filename + L" Upload Buffer", data);
+        return data;
+    }, decoded.layout);
+    decoded.uploadBuffer->Unmap(0, nullptr);
+    return decoded;
+}
+
+ComPtr<ID3D12Resource> Texture::upload(ID3D12Device* device,
+                                       ID3D12GraphicsCommandList* commandList,
+                                       DescriptorHeap* descriptorHeap,
+                                       const DecodedTexture& decoded,
+                                       const std::string& name) {
+    const TextureUploadLayout& layout = decoded.layout;
+    if (!device || !commandList || !descriptorHeap || !decoded.uploadBuffer || layout.width == 0 ||
+        layout.height == 0 || layout.mipCount == 0 || layout.mipCount > getMipCount(layout.width, layout.height) ||
+        (isBlockCompressed(layout.format) && (layout.width % 4 != 0 || layout.height % 4 != 0)) ||
+        layout.footprints.size() != layout.mipCount) {
+        throw std::invalid_argument("Invalid arguments for Texture::upload");
     }
-    m_width = static_cast<UINT>(width);
-    m_height = static_cast<UINT>(height);
-    m_format = DXGI_FORMAT_R8G8B8A8_UNORM;
-    UINT imageSize = static_cast<UINT>(width * height * 4);
 
-    // --- 2. Create Texture Resource (Default Heap) ---
+    m_name = name;
+    m_width = layout.width;
+    m_height = layout.height;
+    m_mipCount = layout.mipCount;
+    m_format = getDxgiFormat(layout.format);
+
+    // --- 1. Create Texture Resource (Default Heap) ---
     m_currentState = D3D12_RESOURCE_STATE_COPY_DEST;
-    D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(m_format, m_width, m_height, 1, 1);
+    D3D12_RESOURCE_DESC textureDesc = CD3DX12_RESOURCE_DESC::Tex2D(m_format, m_width, m_height, 1,
+                                                                     static_cast<UINT16>(m_mipCount));
     auto defaultHeapPros = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
     HRESULT hr = device->CreateCommittedResource(
         &defaultHeapPros,
@@ -59,61 +135,82 @@ ComPtr<ID3D12Resource> Texture::LoadFromFile(ID3D12Device* device,
         nullptr,
         IID_PPV_ARGS(&m_textureResource));
     if (FAILED(hr)) {
-        stbi_image_free(pixels);
         throw std::runtime_error("Failed to create texture resource");
     }
     std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
     std::wstring wideName = converter.from_bytes(m_name);
     m_textureResource->SetName(wideName.c_str()); // Use filename as debug name
 
-    ComPtr<ID3D12Resource> uploadBuffer;
+    // --- 2. Copy every level from the upload buffer ---
+    // The pixels were written by the layout of getCopyableFootprints, which must be the device's
+    std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(m_mipCount);
+    std::vector<UINT> rowCounts(m_mipCount);
+    std::vector<UINT64> rowSizes(m_mipCount);
     UINT64 uploadBufferSize = 0;
-    device->GetCopyableFootprints(&textureDesc, 0, 1, 0, nullptr, nullptr, nullptr, &uploadBufferSize);
-
-    // --- 3. Create Upload Buffer and Copy Data ---
-    auto uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-    auto uploadBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
-    hr = device->CreateCommittedResource(
-        &uploadHeapProps,
-        D3D12_HEAP_FLAG_NONE,
-        &uploadBufferDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ,
-        nullptr,
-        IID_PPV_ARGS(&uploadBuffer));
-
-    if (FAILED(hr)) {
-        stbi_image_free(pixels);
-        throw std::runtime_error("Failed to create upload buffer");
+    device->GetCopyableFootprints(&textureDesc, 0, m_mipCount, 0, layouts.data(), rowCounts.data(), rowSizes.data(),
+                                  &uploadBufferSize);
+    bool footprintsMatch = uploadBufferSize == layout.size;
+    for (UINT level = 0; level < m_mipCount; level++) {
+        const D3D12_SUBRESOURCE_FOOTPRINT& footprint = layouts[level].Footprint;
+        const TextureFootprint& expected = layout.footprints[level];
+        footprintsMatch = footprintsMatch && layouts[level].Offset == expected.offset &&
+                          footprint.Width == expected.width && footprint.Height == expected.height &&
+                          footprint.RowPitch == expected.rowPitch && rowCounts[level] == expected.rowCount &&
+                          rowSizes[level] == expected.rowSize;
+    }
+    if (!footprintsMatch) {
+        throw std::runtime_error("Upload layout of texture " + m_name + " differs from the device's");
+    }
+    for (UINT level = 0; level < m_mipCount; level++) {
+        CD3DX12_TEXTURE_COPY_LOCATION destination(m_textureResource.Get(), level);
+        CD3DX12_TEXTURE_COPY_LOCATION source(decoded.uploadBuffer.Get(), layouts[level]);
+        commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
     }
-
-    uploadBuffer->SetName((wideName + L"Upload Buffer").c_str());
-
-    D3D12_SUBRESOURCE_DATA textureData;
-    textureData.pData = pixels;
-    textureData.RowPitch = static_cast<LONG_PTR>(m_width) * 4;
-    textureData.SlicePitch = static_cast<LONG_PTR>(imageSize);
-
-    UpdateSubresources(commandList, m_textureResource.Get(), uploadBuffer.Get(), 0, 0, 1, &textureData);
     D3D12_RESOURCE_STATES finalStateAfterLoad = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
     TransitionToState(commandList, finalStateAfterLoad); // Use the new method
 
-    // --- 4. Create Shader Resource View (SRV) ---
+    // --- 3. Create Shader Resource View (SRV) ---
     if (!descriptorHeap->allocateDescriptor(m_srvHandleCPU, m_srvHandleGPU)) {
-        stbi_image_free(pixels);
         throw std::runtime_error("Failed to allocate descriptor for texture");
     }
+    m_descriptorHeap = descriptorHeap;
 
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
     srvDesc.Format = m_format;
     srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
     srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     srvDesc.Texture2D.MostDetailedMip = 0;
-    srvDesc.Texture2D.MipLevels = 1;
+    srvDesc.Texture2D.MipLevels = m_mipCount;
     device->CreateShaderResourceView(m_textureResource.Get(), &srvDesc, m_srvHandleCPU);
 
-    stbi_image_free(pixels);
+    return decoded.uploadBuffer;
+}
 
-    return uploadBuffer;
+ComPtr<ID3D12Resource> Texture::upload(ID3D12Device* device,
+                                       ID3D12GraphicsCommandList* commandList,
+                                       DescriptorHeap* descriptorHeap,
+                                       const TextureImage& image,
+                                       const std::string& name) {
+    if (!device || !commandList || !descriptorHeap || image.width == 0 || image.height == 0 ||
+        image.mipCount == 0 || image.mipCount > getMipCount(image.width, image.height) ||
+        (isBlockCompressed(image.format) && (image.width % 4 != 0 || image.height % 4 != 0)) ||
+        image.pixels.size() < getTextureChainSize(image.format, image.width, image.height, image.mipCount)) {
+        throw std::invalid_argument("Invalid arguments for Texture::upload");
+    }
+
+    DecodedTexture decoded;
+    decoded.layout = getTextureUploadLayout(image.format, image.width, image.height, image.mipCount);
+    std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+    uint8_t* data = nullptr;
+    decoded.uploadBuffer = createUploadBuffer(device, decoded.layout, converter.from_bytes(name) + L" Upload Buffer",
+                                              data);
+    std::vector<const uint8_t*> levels(image.mipCount);
+    for (uint32_t level = 0; level < image.mipCount; level++) {
+        levels[level] = image.pixels.data() + getTextureLevelOffset(image.format, image.width, image.height, level);
+    }
+    writeTextureLevels(decoded.layout, levels.data(), data);
+    decoded.uploadBuffer->Unmap(0, nullptr);
+    return upload(device, commandList, descriptorHeap, decoded, name);
 }
 
 void Texture::TransitionToState(
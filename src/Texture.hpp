@@ -1,10 +1,18 @@
 #pragma once
 #include <d3d12.h>
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <wrl/client.h>
 
 #include "DescriptorHeap.hpp"
+#include "asset/TextureImport.hpp"
 
+// A texture decoded into a mapped upload buffer (see Texture::decodeFile), ready for Texture::upload
+struct DecodedTexture {
+    Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer; // Laid out by layout, already unmapped
+    TextureUploadLayout layout;
+};
 
 class Texture {
 public:
@@ -17,6 +25,38 @@ public:
         ID3D12GraphicsCommandList* commandList,
         DescriptorHeap* descriptorHeap,
         const std::wstring& filename,
+        const std::string& name = "Texture",
+        DerivedDataCache* derivedDataCache = nullptr,
+        const VirtualFileSystem* fileSystem = nullptr
+    );
+
+    // Decodes an image file (stb_image) to its mip chain, block-compressed (BC1/BC3) when its size allows,
+    // through the texture cache (see loadTextureForUpload), or reads a DDS/KTX2 file, straight into a new
+    // upload buffer at the row pitch of the copy: no packed copy of the pixels is made for cached and prebuilt
+    // textures. Records no commands (the device is free-threaded), so any thread may call it. The job system
+    // filters and compresses an uncached texture in parallel. Throws std::runtime_error if the file cannot be
+    // read.
+    static DecodedTexture decodeFile(ID3D12Device* device, const std::wstring& filename,
+                                     DerivedDataCache* derivedDataCache = nullptr,
+                                     const VirtualFileSystem* fileSystem = nullptr, JobSystem* jobSystem = nullptr);
+
+    // Creates the texture and its SRV (covering every mip level) and records the copy from the upload buffer.
+    // Returns the upload buffer, which must stay alive until the copy has executed. The texture must be
+    // released before the heap.
+    Microsoft::WRL::ComPtr<ID3D12Resource> upload(
+        ID3D12Device* device,
+        ID3D12GraphicsCommandList* commandList,
+        DescriptorHeap* descriptorHeap,
+        const DecodedTexture& decoded,
+        const std::string& name = "Texture"
+    );
+
+    // The same from decoded pixels (e.g. a placeholder), which are written to a new upload buffer first
+    Microsoft::WRL::ComPtr<ID3D12Resource> upload(
+        ID3D12Device* device,
+        ID3D12GraphicsCommandList* commandList,
+        DescriptorHeap* descriptorHeap,
+        const TextureImage& image,
         const std::string& name = "Texture"
     );
 
@@ -38,17 +78,23 @@ public:
         return m_height;
     }
 
+    UINT getMipCount() const {
+        return m_mipCount;
+    }
+
     DXGI_FORMAT getFormat() const {
         return m_format;
     }
 
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> m_textureResource; // The actual texture resource (DEFAULT heap)
+    DescriptorHeap* m_descriptorHeap = nullptr; // Holds the SRV, which is freed with the texture
     D3D12_CPU_DESCRIPTOR_HANDLE m_srvHandleCPU; // CPU handle where SRV lives in heap
     D3D12_GPU_DESCRIPTOR_HANDLE m_srvHandleGPU; // GPU handle where SRV lives in heap (if shader visible)
     std::string m_name;
     UINT m_width = 0;
     UINT m_height = 0;
+    UINT m_mipCount = 1;
     DXGI_FORMAT m_format = DXGI_FORMAT_UNKNOWN;
     D3D12_RESOURCE_STATES m_currentState = D3D12_RESOURCE_STATE_COMMON;
 };
@@ -0,0 +1,25 @@
+// Shared decode helpers for the vertex encodings in asset/VertexFormat.hpp.
+// The C++ side defines POSITION_SNORM16, VERTEX_COLOR, TEXCOORD_HALF / TEXCOORD_UNORM16 and NORMAL_OCT16
+// to match the mesh's VertexFormat (getVertexFormatShaderDefines).
+#ifndef VERTEX_DECODE_HLSL
+#define VERTEX_DECODE_HLSL
+
+// Octahedral map back to a unit vector
+float3 octahedralDecode(float2 e) {
+    float3 n = float3(e.x, e.y, 1.0f - abs(e.x) - abs(e.y));
+    float t = saturate(-n.z);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+    return normalize(n);
+}
+
+// Manual unpacking of the low 16 bits, for raw StructuredBuffer reads where there is no input assembler
+float snorm16ToFloat(uint bits) {
+    return max((float)((int)(bits << 16) >> 16) / 32767.0f, -1.0f);
+}
+
+float unorm16ToFloat(uint bits) {
+    return (float)(bits & 0xFFFF) / 65535.0f;
+}
+
+#endif
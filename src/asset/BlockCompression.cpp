@@ -0,0 +1,1057 @@
+#include "BlockCompression.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "MipGenerator.hpp"
+#include "TextureImport.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    constexpr size_t kBlocksPerJob = 64;
+
+    struct Block {
+        uint8_t texels[16][4]; // RGBA, row by row
+    };
+
+    void loadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY,
+                   Block& block) {
+        for (uint32_t y = 0; y < 4; y++) {
+            const uint32_t sy = std::min(blockY * 4 + y, height - 1);
+            for (uint32_t x = 0; x < 4; x++) {
+                const uint32_t sx = std::min(blockX * 4 + x, width - 1);
+                memcpy(block.texels[y * 4 + x], pixels + (size_t(sy) * width + sx) * 4, 4);
+            }
+        }
+    }
+
+    inline int squared(int value) {
+        return value * value;
+    }
+
+    // --- Endpoint fitting, shared by BC1 and BC7 ---
+
+    // Line through a set of texels (channels 0 to channelCount - 1): the endpoints of its projection onto
+    // the principal axis, or the corners of the bounding box at Fast quality
+    void fitLine(const Block& block, const uint8_t* texels, int texelCount, int channelCount, bool boundingBox,
+                 float outEndpoints[2][4]) {
+        float mean[4] = {};
+        float minimum[4] = {255.0f, 255.0f, 255.0f, 255.0f};
+        float maximum[4] = {};
+        for (int i = 0; i < texelCount; i++) {
+            for (int c = 0; c < channelCount; c++) {
+                const float value = block.texels[texels[i]][c];
+                mean[c] += value;
+                minimum[c] = std::min(minimum[c], value);
+                maximum[c] = std::max(maximum[c], value);
+            }
+        }
+        for (int c = 0; c < 4; c++) {
+            mean[c] /= float(texelCount);
+            outEndpoints[0][c] = c < channelCount ? minimum[c] : 255.0f;
+            outEndpoints[1][c] = c < channelCount ? maximum[c] : 255.0f;
+        }
+        if (boundingBox) {
+            // Inset by 1/16 of the range: the extremes are rarely worth an exact palette entry
+            for (int c = 0; c < channelCount; c++) {
+                const float inset = (maximum[c] - minimum[c]) / 16.0f;
+                outEndpoints[0][c] += inset;
+                outEndpoints[1][c] -= inset;
+            }
+            return;
+        }
+
+        float covariance[4][4] = {};
+        for (int i = 0; i < texelCount; i++) {
+            float d[4] = {};
+            for (int c = 0; c < channelCount; c++) {
+                d[c] = block.texels[texels[i]][c] - mean[c];
+            }
+            for (int a = 0; a < channelCount; a++) {
+                for (int b = a; b < channelCount; b++) {
+                    covariance[a][b] += d[a] * d[b];
+                }
+            }
+        }
+        // Power iteration from the diagonal of the bounding box, which already points roughly along the axis
+        float axis[4] = {};
+        for (int c = 0; c < channelCount; c++) {
+            axis[c] = maximum[c] - minimum[c];
+        }
+        for (int iteration = 0; iteration < 8; iteration++) {
+            float next[4] = {};
+            float length = 0.0f;
+            for (int a = 0; a < channelCount; a++) {
+                for (int b = 0; b < channelCount; b++) {
+                    next[a] += (a <= b ? covariance[a][b] : covariance[b][a]) * axis[b];
+                }
+                length = std::max(length, std::abs(next[a]));
+            }
+            if (length == 0.0f) {
+                return; // A single color, or a degenerate axis: keep the bounding box
+            }
+            for (int c = 0; c < channelCount; c++) {
+                axis[c] = next[c] / length;
+            }
+        }
+        float lengthSquared = 0.0f;
+        for (int c = 0; c < channelCount; c++) {
+            lengthSquared += axis[c] * axis[c];
+        }
+        float minT = 1e30f;
+        float maxT = -1e30f;
+        for (int i = 0; i < texelCount; i++) {
+            float t = 0.0f;
+            for (int c = 0; c < channelCount; c++) {
+                t += (block.texels[texels[i]][c] - mean[c]) * axis[c];
+            }
+            minT = std::min(minT, t);
+            maxT = std::max(maxT, t);
+        }
+        for (int c = 0; c < channelCount; c++) {
+            outEndpoints[0][c] = std::clamp(mean[c] + axis[c] * minT / lengthSquared, 0.0f, 255.0f);
+            outEndpoints[1][c] = std::clamp(mean[c] + axis[c] * maxT / lengthSquared, 0.0f, 255.0f);
+        }
+    }
+
+    // Least-squares endpoints for the texels' current positions along the line (weights in [0, 1] from the
+    // first endpoint to the second). Returns false if the positions do not determine two endpoints.
+    bool solveEndpoints(const Block& block, const uint8_t* texels, int texelCount, const float* weights,
+                        int channelCount, float outEndpoints[2][4]) {
+        float aa = 0.0f;
+        float ab = 0.0f;
+        float bb = 0.0f;
+        float ax[4] = {};
+        float bx[4] = {};
+        for (int i = 0; i < texelCount; i++) {
+            const float t = weights[i];
+            aa += (1.0f - t) * (1.0f - t);
+            ab += (1.0f - t) * t;
+            bb += t * t;
+            for (int c = 0; c < channelCount; c++) {
+                ax[c] += (1.0f - t) * block.texels[texels[i]][c];
+                bx[c] += t * block.texels[texels[i]][c];
+            }
+        }
+        const float determinant = aa * bb - ab * ab;
+        if (std::abs(determinant) < 1e-6f) {
+            return false;
+        }
+        for (int c = 0; c < channelCount; c++) {
+            outEndpoints[0][c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+            outEndpoints[1][c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+        }
+        return true;
+    }
+
+    constexpr uint8_t kAllTexels[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+
+    int getRefinementCount(BlockQuality quality) {
+        return quality == BlockQuality::Fast ? 0 : (quality == BlockQuality::Normal ? 1 : 3);
+    }
+
+    // --- BC1 color ---
+
+    inline int expand5(int value) {
+        return (value << 3) | (value >> 2);
+    }
+
+    inline int expand6(int value) {
+        return (value << 2) | (value >> 4);
+    }
+
+    uint16_t packRgb565(const float color[4]) {
+        const int r = std::clamp(int(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+        const int g = std::clamp(int(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+        const int b = std::clamp(int(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    void unpackRgb565(uint16_t value, int rgb[3]) {
+        rgb[0] = expand5(value >> 11);
+        rgb[1] = expand6((value >> 5) & 63);
+        rgb[2] = expand5(value & 31);
+    }
+
+    // Four colors when c0 > c1 (or always, in BC3), otherwise three and transparent black
+    void getBc1Palette(uint16_t c0, uint16_t c1, bool fourColors, int palette[4][3]) {
+        unpackRgb565(c0, palette[0]);
+        unpackRgb565(c1, palette[1]);
+        for (int c = 0; c < 3; c++) {
+            if (fourColors) {
+                palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+            } else {
+                palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+                palette[3][c] = 0;
+            }
+        }
+    }
+
+    // Picks the nearest palette entry for every texel; returns the squared error. Three-color blocks never
+    // use the transparent entry, since BC1 textures are opaque.
+    int evaluateBc1(const Block& block, uint16_t c0, uint16_t c1, bool fourColors, uint32_t& outIndices) {
+        int palette[4][3];
+        getBc1Palette(c0, c1, fourColors, palette);
+        const int entryCount = fourColors ? 4 : 3;
+        int error = 0;
+        outIndices = 0;
+        for (int i = 0; i < 16; i++) {
+            int bestError = 1 << 30;
+            int bestIndex = 0;
+            for (int entry = 0; entry < entryCount; entry++) {
+                const int entryError = squared(block.texels[i][0] - palette[entry][0]) +
+                                       squared(block.texels[i][1] - palette[entry][1]) +
+                                       squared(block.texels[i][2] - palette[entry][2]);
+                if (entryError < bestError) {
+                    bestError = entryError;
+                    bestIndex = entry;
+                }
+            }
+            error += bestError;
+            outIndices |= uint32_t(bestIndex) << (i * 2);
+        }
+        return error;
+    }
+
+    // Endpoint pairs whose 1/3 interpolant reproduces each 8-bit value best, for single-color blocks
+    struct SingleColorTable {
+        uint8_t high[256];
+        uint8_t low[256];
+    };
+
+    SingleColorTable buildSingleColorTable(int bits) {
+        SingleColorTable table = {};
+        const int count = 1 << bits;
+        for (int value = 0; value < 256; value++) {
+            int bestError = 1 << 30;
+            for (int high = 0; high < count; high++) {
+                for (int low = 0; low < count; low++) {
+                    const int e0 = bits == 5 ? expand5(high) : expand6(high);
+                    const int e1 = bits == 5 ? expand5(low) : expand6(low);
+                    const int error = std::abs((2 * e0 + e1) / 3 - value) * 256 + std::abs(high - low);
+                    if (error < bestError) {
+                        bestError = error;
+                        table.high[value] = static_cast<uint8_t>(high);
+                        table.low[value] = static_cast<uint8_t>(low);
+                    }
+                }
+            }
+        }
+        return table;
+    }
+
+    void encodeBc1(const Block& block, BlockQuality quality, bool alwaysFourColors, uint8_t* dst) {
+        uint16_t c0;
+        uint16_t c1;
+        uint32_t indices;
+
+        bool singleColor = true;
+        for (int i = 1; i < 16 && singleColor; i++) {
+            singleColor = memcmp(block.texels[i], block.texels[0], 3) == 0;
+        }
+        if (singleColor) {
+            static const SingleColorTable table5 = buildSingleColorTable(5);
+            static const SingleColorTable table6 = buildSingleColorTable(6);
+            const uint8_t* color = block.texels[0];
+            c0 = static_cast<uint16_t>((table5.high[color[0]] << 11) | (table6.high[color[1]] << 5) |
+                                       table5.high[color[2]]);
+            c1 = static_cast<uint16_t>((table5.low[color[0]] << 11) | (table6.low[color[1]] << 5) |
+                                       table5.low[color[2]]);
+            indices = 0xAAAAAAAAu; // Entry 2: the 1/3 interpolant
+            if (c0 < c1) {
+                std::swap(c0, c1);
+                indices = 0xFFFFFFFFu; // Entry 3 is the same color once the endpoints swap
+            } else if (c0 == c1) {
+                indices = 0;
+            }
+        } else {
+            float endpoints[2][4];
+            fitLine(block, kAllTexels, 16, 3, quality == BlockQuality::Fast, endpoints);
+            c0 = packRgb565(endpoints[1]);
+            c1 = packRgb565(endpoints[0]);
+            if (c0 < c1) {
+                std::swap(c0, c1);
+            }
+            int error = evaluateBc1(block, c0, c1, true, indices);
+
+            // Four-color palette positions: c0, c1, 1/3, 2/3
+            constexpr float kFourColorWeights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+            for (int iteration = 0; iteration < getRefinementCount(quality) && error > 0; iteration++) {
+                float weights[16];
+                for (int i = 0; i < 16; i++) {
+                    weights[i] = kFourColorWeights[(indices >> (i * 2)) & 3];
+                }
+                float refined[2][4];
+                if (!solveEndpoints(block, kAllTexels, 16, weights, 3, refined)) {
+                    break;
+                }
+                uint16_t r0 = packRgb565(refined[0]);
+                uint16_t r1 = packRgb565(refined[1]);
+                if (r0 < r1) {
+                    std::swap(r0, r1);
+                }
+                uint32_t refinedIndices;
+                const int refinedError = evaluateBc1(block, r0, r1, true, refinedIndices);
+                if (refinedError >= error) {
+                    break;
+                }
+                c0 = r0;
+                c1 = r1;
+                indices = refinedIndices;
+                error = refinedError;
+            }
+
+            // The three-color mode (c0 <= c1) places its interpolant half-way, which suits some blocks better
+            if (quality == BlockQuality::High && !alwaysFourColors && c0 != c1) {
+                uint32_t threeColorIndices;
+                int threeColorError = evaluateBc1(block, c1, c0, false, threeColorIndices);
+                constexpr float kThreeColorWeights[3] = {0.0f, 1.0f, 0.5f};
+                float weights[16];
+                for (int i = 0; i < 16; i++) {
+                    weights[i] = kThreeColorWeights[(threeColorIndices >> (i * 2)) & 3];
+                }
+                float refined[2][4];
+                uint16_t t0 = c1;
+                uint16_t t1 = c0;
+                if (solveEndpoints(block, kAllTexels, 16, weights, 3, refined)) {
+                    uint16_t r0 = packRgb565(refined[0]);
+                    uint16_t r1 = packRgb565(refined[1]);
+                    if (r0 > r1) {
+                        std::swap(r0, r1);
+                    }
+                    uint32_t refinedIndices;
+                    const int refinedError = evaluateBc1(block, r0, r1, false, refinedIndices);
+                    if (refinedError < threeColorError) {
+                        t0 = r0;
+                        t1 = r1;
+                        threeColorIndices = refinedIndices;
+                        threeColorError = refinedError;
+                    }
+                }
+                if (threeColorError < error) {
+                    c0 = t0;
+                    c1 = t1;
+                    indices = threeColorIndices;
+                }
+            }
+        }
+        memcpy(dst, &c0, 2);
+        memcpy(dst + 2, &c1, 2);
+        memcpy(dst + 4, &indices, 4);
+    }
+
+    void decodeBc1(const uint8_t* src, bool alwaysFourColors, Block& block) {
+        uint16_t c0;
+        uint16_t c1;
+        uint32_t indices;
+        memcpy(&c0, src, 2);
+        memcpy(&c1, src + 2, 2);
+        memcpy(&indices, src + 4, 4);
+        const bool fourColors = alwaysFourColors || c0 > c1;
+        int palette[4][3];
+        getBc1Palette(c0, c1, fourColors, palette);
+        for (int i = 0; i < 16; i++) {
+            const int entry = (indices >> (i * 2)) & 3;
+            for (int c = 0; c < 3; c++) {
+                block.texels[i][c] = static_cast<uint8_t>(palette[entry][c]);
+            }
+            block.texels[i][3] = (!fourColors && entry == 3) ? 0 : 255;
+        }
+    }
+
+    // --- BC4 single channel (BC3 alpha, BC5) ---
+
+    // Eight values when a0 > a1, otherwise six plus 0 and 255
+    void getBc4Palette(int a0, int a1, int palette[8]) {
+        palette[0] = a0;
+        palette[1] = a1;
+        if (a0 > a1) {
+            for (int i = 1; i < 7; i++) {
+                palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+            }
+        } else {
+            for (int i = 1; i < 5; i++) {
+                palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+            }
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+    }
+
+    int evaluateBc4(const uint8_t values[16], int a0, int a1, uint64_t& outIndices) {
+        int palette[8];
+        getBc4Palette(a0, a1, palette);
+        int error = 0;
+        outIndices = 0;
+        for (int i = 0; i < 16; i++) {
+            int bestError = 1 << 30;
+            int bestIndex = 0;
+            for (int entry = 0; entry < 8; entry++) {
+                const int entryError = squared(values[i] - palette[entry]);
+                if (entryError < bestError) {
+                    bestError = entryError;
+                    bestIndex = entry;
+                }
+            }
+            error += bestError;
+            outIndices |= uint64_t(bestIndex) << (i * 3);
+        }
+        return error;
+    }
+
+    void encodeBc4(const uint8_t values[16], BlockQuality quality, uint8_t* dst) {
+        int minimum = 255;
+        int maximum = 0;
+        int innerMinimum = 255; // Without the 0 and 255 the six-value mode represents exactly
+        int innerMaximum = 0;
+        for (int i = 0; i < 16; i++) {
+            minimum = std::min<int>(minimum, values[i]);
+            maximum = std::max<int>(maximum, values[i]);
+            if (values[i] != 0 && values[i] != 255) {
+                innerMinimum = std::min<int>(innerMinimum, values[i]);
+                innerMaximum = std::max<int>(innerMaximum, values[i]);
+            }
+        }
+        int a0 = maximum;
+        int a1 = minimum;
+        uint64_t indices;
+        int error = evaluateBc4(values, a0, a1, indices);
+        if (quality != BlockQuality::Fast && error > 0) {
+            auto tryEndpoints = [&](int c0, int c1) {
+                uint64_t candidateIndices;
+                const int candidateError = evaluateBc4(values, c0, c1, candidateIndices);
+                if (candidateError < error) {
+                    a0 = c0;
+                    a1 = c1;
+                    indices = candidateIndices;
+                    error = candidateError;
+                }
+            };
+            if (innerMinimum <= innerMaximum && (minimum == 0 || maximum == 255)) {
+                tryEndpoints(innerMinimum, innerMaximum);
+            }
+            if (quality == BlockQuality::High && maximum > minimum) {
+                // Pulling the endpoints in lets the interpolants land closer to clustered values
+                for (int d0 = -2; d0 <= 0; d0++) {
+                    for (int d1 = 0; d1 <= 2; d1++) {
+                        if (maximum + d0 > minimum + d1) {
+                            tryEndpoints(maximum + d0, minimum + d1);
+                        }
+                    }
+                }
+            }
+        }
+        dst[0] = static_cast<uint8_t>(a0);
+        dst[1] = static_cast<uint8_t>(a1);
+        for (int i = 0; i < 6; i++) {
+            dst[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+        }
+    }
+
+    void decodeBc4(const uint8_t* src, uint8_t* values, size_t stride) {
+        int palette[8];
+        getBc4Palette(src[0], src[1], palette);
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; i++) {
+            indices |= uint64_t(src[2 + i]) << (i * 8);
+        }
+        for (int i = 0; i < 16; i++) {
+            values[i * stride] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+        }
+    }
+
+    void encodeBc4Channel(const Block& block, int channel, BlockQuality quality, uint8_t* dst) {
+        uint8_t values[16];
+        for (int i = 0; i < 16; i++) {
+            values[i] = block.texels[i][channel];
+        }
+        encodeBc4(values, quality, dst);
+    }
+
+    // --- BC7 ---
+
+    class BitWriter {
+    public:
+        explicit BitWriter(uint8_t* dst) : m_dst(dst) {
+            memset(dst, 0, 16);
+        }
+
+        void write(uint32_t value, uint32_t bits) {
+            for (uint32_t i = 0; i < bits; i++, m_position++) {
+                m_dst[m_position >> 3] |= static_cast<uint8_t>(((value >> i) & 1) << (m_position & 7));
+            }
+        }
+
+    private:
+        uint8_t* m_dst;
+        uint32_t m_position = 0;
+    };
+
+    class BitReader {
+    public:
+        explicit BitReader(const uint8_t* src) : m_src(src) {
+        }
+
+        uint32_t read(uint32_t bits) {
+            uint32_t value = 0;
+            for (uint32_t i = 0; i < bits; i++, m_position++) {
+                value |= uint32_t((m_src[m_position >> 3] >> (m_position & 7)) & 1) << i;
+            }
+            return value;
+        }
+
+    private:
+        const uint8_t* m_src;
+        uint32_t m_position = 0;
+    };
+
+    constexpr int kWeights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+    constexpr int kWeights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    // Two-subset partitions: bit i is the subset of texel i
+    constexpr uint16_t kPartitions2[64] = {
+        0xCCCC, 0x8888, 0xEEEE, 0xECC8, 0xC880, 0xFEEC, 0xFEC8, 0xEC80, 0xC800, 0xFFEC, 0xFE80, 0xE800, 0xFFE8,
+        0xFF00, 0xFFF0, 0xF000, 0xF710, 0x008E, 0x7100, 0x08CE, 0x008C, 0x7310, 0x3100, 0x8CCE, 0x088C, 0x3110,
+        0x6666, 0x366C, 0x17E8, 0x0FF0, 0x718E, 0x399C, 0xAAAA, 0xF0F0, 0x5A5A, 0x33CC, 0x3C3C, 0x55AA, 0x9696,
+        0xA55A, 0x73CE, 0x13C8, 0x324C, 0x3BDC, 0x6996, 0xC33C, 0x9966, 0x0660, 0x0272, 0x04E4, 0x4E40, 0x2720,
+        0xC936, 0x936C, 0x39C6, 0x639C, 0x9336, 0x9CC6, 0x817E, 0xE718, 0xCCF0, 0x0FCC, 0x7744, 0xEE22,
+    };
+
+    // Texel of the second subset whose index drops its top bit
+    constexpr uint8_t kAnchors2[64] = {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 2, 8, 2, 2, 8, 8, 15, 2, 8, 2, 2,
+        8, 8, 2, 2, 15, 15, 6, 8, 2, 8, 15, 15, 2, 8, 2, 2, 2, 15, 15, 6, 6, 2, 6, 8, 15, 15, 2, 2, 15, 15,
+        15, 15, 15, 2, 2, 15,
+    };
+
+    struct Bc7Mode {
+        int indexBits;
+        int endpointBits; // Per channel, before the p-bit
+        bool sharedPBit; // One p-bit per subset instead of per endpoint
+        int channelCount; // 3: alpha is 255
+    };
+
+    constexpr Bc7Mode kMode1 = {3, 6, true, 3};
+    constexpr Bc7Mode kMode6 = {4, 7, false, 4};
+
+    // One subset: quantized endpoints (without p-bits), p-bits and the texel indices
+    struct Bc7Subset {
+        int endpoints[2][4];
+        int pBits[2];
+        uint8_t indices[16]; // By position in the subset's texel list
+        int error;
+    };
+
+    inline int expandBc7Endpoint(const Bc7Mode& mode, int value, int pBit) {
+        const int bits = mode.endpointBits + 1;
+        const int withPBit = (value << 1) | pBit;
+        return (withPBit << (8 - bits)) | (withPBit >> (2 * bits - 8));
+    }
+
+    inline int interpolateBc7(int e0, int e1, int weight) {
+        return ((64 - weight) * e0 + weight * e1 + 32) >> 6;
+    }
+
+    // Quantizes float endpoints for the given p-bits, then picks every texel's index
+    void evaluateBc7Subset(const Bc7Mode& mode, const Block& block, const uint8_t* texels, int texelCount,
+                           const float endpoints[2][4], int p0, int p1, Bc7Subset& out) {
+        const int maxValue = (1 << mode.endpointBits) - 1;
+        const float scale = float((1 << (mode.endpointBits + 1)) - 1) / 255.0f;
+        int expanded[2][4];
+        const int pBits[2] = {p0, p1};
+        for (int e = 0; e < 2; e++) {
+            for (int c = 0; c < 4; c++) {
+                if (c < mode.channelCount) {
+                    out.endpoints[e][c] =
+                        std::clamp(int((endpoints[e][c] * scale - pBits[e]) * 0.5f + 0.5f), 0, maxValue);
+                    expanded[e][c] = expandBc7Endpoint(mode, out.endpoints[e][c], pBits[e]);
+                } else {
+                    out.endpoints[e][c] = 0;
+                    expanded[e][c] = 255;
+                }
+            }
+            out.pBits[e] = pBits[e];
+        }
+        const int* weights = mode.indexBits == 3 ? kWeights3 : kWeights4;
+        const int entryCount = 1 << mode.indexBits;
+        int palette[16][4];
+        for (int entry = 0; entry < entryCount; entry++) {
+            for (int c = 0; c < 4; c++) {
+                palette[entry][c] = interpolateBc7(expanded[0][c], expanded[1][c], weights[entry]);
+            }
+        }
+        // The projection on the endpoint axis picks the entry up to rounding; only its neighbours are compared
+        int axis[4];
+        int lengthSquared = 0;
+        for (int c = 0; c < 4; c++) {
+            axis[c] = expanded[1][c] - expanded[0][c];
+            lengthSquared += axis[c] * axis[c];
+        }
+        const float projectionScale = lengthSquared > 0 ? float(entryCount - 1) / float(lengthSquared) : 0.0f;
+        out.error = 0;
+        for (int i = 0; i < texelCount; i++) {
+            const uint8_t* texel = block.texels[texels[i]];
+            int projection = 0;
+            for (int c = 0; c < 4; c++) {
+                projection += (texel[c] - expanded[0][c]) * axis[c];
+            }
+            const int guess = std::clamp(int(float(projection) * projectionScale + 0.5f), 0, entryCount - 1);
+            int bestError = 1 << 30;
+            int bestIndex = 0;
+            for (int entry = std::max(guess - 1, 0); entry <= std::min(guess + 1, entryCount - 1); entry++) {
+                const int entryError = squared(texel[0] - palette[entry][0]) + squared(texel[1] - palette[entry][1]) +
+                                       squared(texel[2] - palette[entry][2]) + squared(texel[3] - palette[entry][3]);
+                if (entryError < bestError) {
+                    bestError = entryError;
+                    bestIndex = entry;
+                }
+            }
+            out.error += bestError;
+            out.indices[i] = static_cast<uint8_t>(bestIndex);
+        }
+    }
+
+    // Tries the p-bit choices for the endpoints and keeps the best
+    void quantizeBc7Subset(const Bc7Mode& mode, const Block& block, const uint8_t* texels, int texelCount,
+                           const float endpoints[2][4], BlockQuality quality, Bc7Subset& best) {
+        best.error = 1 << 30;
+        Bc7Subset candidate;
+        if (mode.sharedPBit) {
+            for (int p = 0; p < 2; p++) {
+                evaluateBc7Subset(mode, block, texels, texelCount, endpoints, p, p, candidate);
+                if (candidate.error < best.error) {
+                    best = candidate;
+                }
+            }
+            return;
+        }
+        if (quality == BlockQuality::Fast) {
+            // The p-bit that rounds each endpoint best, judged on its brightest channel
+            int pBits[2];
+            for (int e = 0; e < 2; e++) {
+                const float value = *std::max_element(endpoints[e], endpoints[e] + mode.channelCount);
+                const int scaled = int(value * float((1 << (mode.endpointBits + 1)) - 1) / 255.0f + 0.5f);
+                pBits[e] = scaled & 1;
+            }
+            evaluateBc7Subset(mode, block, texels, texelCount, endpoints, pBits[0], pBits[1], best);
+            return;
+        }
+        for (int p = 0; p < 4; p++) {
+            evaluateBc7Subset(mode, block, texels, texelCount, endpoints, p & 1, p >> 1, candidate);
+            if (candidate.error < best.error) {
+                best = candidate;
+            }
+        }
+    }
+
+    // Least-squares refinements of the endpoints for the current indices, while they lower the error
+    void refineBc7Subset(const Bc7Mode& mode, const Block& block, const uint8_t* texels, int texelCount,
+                         BlockQuality quality, int iterationCount, Bc7Subset& best) {
+        const int* indexWeights = mode.indexBits == 3 ? kWeights3 : kWeights4;
+        for (int iteration = 0; iteration < iterationCount && best.error > 0; iteration++) {
+            float weights[16];
+            for (int i = 0; i < texelCount; i++) {
+                weights[i] = indexWeights[best.indices[i]] / 64.0f;
+            }
+            float refined[2][4];
+            if (!solveEndpoints(block, texels, texelCount, weights, mode.channelCount, refined)) {
+                break;
+            }
+            Bc7Subset candidate;
+            quantizeBc7Subset(mode, block, texels, texelCount, refined, quality, candidate);
+            if (candidate.error >= best.error) {
+                break;
+            }
+            best = candidate;
+        }
+    }
+
+    void fitBc7Subset(const Bc7Mode& mode, const Block& block, const uint8_t* texels, int texelCount,
+                      BlockQuality quality, int refinementCount, Bc7Subset& best) {
+        float endpoints[2][4];
+        fitLine(block, texels, texelCount, mode.channelCount, quality == BlockQuality::Fast, endpoints);
+        quantizeBc7Subset(mode, block, texels, texelCount, endpoints, quality, best);
+        refineBc7Subset(mode, block, texels, texelCount, quality, refinementCount, best);
+    }
+
+    // The anchor texel's index is stored without its top bit, which must therefore be 0: otherwise swap the
+    // endpoints, which mirrors every index
+    void fixBc7Anchor(const Bc7Mode& mode, Bc7Subset& subset, int anchorPosition, int texelCount) {
+        const int highestIndex = (1 << mode.indexBits) - 1;
+        if (subset.indices[anchorPosition] <= highestIndex >> 1) {
+            return;
+        }
+        for (int c = 0; c < 4; c++) {
+            std::swap(subset.endpoints[0][c], subset.endpoints[1][c]);
+        }
+        std::swap(subset.pBits[0], subset.pBits[1]);
+        for (int i = 0; i < texelCount; i++) {
+            subset.indices[i] = static_cast<uint8_t>(highestIndex - subset.indices[i]);
+        }
+    }
+
+    void writeBc7Mode6(Bc7Subset& subset, uint8_t* dst) {
+        fixBc7Anchor(kMode6, subset, 0, 16);
+        BitWriter writer(dst);
+        writer.write(1 << 6, 7);
+        for (int c = 0; c < 4; c++) {
+            writer.write(subset.endpoints[0][c], 7);
+            writer.write(subset.endpoints[1][c], 7);
+        }
+        writer.write(subset.pBits[0], 1);
+        writer.write(subset.pBits[1], 1);
+        for (int i = 0; i < 16; i++) {
+            writer.write(subset.indices[i], i == 0 ? 3 : 4);
+        }
+    }
+
+    // Texels of each subset of a two-subset partition, in texel order
+    int splitPartition(int partition, uint8_t texels[2][16], int counts[2]) {
+        counts[0] = 0;
+        counts[1] = 0;
+        for (int i = 0; i < 16; i++) {
+            const int subset = (kPartitions2[partition] >> i) & 1;
+            texels[subset][counts[subset]++] = static_cast<uint8_t>(i);
+        }
+        return counts[0];
+    }
+
+    // Per-texel sums for estimatePartitionError: r, g, b, rr, rg, rb, gg, gb, bb
+    struct TexelMoments {
+        float texels[16][9];
+        float total[9];
+    };
+
+    void computeTexelMoments(const Block& block, TexelMoments& moments) {
+        memset(moments.total, 0, sizeof(moments.total));
+        for (int i = 0; i < 16; i++) {
+            const float r = block.texels[i][0];
+            const float g = block.texels[i][1];
+            const float b = block.texels[i][2];
+            const float values[9] = {r, g, b, r * r, r * g, r * b, g * g, g * b, b * b};
+            for (int k = 0; k < 9; k++) {
+                moments.texels[i][k] = values[k];
+                moments.total[k] += values[k];
+            }
+        }
+    }
+
+    // Variance of a subset's texels that its principal axis leaves over, i.e. their squared distance to the
+    // line: trace of the covariance minus its largest eigenvalue, from a few power iterations
+    float estimateSubsetError(const float* sums, int count) {
+        const float inverseCount = 1.0f / float(count);
+        const float rr = sums[3] - sums[0] * sums[0] * inverseCount;
+        const float rg = sums[4] - sums[0] * sums[1] * inverseCount;
+        const float rb = sums[5] - sums[0] * sums[2] * inverseCount;
+        const float gg = sums[6] - sums[1] * sums[1] * inverseCount;
+        const float gb = sums[7] - sums[1] * sums[2] * inverseCount;
+        const float bb = sums[8] - sums[2] * sums[2] * inverseCount;
+        const float trace = rr + gg + bb;
+        if (trace <= 0.0f) {
+            return 0.0f;
+        }
+        float axis[3] = {rr + rg + rb, rg + gg + gb, rb + gb + bb};
+        for (int iteration = 0; iteration < 3; iteration++) {
+            const float next[3] = {rr * axis[0] + rg * axis[1] + rb * axis[2],
+                                   rg * axis[0] + gg * axis[1] + gb * axis[2],
+                                   rb * axis[0] + gb * axis[1] + bb * axis[2]};
+            const float length = std::max({std::abs(next[0]), std::abs(next[1]), std::abs(next[2])});
+            if (length == 0.0f) {
+                return trace;
+            }
+            const float inverseLength = 1.0f / length;
+            for (int c = 0; c < 3; c++) {
+                axis[c] = next[c] * inverseLength;
+            }
+        }
+        // Rayleigh quotient of the converged axis
+        const float product[3] = {rr * axis[0] + rg * axis[1] + rb * axis[2],
+                                  rg * axis[0] + gg * axis[1] + gb * axis[2],
+                                  rb * axis[0] + gb * axis[1] + bb * axis[2]};
+        const float largest = (axis[0] * product[0] + axis[1] * product[1] + axis[2] * product[2]) /
+                              (axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+        return std::max(trace - largest, 0.0f);
+    }
+
+    // A cheap estimate of a partition's error: the second subset's sums are accumulated, the first's follow
+    // from the totals
+    float estimatePartitionError(const TexelMoments& moments, int partition) {
+        float sums[2][9] = {};
+        int count = 0;
+        for (uint32_t mask = kPartitions2[partition]; mask != 0; mask &= mask - 1) {
+            const float* texel = moments.texels[std::countr_zero(mask)];
+            for (int k = 0; k < 9; k++) {
+                sums[1][k] += texel[k];
+            }
+            count++;
+        }
+        for (int k = 0; k < 9; k++) {
+            sums[0][k] = moments.total[k] - sums[1][k];
+        }
+        return estimateSubsetError(sums[0], 16 - count) + estimateSubsetError(sums[1], count);
+    }
+
+    // Mode 1 with the best of a few partitions ranked by their estimated error; returns the squared error
+    int encodeBc7Mode1(const Block& block, BlockQuality quality, uint8_t* dst) {
+        constexpr int kCandidateCount = 4;
+        TexelMoments moments;
+        computeTexelMoments(block, moments);
+        std::array<std::pair<float, int>, 64> ranked;
+        for (int partition = 0; partition < 64; partition++) {
+            ranked[partition] = {estimatePartitionError(moments, partition), partition};
+        }
+        std::partial_sort(ranked.begin(), ranked.begin() + kCandidateCount, ranked.end());
+
+        // The candidates are compared after one refinement; only the best gets the remaining ones
+        int bestPartition = 0;
+        int bestError = 1 << 30;
+        uint8_t texels[2][16];
+        int counts[2];
+        Bc7Subset subsets[2];
+        for (int candidate = 0; candidate < kCandidateCount; candidate++) {
+            const int partition = ranked[candidate].second;
+            splitPartition(partition, texels, counts);
+            Bc7Subset candidateSubsets[2];
+            fitBc7Subset(kMode1, block, texels[0], counts[0], quality, 1, candidateSubsets[0]);
+            fitBc7Subset(kMode1, block, texels[1], counts[1], quality, 1, candidateSubsets[1]);
+            const int error = candidateSubsets[0].error + candidateSubsets[1].error;
+            if (error < bestError) {
+                bestPartition = partition;
+                bestError = error;
+                subsets[0] = candidateSubsets[0];
+                subsets[1] = candidateSubsets[1];
+            }
+        }
+        splitPartition(bestPartition, texels, counts);
+        for (int s = 0; s < 2; s++) {
+            refineBc7Subset(kMode1, block, texels[s], counts[s], quality, getRefinementCount(quality) - 1, subsets[s]);
+        }
+
+        // Texel 0 anchors the first subset; the table gives the second subset's anchor
+        const int anchor = kAnchors2[bestPartition];
+        const int anchorPosition = int(std::find(texels[1], texels[1] + counts[1], uint8_t(anchor)) - texels[1]);
+        fixBc7Anchor(kMode1, subsets[0], 0, counts[0]);
+        fixBc7Anchor(kMode1, subsets[1], anchorPosition, counts[1]);
+
+        BitWriter writer(dst);
+        writer.write(1 << 1, 2);
+        writer.write(bestPartition, 6);
+        for (int c = 0; c < 3; c++) {
+            for (int s = 0; s < 2; s++) {
+                writer.write(subsets[s].endpoints[0][c], 6);
+                writer.write(subsets[s].endpoints[1][c], 6);
+            }
+        }
+        writer.write(subsets[0].pBits[0], 1);
+        writer.write(subsets[1].pBits[0], 1);
+        int positions[2] = {0, 0};
+        for (int i = 0; i < 16; i++) {
+            const int s = (kPartitions2[bestPartition] >> i) & 1;
+            writer.write(subsets[s].indices[positions[s]++], (i == 0 || i == anchor) ? 2 : 3);
+        }
+        return subsets[0].error + subsets[1].error;
+    }
+
+    void encodeBc7(const Block& block, BlockQuality quality, uint8_t* dst) {
+        Bc7Subset subset;
+        fitBc7Subset(kMode6, block, kAllTexels, 16, quality, getRefinementCount(quality), subset);
+        const int mode6Error = subset.error;
+        writeBc7Mode6(subset, dst);
+
+        bool opaque = true;
+        for (int i = 0; i < 16 && opaque; i++) {
+            opaque = block.texels[i][3] == 255;
+        }
+        if (quality == BlockQuality::High && opaque && mode6Error > 0) {
+            uint8_t mode1[16];
+            if (encodeBc7Mode1(block, quality, mode1) < mode6Error) {
+                memcpy(dst, mode1, 16);
+            }
+        }
+    }
+
+    void decodeBc7(const uint8_t* src, Block& block) {
+        memset(&block, 0, sizeof(block));
+        BitReader reader(src);
+        int modeIndex = 0;
+        while (modeIndex < 8 && reader.read(1) == 0) {
+            modeIndex++;
+        }
+        if (modeIndex != 1 && modeIndex != 6) {
+            return;
+        }
+        const Bc7Mode& mode = modeIndex == 1 ? kMode1 : kMode6;
+        const int subsetCount = modeIndex == 1 ? 2 : 1;
+        const int partition = modeIndex == 1 ? int(reader.read(6)) : 0;
+        int endpoints[2][2][4] = {}; // Subset, endpoint, channel
+        for (int c = 0; c < mode.channelCount; c++) {
+            for (int s = 0; s < subsetCount; s++) {
+                endpoints[s][0][c] = int(reader.read(mode.endpointBits));
+                endpoints[s][1][c] = int(reader.read(mode.endpointBits));
+            }
+        }
+        int pBits[2][2];
+        for (int s = 0; s < subsetCount; s++) {
+            pBits[s][0] = int(reader.read(1));
+            pBits[s][1] = mode.sharedPBit ? pBits[s][0] : int(reader.read(1));
+        }
+        int expanded[2][2][4];
+        for (int s = 0; s < subsetCount; s++) {
+            for (int e = 0; e < 2; e++) {
+                for (int c = 0; c < 4; c++) {
+                    expanded[s][e][c] =
+                        c < mode.channelCount ? expandBc7Endpoint(mode, endpoints[s][e][c], pBits[s][e]) : 255;
+                }
+            }
+        }
+        const int* weights = mode.indexBits == 3 ? kWeights3 : kWeights4;
+        const int anchor = modeIndex == 1 ? kAnchors2[partition] : 0;
+        for (int i = 0; i < 16; i++) {
+            const int s = modeIndex == 1 ? (kPartitions2[partition] >> i) & 1 : 0;
+            const bool isAnchor = i == 0 || (s == 1 && i == anchor);
+            const int index = int(reader.read(mode.indexBits - (isAnchor ? 1 : 0)));
+            for (int c = 0; c < 4; c++) {
+                block.texels[i][c] =
+                    static_cast<uint8_t>(interpolateBc7(expanded[s][0][c], expanded[s][1][c], weights[index]));
+            }
+        }
+    }
+
+    void encodeBlock(const Block& block, TextureFormat format, BlockQuality quality, uint8_t* dst) {
+        switch (format) {
+            case TextureFormat::Bc1:
+                encodeBc1(block, quality, false, dst);
+                break;
+            case TextureFormat::Bc3:
+                encodeBc4Channel(block, 3, quality, dst);
+                encodeBc1(block, quality, true, dst + 8);
+                break;
+            case TextureFormat::Bc5:
+                encodeBc4Channel(block, 0, quality, dst);
+                encodeBc4Channel(block, 1, quality, dst + 8);
+                break;
+            case TextureFormat::Bc7:
+                encodeBc7(block, quality, dst);
+                break;
+            case TextureFormat::Rgba8:
+                break;
+        }
+    }
+
+    void decodeBlock(const uint8_t* src, TextureFormat format, Block& block) {
+        switch (format) {
+            case TextureFormat::Bc1:
+                decodeBc1(src, false, block);
+                break;
+            case TextureFormat::Bc3:
+                decodeBc1(src + 8, true, block);
+                decodeBc4(src, &block.texels[0][3], 4);
+                break;
+            case TextureFormat::Bc5:
+                decodeBc4(src, &block.texels[0][0], 4);
+                decodeBc4(src + 8, &block.texels[0][1], 4);
+                for (int i = 0; i < 16; i++) {
+                    block.texels[i][2] = 0;
+                    block.texels[i][3] = 255;
+                }
+                break;
+            case TextureFormat::Bc7:
+                decodeBc7(src, block);
+                break;
+            case TextureFormat::Rgba8:
+                break;
+        }
+    }
+}
+
+size_t getBlockSize(TextureFormat format) {
+    switch (format) {
+        case TextureFormat::Bc1:
+            return 8;
+        case TextureFormat::Bc3:
+        case TextureFormat::Bc5:
+        case TextureFormat::Bc7:
+            return 16;
+        case TextureFormat::Rgba8:
+            break;
+    }
+    return 4;
+}
+
+size_t getTextureRowPitch(TextureFormat format, uint32_t width) {
+    const size_t units = isBlockCompressed(format) ? (size_t(width) + 3) / 4 : width;
+    return units * getBlockSize(format);
+}
+
+uint32_t getTextureRowCount(TextureFormat format, uint32_t height) {
+    return isBlockCompressed(format) ? (height + 3) / 4 : height;
+}
+
+size_t getTextureChainSize(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount) {
+    size_t size = 0;
+    for (uint32_t level = 0; level < mipCount; level++) {
+        size += getTextureLevelSize(format, getMipSize(width, level), getMipSize(height, level));
+    }
+    return size;
+}
+
+void compressImage(const uint8_t* pixels, uint32_t width, uint32_t height, TextureFormat format,
+                   BlockQuality quality, uint8_t* dst, JobSystem* jobSystem) {
+    if (!isBlockCompressed(format)) {
+        memcpy(dst, pixels, size_t(width) * height * 4);
+        return;
+    }
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const size_t blockSize = getBlockSize(format);
+    parallelFor(jobSystem, blocksY, std::max<size_t>(1, kBlocksPerJob / blocksX), [&](size_t begin, size_t end) {
+        Block block;
+        for (size_t y = begin; y < end; y++) {
+            for (uint32_t x = 0; x < blocksX; x++) {
+                loadBlock(pixels, width, height, x, static_cast<uint32_t>(y), block);
+                encodeBlock(block, format, quality, dst + (y * blocksX + x) * blockSize);
+            }
+        }
+    });
+}
+
+void decompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, TextureFormat format,
+                     uint8_t* pixels) {
+    if (!isBlockCompressed(format)) {
+        memcpy(pixels, blocks, size_t(width) * height * 4);
+        return;
+    }
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const size_t blockSize = getBlockSize(format);
+    Block block;
+    for (uint32_t by = 0; by < blocksY; by++) {
+        for (uint32_t bx = 0; bx < blocksX; bx++) {
+            decodeBlock(blocks + (size_t(by) * blocksX + bx) * blockSize, format, block);
+            for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++) {
+                for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++) {
+                    memcpy(pixels + ((size_t(by) * 4 + y) * width + bx * 4 + x) * 4, block.texels[y * 4 + x], 4);
+                }
+            }
+        }
+    }
+}
+
+void compressTexture(TextureImage& image, TextureFormat format, BlockQuality quality, JobSystem* jobSystem) {
+    if (image.format == format) {
+        return;
+    }
+    std::vector<uint8_t> compressed(getTextureChainSize(format, image.width, image.height, image.mipCount));
+    for (uint32_t level = 0; level < image.mipCount; level++) {
+        compressImage(image.pixels.data() + getMipOffset(image.width, image.height, level),
+                      getMipSize(image.width, level), getMipSize(image.height, level), format, quality,
+                      compressed.data() + getTextureLevelOffset(format, image.width, image.height, level), jobSystem);
+    }
+    image.pixels = std::move(compressed);
+    image.format = format;
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+class JobSystem;
+struct TextureImage;
+
+// CPU encoder (and reference decoder) for the BC formats of 4x4 texel blocks. BC1 and BC3 fit the colors of a
+// block on their principal axis and refine the endpoints by least squares; BC3 alpha and BC5 channels are BC4
+// blocks; BC7 uses mode 6 (one RGBA subset, 4-bit indices) and, at High quality, mode 1 (two RGB subsets over
+// the best of 64 partitions) for opaque blocks. Blocks are independent, so rows of blocks are encoded in
+// parallel on the job system.
+
+// Pixel layout of a texture's levels; every block-compressed level is padded to whole 4x4 blocks
+enum class TextureFormat : uint32_t {
+    Rgba8, // R8G8B8A8_UNORM
+    Bc1, // BC1_UNORM: RGB, 8 bytes per block (8:1)
+    Bc3, // BC3_UNORM: BC1 color plus interpolated alpha, 16 bytes per block (4:1)
+    Bc5, // BC5_UNORM: two channels (red and green, e.g. tangent-space normals), 16 bytes per block
+    Bc7, // BC7_UNORM: RGBA, 16 bytes per block, at a higher quality than BC1/BC3 but slower to encode
+};
+
+constexpr uint32_t kTextureFormatCount = 5;
+
+enum class BlockQuality : uint32_t {
+    Fast, // Bounding-box endpoints: for previews and iteration
+    Normal, // Principal axis and one refinement
+    High, // More refinements and encoding modes; BC7 searches two-subset partitions
+};
+
+inline bool isBlockCompressed(TextureFormat format) {
+    return format != TextureFormat::Rgba8;
+}
+
+// Bytes per 4x4 block, or per texel for Rgba8
+size_t getBlockSize(TextureFormat format);
+
+// Bytes per row of texels, or of blocks, as D3D12_SUBRESOURCE_DATA::RowPitch expects for a tightly packed level
+size_t getTextureRowPitch(TextureFormat format, uint32_t width);
+
+// Rows of texels, or of blocks
+uint32_t getTextureRowCount(TextureFormat format, uint32_t height);
+
+inline size_t getTextureLevelSize(TextureFormat format, uint32_t width, uint32_t height) {
+    return getTextureRowPitch(format, width) * getTextureRowCount(format, height);
+}
+
+// Bytes of the first mipCount levels stored back to back from level 0, and the offset of a level among them
+size_t getTextureChainSize(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount);
+
+inline size_t getTextureLevelOffset(TextureFormat format, uint32_t width, uint32_t height, uint32_t level) {
+    return getTextureChainSize(format, width, height, level);
+}
+
+// Encodes an RGBA8 image into getTextureLevelSize(format, width, height) bytes; the texels of blocks that
+// cross the right or bottom edge repeat the last column or row
+void compressImage(const uint8_t* pixels, uint32_t width, uint32_t height, TextureFormat format,
+                   BlockQuality quality, uint8_t* dst, JobSystem* jobSystem = nullptr);
+
+// Decodes back to RGBA8, e.g. to measure the error. BC5 decodes to (red, green, 0, 255). Only the BC7 modes
+// this encoder emits (1 and 6) are decoded; blocks of other modes decode to transparent black.
+void decompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, TextureFormat format,
+                     uint8_t* pixels);
+
+// Replaces the RGBA8 levels of an image with their compressed form
+void compressTexture(TextureImage& image, TextureFormat format, BlockQuality quality,
+                     JobSystem* jobSystem = nullptr);
@@ -0,0 +1,217 @@
+#include "DerivedDataCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+
+#include "Hash.hpp"
+#include "MappedFile.hpp"
+
+namespace {
+    std::string toFileName(uint64_t key, const char* extension) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+        return std::string(name) + extension;
+    }
+}
+
+uint64_t makeDerivedDataKey(const char* kind, uint64_t version, uint64_t contentHash, uint64_t optionsHash) {
+    uint64_t key = hash64(kind, strlen(kind), kDerivedDataCacheVersion);
+    key = hashCombine(key, version);
+    key = hashCombine(key, contentHash);
+    return hashCombine(key, optionsHash);
+}
+
+DerivedDataCache::DerivedDataCache() {
+}
+
+DerivedDataCache::~DerivedDataCache() {
+}
+
+bool DerivedDataCache::open(const std::string& directory, uint64_t maxSizeBytes) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    if (ec || !std::filesystem::is_directory(directory, ec)) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_directory = directory;
+    m_maxSize = maxSizeBytes;
+    m_totalSize = 0;
+    m_entries.clear();
+    for (const auto& item : std::filesystem::directory_iterator(directory, ec)) {
+        if (!item.is_regular_file(ec)) {
+            continue;
+        }
+        if (item.path().extension() == ".tmp") {
+            std::filesystem::remove(item.path(), ec); // Left behind by a write that never finished
+            continue;
+        }
+        Entry entry = {};
+        entry.size = item.file_size(ec);
+        entry.lastUse = item.last_write_time(ec);
+        if (!ec) {
+            m_entries[item.path().filename().string()] = entry;
+            m_totalSize += entry.size;
+        }
+    }
+    trimLocked();
+    return true;
+}
+
+bool DerivedDataCache::load(uint64_t key, std::vector<uint8_t>& outData) {
+    if (!isOpen()) {
+        return false;
+    }
+    const std::string path = getEntryPath(key, ".ddc");
+    bool valid = false;
+    {
+        MappedFile file;
+        if (!file.open(path)) {
+            return false; // Not cached
+        }
+        DerivedDataHeader header = {};
+        if (file.size() >= sizeof(header)) {
+            memcpy(&header, file.data(), sizeof(header));
+            const uint8_t* payload = file.data() + sizeof(header);
+            valid = header.magic == kDerivedDataMagic && header.version == kDerivedDataCacheVersion &&
+                    header.key == key && header.payloadSize == file.size() - sizeof(header) &&
+                    hash64(payload, static_cast<size_t>(header.payloadSize)) == header.payloadHash;
+            if (valid) {
+                outData.assign(payload, payload + header.payloadSize);
+            }
+        }
+    }
+    if (!valid) {
+        remove(path); // Unmapped first, so it can be deleted on Windows too
+        return false;
+    }
+    touch(path);
+    return true;
+}
+
+bool DerivedDataCache::store(uint64_t key, const void* data, size_t size) {
+    if (!isOpen()) {
+        return false;
+    }
+    const std::string path = getEntryPath(key, ".ddc");
+    std::string tempPath;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint64_t unique = hashCombine(std::hash<std::thread::id>()(std::this_thread::get_id()), ++m_tempCounter);
+        tempPath = path + "." + toFileName(unique, ".tmp");
+    }
+
+    DerivedDataHeader header = {};
+    header.magic = kDerivedDataMagic;
+    header.version = kDerivedDataCacheVersion;
+    header.key = key;
+    header.payloadSize = size;
+    header.payloadHash = hash64(data, size);
+
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && (size == 0 || fwrite(data, 1, size, file) == size);
+    ok = (fclose(file) == 0) && ok;
+
+    // Readers only ever see the old entry or the complete new one
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tempPath, path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    recordWrite(path);
+    return true;
+}
+
+std::string DerivedDataCache::getEntryPath(uint64_t key, const char* extension) const {
+    return (std::filesystem::path(m_directory) / toFileName(key, extension)).string();
+}
+
+void DerivedDataCache::touch(const std::string& path) {
+    std::error_code ec;
+    const auto now = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(path, now, ec);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(std::filesystem::path(path).filename().string());
+    if (it != m_entries.end()) {
+        it->second.lastUse = now;
+    }
+}
+
+void DerivedDataCache::recordWrite(const std::string& path) {
+    std::error_code ec;
+    Entry entry = {};
+    entry.size = std::filesystem::file_size(path, ec);
+    entry.lastUse = std::filesystem::file_time_type::clock::now();
+    if (ec) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Entry& slot = m_entries[std::filesystem::path(path).filename().string()];
+    m_totalSize = m_totalSize - slot.size + entry.size; // slot.size is 0 for a new entry
+    slot = entry;
+    trimLocked();
+}
+
+void DerivedDataCache::remove(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(std::filesystem::path(path).filename().string());
+    if (it != m_entries.end()) {
+        m_totalSize -= it->second.size;
+        m_entries.erase(it);
+    }
+}
+
+void DerivedDataCache::trim() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    trimLocked();
+}
+
+uint64_t DerivedDataCache::getTotalSize() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalSize;
+}
+
+size_t DerivedDataCache::getEntryCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+void DerivedDataCache::trimLocked() {
+    if (m_totalSize <= m_maxSize) {
+        return;
+    }
+    std::vector<std::pair<std::filesystem::file_time_type, std::string>> byAge;
+    byAge.reserve(m_entries.size());
+    for (const auto& [name, entry] : m_entries) {
+        byAge.emplace_back(entry.lastUse, name);
+    }
+    std::sort(byAge.begin(), byAge.end());
+    for (const auto& [lastUse, name] : byAge) {
+        if (m_totalSize <= m_maxSize) {
+            break;
+        }
+        std::error_code ec;
+        std::filesystem::remove(std::filesystem::path(m_directory) / name, ec);
+        if (ec) {
+            continue; // Still mapped by a loader (Windows); stays until a later trim
+        }
+        m_totalSize -= m_entries[name].size;
+        m_entries.erase(name);
+    }
+}
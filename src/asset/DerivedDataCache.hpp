@@ -0,0 +1,93 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Local cache of processed asset data (imported meshes, decoded textures, compiled shaders), shared by
+// every loader. Entries are files in one directory named after a 64-bit key built from the source bytes,
+// the processing options and the version of the code that produced them, so a changed input simply
+// misses instead of having to be detected. Writes go to a temporary file that is renamed into place, and
+// the directory is kept under a size limit by evicting the least recently used entries (the last write
+// time of an entry doubles as its last use, so recency survives restarts).
+
+// Bump when every entry must be rebuilt (e.g. a change to the blob format)
+constexpr uint32_t kDerivedDataCacheVersion = 1;
+
+constexpr uint32_t kDerivedDataMagic = 0x44445844; // "DXDD"
+
+// Header of a blob entry; the payload follows it and is checked against payloadHash on every load
+struct DerivedDataHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint64_t payloadSize;
+    uint64_t payloadHash; // hash64 of the payload
+};
+
+// Key of one artifact: kind names the loader (e.g. "texture") and version is that loader's revision,
+// contentHash covers the source bytes and optionsHash whatever else shapes the result
+uint64_t makeDerivedDataKey(const char* kind, uint64_t version, uint64_t contentHash, uint64_t optionsHash);
+
+class DerivedDataCache {
+public:
+    DerivedDataCache();
+
+    ~DerivedDataCache();
+
+    DerivedDataCache(const DerivedDataCache&) = delete;
+
+    DerivedDataCache& operator=(const DerivedDataCache&) = delete;
+
+    // Creates the directory if needed, indexes the existing entries (deleting temporary files left by
+    // interrupted writes) and trims it to maxSizeBytes. Returns false if the directory cannot be created.
+    bool open(const std::string& directory, uint64_t maxSizeBytes);
+
+    bool isOpen() const {
+        return !m_directory.empty();
+    }
+
+    // Copies the payload of a blob entry into outData. A truncated or corrupted entry (wrong header, size
+    // or payload hash) is deleted and reported as a miss.
+    bool load(uint64_t key, std::vector<uint8_t>& outData);
+
+    // Writes a blob entry atomically, then evicts old entries if the size limit is exceeded
+    bool store(uint64_t key, const void* data, size_t size);
+
+    // Path of an entry in a loader's own file format (e.g. a memory-mapped mesh cache). Such loaders
+    // validate the file themselves and report hits and writes with touch() and recordWrite().
+    std::string getEntryPath(uint64_t key, const char* extension) const;
+
+    // Marks an entry as just used, so it is evicted last
+    void touch(const std::string& path);
+
+    // Accounts for a file written (or replaced) at path, then evicts old entries if needed
+    void recordWrite(const std::string& path);
+
+    void remove(const std::string& path);
+
+    // Deletes least recently used entries until the directory fits in the size limit
+    void trim();
+
+    uint64_t getTotalSize() const;
+
+    size_t getEntryCount() const;
+
+private:
+    struct Entry {
+        uint64_t size;
+        std::filesystem::file_time_type lastUse;
+    };
+
+    void trimLocked();
+
+    std::string m_directory;
+    uint64_t m_maxSize = 0;
+    uint64_t m_totalSize = 0;
+    uint64_t m_tempCounter = 0; // Distinguishes temporary files of concurrent writers
+    std::unordered_map<std::string, Entry> m_entries; // By file name
+    mutable std::mutex m_mutex; // Loaders run as jobs, so entries are added and used from several threads
+};
@@ -0,0 +1,1042 @@
+#include "GltfImport.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include "Json.hpp"
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+namespace {
+    constexpr uint32_t kGlbMagic = 0x46546C67; // "glTF"
+    constexpr uint32_t kGlbVersion = 2;
+    constexpr uint32_t kGlbChunkJson = 0x4E4F534A; // "JSON"
+    constexpr uint32_t kGlbChunkBin = 0x004E4942; // "BIN\0"
+
+    // Accessor component types
+    constexpr int kByte = 5120;
+    constexpr int kUnsignedByte = 5121;
+    constexpr int kShort = 5122;
+    constexpr int kUnsignedShort = 5123;
+    constexpr int kUnsignedInt = 5125;
+    constexpr int kFloat = 5126;
+
+    constexpr int kModeTriangles = 4;
+    constexpr int kTargetArrayBuffer = 34962;
+    constexpr int kTargetElementArrayBuffer = 34963;
+
+    // Required extensions the importer honours; any other one makes the file unreadable
+    const char* const kSupportedExtensions[] = {"KHR_mesh_quantization", "KHR_materials_emissive_strength"};
+
+    struct BufferRange {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // A validated accessor: element i starts at data + i * stride and lies inside its buffer view
+    struct Accessor {
+        const JsonValue* json = nullptr; // Null when the attribute is absent
+        const uint8_t* data = nullptr;
+        size_t count = 0;
+        size_t stride = 0;
+        int componentType = 0;
+        int componentCount = 0;
+        bool normalized = false;
+        int bufferView = -1;
+    };
+
+    struct Document {
+        std::string filename;
+        std::filesystem::path directory; // External buffers and images are relative to it
+        JsonValue json;
+        std::vector<BufferRange> buffers;
+    };
+
+    [[noreturn]] void fail(const Document& document, const std::string& reason) {
+        throw std::runtime_error("Invalid glTF file " + document.filename + ": " + reason);
+    }
+
+    inline uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    // Index of another glTF object, or -1 if the value is absent or not one
+    int getIndex(const JsonValue& value) {
+        const double number = value.asNumber(-1.0);
+        return number >= 0.0 && number < 2147483647.0 && number == std::floor(number) ? static_cast<int>(number) : -1;
+    }
+
+    // A byte offset, length or count; fallback if absent
+    size_t getSize(const Document& document, const JsonValue& value, size_t fallback, const char* what) {
+        if (value.isNull()) {
+            return fallback;
+        }
+        const double number = value.asNumber(-1.0);
+        if (!(number >= 0.0 && number <= 9007199254740992.0 && number == std::floor(number))) {
+            fail(document, std::string("invalid ") + what);
+        }
+        return static_cast<size_t>(number);
+    }
+
+    size_t getComponentSize(int componentType) {
+        switch (componentType) {
+            case kByte:
+            case kUnsignedByte:
+                return 1;
+            case kShort:
+            case kUnsignedShort:
+                return 2;
+            case kUnsignedInt:
+            case kFloat:
+                return 4;
+            default:
+                return 0;
+        }
+    }
+
+    // Matrices are never vertex attributes or indices, so they count as invalid
+    int getComponentCount(const std::string& type) {
+        const char* const types[] = {"SCALAR", "VEC2", "VEC3", "VEC4"};
+        for (int i = 0; i < 4; ++i) {
+            if (type == types[i]) {
+                return i + 1;
+            }
+        }
+        return 0;
+    }
+
+    // Relative URIs may be percent-encoded (e.g. "%20" for a space)
+    std::string decodeUri(const std::string& uri) {
+        std::string decoded;
+        decoded.reserve(uri.size());
+        for (size_t i = 0; i < uri.size(); ++i) {
+            unsigned value = 0;
+            if (uri[i] == '%' && i + 2 < uri.size() &&
+                std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3) {
+                decoded += static_cast<char>(value);
+                i += 2;
+            } else {
+                decoded += uri[i];
+            }
+        }
+        return decoded;
+    }
+
+    std::string encodeUri(const std::string& path) {
+        static const char* hexDigits = "0123456789ABCDEF";
+        std::string encoded;
+        for (unsigned char c : path) {
+            if (isalnum(c) || strchr("-._~/", c)) {
+                encoded += static_cast<char>(c);
+            } else {
+                encoded += '%';
+                encoded += hexDigits[c >> 4];
+                encoded += hexDigits[c & 15];
+            }
+        }
+        return encoded;
+    }
+
+    BufferRange getBufferView(const Document& document, int index, size_t* outStride = nullptr) {
+        const JsonValue& view = document.json["bufferViews"][static_cast<size_t>(index)];
+        const int buffer = getIndex(view["buffer"]);
+        if (!view.isObject() || buffer < 0 || static_cast<size_t>(buffer) >= document.buffers.size()) {
+            fail(document, "invalid buffer view " + std::to_string(index));
+        }
+        const BufferRange& range = document.buffers[buffer];
+        const size_t offset = getSize(document, view["byteOffset"], 0, "buffer view offset");
+        const size_t length = getSize(document, view["byteLength"], SIZE_MAX, "buffer view length");
+        if (offset > range.size || length > range.size - offset) {
+            fail(document, "buffer view " + std::to_string(index) + " exceeds its buffer");
+        }
+        if (outStride) {
+            *outStride = getSize(document, view["byteStride"], 0, "buffer view stride");
+        }
+        return {range.data + offset, length};
+    }
+
+    Accessor getAccessor(const Document& document, int index) {
+        const JsonValue& json = document.json["accessors"][static_cast<size_t>(index)];
+        if (index < 0 || !json.isObject()) {
+            fail(document, "invalid accessor " + std::to_string(index));
+        }
+        if (json.has("sparse")) {
+            fail(document, "sparse accessors are not supported");
+        }
+        Accessor accessor;
+        accessor.json = &json;
+        accessor.componentType = getIndex(json["componentType"]);
+        accessor.componentCount = getComponentCount(json["type"].asString());
+        accessor.normalized = json["normalized"].asBool();
+        accessor.count = getSize(document, json["count"], SIZE_MAX, "accessor count");
+        accessor.bufferView = getIndex(json["bufferView"]);
+        const size_t elementSize = getComponentSize(accessor.componentType) * accessor.componentCount;
+        if (elementSize == 0 || accessor.count == SIZE_MAX) {
+            fail(document, "invalid accessor " + std::to_string(index));
+        }
+        if (accessor.bufferView < 0) {
+            fail(document, "accessors without a buffer view are not supported");
+        }
+        size_t stride = 0;
+        const BufferRange view = getBufferView(document, accessor.bufferView, &stride);
+        accessor.stride = stride > 0 ? stride : elementSize;
+        const size_t offset = getSize(document, json["byteOffset"], 0, "accessor offset");
+        if (accessor.count > 0 && (accessor.stride < elementSize || offset > view.size ||
+                                   view.size - offset < elementSize ||
+                                   accessor.count - 1 > (view.size - offset - elementSize) / accessor.stride)) {
+            fail(document, "accessor " + std::to_string(index) + " exceeds its buffer view");
+        }
+        accessor.data = view.data + offset;
+        return accessor;
+    }
+
+    // Up to four components of element index, converted to float (normalized integers to [0, 1] / [-1, 1])
+    void readComponents(const Accessor& accessor, size_t index, float* out) {
+        const uint8_t* element = accessor.data + index * accessor.stride;
+        for (int c = 0; c < std::min(accessor.componentCount, 4); ++c) {
+            switch (accessor.componentType) {
+                case kFloat:
+                    memcpy(&out[c], element + c * 4, sizeof(float));
+                    break;
+                case kUnsignedByte:
+                    out[c] = accessor.normalized ? element[c] / 255.0f : element[c];
+                    break;
+                case kByte: {
+                    const float value = static_cast<int8_t>(element[c]);
+                    out[c] = accessor.normalized ? std::max(value / 127.0f, -1.0f) : value;
+                    break;
+                }
+                case kUnsignedShort: {
+                    uint16_t value;
+                    memcpy(&value, element + c * 2, sizeof(value));
+                    out[c] = accessor.normalized ? value / 65535.0f : value;
+                    break;
+                }
+                case kShort: {
+                    int16_t value;
+                    memcpy(&value, element + c * 2, sizeof(value));
+                    out[c] = accessor.normalized ? std::max(value / 32767.0f, -1.0f) : value;
+                    break;
+                }
+                case kUnsignedInt: {
+                    uint32_t value;
+                    memcpy(&value, element + c * 4, sizeof(value));
+                    out[c] = static_cast<float>(value);
+                    break;
+                }
+            }
+        }
+    }
+
+    uint32_t readIndex(const Accessor& accessor, size_t index) {
+        const uint8_t* element = accessor.data + index * accessor.stride;
+        if (accessor.componentType == kUnsignedByte) {
+            return element[0];
+        }
+        if (accessor.componentType == kUnsignedShort) {
+            uint16_t value;
+            memcpy(&value, element, sizeof(value));
+            return value;
+        }
+        return read32(element);
+    }
+
+    template <typename T>
+    uint32_t findMaxIndex(const uint8_t* data, size_t count, size_t stride) {
+        uint32_t maxIndex = 0;
+        for (size_t i = 0; i < count; ++i) {
+            T value;
+            memcpy(&value, data + i * stride, sizeof(value));
+            maxIndex = std::max<uint32_t>(maxIndex, value);
+        }
+        return maxIndex;
+    }
+
+    // The vertex attributes of a primitive; primitives naming the same accessors share their vertices
+    struct VertexSet {
+        std::array<int, 4> key; // POSITION, NORMAL, TEXCOORD_0 and COLOR_0 accessors (-1 when absent)
+        Accessor position;
+        Accessor normal;
+        Accessor texCoord;
+        Accessor color;
+        uint32_t baseVertex = 0;
+    };
+
+    struct Primitive {
+        size_t set;
+        Accessor indices; // Absent for non-indexed primitives
+        uint32_t materialIndex;
+    };
+
+    // True if the attributes are interleaved exactly like Vertex, so whole vertices can be used as they are
+    bool matchesVertexLayout(const VertexSet& set) {
+        auto isFloats = [&](const Accessor& accessor, int componentCount, size_t offset) {
+            return accessor.json && accessor.componentType == kFloat && !accessor.normalized &&
+                   accessor.componentCount == componentCount && accessor.stride == sizeof(Vertex) &&
+                   accessor.count == set.position.count && accessor.bufferView == set.position.bufferView &&
+                   accessor.data == set.position.data + offset;
+        };
+        return isFloats(set.position, 3, offsetof(Vertex, position)) &&
+               isFloats(set.color, 4, offsetof(Vertex, color)) &&
+               isFloats(set.texCoord, 2, offsetof(Vertex, texCoord)) &&
+               isFloats(set.normal, 3, offsetof(Vertex, normal));
+    }
+
+    void convertVertices(const VertexSet& set, Vertex* out) {
+        for (size_t i = 0; i < set.position.count; ++i) {
+            Vertex& vertex = out[i];
+            vertex = {};
+            vertex.color = glm::vec4(1.0f); // Default white, as for OBJ
+            readComponents(set.position, i, &vertex.position.x);
+            if (set.normal.json) {
+                readComponents(set.normal, i, &vertex.normal.x);
+            }
+            if (set.texCoord.json) {
+                readComponents(set.texCoord, i, &vertex.texCoord.x);
+            }
+            if (set.color.json) {
+                readComponents(set.color, i, &vertex.color.x);
+            }
+        }
+    }
+
+    MeshBounds makeBounds(const glm::vec3& aabbMin, const glm::vec3& aabbMax) {
+        MeshBounds bounds = {};
+        bounds.aabbMin = aabbMin;
+        bounds.aabbMax = aabbMax;
+        bounds.center = (aabbMin + aabbMax) * 0.5f;
+        bounds.radius = glm::length(aabbMax - aabbMin) * 0.5f;
+        return bounds;
+    }
+
+    // From the accessor's min/max (required for positions) when they are float positions, else from the data
+    MeshBounds getPositionBounds(const Accessor& position) {
+        const JsonValue& minimum = (*position.json)["min"];
+        const JsonValue& maximum = (*position.json)["max"];
+        glm::vec3 aabbMin(FLT_MAX);
+        glm::vec3 aabbMax(-FLT_MAX);
+        if (position.componentType == kFloat && minimum.size() == 3 && maximum.size() == 3) {
+            for (int c = 0; c < 3; ++c) {
+                aabbMin[c] = static_cast<float>(minimum[c].asNumber());
+                aabbMax[c] = static_cast<float>(maximum[c].asNumber());
+            }
+        } else {
+            for (size_t i = 0; i < position.count; ++i) {
+                glm::vec3 value(0.0f);
+                readComponents(position, i, &value.x);
+                aabbMin = glm::min(aabbMin, value);
+                aabbMax = glm::max(aabbMax, value);
+            }
+        }
+        return position.count > 0 ? makeBounds(aabbMin, aabbMax) : MeshBounds{};
+    }
+
+    void buildMesh(const Document& document, const JsonValue& json, const GltfModel& model, GltfMesh& mesh) {
+        mesh.name = json["name"].asString();
+        const JsonValue& primitives = json["primitives"];
+        std::vector<VertexSet> sets;
+        std::vector<Primitive> inputs;
+        for (size_t p = 0; p < primitives.size(); ++p) {
+            const JsonValue& primitive = primitives[p];
+            if (primitive["mode"].asNumber(kModeTriangles) != kModeTriangles) {
+                std::cerr << "Warning: skipping a non-triangle primitive of mesh \"" << mesh.name << "\" in "
+                          << document.filename << std::endl;
+                continue;
+            }
+            if (primitive["extensions"].has("KHR_draco_mesh_compression")) {
+                fail(document, "Draco-compressed primitives are not supported");
+            }
+            const JsonValue& attributes = primitive["attributes"];
+            const std::array<int, 4> key = {getIndex(attributes["POSITION"]), getIndex(attributes["NORMAL"]),
+                                            getIndex(attributes["TEXCOORD_0"]), getIndex(attributes["COLOR_0"])};
+            if (key[0] < 0) {
+                fail(document, "primitive without positions in mesh \"" + mesh.name + "\"");
+            }
+            auto found = std::find_if(sets.begin(), sets.end(), [&](const VertexSet& set) { return set.key == key; });
+            if (found == sets.end()) {
+                VertexSet set;
+                set.key = key;
+                set.position = getAccessor(document, key[0]);
+                Accessor* attributes[] = {&set.position, &set.normal, &set.texCoord, &set.color};
+                for (size_t a = 1; a < 4; ++a) {
+                    if (key[a] >= 0) {
+                        *attributes[a] = getAccessor(document, key[a]);
+                    }
+                }
+                for (const Accessor* attribute : {&set.normal, &set.texCoord, &set.color}) {
+                    if (attribute->json && attribute->count != set.position.count) {
+                        fail(document, "attribute count mismatch in mesh \"" + mesh.name + "\"");
+                    }
+                }
+                sets.push_back(set);
+                found = sets.end() - 1;
+            }
+
+            Primitive input = {};
+            input.set = static_cast<size_t>(found - sets.begin());
+            const int indices = getIndex(primitive["indices"]);
+            if (indices >= 0) {
+                input.indices = getAccessor(document, indices);
+                const int type = input.indices.componentType;
+                if (input.indices.componentCount != 1 ||
+                    (type != kUnsignedByte && type != kUnsignedShort && type != kUnsignedInt)) {
+                    fail(document, "invalid index accessor " + std::to_string(indices));
+                }
+            }
+            const int material = getIndex(primitive["material"]);
+            input.materialIndex = material >= 0 && static_cast<size_t>(material) < model.materials.size()
+                                      ? static_cast<uint32_t>(material)
+                                      : kNoMaterial;
+            inputs.push_back(input);
+        }
+
+        // Vertices are used in place when every set is in the Vertex layout inside one buffer view; each set
+        // then starts at its own base vertex
+        mesh.zeroCopyVertices = !sets.empty();
+        const uint8_t* vertexBase = nullptr;
+        for (const VertexSet& set : sets) {
+            mesh.zeroCopyVertices = mesh.zeroCopyVertices && matchesVertexLayout(set) &&
+                                    set.position.bufferView == sets[0].position.bufferView;
+            vertexBase = vertexBase ? std::min(vertexBase, set.position.data) : set.position.data;
+        }
+        for (const VertexSet& set : sets) {
+            mesh.zeroCopyVertices = mesh.zeroCopyVertices && (set.position.data - vertexBase) % sizeof(Vertex) == 0;
+        }
+        size_t vertexCount = 0;
+        for (VertexSet& set : sets) {
+            if (mesh.zeroCopyVertices) {
+                set.baseVertex = static_cast<uint32_t>((set.position.data - vertexBase) / sizeof(Vertex));
+                vertexCount = std::max(vertexCount, set.baseVertex + set.position.count);
+                continue;
+            }
+            set.baseVertex = static_cast<uint32_t>(mesh.vertices.size());
+            mesh.vertices.resize(mesh.vertices.size() + set.position.count);
+            Vertex* out = mesh.vertices.data() + set.baseVertex;
+            if (matchesVertexLayout(set)) {
+                memcpy(out, set.position.data, set.position.count * sizeof(Vertex));
+            } else {
+                convertVertices(set, out);
+            }
+            vertexCount = mesh.vertices.size();
+        }
+        if (vertexCount > UINT32_MAX) {
+            fail(document, "too many vertices in mesh \"" + mesh.name + "\"");
+        }
+
+        // Indices likewise when they share one buffer view and are all 16 or all 32 bits; indices are
+        // range-checked either way, since the GPU and the ray tracing builds trust them
+        const int indexType = inputs.empty() ? 0 : inputs[0].indices.componentType;
+        mesh.zeroCopyIndices = indexType == kUnsignedShort || indexType == kUnsignedInt;
+        const uint8_t* indexBase = nullptr;
+        bool needs32 = false;
+        for (const Primitive& input : inputs) {
+            const Accessor& indices = input.indices;
+            const size_t setVertexCount = sets[input.set].position.count;
+            const size_t count = indices.json ? indices.count : setVertexCount;
+            if (count % 3 != 0) {
+                fail(document, "primitive index count is not a multiple of 3 in mesh \"" + mesh.name + "\"");
+            }
+            if (!indices.json) {
+                mesh.zeroCopyIndices = false;
+                needs32 = needs32 || setVertexCount > 65536;
+                continue;
+            }
+            const uint32_t maxIndex = indices.componentType == kUnsignedInt
+                                          ? findMaxIndex<uint32_t>(indices.data, indices.count, indices.stride)
+                                          : indices.componentType == kUnsignedShort
+                                          ? findMaxIndex<uint16_t>(indices.data, indices.count, indices.stride)
+                                          : findMaxIndex<uint8_t>(indices.data, indices.count, indices.stride);
+            if (indices.count > 0 && maxIndex >= setVertexCount) {
+                fail(document, "index out of range in mesh \"" + mesh.name + "\"");
+            }
+            needs32 = needs32 || maxIndex > 0xFFFF;
+            const size_t size = getComponentSize(indices.componentType);
+            mesh.zeroCopyIndices = mesh.zeroCopyIndices && indices.componentType == indexType &&
+                                   indices.stride == size && indices.bufferView == inputs[0].indices.bufferView;
+            indexBase = indexBase ? std::min(indexBase, indices.data) : indices.data;
+        }
+        const uint32_t indexSize = mesh.zeroCopyIndices ? static_cast<uint32_t>(getComponentSize(indexType))
+                                 : needs32 ? 4 : 2;
+        for (const Primitive& input : inputs) {
+            mesh.zeroCopyIndices = mesh.zeroCopyIndices && (input.indices.data - indexBase) % indexSize == 0;
+        }
+
+        size_t indexCount = 0;
+        glm::vec3 aabbMin(FLT_MAX);
+        glm::vec3 aabbMax(-FLT_MAX);
+        for (const Primitive& input : inputs) {
+            const VertexSet& set = sets[input.set];
+            const Accessor& indices = input.indices;
+            Submesh submesh = {};
+            submesh.indexCount = static_cast<uint32_t>(indices.json ? indices.count : set.position.count);
+            submesh.materialIndex = input.materialIndex;
+            submesh.baseVertex = set.baseVertex;
+            submesh.bounds = getPositionBounds(set.position);
+            if (mesh.zeroCopyIndices) {
+                submesh.indexOffset = static_cast<uint32_t>((indices.data - indexBase) / indexSize);
+                indexCount = std::max<size_t>(indexCount, submesh.indexOffset + submesh.indexCount);
+            } else {
+                submesh.indexOffset = static_cast<uint32_t>(indexCount);
+                indexCount += submesh.indexCount;
+                mesh.indices.resize(indexCount * indexSize);
+                uint8_t* out = mesh.indices.data() + submesh.indexOffset * indexSize;
+                for (size_t i = 0; i < submesh.indexCount; ++i) {
+                    const uint32_t index = indices.json ? readIndex(indices, i) : static_cast<uint32_t>(i);
+                    if (indexSize == 2) {
+                        const uint16_t shortIndex = static_cast<uint16_t>(index);
+                        memcpy(out + i * 2, &shortIndex, sizeof(shortIndex));
+                    } else {
+                        memcpy(out + i * 4, &index, sizeof(index));
+                    }
+                }
+            }
+            if (set.position.count > 0) {
+                aabbMin = glm::min(aabbMin, submesh.bounds.aabbMin);
+                aabbMax = glm::max(aabbMax, submesh.bounds.aabbMax);
+            }
+            mesh.submeshes.push_back(submesh);
+        }
+        if (indexCount > UINT32_MAX) {
+            fail(document, "too many indices in mesh \"" + mesh.name + "\"");
+        }
+
+        // glTF asks for flat normals when a primitive has none; converted vertices may be shared by several
+        // triangles, so they get the area-weighted average of their faces instead
+        for (const Primitive& input : inputs) {
+            const VertexSet& set = sets[input.set];
+            if (set.normal.json) {
+                continue;
+            }
+            Vertex* vertices = mesh.vertices.data() + set.baseVertex;
+            const Submesh& submesh = mesh.submeshes[&input - inputs.data()];
+            for (size_t i = 0; i < submesh.indexCount; i += 3) {
+                uint32_t corners[3];
+                for (size_t k = 0; k < 3; ++k) {
+                    corners[k] = input.indices.json ? readIndex(input.indices, i + k) : static_cast<uint32_t>(i + k);
+                }
+                const glm::vec3 faceNormal = glm::cross(vertices[corners[1]].position - vertices[corners[0]].position,
+                                                        vertices[corners[2]].position - vertices[corners[0]].position);
+                for (uint32_t corner : corners) {
+                    vertices[corner].normal += faceNormal;
+                }
+            }
+        }
+        for (const VertexSet& set : sets) {
+            if (set.normal.json) {
+                continue;
+            }
+            for (size_t i = 0; i < set.position.count; ++i) {
+                glm::vec3& normal = mesh.vertices[set.baseVertex + i].normal;
+                const float length = glm::length(normal);
+                normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+            }
+        }
+
+        MeshView& view = mesh.view;
+        view.vertices = mesh.zeroCopyVertices ? static_cast<const void*>(vertexBase) : mesh.vertices.data();
+        view.vertexCount = vertexCount;
+        view.indices = mesh.zeroCopyIndices ? static_cast<const void*>(indexBase) : mesh.indices.data();
+        view.indexCount = indexCount;
+        view.indexSize = indexSize;
+        view.submeshes = mesh.submeshes.data();
+        view.submeshCount = mesh.submeshes.size();
+        view.materials = model.materials.data();
+        view.materialCount = model.materials.size();
+        view.materialStrings = model.materialStrings.data();
+        view.materialStringsSize = model.materialStrings.size();
+        view.bounds = mesh.submeshes.empty() ? MeshBounds{} : makeBounds(aabbMin, aabbMax);
+    }
+
+    // Path of an image file relative to the working directory, as for OBJ textures; empty for embedded ones
+    std::string getImagePath(const Document& document, int image) {
+        const std::string& uri = document.json["images"][static_cast<size_t>(image)]["uri"].asString();
+        if (image < 0 || uri.empty() || uri.compare(0, 5, "data:") == 0) {
+            return {};
+        }
+        return (document.directory / decodeUri(uri)).generic_string();
+    }
+
+    void buildMaterials(const Document& document, GltfModel& model) {
+        model.materialStrings.assign(1, '\0');
+        auto addString = [&](const std::string& value) {
+            if (value.empty()) {
+                return uint32_t(0);
+            }
+            uint32_t offset = static_cast<uint32_t>(model.materialStrings.size());
+            model.materialStrings.insert(model.materialStrings.end(), value.begin(), value.end());
+            model.materialStrings.push_back('\0');
+            return offset;
+        };
+        auto texturePath = [&](const JsonValue& textureInfo) {
+            const int texture = getIndex(textureInfo["index"]);
+            return getImagePath(document, getIndex(document.json["textures"][static_cast<size_t>(texture)]["source"]));
+        };
+
+        const JsonValue& materials = document.json["materials"];
+        for (size_t i = 0; i < materials.size(); ++i) {
+            const JsonValue& material = materials[i];
+            const JsonValue& pbr = material["pbrMetallicRoughness"];
+            glm::vec4 baseColor(1.0f);
+            for (size_t c = 0; c < 4 && c < pbr["baseColorFactor"].size(); ++c) {
+                baseColor[c] = static_cast<float>(pbr["baseColorFactor"][c].asNumber(1.0));
+            }
+            glm::vec3 emissive(0.0f);
+            for (size_t c = 0; c < 3 && c < material["emissiveFactor"].size(); ++c) {
+                emissive[c] = static_cast<float>(material["emissiveFactor"][c].asNumber());
+            }
+            emissive *= static_cast<float>(
+                material["extensions"]["KHR_materials_emissive_strength"]["emissiveStrength"].asNumber(1.0));
+            // Metal/roughness mapped onto the Phong terms the renderer uses: dielectrics reflect 4% and
+            // metals their base color, and the exponent follows from the GGX alpha (roughness squared)
+            const float metallic = static_cast<float>(pbr["metallicFactor"].asNumber(1.0));
+            const float roughness = static_cast<float>(pbr["roughnessFactor"].asNumber(1.0));
+            const float alpha = std::max(roughness * roughness, 1e-3f);
+
+            MeshMaterial meshMaterial = {};
+            meshMaterial.diffuseColor = baseColor;
+            meshMaterial.specularColor = glm::vec4(glm::mix(glm::vec3(0.04f), glm::vec3(baseColor), metallic), 0.0f);
+            meshMaterial.emissiveColor = emissive;
+            meshMaterial.specularPower = std::max(2.0f / (alpha * alpha) - 2.0f, 1.0f);
+            meshMaterial.nameOffset = addString(material["name"].asString());
+            meshMaterial.diffuseTextureOffset = addString(texturePath(pbr["baseColorTexture"]));
+            meshMaterial.normalTextureOffset = addString(texturePath(material["normalTexture"]));
+            model.materials.push_back(meshMaterial);
+        }
+
+        const JsonValue& images = document.json["images"];
+        for (size_t i = 0; i < images.size(); ++i) {
+            GltfImage image;
+            image.uri = getImagePath(document, static_cast<int>(i));
+            image.mimeType = images[i]["mimeType"].asString();
+            const int bufferView = getIndex(images[i]["bufferView"]);
+            if (bufferView >= 0) {
+                const BufferRange range = getBufferView(document, bufferView);
+                image.data = range.data;
+                image.size = range.size;
+            }
+            model.images.push_back(image);
+        }
+    }
+
+    glm::mat4 getLocalTransform(const JsonValue& node) {
+        const JsonValue& matrix = node["matrix"];
+        if (matrix.size() == 16) {
+            glm::mat4 transform; // Column-major, like glm
+            for (int column = 0; column < 4; ++column) {
+                for (int row = 0; row < 4; ++row) {
+                    transform[column][row] = static_cast<float>(matrix[column * 4 + row].asNumber());
+                }
+            }
+            return transform;
+        }
+        glm::vec3 translation(0.0f);
+        glm::vec3 scale(1.0f);
+        float rotation[4] = {0.0f, 0.0f, 0.0f, 1.0f}; // x, y, z, w
+        for (size_t c = 0; c < 3; ++c) {
+            translation[c] = static_cast<float>(node["translation"][c].asNumber(0.0));
+            scale[c] = static_cast<float>(node["scale"][c].asNumber(1.0));
+        }
+        for (size_t c = 0; c < 4; ++c) {
+            rotation[c] = static_cast<float>(node["rotation"][c].asNumber(rotation[c]));
+        }
+        const glm::quat orientation(rotation[3], rotation[0], rotation[1], rotation[2]);
+        return glm::translate(glm::mat4(1.0f), translation) * glm::mat4_cast(orientation) *
+               glm::scale(glm::mat4(1.0f), scale);
+    }
+
+    void buildInstances(const Document& document, GltfModel& model) {
+        const JsonValue& nodes = document.json["nodes"];
+        std::vector<int> roots;
+        const JsonValue& scenes = document.json["scenes"];
+        if (scenes.size() > 0) {
+            const int scene = std::max(getIndex(document.json["scene"]), 0);
+            const JsonValue& sceneNodes = scenes[static_cast<size_t>(scene)]["nodes"];
+            for (size_t i = 0; i < sceneNodes.size(); ++i) {
+                roots.push_back(getIndex(sceneNodes[i]));
+            }
+        } else {
+            // Without scenes every node that is nobody's child is a root
+            std::vector<bool> isChild(nodes.size(), false);
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                const JsonValue& children = nodes[i]["children"];
+                for (size_t c = 0; c < children.size(); ++c) {
+                    const int child = getIndex(children[c]);
+                    if (child >= 0 && static_cast<size_t>(child) < nodes.size()) {
+                        isChild[child] = true;
+                    }
+                }
+            }
+            for (size_t i = 0; i < nodes.size(); ++i) {
+                if (!isChild[i]) {
+                    roots.push_back(static_cast<int>(i));
+                }
+            }
+        }
+
+        struct PendingNode {
+            int index;
+            glm::mat4 parentTransform;
+            size_t depth;
+        };
+        std::vector<PendingNode> stack;
+        for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+            stack.push_back({*it, glm::mat4(1.0f), 0});
+        }
+        while (!stack.empty()) {
+            const PendingNode pending = stack.back();
+            stack.pop_back();
+            const JsonValue& node = nodes[static_cast<size_t>(pending.index)];
+            if (pending.index < 0 || !node.isObject() || pending.depth > nodes.size()) {
+                fail(document, "invalid node hierarchy");
+            }
+            const glm::mat4 transform = pending.parentTransform * getLocalTransform(node);
+            const int mesh = getIndex(node["mesh"]);
+            if (mesh >= 0) {
+                if (static_cast<size_t>(mesh) >= model.meshes.size()) {
+                    fail(document, "node " + std::to_string(pending.index) + " references a missing mesh");
+                }
+                model.instances.push_back({static_cast<uint32_t>(mesh), static_cast<uint32_t>(pending.index),
+                                           transform});
+            }
+            const JsonValue& children = node["children"];
+            for (size_t c = children.size(); c-- > 0;) {
+                stack.push_back({getIndex(children[c]), transform, pending.depth + 1});
+            }
+        }
+    }
+
+    void appendJsonString(std::string& out, const std::string& value) {
+        out += '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char escape[8];
+                snprintf(escape, sizeof(escape), "\\u%04x", c);
+                out += escape;
+            } else {
+                out += c;
+            }
+        }
+        out += '"';
+    }
+
+    // Shortest text that reads back as the same float, independent of the locale
+    void appendNumber(std::string& out, float value) {
+        char text[32];
+        const std::to_chars_result result = std::to_chars(text, text + sizeof(text),
+                                                          std::isfinite(value) ? value : 0.0f);
+        out.append(text, result.ptr);
+    }
+
+    void appendNumbers(std::string& out, const float* values, size_t count) {
+        out += '[';
+        for (size_t i = 0; i < count; ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            appendNumber(out, values[i]);
+        }
+        out += ']';
+    }
+}
+
+void loadGltfFile(const std::string& filename, GltfModel& outModel, const VirtualFileSystem* fileSystem) {
+    outModel = GltfModel();
+    VirtualFile file;
+    if (!openFile(fileSystem, filename, file)) {
+        throw std::runtime_error("Failed to open glTF file: " + filename);
+    }
+    Document document;
+    document.filename = filename;
+    document.directory = std::filesystem::path(filename).parent_path();
+
+    // A .glb is a JSON chunk followed by an optional binary chunk; anything else is read as .gltf text
+    const char* jsonText = reinterpret_cast<const char*>(file.data());
+    size_t jsonSize = file.size();
+    BufferRange binaryChunk;
+    if (file.size() >= 12 && read32(file.data()) == kGlbMagic) {
+        const uint32_t length = read32(file.data() + 8);
+        if (read32(file.data() + 4) != kGlbVersion || length > file.size()) {
+            fail(document, "unsupported or truncated GLB header");
+        }
+        jsonText = nullptr;
+        for (size_t offset = 12; offset + 8 <= length;) {
+            const uint32_t chunkLength = read32(file.data() + offset);
+            const uint32_t chunkType = read32(file.data() + offset + 4);
+            offset += 8;
+            if (chunkLength > length - offset) {
+                fail(document, "truncated GLB chunk");
+            }
+            if (!jsonText) {
+                if (chunkType != kGlbChunkJson) {
+                    fail(document, "the first GLB chunk is not JSON");
+                }
+                jsonText = reinterpret_cast<const char*>(file.data() + offset);
+                jsonSize = chunkLength;
+            } else if (chunkType == kGlbChunkBin && !binaryChunk.data) {
+                binaryChunk = {file.data() + offset, chunkLength};
+            }
+            offset += chunkLength; // Unknown chunks are skipped
+        }
+        if (!jsonText) {
+            fail(document, "missing GLB JSON chunk");
+        }
+    }
+    std::string error;
+    if (!parseJson(jsonText, jsonSize, document.json, &error)) {
+        fail(document, error);
+    }
+    outModel.files.push_back(std::move(file));
+
+    const JsonValue& json = document.json;
+    if (json["asset"]["version"].asString().compare(0, 2, "2.") != 0) {
+        fail(document, "not a glTF 2.0 asset");
+    }
+    const JsonValue& required = json["extensionsRequired"];
+    for (size_t i = 0; i < required.size(); ++i) {
+        const std::string& extension = required[i].asString();
+        if (std::none_of(std::begin(kSupportedExtensions), std::end(kSupportedExtensions),
+                         [&](const char* supported) { return extension == supported; })) {
+            fail(document, "required extension " + extension + " is not supported");
+        }
+    }
+
+    // The GLB binary chunk is the first buffer (the one without a uri); other buffers are mapped files
+    const JsonValue& buffers = json["buffers"];
+    for (size_t i = 0; i < buffers.size(); ++i) {
+        const JsonValue& buffer = buffers[i];
+        const size_t byteLength = getSize(document, buffer["byteLength"], SIZE_MAX, "buffer length");
+        BufferRange range;
+        if (!buffer.has("uri")) {
+            if (i != 0 || !binaryChunk.data) {
+                fail(document, "buffer " + std::to_string(i) + " has no data");
+            }
+            range = binaryChunk;
+        } else {
+            const std::string& uri = buffer["uri"].asString();
+            if (uri.compare(0, 5, "data:") == 0) {
+                fail(document, "embedded data URIs are not supported (convert the file to .glb)");
+            }
+            const std::string path = (document.directory / decodeUri(uri)).generic_string();
+            VirtualFile bufferFile;
+            if (!openFile(fileSystem, path, bufferFile)) {
+                throw std::runtime_error("Failed to open glTF buffer: " + path);
+            }
+            range = {bufferFile.data(), bufferFile.size()};
+            outModel.files.push_back(std::move(bufferFile)); // Moving keeps the mapped data where it is
+        }
+        if (range.size < byteLength) {
+            fail(document, "buffer " + std::to_string(i) + " is shorter than its byteLength");
+        }
+        range.size = byteLength;
+        document.buffers.push_back(range);
+    }
+
+    buildMaterials(document, outModel);
+    const JsonValue& meshes = json["meshes"];
+    outModel.meshes.resize(meshes.size()); // Sized up front: the views point into each mesh's own vectors
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        buildMesh(document, meshes[i], outModel, outModel.meshes[i]);
+    }
+    buildInstances(document, outModel);
+}
+
+bool writeGlbFile(const std::string& path, const MeshView& mesh, const std::string& name) {
+    if (!(mesh.vertexFormat == VertexFormat{}) || !mesh.vertices || !mesh.indices || mesh.vertexCount == 0 ||
+        (mesh.indexSize != 2 && mesh.indexSize != 4)) {
+        return false;
+    }
+    const Vertex* vertices = static_cast<const Vertex*>(mesh.vertices);
+    const size_t vertexBytes = mesh.vertexCount * sizeof(Vertex);
+    const size_t indexBytes = mesh.indexCount * mesh.indexSize;
+    std::vector<Submesh> submeshes(mesh.submeshes, mesh.submeshes + mesh.submeshCount);
+    if (submeshes.empty()) {
+        Submesh submesh = {};
+        submesh.indexCount = static_cast<uint32_t>(mesh.indexCount);
+        submesh.materialIndex = kNoMaterial;
+        submeshes.push_back(submesh);
+    }
+    auto getString = [&](uint32_t offset) {
+        return std::string(offset < mesh.materialStringsSize ? mesh.materialStrings + offset : "");
+    };
+
+    // Both streams go into one buffer: the interleaved vertices (one view, stride sizeof(Vertex)), then the
+    // indices. Submeshes with the same base vertex share their attribute accessors.
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"DirectX12Learning\"},\"scene\":0,"
+                       "\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0,\"name\":";
+    appendJsonString(json, name);
+    json += "}],\"buffers\":[{\"byteLength\":" + std::to_string(vertexBytes + indexBytes) + "}],";
+    json += "\"bufferViews\":[{\"buffer\":0,\"byteLength\":" + std::to_string(vertexBytes) +
+            ",\"byteStride\":" + std::to_string(sizeof(Vertex)) + ",\"target\":" + std::to_string(kTargetArrayBuffer) +
+            "},{\"buffer\":0,\"byteOffset\":" + std::to_string(vertexBytes) + ",\"byteLength\":" +
+            std::to_string(indexBytes) + ",\"target\":" + std::to_string(kTargetElementArrayBuffer) + "}],";
+
+    std::string accessors;
+    std::string primitives;
+    std::vector<uint32_t> baseVertices;
+    std::vector<size_t> baseAccessors; // First of the four attribute accessors of each base vertex
+    size_t accessorCount = 0;
+    for (const Submesh& submesh : submeshes) {
+        if (submesh.baseVertex >= mesh.vertexCount ||
+            submesh.indexOffset + size_t(submesh.indexCount) > mesh.indexCount) {
+            return false;
+        }
+        size_t base = std::find(baseVertices.begin(), baseVertices.end(), submesh.baseVertex) - baseVertices.begin();
+        if (base == baseVertices.size()) {
+            baseVertices.push_back(submesh.baseVertex);
+            baseAccessors.push_back(accessorCount);
+            const size_t count = mesh.vertexCount - submesh.baseVertex;
+            glm::vec3 aabbMin(FLT_MAX);
+            glm::vec3 aabbMax(-FLT_MAX);
+            for (size_t i = submesh.baseVertex; i < mesh.vertexCount; ++i) {
+                aabbMin = glm::min(aabbMin, vertices[i].position);
+                aabbMax = glm::max(aabbMax, vertices[i].position);
+            }
+            struct Attribute {
+                size_t offset;
+                const char* type;
+            };
+            const Attribute attributes[] = {{offsetof(Vertex, position), "VEC3"}, {offsetof(Vertex, normal), "VEC3"},
+                                            {offsetof(Vertex, texCoord), "VEC2"}, {offsetof(Vertex, color), "VEC4"}};
+            for (const Attribute& attribute : attributes) {
+                accessors += accessors.empty() ? "" : ",";
+                accessors += "{\"bufferView\":0,\"byteOffset\":" +
+                             std::to_string(submesh.baseVertex * sizeof(Vertex) + attribute.offset) +
+                             ",\"componentType\":" + std::to_string(kFloat) + ",\"count\":" + std::to_string(count) +
+                             ",\"type\":\"" + attribute.type + "\"";
+                if (attribute.offset == offsetof(Vertex, position)) {
+                    accessors += ",\"min\":";
+                    appendNumbers(accessors, &aabbMin.x, 3);
+                    accessors += ",\"max\":";
+                    appendNumbers(accessors, &aabbMax.x, 3);
+                }
+                accessors += "}";
+            }
+            accessorCount += 4;
+        }
+        const size_t attributeAccessor = baseAccessors[base];
+        accessors += ",{\"bufferView\":1,\"byteOffset\":" + std::to_string(submesh.indexOffset * mesh.indexSize) +
+                     ",\"componentType\":" + std::to_string(mesh.indexSize == 2 ? kUnsignedShort : kUnsignedInt) +
+                     ",\"count\":" + std::to_string(submesh.indexCount) + ",\"type\":\"SCALAR\"}";
+        primitives += primitives.empty() ? "{" : ",{";
+        primitives += "\"attributes\":{\"POSITION\":" + std::to_string(attributeAccessor) +
+                      ",\"NORMAL\":" + std::to_string(attributeAccessor + 1) +
+                      ",\"TEXCOORD_0\":" + std::to_string(attributeAccessor + 2) +
+                      ",\"COLOR_0\":" + std::to_string(attributeAccessor + 3) +
+                      "},\"indices\":" + std::to_string(accessorCount++);
+        if (submesh.materialIndex < mesh.materialCount) {
+            primitives += ",\"material\":" + std::to_string(submesh.materialIndex);
+        }
+        primitives += "}";
+    }
+    json += "\"accessors\":[" + accessors + "],\"meshes\":[{\"name\":";
+    appendJsonString(json, name);
+    json += ",\"primitives\":[" + primitives + "]}]";
+
+    // Texture paths become URIs relative to the written file
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    std::vector<std::string> images;
+    auto addImage = [&](uint32_t offset) {
+        const std::string texture = getString(offset);
+        if (texture.empty()) {
+            return -1;
+        }
+        std::error_code ec;
+        const std::filesystem::path relative = std::filesystem::absolute(texture, ec).lexically_relative(
+            std::filesystem::absolute(directory, ec));
+        const std::string uri = encodeUri(relative.empty() ? texture : relative.generic_string());
+        auto found = std::find(images.begin(), images.end(), uri);
+        if (found == images.end()) {
+            images.push_back(uri);
+            found = images.end() - 1;
+        }
+        return static_cast<int>(found - images.begin());
+    };
+    if (mesh.materialCount > 0) {
+        json += ",\"materials\":[";
+        for (size_t i = 0; i < mesh.materialCount; ++i) {
+            const MeshMaterial& material = mesh.materials[i];
+            // Phong back to metal/roughness: the inverse of the import mapping, as a dielectric
+            const float alpha = std::sqrt(2.0f / (std::max(material.specularPower, 0.0f) + 2.0f));
+            const float roughness = std::min(std::sqrt(alpha), 1.0f);
+            json += i > 0 ? ",{\"name\":" : "{\"name\":";
+            appendJsonString(json, getString(material.nameOffset));
+            json += ",\"pbrMetallicRoughness\":{\"baseColorFactor\":";
+            appendNumbers(json, &material.diffuseColor.x, 4);
+            json += ",\"metallicFactor\":0,\"roughnessFactor\":";
+            appendNumber(json, roughness);
+            const int diffuse = addImage(material.diffuseTextureOffset);
+            if (diffuse >= 0) {
+                json += ",\"baseColorTexture\":{\"index\":" + std::to_string(diffuse) + "}";
+            }
+            json += "},\"emissiveFactor\":";
+            const glm::vec3 emissive = glm::clamp(material.emissiveColor, 0.0f, 1.0f);
+            appendNumbers(json, &emissive.x, 3);
+            const int normal = addImage(material.normalTextureOffset);
+            if (normal >= 0) {
+                json += ",\"normalTexture\":{\"index\":" + std::to_string(normal) + "}";
+            }
+            json += material.diffuseColor.a < 1.0f ? ",\"alphaMode\":\"BLEND\"}" : "}";
+        }
+        json += "]";
+    }
+    if (!images.empty()) {
+        std::string textures;
+        std::string imageList;
+        for (size_t i = 0; i < images.size(); ++i) {
+            textures += (i > 0 ? ",{\"source\":" : "{\"source\":") + std::to_string(i) + "}";
+            imageList += i > 0 ? ",{\"uri\":" : "{\"uri\":";
+            appendJsonString(imageList, images[i]);
+            imageList += "}";
+        }
+        json += ",\"textures\":[" + textures + "],\"images\":[" + imageList + "]";
+    }
+    json += "}";
+
+    // Chunks are padded to 4 bytes: JSON with spaces, binary data with zeros
+    json.resize((json.size() + 3) & ~size_t(3), ' ');
+    const size_t binarySize = (vertexBytes + indexBytes + 3) & ~size_t(3);
+    const uint64_t totalSize = 12 + 8 + json.size() + 8 + binarySize;
+    if (totalSize > UINT32_MAX) {
+        return false;
+    }
+    const uint32_t header[5] = {kGlbMagic, kGlbVersion, static_cast<uint32_t>(totalSize),
+                                static_cast<uint32_t>(json.size()), kGlbChunkJson};
+    const uint32_t binaryHeader[2] = {static_cast<uint32_t>(binarySize), kGlbChunkBin};
+    static const uint8_t zeros[4] = {};
+
+    const std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+              fwrite(json.data(), 1, json.size(), file) == json.size() &&
+              fwrite(binaryHeader, sizeof(binaryHeader), 1, file) == 1 &&
+              fwrite(mesh.vertices, 1, vertexBytes, file) == vertexBytes &&
+              (indexBytes == 0 || fwrite(mesh.indices, 1, indexBytes, file) == indexBytes) &&
+              fwrite(zeros, 1, binarySize - vertexBytes - indexBytes, file) == binarySize - vertexBytes - indexBytes;
+    ok = (fclose(file) == 0) && ok;
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tempPath, path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(tempPath, ec);
+    }
+    return ok;
+}
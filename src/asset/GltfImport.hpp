@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MeshData.hpp"
+#include "VirtualFileSystem.hpp"
+#include "glm/glm.hpp"
+
+// glTF 2.0 import (.glb, or .gltf with external .bin buffers). The files stay mapped and each mesh is exposed as
+// a MeshView: when its vertices are already interleaved in the Vertex layout, and its indices are 16 or 32
+// bits, the view points straight into the binary buffer and nothing is repacked. Other layouts are converted
+// per vertex. Every triangle primitive of a mesh becomes a submesh with its own material.
+
+// One placement of a mesh in the scene: the world matrix of a node referencing it
+struct GltfInstance {
+    uint32_t meshIndex;
+    uint32_t nodeIndex;
+    glm::mat4 transform;
+};
+
+// An image referenced by the materials: an external file (uri, relative to the glTF file) or bytes embedded
+// in a buffer (data/size, with mimeType)
+struct GltfImage {
+    std::string uri;
+    std::string mimeType;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+struct GltfMesh {
+    std::string name;
+    MeshView view; // Submeshes, materials and bounds included; always the Vertex layout
+    bool zeroCopyVertices = false; // view.vertices points into a mapped buffer
+    bool zeroCopyIndices = false; // view.indices points into a mapped buffer
+    std::vector<Vertex> vertices; // Converted vertices, unless zeroCopyVertices
+    std::vector<uint8_t> indices; // Copied or widened indices, unless zeroCopyIndices
+    std::vector<Submesh> submeshes;
+};
+
+struct GltfModel {
+    std::vector<VirtualFile> files; // The .glb/.gltf itself, then the external buffer files; views point into them
+    std::vector<GltfMesh> meshes;
+    std::vector<GltfInstance> instances; // Nodes of the default scene that have a mesh, in depth-first order
+    std::vector<MeshMaterial> materials; // Shared by every mesh; texture paths are relative to the glTF file
+    std::vector<char> materialStrings;
+    std::vector<GltfImage> images;
+};
+
+// Loads a glTF file through the file system (loose files when null). Throws std::runtime_error if the file
+// is missing or malformed, or needs an unsupported extension (e.g. Draco or meshopt compression).
+void loadGltfFile(const std::string& filename, GltfModel& outModel, const VirtualFileSystem* fileSystem = nullptr);
+
+// Writes a mesh in the Vertex layout (uncompressed streams) as a .glb that loads without any repacking:
+// one interleaved vertex buffer view, one primitive per submesh, and one node. LODs and meshlets are not
+// stored. Returns false if the mesh uses another layout or the file cannot be written.
+bool writeGlbFile(const std::string& path, const MeshView& mesh, const std::string& name);
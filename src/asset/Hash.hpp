@@ -0,0 +1,11 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 64-bit xxHash (XXH64) of a byte range. Fast, non-cryptographic, stable across platforms.
+uint64_t hash64(const void* data, size_t size, uint64_t seed = 0);
+
+// Mixes a value into an existing hash (used to build keys out of several fields)
+inline uint64_t hashCombine(uint64_t seed, uint64_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
+}
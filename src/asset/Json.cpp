@@ -0,0 +1,304 @@
+#include "Json.hpp"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+    const JsonValue kNullValue;
+
+    constexpr int kMaxDepth = 128; // Nesting limit, so hostile input cannot overflow the stack
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    return m_type == Type::Array && index < m_elements.size() ? m_elements[index] : kNullValue;
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const {
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        if (m_keys[i] == key) {
+            return m_elements[i];
+        }
+    }
+    return kNullValue;
+}
+
+bool JsonValue::has(const char* key) const {
+    return &(*this)[key] != &kNullValue;
+}
+
+// Recursive descent over the whole text; stops at the first error
+class JsonParser {
+public:
+    JsonParser(const char* text, size_t size) : m_current(text), m_begin(text), m_end(text + size) {
+    }
+
+    bool parseDocument(JsonValue& outValue) {
+        if (!parseValue(outValue, 0)) {
+            return false;
+        }
+        skipWhitespace();
+        return m_current == m_end || fail("unexpected data after the document");
+    }
+
+    std::string getError() const {
+        return m_error + " at offset " + std::to_string(m_errorOffset);
+    }
+
+private:
+    bool fail(const char* message) {
+        if (m_error.empty()) {
+            m_error = message;
+            m_errorOffset = static_cast<size_t>(m_current - m_begin);
+        }
+        return false;
+    }
+
+    void skipWhitespace() {
+        while (m_current < m_end && (*m_current == ' ' || *m_current == '\t' || *m_current == '\n' ||
+                                     *m_current == '\r')) {
+            ++m_current;
+        }
+    }
+
+    bool consume(const char* literal) {
+        const size_t length = strlen(literal);
+        if (size_t(m_end - m_current) < length || memcmp(m_current, literal, length) != 0) {
+            return false;
+        }
+        m_current += length;
+        return true;
+    }
+
+    bool parseValue(JsonValue& value, int depth) {
+        if (depth > kMaxDepth) {
+            return fail("nested too deeply");
+        }
+        skipWhitespace();
+        if (m_current == m_end) {
+            return fail("unexpected end of text");
+        }
+        switch (*m_current) {
+            case '{':
+                return parseObject(value, depth);
+            case '[':
+                return parseArray(value, depth);
+            case '"':
+                value.m_type = JsonValue::Type::String;
+                return parseString(value.m_string);
+            case 't':
+            case 'f':
+                value.m_type = JsonValue::Type::Bool;
+                value.m_bool = *m_current == 't';
+                return consume(value.m_bool ? "true" : "false") || fail("invalid literal");
+            case 'n':
+                return consume("null") || fail("invalid literal");
+            default:
+                return parseNumber(value);
+        }
+    }
+
+    bool parseObject(JsonValue& value, int depth) {
+        value.m_type = JsonValue::Type::Object;
+        ++m_current;
+        skipWhitespace();
+        if (m_current < m_end && *m_current == '}') {
+            ++m_current;
+            return true;
+        }
+        while (true) {
+            skipWhitespace();
+            if (m_current == m_end || *m_current != '"') {
+                return fail("expected a member name");
+            }
+            value.m_keys.emplace_back();
+            if (!parseString(value.m_keys.back())) {
+                return false;
+            }
+            skipWhitespace();
+            if (m_current == m_end || *m_current++ != ':') {
+                return fail("expected ':'");
+            }
+            value.m_elements.emplace_back();
+            if (!parseValue(value.m_elements.back(), depth + 1)) {
+                return false;
+            }
+            skipWhitespace();
+            if (m_current == m_end) {
+                return fail("unterminated object");
+            }
+            const char next = *m_current++;
+            if (next == '}') {
+                return true;
+            }
+            if (next != ',') {
+                return fail("expected ',' or '}'");
+            }
+        }
+    }
+
+    bool parseArray(JsonValue& value, int depth) {
+        value.m_type = JsonValue::Type::Array;
+        ++m_current;
+        skipWhitespace();
+        if (m_current < m_end && *m_current == ']') {
+            ++m_current;
+            return true;
+        }
+        while (true) {
+            value.m_elements.emplace_back();
+            if (!parseValue(value.m_elements.back(), depth + 1)) {
+                return false;
+            }
+            skipWhitespace();
+            if (m_current == m_end) {
+                return fail("unterminated array");
+            }
+            const char next = *m_current++;
+            if (next == ']') {
+                return true;
+            }
+            if (next != ',') {
+                return fail("expected ',' or ']'");
+            }
+        }
+    }
+
+    bool parseHex4(uint32_t& outCode) {
+        if (m_end - m_current < 4) {
+            return false;
+        }
+        outCode = 0;
+        for (int i = 0; i < 4; ++i) {
+            const char c = *m_current++;
+            const uint32_t digit = c >= '0' && c <= '9' ? c - '0'
+                                 : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                                 : c >= 'A' && c <= 'F' ? c - 'A' + 10
+                                 : 16;
+            if (digit == 16) {
+                return false;
+            }
+            outCode = outCode * 16 + digit;
+        }
+        return true;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t code) {
+        if (code < 0x80) {
+            out += static_cast<char>(code);
+        } else if (code < 0x800) {
+            out += static_cast<char>(0xC0 | (code >> 6));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            out += static_cast<char>(0xE0 | (code >> 12));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (code >> 18));
+            out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (code & 0x3F));
+        }
+    }
+
+    bool parseString(std::string& out) {
+        ++m_current; // Opening quote
+        while (true) {
+            // Runs without escapes are copied in one go
+            const char* run = m_current;
+            while (m_current < m_end && *m_current != '"' && *m_current != '\\' &&
+                   static_cast<unsigned char>(*m_current) >= 0x20) {
+                ++m_current;
+            }
+            out.append(run, m_current);
+            if (m_current == m_end) {
+                return fail("unterminated string");
+            }
+            const char c = *m_current++;
+            if (c == '"') {
+                return true;
+            }
+            if (c != '\\') {
+                --m_current;
+                return fail("control character in string");
+            }
+            if (m_current == m_end) {
+                return fail("unterminated string");
+            }
+            const char escape = *m_current++;
+            switch (escape) {
+                case '"':
+                case '\\':
+                case '/':
+                    out += escape;
+                    break;
+                case 'b':
+                    out += '\b';
+                    break;
+                case 'f':
+                    out += '\f';
+                    break;
+                case 'n':
+                    out += '\n';
+                    break;
+                case 'r':
+                    out += '\r';
+                    break;
+                case 't':
+                    out += '\t';
+                    break;
+                case 'u': {
+                    uint32_t code;
+                    if (!parseHex4(code)) {
+                        return fail("invalid \\u escape");
+                    }
+                    // A surrogate pair encodes one code point above U+FFFF; a lone low surrogate becomes U+FFFD
+                    if (code >= 0xD800 && code < 0xDC00) {
+                        uint32_t low;
+                        if (consume("\\u") && parseHex4(low) && low >= 0xDC00 && low < 0xE000) {
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        } else {
+                            return fail("invalid surrogate pair");
+                        }
+                    } else if (code >= 0xDC00 && code < 0xE000) {
+                        code = 0xFFFD;
+                    }
+                    appendUtf8(out, code);
+                    break;
+                }
+                default:
+                    return fail("invalid escape");
+            }
+        }
+    }
+
+    bool parseNumber(JsonValue& value) {
+        // from_chars takes no leading '+' (neither does JSON) and is locale independent, unlike strtod
+        const std::from_chars_result result = std::from_chars(m_current, m_end, value.m_number);
+        if (result.ec != std::errc() || result.ptr == m_current) {
+            return fail("invalid value");
+        }
+        value.m_type = JsonValue::Type::Number;
+        m_current = result.ptr;
+        return true;
+    }
+
+    const char* m_current;
+    const char* m_begin;
+    const char* m_end;
+    std::string m_error;
+    size_t m_errorOffset = 0;
+};
+
+bool parseJson(const char* text, size_t size, JsonValue& outValue, std::string* error) {
+    outValue = JsonValue();
+    JsonParser parser(text, size);
+    if (!parser.parseDocument(outValue)) {
+        if (error) {
+            *error = parser.getError();
+        }
+        outValue = JsonValue();
+        return false;
+    }
+    return true;
+}
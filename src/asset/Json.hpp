@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Read-only JSON document (e.g. a glTF manifest). Numbers are doubles and object members keep their order.
+// Lookups never fail: a missing member or element is a null value, and the as* accessors return the
+// fallback when the value has another type.
+class JsonValue {
+public:
+    enum class Type {
+        Null,
+        Bool,
+        Number,
+        String,
+        Array,
+        Object
+    };
+
+    Type getType() const {
+        return m_type;
+    }
+
+    bool isNull() const {
+        return m_type == Type::Null;
+    }
+
+    bool isNumber() const {
+        return m_type == Type::Number;
+    }
+
+    bool isString() const {
+        return m_type == Type::String;
+    }
+
+    bool isArray() const {
+        return m_type == Type::Array;
+    }
+
+    bool isObject() const {
+        return m_type == Type::Object;
+    }
+
+    bool asBool(bool fallback = false) const {
+        return m_type == Type::Bool ? m_bool : fallback;
+    }
+
+    double asNumber(double fallback = 0.0) const {
+        return m_type == Type::Number ? m_number : fallback;
+    }
+
+    const std::string& asString() const {
+        return m_string; // Empty unless a string
+    }
+
+    // Elements of an array, or members of an object
+    size_t size() const {
+        return m_elements.size();
+    }
+
+    const JsonValue& operator[](size_t index) const;
+
+    const JsonValue& operator[](const char* key) const;
+
+    bool has(const char* key) const;
+
+    // Name of the index-th member of an object
+    const std::string& getKey(size_t index) const {
+        return m_keys[index];
+    }
+
+private:
+    friend class JsonParser;
+
+    Type m_type = Type::Null;
+    bool m_bool = false;
+    double m_number = 0.0;
+    std::string m_string;
+    std::vector<JsonValue> m_elements; // Array elements or object member values
+    std::vector<std::string> m_keys; // Object member names, parallel to m_elements
+};
+
+// Parses UTF-8 JSON text. Returns false, with a message in error if given, when the text is malformed.
+bool parseJson(const char* text, size_t size, JsonValue& outValue, std::string* error = nullptr);
@@ -0,0 +1,220 @@
+#include "Lz4.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr size_t kMinMatch = 4;
+    constexpr size_t kLastLiterals = 5; // A block always ends with at least this many literals
+    constexpr size_t kMatchStartLimit = 12; // No match may start closer than this to the end of the block
+    constexpr size_t kMaxOffset = 65535;
+    constexpr uint32_t kHashBits = 16;
+
+    inline uint32_t read32(const uint8_t* p) {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t read64(const uint8_t* p) {
+        uint64_t v;
+        memcpy(&v, p, sizeof(v)); // Little-endian hosts only (x64 / ARM64), like hash64
+        return v;
+    }
+
+    inline uint32_t hashSequence(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - kHashBits);
+    }
+
+    // Length of the common prefix of a and b, stopping at limit (a < limit)
+    size_t countMatching(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+        const uint8_t* start = a;
+        while (a + 8 <= limit) {
+            const uint64_t diff = read64(a) ^ read64(b);
+            if (diff != 0) {
+                return size_t(a - start) + std::countr_zero(diff) / 8;
+            }
+            a += 8;
+            b += 8;
+        }
+        while (a < limit && *a == *b) {
+            ++a;
+            ++b;
+        }
+        return size_t(a - start);
+    }
+
+    // Copies in 16-byte chunks up to 15 bytes past dst + size; the caller guarantees both buffers have room.
+    // Chunks are read before they are written, so src may trail dst by 16 bytes or more (a match).
+    inline void wildCopy16(uint8_t* dst, const uint8_t* src, size_t size) {
+        uint8_t* end = dst + size;
+        do {
+            memcpy(dst, src, 16);
+            dst += 16;
+            src += 16;
+        } while (dst < end);
+    }
+
+    // The part of a length that does not fit in its 4-bit token field: 255s, then the remainder
+    bool writeLengthBytes(uint8_t*& op, const uint8_t* opEnd, size_t length) {
+        for (; length >= 255; length -= 255) {
+            if (op == opEnd) {
+                return false;
+            }
+            *op++ = 255;
+        }
+        if (op == opEnd) {
+            return false;
+        }
+        *op++ = static_cast<uint8_t>(length);
+        return true;
+    }
+
+    bool readLengthBytes(const uint8_t*& ip, const uint8_t* ipEnd, size_t& length) {
+        uint8_t value;
+        do {
+            if (ip == ipEnd) {
+                return false;
+            }
+            value = *ip++;
+            length += value;
+        } while (value == 255);
+        return true;
+    }
+
+    // One sequence: literals, then a match of matchLength bytes at offset (none for the last sequence)
+    bool writeSequence(uint8_t*& op, const uint8_t* opEnd, const uint8_t* literals, size_t literalLength,
+                       size_t offset, size_t matchLength) {
+        if (op == opEnd) {
+            return false;
+        }
+        uint8_t* token = op++;
+        *token = static_cast<uint8_t>(std::min<size_t>(literalLength, 15) << 4);
+        if (literalLength >= 15 && !writeLengthBytes(op, opEnd, literalLength - 15)) {
+            return false;
+        }
+        if (literalLength > size_t(opEnd - op)) {
+            return false;
+        }
+        if (literalLength > 0) { // An empty input has no literal pointer to copy from
+            memcpy(op, literals, literalLength);
+        }
+        op += literalLength;
+        if (matchLength == 0) {
+            return true;
+        }
+
+        if (opEnd - op < 2) {
+            return false;
+        }
+        *op++ = static_cast<uint8_t>(offset);
+        *op++ = static_cast<uint8_t>(offset >> 8);
+        const size_t matchCode = matchLength - kMinMatch;
+        *token |= static_cast<uint8_t>(std::min<size_t>(matchCode, 15));
+        return matchCode < 15 || writeLengthBytes(op, opEnd, matchCode - 15);
+    }
+}
+
+size_t lz4Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity) {
+    uint8_t* op = dst;
+    const uint8_t* opEnd = dst + dstCapacity;
+    const uint8_t* anchor = src; // Start of the literals not yet written
+    if (srcSize > kMatchStartLimit) {
+        std::vector<uint32_t> table(size_t(1) << kHashBits, 0); // Last position of each hashed 4-byte sequence
+        const uint8_t* matchStartLimit = src + srcSize - kMatchStartLimit;
+        const uint8_t* matchEndLimit = src + srcSize - kLastLiterals;
+        const uint8_t* ip = src;
+        while (ip <= matchStartLimit) {
+            const uint32_t sequence = read32(ip);
+            uint32_t& slot = table[hashSequence(sequence)];
+            const uint8_t* candidate = src + slot;
+            slot = static_cast<uint32_t>(ip - src);
+            if (candidate >= ip || size_t(ip - candidate) > kMaxOffset || read32(candidate) != sequence) {
+                // Skip faster through data that does not compress
+                ip += 1 + (size_t(ip - anchor) >> 6);
+                continue;
+            }
+
+            while (ip > anchor && candidate > src && ip[-1] == candidate[-1]) {
+                --ip;
+                --candidate;
+            }
+            const uint8_t* matchEnd = ip + kMinMatch;
+            matchEnd += countMatching(matchEnd, candidate + kMinMatch, matchEndLimit);
+            if (!writeSequence(op, opEnd, anchor, size_t(ip - anchor), size_t(ip - candidate),
+                               size_t(matchEnd - ip))) {
+                return 0;
+            }
+            // Positions inside the match are not searched; hashing one near its end helps the next search
+            table[hashSequence(read32(matchEnd - 2))] = static_cast<uint32_t>(matchEnd - 2 - src);
+            ip = matchEnd;
+            anchor = matchEnd;
+        }
+    }
+    if (!writeSequence(op, opEnd, anchor, size_t(src + srcSize - anchor), 0, 0)) {
+        return 0;
+    }
+    return size_t(op - dst);
+}
+
+bool lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize) {
+    const uint8_t* ip = src;
+    const uint8_t* ipEnd = src + srcSize;
+    uint8_t* op = dst;
+    const uint8_t* opEnd = dst + dstSize;
+    while (true) {
+        if (ip == ipEnd) {
+            return false;
+        }
+        const uint8_t token = *ip++;
+        size_t literalLength = token >> 4;
+        if (literalLength == 15 && !readLengthBytes(ip, ipEnd, literalLength)) {
+            return false;
+        }
+        if (literalLength > size_t(ipEnd - ip) || literalLength > size_t(opEnd - op)) {
+            return false;
+        }
+        // Most sequences are short, so away from the ends of the buffers they are copied in whole chunks
+        if (size_t(ipEnd - ip) - literalLength >= 16 && size_t(opEnd - op) - literalLength >= 16) {
+            wildCopy16(op, ip, literalLength);
+        } else {
+            memcpy(op, ip, literalLength);
+        }
+        ip += literalLength;
+        op += literalLength;
+        if (ip == ipEnd) {
+            break; // The last sequence has no match
+        }
+
+        if (ipEnd - ip < 2) {
+            return false;
+        }
+        const size_t offset = size_t(ip[0]) | (size_t(ip[1]) << 8);
+        ip += 2;
+        size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLengthBytes(ip, ipEnd, matchLength)) {
+            return false;
+        }
+        matchLength += kMinMatch;
+        if (offset == 0 || offset > size_t(op - dst) || matchLength > size_t(opEnd - op)) {
+            return false;
+        }
+        const uint8_t* match = op - offset;
+        if (offset >= 16 && size_t(opEnd - op) - matchLength >= 16) {
+            wildCopy16(op, match, matchLength);
+        } else {
+            // An overlapping match repeats the last offset bytes; copying whole periods keeps every memcpy
+            // disjoint and doubles the chunk each time, so long runs cost a few copies instead of a byte loop
+            size_t copied = 0;
+            while (copied < matchLength) {
+                const size_t chunk = std::min(matchLength - copied, copied + offset);
+                memcpy(op + copied, match, chunk);
+                copied += chunk;
+            }
+        }
+        op += matchLength;
+    }
+    return op == opEnd;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// LZ4 block format (no frame): compatible with LZ4_compress_default / LZ4_decompress_safe, so blocks can be
+// inspected with the reference tools. Decoding is a few memcpys per sequence, fast enough that compressed
+// pack entries cost about as much to load as reading them uncompressed.
+
+// Worst-case compressed size of size bytes (incompressible input grows slightly)
+inline size_t lz4CompressBound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+// Greedy single-pass compression. Returns the compressed size, or 0 if it does not fit in dstCapacity
+// (with dstCapacity >= lz4CompressBound(srcSize) it always fits). srcSize must be below 4 GiB.
+size_t lz4Compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+
+// Decodes exactly dstSize bytes. Returns false on malformed input instead of reading or writing out of
+// bounds, so corrupted data is safe to pass in.
+bool lz4Decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstSize);
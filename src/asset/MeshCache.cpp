@@ -0,0 +1,538 @@
+#include "MeshCache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+#include "Hash.hpp"
+#include "MeshCodec.hpp"
+
+namespace {
+    uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    bool isCompressedSection(uint32_t type) {
+        return type >= static_cast<uint32_t>(MeshCacheSectionType::CompressedVertices) &&
+               type <= static_cast<uint32_t>(MeshCacheSectionType::CompressedLodIndices);
+    }
+
+    CompressedStream getCompressedStream(const MeshCacheFile& file, const MeshCacheSection& section) {
+        return {static_cast<const uint8_t*>(file.getSectionData(section)), static_cast<size_t>(section.size)};
+    }
+}
+
+bool querySourceStamp(const std::string& path, SourceStamp& outStamp, bool hashContents) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec) {
+        return false;
+    }
+    auto writeTime = std::filesystem::last_write_time(path, ec);
+    if (ec) {
+        return false;
+    }
+    outStamp.size = size;
+    outStamp.timestamp = static_cast<int64_t>(writeTime.time_since_epoch().count());
+    outStamp.contentHash = 0;
+    if (hashContents) {
+        MappedFile source;
+        if (!source.open(path)) {
+            return false;
+        }
+        outStamp.contentHash = hash64(source.data(), source.size());
+    }
+    return true;
+}
+
+bool sourceMatchesStamp(const std::string& path, uint64_t size, int64_t timestamp, uint64_t contentHash) {
+    SourceStamp stamp;
+    if (!querySourceStamp(path, stamp, false) || stamp.size != size) {
+        return false;
+    }
+    if (stamp.timestamp != timestamp) {
+        // Timestamp changed (copy, checkout, touch) - only trust the stamp if the contents are identical
+        if (!querySourceStamp(path, stamp, true) || stamp.contentHash != contentHash) {
+            return false;
+        }
+    }
+    return true;
+}
+
+MeshCacheFile::MeshCacheFile() {
+}
+
+MeshCacheFile::~MeshCacheFile() {
+}
+
+bool MeshCacheFile::open(const std::string& path, const VirtualFileSystem* fileSystem) {
+    close();
+    if (!openFile(fileSystem, path, m_file)) {
+        return false;
+    }
+    if (m_file.size() < sizeof(MeshCacheHeader)) {
+        close();
+        return false;
+    }
+    const auto* header = reinterpret_cast<const MeshCacheHeader*>(m_file.data());
+    if (header->magic != kMeshCacheMagic || header->version != kMeshCacheVersion) {
+        close();
+        return false;
+    }
+    uint64_t tableEnd = sizeof(MeshCacheHeader) + uint64_t(header->sectionCount) * sizeof(MeshCacheSection);
+    if (tableEnd > m_file.size()) {
+        close();
+        return false;
+    }
+    const auto* sections = reinterpret_cast<const MeshCacheSection*>(m_file.data() + sizeof(MeshCacheHeader));
+    for (uint32_t i = 0; i < header->sectionCount; ++i) {
+        const MeshCacheSection& section = sections[i];
+        if (section.offset % kMeshCacheSectionAlignment != 0 ||
+            section.offset < tableEnd ||
+            section.offset > m_file.size() ||
+            section.size > m_file.size() - section.offset ||
+            (section.size != section.elementCount * section.elementStride && !isCompressedSection(section.type))) {
+            close();
+            return false;
+        }
+    }
+    m_header = header;
+    m_sections = sections;
+    return true;
+}
+
+void MeshCacheFile::close() {
+    m_file.close();
+    m_header = nullptr;
+    m_sections = nullptr;
+}
+
+bool MeshCacheFile::matchesSource(const std::string& sourcePath, uint64_t optionsHash) const {
+    if (!m_header || m_header->optionsHash != optionsHash) {
+        return false;
+    }
+    if (!sourceMatchesStamp(sourcePath, m_header->sourceSize, m_header->sourceTimestamp, m_header->sourceHash)) {
+        return false;
+    }
+    return dependenciesUnchanged();
+}
+
+bool MeshCacheFile::matchesContent(uint64_t sourceHash, uint64_t optionsHash) const {
+    if (!m_header || m_header->optionsHash != optionsHash || m_header->sourceHash != sourceHash) {
+        return false;
+    }
+    return dependenciesUnchanged();
+}
+
+bool MeshCacheFile::dependenciesUnchanged() const {
+    SourceStamp stamp;
+    const MeshCacheSection* dependencies = findSection(MeshCacheSectionType::Dependencies);
+    if (!dependencies) {
+        return true;
+    }
+    const MeshCacheSection* paths = findSection(MeshCacheSectionType::DependencyPaths);
+    if (dependencies->elementStride != sizeof(MeshCacheDependency) || !paths || paths->elementStride != 1 ||
+        paths->elementCount == 0) {
+        return false;
+    }
+    const auto* records = static_cast<const MeshCacheDependency*>(getSectionData(*dependencies));
+    const auto* pathData = static_cast<const char*>(getSectionData(*paths));
+    if (pathData[paths->elementCount - 1] != '\0') {
+        return false;
+    }
+    for (uint64_t i = 0; i < dependencies->elementCount; ++i) {
+        if (records[i].pathOffset >= paths->elementCount ||
+            !querySourceStamp(pathData + records[i].pathOffset, stamp, false) ||
+            stamp.size != records[i].size || stamp.timestamp != records[i].timestamp) {
+            return false;
+        }
+    }
+    return true;
+}
+
+const MeshCacheSection* MeshCacheFile::findSection(MeshCacheSectionType type) const {
+    if (!m_header) {
+        return nullptr;
+    }
+    for (uint32_t i = 0; i < m_header->sectionCount; ++i) {
+        if (m_sections[i].type == static_cast<uint32_t>(type)) {
+            return &m_sections[i];
+        }
+    }
+    return nullptr;
+}
+
+MeshView MeshCacheFile::getView() const {
+    MeshView view;
+    const MeshCacheSection* vertices = findSection(MeshCacheSectionType::Vertices);
+    const MeshCacheSection* indices = findSection(MeshCacheSectionType::Indices);
+    const MeshCacheSection* format = findSection(MeshCacheSectionType::VertexFormat);
+    const MeshCacheSection* positions = findSection(MeshCacheSectionType::Positions);
+    const MeshCacheSection* compressedVertices = findSection(MeshCacheSectionType::CompressedVertices);
+    const MeshCacheSection* compressedPositions = findSection(MeshCacheSectionType::CompressedPositions);
+    const MeshCacheSection* compressedIndices = findSection(MeshCacheSectionType::CompressedIndices);
+    if (!format || format->size < sizeof(MeshCacheVertexFormat)) {
+        return view;
+    }
+    MeshCacheVertexFormat vertexFormat;
+    memcpy(&vertexFormat, getSectionData(*format), sizeof(vertexFormat));
+    view.vertexFormat = vertexFormat.format;
+    view.quantization = vertexFormat.quantization;
+    const VertexLayout layout = getVertexLayout(view.vertexFormat);
+    if (vertices && vertices->elementStride == layout.stride) {
+        view.vertices = getSectionData(*vertices);
+        view.vertexCount = static_cast<size_t>(vertices->elementCount);
+    } else if (compressedVertices && compressedVertices->elementStride == layout.stride) {
+        view.compressedVertices = getCompressedStream(*this, *compressedVertices);
+        view.vertexCount = static_cast<size_t>(compressedVertices->elementCount);
+    }
+    if (view.vertexFormat.splitPositions) {
+        if (positions && positions->elementStride == layout.positionStride &&
+            positions->elementCount == view.vertexCount) {
+            view.positions = getSectionData(*positions);
+        } else if (compressedPositions && compressedPositions->elementStride == layout.positionStride &&
+                   compressedPositions->elementCount == view.vertexCount) {
+            view.compressedPositions = getCompressedStream(*this, *compressedPositions);
+        } else {
+            view.vertices = nullptr;
+            view.compressedVertices = {};
+            view.vertexCount = 0;
+        }
+    }
+    if (!indices) {
+        indices = compressedIndices;
+    }
+    if (indices && (indices->elementStride == sizeof(uint32_t) || indices->elementStride == sizeof(uint16_t))) {
+        if (indices == compressedIndices) {
+            view.compressedIndices = getCompressedStream(*this, *indices);
+        } else {
+            view.indices = getSectionData(*indices);
+        }
+        view.indexCount = static_cast<size_t>(indices->elementCount);
+        view.indexSize = indices->elementStride;
+    }
+
+    // Meshlets are optional, but all four sections must be present and consistent with the index buffer
+    const MeshCacheSection* meshlets = findSection(MeshCacheSectionType::Meshlets);
+    const MeshCacheSection* meshletBounds = findSection(MeshCacheSectionType::MeshletBounds);
+    const MeshCacheSection* meshletVertices = findSection(MeshCacheSectionType::MeshletVertices);
+    const MeshCacheSection* meshletTriangles = findSection(MeshCacheSectionType::MeshletTriangles);
+    if (meshlets && meshletBounds && meshletVertices && meshletTriangles &&
+        meshlets->elementStride == sizeof(Meshlet) &&
+        meshletBounds->elementStride == sizeof(MeshletBounds) &&
+        meshletBounds->elementCount == meshlets->elementCount &&
+        meshletVertices->elementStride == sizeof(uint32_t) &&
+        meshletTriangles->elementStride == 3 &&
+        meshletTriangles->elementCount * 3 == view.indexCount) {
+        view.meshlets = static_cast<const Meshlet*>(getSectionData(*meshlets));
+        view.meshletBounds = static_cast<const MeshletBounds*>(getSectionData(*meshletBounds));
+        view.meshletCount = static_cast<size_t>(meshlets->elementCount);
+        view.meshletVertices = static_cast<const uint32_t*>(getSectionData(*meshletVertices));
+        view.meshletVertexCount = static_cast<size_t>(meshletVertices->elementCount);
+        view.meshletTriangles = static_cast<const uint8_t*>(getSectionData(*meshletTriangles));
+    }
+
+    // LODs are optional too; every level must lie inside LOD0 + the LOD index section
+    const MeshCacheSection* lods = findSection(MeshCacheSectionType::Lods);
+    const MeshCacheSection* lodIndices = findSection(MeshCacheSectionType::LodIndices);
+    const MeshCacheSection* compressedLodIndices = findSection(MeshCacheSectionType::CompressedLodIndices);
+    if (!lodIndices) {
+        lodIndices = compressedLodIndices;
+    }
+    if (lods && lodIndices && lods->elementStride == sizeof(MeshLod) &&
+        lodIndices->elementStride == view.indexSize) {
+        const auto* levels = static_cast<const MeshLod*>(getSectionData(*lods));
+        bool valid = true;
+        for (uint64_t i = 0; i < lods->elementCount; ++i) {
+            valid = valid && uint64_t(levels[i].indexOffset) + levels[i].indexCount <=
+                             view.indexCount + lodIndices->elementCount;
+        }
+        if (valid) {
+            view.lods = levels;
+            view.lodCount = static_cast<size_t>(lods->elementCount);
+            if (lodIndices == compressedLodIndices) {
+                view.compressedLodIndices = getCompressedStream(*this, *lodIndices);
+            } else {
+                view.lodIndices = getSectionData(*lodIndices);
+            }
+            view.lodIndexCount = static_cast<size_t>(lodIndices->elementCount);
+        }
+    }
+
+    // Submeshes must tile inside LOD0 and reference valid levels, meshlets and materials
+    const MeshCacheSection* submeshes = findSection(MeshCacheSectionType::Submeshes);
+    const MeshCacheSection* materials = findSection(MeshCacheSectionType::Materials);
+    const MeshCacheSection* strings = findSection(MeshCacheSectionType::MaterialStrings);
+    if (submeshes && materials && strings && submeshes->elementStride == sizeof(Submesh) &&
+        materials->elementStride == sizeof(MeshMaterial) && strings->elementStride == 1 &&
+        strings->elementCount > 0) {
+        const auto* submeshData = static_cast<const Submesh*>(getSectionData(*submeshes));
+        const auto* materialData = static_cast<const MeshMaterial*>(getSectionData(*materials));
+        const auto* stringData = static_cast<const char*>(getSectionData(*strings));
+        bool valid = stringData[strings->elementCount - 1] == '\0';
+        for (uint64_t i = 0; i < submeshes->elementCount; ++i) {
+            const Submesh& submesh = submeshData[i];
+            valid = valid && uint64_t(submesh.indexOffset) + submesh.indexCount <= view.indexCount &&
+                    uint64_t(submesh.lodOffset) + submesh.lodCount <= view.lodCount &&
+                    uint64_t(submesh.meshletOffset) + submesh.meshletCount <= view.meshletCount &&
+                    submesh.baseVertex <= view.vertexCount &&
+                    (submesh.materialIndex == kNoMaterial || submesh.materialIndex < materials->elementCount);
+        }
+        for (uint64_t i = 0; i < materials->elementCount; ++i) {
+            const MeshMaterial& material = materialData[i];
+            valid = valid && material.nameOffset < strings->elementCount &&
+                    material.diffuseTextureOffset < strings->elementCount &&
+                    material.normalTextureOffset < strings->elementCount;
+        }
+        if (valid) {
+            view.submeshes = submeshData;
+            view.submeshCount = static_cast<size_t>(submeshes->elementCount);
+            view.materials = materialData;
+            view.materialCount = static_cast<size_t>(materials->elementCount);
+            view.materialStrings = stringData;
+            view.materialStringsSize = static_cast<size_t>(strings->elementCount);
+        }
+    }
+    const MeshCacheSection* bounds = findSection(MeshCacheSectionType::Bounds);
+    if (bounds && bounds->size >= sizeof(MeshBounds)) {
+        memcpy(&view.bounds, getSectionData(*bounds), sizeof(MeshBounds));
+    }
+    return view;
+}
+
+void MeshCacheWriter::addSection(MeshCacheSectionType type, const void* data, uint32_t elementStride,
+                                 uint64_t elementCount) {
+    m_sections.push_back({type, data, elementStride, elementCount, elementCount * elementStride, false});
+}
+
+void MeshCacheWriter::addCompressedSection(MeshCacheSectionType type, const void* data, size_t size,
+                                           uint32_t elementStride, uint64_t elementCount) {
+    m_sections.push_back({type, data, elementStride, elementCount, size, true});
+}
+
+MeshCacheStreamWriter::~MeshCacheStreamWriter() {
+    abort();
+}
+
+bool MeshCacheStreamWriter::open(const std::string& path, uint32_t sectionCount) {
+    abort();
+    m_path = path;
+    m_tempPath = path + ".tmp";
+    m_file = fopen(m_tempPath.c_str(), "wb");
+    if (!m_file) {
+        return false;
+    }
+    m_table.clear();
+    m_sectionCount = sectionCount;
+    // Header and table are written last; reserve their space with zeros
+    static const uint8_t zeros[256] = {};
+    m_offset = sizeof(MeshCacheHeader) + uint64_t(sectionCount) * sizeof(MeshCacheSection);
+    m_ok = true;
+    for (uint64_t remaining = m_offset; m_ok && remaining > 0;) {
+        size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, sizeof(zeros)));
+        m_ok = fwrite(zeros, 1, chunk, m_file) == chunk;
+        remaining -= chunk;
+    }
+    return m_ok;
+}
+
+void MeshCacheStreamWriter::beginSection(MeshCacheSectionType type, uint32_t elementStride) {
+    static const uint8_t padding[kMeshCacheSectionAlignment] = {};
+    uint64_t aligned = alignOffset(m_offset, kMeshCacheSectionAlignment);
+    if (m_ok && aligned > m_offset) {
+        m_ok = fwrite(padding, 1, static_cast<size_t>(aligned - m_offset), m_file) == aligned - m_offset;
+    }
+    m_offset = aligned;
+    MeshCacheSection section = {};
+    section.type = static_cast<uint32_t>(type);
+    section.elementStride = elementStride;
+    section.offset = m_offset;
+    m_table.push_back(section);
+}
+
+bool MeshCacheStreamWriter::append(const void* data, size_t size) {
+    if (m_ok && size > 0 && !m_table.empty()) {
+        m_ok = fwrite(data, 1, size, m_file) == size;
+        m_table.back().size += size;
+        m_offset += size;
+    }
+    return m_ok;
+}
+
+void MeshCacheStreamWriter::endSection() {
+    MeshCacheSection& section = m_table.back();
+    section.elementCount = section.elementStride ? section.size / section.elementStride : 0;
+    m_ok = m_ok && section.elementCount * section.elementStride == section.size;
+}
+
+void MeshCacheStreamWriter::endCompressedSection(uint64_t elementCount) {
+    m_table.back().elementCount = elementCount;
+}
+
+bool MeshCacheStreamWriter::finish(const SourceStamp& source, uint64_t optionsHash) {
+    if (!m_file) {
+        return false;
+    }
+    MeshCacheHeader header = {};
+    header.magic = kMeshCacheMagic;
+    header.version = kMeshCacheVersion;
+    header.sectionCount = m_sectionCount;
+    header.sourceSize = source.size;
+    header.sourceTimestamp = source.timestamp;
+    header.sourceHash = source.contentHash;
+    header.optionsHash = optionsHash;
+
+    bool ok = m_ok && m_table.size() == m_sectionCount && fseek(m_file, 0, SEEK_SET) == 0 &&
+              fwrite(&header, sizeof(header), 1, m_file) == 1;
+    if (ok && !m_table.empty()) {
+        ok = fwrite(m_table.data(), sizeof(MeshCacheSection), m_table.size(), m_file) == m_table.size();
+    }
+    ok = (fclose(m_file) == 0) && ok;
+    m_file = nullptr;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(m_tempPath, m_path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(m_tempPath, ec);
+    }
+    m_ok = false;
+    return ok;
+}
+
+void MeshCacheStreamWriter::abort() {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+        std::error_code ec;
+        std::filesystem::remove(m_tempPath, ec);
+    }
+    m_ok = false;
+}
+
+bool MeshCacheWriter::write(const std::string& path, const SourceStamp& source, uint64_t optionsHash) const {
+    MeshCacheStreamWriter writer;
+    if (!writer.open(path, static_cast<uint32_t>(m_sections.size()))) {
+        return false;
+    }
+    for (const PendingSection& section : m_sections) {
+        writer.beginSection(section.type, section.elementStride);
+        writer.append(section.data, static_cast<size_t>(section.size));
+        if (section.compressed) {
+            writer.endCompressedSection(section.elementCount);
+        } else {
+            writer.endSection();
+        }
+    }
+    return writer.finish(source, optionsHash);
+}
+
+namespace {
+    // Adds a vertex or index stream: compressed as the view holds it, compressed into storage when asked and
+    // that is smaller, otherwise plain
+    void addStreamSection(MeshCacheWriter& writer, MeshCacheSectionType type, MeshCacheSectionType compressedType,
+                          const void* data, const CompressedStream& compressed, uint32_t elementStride,
+                          size_t elementCount, bool indexStream, bool compress, std::vector<uint8_t>& storage) {
+        if (compressed.data) {
+            writer.addCompressedSection(compressedType, compressed.data, compressed.size, elementStride, elementCount);
+            return;
+        }
+        if (compress && elementCount > 0) {
+            storage = indexStream ? encodeIndexBuffer(data, elementCount, elementStride)
+                                  : encodeVertexBuffer(data, elementCount, elementStride);
+            if (!storage.empty() && storage.size() < elementCount * elementStride) {
+                writer.addCompressedSection(compressedType, storage.data(), storage.size(), elementStride,
+                                            elementCount);
+                return;
+            }
+        }
+        writer.addSection(type, data, elementStride, elementCount);
+    }
+}
+
+bool writeMeshCache(const std::string& path, const MeshView& mesh, const SourceStamp& source, uint64_t optionsHash,
+                    const std::vector<std::string>& dependencies, bool compressStreams) {
+    MeshCacheVertexFormat vertexFormat;
+    memset(static_cast<void*>(&vertexFormat), 0, sizeof(vertexFormat)); // Deterministic padding bytes
+    vertexFormat.format = mesh.vertexFormat;
+    vertexFormat.quantization = mesh.quantization;
+    const VertexLayout layout = getVertexLayout(mesh.vertexFormat);
+    MeshCacheWriter writer;
+    DecodedMeshStreams compressed; // Compressed here; must outlive writer.write()
+    writer.addSection(MeshCacheSectionType::VertexFormat, &vertexFormat, sizeof(vertexFormat), 1);
+    addStreamSection(writer, MeshCacheSectionType::Vertices, MeshCacheSectionType::CompressedVertices, mesh.vertices,
+                     mesh.compressedVertices, layout.stride, mesh.vertexCount, false, compressStreams,
+                     compressed.vertices);
+    if (mesh.vertexFormat.splitPositions) {
+        addStreamSection(writer, MeshCacheSectionType::Positions, MeshCacheSectionType::CompressedPositions,
+                         mesh.positions, mesh.compressedPositions, layout.positionStride, mesh.vertexCount, false,
+                         compressStreams, compressed.positions);
+    }
+    addStreamSection(writer, MeshCacheSectionType::Indices, MeshCacheSectionType::CompressedIndices, mesh.indices,
+                     mesh.compressedIndices, mesh.indexSize, mesh.indexCount, true, compressStreams,
+                     compressed.indices);
+    if (mesh.meshletCount > 0) {
+        writer.addSection(MeshCacheSectionType::Meshlets, mesh.meshlets, sizeof(Meshlet), mesh.meshletCount);
+        writer.addSection(MeshCacheSectionType::MeshletBounds, mesh.meshletBounds, sizeof(MeshletBounds),
+                          mesh.meshletCount);
+        writer.addSection(MeshCacheSectionType::MeshletVertices, mesh.meshletVertices, sizeof(uint32_t),
+                          mesh.meshletVertexCount);
+        writer.addSection(MeshCacheSectionType::MeshletTriangles, mesh.meshletTriangles, 3, mesh.indexCount / 3);
+    }
+    if (mesh.lodCount > 0) {
+        writer.addSection(MeshCacheSectionType::Lods, mesh.lods, sizeof(MeshLod), mesh.lodCount);
+        addStreamSection(writer, MeshCacheSectionType::LodIndices, MeshCacheSectionType::CompressedLodIndices,
+                         mesh.lodIndices, mesh.compressedLodIndices, mesh.indexSize, mesh.lodIndexCount, true,
+                         compressStreams, compressed.lodIndices);
+    }
+    if (mesh.submeshCount > 0) {
+        writer.addSection(MeshCacheSectionType::Submeshes, mesh.submeshes, sizeof(Submesh), mesh.submeshCount);
+        writer.addSection(MeshCacheSectionType::Materials, mesh.materials, sizeof(MeshMaterial), mesh.materialCount);
+        writer.addSection(MeshCacheSectionType::MaterialStrings, mesh.materialStrings, 1, mesh.materialStringsSize);
+    }
+    std::vector<MeshCacheDependency> dependencyRecords;
+    std::vector<char> dependencyPaths;
+    for (const std::string& dependency : dependencies) {
+        SourceStamp stamp;
+        if (!querySourceStamp(dependency, stamp, false)) {
+            return false;
+        }
+        dependencyRecords.push_back({static_cast<uint32_t>(dependencyPaths.size()), 0, stamp.size, stamp.timestamp});
+        dependencyPaths.insert(dependencyPaths.end(), dependency.c_str(), dependency.c_str() + dependency.size() + 1);
+    }
+    if (!dependencyRecords.empty()) {
+        writer.addSection(MeshCacheSectionType::Dependencies, dependencyRecords.data(), sizeof(MeshCacheDependency),
+                          dependencyRecords.size());
+        writer.addSection(MeshCacheSectionType::DependencyPaths, dependencyPaths.data(), 1, dependencyPaths.size());
+    }
+    writer.addSection(MeshCacheSectionType::Bounds, &mesh.bounds, sizeof(MeshBounds), 1);
+    return writer.write(path, source, optionsHash);
+}
+
+bool decodeMeshStreams(MeshView& view, DecodedMeshStreams& outStreams) {
+    const VertexLayout layout = getVertexLayout(view.vertexFormat);
+    auto decode = [](CompressedStream& compressed, const void*& data, std::vector<uint8_t>& storage, size_t count,
+                     uint32_t elementStride, bool indexStream) {
+        if (!compressed.data) {
+            return true;
+        }
+        storage.resize(count * elementStride);
+        if (indexStream ? !decodeIndexBuffer(storage.data(), count, elementStride, compressed.data, compressed.size)
+                        : !decodeVertexBuffer(storage.data(), count, elementStride, compressed.data, compressed.size)) {
+            return false;
+        }
+        data = storage.data();
+        compressed = {};
+        return true;
+    };
+    return decode(view.compressedVertices, view.vertices, outStreams.vertices, view.vertexCount, layout.stride,
+                  false) &&
+           decode(view.compressedPositions, view.positions, outStreams.positions, view.vertexCount,
+                  layout.positionStride, false) &&
+           decode(view.compressedIndices, view.indices, outStreams.indices, view.indexCount, view.indexSize, true) &&
+           decode(view.compressedLodIndices, view.lodIndices, outStreams.lodIndices, view.lodIndexCount,
+                  view.indexSize, true);
+}
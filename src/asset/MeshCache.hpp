@@ -0,0 +1,217 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "MeshData.hpp"
+#include "VirtualFileSystem.hpp"
+
+// Binary mesh cache (".meshcache"): a fixed header, a section table, then section payloads.
+// Every payload starts on a kMeshCacheSectionAlignment boundary so a memory-mapped file can hand
+// its vertex/index arrays straight to the GPU upload path without any per-vertex work.
+
+constexpr uint32_t kMeshCacheMagic = 0x434D5844; // "DXMC"
+constexpr uint32_t kMeshCacheVersion = 8;
+constexpr size_t kMeshCacheSectionAlignment = 256;
+
+enum class MeshCacheSectionType : uint32_t {
+    Vertices = 1, // Encoded vertices, elementStride = getVertexLayout(format).stride
+    Indices = 2, // uint32_t[] or uint16_t[] (elementStride), relative to the submesh base vertices
+    VertexFormat = 3, // MeshCacheVertexFormat
+    Positions = 4, // Split position stream, elementStride = getVertexLayout(format).positionStride
+    Meshlets = 5, // Meshlet[]
+    MeshletBounds = 6, // MeshletBounds[], one per meshlet
+    MeshletVertices = 7, // uint32_t[]
+    MeshletTriangles = 8, // uint8_t[3] per triangle
+    Lods = 9, // MeshLod[], per-submesh chains
+    LodIndices = 10, // LOD1.. index buffers, same element size as Indices
+    Bounds = 11, // MeshBounds
+    Submeshes = 12, // Submesh[]
+    Materials = 13, // MeshMaterial[]
+    MaterialStrings = 14, // char[], null-terminated strings referenced by the materials
+    Dependencies = 15, // MeshCacheDependency[]
+    DependencyPaths = 16, // char[], null-terminated paths referenced by the dependencies
+    // MeshCodec-compressed forms of Vertices, Positions, Indices and LodIndices, stored instead of them.
+    // elementStride and elementCount describe the decoded stream; size is the compressed size.
+    CompressedVertices = 17,
+    CompressedPositions = 18,
+    CompressedIndices = 19,
+    CompressedLodIndices = 20,
+};
+
+// Payload of the VertexFormat section: how to interpret the Vertices section
+struct MeshCacheVertexFormat {
+    VertexFormat format;
+    VertexQuantization quantization;
+};
+
+struct MeshCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t sectionCount;
+    uint32_t reserved;
+    uint64_t sourceSize; // Byte size of the source file when the cache was written
+    int64_t sourceTimestamp; // Last write time of the source file (filesystem clock ticks)
+    uint64_t sourceHash; // hash64 of the source file contents
+    uint64_t optionsHash; // Hash of the import options that shaped the cached data
+};
+
+struct MeshCacheSection {
+    uint32_t type; // MeshCacheSectionType
+    uint32_t elementStride;
+    uint64_t elementCount;
+    uint64_t offset; // From the start of the file, aligned to kMeshCacheSectionAlignment
+    uint64_t size; // Payload size in bytes
+};
+
+// Another file the cached data was built from (e.g. a material library), checked by size and timestamp
+struct MeshCacheDependency {
+    uint32_t pathOffset; // Into the DependencyPaths section
+    uint32_t reserved;
+    uint64_t size;
+    int64_t timestamp;
+};
+
+// Identifies the exact source file a cache was built from
+struct SourceStamp {
+    uint64_t size = 0;
+    int64_t timestamp = 0;
+    uint64_t contentHash = 0;
+};
+
+// Fills size/timestamp and, if requested, the content hash. Returns false if the file cannot be read.
+bool querySourceStamp(const std::string& path, SourceStamp& outStamp, bool hashContents);
+
+// True if the file is still the one that was stamped: same size and timestamp, or the same contents when
+// only the timestamp changed. Shared by every cache format that records a SourceStamp.
+bool sourceMatchesStamp(const std::string& path, uint64_t size, int64_t timestamp, uint64_t contentHash);
+
+class MeshCacheFile {
+public:
+    MeshCacheFile();
+
+    ~MeshCacheFile();
+
+    // Maps the file (or opens it in a pack, in place when it is stored uncompressed) and validates magic,
+    // version and section bounds
+    bool open(const std::string& path, const VirtualFileSystem* fileSystem = nullptr);
+
+    void close();
+
+    bool isOpen() const {
+        return m_header != nullptr;
+    }
+
+    // True if the cache was built from this exact source (size + timestamp, falling back to a content
+    // hash when only the timestamp changed) with the same import options, and no dependency changed
+    bool matchesSource(const std::string& sourcePath, uint64_t optionsHash) const;
+
+    // Same check for a cache found by content (see DerivedDataCache): the source hash is already known
+    bool matchesContent(uint64_t sourceHash, uint64_t optionsHash) const;
+
+    // Only the options are checked for a cache shipped in a pack, which is built together with its source
+    bool matchesOptions(uint64_t optionsHash) const {
+        return m_header && m_header->optionsHash == optionsHash;
+    }
+
+    const MeshCacheHeader& getHeader() const {
+        return *m_header;
+    }
+
+    const MeshCacheSection* findSection(MeshCacheSectionType type) const;
+
+    const void* getSectionData(const MeshCacheSection& section) const {
+        return m_file.data() + section.offset;
+    }
+
+    // Vertex/index arrays pointing directly into the mapping; valid while the file stays open. Compressed
+    // streams are returned compressed (see MeshView).
+    MeshView getView() const;
+
+private:
+    bool dependenciesUnchanged() const;
+
+    VirtualFile m_file;
+    const MeshCacheHeader* m_header = nullptr;
+    const MeshCacheSection* m_sections = nullptr;
+};
+
+// Writes a cache whose sections are produced incrementally: sections are appended one after another and
+// the header and section table are filled in by finish(). Like MeshCacheWriter, it writes a temporary
+// file and renames it into place, so an unfinished or failed write never replaces a valid cache.
+class MeshCacheStreamWriter {
+public:
+    ~MeshCacheStreamWriter();
+
+    // sectionCount reserves the section table; exactly that many sections must be written
+    bool open(const std::string& path, uint32_t sectionCount);
+
+    void beginSection(MeshCacheSectionType type, uint32_t elementStride);
+
+    bool append(const void* data, size_t size);
+
+    void endSection();
+
+    // Ends a section holding a compressed stream of elementCount decoded elements
+    void endCompressedSection(uint64_t elementCount);
+
+    bool finish(const SourceStamp& source, uint64_t optionsHash);
+
+    // Deletes the temporary file unless finish() succeeded
+    void abort();
+
+private:
+    std::string m_path;
+    std::string m_tempPath;
+    FILE* m_file = nullptr;
+    std::vector<MeshCacheSection> m_table;
+    uint32_t m_sectionCount = 0;
+    uint64_t m_offset = 0;
+    bool m_ok = false;
+};
+
+class MeshCacheWriter {
+public:
+    // The data pointer must stay valid until write() returns
+    void addSection(MeshCacheSectionType type, const void* data, uint32_t elementStride, uint64_t elementCount);
+
+    // A compressed stream of size bytes that decodes to elementCount elements of elementStride bytes
+    void addCompressedSection(MeshCacheSectionType type, const void* data, size_t size, uint32_t elementStride,
+                              uint64_t elementCount);
+
+    // Writes to a temporary file next to the target and renames it into place, so a crash never
+    // leaves a truncated cache behind
+    bool write(const std::string& path, const SourceStamp& source, uint64_t optionsHash) const;
+
+private:
+    struct PendingSection {
+        MeshCacheSectionType type;
+        const void* data;
+        uint32_t elementStride;
+        uint64_t elementCount;
+        uint64_t size;
+        bool compressed;
+    };
+
+    std::vector<PendingSection> m_sections;
+};
+
+// Convenience wrapper for the common vertex + index layout; dependencies are stamped as they are now. With
+// compressStreams, vertices and indices are stored MeshCodec-compressed when that makes them smaller;
+// streams the view already holds compressed are written as they are either way.
+bool writeMeshCache(const std::string& path, const MeshView& mesh, const SourceStamp& source, uint64_t optionsHash,
+                    const std::vector<std::string>& dependencies = {}, bool compressStreams = false);
+
+// Storage for the decoded streams of a view
+struct DecodedMeshStreams {
+    std::vector<uint8_t> vertices;
+    std::vector<uint8_t> positions;
+    std::vector<uint8_t> indices;
+    std::vector<uint8_t> lodIndices;
+};
+
+// Decodes the compressed streams of the view into outStreams and points the view at them, for code that
+// reads vertices or indices on the CPU (uploads decode straight into upload memory instead). Returns false
+// if a stream is corrupt.
+bool decodeMeshStreams(MeshView& view, DecodedMeshStreams& outStreams);
@@ -0,0 +1,743 @@
+#include "MeshCodec.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+// MESH_CODEC_NO_SIMD builds the scalar decoder, which "meshcodec check" compares the SIMD ones against
+#if !defined(MESH_CODEC_NO_SIMD) && \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define MESH_CODEC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// pshufb expands escaped values without a per-value loop; MSVC defines no __SSSE3__, but __AVX__ implies it
+#if MESH_CODEC_SSE2 && (defined(__SSSE3__) || defined(__AVX__))
+#define MESH_CODEC_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if !MESH_CODEC_SSE2 && !defined(MESH_CODEC_NO_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+#define MESH_CODEC_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+    constexpr uint8_t kVertexCodecHeader = 0xA1;
+    constexpr uint8_t kIndexCodecHeader = 0xE1;
+    constexpr size_t kBlockMaxBytes = 8192;
+    constexpr size_t kBlockMaxVertices = 256;
+    constexpr size_t kGroupSize = 16;
+    // Zero bytes after the vertex data, so the SIMD group decoder can always load 16 bytes past a group header
+    constexpr size_t kVertexTailSize = 32;
+    constexpr size_t kFifoSize = 16;
+
+    // Multiple of the group size, so only the last block of a buffer has a partial group
+    size_t getBlockVertexCount(size_t stride) {
+        return std::min(kBlockMaxVertices, (kBlockMaxBytes / stride) & ~(kGroupSize - 1));
+    }
+
+    inline uint8_t zigzag8(uint8_t delta) {
+        return static_cast<uint8_t>((delta << 1) ^ (static_cast<int8_t>(delta) >> 7));
+    }
+
+    inline uint8_t unzigzag8(uint8_t value) {
+        return static_cast<uint8_t>((value >> 1) ^ -(value & 1));
+    }
+
+    // --- Vertex encoding ---
+
+    // Group bit widths by header code: 0, 2, 4 or 8 bits per value. In the 2- and 4-bit forms the largest
+    // value (3 or 15) escapes to a raw byte, stored after the packed values in group order.
+    constexpr int kGroupBits[4] = {0, 2, 4, 8};
+
+    size_t getGroupSize(const uint8_t* values, int bits) {
+        if (bits == 0) {
+            return std::all_of(values, values + kGroupSize, [](uint8_t v) { return v == 0; }) ? 0 : SIZE_MAX;
+        }
+        if (bits == 8) {
+            return kGroupSize;
+        }
+        const unsigned escape = (1u << bits) - 1;
+        size_t size = kGroupSize * bits / 8;
+        for (size_t i = 0; i < kGroupSize; ++i) {
+            size += values[i] >= escape;
+        }
+        return size;
+    }
+
+    void encodeGroup(std::vector<uint8_t>& out, const uint8_t* values, int bits) {
+        if (bits == 0) {
+            return;
+        }
+        if (bits == 8) {
+            out.insert(out.end(), values, values + kGroupSize);
+            return;
+        }
+        // Packed most significant first: value 0 is in the top bits of the first byte
+        const unsigned escape = (1u << bits) - 1;
+        const size_t perByte = 8 / bits;
+        for (size_t i = 0; i < kGroupSize; i += perByte) {
+            uint8_t packed = 0;
+            for (size_t j = 0; j < perByte; ++j) {
+                packed = static_cast<uint8_t>((packed << bits) | std::min<unsigned>(values[i + j], escape));
+            }
+            out.push_back(packed);
+        }
+        for (size_t i = 0; i < kGroupSize; ++i) {
+            if (values[i] >= escape) {
+                out.push_back(values[i]);
+            }
+        }
+    }
+
+    // One byte plane of a block: 2-bit header codes for every group, then the groups
+    void encodeBytePlane(std::vector<uint8_t>& out, const uint8_t* values, size_t groupCount) {
+        const size_t headerOffset = out.size();
+        out.resize(out.size() + (groupCount + 3) / 4, 0);
+        for (size_t group = 0; group < groupCount; ++group) {
+            const uint8_t* groupValues = values + group * kGroupSize;
+            int bestCode = 3;
+            size_t bestSize = kGroupSize;
+            for (int code = 0; code < 3; ++code) {
+                const size_t size = getGroupSize(groupValues, kGroupBits[code]);
+                if (size < bestSize) {
+                    bestCode = code;
+                    bestSize = size;
+                }
+            }
+            out[headerOffset + group / 4] |= static_cast<uint8_t>(bestCode << (group % 4 * 2));
+            encodeGroup(out, groupValues, kGroupBits[bestCode]);
+        }
+    }
+
+    // --- Vertex decoding ---
+
+    // Scalar group decoder, used near the end of the data (and for escapes without SSSE3)
+    const uint8_t* decodeGroupScalar(const uint8_t* data, const uint8_t* dataEnd, int bits, uint8_t* out) {
+        const size_t packedSize = kGroupSize * bits / 8;
+        if (size_t(dataEnd - data) < packedSize) {
+            return nullptr;
+        }
+        const uint8_t* raw = data + packedSize;
+        const unsigned escape = (1u << bits) - 1;
+        const size_t perByte = 8 / bits;
+        for (size_t i = 0; i < kGroupSize; ++i) {
+            const unsigned shift = static_cast<unsigned>((perByte - 1 - i % perByte) * bits);
+            uint8_t value = static_cast<uint8_t>((data[i / perByte] >> shift) & escape);
+            if (value == escape) {
+                if (raw == dataEnd) {
+                    return nullptr;
+                }
+                value = *raw++;
+            }
+            out[i] = value;
+        }
+        return raw;
+    }
+
+#if MESH_CODEC_SSSE3 || MESH_CODEC_NEON
+    // For each 8-bit escape mask: where each lane's raw byte is relative to the first raw byte of its half
+    // (0x80 = not escaped, which pshufb/tbl turn into 0)
+    constexpr std::array<std::array<uint8_t, 8>, 256> kEscapeShuffle = [] {
+        std::array<std::array<uint8_t, 8>, 256> table = {};
+        for (unsigned mask = 0; mask < 256; ++mask) {
+            uint8_t next = 0;
+            for (unsigned lane = 0; lane < 8; ++lane) {
+                table[mask][lane] = (mask >> lane) & 1 ? next++ : 0x80;
+            }
+        }
+        return table;
+    }();
+#endif
+
+#if MESH_CODEC_SSE2
+    // 16 values of bits width from the packed bytes at data, lanes in value order
+    inline __m128i unpackGroup(const uint8_t* data, int bits) {
+        if (bits == 2) {
+            int packed;
+            memcpy(&packed, data, sizeof(packed));
+            const __m128i sel = _mm_cvtsi32_si128(packed);
+            const __m128i sel22 = _mm_unpacklo_epi8(_mm_srli_epi16(sel, 4), sel);
+            const __m128i sel2222 = _mm_unpacklo_epi8(_mm_srli_epi16(sel22, 2), sel22);
+            return _mm_and_si128(sel2222, _mm_set1_epi8(3));
+        }
+        const __m128i sel = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+        const __m128i sel44 = _mm_unpacklo_epi8(_mm_srli_epi16(sel, 4), sel);
+        return _mm_and_si128(sel44, _mm_set1_epi8(15));
+    }
+
+    // Needs 8 + 16 readable bytes at data; the caller checks the result against the end of the data
+    inline const uint8_t* decodeGroupSimd(const uint8_t* data, int bits, uint8_t* out) {
+        const __m128i values = unpackGroup(data, bits);
+        const __m128i escaped = _mm_cmpeq_epi8(values, _mm_set1_epi8(static_cast<char>((1 << bits) - 1)));
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(escaped));
+        const uint8_t* raw = data + kGroupSize * bits / 8;
+        if (mask == 0) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), values);
+            return raw;
+        }
+        const unsigned lowCount = std::popcount(mask & 0xFF);
+#if MESH_CODEC_SSSE3
+        const auto* lowEntry = reinterpret_cast<const __m128i*>(kEscapeShuffle[mask & 0xFF].data());
+        const auto* highEntry = reinterpret_cast<const __m128i*>(kEscapeShuffle[mask >> 8].data());
+        const __m128i lowShuffle = _mm_loadl_epi64(lowEntry);
+        // Lanes of the high half index past the low half's raw bytes; 0x80 lanes stay >= 0x80
+        const __m128i highShuffle = _mm_add_epi8(_mm_loadl_epi64(highEntry),
+                                                 _mm_set1_epi8(static_cast<char>(lowCount)));
+        const __m128i shuffle = _mm_unpacklo_epi64(lowShuffle, highShuffle);
+        const __m128i rawBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(raw));
+        const __m128i result = _mm_or_si128(_mm_shuffle_epi8(rawBytes, shuffle), _mm_andnot_si128(escaped, values));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), result);
+#else
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), values);
+        const uint8_t* next = raw;
+        for (unsigned rest = mask; rest != 0; rest &= rest - 1) {
+            out[std::countr_zero(rest)] = *next++;
+        }
+#endif
+        return raw + lowCount + std::popcount(mask >> 8);
+    }
+#elif MESH_CODEC_NEON
+    inline uint8x16_t unpackGroup(const uint8_t* data, int bits) {
+        // Every packed byte repeated once per value it holds, then shifted right by each value's position
+        static const uint8_t kSpread2[16] = {0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3};
+        static const int8_t kShift2[16] = {-6, -4, -2, 0, -6, -4, -2, 0, -6, -4, -2, 0, -6, -4, -2, 0};
+        static const uint8_t kSpread4[16] = {0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7};
+        static const int8_t kShift4[16] = {-4, 0, -4, 0, -4, 0, -4, 0, -4, 0, -4, 0, -4, 0, -4, 0};
+        const uint8x16_t packed = vcombine_u8(vld1_u8(data), vdup_n_u8(0));
+        if (bits == 2) {
+            const uint8x16_t spread = vqtbl1q_u8(packed, vld1q_u8(kSpread2));
+            return vandq_u8(vshlq_u8(spread, vld1q_s8(kShift2)), vdupq_n_u8(3));
+        }
+        const uint8x16_t spread = vqtbl1q_u8(packed, vld1q_u8(kSpread4));
+        return vandq_u8(vshlq_u8(spread, vld1q_s8(kShift4)), vdupq_n_u8(15));
+    }
+
+    inline const uint8_t* decodeGroupSimd(const uint8_t* data, int bits, uint8_t* out) {
+        static const uint8_t kLaneBits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+        const uint8x16_t values = unpackGroup(data, bits);
+        const uint8x16_t escaped = vceqq_u8(values, vdupq_n_u8(static_cast<uint8_t>((1 << bits) - 1)));
+        const uint8x16_t laneBits = vandq_u8(escaped, vld1q_u8(kLaneBits));
+        const unsigned lowMask = vaddv_u8(vget_low_u8(laneBits));
+        const unsigned highMask = vaddv_u8(vget_high_u8(laneBits));
+        const uint8_t* raw = data + kGroupSize * bits / 8;
+        if ((lowMask | highMask) == 0) {
+            vst1q_u8(out, values);
+            return raw;
+        }
+        const unsigned lowCount = std::popcount(lowMask);
+        const uint8x8_t lowShuffle = vld1_u8(kEscapeShuffle[lowMask].data());
+        const uint8x8_t highShuffle = vadd_u8(vld1_u8(kEscapeShuffle[highMask].data()),
+                                              vdup_n_u8(static_cast<uint8_t>(lowCount)));
+        const uint8x16_t rawBytes = vqtbl1q_u8(vld1q_u8(raw), vcombine_u8(lowShuffle, highShuffle));
+        vst1q_u8(out, vbslq_u8(escaped, rawBytes, values));
+        return raw + lowCount + std::popcount(highMask);
+    }
+#endif
+
+    const uint8_t* decodeBytePlane(const uint8_t* data, const uint8_t* dataEnd, [[maybe_unused]] const uint8_t* srcEnd,
+                                   uint8_t* out, size_t groupCount) {
+        const size_t headerSize = (groupCount + 3) / 4;
+        if (size_t(dataEnd - data) < headerSize) {
+            return nullptr;
+        }
+        const uint8_t* header = data;
+        data += headerSize;
+        for (size_t group = 0; group < groupCount && data; ++group) {
+            uint8_t* groupOut = out + group * kGroupSize;
+            const int bits = kGroupBits[(header[group / 4] >> (group % 4 * 2)) & 3];
+            if (bits == 0) {
+                memset(groupOut, 0, kGroupSize);
+            } else if (bits == 8) {
+                if (size_t(dataEnd - data) < kGroupSize) {
+                    return nullptr;
+                }
+                memcpy(groupOut, data, kGroupSize);
+                data += kGroupSize;
+            } else {
+#if MESH_CODEC_SSE2 || MESH_CODEC_NEON
+                // Valid data is followed by the tail, so this only falls back for corrupt data
+                if (size_t(srcEnd - data) >= 8 + kGroupSize) {
+                    data = decodeGroupSimd(data, bits, groupOut);
+                    data = data <= dataEnd ? data : nullptr;
+                    continue;
+                }
+#endif
+                data = decodeGroupScalar(data, dataEnd, bits, groupOut);
+            }
+        }
+        return data;
+    }
+
+    // Turns the decoded byte planes (stride planes of vertexCount zigzag deltas) into vertexCount vertices,
+    // continuing from last, the previous vertex, which is updated. vertexCount is a multiple of the group size.
+    void reconstructBlock(uint8_t* block, const uint8_t* planes, size_t vertexCount, size_t stride, uint8_t* last) {
+#if MESH_CODEC_SSE2
+        // Four planes at a time: prefix sums across 16 vertices, then a 4x16 transpose into 32-bit stores
+        const __m128i one = _mm_set1_epi8(1);
+        const __m128i low7 = _mm_set1_epi8(0x7F);
+        for (size_t k = 0; k < stride; k += 4) {
+            __m128i previous[4];
+            for (size_t j = 0; j < 4; ++j) {
+                previous[j] = _mm_set1_epi8(static_cast<char>(last[k + j]));
+            }
+            for (size_t i = 0; i < vertexCount; i += kGroupSize) {
+                __m128i values[4];
+                for (size_t j = 0; j < 4; ++j) {
+                    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(planes + (k + j) * vertexCount + i));
+                    v = _mm_xor_si128(_mm_and_si128(_mm_srli_epi16(v, 1), low7),
+                                      _mm_sub_epi8(_mm_setzero_si128(), _mm_and_si128(v, one)));
+                    v = _mm_add_epi8(v, _mm_slli_si128(v, 1));
+                    v = _mm_add_epi8(v, _mm_slli_si128(v, 2));
+                    v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+                    v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+                    v = _mm_add_epi8(v, previous[j]);
+                    // Last lane broadcast: the base of the next 16 vertices
+                    previous[j] = _mm_shuffle_epi32(_mm_shufflehi_epi16(_mm_unpackhi_epi8(v, v), 0xFF), 0xFF);
+                    values[j] = v;
+                }
+                const __m128i t0 = _mm_unpacklo_epi8(values[0], values[1]);
+                const __m128i t1 = _mm_unpackhi_epi8(values[0], values[1]);
+                const __m128i t2 = _mm_unpacklo_epi8(values[2], values[3]);
+                const __m128i t3 = _mm_unpackhi_epi8(values[2], values[3]);
+                __m128i rows[4] = {_mm_unpacklo_epi16(t0, t2), _mm_unpackhi_epi16(t0, t2),
+                                   _mm_unpacklo_epi16(t1, t3), _mm_unpackhi_epi16(t1, t3)};
+                uint8_t* out = block + i * stride + k;
+                for (size_t r = 0; r < 4; ++r) {
+                    for (size_t v = 0; v < 4; ++v) {
+                        const int word = _mm_cvtsi128_si32(rows[r]);
+                        memcpy(out, &word, sizeof(word));
+                        out += stride;
+                        rows[r] = _mm_srli_si128(rows[r], 4);
+                    }
+                }
+            }
+            for (size_t j = 0; j < 4; ++j) {
+                last[k + j] = static_cast<uint8_t>(_mm_cvtsi128_si32(previous[j]));
+            }
+        }
+#elif MESH_CODEC_NEON
+        for (size_t k = 0; k < stride; k += 4) {
+            uint8x16_t previous[4];
+            for (size_t j = 0; j < 4; ++j) {
+                previous[j] = vdupq_n_u8(last[k + j]);
+            }
+            const uint8x16_t zero = vdupq_n_u8(0);
+            for (size_t i = 0; i < vertexCount; i += kGroupSize) {
+                uint8x16_t values[4];
+                for (size_t j = 0; j < 4; ++j) {
+                    uint8x16_t v = vld1q_u8(planes + (k + j) * vertexCount + i);
+                    const int8x16_t sign = vnegq_s8(vreinterpretq_s8_u8(vandq_u8(v, vdupq_n_u8(1))));
+                    v = veorq_u8(vshrq_n_u8(v, 1), vreinterpretq_u8_s8(sign));
+                    v = vaddq_u8(v, vextq_u8(zero, v, 15));
+                    v = vaddq_u8(v, vextq_u8(zero, v, 14));
+                    v = vaddq_u8(v, vextq_u8(zero, v, 12));
+                    v = vaddq_u8(v, vextq_u8(zero, v, 8));
+                    v = vaddq_u8(v, previous[j]);
+                    previous[j] = vdupq_laneq_u8(v, 15);
+                    values[j] = v;
+                }
+                const uint8x16x2_t t01 = vzipq_u8(values[0], values[1]);
+                const uint8x16x2_t t23 = vzipq_u8(values[2], values[3]);
+                const uint16x8x2_t low = vzipq_u16(vreinterpretq_u16_u8(t01.val[0]),
+                                                   vreinterpretq_u16_u8(t23.val[0]));
+                const uint16x8x2_t high = vzipq_u16(vreinterpretq_u16_u8(t01.val[1]),
+                                                    vreinterpretq_u16_u8(t23.val[1]));
+                const uint32x4_t rows[4] = {vreinterpretq_u32_u16(low.val[0]), vreinterpretq_u32_u16(low.val[1]),
+                                            vreinterpretq_u32_u16(high.val[0]), vreinterpretq_u32_u16(high.val[1])};
+                uint8_t* out = block + i * stride + k;
+                for (size_t r = 0; r < 4; ++r) {
+                    uint32_t words[4];
+                    vst1q_u32(words, rows[r]);
+                    for (size_t v = 0; v < 4; ++v) {
+                        memcpy(out, &words[v], sizeof(uint32_t));
+                        out += stride;
+                    }
+                }
+            }
+            for (size_t j = 0; j < 4; ++j) {
+                last[k + j] = vgetq_lane_u8(previous[j], 0);
+            }
+        }
+#else
+        for (size_t k = 0; k < stride; ++k) {
+            uint8_t value = last[k];
+            const uint8_t* plane = planes + k * vertexCount;
+            for (size_t i = 0; i < vertexCount; ++i) {
+                value = static_cast<uint8_t>(value + unzigzag8(plane[i]));
+                block[i * stride + k] = value;
+            }
+            last[k] = value;
+        }
+#endif
+    }
+
+    // --- Index coding ---
+
+    // Recently seen directed edges and vertices. Entry 0 of a lookup is the most recent one.
+    struct IndexFifos {
+        uint32_t edges[kFifoSize][2];
+        uint32_t vertices[kFifoSize];
+        size_t edgeOffset = 0;
+        size_t vertexOffset = 0;
+        uint32_t next = 0; // The index a vertex seen for the first time is expected to have
+        uint32_t last = 0; // Base of the delta for explicitly coded indices
+
+        IndexFifos() {
+            memset(edges, 0xFF, sizeof(edges));
+            memset(vertices, 0xFF, sizeof(vertices));
+        }
+
+        void pushEdge(uint32_t a, uint32_t b) {
+            edges[edgeOffset][0] = a;
+            edges[edgeOffset][1] = b;
+            edgeOffset = (edgeOffset + 1) % kFifoSize;
+        }
+
+        void pushVertex(uint32_t v) {
+            vertices[vertexOffset] = v;
+            vertexOffset = (vertexOffset + 1) % kFifoSize;
+        }
+
+        const uint32_t* getEdge(size_t age) const {
+            return edges[(edgeOffset + kFifoSize - 1 - age) % kFifoSize];
+        }
+
+        uint32_t getVertex(size_t age) const {
+            return vertices[(vertexOffset + kFifoSize - 1 - age) % kFifoSize];
+        }
+
+        // Age of the newest edge the triangle (a, b, c) contains in its winding order, and the rotation that
+        // makes it the triangle's first edge; -1 if none
+        int findEdge(uint32_t a, uint32_t b, uint32_t c, unsigned& outRotation) const {
+            for (size_t age = 0; age < kFifoSize; ++age) {
+                const uint32_t* edge = getEdge(age);
+                const uint32_t x = edge[0];
+                const uint32_t y = edge[1];
+                outRotation = (x == a && y == b) ? 0 : (x == b && y == c) ? 1 : (x == c && y == a) ? 2 : 3;
+                if (outRotation < 3) {
+                    return static_cast<int>(age);
+                }
+            }
+            return -1;
+        }
+
+        int findVertex(uint32_t v) const {
+            for (size_t age = 0; age < kFifoSize; ++age) {
+                if (getVertex(age) == v) {
+                    return static_cast<int>(age);
+                }
+            }
+            return -1;
+        }
+    };
+
+    // Per-vertex source codes: 0 = next (a new vertex), 1..14 = vertex FIFO entry of age code - 1,
+    // 15 = explicit zigzag delta to the last explicit index, as a LEB128 varint in the data stream
+    constexpr unsigned kSourceNext = 0;
+    constexpr unsigned kSourceExplicit = 15;
+    constexpr int kMaxFifoSourceAge = 13;
+    // Triangle codes: high nibble < 15 is an edge FIFO hit (age) with the third vertex's source in the low
+    // nibble; 0xF0 is three new vertices; 0xFF is three sources in two data bytes
+    constexpr uint8_t kCodeNewTriangle = 0xF0;
+    constexpr uint8_t kCodeGenericTriangle = 0xFF;
+
+    void writeVarint(std::vector<uint8_t>& out, uint32_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    bool readVarint(const uint8_t*& data, const uint8_t* end, uint32_t& outValue) {
+        uint32_t value = 0;
+        for (unsigned shift = 0; shift < 35; shift += 7) {
+            if (data == end) {
+                return false;
+            }
+            const uint8_t byte = *data++;
+            value |= uint32_t(byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                outValue = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Chooses the source of v and updates next; lookups see the FIFO as it was before the triangle
+    unsigned encodeSource(IndexFifos& fifos, uint32_t v, std::vector<uint32_t>& explicitIndices) {
+        if (v == fifos.next) {
+            fifos.next++;
+            return kSourceNext;
+        }
+        const int age = fifos.findVertex(v);
+        if (age >= 0 && age <= kMaxFifoSourceAge) {
+            return static_cast<unsigned>(age + 1);
+        }
+        explicitIndices.push_back(v);
+        return kSourceExplicit;
+    }
+
+    void writeExplicit(std::vector<uint8_t>& data, IndexFifos& fifos, uint32_t v) {
+        const int32_t delta = static_cast<int32_t>(v - fifos.last);
+        writeVarint(data, (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31));
+        fifos.last = v;
+    }
+
+    bool decodeSource(IndexFifos& fifos, unsigned source, const uint8_t*& data, const uint8_t* end,
+                      uint32_t& outVertex) {
+        if (source == kSourceNext) {
+            outVertex = fifos.next++;
+            return true;
+        }
+        if (source != kSourceExplicit) {
+            outVertex = fifos.getVertex(source - 1);
+            return true;
+        }
+        uint32_t zigzag;
+        if (!readVarint(data, end, zigzag)) {
+            return false;
+        }
+        fifos.last += (zigzag >> 1) ^ (0u - (zigzag & 1));
+        outVertex = fifos.last;
+        return true;
+    }
+
+    template <typename T>
+    std::vector<uint8_t> encodeIndices(const T* indices, size_t indexCount) {
+        const size_t triangleCount = indexCount / 3;
+        std::vector<uint8_t> codes(triangleCount);
+        std::vector<uint8_t> rotations((triangleCount + 3) / 4, 0);
+        std::vector<uint8_t> data;
+        std::vector<uint32_t> explicitIndices;
+        IndexFifos fifos;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            const uint32_t a = indices[t * 3 + 0];
+            const uint32_t b = indices[t * 3 + 1];
+            const uint32_t c = indices[t * 3 + 2];
+            explicitIndices.clear();
+            unsigned rotation = 0;
+            const int edgeAge = fifos.findEdge(a, b, c, rotation);
+            if (edgeAge >= 0 && edgeAge < 15) {
+                // Rotated so the shared edge comes first; the decoder rotates back
+                const uint32_t x = rotation == 0 ? a : rotation == 1 ? b : c;
+                const uint32_t y = rotation == 0 ? b : rotation == 1 ? c : a;
+                const uint32_t z = rotation == 0 ? c : rotation == 1 ? a : b;
+                const unsigned source = encodeSource(fifos, z, explicitIndices);
+                codes[t] = static_cast<uint8_t>((edgeAge << 4) | source);
+                if (source == kSourceExplicit) {
+                    writeExplicit(data, fifos, z);
+                }
+                if (source == kSourceNext || source == kSourceExplicit) {
+                    fifos.pushVertex(z);
+                }
+                fifos.pushEdge(z, y);
+                fifos.pushEdge(x, z);
+                rotations[t / 4] |= static_cast<uint8_t>(rotation << (t % 4 * 2));
+                continue;
+            }
+
+            const uint32_t next = fifos.next;
+            if (a == next && b == next + 1 && c == next + 2) {
+                codes[t] = kCodeNewTriangle;
+                fifos.next += 3;
+                fifos.pushVertex(a);
+                fifos.pushVertex(b);
+                fifos.pushVertex(c);
+            } else {
+                const unsigned sourceA = encodeSource(fifos, a, explicitIndices);
+                const unsigned sourceB = encodeSource(fifos, b, explicitIndices);
+                const unsigned sourceC = encodeSource(fifos, c, explicitIndices);
+                codes[t] = kCodeGenericTriangle;
+                data.push_back(static_cast<uint8_t>((sourceA << 4) | sourceB));
+                data.push_back(static_cast<uint8_t>(sourceC));
+                for (uint32_t v : explicitIndices) {
+                    writeExplicit(data, fifos, v);
+                }
+                const uint32_t vertices[3] = {a, b, c};
+                const unsigned sources[3] = {sourceA, sourceB, sourceC};
+                for (size_t i = 0; i < 3; ++i) {
+                    if (sources[i] == kSourceNext || sources[i] == kSourceExplicit) {
+                        fifos.pushVertex(vertices[i]);
+                    }
+                }
+            }
+            fifos.pushEdge(b, a);
+            fifos.pushEdge(c, b);
+            fifos.pushEdge(a, c);
+        }
+
+        std::vector<uint8_t> out;
+        out.reserve(1 + codes.size() + rotations.size() + data.size());
+        out.push_back(kIndexCodecHeader);
+        out.insert(out.end(), codes.begin(), codes.end());
+        out.insert(out.end(), rotations.begin(), rotations.end());
+        out.insert(out.end(), data.begin(), data.end());
+        return out;
+    }
+
+    template <typename T>
+    bool decodeIndices(T* dst, size_t indexCount, const uint8_t* src, size_t srcSize) {
+        const size_t triangleCount = indexCount / 3;
+        const size_t rotationSize = (triangleCount + 3) / 4;
+        if (indexCount % 3 != 0 || srcSize < 1 + triangleCount + rotationSize || src[0] != kIndexCodecHeader) {
+            return false;
+        }
+        const uint8_t* codes = src + 1;
+        const uint8_t* rotations = codes + triangleCount;
+        const uint8_t* data = rotations + rotationSize;
+        const uint8_t* end = src + srcSize;
+        IndexFifos fifos;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            const uint8_t code = codes[t];
+            uint32_t triangle[3];
+            if ((code >> 4) < 15) {
+                const uint32_t* edge = fifos.getEdge(code >> 4);
+                const uint32_t x = edge[0];
+                const uint32_t y = edge[1];
+                const unsigned source = code & 15;
+                uint32_t z;
+                if (!decodeSource(fifos, source, data, end, z)) {
+                    return false;
+                }
+                if (source == kSourceNext || source == kSourceExplicit) {
+                    fifos.pushVertex(z);
+                }
+                fifos.pushEdge(z, y);
+                fifos.pushEdge(x, z);
+                const unsigned rotation = (rotations[t / 4] >> (t % 4 * 2)) & 3;
+                if (rotation == 0) {
+                    triangle[0] = x, triangle[1] = y, triangle[2] = z;
+                } else if (rotation == 1) {
+                    triangle[0] = z, triangle[1] = x, triangle[2] = y;
+                } else if (rotation == 2) {
+                    triangle[0] = y, triangle[1] = z, triangle[2] = x;
+                } else {
+                    return false;
+                }
+            } else if (code == kCodeNewTriangle) {
+                for (uint32_t& v : triangle) {
+                    v = fifos.next++;
+                    fifos.pushVertex(v);
+                }
+                fifos.pushEdge(triangle[1], triangle[0]);
+                fifos.pushEdge(triangle[2], triangle[1]);
+                fifos.pushEdge(triangle[0], triangle[2]);
+            } else if (code == kCodeGenericTriangle) {
+                if (end - data < 2) {
+                    return false;
+                }
+                const unsigned sources[3] = {unsigned(data[0] >> 4), unsigned(data[0] & 15), unsigned(data[1] & 15)};
+                data += 2;
+                // Sources refer to the FIFO as it was before the triangle, so vertices are pushed afterwards
+                for (size_t i = 0; i < 3; ++i) {
+                    if (!decodeSource(fifos, sources[i], data, end, triangle[i])) {
+                        return false;
+                    }
+                }
+                for (size_t i = 0; i < 3; ++i) {
+                    if (sources[i] == kSourceNext || sources[i] == kSourceExplicit) {
+                        fifos.pushVertex(triangle[i]);
+                    }
+                }
+                fifos.pushEdge(triangle[1], triangle[0]);
+                fifos.pushEdge(triangle[2], triangle[1]);
+                fifos.pushEdge(triangle[0], triangle[2]);
+            } else {
+                return false;
+            }
+            // Written in order, one index at a time, which suits write-combined upload memory
+            for (size_t i = 0; i < 3; ++i) {
+                const T value = static_cast<T>(triangle[i]);
+                memcpy(dst + t * 3 + i, &value, sizeof(T));
+            }
+        }
+        return data == end;
+    }
+}
+
+std::vector<uint8_t> encodeVertexBuffer(const void* vertices, size_t vertexCount, size_t stride) {
+    if (stride == 0 || stride % 4 != 0 || stride > kMaxVertexCodecStride) {
+        return {};
+    }
+    const auto* src = static_cast<const uint8_t*>(vertices);
+    const size_t blockVertexCount = getBlockVertexCount(stride);
+    std::vector<uint8_t> out;
+    out.reserve(1 + vertexCount * stride / 2 + kVertexTailSize);
+    out.push_back(kVertexCodecHeader);
+    uint8_t last[kMaxVertexCodecStride] = {}; // Deltas of the first vertex are against zero
+    uint8_t plane[kBlockMaxVertices];
+    for (size_t blockStart = 0; blockStart < vertexCount; blockStart += blockVertexCount) {
+        const size_t count = std::min(blockVertexCount, vertexCount - blockStart);
+        const size_t groupCount = (count + kGroupSize - 1) / kGroupSize;
+        for (size_t k = 0; k < stride; ++k) {
+            uint8_t previous = last[k];
+            for (size_t i = 0; i < count; ++i) {
+                const uint8_t value = src[(blockStart + i) * stride + k];
+                plane[i] = zigzag8(static_cast<uint8_t>(value - previous));
+                previous = value;
+            }
+            memset(plane + count, 0, groupCount * kGroupSize - count); // Padding decodes to copies of the last
+            last[k] = previous;
+            encodeBytePlane(out, plane, groupCount);
+        }
+    }
+    out.resize(out.size() + kVertexTailSize, 0);
+    return out;
+}
+
+bool decodeVertexBuffer(void* dst, size_t vertexCount, size_t stride, const uint8_t* src, size_t srcSize) {
+    if (stride == 0 || stride % 4 != 0 || stride > kMaxVertexCodecStride || srcSize < 1 + kVertexTailSize ||
+        src[0] != kVertexCodecHeader) {
+        return false;
+    }
+    auto* out = static_cast<uint8_t*>(dst);
+    const uint8_t* data = src + 1;
+    const uint8_t* srcEnd = src + srcSize;
+    const uint8_t* dataEnd = srcEnd - kVertexTailSize;
+    const size_t blockVertexCount = getBlockVertexCount(stride);
+    alignas(16) uint8_t planes[kBlockMaxBytes];
+    alignas(16) uint8_t block[kBlockMaxBytes];
+    uint8_t last[kMaxVertexCodecStride] = {};
+    for (size_t blockStart = 0; blockStart < vertexCount; blockStart += blockVertexCount) {
+        const size_t count = std::min(blockVertexCount, vertexCount - blockStart);
+        const size_t groupCount = (count + kGroupSize - 1) / kGroupSize;
+        const size_t paddedCount = groupCount * kGroupSize;
+        for (size_t k = 0; k < stride && data; ++k) {
+            data = decodeBytePlane(data, dataEnd, srcEnd, planes + k * paddedCount, groupCount);
+        }
+        if (!data) {
+            return false;
+        }
+        reconstructBlock(block, planes, paddedCount, stride, last);
+        memcpy(out + blockStart * stride, block, count * stride);
+    }
+    return data == dataEnd;
+}
+
+std::vector<uint8_t> encodeIndexBuffer(const void* indices, size_t indexCount, size_t indexSize) {
+    if (indexCount % 3 != 0) {
+        return {};
+    }
+    if (indexSize == sizeof(uint16_t)) {
+        return encodeIndices(static_cast<const uint16_t*>(indices), indexCount);
+    }
+    if (indexSize == sizeof(uint32_t)) {
+        return encodeIndices(static_cast<const uint32_t*>(indices), indexCount);
+    }
+    return {};
+}
+
+bool decodeIndexBuffer(void* dst, size_t indexCount, size_t indexSize, const uint8_t* src, size_t srcSize) {
+    if (indexSize == sizeof(uint16_t)) {
+        return decodeIndices(static_cast<uint16_t*>(dst), indexCount, src, srcSize);
+    }
+    if (indexSize == sizeof(uint32_t)) {
+        return decodeIndices(static_cast<uint32_t*>(dst), indexCount, src, srcSize);
+    }
+    return false;
+}
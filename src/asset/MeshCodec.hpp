@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Lossless compression of GPU vertex and index buffers for storage (mesh caches), in the spirit of
+// meshoptimizer's codecs. Both compress best on buffers already optimized for the vertex cache and for
+// fetch order, as MeshImport produces them, and their output still compresses well with LZ4 (packs).
+//
+// Vertices are coded in blocks of at most 8 KB: every byte of the vertex is delta-coded against the same
+// byte of the previous vertex, zigzag-mapped, and the resulting byte planes are stored in groups of 16
+// with 0, 2, 4 or 8 bits per value (values that do not fit are escaped). Decoding is SIMD (SSE2, SSSE3,
+// NEON) and reconstructs each block in a small buffer copied out in one go, so the destination may be
+// write-combined upload memory.
+//
+// Indices are coded per triangle against a FIFO of recently seen edges and vertices: most triangles share
+// an edge with a recent one and cost one byte, plus two bits for their rotation, which is kept.
+
+constexpr size_t kMaxVertexCodecStride = 256;
+
+// Returns an empty vector if the stride is not a multiple of 4 in [4, kMaxVertexCodecStride]
+std::vector<uint8_t> encodeVertexBuffer(const void* vertices, size_t vertexCount, size_t stride);
+
+// Writes vertexCount * stride bytes to dst. Returns false if the data is corrupt or was encoded for another
+// vertex count or stride.
+bool decodeVertexBuffer(void* dst, size_t vertexCount, size_t stride, const uint8_t* src, size_t srcSize);
+
+// Triangle lists of 16- or 32-bit indices; returns an empty vector if indexCount is not a multiple of 3
+std::vector<uint8_t> encodeIndexBuffer(const void* indices, size_t indexCount, size_t indexSize);
+
+// Writes indexCount indices of indexSize bytes to dst, in order. Returns false if the data is corrupt.
+bool decodeIndexBuffer(void* dst, size_t indexCount, size_t indexSize, const uint8_t* src, size_t srcSize);
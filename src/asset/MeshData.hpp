@@ -0,0 +1,111 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MeshSimplifier.hpp"
+#include "Meshlet.hpp"
+#include "VertexFormat.hpp"
+#include "glm/glm.hpp"
+
+// Interleaved vertex layout shared by the raster input layout and the DXR StructuredBuffer<Vertex>
+struct Vertex {
+    glm::vec3 position;
+    glm::vec4 color;
+    glm::vec2 texCoord;
+    glm::vec3 normal;
+};
+
+// Object-space bounds of the whole mesh
+struct MeshBounds {
+    glm::vec3 center; // Bounding sphere
+    float radius;
+    glm::vec3 aabbMin;
+    glm::vec3 aabbMax;
+};
+
+constexpr uint32_t kNoMaterial = 0xFFFFFFFFu;
+
+// Surface parameters of one .mtl material. Strings are offsets of null-terminated entries in the mesh's
+// material string table (offset 0 is the empty string).
+struct MeshMaterial {
+    glm::vec4 diffuseColor; // Kd, alpha = dissolve
+    glm::vec4 specularColor; // Ks, w unused
+    glm::vec3 emissiveColor; // Ke
+    float specularPower; // Ns
+    uint32_t nameOffset;
+    uint32_t diffuseTextureOffset; // Texture paths are relative to the OBJ file
+    uint32_t normalTextureOffset;
+    uint32_t padding;
+};
+
+// One OBJ group drawn with a single material. Every LOD has its own index range for the submesh;
+// LOD0's is [indexOffset, +indexCount). Indices are relative to baseVertex.
+struct Submesh {
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t materialIndex; // Into the mesh materials, kNoMaterial for the default material
+    uint32_t lodOffset; // The submesh's levels are lods[lodOffset, +lodCount), LOD0 first
+    uint32_t lodCount;
+    uint32_t meshletOffset; // Meshlets covering exactly the LOD0 range, when the mesh has meshlets
+    uint32_t meshletCount;
+    uint32_t baseVertex; // Added to every index of the submesh (all LODs); see convertToShortIndices
+    MeshBounds bounds;
+};
+
+// CPU-side result of a mesh import, independent of any graphics API
+struct MeshData {
+    std::vector<Vertex> vertices;
+    // Triangle list, relative to each submesh's baseVertex; meshlet order when meshlets were built
+    std::vector<uint32_t> indices;
+    MeshletData meshlets; // Empty unless MeshImportOptions::buildMeshlets
+    std::vector<uint32_t> lodIndices; // Coarser LOD index buffers, meant to follow indices in one buffer
+    std::vector<MeshLod> lods; // Per-submesh chains, see Submesh; empty when no LODs were requested
+    std::vector<Submesh> submeshes; // Sorted by material; cover indices in order
+    std::vector<MeshMaterial> materials;
+    std::vector<char> materialStrings;
+    std::vector<std::string> dependencies; // Files besides the source that shaped the data (.mtl libraries)
+    MeshBounds bounds = {};
+    uint32_t indexSize = 4; // Bytes per index on the GPU; 2 when every index (and LOD index) fits 16 bits
+};
+
+// A vertex or index stream as stored in a mesh cache compressed with MeshCodec
+struct CompressedStream {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Non-owning view over encoded vertices and indices (either freshly imported data or a memory-mapped mesh cache)
+struct MeshView {
+    const void* vertices = nullptr; // vertexCount * getVertexLayout(vertexFormat).stride bytes
+    const void* positions = nullptr; // vertexCount * positionStride bytes, only when vertexFormat.splitPositions
+    // Set instead of vertices/positions/indices/lodIndices (which are then null) when the cache stores that
+    // stream compressed; the counts and sizes still describe the decoded data. See decodeMeshStreams.
+    CompressedStream compressedVertices;
+    CompressedStream compressedPositions;
+    CompressedStream compressedIndices;
+    CompressedStream compressedLodIndices;
+    size_t vertexCount = 0;
+    VertexFormat vertexFormat;
+    VertexQuantization quantization;
+    const void* indices = nullptr; // indexCount elements of indexSize bytes
+    size_t indexCount = 0;
+    uint32_t indexSize = 4; // 2 or 4; the LOD indices use the same size
+    const Meshlet* meshlets = nullptr; // Optional; meshlet i covers indices [triangleOffset * 3, +triangleCount * 3)
+    const MeshletBounds* meshletBounds = nullptr; // meshletCount entries
+    size_t meshletCount = 0;
+    const uint32_t* meshletVertices = nullptr; // Absolute vertex indices (baseVertex already added)
+    size_t meshletVertexCount = 0;
+    const uint8_t* meshletTriangles = nullptr; // 3 bytes per triangle, indexCount / 3 triangles
+    const void* lodIndices = nullptr; // Optional; LOD1.. indices, addressed as if they followed indices
+    size_t lodIndexCount = 0;
+    const MeshLod* lods = nullptr; // lodCount entries, indexed through the submeshes
+    size_t lodCount = 0;
+    const Submesh* submeshes = nullptr; // Optional; without submeshes the mesh is one submesh with LOD chain lods
+    size_t submeshCount = 0;
+    const MeshMaterial* materials = nullptr;
+    size_t materialCount = 0;
+    const char* materialStrings = nullptr;
+    size_t materialStringsSize = 0;
+    MeshBounds bounds = {};
+};
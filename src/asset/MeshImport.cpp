@@ -0,0 +1,887 @@
+#include "MeshImport.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+
+#include "DerivedDataCache.hpp"
+#include "Hash.hpp"
+#include "MeshOptimizer.hpp"
+#include "ObjParser.hpp"
+#include "ShortIndices.hpp"
+#include "VertexWelder.hpp"
+#include "VirtualFileSystem.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    Vertex makeObjVertex(const float* position, const float* texCoord, const float* normal) {
+        Vertex vertex = {};
+        vertex.position = {position[0], position[1], position[2]};
+        // Provide default normal if none exists (e.g., facing up)
+        vertex.normal = normal ? glm::vec3(normal[0], normal[1], normal[2]) : glm::vec3(0.0f, 1.0f, 0.0f);
+        // OBJ UVs often have Y inverted compared to DX, flip it
+        vertex.texCoord = texCoord ? glm::vec2(texCoord[0], 1.0f - texCoord[1]) : glm::vec2(0.0f, 0.0f);
+        // Color (set default or potentially load from material later)
+        vertex.color = {1.0f, 1.0f, 1.0f, 1.0f}; // Default white
+        return vertex;
+    }
+
+    MeshBounds computeMeshBounds(const std::vector<Vertex>& vertices) {
+        MeshBounds bounds = {};
+        bounds.aabbMin = glm::vec3(FLT_MAX);
+        bounds.aabbMax = glm::vec3(-FLT_MAX);
+        for (const Vertex& vertex : vertices) {
+            bounds.aabbMin = glm::min(bounds.aabbMin, vertex.position);
+            bounds.aabbMax = glm::max(bounds.aabbMax, vertex.position);
+        }
+        bounds.center = (bounds.aabbMin + bounds.aabbMax) * 0.5f;
+        for (const Vertex& vertex : vertices) {
+            bounds.radius = std::max(bounds.radius, glm::length(vertex.position - bounds.center));
+        }
+        return bounds;
+    }
+
+    MeshBounds computeIndexedBounds(const std::vector<Vertex>& vertices, const uint32_t* indices, size_t indexCount) {
+        MeshBounds bounds = {};
+        if (indexCount == 0) {
+            return bounds;
+        }
+        bounds.aabbMin = glm::vec3(FLT_MAX);
+        bounds.aabbMax = glm::vec3(-FLT_MAX);
+        for (size_t i = 0; i < indexCount; ++i) {
+            bounds.aabbMin = glm::min(bounds.aabbMin, vertices[indices[i]].position);
+            bounds.aabbMax = glm::max(bounds.aabbMax, vertices[indices[i]].position);
+        }
+        bounds.center = (bounds.aabbMin + bounds.aabbMax) * 0.5f;
+        for (size_t i = 0; i < indexCount; ++i) {
+            bounds.radius = std::max(bounds.radius, glm::length(vertices[indices[i]].position - bounds.center));
+        }
+        return bounds;
+    }
+
+    // Vertices [first, first + count) referenced by a submesh
+    struct VertexRange {
+        uint32_t first;
+        uint32_t count;
+    };
+
+    // Makes the indices relative to the vertex range they use, so the per-submesh passes only touch (and
+    // allocate for) that range instead of the whole vertex buffer
+    VertexRange rebaseIndices(uint32_t* indices, size_t indexCount) {
+        if (indexCount == 0) {
+            return {0, 0};
+        }
+        uint32_t minimum = indices[0];
+        uint32_t maximum = indices[0];
+        for (size_t i = 1; i < indexCount; ++i) {
+            minimum = std::min(minimum, indices[i]);
+            maximum = std::max(maximum, indices[i]);
+        }
+        for (size_t i = 0; i < indexCount; ++i) {
+            indices[i] -= minimum;
+        }
+        return {minimum, maximum - minimum + 1};
+    }
+
+    void restoreIndices(uint32_t* indices, size_t indexCount, uint32_t firstVertex) {
+        for (size_t i = 0; i < indexCount; ++i) {
+            indices[i] += firstVertex;
+        }
+    }
+
+    // Appends the meshlets of one submesh, built on rebased indices, to the mesh meshlets
+    void appendMeshlets(MeshletData& destination, const MeshletData& meshlets, uint32_t firstVertex,
+                        uint32_t firstTriangle) {
+        const uint32_t vertexBase = static_cast<uint32_t>(destination.vertices.size());
+        for (Meshlet meshlet : meshlets.meshlets) {
+            meshlet.vertexOffset += vertexBase;
+            meshlet.triangleOffset += firstTriangle;
+            destination.meshlets.push_back(meshlet);
+        }
+        destination.bounds.insert(destination.bounds.end(), meshlets.bounds.begin(), meshlets.bounds.end());
+        for (uint32_t vertex : meshlets.vertices) {
+            destination.vertices.push_back(vertex + firstVertex);
+        }
+        destination.triangles.insert(destination.triangles.end(), meshlets.triangles.begin(), meshlets.triangles.end());
+    }
+
+    // LOD chain of one submesh as returned by buildMeshLods: levels after the first index indices
+    struct SubmeshLods {
+        std::vector<MeshLod> levels;
+        std::vector<uint32_t> indices;
+    };
+
+    // Fills mesh.lods and mesh.lodIndices. The index data is laid out level by level, so at any LOD the
+    // ranges of submeshes that are adjacent in LOD0 stay adjacent and can still be drawn together.
+    void layoutSubmeshLods(MeshData& mesh, const std::vector<SubmeshLods>& submeshLods) {
+        size_t levelCount = 0;
+        for (size_t s = 0; s < mesh.submeshes.size(); ++s) {
+            Submesh& submesh = mesh.submeshes[s];
+            const std::vector<MeshLod>& levels = submeshLods[s].levels;
+            submesh.lodOffset = static_cast<uint32_t>(mesh.lods.size());
+            submesh.lodCount = static_cast<uint32_t>(levels.size());
+            for (size_t level = 0; level < levels.size(); ++level) {
+                MeshLod lod = levels[level];
+                lod.indexOffset = level == 0 ? submesh.indexOffset : 0; // Coarser levels are placed below
+                mesh.lods.push_back(lod);
+            }
+            levelCount = std::max(levelCount, levels.size());
+        }
+        for (size_t level = 1; level < levelCount; ++level) {
+            for (size_t s = 0; s < mesh.submeshes.size(); ++s) {
+                const Submesh& submesh = mesh.submeshes[s];
+                if (level >= submesh.lodCount) {
+                    continue;
+                }
+                const MeshLod& source = submeshLods[s].levels[level];
+                const uint32_t* indices = submeshLods[s].indices.data() + (source.indexOffset - submesh.indexCount);
+                mesh.lods[submesh.lodOffset + level].indexOffset =
+                    static_cast<uint32_t>(mesh.indices.size() + mesh.lodIndices.size());
+                mesh.lodIndices.insert(mesh.lodIndices.end(), indices, indices + source.indexCount);
+            }
+        }
+    }
+
+    // Builds the material table from the "usemtl" names, in the same order, reading the .mtl libraries
+    // next to the OBJ file. Missing libraries or materials fall back to the MTL defaults with a warning.
+    void loadObjMaterials(MeshData& mesh, const ObjData& obj, const std::string& filename,
+                          const VirtualFileSystem* fileSystem) {
+        const std::filesystem::path directory = std::filesystem::path(filename).parent_path();
+        std::vector<ObjMaterial> libraryMaterials;
+        std::vector<std::filesystem::path> materialDirectories; // Library of each entry, relative to the OBJ
+        for (const std::string& library : obj.materialLibraries) {
+            try {
+                const std::string path = (directory / library).string();
+                parseMtlFile(path, libraryMaterials, fileSystem);
+                if (!fileSystem || !fileSystem->isPacked(path)) {
+                    mesh.dependencies.push_back(path); // Only files on disk can be stamped
+                }
+            } catch (const std::runtime_error& e) {
+                std::cerr << "Warning: " << e.what() << std::endl;
+            }
+            materialDirectories.resize(libraryMaterials.size(), std::filesystem::path(library).parent_path());
+        }
+
+        mesh.materialStrings.assign(1, '\0');
+        auto addString = [&](const std::string& value) {
+            if (value.empty()) {
+                return uint32_t(0);
+            }
+            uint32_t offset = static_cast<uint32_t>(mesh.materialStrings.size());
+            mesh.materialStrings.insert(mesh.materialStrings.end(), value.begin(), value.end());
+            mesh.materialStrings.push_back('\0');
+            return offset;
+        };
+        auto texturePath = [](const std::filesystem::path& libraryDirectory, const std::string& texture) {
+            return texture.empty() ? texture : (libraryDirectory / texture).generic_string();
+        };
+
+        for (const std::string& name : obj.materialNames) {
+            // Later definitions win, as with tinyobj
+            ObjMaterial material;
+            material.name = name;
+            std::filesystem::path libraryDirectory;
+            auto found = std::find_if(libraryMaterials.rbegin(), libraryMaterials.rend(),
+                                      [&](const ObjMaterial& m) { return m.name == name; });
+            if (found != libraryMaterials.rend()) {
+                material = *found;
+                libraryDirectory = materialDirectories[libraryMaterials.rend() - found - 1];
+            } else {
+                std::cerr << "Warning: material \"" << name << "\" not found for " << filename << std::endl;
+            }
+            MeshMaterial meshMaterial = {};
+            meshMaterial.diffuseColor = glm::vec4(material.diffuse[0], material.diffuse[1], material.diffuse[2],
+                                                  material.dissolve);
+            meshMaterial.specularColor = glm::vec4(material.specular[0], material.specular[1], material.specular[2],
+                                                   0.0f);
+            meshMaterial.emissiveColor = glm::vec3(material.emissive[0], material.emissive[1], material.emissive[2]);
+            meshMaterial.specularPower = material.shininess;
+            meshMaterial.nameOffset = addString(name);
+            meshMaterial.diffuseTextureOffset = addString(texturePath(libraryDirectory, material.diffuseTexture));
+            meshMaterial.normalTextureOffset = addString(texturePath(libraryDirectory, material.normalTexture));
+            mesh.materials.push_back(meshMaterial);
+        }
+    }
+
+    // 64-bit file offsets for the spill files (long is 32 bits on Windows)
+    bool seekFile(FILE* file, uint64_t offset) {
+#ifdef _WIN32
+        return _fseeki64(file, static_cast<int64_t>(offset), SEEK_SET) == 0;
+#else
+        return fseeko(file, static_cast<off_t>(offset), SEEK_SET) == 0;
+#endif
+    }
+
+    struct FileCloser {
+        void operator()(FILE* file) const {
+            fclose(file);
+        }
+    };
+
+    using TempFile = std::unique_ptr<FILE, FileCloser>;
+
+    TempFile openTempFile() {
+        TempFile file(std::tmpfile()); // Deleted automatically when closed
+        if (!file) {
+            throw std::runtime_error("Failed to create a temporary file for streaming import");
+        }
+        return file;
+    }
+
+    // Append-only float array for the streaming importer: full blocks go to a temporary file and reads
+    // go through a small direct-mapped block cache, so memory use is fixed by the cache size. OBJ faces
+    // mostly reference recent attributes, which the cache (and the block being filled) keeps in memory.
+    template<size_t Components>
+    class SpilledAttributeArray {
+    public:
+        explicit SpilledAttributeArray(size_t cacheBytes)
+            : m_tail(kBlockSize * Components) {
+            size_t slotCount = std::max<size_t>(cacheBytes / kBlockBytes, 1);
+            m_slotBlocks.assign(slotCount, kEmptySlot);
+            m_slots.resize(slotCount * kBlockSize * Components);
+        }
+
+        size_t size() const {
+            return m_count;
+        }
+
+        void push(const float* values) {
+            memcpy(&m_tail[(m_count % kBlockSize) * Components], values, sizeof(float) * Components);
+            if (++m_count % kBlockSize == 0) {
+                spillTail();
+            }
+        }
+
+        // The pointer is only valid until the next get() or push()
+        const float* get(size_t index) {
+            size_t block = index / kBlockSize;
+            size_t element = (index % kBlockSize) * Components;
+            if (block == m_count / kBlockSize) {
+                return &m_tail[element];
+            }
+            size_t slot = block % m_slotBlocks.size();
+            float* data = &m_slots[slot * kBlockSize * Components];
+            if (m_slotBlocks[slot] != block) {
+                if (!seekFile(m_file.get(), uint64_t(block) * kBlockBytes) ||
+                    fread(data, kBlockBytes, 1, m_file.get()) != 1) {
+                    throw std::runtime_error("Failed to read back spilled OBJ attributes");
+                }
+                m_slotBlocks[slot] = block;
+            }
+            return &data[element];
+        }
+
+    private:
+        static constexpr size_t kBlockSize = 4096; // Elements per block
+        static constexpr size_t kBlockBytes = kBlockSize * Components * sizeof(float);
+        static constexpr size_t kEmptySlot = ~size_t(0);
+
+        TempFile m_file;
+        std::vector<float> m_tail; // Block being filled
+        std::vector<float> m_slots; // Cached blocks
+        std::vector<size_t> m_slotBlocks; // Block held by each slot
+        size_t m_count = 0;
+
+        void spillTail() {
+            if (!m_file) {
+                m_file = openTempFile();
+            }
+            size_t block = m_count / kBlockSize - 1;
+            if (!seekFile(m_file.get(), uint64_t(block) * kBlockBytes) ||
+                fwrite(m_tail.data(), kBlockBytes, 1, m_file.get()) != 1) {
+                throw std::runtime_error("Failed to spill OBJ attributes to disk");
+            }
+            // The newest block is the one faces are most likely to reference next
+            size_t slot = block % m_slotBlocks.size();
+            memcpy(&m_slots[slot * kBlockSize * Components], m_tail.data(), kBlockBytes);
+            m_slotBlocks[slot] = block;
+        }
+    };
+
+    // Rough per-vertex cost of a streaming batch: the vertex and its reordered copy, two hash table slots,
+    // about six indices, the fetch remap and the Tipsify adjacency and scratch arrays
+    constexpr size_t kStreamingBytesPerVertex = 320;
+
+    // Splits the OBJ stream into batches of at most maxVertices unique vertices and hands each one to the
+    // callback after the per-batch optimizations
+    class StreamingObjImporter : public ObjStreamHandler {
+    public:
+        StreamingObjImporter(const MeshImportOptions& options, size_t attributeCacheBytes, size_t maxVertices,
+                             const MeshBatchCallback& onBatch)
+            : m_options(options), m_onBatch(onBatch), m_positions(attributeCacheBytes * 3 / 8),
+              m_texCoords(attributeCacheBytes * 2 / 8), m_normals(attributeCacheBytes * 3 / 8),
+              m_maxVertices(maxVertices), m_maxIndices(maxVertices * 6), m_vertexTable(maxVertices) {
+            m_vertices.reserve(m_maxVertices);
+            m_indices.reserve(m_maxIndices);
+            m_bounds.aabbMin = glm::vec3(FLT_MAX);
+            m_bounds.aabbMax = glm::vec3(-FLT_MAX);
+        }
+
+        void onPosition(float x, float y, float z) override {
+            const float values[3] = {x, y, z};
+            m_positions.push(values);
+        }
+
+        void onTexCoord(float u, float v) override {
+            const float values[2] = {u, v};
+            m_texCoords.push(values);
+        }
+
+        void onNormal(float x, float y, float z) override {
+            const float values[3] = {x, y, z};
+            m_normals.push(values);
+        }
+
+        void onFace(const ObjIndex* corners, uint32_t cornerCount) override {
+            // Copies, since a spilled array only keeps one looked-up block per cache slot valid
+            float quad[4][3] = {};
+            const float* quadPositions[4] = {quad[0], quad[1], quad[2], quad[3]};
+            if (cornerCount == 4) {
+                for (int i = 0; i < 4; ++i) {
+                    memcpy(quad[i], m_positions.get(corners[i].position), sizeof(quad[i]));
+                }
+            }
+            m_triangles.resize((cornerCount - 2) * 3);
+            size_t triangleCorners = triangulateObjPolygon(corners, cornerCount, quadPositions, m_triangles.data());
+            for (size_t t = 0; t < triangleCorners; t += 3) {
+                if (m_vertices.size() + 3 > m_maxVertices || m_indices.size() + 3 > m_maxIndices) {
+                    flush();
+                }
+                for (size_t k = 0; k < 3; ++k) {
+                    addCorner(m_triangles[t + k]);
+                }
+            }
+        }
+
+        // Emits the last partial batch
+        void flush() {
+            if (m_indices.empty()) {
+                return;
+            }
+            if (m_options.optimizeVertexCache) {
+                optimizeVertexCache(m_indices.data(), m_indices.data(), m_indices.size(), m_vertices.size());
+            }
+            if (m_options.optimizeVertexFetch) {
+                m_remap.resize(m_vertices.size());
+                size_t usedVertices = buildVertexFetchRemap(m_remap.data(), m_indices.data(), m_indices.size(),
+                                                            m_vertices.size());
+                m_reordered.resize(usedVertices);
+                remapVertexBuffer(m_reordered.data(), m_vertices.data(), m_vertices.size(), sizeof(Vertex),
+                                  m_remap.data());
+                remapIndexBuffer(m_indices.data(), m_indices.data(), m_indices.size(), m_remap.data());
+                m_vertices.swap(m_reordered);
+            }
+            m_onBatch({m_vertices.data(), m_vertices.size(), m_indices.data(), m_indices.size()});
+            m_triangleCount += m_indices.size() / 3;
+            m_batchCount++;
+            m_vertices.clear();
+            m_indices.clear();
+            m_vertexTable.clear();
+        }
+
+        MeshBounds getBounds() const {
+            MeshBounds bounds = m_bounds;
+            if (m_triangleCount == 0) {
+                return MeshBounds{};
+            }
+            bounds.center = (bounds.aabbMin + bounds.aabbMax) * 0.5f;
+            bounds.radius = glm::length(bounds.aabbMax - bounds.aabbMin) * 0.5f;
+            return bounds;
+        }
+
+        size_t getTriangleCount() const {
+            return m_triangleCount;
+        }
+
+        size_t getBatchCount() const {
+            return m_batchCount;
+        }
+
+    private:
+        const MeshImportOptions& m_options;
+        const MeshBatchCallback& m_onBatch;
+        SpilledAttributeArray<3> m_positions;
+        SpilledAttributeArray<2> m_texCoords;
+        SpilledAttributeArray<3> m_normals;
+        size_t m_maxVertices;
+        size_t m_maxIndices;
+        VertexIndexTable m_vertexTable; // Batch-local (v, vt, vn) deduplication
+        std::vector<Vertex> m_vertices;
+        std::vector<uint32_t> m_indices;
+        std::vector<Vertex> m_reordered;
+        std::vector<uint32_t> m_remap;
+        std::vector<ObjIndex> m_triangles;
+        MeshBounds m_bounds = {};
+        size_t m_triangleCount = 0;
+        size_t m_batchCount = 0;
+
+        void addCorner(const ObjIndex& index) {
+            bool inserted = false;
+            uint32_t vertexIndex = m_vertexTable.findOrInsert({index.position, index.texCoord, index.normal},
+                                                              static_cast<uint32_t>(m_vertices.size()), inserted);
+            if (inserted) {
+                float position[3];
+                float texCoord[2];
+                float normal[3];
+                memcpy(position, m_positions.get(index.position), sizeof(position));
+                if (index.texCoord >= 0) {
+                    memcpy(texCoord, m_texCoords.get(index.texCoord), sizeof(texCoord));
+                }
+                if (index.normal >= 0) {
+                    memcpy(normal, m_normals.get(index.normal), sizeof(normal));
+                }
+                Vertex vertex = makeObjVertex(position, index.texCoord >= 0 ? texCoord : nullptr,
+                                              index.normal >= 0 ? normal : nullptr);
+                m_bounds.aabbMin = glm::min(m_bounds.aabbMin, vertex.position);
+                m_bounds.aabbMax = glm::max(m_bounds.aabbMax, vertex.position);
+                m_vertices.push_back(vertex);
+            }
+            m_indices.push_back(vertexIndex);
+        }
+    };
+}
+
+uint64_t hashImportOptions(const MeshImportOptions& options, uint64_t importRevision) {
+    uint64_t hash = hashCombine(0, importRevision);
+    hash = hashCombine(hash, sizeof(Vertex));
+    hash = hashCombine(hash, hash64(&options.weld, sizeof(options.weld)));
+    hash = hashCombine(hash, options.optimizeVertexCache);
+    hash = hashCombine(hash, options.optimizeVertexFetch);
+    hash = hashCombine(hash, options.spatialSortVertices);
+    hash = hashCombine(hash, hash64(&options.vertexFormat, sizeof(options.vertexFormat)));
+    hash = hashCombine(hash, options.buildMeshlets);
+    hash = hashCombine(hash, hash64(options.lods.data(), options.lods.size() * sizeof(MeshLodTarget)));
+    hash = hashCombine(hash, options.shortIndices);
+    hash = hashCombine(hash, options.streaming);
+    if (options.streaming) {
+        hash = hashCombine(hash, options.streamingMemoryBudget); // Decides where batches split
+    }
+    return hash;
+}
+
+MeshData importObjFile(const std::string& filename, const MeshImportOptions& options) {
+    ObjParseOptions parseOptions;
+    parseOptions.threadCount = options.parseThreadCount;
+    parseOptions.jobSystem = options.jobSystem;
+    ObjData obj;
+    parseObjFile(filename, obj, parseOptions, options.fileSystem);
+
+    // --- Process vertices and indices ---
+    MeshData mesh;
+    // Flat table presized from the corner count: one probe per corner, no per-vertex allocation
+    VertexIndexTable uniqueVertices(obj.corners.size());
+    mesh.indices.reserve(obj.corners.size());
+
+    // Every OBJ group becomes a submesh. Groups are ordered by material, so submeshes sharing a material
+    // are adjacent in the index buffer and can be drawn together.
+    std::vector<size_t> groupOrder(obj.groups.size());
+    std::iota(groupOrder.begin(), groupOrder.end(), size_t(0));
+    std::stable_sort(groupOrder.begin(), groupOrder.end(), [&](size_t a, size_t b) {
+        return static_cast<uint32_t>(obj.groups[a].material) < static_cast<uint32_t>(obj.groups[b].material);
+    });
+    for (size_t group : groupOrder) {
+        const ObjGroup& objGroup = obj.groups[group];
+        Submesh submesh = {};
+        submesh.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+        submesh.indexCount = static_cast<uint32_t>(objGroup.cornerCount);
+        submesh.materialIndex = static_cast<uint32_t>(objGroup.material); // -1 is kNoMaterial
+        mesh.submeshes.push_back(submesh);
+
+        for (size_t corner = objGroup.firstCorner; corner < objGroup.firstCorner + objGroup.cornerCount; ++corner) {
+            const ObjIndex& index = obj.corners[corner];
+            bool inserted = false;
+            uint32_t vertexIndex = uniqueVertices.findOrInsert({index.position, index.texCoord, index.normal},
+                                                               static_cast<uint32_t>(mesh.vertices.size()), inserted);
+            if (inserted) {
+                // First time this combination of pos/norm/uv index is seen, create a new Vertex
+                mesh.vertices.push_back(makeObjVertex(
+                    &obj.positions[3 * index.position],
+                    index.texCoord >= 0 ? &obj.texCoords[2 * index.texCoord] : nullptr,
+                    index.normal >= 0 ? &obj.normals[3 * index.normal] : nullptr));
+            }
+            mesh.indices.push_back(vertexIndex);
+        }
+    }
+
+    // A submesh can only use 16-bit indices if it references at most 65536 vertices; larger ones are split
+    // here, before anything is built per submesh
+    if (options.shortIndices && mesh.vertices.size() > kShortIndexVertexLimit) {
+        std::vector<Submesh> submeshes;
+        for (const Submesh& submesh : mesh.submeshes) {
+            if (submesh.indexCount <= kShortIndexVertexLimit) {
+                submeshes.push_back(submesh); // Cannot reference more vertices than it has indices
+                continue;
+            }
+            Submesh part = submesh;
+            for (uint32_t indexCount : splitIndexRuns(mesh.indices.data() + submesh.indexOffset, submesh.indexCount,
+                                                      mesh.vertices.size())) {
+                part.indexCount = indexCount;
+                submeshes.push_back(part);
+                part.indexOffset += indexCount;
+            }
+        }
+        mesh.submeshes.swap(submeshes);
+    }
+
+    // Optional tolerance-based welding of vertices that only differ by float noise
+    if (options.weld.positionEpsilon > 0.0f) {
+        size_t removed = weldVertices(mesh, options.weld);
+        std::cout << "Welded " << removed << " vertices in " << filename << std::endl;
+    }
+
+    // Triangle reordering, meshlets and LODs work per submesh, so no triangle leaves its submesh
+
+    // Reorder triangles for post-transform cache reuse (raster VS invocations, ClosestHit index loads)
+    if (options.optimizeVertexCache) {
+        VertexCacheStats before = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+        parallelFor(options.jobSystem, mesh.submeshes.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t s = begin; s < end; ++s) {
+                const Submesh& submesh = mesh.submeshes[s];
+                uint32_t* indices = mesh.indices.data() + submesh.indexOffset;
+                const VertexRange range = rebaseIndices(indices, submesh.indexCount);
+                optimizeVertexCache(indices, indices, submesh.indexCount, range.count);
+                restoreIndices(indices, submesh.indexCount, range.first);
+            }
+        });
+        VertexCacheStats after = analyzeVertexCache(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size());
+        std::cout << "Vertex cache " << filename << ": ACMR " << before.acmr << " -> " << after.acmr
+                << ", ATVR " << before.atvr << " -> " << after.atvr << std::endl;
+    }
+
+    // Submeshes are built in parallel, each into its own slot; meshlets are appended in submesh order after
+    std::vector<SubmeshLods> submeshLods(mesh.submeshes.size());
+    std::vector<MeshletData> submeshMeshlets(mesh.submeshes.size());
+    std::vector<uint32_t> submeshFirstVertex(mesh.submeshes.size(), 0);
+    parallelFor(options.jobSystem, mesh.submeshes.size(), 1, [&](size_t begin, size_t end) {
+        for (size_t s = begin; s < end; ++s) {
+            const Submesh& submesh = mesh.submeshes[s];
+            uint32_t* indices = mesh.indices.data() + submesh.indexOffset;
+            const VertexRange range = rebaseIndices(indices, submesh.indexCount);
+            if (range.count == 0) {
+                continue;
+            }
+            const float* positions = &mesh.vertices[range.first].position.x;
+            submeshFirstVertex[s] = range.first;
+
+            // Meshlets grow from the cache-optimized order; the index range is then rewritten meshlet by
+            // meshlet, so each meshlet is a contiguous index range the rasterizer can draw on its own
+            if (options.buildMeshlets) {
+                MeshletData& meshlets = submeshMeshlets[s];
+                meshlets = buildMeshlets(indices, submesh.indexCount, positions, range.count, sizeof(Vertex));
+                writeMeshletIndices(indices, meshlets);
+            }
+
+            // Discrete LODs, simplified from the final LOD0 order, each level with its own cache optimization
+            if (!options.lods.empty()) {
+                SubmeshLods& lods = submeshLods[s];
+                lods.levels = buildMeshLods(lods.indices, indices, submesh.indexCount, positions, range.count,
+                                            sizeof(Vertex), options.lods.data(), options.lods.size());
+                for (size_t level = 1; level < lods.levels.size(); ++level) {
+                    uint32_t* levelIndices =
+                            lods.indices.data() + (lods.levels[level].indexOffset - submesh.indexCount);
+                    if (options.optimizeVertexCache) {
+                        optimizeVertexCache(levelIndices, levelIndices, lods.levels[level].indexCount, range.count);
+                    }
+                    restoreIndices(levelIndices, lods.levels[level].indexCount, range.first);
+                }
+            }
+            restoreIndices(indices, submesh.indexCount, range.first);
+        }
+    });
+    if (options.buildMeshlets) {
+        for (size_t s = 0; s < mesh.submeshes.size(); ++s) {
+            Submesh& submesh = mesh.submeshes[s];
+            submesh.meshletOffset = static_cast<uint32_t>(mesh.meshlets.meshlets.size());
+            submesh.meshletCount = static_cast<uint32_t>(submeshMeshlets[s].meshlets.size());
+            appendMeshlets(mesh.meshlets, submeshMeshlets[s], submeshFirstVertex[s], submesh.indexOffset / 3);
+        }
+    }
+    if (options.buildMeshlets && !mesh.meshlets.meshlets.empty()) {
+        std::cout << "Meshlets " << filename << ": " << mesh.meshlets.meshlets.size() << " (avg "
+                << float(mesh.meshlets.vertices.size()) / float(mesh.meshlets.meshlets.size()) << " vertices, "
+                << float(mesh.indices.size() / 3) / float(mesh.meshlets.meshlets.size()) << " triangles)" << std::endl;
+    }
+    if (!options.lods.empty()) {
+        layoutSubmeshLods(mesh, submeshLods);
+    }
+
+    // Reorder the vertex buffer itself: by first use (matches the index order above) or, for meshes that
+    // are mostly ray traced, along a Morton curve so spatially close hits fetch nearby vertices
+    if ((options.optimizeVertexFetch || options.spatialSortVertices) && !mesh.vertices.empty()) {
+        VertexFetchStats before = analyzeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(),
+                                                     sizeof(Vertex));
+        std::vector<uint32_t> remap(mesh.vertices.size());
+        size_t usedVertices = mesh.vertices.size();
+        if (options.spatialSortVertices) {
+            buildSpatialSortRemap(remap.data(), &mesh.vertices[0].position.x, mesh.vertices.size(), sizeof(Vertex));
+        } else {
+            usedVertices = buildVertexFetchRemap(remap.data(), mesh.indices.data(), mesh.indices.size(),
+                                                 mesh.vertices.size());
+        }
+        std::vector<Vertex> reordered(usedVertices);
+        remapVertexBuffer(reordered.data(), mesh.vertices.data(), mesh.vertices.size(), sizeof(Vertex), remap.data());
+        remapIndexBuffer(mesh.indices.data(), mesh.indices.data(), mesh.indices.size(), remap.data());
+        remapIndexBuffer(mesh.meshlets.vertices.data(), mesh.meshlets.vertices.data(), mesh.meshlets.vertices.size(),
+                         remap.data());
+        remapIndexBuffer(mesh.lodIndices.data(), mesh.lodIndices.data(), mesh.lodIndices.size(), remap.data());
+        mesh.vertices.swap(reordered);
+        VertexFetchStats after = analyzeVertexFetch(mesh.indices.data(), mesh.indices.size(), mesh.vertices.size(),
+                                                    sizeof(Vertex));
+        std::cout << "Vertex fetch " << filename << ": overfetch " << before.overfetch << " -> " << after.overfetch
+                << std::endl;
+    }
+
+    if (mesh.vertices.empty()) {
+        throw std::runtime_error("Failed to load OBJ file: " + filename);
+    }
+    if (mesh.indices.empty()) {
+        throw std::runtime_error("No indices loaded from OBJ file: " + filename);
+    }
+    for (Submesh& submesh : mesh.submeshes) {
+        submesh.bounds = computeIndexedBounds(mesh.vertices, mesh.indices.data() + submesh.indexOffset,
+                                              submesh.indexCount);
+    }
+    mesh.bounds = computeMeshBounds(mesh.vertices);
+
+    // Last, since it may duplicate vertices shared by submeshes: the passes above all see one vertex buffer
+    if (options.shortIndices) {
+        const VertexLayout layout = getVertexLayout(options.vertexFormat);
+        ptrdiff_t duplicated = convertToShortIndices(mesh, layout.stride + layout.positionStride);
+        if (duplicated >= 0) {
+            std::cout << "16-bit indices " << filename << ": " << mesh.submeshes.size() << " submeshes, "
+                    << duplicated << " vertices duplicated" << std::endl;
+        }
+    }
+    loadObjMaterials(mesh, obj, filename, options.fileSystem);
+    return mesh;
+}
+
+MeshBounds importObjFileStreaming(const std::string& filename, const MeshImportOptions& options,
+                                  const MeshBatchCallback& onBatch) {
+    // Budget split: read window, attribute block cache, and the rest for the batch being built. The window
+    // counts twice: the elements parsed out of it take about as much memory again as its text.
+    const size_t budget = options.streamingMemoryBudget;
+    const size_t windowSize = std::clamp<size_t>(budget / 16, size_t(1) << 20, size_t(16) << 20);
+    const size_t attributeCacheBytes = budget / 4;
+    const size_t fixedBytes = windowSize * 2 + attributeCacheBytes;
+    const size_t batchBytes = budget > fixedBytes ? budget - fixedBytes : 0;
+    const size_t maxVertices = std::max<size_t>(batchBytes / kStreamingBytesPerVertex, 4096);
+
+    StreamingObjImporter importer(options, attributeCacheBytes, maxVertices, onBatch);
+    readObjStream(filename, importer, windowSize);
+    importer.flush();
+    if (importer.getTriangleCount() == 0) {
+        throw std::runtime_error("No indices loaded from OBJ file: " + filename);
+    }
+    std::cout << "Streamed " << filename << ": " << importer.getTriangleCount() << " triangles in "
+            << importer.getBatchCount() << " batches of up to " << maxVertices << " vertices" << std::endl;
+    return importer.getBounds();
+}
+
+bool writeStreamedMeshCache(const std::string& filename, const std::string& cachePath,
+                            const MeshImportOptions& options, const SourceStamp& source, uint64_t optionsHash) {
+    MeshCacheStreamWriter writer;
+    if (!writer.open(cachePath, 4)) {
+        return false;
+    }
+    MeshCacheVertexFormat format = {};
+    writer.beginSection(MeshCacheSectionType::VertexFormat, sizeof(format));
+    writer.append(&format, sizeof(format));
+    writer.endSection();
+
+    // Vertices go straight to the cache; indices wait in a temporary file until the vertex section is done
+    TempFile indexFile = openTempFile();
+    std::vector<uint32_t> rebased;
+    uint64_t vertexBase = 0;
+    bool ok = true;
+    writer.beginSection(MeshCacheSectionType::Vertices, sizeof(Vertex));
+    MeshBounds bounds = importObjFileStreaming(filename, options, [&](const MeshBatch& batch) {
+        if (vertexBase + batch.vertexCount > UINT32_MAX) {
+            throw std::runtime_error("Too many vertices for 32-bit indices in OBJ file: " + filename);
+        }
+        rebased.resize(batch.indexCount);
+        for (size_t i = 0; i < batch.indexCount; ++i) {
+            rebased[i] = static_cast<uint32_t>(vertexBase + batch.indices[i]);
+        }
+        ok = ok && writer.append(batch.vertices, batch.vertexCount * sizeof(Vertex)) &&
+             fwrite(rebased.data(), sizeof(uint32_t), rebased.size(), indexFile.get()) == rebased.size();
+        vertexBase += batch.vertexCount;
+    });
+    writer.endSection();
+
+    writer.beginSection(MeshCacheSectionType::Indices, sizeof(uint32_t));
+    ok = ok && seekFile(indexFile.get(), 0);
+    std::vector<uint8_t> chunk(size_t(64) << 10); // Outside the importer budget, so kept small
+    while (ok) {
+        size_t read = fread(chunk.data(), 1, chunk.size(), indexFile.get());
+        ok = writer.append(chunk.data(), read);
+        if (read < chunk.size()) {
+            ok = ok && !ferror(indexFile.get());
+            break;
+        }
+    }
+    writer.endSection();
+
+    writer.beginSection(MeshCacheSectionType::Bounds, sizeof(bounds));
+    writer.append(&bounds, sizeof(bounds));
+    writer.endSection();
+    if (!ok) {
+        writer.abort();
+        return false;
+    }
+    return writer.finish(source, optionsHash);
+}
+
+void importMesh(const std::string& filename, const MeshImportOptions& options, ImportedMesh& outMesh) {
+    outMesh.data = importObjFile(filename, options);
+    const std::vector<Vertex>& vertices = outMesh.data.vertices;
+    outMesh.view.vertexFormat = options.vertexFormat;
+    outMesh.view.quantization = computeVertexQuantization(vertices.data(), vertices.size(), options.vertexFormat);
+    if (options.vertexFormat == VertexFormat{}) {
+        outMesh.view.vertices = vertices.data(); // Already in the Vertex layout
+    } else {
+        const VertexLayout layout = getVertexLayout(options.vertexFormat);
+        outMesh.encodedVertices.resize(vertices.size() * layout.stride);
+        outMesh.encodedPositions.resize(vertices.size() * layout.positionStride);
+        encodeVertices(outMesh.encodedVertices.data(), outMesh.encodedPositions.data(), vertices.data(),
+                       vertices.size(), options.vertexFormat, outMesh.view.quantization);
+        outMesh.view.vertices = outMesh.encodedVertices.data();
+        if (options.vertexFormat.splitPositions) {
+            outMesh.view.positions = outMesh.encodedPositions.data();
+        }
+    }
+    outMesh.view.vertexCount = vertices.size();
+    outMesh.view.indices = outMesh.data.indices.data();
+    outMesh.view.indexCount = outMesh.data.indices.size();
+    outMesh.view.indexSize = outMesh.data.indexSize;
+    if (outMesh.data.indexSize == 2) {
+        outMesh.encodedIndices.assign(outMesh.data.indices.begin(), outMesh.data.indices.end());
+        outMesh.encodedIndices.insert(outMesh.encodedIndices.end(), outMesh.data.lodIndices.begin(),
+                                      outMesh.data.lodIndices.end());
+        outMesh.view.indices = outMesh.encodedIndices.data();
+    }
+    const MeshletData& meshlets = outMesh.data.meshlets;
+    if (!meshlets.meshlets.empty()) {
+        outMesh.view.meshlets = meshlets.meshlets.data();
+        outMesh.view.meshletBounds = meshlets.bounds.data();
+        outMesh.view.meshletCount = meshlets.meshlets.size();
+        outMesh.view.meshletVertices = meshlets.vertices.data();
+        outMesh.view.meshletVertexCount = meshlets.vertices.size();
+        outMesh.view.meshletTriangles = meshlets.triangles.data();
+    }
+    if (!outMesh.data.lods.empty()) {
+        outMesh.view.lodIndices = outMesh.data.lodIndices.data();
+        if (outMesh.data.indexSize == 2) {
+            outMesh.view.lodIndices = outMesh.encodedIndices.data() + outMesh.data.indices.size();
+        }
+        outMesh.view.lodIndexCount = outMesh.data.lodIndices.size();
+        outMesh.view.lods = outMesh.data.lods.data();
+        outMesh.view.lodCount = outMesh.data.lods.size();
+    }
+    if (!outMesh.data.submeshes.empty()) {
+        outMesh.view.submeshes = outMesh.data.submeshes.data();
+        outMesh.view.submeshCount = outMesh.data.submeshes.size();
+        outMesh.view.materials = outMesh.data.materials.data();
+        outMesh.view.materialCount = outMesh.data.materials.size();
+        outMesh.view.materialStrings = outMesh.data.materialStrings.data();
+        outMesh.view.materialStringsSize = outMesh.data.materialStrings.size();
+    }
+    outMesh.view.bounds = outMesh.data.bounds;
+    outMesh.fromCache = false;
+}
+
+void loadMesh(const std::string& filename, const MeshImportOptions& options, ImportedMesh& outMesh) {
+    const std::string sidecarPath = filename + ".meshcache";
+    const uint64_t optionsHash = hashImportOptions(options);
+
+    // Packed assets ship their caches, so the pack is trusted without looking at the source on disk
+    const VirtualFileSystem* fileSystem = options.fileSystem;
+    if (options.useCache && fileSystem && fileSystem->isPacked(sidecarPath)) {
+        if (outMesh.cache.open(sidecarPath, fileSystem) && outMesh.cache.matchesOptions(optionsHash)) {
+            outMesh.view = outMesh.cache.getView();
+            if (outMesh.view.vertexCount > 0 && outMesh.view.indexCount > 0) {
+                outMesh.fromCache = true;
+                return;
+            }
+        }
+        outMesh.cache.close();
+    }
+    if (fileSystem && fileSystem->isPacked(filename)) {
+        if (options.streaming) {
+            throw std::runtime_error("Streaming import needs the source on disk: " + filename);
+        }
+        importMesh(filename, options, outMesh);
+        return;
+    }
+    if (fileSystem && !fileSystem->exists(filename)) {
+        throw std::runtime_error("Failed to open OBJ file: " + filename); // Loose files are disabled
+    }
+
+    // A cache next to the source (written by an earlier run or prebuilt by assetc) is only a stat away
+    if (options.useCache && outMesh.cache.open(sidecarPath)) {
+        if (outMesh.cache.matchesSource(filename, optionsHash)) {
+            outMesh.view = outMesh.cache.getView();
+            if (outMesh.view.vertexCount > 0 && outMesh.view.indexCount > 0) {
+                outMesh.fromCache = true;
+                return;
+            }
+        }
+        outMesh.cache.close(); // Stale or unreadable; must be unmapped before it can be replaced
+    }
+
+    // In the derived-data cache the entry is found by content, so copies and touched sources still hit.
+    // Streamed imports keep the file next to the source: the key would read the whole source once more.
+    std::string cachePath = sidecarPath;
+    DerivedDataCache* derivedData = options.useCache && !options.streaming ? options.derivedDataCache : nullptr;
+    SourceStamp stamp;
+    if (derivedData && querySourceStamp(filename, stamp, true)) {
+        const uint64_t key = makeDerivedDataKey("mesh", kMeshCacheVersion, stamp.contentHash, optionsHash);
+        cachePath = derivedData->getEntryPath(key, ".meshcache");
+        if (outMesh.cache.open(cachePath)) {
+            if (outMesh.cache.matchesContent(stamp.contentHash, optionsHash)) {
+                outMesh.view = outMesh.cache.getView();
+                if (outMesh.view.vertexCount > 0 && outMesh.view.indexCount > 0) {
+                    outMesh.fromCache = true;
+                    derivedData->touch(cachePath);
+                    return;
+                }
+            }
+            outMesh.cache.close();
+        }
+    } else {
+        derivedData = nullptr; // Unreadable source: the import below reports it
+    }
+
+    // Streamed meshes never exist in memory as a whole: they are written to the cache and used from there
+    if (options.streaming) {
+        // No content hash: that would map and read the whole source a second time
+        if (!querySourceStamp(filename, stamp, false) ||
+            !writeStreamedMeshCache(filename, cachePath, options, stamp, optionsHash) ||
+            !outMesh.cache.open(cachePath)) {
+            throw std::runtime_error("Failed to write streamed mesh cache: " + cachePath);
+        }
+        outMesh.view = outMesh.cache.getView();
+        if (outMesh.view.vertexCount == 0 || outMesh.view.indexCount == 0) {
+            throw std::runtime_error("Invalid streamed mesh cache: " + cachePath);
+        }
+        outMesh.fromCache = false;
+        return;
+    }
+
+    importMesh(filename, options, outMesh);
+    if (options.useCache) {
+        if ((!derivedData && !querySourceStamp(filename, stamp, true)) ||
+            !writeMeshCache(cachePath, outMesh.view, stamp, optionsHash, outMesh.data.dependencies,
+                            options.compressStreams)) {
+            std::cerr << "Warning: could not write mesh cache " << cachePath << std::endl;
+        } else if (derivedData) {
+            derivedData->recordWrite(cachePath);
+        }
+    }
+}
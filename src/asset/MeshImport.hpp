@@ -0,0 +1,99 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "MeshCache.hpp"
+#include "MeshData.hpp"
+#include "VertexWelder.hpp"
+
+class DerivedDataCache;
+class JobSystem;
+class VirtualFileSystem;
+
+struct MeshImportOptions {
+    bool useCache = true; // Read/write "<source>.meshcache" next to the source file
+    // Without a valid "<source>.meshcache", looks the cache up here (keyed by the source contents and the
+    // options hash) and writes new caches here instead (except for streamed imports); not part of the hash
+    DerivedDataCache* derivedDataCache = nullptr;
+    // Reads the cache, the source and its material libraries through mounted packs; not part of the hash
+    const VirtualFileSystem* fileSystem = nullptr;
+    unsigned parseThreadCount = 0; // OBJ parser chunks, 0 = one per thread
+    // Runs the OBJ parse and the per-submesh passes (vertex cache, meshlets, LODs) as jobs; does not change
+    // the result, so it is not part of the options hash
+    JobSystem* jobSystem = nullptr;
+    WeldOptions weld; // Epsilon welding after exact (v, vt, vn) deduplication; off by default
+    bool optimizeVertexCache = true; // Tipsify triangle reordering, reports ACMR/ATVR before and after
+    bool optimizeVertexFetch = true; // Reorder vertices by first use in the index buffer
+    bool spatialSortVertices = false; // Morton-order vertices instead (meshes consumed mainly by DXR)
+    VertexFormat vertexFormat; // GPU vertex encoding; the default is the uncompressed Vertex struct
+    bool buildMeshlets = true; // Partition into meshlets (cluster culling) and order the index buffer by meshlet
+    // Simplified levels after LOD0, coarsest last; empty disables LOD generation
+    std::vector<MeshLodTarget> lods = {{0.5f, 0.002f}, {0.25f, 0.005f}, {0.125f, 0.01f}, {0.0625f, 0.02f}};
+    // 16-bit indices with per-submesh base vertices when that saves memory (see convertToShortIndices);
+    // submeshes referencing more than 65536 vertices are split into several with the same material
+    bool shortIndices = true;
+    // Bounded-memory import for sources larger than RAM (see importObjFileStreaming); loadMesh then writes
+    // the cache (even with useCache off) and maps it instead of holding the mesh in memory
+    bool streaming = false;
+    size_t streamingMemoryBudget = size_t(256) << 20; // Bytes the streaming importer may allocate
+    // Store vertices and indices MeshCodec-compressed in written caches (not streamed ones). Caches of either
+    // kind load, so it is not part of the options hash.
+    bool compressStreams = true;
+};
+
+// Bump whenever the import code changes its output so stale caches get rebuilt
+constexpr uint64_t kMeshImportRevision = 6;
+
+// Hash of every option that changes the imported data and of the import code revision; stored in the cache
+// header
+uint64_t hashImportOptions(const MeshImportOptions& options, uint64_t importRevision = kMeshImportRevision);
+
+// Parses an OBJ file (multi-threaded) and deduplicates its pos/uv/normal index triples into an indexed triangle list
+MeshData importObjFile(const std::string& filename, const MeshImportOptions& options);
+
+// One self-contained piece of a streamed mesh: vertices are deduplicated within the batch only and the
+// indices are local to it
+struct MeshBatch {
+    const Vertex* vertices;
+    size_t vertexCount;
+    const uint32_t* indices;
+    size_t indexCount;
+};
+
+using MeshBatchCallback = std::function<void(const MeshBatch& batch)>;
+
+// Streaming OBJ import: the file is read through a fixed window, attributes beyond a small cache are
+// spilled to a temporary file, and triangles are handed to onBatch in batches sized from
+// options.streamingMemoryBudget, which bounds the importer's own memory use. Only per-batch processing
+// applies (vertex cache and fetch optimization); welding, meshlets, LODs and spatial sorting need the
+// whole mesh and are skipped. Returns the bounds of the whole mesh (the sphere is the AABB's).
+MeshBounds importObjFileStreaming(const std::string& filename, const MeshImportOptions& options,
+                                  const MeshBatchCallback& onBatch);
+
+// Streams the OBJ straight into a mesh cache in the Vertex layout: batches are concatenated and their
+// indices rebased, with the indices spilled to a temporary file until the vertex section is complete
+bool writeStreamedMeshCache(const std::string& filename, const std::string& cachePath,
+                            const MeshImportOptions& options, const SourceStamp& source, uint64_t optionsHash);
+
+// Result of loadMesh: either a memory-mapped cache or freshly imported data, exposed through one view
+struct ImportedMesh {
+    MeshCacheFile cache; // Open when the mesh came from the cache
+    MeshData data; // Filled when the mesh was imported from source
+    std::vector<uint8_t> encodedVertices; // data.vertices in options.vertexFormat (unless that is the Vertex layout)
+    std::vector<uint8_t> encodedPositions; // Position stream when options.vertexFormat.splitPositions
+    std::vector<uint16_t> encodedIndices; // data.indices then data.lodIndices, when data.indexSize is 2
+    MeshView view; // A cache's streams may be compressed (see decodeMeshStreams)
+    bool fromCache = false;
+};
+
+// Imports the source without consulting or writing any cache (options.streaming is ignored). Throws
+// std::runtime_error on import failure.
+void importMesh(const std::string& filename, const MeshImportOptions& options, ImportedMesh& outMesh);
+
+// Loads a mesh through its binary cache when it is valid (next to the source first, then in the
+// derived-data cache), otherwise imports the source and (re)writes the cache. Throws std::runtime_error
+// on import failure. With a file system, a "<source>.meshcache" in a mounted pack comes first and is used
+// in place; a source found only in a pack is imported without writing any cache (pack assetc's outputs).
+void loadMesh(const std::string& filename, const MeshImportOptions& options, ImportedMesh& outMesh);
@@ -0,0 +1,233 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+void buildTriangleAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount,
+                            size_t vertexCount) {
+    adjacency.offsets.assign(vertexCount + 1, 0);
+    for (size_t i = 0; i < indexCount; ++i) {
+        adjacency.offsets[indices[i] + 1]++;
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        adjacency.offsets[v + 1] += adjacency.offsets[v];
+    }
+    adjacency.triangles.resize(indexCount);
+    std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+    for (size_t i = 0; i < indexCount; ++i) {
+        adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+}
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned cacheSize) {
+    VertexCacheStats stats;
+    if (indexCount < 3 || vertexCount == 0) {
+        return stats;
+    }
+    // FIFO cache: a vertex is resident while fewer than cacheSize misses happened since it was loaded
+    std::vector<size_t> loadTime(vertexCount, 0);
+    size_t time = cacheSize + 1;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t v = indices[i];
+        if (time - loadTime[v] > cacheSize) {
+            loadTime[v] = time++;
+            stats.transformedVertices++;
+        }
+    }
+    stats.acmr = static_cast<float>(stats.transformedVertices) / static_cast<float>(indexCount / 3);
+    stats.atvr = static_cast<float>(stats.transformedVertices) / static_cast<float>(vertexCount);
+    return stats;
+}
+
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                         unsigned cacheSize) {
+    if (indexCount < 3 || vertexCount == 0) {
+        return;
+    }
+    const size_t triangleCount = indexCount / 3;
+
+    TriangleAdjacency adjacency;
+    buildTriangleAdjacency(adjacency, indices, triangleCount * 3, vertexCount);
+
+    // Copy the input so destination may alias indices
+    std::vector<uint32_t> source(indices, indices + triangleCount * 3);
+
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<size_t> cacheTime(vertexCount, 0);
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> deadEnd; // Recently referenced vertices, used when the fan runs dry
+    std::vector<uint32_t> candidates;
+    deadEnd.reserve(indexCount);
+    candidates.reserve(64);
+
+    size_t time = cacheSize + 1;
+    size_t cursor = 0; // Linear scan position for when the dead-end stack is exhausted
+    size_t output = 0;
+    int64_t fanning = 0;
+
+    while (fanning >= 0) {
+        const uint32_t f = static_cast<uint32_t>(fanning);
+        candidates.clear();
+
+        // Emit every remaining triangle around the fanning vertex
+        for (uint32_t k = adjacency.offsets[f]; k < adjacency.offsets[f + 1]; ++k) {
+            uint32_t triangle = adjacency.triangles[k];
+            if (emitted[triangle]) {
+                continue;
+            }
+            for (int c = 0; c < 3; ++c) {
+                uint32_t v = source[triangle * 3 + c];
+                destination[output++] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - cacheTime[v] > cacheSize) {
+                    cacheTime[v] = time++;
+                }
+            }
+            emitted[triangle] = true;
+        }
+
+        // Next fanning vertex: the candidate that will still be in cache after its remaining triangles
+        // are emitted, preferring the oldest such entry
+        int64_t best = -1;
+        int64_t bestPriority = -1;
+        for (uint32_t v: candidates) {
+            if (liveTriangles[v] == 0) {
+                continue;
+            }
+            int64_t priority = 0;
+            if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize) {
+                priority = static_cast<int64_t>(time - cacheTime[v]);
+            }
+            if (priority > bestPriority) {
+                bestPriority = priority;
+                best = v;
+            }
+        }
+
+        if (best < 0) {
+            // Dead end: fall back to recently used vertices, then to a linear scan
+            while (!deadEnd.empty() && best < 0) {
+                uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if (liveTriangles[v] > 0) {
+                    best = v;
+                }
+            }
+            while (best < 0 && cursor < vertexCount) {
+                if (liveTriangles[cursor] > 0) {
+                    best = static_cast<int64_t>(cursor);
+                }
+                ++cursor;
+            }
+        }
+        fanning = best;
+    }
+}
+
+VertexFetchStats analyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                    size_t vertexSize) {
+    VertexFetchStats stats;
+    if (indexCount == 0 || vertexCount == 0 || vertexSize == 0) {
+        return stats;
+    }
+    constexpr size_t kCacheLine = 64;
+    constexpr size_t kCacheLines = 256; // 16 KB, roughly an L1 slice
+    std::vector<size_t> tags(kCacheLines, ~size_t(0));
+
+    for (size_t i = 0; i < indexCount; ++i) {
+        size_t start = indices[i] * vertexSize;
+        size_t end = start + vertexSize;
+        for (size_t line = start / kCacheLine; line * kCacheLine < end; ++line) {
+            size_t& tag = tags[line % kCacheLines];
+            if (tag != line) {
+                tag = line;
+                stats.bytesFetched += kCacheLine;
+            }
+        }
+    }
+    stats.overfetch = static_cast<float>(stats.bytesFetched) / static_cast<float>(vertexCount * vertexSize);
+    return stats;
+}
+
+size_t buildVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+    std::fill(remap, remap + vertexCount, kUnusedVertex);
+    uint32_t next = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32_t& slot = remap[indices[i]];
+        if (slot == kUnusedVertex) {
+            slot = next++;
+        }
+    }
+    return next;
+}
+
+namespace {
+    // Spreads the low 10 bits of v so there are two zero bits between each
+    inline uint32_t part1By2(uint32_t v) {
+        v &= 0x3FF;
+        v = (v | (v << 16)) & 0x030000FF;
+        v = (v | (v << 8)) & 0x0300F00F;
+        v = (v | (v << 4)) & 0x030C30C3;
+        v = (v | (v << 2)) & 0x09249249;
+        return v;
+    }
+}
+
+void buildSpatialSortRemap(uint32_t* remap, const float* positions, size_t vertexCount, size_t positionStride) {
+    if (vertexCount == 0) {
+        return;
+    }
+    auto positionOf = [&](size_t i) {
+        return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + i * positionStride);
+    };
+
+    float minBound[3] = {positionOf(0)[0], positionOf(0)[1], positionOf(0)[2]};
+    float maxBound[3] = {minBound[0], minBound[1], minBound[2]};
+    for (size_t i = 1; i < vertexCount; ++i) {
+        const float* p = positionOf(i);
+        for (int axis = 0; axis < 3; ++axis) {
+            minBound[axis] = std::min(minBound[axis], p[axis]);
+            maxBound[axis] = std::max(maxBound[axis], p[axis]);
+        }
+    }
+    // Uniform scale keeps the curve isotropic for elongated meshes
+    float extent = std::max({maxBound[0] - minBound[0], maxBound[1] - minBound[1], maxBound[2] - minBound[2]});
+    float scale = extent > 0.0f ? 1023.0f / extent : 0.0f;
+
+    std::vector<std::pair<uint32_t, uint32_t>> keys(vertexCount); // (morton code, old index)
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const float* p = positionOf(i);
+        uint32_t x = static_cast<uint32_t>((p[0] - minBound[0]) * scale + 0.5f);
+        uint32_t y = static_cast<uint32_t>((p[1] - minBound[1]) * scale + 0.5f);
+        uint32_t z = static_cast<uint32_t>((p[2] - minBound[2]) * scale + 0.5f);
+        keys[i] = {part1By2(x) | (part1By2(y) << 1) | (part1By2(z) << 2), static_cast<uint32_t>(i)};
+    }
+    std::sort(keys.begin(), keys.end());
+    for (size_t i = 0; i < vertexCount; ++i) {
+        remap[keys[i].second] = static_cast<uint32_t>(i);
+    }
+}
+
+void remapVertexBuffer(void* destination, const void* vertices, size_t vertexCount, size_t vertexSize,
+                       const uint32_t* remap) {
+    auto* dst = static_cast<uint8_t*>(destination);
+    const auto* src = static_cast<const uint8_t*>(vertices);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        if (remap[i] != kUnusedVertex) {
+            memcpy(dst + remap[i] * vertexSize, src + i * vertexSize, vertexSize);
+        }
+    }
+}
+
+void remapIndexBuffer(uint32_t* destination, const uint32_t* indices, size_t indexCount, const uint32_t* remap) {
+    for (size_t i = 0; i < indexCount; ++i) {
+        destination[i] = remap[indices[i]];
+    }
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Triangles using each vertex, in CSR form: triangles[offsets[v] .. offsets[v + 1])
+struct TriangleAdjacency {
+    std::vector<uint32_t> offsets; // vertexCount + 1
+    std::vector<uint32_t> triangles;
+};
+
+void buildTriangleAdjacency(TriangleAdjacency& adjacency, const uint32_t* indices, size_t indexCount,
+                            size_t vertexCount);
+
+// Post-transform vertex cache efficiency of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats {
+    size_t transformedVertices = 0; // Cache misses
+    float acmr = 0.0f; // Average cache miss ratio: misses per triangle (0.5 is ideal, 3 is worst)
+    float atvr = 0.0f; // Average transformed vertex ratio: misses per vertex (1 is ideal)
+};
+
+constexpr unsigned kDefaultVertexCacheSize = 16;
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                    unsigned cacheSize = kDefaultVertexCacheSize);
+
+// Reorders triangles for post-transform cache reuse (Tipsify, Sander et al. 2007). Runs in linear time;
+// every triangle is emitted exactly once with its winding unchanged. destination may alias indices.
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                         unsigned cacheSize = kDefaultVertexCacheSize);
+
+// Vertex fetch efficiency, simulated with a small direct-mapped cache of 64-byte lines
+struct VertexFetchStats {
+    size_t bytesFetched = 0;
+    float overfetch = 0.0f; // bytesFetched / vertex buffer size (1 is ideal)
+};
+
+VertexFetchStats analyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                    size_t vertexSize);
+
+constexpr uint32_t kUnusedVertex = 0xFFFFFFFFu;
+
+// Builds a remap table (old vertex -> new vertex) that orders vertices by first use in the index
+// buffer. Unreferenced vertices map to kUnusedVertex. Returns the number of referenced vertices.
+size_t buildVertexFetchRemap(uint32_t* remap, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Builds a remap table that orders vertices along a Morton (Z-order) curve of their positions. Useful for
+// meshes consumed mainly by ray tracing, where hit shaders fetch vertices by spatial proximity rather
+// than index order. positions points at the first position; positionStride is the vertex size in bytes.
+void buildSpatialSortRemap(uint32_t* remap, const float* positions, size_t vertexCount, size_t positionStride);
+
+// Applies a remap table to a vertex buffer (any vertex size). destination must not alias vertices.
+void remapVertexBuffer(void* destination, const void* vertices, size_t vertexCount, size_t vertexSize,
+                       const uint32_t* remap);
+
+// Rewrites indices through a remap table. destination may alias indices.
+void remapIndexBuffer(uint32_t* destination, const uint32_t* indices, size_t indexCount, const uint32_t* remap);
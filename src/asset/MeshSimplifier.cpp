@@ -0,0 +1,487 @@
+#include "MeshSimplifier.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+#include "MeshOptimizer.hpp"
+#include "glm/glm.hpp"
+
+namespace {
+    enum class VertexKind : uint8_t {
+        Manifold, // Interior vertex, may collapse onto any neighbour
+        Border, // On one open edge loop; collapses only along it
+        Seam, // Two attribute wedges split along one seam; collapses only along it, together with its twin
+        Locked, // Corners, seam ends, non-manifold fans: never moves
+    };
+
+    constexpr uint32_t kNoVertex = ~0u;
+    // Boundary edge quadrics are weighted against the area-weighted face quadrics so borders and seams keep
+    // their shape even on flat regions, where the face planes alone would let them slide freely
+    constexpr double kEdgeWeight = 10.0;
+
+    // Outgoing half-edges per vertex, in CSR form: a -> next[offsets[a] .. offsets[a + 1])
+    struct EdgeAdjacency {
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> next;
+    };
+
+    void buildEdgeAdjacency(EdgeAdjacency& adjacency, const uint32_t* indices, size_t indexCount,
+                            size_t vertexCount) {
+        adjacency.offsets.assign(vertexCount + 1, 0);
+        for (size_t i = 0; i < indexCount; ++i) {
+            adjacency.offsets[indices[i] + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            adjacency.offsets[v + 1] += adjacency.offsets[v];
+        }
+        adjacency.next.resize(indexCount);
+        std::vector<uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+        for (size_t i = 0; i + 2 < indexCount; i += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                adjacency.next[fill[indices[i + k]]++] = indices[i + (k + 1) % 3];
+            }
+        }
+    }
+
+    bool hasEdge(const EdgeAdjacency& adjacency, uint32_t a, uint32_t b) {
+        for (uint32_t i = adjacency.offsets[a]; i < adjacency.offsets[a + 1]; ++i) {
+            if (adjacency.next[i] == b) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // An edge used in one direction only: a border, or a seam when seen in attribute space
+    bool isOpenEdge(const EdgeAdjacency& adjacency, uint32_t a, uint32_t b) {
+        return hasEdge(adjacency, a, b) != hasEdge(adjacency, b, a);
+    }
+
+    // remap: vertex -> lowest vertex with the bitwise same position; wedge: circular list of those vertices
+    void buildPositionRemap(std::vector<uint32_t>& remap, std::vector<uint32_t>& wedge,
+                            const std::vector<glm::vec3>& positions) {
+        const size_t vertexCount = positions.size();
+        std::vector<uint32_t> order(vertexCount);
+        std::iota(order.begin(), order.end(), 0u);
+        std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            int c = memcmp(&positions[a], &positions[b], sizeof(glm::vec3));
+            return c < 0 || (c == 0 && a < b);
+        });
+        remap.resize(vertexCount);
+        wedge.resize(vertexCount);
+        for (size_t i = 0; i < vertexCount;) {
+            size_t end = i + 1;
+            while (end < vertexCount && memcmp(&positions[order[i]], &positions[order[end]], sizeof(glm::vec3)) == 0) {
+                end++;
+            }
+            for (size_t k = i; k < end; ++k) {
+                remap[order[k]] = order[i];
+                wedge[order[k]] = order[k + 1 < end ? k + 1 : i];
+            }
+            i = end;
+        }
+    }
+
+    void classifyVertices(std::vector<VertexKind>& kinds, const EdgeAdjacency& adjacency,
+                          const std::vector<uint32_t>& remap, const std::vector<uint32_t>& wedge) {
+        const size_t vertexCount = remap.size();
+        // The single open edge into / out of each vertex; kNoVertex if none, the vertex itself if several
+        std::vector<uint32_t> openIn(vertexCount, kNoVertex);
+        std::vector<uint32_t> openOut(vertexCount, kNoVertex);
+        for (uint32_t a = 0; a < vertexCount; ++a) {
+            for (uint32_t i = adjacency.offsets[a]; i < adjacency.offsets[a + 1]; ++i) {
+                uint32_t b = adjacency.next[i];
+                if (!hasEdge(adjacency, b, a)) {
+                    openOut[a] = openOut[a] == kNoVertex ? b : a;
+                    openIn[b] = openIn[b] == kNoVertex ? a : b;
+                }
+            }
+        }
+        // Whether the edge a -> b is also open once wedges are merged, i.e. a real border
+        auto isOpenByPosition = [&](uint32_t a, uint32_t b) {
+            for (uint32_t wb = b;;) {
+                for (uint32_t wa = a;;) {
+                    if (hasEdge(adjacency, wb, wa)) {
+                        return false;
+                    }
+                    if ((wa = wedge[wa]) == a) {
+                        break;
+                    }
+                }
+                if ((wb = wedge[wb]) == b) {
+                    break;
+                }
+            }
+            return true;
+        };
+        auto isSingle = [](uint32_t open, uint32_t v) {
+            return open != kNoVertex && open != v;
+        };
+
+        kinds.assign(vertexCount, VertexKind::Locked);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            if (remap[v] != v) {
+                continue;
+            }
+            if (wedge[v] == v) {
+                if (openIn[v] == kNoVertex && openOut[v] == kNoVertex) {
+                    kinds[v] = VertexKind::Manifold;
+                } else if (isSingle(openIn[v], v) && isSingle(openOut[v], v) &&
+                           isOpenByPosition(v, openOut[v]) && isOpenByPosition(openIn[v], v)) {
+                    kinds[v] = VertexKind::Border;
+                }
+            } else if (wedge[wedge[v]] == v) {
+                // Both wedges must run along the same seam in opposite directions, away from any border
+                uint32_t w = wedge[v];
+                if (isSingle(openIn[v], v) && isSingle(openOut[v], v) && isSingle(openIn[w], w) &&
+                    isSingle(openOut[w], w) && remap[openOut[v]] == remap[openIn[w]] &&
+                    remap[openIn[v]] == remap[openOut[w]] && !isOpenByPosition(v, openOut[v]) &&
+                    !isOpenByPosition(openIn[v], v)) {
+                    kinds[v] = VertexKind::Seam;
+                }
+            }
+        }
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            kinds[v] = kinds[remap[v]];
+        }
+    }
+
+    // Symmetric 4x4 error quadric sum(w * (dot(n, p) + d)^2), plus the total weight for normalization
+    struct Quadric {
+        double a00, a11, a22, a10, a20, a21;
+        double b0, b1, b2;
+        double c;
+        double weight;
+    };
+
+    Quadric makePlaneQuadric(const glm::vec3& n, float d, double weight) {
+        return {
+            n.x * n.x * weight, n.y * n.y * weight, n.z * n.z * weight,
+            n.y * n.x * weight, n.z * n.x * weight, n.z * n.y * weight,
+            n.x * d * weight, n.y * d * weight, n.z * d * weight,
+            double(d) * d * weight,
+            weight
+        };
+    }
+
+    void addQuadric(Quadric& q, const Quadric& r) {
+        q.a00 += r.a00;
+        q.a11 += r.a11;
+        q.a22 += r.a22;
+        q.a10 += r.a10;
+        q.a20 += r.a20;
+        q.a21 += r.a21;
+        q.b0 += r.b0;
+        q.b1 += r.b1;
+        q.b2 += r.b2;
+        q.c += r.c;
+        q.weight += r.weight;
+    }
+
+    // Weighted mean squared distance to the accumulated planes
+    double quadricError(const Quadric& q, const glm::vec3& p) {
+        double rx = q.a00 * p.x + q.a10 * p.y + q.a20 * p.z;
+        double ry = q.a10 * p.x + q.a11 * p.y + q.a21 * p.z;
+        double rz = q.a20 * p.x + q.a21 * p.y + q.a22 * p.z;
+        double r = rx * p.x + ry * p.y + rz * p.z + 2.0 * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+        return std::fabs(r) / (q.weight > 0.0 ? q.weight : 1.0);
+    }
+
+    void loadPositions(std::vector<glm::vec3>& out, const float* positions, size_t vertexCount,
+                       size_t positionStride) {
+        out.resize(vertexCount);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            memcpy(&out[v], reinterpret_cast<const uint8_t*>(positions) + v * positionStride, sizeof(glm::vec3));
+        }
+    }
+
+    // Largest side of the bounding box; errors are expressed relative to it
+    float computeExtent(const std::vector<glm::vec3>& positions, glm::vec3& outMin) {
+        glm::vec3 minimum(FLT_MAX);
+        glm::vec3 maximum(-FLT_MAX);
+        for (const glm::vec3& p : positions) {
+            minimum = glm::min(minimum, p);
+            maximum = glm::max(maximum, p);
+        }
+        outMin = minimum;
+        glm::vec3 size = maximum - minimum;
+        return positions.empty() ? 0.0f : std::max(size.x, std::max(size.y, size.z));
+    }
+
+    struct Collapse {
+        uint32_t v; // Moves onto t
+        uint32_t t;
+        float error;
+    };
+}
+
+size_t simplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                    size_t vertexCount, size_t positionStride, size_t targetIndexCount, float targetError,
+                    float* resultError) {
+    std::vector<uint32_t> result;
+    result.reserve(indexCount);
+    for (size_t i = 0; i + 2 < indexCount; i += 3) {
+        if (indices[i] != indices[i + 1] && indices[i + 1] != indices[i + 2] && indices[i] != indices[i + 2]) {
+            result.insert(result.end(), &indices[i], &indices[i + 3]);
+        }
+    }
+
+    // Work in a unit-sized space so the error threshold is scale independent
+    std::vector<glm::vec3> vertexPositions;
+    loadPositions(vertexPositions, positions, vertexCount, positionStride);
+    std::vector<uint32_t> remap;
+    std::vector<uint32_t> wedge;
+    buildPositionRemap(remap, wedge, vertexPositions);
+    glm::vec3 minimum;
+    float extent = computeExtent(vertexPositions, minimum);
+    float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+    for (glm::vec3& p : vertexPositions) {
+        p = (p - minimum) * scale;
+    }
+
+    EdgeAdjacency edges;
+    buildEdgeAdjacency(edges, result.data(), result.size(), vertexCount);
+    std::vector<VertexKind> kinds;
+    classifyVertices(kinds, edges, remap, wedge);
+
+    // Quadrics live on positions (remap targets) so both wedges of a seam accumulate the same error
+    std::vector<Quadric> quadrics(vertexCount, Quadric{});
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const uint32_t* triangle = &result[i];
+        const glm::vec3& p0 = vertexPositions[triangle[0]];
+        glm::vec3 normal = glm::cross(vertexPositions[triangle[1]] - p0, vertexPositions[triangle[2]] - p0);
+        float length = glm::length(normal);
+        if (length <= 0.0f) {
+            continue;
+        }
+        normal /= length;
+        Quadric face = makePlaneQuadric(normal, -glm::dot(normal, p0), length * 0.5);
+        for (size_t k = 0; k < 3; ++k) {
+            addQuadric(quadrics[remap[triangle[k]]], face);
+        }
+        // Open edges (borders, and seams in attribute space): plane through the edge, perpendicular to the face
+        for (size_t k = 0; k < 3; ++k) {
+            uint32_t a = triangle[k];
+            uint32_t b = triangle[(k + 1) % 3];
+            if (hasEdge(edges, b, a)) {
+                continue;
+            }
+            glm::vec3 edge = vertexPositions[b] - vertexPositions[a];
+            float edgeLength = glm::length(edge);
+            if (edgeLength <= 0.0f) {
+                continue;
+            }
+            glm::vec3 edgeNormal = glm::normalize(glm::cross(edge / edgeLength, normal));
+            Quadric boundary = makePlaneQuadric(edgeNormal, -glm::dot(edgeNormal, vertexPositions[a]),
+                                                double(edgeLength) * edgeLength * kEdgeWeight);
+            addQuadric(quadrics[remap[a]], boundary);
+            addQuadric(quadrics[remap[b]], boundary);
+        }
+    }
+
+    TriangleAdjacency triangles;
+    std::vector<Collapse> candidates;
+    std::vector<uint32_t> collapseRemap(vertexCount);
+    std::vector<uint8_t> touched(vertexCount);
+    const double errorLimit = double(targetError) * targetError;
+    double maxError = 0.0;
+
+    // Twin of a seam collapse: the wedge of t that w (the other side of v) shares an open edge with
+    auto findSeamTwin = [&](uint32_t w, uint32_t t) {
+        for (uint32_t wt = t;;) {
+            if (isOpenEdge(edges, w, wt)) {
+                return wt;
+            }
+            if ((wt = wedge[wt]) == t) {
+                return kNoVertex;
+            }
+        }
+    };
+    auto canCollapse = [&](uint32_t v, uint32_t t) {
+        if (remap[v] == remap[t]) {
+            return false;
+        }
+        switch (kinds[v]) {
+            case VertexKind::Manifold:
+                return true;
+            case VertexKind::Border:
+                return (kinds[t] == VertexKind::Border || kinds[t] == VertexKind::Locked) && isOpenEdge(edges, v, t);
+            case VertexKind::Seam:
+                return (kinds[t] == VertexKind::Seam || kinds[t] == VertexKind::Locked) && isOpenEdge(edges, v, t);
+            default:
+                return false;
+        }
+    };
+    // Moving v onto t must not turn any surviving triangle around v upside down
+    auto flipsTriangle = [&](uint32_t v, uint32_t t) {
+        const glm::vec3& target = vertexPositions[t];
+        for (uint32_t a = triangles.offsets[v]; a < triangles.offsets[v + 1]; ++a) {
+            const uint32_t* triangle = &result[size_t(triangles.triangles[a]) * 3];
+            if (triangle[0] == t || triangle[1] == t || triangle[2] == t) {
+                continue; // Collapses away
+            }
+            size_t k = triangle[0] == v ? 0 : (triangle[1] == v ? 1 : 2);
+            const glm::vec3& p1 = vertexPositions[triangle[(k + 1) % 3]];
+            const glm::vec3& p2 = vertexPositions[triangle[(k + 2) % 3]];
+            glm::vec3 before = glm::cross(p1 - vertexPositions[v], p2 - vertexPositions[v]);
+            glm::vec3 after = glm::cross(p1 - target, p2 - target);
+            if (glm::dot(before, after) <= 0.0f) {
+                return true;
+            }
+        }
+        return false;
+    };
+    // Locks the one-ring of v for the rest of the pass and returns how many triangles the collapse removes
+    auto lockRing = [&](uint32_t v, uint32_t t) {
+        size_t removed = 0;
+        for (uint32_t a = triangles.offsets[v]; a < triangles.offsets[v + 1]; ++a) {
+            const uint32_t* triangle = &result[size_t(triangles.triangles[a]) * 3];
+            for (size_t k = 0; k < 3; ++k) {
+                touched[remap[triangle[k]]] = 1;
+            }
+            removed += (triangle[0] == t || triangle[1] == t || triangle[2] == t);
+        }
+        return removed;
+    };
+
+    // Each pass collapses the cheapest edges whose neighbourhoods do not overlap, then compacts the index
+    // buffer; quadrics carry over, so later passes see the error accumulated by earlier ones
+    while (result.size() > targetIndexCount) {
+        buildEdgeAdjacency(edges, result.data(), result.size(), vertexCount);
+        buildTriangleAdjacency(triangles, result.data(), result.size(), vertexCount);
+
+        candidates.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (size_t k = 0; k < 3; ++k) {
+                uint32_t a = result[i + k];
+                uint32_t b = result[i + (k + 1) % 3];
+                if (a > b && hasEdge(edges, b, a)) {
+                    continue; // Interior edges are seen from both sides, keep one
+                }
+                Collapse best = {kNoVertex, kNoVertex, FLT_MAX};
+                if (canCollapse(a, b)) {
+                    best = {a, b, float(quadricError(quadrics[remap[a]], vertexPositions[b]))};
+                }
+                if (canCollapse(b, a)) {
+                    float error = float(quadricError(quadrics[remap[b]], vertexPositions[a]));
+                    if (error < best.error) {
+                        best = {b, a, error};
+                    }
+                }
+                if (best.v != kNoVertex) {
+                    candidates.push_back(best);
+                }
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) {
+            return a.error < b.error;
+        });
+
+        std::iota(collapseRemap.begin(), collapseRemap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), 0);
+        const size_t triangleGoal = (result.size() - targetIndexCount + 2) / 3;
+        size_t removedTriangles = 0;
+        size_t collapseCount = 0;
+        for (const Collapse& collapse : candidates) {
+            if (collapse.error > errorLimit || removedTriangles >= triangleGoal) {
+                break;
+            }
+            if (touched[remap[collapse.v]] || touched[remap[collapse.t]]) {
+                continue;
+            }
+            uint32_t twin = kNoVertex;
+            uint32_t twinTarget = kNoVertex;
+            if (kinds[collapse.v] == VertexKind::Seam) {
+                twin = wedge[collapse.v];
+                twinTarget = findSeamTwin(twin, collapse.t);
+                if (twinTarget == kNoVertex) {
+                    continue;
+                }
+            }
+            if (flipsTriangle(collapse.v, collapse.t) ||
+                (twin != kNoVertex && flipsTriangle(twin, twinTarget))) {
+                continue;
+            }
+            collapseRemap[collapse.v] = collapse.t;
+            removedTriangles += lockRing(collapse.v, collapse.t);
+            if (twin != kNoVertex) {
+                collapseRemap[twin] = twinTarget;
+                removedTriangles += lockRing(twin, twinTarget);
+            }
+            addQuadric(quadrics[remap[collapse.t]], quadrics[remap[collapse.v]]);
+            maxError = std::max(maxError, double(collapse.error));
+            collapseCount++;
+        }
+        if (collapseCount == 0) {
+            break; // Everything left is locked, would flip, or exceeds the error limit
+        }
+
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            uint32_t a = collapseRemap[result[i]];
+            uint32_t b = collapseRemap[result[i + 1]];
+            uint32_t c = collapseRemap[result[i + 2]];
+            if (remap[a] == remap[b] || remap[b] == remap[c] || remap[a] == remap[c]) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    std::copy(result.begin(), result.end(), destination);
+    if (resultError) {
+        *resultError = float(std::sqrt(maxError));
+    }
+    return result.size();
+}
+
+std::vector<MeshLod> buildMeshLods(std::vector<uint32_t>& lodIndices, const uint32_t* indices, size_t indexCount,
+                                   const float* positions, size_t vertexCount, size_t positionStride,
+                                   const MeshLodTarget* targets, size_t targetCount) {
+    std::vector<MeshLod> lods;
+    lods.push_back({0, static_cast<uint32_t>(indexCount), 0.0f, 0});
+
+    std::vector<glm::vec3> vertexPositions;
+    loadPositions(vertexPositions, positions, vertexCount, positionStride);
+    glm::vec3 minimum;
+    const float extent = computeExtent(vertexPositions, minimum);
+
+    std::vector<uint32_t> source(indices, indices + indexCount);
+    std::vector<uint32_t> level(indexCount);
+    float error = 0.0f;
+    for (size_t i = 0; i < targetCount; ++i) {
+        size_t targetIndexCount = size_t(double(indexCount) * targets[i].indexRatio) / 3 * 3;
+        float levelError = 0.0f;
+        size_t levelCount = simplifyMesh(level.data(), source.data(), source.size(), positions, vertexCount,
+                                         positionStride, targetIndexCount,
+                                         std::max(targets[i].maxError - error, 0.0f), &levelError);
+        // A level that barely differs from its parent costs memory without saving any work
+        if (levelCount == 0 || levelCount * 20 > source.size() * 19) {
+            break;
+        }
+        error += levelError;
+        lods.push_back({static_cast<uint32_t>(indexCount + lodIndices.size()), static_cast<uint32_t>(levelCount),
+                        error * extent, 0});
+        lodIndices.insert(lodIndices.end(), level.begin(), level.begin() + levelCount);
+        source.assign(level.begin(), level.begin() + levelCount);
+    }
+    return lods;
+}
+
+size_t selectMeshLod(const float* lodErrors, size_t lodCount, float distance, float objectToWorldScale, float fovY,
+                     float viewportHeight, float maxPixelError) {
+    // Screen pixels covered by one world unit at this distance
+    float pixelsPerUnit = viewportHeight / (2.0f * std::max(distance, 1e-4f) * std::tan(fovY * 0.5f));
+    for (size_t i = lodCount; i-- > 1;) {
+        if (lodErrors[i] * objectToWorldScale * pixelsPerUnit <= maxPixelError) {
+            return i;
+        }
+    }
+    return 0;
+}
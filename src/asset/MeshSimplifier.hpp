@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Quadric error edge-collapse simplification (Garland & Heckbert 1997) for building discrete LODs.
+// Works on the index buffer only: every collapse moves a vertex onto one of its neighbours, so all
+// levels share the original vertex buffer. Vertices that share a position but not their attributes
+// (UV or normal seams) are collapsed together along the seam or not at all, and open borders only
+// collapse along themselves, so no level tears the surface or smears attributes across a seam.
+
+// Simplifies towards targetIndexCount, stopping early once the next collapse would exceed targetError.
+// Errors are relative to the mesh extent (largest side of the bounding box): 0.01 is 1% of the mesh
+// size. Writes at most indexCount indices to destination (which may alias indices) and returns how many
+// were written; resultError receives the error actually reached, in the same relative units.
+size_t simplifyMesh(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions,
+                    size_t vertexCount, size_t positionStride, size_t targetIndexCount, float targetError,
+                    float* resultError = nullptr);
+
+// Per-level targets for buildMeshLods
+struct MeshLodTarget {
+    float indexRatio; // Fraction of the LOD0 index count to aim for
+    float maxError; // Relative to the mesh extent, as in simplifyMesh
+};
+
+// One level of detail: a range of the mesh index buffer
+struct MeshLod {
+    uint32_t indexOffset; // First index; LOD0 starts at 0 and coarser levels follow it in the index buffer
+    uint32_t indexCount;
+    float error; // Object-space geometric deviation from LOD0
+    uint32_t padding;
+};
+
+// Builds the LOD chain, each level simplified from the previous one (errors accumulate along the chain).
+// Returns LOD0 (the input indices) followed by the generated levels, whose indices are appended to
+// lodIndices; offsets assume lodIndices is placed right after the indexCount LOD0 indices. Stops early
+// when a level no longer reduces the triangle count meaningfully.
+std::vector<MeshLod> buildMeshLods(std::vector<uint32_t>& lodIndices, const uint32_t* indices, size_t indexCount,
+                                   const float* positions, size_t vertexCount, size_t positionStride,
+                                   const MeshLodTarget* targets, size_t targetCount);
+
+// Coarsest level whose error, projected at this distance, stays within maxPixelError pixels. lodErrors
+// holds the object-space error of each level (LOD0 first); fovY is the vertical field of view in radians
+// and objectToWorldScale converts the errors to world units.
+size_t selectMeshLod(const float* lodErrors, size_t lodCount, float distance, float objectToWorldScale, float fovY,
+                     float viewportHeight, float maxPixelError);
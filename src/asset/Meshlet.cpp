@@ -0,0 +1,241 @@
+#include "Meshlet.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "MeshOptimizer.hpp"
+
+namespace {
+    constexpr uint8_t kNotInMeshlet = 0xFF;
+
+    glm::vec3 loadPosition(const float* positions, size_t positionStride, uint32_t vertex) {
+        glm::vec3 position;
+        memcpy(&position, reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride, sizeof(position));
+        return position;
+    }
+
+    MeshletBounds computeBounds(const MeshletData& data, const Meshlet& meshlet, const float* positions,
+                                size_t positionStride) {
+        MeshletBounds bounds = {};
+        bounds.aabbMin = glm::vec3(FLT_MAX);
+        bounds.aabbMax = glm::vec3(-FLT_MAX);
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            glm::vec3 p = loadPosition(positions, positionStride, data.vertices[meshlet.vertexOffset + i]);
+            bounds.aabbMin = glm::min(bounds.aabbMin, p);
+            bounds.aabbMax = glm::max(bounds.aabbMax, p);
+        }
+        bounds.center = (bounds.aabbMin + bounds.aabbMax) * 0.5f;
+        float radiusSquared = 0.0f;
+        for (uint32_t i = 0; i < meshlet.vertexCount; ++i) {
+            glm::vec3 d = loadPosition(positions, positionStride, data.vertices[meshlet.vertexOffset + i]) -
+                          bounds.center;
+            radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+        }
+        bounds.radius = std::sqrt(radiusSquared);
+
+        // Normal cone from the geometric (winding) normals, which is what backface culling tests
+        glm::vec3 normals[kMeshletMaxTriangles];
+        size_t normalCount = 0;
+        glm::vec3 axis(0.0f);
+        for (uint32_t t = 0; t < meshlet.triangleCount && normalCount < kMeshletMaxTriangles; ++t) {
+            const uint8_t* triangle = &data.triangles[(meshlet.triangleOffset + t) * 3];
+            glm::vec3 p0 = loadPosition(positions, positionStride, data.vertices[meshlet.vertexOffset + triangle[0]]);
+            glm::vec3 p1 = loadPosition(positions, positionStride, data.vertices[meshlet.vertexOffset + triangle[1]]);
+            glm::vec3 p2 = loadPosition(positions, positionStride, data.vertices[meshlet.vertexOffset + triangle[2]]);
+            glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            float length = glm::length(n);
+            if (length <= 0.0f || !std::isfinite(length)) {
+                continue; // Degenerate triangles never rasterize, so they do not constrain the cone
+            }
+            normals[normalCount++] = n / length;
+            axis += n / length;
+        }
+        float axisLength = glm::length(axis);
+        if (normalCount == 0 || axisLength < 1e-6f) {
+            bounds.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+            bounds.coneCutoff = -1.0f;
+            return bounds;
+        }
+        bounds.coneAxis = axis / axisLength;
+        bounds.coneCutoff = 1.0f;
+        for (size_t i = 0; i < normalCount; ++i) {
+            bounds.coneCutoff = std::min(bounds.coneCutoff, glm::dot(bounds.coneAxis, normals[i]));
+        }
+        return bounds;
+    }
+}
+
+MeshletData buildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+                          size_t positionStride, size_t maxVertices, size_t maxTriangles) {
+    MeshletData data;
+    const size_t triangleCount = indexCount / 3;
+    maxVertices = std::min(std::max<size_t>(maxVertices, 3), size_t(kNotInMeshlet));
+    maxTriangles = std::min(std::max<size_t>(maxTriangles, 1), kMeshletMaxTriangles);
+    if (triangleCount == 0 || vertexCount == 0) {
+        return data;
+    }
+
+    TriangleAdjacency adjacency;
+    buildTriangleAdjacency(adjacency, indices, triangleCount * 3, vertexCount);
+    std::vector<uint32_t> liveTriangles(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+    }
+    std::vector<uint8_t> emitted(triangleCount, 0);
+    std::vector<uint8_t> localIndex(vertexCount, kNotInMeshlet);
+    data.triangles.reserve(triangleCount * 3);
+
+    Meshlet current = {};
+    size_t seedCursor = 0;
+    uint32_t lastTriangle = ~0u;
+
+    auto flush = [&]() {
+        if (current.triangleCount == 0) {
+            return;
+        }
+        for (uint32_t i = 0; i < current.vertexCount; ++i) {
+            localIndex[data.vertices[current.vertexOffset + i]] = kNotInMeshlet;
+        }
+        data.meshlets.push_back(current);
+        data.bounds.push_back(computeBounds(data, current, positions, positionStride));
+        current.vertexOffset = static_cast<uint32_t>(data.vertices.size());
+        current.triangleOffset += current.triangleCount;
+        current.vertexCount = 0;
+        current.triangleCount = 0;
+    };
+
+    // Lowest cost unemitted triangle around the given vertices that still fits: fewest new vertices first,
+    // then fewest remaining neighbours (finishes borders instead of leaving slivers behind)
+    auto findCandidate = [&](const uint32_t* vertices, size_t count) {
+        uint32_t best = ~0u;
+        uint32_t bestNew = 4;
+        uint32_t bestLive = ~0u;
+        for (size_t i = 0; i < count; ++i) {
+            uint32_t v = vertices[i];
+            for (uint32_t a = adjacency.offsets[v]; a < adjacency.offsets[v + 1]; ++a) {
+                uint32_t t = adjacency.triangles[a];
+                if (emitted[t]) {
+                    continue;
+                }
+                const uint32_t* triangle = &indices[t * 3];
+                uint32_t newVertices = (localIndex[triangle[0]] == kNotInMeshlet) +
+                                       (localIndex[triangle[1]] == kNotInMeshlet) +
+                                       (localIndex[triangle[2]] == kNotInMeshlet);
+                if (current.vertexCount + newVertices > maxVertices) {
+                    continue;
+                }
+                uint32_t live = liveTriangles[triangle[0]] + liveTriangles[triangle[1]] + liveTriangles[triangle[2]];
+                if (newVertices < bestNew || (newVertices == bestNew && live < bestLive)) {
+                    best = t;
+                    bestNew = newVertices;
+                    bestLive = live;
+                }
+            }
+        }
+        return best;
+    };
+
+    size_t emittedCount = 0;
+    while (emittedCount < triangleCount) {
+        if (current.triangleCount == maxTriangles) {
+            flush();
+        }
+        uint32_t next = ~0u;
+        if (lastTriangle != ~0u) {
+            // Grow around the most recent triangle first, then anywhere along the meshlet. Right after a
+            // flush this seeds the new meshlet next to the previous one.
+            next = findCandidate(&indices[lastTriangle * 3], 3);
+            if (next == ~0u) {
+                next = findCandidate(data.vertices.data() + current.vertexOffset, current.vertexCount);
+            }
+            if (next == ~0u) {
+                flush();
+            }
+        }
+        if (next == ~0u) {
+            while (emitted[seedCursor]) {
+                seedCursor++;
+            }
+            next = static_cast<uint32_t>(seedCursor);
+        }
+
+        const uint32_t* triangle = &indices[next * 3];
+        for (int k = 0; k < 3; ++k) {
+            uint32_t v = triangle[k];
+            if (localIndex[v] == kNotInMeshlet) {
+                localIndex[v] = static_cast<uint8_t>(current.vertexCount++);
+                data.vertices.push_back(v);
+            }
+            data.triangles.push_back(localIndex[v]);
+            liveTriangles[v]--;
+        }
+        current.triangleCount++;
+        emitted[next] = 1;
+        emittedCount++;
+        lastTriangle = next;
+    }
+    flush();
+    return data;
+}
+
+void writeMeshletIndices(uint32_t* destination, const MeshletData& meshlets) {
+    for (const Meshlet& meshlet : meshlets.meshlets) {
+        const uint8_t* triangles = &meshlets.triangles[size_t(meshlet.triangleOffset) * 3];
+        uint32_t* out = destination + size_t(meshlet.triangleOffset) * 3;
+        for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+            out[i] = meshlets.vertices[meshlet.vertexOffset + triangles[i]];
+        }
+    }
+}
+
+MeshletCullView makeMeshletCullView(const glm::mat4& viewProjection, const glm::mat4& world,
+                                    const glm::vec3& cameraPosition) {
+    MeshletCullView view;
+    // Gribb/Hartmann: planes of the object-space frustum are sums/differences of the matrix rows
+    const glm::mat4 m = glm::transpose(viewProjection * world); // m[i] is row i
+    view.planes[0] = m[3] + m[0]; // Left
+    view.planes[1] = m[3] - m[0]; // Right
+    view.planes[2] = m[3] + m[1]; // Bottom
+    view.planes[3] = m[3] - m[1]; // Top
+    view.planes[4] = m[3] + m[2]; // Near (-w <= z)
+    view.planes[5] = m[3] - m[2]; // Far
+    for (glm::vec4& plane : view.planes) {
+        float length = glm::length(glm::vec3(plane));
+        plane = length > 0.0f ? plane / length : plane;
+    }
+    view.cameraPosition = glm::vec3(glm::inverse(world) * glm::vec4(cameraPosition, 1.0f));
+    return view;
+}
+
+size_t cullMeshlets(uint32_t* visibleMeshlets, const MeshletBounds* bounds, size_t meshletCount,
+                    const MeshletCullView& view) {
+    size_t visibleCount = 0;
+    for (size_t i = 0; i < meshletCount; ++i) {
+        const MeshletBounds& b = bounds[i];
+        bool inside = true;
+        for (const glm::vec4& plane : view.planes) {
+            inside = inside && glm::dot(glm::vec3(plane), b.center) + plane.w >= -b.radius;
+        }
+        if (!inside) {
+            continue;
+        }
+        // Every triangle faces away if, for any normal n within the cone and any point p in the sphere,
+        // dot(n, p - eye) > 0. The worst case over the cone is cos(angle(axis, center - eye) + halfAngle).
+        if (b.coneCutoff > 0.0f) {
+            glm::vec3 toCenter = b.center - view.cameraPosition;
+            float distance = glm::length(toCenter);
+            if (distance > b.radius) {
+                float cosTheta = glm::dot(toCenter, b.coneAxis) / distance;
+                float sinTheta = std::sqrt(std::max(0.0f, 1.0f - cosTheta * cosTheta));
+                float sinAlpha = std::sqrt(std::max(0.0f, 1.0f - b.coneCutoff * b.coneCutoff));
+                if (cosTheta * b.coneCutoff - sinTheta * sinAlpha > b.radius / distance) {
+                    continue;
+                }
+            }
+        }
+        visibleMeshlets[visibleCount++] = static_cast<uint32_t>(i);
+    }
+    return visibleCount;
+}
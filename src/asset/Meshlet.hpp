@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// Meshlets: small clusters of triangles with their own vertex list, sized for mesh shaders
+// (64 vertices / 124 triangles fit the usual output limits) and for per-cluster culling.
+
+constexpr size_t kMeshletMaxVertices = 64;
+constexpr size_t kMeshletMaxTriangles = 124;
+
+// GPU-visible (StructuredBuffer) layout
+struct Meshlet {
+    uint32_t vertexOffset; // First entry in MeshletData::vertices
+    uint32_t triangleOffset; // First triangle in MeshletData::triangles, and in the mesh index buffer (x3)
+    uint32_t vertexCount;
+    uint32_t triangleCount;
+};
+
+// GPU-visible (StructuredBuffer) layout, object space
+struct MeshletBounds {
+    glm::vec3 center; // Bounding sphere
+    float radius;
+    glm::vec3 coneAxis; // Average facing direction of the triangles
+    float coneCutoff; // cos of the normal cone half-angle; <= 0 means the cone can never be backfacing
+    glm::vec3 aabbMin;
+    float padding0;
+    glm::vec3 aabbMax;
+    float padding1;
+};
+
+struct MeshletData {
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds; // One per meshlet
+    std::vector<uint32_t> vertices; // Meshlet-local vertex -> mesh vertex
+    std::vector<uint8_t> triangles; // 3 meshlet-local vertex indices per triangle
+};
+
+// Partitions an indexed triangle list into meshlets, growing each one across shared edges and starting
+// new ones in index order (so the input is best already optimized for the vertex cache). Meshlet
+// triangles are stored in the order they were added; writeMeshletIndices turns that into an index buffer
+// where every meshlet is one contiguous range.
+MeshletData buildMeshlets(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount,
+                          size_t positionStride, size_t maxVertices = kMeshletMaxVertices,
+                          size_t maxTriangles = kMeshletMaxTriangles);
+
+// destination must hold meshlets.triangles.size() indices (the original index count)
+void writeMeshletIndices(uint32_t* destination, const MeshletData& meshlets);
+
+// Object-space culling inputs: normalized frustum planes (inside: dot(xyz, p) + w >= 0) and the eye
+struct MeshletCullView {
+    glm::vec4 planes[6];
+    glm::vec3 cameraPosition;
+};
+
+// The planes are taken with a [-w, w] clip depth range, a superset of the D3D [0, w] range, so no
+// visible cluster is ever rejected whichever convention the projection uses
+MeshletCullView makeMeshletCullView(const glm::mat4& viewProjection, const glm::mat4& world,
+                                    const glm::vec3& cameraPosition);
+
+// Frustum test on the bounding sphere plus a conservative normal cone backface test. Writes the indices
+// of the surviving meshlets in ascending order and returns how many there are.
+size_t cullMeshlets(uint32_t* visibleMeshlets, const MeshletBounds* bounds, size_t meshletCount,
+                    const MeshletCullView& view);
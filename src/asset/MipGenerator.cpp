@@ -0,0 +1,387 @@
+#include "MipGenerator.hpp"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "TextureImport.hpp"
+#include "core/JobSystem.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIP_GENERATOR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if !MIP_GENERATOR_SSE2 && (defined(__aarch64__) || defined(_M_ARM64))
+#define MIP_GENERATOR_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+    constexpr double kPi = 3.14159265358979323846;
+    constexpr double kWindowRadius = 3.0; // Lobes of the windowed sinc filters, in parent texels at scale 1
+    constexpr double kKaiserAlpha = 4.0;
+    constexpr size_t kTexelsPerJob = 16 * 1024; // Rows are grouped so a job filters at least this many texels
+
+    // --- RGBA float vectors: one texel per register ---
+
+#if MIP_GENERATOR_SSE2
+    using Float4 = __m128;
+
+    inline Float4 load4(const float* p) {
+        return _mm_loadu_ps(p);
+    }
+
+    inline void store4(float* p, Float4 v) {
+        _mm_storeu_ps(p, v);
+    }
+
+    inline Float4 zero4() {
+        return _mm_setzero_ps();
+    }
+
+    inline Float4 mulAdd4(Float4 acc, Float4 v, float weight) {
+        return _mm_add_ps(acc, _mm_mul_ps(v, _mm_set1_ps(weight)));
+    }
+
+    // Clamps to [0, 1], scales and rounds to integers
+    inline void quantize4(Float4 v, Float4 scale, int32_t* out) {
+        v = _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale),
+                                                                                      _mm_set1_ps(0.5f))));
+    }
+#elif MIP_GENERATOR_NEON
+    using Float4 = float32x4_t;
+
+    inline Float4 load4(const float* p) {
+        return vld1q_f32(p);
+    }
+
+    inline void store4(float* p, Float4 v) {
+        vst1q_f32(p, v);
+    }
+
+    inline Float4 zero4() {
+        return vdupq_n_f32(0.0f);
+    }
+
+    inline Float4 mulAdd4(Float4 acc, Float4 v, float weight) {
+        return vmlaq_n_f32(acc, v, weight);
+    }
+
+    inline void quantize4(Float4 v, Float4 scale, int32_t* out) {
+        v = vminq_f32(vmaxq_f32(v, vdupq_n_f32(0.0f)), vdupq_n_f32(1.0f));
+        vst1q_s32(out, vcvtq_s32_f32(vmlaq_f32(vdupq_n_f32(0.5f), v, scale)));
+    }
+#else
+    struct Float4 {
+        float v[4];
+    };
+
+    inline Float4 load4(const float* p) {
+        return {{p[0], p[1], p[2], p[3]}};
+    }
+
+    inline void store4(float* p, Float4 v) {
+        memcpy(p, v.v, sizeof(v.v));
+    }
+
+    inline Float4 zero4() {
+        return {{0.0f, 0.0f, 0.0f, 0.0f}};
+    }
+
+    inline Float4 mulAdd4(Float4 acc, Float4 v, float weight) {
+        for (int i = 0; i < 4; i++) {
+            acc.v[i] += v.v[i] * weight;
+        }
+        return acc;
+    }
+
+    inline void quantize4(Float4 v, Float4 scale, int32_t* out) {
+        for (int i = 0; i < 4; i++) {
+            out[i] = static_cast<int32_t>(std::clamp(v.v[i], 0.0f, 1.0f) * scale.v[i] + 0.5f);
+        }
+    }
+#endif
+
+    // --- Filter kernels ---
+
+    double sinc(double x) {
+        return x == 0.0 ? 1.0 : std::sin(kPi * x) / (kPi * x);
+    }
+
+    // Modified Bessel function of the first kind, order 0 (power series; converges fast for the alphas used)
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 32 && term > 1e-12 * sum; k++) {
+            term *= (x * x / 4.0) / (double(k) * k);
+            sum += term;
+        }
+        return sum;
+    }
+
+    double evaluateKernel(MipFilter filter, double x) {
+        const double t = x / kWindowRadius;
+        if (t <= -1.0 || t >= 1.0) {
+            return 0.0;
+        }
+        if (filter == MipFilter::Kaiser) {
+            return sinc(x) * besselI0(kKaiserAlpha * std::sqrt(1.0 - t * t)) / besselI0(kKaiserAlpha);
+        }
+        return sinc(x) * sinc(t); // Lanczos
+    }
+
+    // Contributions of the parent texels to every child texel along one axis, normalized to sum to 1. Tap
+    // ranges are stored back to back: child i uses taps [first[i], first[i + 1]).
+    struct FilterTaps {
+        std::vector<uint32_t> first;
+        std::vector<uint32_t> indices;
+        std::vector<float> weights;
+    };
+
+    void addTap(FilterTaps& taps, size_t childFirst, uint32_t index, double weight) {
+        // Wide kernels wrap several times around tiny levels: merge the repeats
+        for (size_t t = childFirst; t < taps.indices.size(); t++) {
+            if (taps.indices[t] == index) {
+                taps.weights[t] += static_cast<float>(weight);
+                return;
+            }
+        }
+        taps.indices.push_back(index);
+        taps.weights.push_back(static_cast<float>(weight));
+    }
+
+    FilterTaps computeFilterTaps(uint32_t srcSize, uint32_t dstSize, MipFilter filter) {
+        FilterTaps taps;
+        taps.first.reserve(dstSize + 1);
+        const double scale = double(srcSize) / dstSize;
+        for (uint32_t i = 0; i < dstSize; i++) {
+            const size_t childFirst = taps.indices.size();
+            taps.first.push_back(static_cast<uint32_t>(childFirst));
+            if (filter == MipFilter::Box) {
+                // Exact overlap of each parent texel with the child's footprint [i * scale, (i + 1) * scale)
+                const double begin = i * scale;
+                const double end = (i + 1) * scale;
+                for (int64_t j = int64_t(std::floor(begin)); double(j) < end; j++) {
+                    const double overlap = std::min(end, double(j + 1)) - std::max(begin, double(j));
+                    if (overlap > 1e-9) {
+                        addTap(taps, childFirst, static_cast<uint32_t>(j), overlap);
+                    }
+                }
+            } else {
+                // Kernel stretched by the scale and sampled at the parent texel centers
+                const double center = (i + 0.5) * scale;
+                const double radius = kWindowRadius * scale;
+                const int64_t firstTexel = int64_t(std::ceil(center - radius - 0.5));
+                const int64_t lastTexel = int64_t(std::floor(center + radius - 0.5));
+                for (int64_t j = firstTexel; j <= lastTexel; j++) {
+                    const double weight = evaluateKernel(filter, (j + 0.5 - center) / scale);
+                    if (weight != 0.0) {
+                        const int64_t wrapped = ((j % int64_t(srcSize)) + srcSize) % srcSize;
+                        addTap(taps, childFirst, static_cast<uint32_t>(wrapped), weight);
+                    }
+                }
+            }
+            double sum = 0.0;
+            for (size_t t = childFirst; t < taps.weights.size(); t++) {
+                sum += taps.weights[t];
+            }
+            for (size_t t = childFirst; t < taps.weights.size(); t++) {
+                taps.weights[t] = static_cast<float>(taps.weights[t] / sum);
+            }
+        }
+        taps.first.push_back(static_cast<uint32_t>(taps.indices.size()));
+        return taps;
+    }
+
+    size_t getRowGrain(uint32_t width) {
+        return std::max<size_t>(1, kTexelsPerJob / width);
+    }
+
+    // Filters every row of src (width srcWidth) into dst (width taps.first.size() - 1)
+    void filterRows(const float* src, uint32_t srcWidth, float* dst, uint32_t rowCount, const FilterTaps& taps,
+                    JobSystem* jobSystem) {
+        const uint32_t dstWidth = static_cast<uint32_t>(taps.first.size() - 1);
+        parallelFor(jobSystem, rowCount, getRowGrain(srcWidth), [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; y++) {
+                const float* srcRow = src + y * srcWidth * 4;
+                float* dstRow = dst + y * dstWidth * 4;
+                for (uint32_t x = 0; x < dstWidth; x++) {
+                    Float4 sum = zero4();
+                    for (uint32_t t = taps.first[x]; t < taps.first[x + 1]; t++) {
+                        sum = mulAdd4(sum, load4(srcRow + size_t(taps.indices[t]) * 4), taps.weights[t]);
+                    }
+                    store4(dstRow + size_t(x) * 4, sum);
+                }
+            }
+        });
+    }
+
+    // Filters the columns of src (height srcHeight) into the rows of dst: every child row is a weighted sum
+    // of whole parent rows, so the inner loop streams through contiguous memory
+    void filterColumns(const float* src, uint32_t width, float* dst, const FilterTaps& taps, JobSystem* jobSystem) {
+        const size_t rowFloats = size_t(width) * 4;
+        const size_t dstHeight = taps.first.size() - 1;
+        parallelFor(jobSystem, dstHeight, getRowGrain(width), [&](size_t begin, size_t end) {
+            for (size_t y = begin; y < end; y++) {
+                float* dstRow = dst + y * rowFloats;
+                for (size_t x = 0; x < rowFloats; x += 4) {
+                    store4(dstRow + x, zero4());
+                }
+                for (uint32_t t = taps.first[y]; t < taps.first[y + 1]; t++) {
+                    const float* srcRow = src + size_t(taps.indices[t]) * rowFloats;
+                    const float weight = taps.weights[t];
+                    for (size_t x = 0; x < rowFloats; x += 4) {
+                        store4(dstRow + x, mulAdd4(load4(dstRow + x), load4(srcRow + x), weight));
+                    }
+                }
+            }
+        });
+    }
+
+    // --- sRGB conversions ---
+
+    constexpr size_t kLinearTableSize = 65536; // Fine enough that the steep start of the sRGB curve rounds right
+
+    double srgbToLinear(double c) {
+        return c <= 0.04045 ? c / 12.92 : std::pow((c + 0.055) / 1.055, 2.4);
+    }
+
+    double linearToSrgb(double c) {
+        return c <= 0.0031308 ? c * 12.92 : 1.055 * std::pow(c, 1.0 / 2.4) - 0.055;
+    }
+
+    // 8-bit value -> float, decoded from sRGB or not
+    const std::array<float, 256>& getUnormTable(bool srgb) {
+        static const std::array<float, 256> srgbTable = [] {
+            std::array<float, 256> values;
+            for (size_t i = 0; i < values.size(); i++) {
+                values[i] = static_cast<float>(srgbToLinear(i / 255.0));
+            }
+            return values;
+        }();
+        static const std::array<float, 256> linearTable = [] {
+            std::array<float, 256> values;
+            for (size_t i = 0; i < values.size(); i++) {
+                values[i] = static_cast<float>(i / 255.0);
+            }
+            return values;
+        }();
+        return srgb ? srgbTable : linearTable;
+    }
+
+    const std::vector<uint8_t>& getLinearToSrgbTable() {
+        static const std::vector<uint8_t> table = [] {
+            std::vector<uint8_t> values(kLinearTableSize);
+            for (size_t i = 0; i < values.size(); i++) {
+                const double srgb = linearToSrgb(double(i) / (kLinearTableSize - 1));
+                values[i] = static_cast<uint8_t>(std::lround(srgb * 255.0));
+            }
+            return values;
+        }();
+        return table;
+    }
+
+    void convertToFloat(const uint8_t* pixels, size_t texelCount, bool srgb, float* dst) {
+        const std::array<float, 256>& color = getUnormTable(srgb);
+        const std::array<float, 256>& alpha = getUnormTable(false);
+        for (size_t i = 0; i < texelCount * 4; i += 4) {
+            dst[i] = color[pixels[i]];
+            dst[i + 1] = color[pixels[i + 1]];
+            dst[i + 2] = color[pixels[i + 2]];
+            dst[i + 3] = alpha[pixels[i + 3]];
+        }
+    }
+
+    // Clamped first: sinc filters ring past the input range
+    void convertToPixels(const float* src, size_t texelCount, bool srgb, uint8_t* dst) {
+        alignas(16) int32_t values[4];
+        if (!srgb) {
+            const Float4 scale = load4(std::array<float, 4>{255.0f, 255.0f, 255.0f, 255.0f}.data());
+            for (size_t i = 0; i < texelCount * 4; i += 4) {
+                quantize4(load4(src + i), scale, values);
+                for (int c = 0; c < 4; c++) {
+                    dst[i + c] = static_cast<uint8_t>(values[c]);
+                }
+            }
+            return;
+        }
+        const std::vector<uint8_t>& toSrgb = getLinearToSrgbTable();
+        const float colorScale = float(kLinearTableSize - 1);
+        const Float4 scale = load4(std::array<float, 4>{colorScale, colorScale, colorScale, 255.0f}.data());
+        for (size_t i = 0; i < texelCount * 4; i += 4) {
+            quantize4(load4(src + i), scale, values);
+            dst[i] = toSrgb[values[0]];
+            dst[i + 1] = toSrgb[values[1]];
+            dst[i + 2] = toSrgb[values[2]];
+            dst[i + 3] = static_cast<uint8_t>(values[3]);
+        }
+    }
+}
+
+uint32_t getMipCount(uint32_t width, uint32_t height) {
+    uint32_t count = 1;
+    while ((width | height) >> count) {
+        count++;
+    }
+    return count;
+}
+
+size_t getMipChainSize(uint32_t width, uint32_t height, uint32_t mipCount) {
+    size_t size = 0;
+    for (uint32_t level = 0; level < mipCount; level++) {
+        size += size_t(getMipSize(width, level)) * getMipSize(height, level) * 4;
+    }
+    return size;
+}
+
+void resampleImage(const float* src, uint32_t srcWidth, uint32_t srcHeight, float* dst, uint32_t dstWidth,
+                   uint32_t dstHeight, MipFilter filter, JobSystem* jobSystem) {
+    // Horizontal first: the intermediate image is then as small as the reduction allows
+    std::vector<float> rows;
+    const float* filtered = src;
+    if (dstWidth != srcWidth) {
+        rows.resize(size_t(dstWidth) * srcHeight * 4);
+        filterRows(src, srcWidth, rows.data(), srcHeight, computeFilterTaps(srcWidth, dstWidth, filter), jobSystem);
+        filtered = rows.data();
+    }
+    if (dstHeight != srcHeight) {
+        filterColumns(filtered, dstWidth, dst, computeFilterTaps(srcHeight, dstHeight, filter), jobSystem);
+    } else {
+        memcpy(dst, filtered, size_t(dstWidth) * dstHeight * 4 * sizeof(float));
+    }
+}
+
+void generateMips(TextureImage& image, const MipOptions& options, JobSystem* jobSystem) {
+    const uint32_t mipCount = getMipCount(image.width, image.height);
+    const size_t baseSize = size_t(image.width) * image.height * 4;
+    image.pixels.resize(getMipChainSize(image.width, image.height, mipCount));
+    image.mipCount = mipCount;
+
+    // Each level is filtered from the previous one in float, so only the stored levels are quantized
+    std::vector<float> parent(baseSize);
+    std::vector<float> child;
+    parallelFor(jobSystem, image.height, getRowGrain(image.width), [&](size_t begin, size_t end) {
+        const size_t offset = begin * image.width * 4;
+        convertToFloat(image.pixels.data() + offset, (end - begin) * image.width, options.srgb,
+                       parent.data() + offset);
+    });
+    for (uint32_t level = 1; level < mipCount; level++) {
+        const uint32_t parentWidth = getMipSize(image.width, level - 1);
+        const uint32_t parentHeight = getMipSize(image.height, level - 1);
+        const uint32_t width = getMipSize(image.width, level);
+        const uint32_t height = getMipSize(image.height, level);
+        child.resize(size_t(width) * height * 4);
+        resampleImage(parent.data(), parentWidth, parentHeight, child.data(), width, height, options.filter,
+                      jobSystem);
+
+        uint8_t* pixels = image.pixels.data() + getMipOffset(image.width, image.height, level);
+        parallelFor(jobSystem, height, getRowGrain(width), [&](size_t begin, size_t end) {
+            const size_t offset = begin * width * 4;
+            convertToPixels(child.data() + offset, (end - begin) * width, options.srgb, pixels + offset);
+        });
+        std::swap(parent, child);
+    }
+}
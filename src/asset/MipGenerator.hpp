@@ -0,0 +1,49 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+class JobSystem;
+struct TextureImage;
+
+// CPU mip chain generation for RGBA8 textures. Every level is resampled from the previous one with a
+// separable filter in linear float: color channels are converted from sRGB first, so averaging does not
+// darken the image, and quantized back once per level. Sizes that are not powers of two halve with rounding
+// down (the D3D convention), so a level may be a 3:1 or 2.5:1 reduction of its parent; the filter weights are
+// computed for the actual ratio and centered on the child texel. Edges wrap, like the samplers of both
+// renderers, so tiling textures stay seamless at every level.
+
+enum class MipFilter : uint32_t {
+    Box, // Area average of the parent texels: cheap, a little blurry and prone to aliasing
+    Kaiser, // Kaiser-windowed sinc (3 lobes): sharp, little aliasing; the default, as in NVTT
+    Lanczos, // Lanczos-3: sharper still, with slightly more ringing
+};
+
+struct MipOptions {
+    MipFilter filter = MipFilter::Kaiser;
+    bool srgb = true; // Filter the color channels in linear light; alpha is always linear
+};
+
+// Levels of a full chain, down to 1x1
+uint32_t getMipCount(uint32_t width, uint32_t height);
+
+inline uint32_t getMipSize(uint32_t size, uint32_t level) {
+    return std::max(size >> level, 1u);
+}
+
+// Bytes of the first mipCount levels of an RGBA8 chain, stored back to back from level 0
+size_t getMipChainSize(uint32_t width, uint32_t height, uint32_t mipCount);
+
+// Byte offset of a level in such a chain
+inline size_t getMipOffset(uint32_t width, uint32_t height, uint32_t level) {
+    return getMipChainSize(width, height, level);
+}
+
+// Replaces the levels below 0 with a full chain filtered from level 0. Rows are filtered in parallel on the
+// job system (serially without one).
+void generateMips(TextureImage& image, const MipOptions& options, JobSystem* jobSystem = nullptr);
+
+// One filtering step on linear RGBA float texels, exposed for tests and benchmarks: resamples a
+// srcWidth x srcHeight image to dstWidth x dstHeight (each at most the source size) into dst
+void resampleImage(const float* src, uint32_t srcWidth, uint32_t srcHeight, float* dst, uint32_t dstWidth,
+                   uint32_t dstHeight, MipFilter filter, JobSystem* jobSystem = nullptr);
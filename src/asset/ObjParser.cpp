@@ -0,0 +1,668 @@
+#include "ObjParser.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+
+#include "VirtualFileSystem.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    // Face corner as written in the file. Indices are zero-based; a corner whose bit is set in
+    // relativeMask came from a negative OBJ index and is still relative to the start of its chunk.
+    struct RawCorner {
+        int32_t position;
+        int32_t texCoord;
+        int32_t normal;
+        uint32_t relativeMask;
+    };
+
+    constexpr uint32_t kRelativePosition = 1u << 0;
+    constexpr uint32_t kRelativeTexCoord = 1u << 1;
+    constexpr uint32_t kRelativeNormal = 1u << 2;
+
+    // "o"/"g", "usemtl" or "mtllib" statement, applying from face `face` of its chunk on
+    struct ObjMarker {
+        enum class Type : uint8_t {
+            Group,
+            Material,
+            Library,
+        };
+
+        size_t face;
+        Type type;
+        std::string name;
+    };
+
+    struct ObjChunk {
+        const char* begin = nullptr;
+        const char* end = nullptr;
+        std::vector<float> positions;
+        std::vector<float> texCoords;
+        std::vector<float> normals;
+        std::vector<RawCorner> corners; // Polygon corners, faceSizes[i] per face
+        std::vector<uint32_t> faceSizes;
+        std::vector<ObjMarker> markers;
+        size_t triangleCount = 0;
+        std::string error;
+
+        // Filled during stitching
+        size_t positionBase = 0;
+        size_t texCoordBase = 0;
+        size_t normalBase = 0;
+        size_t triangleBase = 0;
+    };
+
+    // One call per chunk: as jobs when there is a job system, otherwise on a thread each
+    template<typename Fn>
+    void runParallel(JobSystem* jobSystem, size_t count, Fn&& fn) {
+        if (jobSystem) {
+            jobSystem->parallelFor(count, 1, [&fn](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    fn(i);
+                }
+            });
+            return;
+        }
+        if (count <= 1) {
+            if (count == 1) fn(0);
+            return;
+        }
+        std::vector<std::thread> threads;
+        threads.reserve(count - 1);
+        for (size_t i = 1; i < count; ++i) {
+            threads.emplace_back([&fn, i]() { fn(i); });
+        }
+        fn(0); // Calling thread takes the first chunk
+        for (auto& thread: threads) {
+            thread.join();
+        }
+    }
+
+    inline bool isBlank(char c) {
+        return c == ' ' || c == '\t';
+    }
+
+    inline void skipBlanks(const char*& p, const char* end) {
+        while (p < end && isBlank(*p)) ++p;
+    }
+
+    bool parseFloat(const char*& p, const char* end, float& out) {
+        skipBlanks(p, end);
+        if (p < end && *p == '+') ++p; // from_chars does not accept a leading '+'
+        auto result = std::from_chars(p, end, out);
+        if (result.ec != std::errc()) {
+            return false;
+        }
+        p = result.ptr;
+        return true;
+    }
+
+    bool parseInt(const char*& p, const char* end, int32_t& out) {
+        bool negative = false;
+        if (p < end && (*p == '-' || *p == '+')) {
+            negative = *p == '-';
+            ++p;
+        }
+        if (p >= end || *p < '0' || *p > '9') {
+            return false;
+        }
+        int64_t value = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + (*p - '0');
+            if (value > INT32_MAX) return false;
+            ++p;
+        }
+        out = static_cast<int32_t>(negative ? -value : value);
+        return true;
+    }
+
+    // Converts a one-based (or negative, relative) OBJ index to a zero-based chunk index
+    bool resolveRaw(int32_t raw, size_t localCount, uint32_t relativeBit, int32_t& outIndex, uint32_t& mask) {
+        if (raw > 0) {
+            outIndex = raw - 1;
+            return true;
+        }
+        if (raw < 0) {
+            outIndex = static_cast<int32_t>(static_cast<int64_t>(localCount) + raw);
+            mask |= relativeBit;
+            return true;
+        }
+        return false; // Zero is not a valid OBJ index
+    }
+
+    // v, v/vt, v//vn or v/vt/vn
+    bool parseCorner(const char*& p, const char* end, const std::vector<float>& positions,
+                     const std::vector<float>& texCoords, const std::vector<float>& normals, RawCorner& outCorner) {
+        int32_t raw = 0;
+        outCorner = {-1, -1, -1, 0};
+        if (!parseInt(p, end, raw) ||
+            !resolveRaw(raw, positions.size() / 3, kRelativePosition, outCorner.position, outCorner.relativeMask)) {
+            return false;
+        }
+        if (p < end && *p == '/') {
+            ++p;
+            if (p < end && *p != '/') {
+                if (!parseInt(p, end, raw) ||
+                    !resolveRaw(raw, texCoords.size() / 2, kRelativeTexCoord, outCorner.texCoord,
+                                outCorner.relativeMask)) {
+                    return false;
+                }
+            }
+            if (p < end && *p == '/') {
+                ++p;
+                if (!parseInt(p, end, raw) ||
+                    !resolveRaw(raw, normals.size() / 3, kRelativeNormal, outCorner.normal,
+                                outCorner.relativeMask)) {
+                    return false;
+                }
+            }
+        }
+        return p >= end || isBlank(*p) || *p == '\r';
+    }
+
+    // Rest of the line without surrounding blanks, a trailing '\r' or a comment
+    std::string parseName(const char* p, const char* end) {
+        const char* comment = static_cast<const char*>(memchr(p, '#', end - p));
+        end = comment ? comment : end;
+        skipBlanks(p, end);
+        while (end > p && (isBlank(end[-1]) || end[-1] == '\r')) {
+            --end;
+        }
+        return std::string(p, end);
+    }
+
+    bool isKeyword(const char* p, const char* end, const char* keyword, size_t length) {
+        return size_t(end - p) > length && memcmp(p, keyword, length) == 0 && isBlank(p[length]);
+    }
+
+    // Parses the lines in [begin, end), appending attributes and polygon corners (faceSizes[i] per face).
+    // Relative corner indices resolve against the attribute counts at that point. Group and material
+    // statements go to markers unless it is null. Returns an error message, empty on success.
+    std::string parseLines(const char* begin, const char* end, std::vector<float>& positions,
+                           std::vector<float>& texCoords, std::vector<float>& normals,
+                           std::vector<RawCorner>& corners, std::vector<uint32_t>& faceSizes,
+                           std::vector<ObjMarker>* markers) {
+        const char* p = begin;
+        while (p < end) {
+            const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+            if (!lineEnd) lineEnd = end;
+            const char* lineStart = p;
+
+            skipBlanks(p, lineEnd);
+            bool ok = true;
+            if (lineEnd - p >= 2 && p[0] == 'v' && isBlank(p[1])) {
+                p += 2;
+                float x, y, z;
+                ok = parseFloat(p, lineEnd, x) && parseFloat(p, lineEnd, y) && parseFloat(p, lineEnd, z);
+                if (ok) {
+                    positions.insert(positions.end(), {x, y, z}); // Optional w / vertex color ignored
+                }
+            } else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && isBlank(p[2])) {
+                p += 3;
+                float u, v = 0.0f;
+                ok = parseFloat(p, lineEnd, u);
+                if (ok) {
+                    const char* save = p;
+                    if (!parseFloat(p, lineEnd, v)) {
+                        p = save;
+                        v = 0.0f;
+                    }
+                    texCoords.insert(texCoords.end(), {u, v});
+                }
+            } else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && isBlank(p[2])) {
+                p += 3;
+                float x, y, z;
+                ok = parseFloat(p, lineEnd, x) && parseFloat(p, lineEnd, y) && parseFloat(p, lineEnd, z);
+                if (ok) {
+                    normals.insert(normals.end(), {x, y, z});
+                }
+            } else if (lineEnd - p >= 2 && p[0] == 'f' && isBlank(p[1])) {
+                p += 2;
+                uint32_t faceSize = 0;
+                while (true) {
+                    skipBlanks(p, lineEnd);
+                    if (p >= lineEnd || *p == '\r' || *p == '#') break;
+                    RawCorner corner;
+                    if (!parseCorner(p, lineEnd, positions, texCoords, normals, corner)) {
+                        ok = false;
+                        break;
+                    }
+                    corners.push_back(corner);
+                    ++faceSize;
+                }
+                if (ok) {
+                    if (faceSize >= 3) {
+                        faceSizes.push_back(faceSize);
+                    } else {
+                        corners.resize(corners.size() - faceSize); // Degenerate face, skip
+                    }
+                }
+            } else if (markers && (isKeyword(p, lineEnd, "o", 1) || isKeyword(p, lineEnd, "g", 1))) {
+                markers->push_back({faceSizes.size(), ObjMarker::Type::Group, parseName(p + 2, lineEnd)});
+            } else if (markers && isKeyword(p, lineEnd, "usemtl", 6)) {
+                markers->push_back({faceSizes.size(), ObjMarker::Type::Material, parseName(p + 7, lineEnd)});
+            } else if (markers && isKeyword(p, lineEnd, "mtllib", 6)) {
+                markers->push_back({faceSizes.size(), ObjMarker::Type::Library, parseName(p + 7, lineEnd)});
+            }
+            // Everything else (comments, s, l, p) carries no geometry
+
+            if (!ok) {
+                const char* textEnd = (lineEnd > lineStart && lineEnd[-1] == '\r') ? lineEnd - 1 : lineEnd;
+                return "Malformed OBJ line: \"" + std::string(lineStart, textEnd) + "\"";
+            }
+            p = lineEnd + 1;
+        }
+        return {};
+    }
+
+    void parseChunk(ObjChunk& chunk) {
+        chunk.error = parseLines(chunk.begin, chunk.end, chunk.positions, chunk.texCoords, chunk.normals,
+                                 chunk.corners, chunk.faceSizes, &chunk.markers);
+        for (uint32_t faceSize: chunk.faceSizes) {
+            chunk.triangleCount += faceSize - 2;
+        }
+    }
+
+    const char* nextLineStart(const char* p, const char* begin, const char* end) {
+        if (p <= begin) return begin;
+        if (p >= end) return end;
+        const char* newline = static_cast<const char*>(memchr(p - 1, '\n', end - (p - 1)));
+        return newline ? newline + 1 : end;
+    }
+
+    bool resolveCorner(const RawCorner& raw, const ObjChunk& chunk, size_t positionCount, size_t texCoordCount,
+                       size_t normalCount, ObjIndex& outIndex) {
+        outIndex.position = raw.position + ((raw.relativeMask & kRelativePosition)
+                                                ? static_cast<int32_t>(chunk.positionBase) : 0);
+        outIndex.texCoord = raw.texCoord + ((raw.relativeMask & kRelativeTexCoord)
+                                                ? static_cast<int32_t>(chunk.texCoordBase) : 0);
+        outIndex.normal = raw.normal + ((raw.relativeMask & kRelativeNormal)
+                                            ? static_cast<int32_t>(chunk.normalBase) : 0);
+        if (outIndex.position < 0 || static_cast<size_t>(outIndex.position) >= positionCount) {
+            return false;
+        }
+        if ((outIndex.texCoord < 0 && (raw.relativeMask & kRelativeTexCoord)) ||
+            (outIndex.texCoord >= 0 && static_cast<size_t>(outIndex.texCoord) >= texCoordCount)) {
+            return false;
+        }
+        if ((outIndex.normal < 0 && (raw.relativeMask & kRelativeNormal)) ||
+            (outIndex.normal >= 0 && static_cast<size_t>(outIndex.normal) >= normalCount)) {
+            return false;
+        }
+        return true;
+    }
+
+    float squaredDistance(const float* a, const float* b) {
+        float dx = b[0] - a[0];
+        float dy = b[1] - a[1];
+        float dz = b[2] - a[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    void triangulateChunk(ObjChunk& chunk, ObjData& data) {
+        const size_t positionCount = data.positions.size() / 3;
+        const size_t texCoordCount = data.texCoords.size() / 2;
+        const size_t normalCount = data.normals.size() / 3;
+        ObjIndex* out = data.corners.data() + chunk.triangleBase * 3;
+        const RawCorner* face = chunk.corners.data();
+        ObjIndex polygon[4];
+        std::vector<ObjIndex> largePolygon;
+
+        for (uint32_t faceSize: chunk.faceSizes) {
+            ObjIndex* corners = polygon;
+            if (faceSize > 4) {
+                largePolygon.resize(faceSize);
+                corners = largePolygon.data();
+            }
+            for (uint32_t i = 0; i < faceSize; ++i) {
+                if (!resolveCorner(face[i], chunk, positionCount, texCoordCount, normalCount, corners[i])) {
+                    chunk.error = "OBJ face references an attribute that does not exist";
+                    return;
+                }
+            }
+            face += faceSize;
+
+            const float* quadPositions[4] = {};
+            if (faceSize == 4) {
+                for (uint32_t i = 0; i < 4; ++i) {
+                    quadPositions[i] = &data.positions[3 * size_t(corners[i].position)];
+                }
+            }
+            out += triangulateObjPolygon(corners, faceSize, quadPositions, out);
+        }
+    }
+
+    // Replays the group/material statements of all chunks in file order to split the corners into groups
+    void buildGroups(const std::vector<ObjChunk>& chunks, ObjData& data) {
+        std::unordered_map<std::string, int32_t> materialIds;
+        std::string name;
+        int32_t material = -1;
+        size_t groupStart = 0;
+        auto closeGroup = [&](size_t end) {
+            if (end == groupStart) {
+                return;
+            }
+            ObjGroup* last = data.groups.empty() ? nullptr : &data.groups.back();
+            if (last && last->name == name && last->material == material) {
+                last->cornerCount += end - groupStart; // Same state again, e.g. a repeated "usemtl"
+            } else {
+                data.groups.push_back({groupStart, end - groupStart, name, material});
+            }
+            groupStart = end;
+        };
+
+        for (const ObjChunk& chunk: chunks) {
+            size_t corner = chunk.triangleBase * 3;
+            size_t face = 0;
+            for (const ObjMarker& marker: chunk.markers) {
+                for (; face < marker.face; ++face) {
+                    corner += size_t(chunk.faceSizes[face] - 2) * 3;
+                }
+                if (marker.type == ObjMarker::Type::Library) {
+                    if (std::find(data.materialLibraries.begin(), data.materialLibraries.end(), marker.name) ==
+                        data.materialLibraries.end()) {
+                        data.materialLibraries.push_back(marker.name);
+                    }
+                    continue;
+                }
+                closeGroup(corner);
+                if (marker.type == ObjMarker::Type::Group) {
+                    name = marker.name;
+                } else {
+                    auto [it, inserted] = materialIds.emplace(marker.name, static_cast<int32_t>(materialIds.size()));
+                    if (inserted) {
+                        data.materialNames.push_back(marker.name);
+                    }
+                    material = it->second;
+                }
+            }
+        }
+        closeGroup(data.corners.size());
+    }
+
+    bool parseFloats(const char*& p, const char* end, float* out, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            if (!parseFloat(p, end, out[i])) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Last blank-separated token of a texture map line, after any options
+    std::string parseMapFile(const char* p, const char* end) {
+        std::string line = parseName(p, end);
+        size_t lastBlank = line.find_last_of(" \t");
+        return lastBlank == std::string::npos ? line : line.substr(lastBlank + 1);
+    }
+}
+
+size_t triangulateObjPolygon(const ObjIndex* polygon, uint32_t cornerCount, const float* const quadPositions[4],
+                             ObjIndex* out) {
+    if (cornerCount < 3) {
+        return 0;
+    }
+    if (cornerCount == 4) {
+        // Split along the shorter diagonal, matching tinyobj's quad triangulation
+        static constexpr uint8_t kShortDiagonal02[6] = {0, 1, 2, 0, 2, 3};
+        static constexpr uint8_t kShortDiagonal13[6] = {0, 1, 3, 1, 2, 3};
+        const uint8_t* order = squaredDistance(quadPositions[0], quadPositions[2]) <
+                               squaredDistance(quadPositions[1], quadPositions[3])
+                                   ? kShortDiagonal02
+                                   : kShortDiagonal13;
+        for (size_t i = 0; i < 6; ++i) {
+            out[i] = polygon[order[i]];
+        }
+        return 6;
+    }
+    for (uint32_t i = 1; i + 1 < cornerCount; ++i) {
+        *out++ = polygon[0];
+        *out++ = polygon[i];
+        *out++ = polygon[i + 1];
+    }
+    return size_t(cornerCount - 2) * 3;
+}
+
+void parseObj(const char* text, size_t size, ObjData& outData, const ObjParseOptions& options) {
+    outData = ObjData();
+    if (!text || size == 0) {
+        return;
+    }
+
+    // --- 1. Split at line boundaries ---
+    size_t threadCount = options.threadCount ? options.threadCount
+                             : options.jobSystem ? options.jobSystem->getThreadCount()
+                             : std::thread::hardware_concurrency();
+    threadCount = std::max<size_t>(1, threadCount);
+    size_t chunkCount = std::min(threadCount, std::max<size_t>(1, size / std::max<size_t>(1, options.minChunkSize)));
+
+    const char* end = text + size;
+    std::vector<ObjChunk> chunks(chunkCount);
+    const char* chunkStart = text;
+    for (size_t i = 0; i < chunkCount; ++i) {
+        const char* chunkEnd = (i + 1 == chunkCount)
+                                   ? end
+                                   : nextLineStart(text + size * (i + 1) / chunkCount, text, end);
+        chunks[i].begin = chunkStart;
+        chunks[i].end = std::max(chunkStart, chunkEnd);
+        chunkStart = chunks[i].end;
+    }
+
+    // --- 2. Parse each chunk independently ---
+    runParallel(options.jobSystem, chunkCount, [&](size_t i) { parseChunk(chunks[i]); });
+    for (const ObjChunk& chunk: chunks) {
+        if (!chunk.error.empty()) {
+            throw std::runtime_error(chunk.error);
+        }
+    }
+
+    // --- 3. Stitch: global offsets for every chunk ---
+    size_t positionFloats = 0, texCoordFloats = 0, normalFloats = 0, triangleCount = 0;
+    for (ObjChunk& chunk: chunks) {
+        chunk.positionBase = positionFloats / 3;
+        chunk.texCoordBase = texCoordFloats / 2;
+        chunk.normalBase = normalFloats / 3;
+        chunk.triangleBase = triangleCount;
+        positionFloats += chunk.positions.size();
+        texCoordFloats += chunk.texCoords.size();
+        normalFloats += chunk.normals.size();
+        triangleCount += chunk.triangleCount;
+    }
+    if (positionFloats / 3 > static_cast<size_t>(INT32_MAX)) {
+        throw std::runtime_error("OBJ file has too many vertices");
+    }
+    outData.positions.resize(positionFloats);
+    outData.texCoords.resize(texCoordFloats);
+    outData.normals.resize(normalFloats);
+    outData.corners.resize(triangleCount * 3);
+
+    runParallel(options.jobSystem, chunkCount, [&](size_t i) {
+        const ObjChunk& chunk = chunks[i];
+        std::copy(chunk.positions.begin(), chunk.positions.end(), outData.positions.begin() + chunk.positionBase * 3);
+        std::copy(chunk.texCoords.begin(), chunk.texCoords.end(), outData.texCoords.begin() + chunk.texCoordBase * 2);
+        std::copy(chunk.normals.begin(), chunk.normals.end(), outData.normals.begin() + chunk.normalBase * 3);
+    });
+
+    // --- 4. Resolve indices against the global arrays and triangulate in place ---
+    runParallel(options.jobSystem, chunkCount, [&](size_t i) { triangulateChunk(chunks[i], outData); });
+    for (const ObjChunk& chunk: chunks) {
+        if (!chunk.error.empty()) {
+            throw std::runtime_error(chunk.error);
+        }
+    }
+
+    // --- 5. Groups and materials ---
+    buildGroups(chunks, outData);
+}
+
+void parseObjFile(const std::string& filename, ObjData& outData, const ObjParseOptions& options,
+                  const VirtualFileSystem* fileSystem) {
+    VirtualFile file;
+    if (!openFile(fileSystem, filename, file)) {
+        throw std::runtime_error("Failed to open OBJ file: " + filename);
+    }
+    try {
+        parseObj(reinterpret_cast<const char*>(file.data()), file.size(), outData, options);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+}
+
+void parseMtl(const char* text, size_t size, std::vector<ObjMaterial>& outMaterials) {
+    const char* p = text;
+    const char* end = text + size;
+    ObjMaterial* material = nullptr;
+    while (p < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if (!lineEnd) lineEnd = end;
+        const char* lineStart = p;
+
+        skipBlanks(p, lineEnd);
+        bool ok = true;
+        if (isKeyword(p, lineEnd, "newmtl", 6)) {
+            outMaterials.emplace_back();
+            material = &outMaterials.back();
+            material->name = parseName(p + 7, lineEnd);
+        } else if (material) {
+            if (isKeyword(p, lineEnd, "Ka", 2)) {
+                p += 3;
+                ok = parseFloats(p, lineEnd, material->ambient, 3);
+            } else if (isKeyword(p, lineEnd, "Kd", 2)) {
+                p += 3;
+                ok = parseFloats(p, lineEnd, material->diffuse, 3);
+            } else if (isKeyword(p, lineEnd, "Ks", 2)) {
+                p += 3;
+                ok = parseFloats(p, lineEnd, material->specular, 3);
+            } else if (isKeyword(p, lineEnd, "Ke", 2)) {
+                p += 3;
+                ok = parseFloats(p, lineEnd, material->emissive, 3);
+            } else if (isKeyword(p, lineEnd, "Ns", 2)) {
+                p += 3;
+                ok = parseFloat(p, lineEnd, material->shininess);
+            } else if (isKeyword(p, lineEnd, "d", 1)) {
+                p += 2;
+                ok = parseFloat(p, lineEnd, material->dissolve);
+            } else if (isKeyword(p, lineEnd, "Tr", 2)) {
+                p += 3;
+                float transparency = 0.0f;
+                ok = parseFloat(p, lineEnd, transparency);
+                material->dissolve = 1.0f - transparency;
+            } else if (isKeyword(p, lineEnd, "map_Kd", 6)) {
+                material->diffuseTexture = parseMapFile(p + 7, lineEnd);
+            } else if (isKeyword(p, lineEnd, "norm", 4) || isKeyword(p, lineEnd, "bump", 4)) {
+                material->normalTexture = parseMapFile(p + 5, lineEnd);
+            } else if (isKeyword(p, lineEnd, "map_Bump", 8) || isKeyword(p, lineEnd, "map_bump", 8)) {
+                material->normalTexture = parseMapFile(p + 9, lineEnd);
+            }
+            // Other statements (illum, Ni, Tf, other maps) are not used by the renderer
+        }
+
+        if (!ok) {
+            const char* textEnd = (lineEnd > lineStart && lineEnd[-1] == '\r') ? lineEnd - 1 : lineEnd;
+            throw std::runtime_error("Malformed MTL line: \"" + std::string(lineStart, textEnd) + "\"");
+        }
+        p = lineEnd + 1;
+    }
+}
+
+void parseMtlFile(const std::string& filename, std::vector<ObjMaterial>& outMaterials,
+                  const VirtualFileSystem* fileSystem) {
+    VirtualFile file;
+    if (!openFile(fileSystem, filename, file)) {
+        throw std::runtime_error("Failed to open MTL file: " + filename);
+    }
+    try {
+        parseMtl(reinterpret_cast<const char*>(file.data()), file.size(), outMaterials);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(filename + ": " + e.what());
+    }
+}
+
+void readObjStream(const std::string& filename, ObjStreamHandler& handler, size_t windowSize) {
+    std::unique_ptr<FILE, int (*)(FILE*)> file(fopen(filename.c_str(), "rb"), fclose);
+    if (!file) {
+        throw std::runtime_error("Failed to open OBJ file: " + filename);
+    }
+    std::vector<char> window(std::max<size_t>(windowSize, 4096));
+    size_t filled = 0;
+    size_t positionCount = 0, texCoordCount = 0, normalCount = 0;
+    ObjChunk chunk; // Reused for every window so its arrays keep their capacity
+    std::vector<ObjIndex> polygon;
+
+    while (true) {
+        size_t read = fread(window.data() + filled, 1, window.size() - filled, file.get());
+        if (ferror(file.get())) {
+            throw std::runtime_error("Failed to read OBJ file: " + filename);
+        }
+        filled += read;
+        const bool last = filled < window.size();
+        if (filled == 0) {
+            break;
+        }
+
+        // Parse whole lines only; a trailing partial line moves to the front of the window
+        size_t parseSize = filled;
+        if (!last) {
+            while (parseSize > 0 && window[parseSize - 1] != '\n') {
+                parseSize--;
+            }
+            if (parseSize == 0) {
+                throw std::runtime_error(filename + ": OBJ line longer than the stream window");
+            }
+        }
+        chunk.positions.clear();
+        chunk.texCoords.clear();
+        chunk.normals.clear();
+        chunk.corners.clear();
+        chunk.faceSizes.clear();
+        chunk.error = parseLines(window.data(), window.data() + parseSize, chunk.positions, chunk.texCoords,
+                                 chunk.normals, chunk.corners, chunk.faceSizes, nullptr);
+        if (!chunk.error.empty()) {
+            throw std::runtime_error(filename + ": " + chunk.error);
+        }
+
+        // Attributes first so every face below can be resolved by the handler
+        for (size_t i = 0; i < chunk.positions.size(); i += 3) {
+            handler.onPosition(chunk.positions[i], chunk.positions[i + 1], chunk.positions[i + 2]);
+        }
+        for (size_t i = 0; i < chunk.texCoords.size(); i += 2) {
+            handler.onTexCoord(chunk.texCoords[i], chunk.texCoords[i + 1]);
+        }
+        for (size_t i = 0; i < chunk.normals.size(); i += 3) {
+            handler.onNormal(chunk.normals[i], chunk.normals[i + 1], chunk.normals[i + 2]);
+        }
+        chunk.positionBase = positionCount;
+        chunk.texCoordBase = texCoordCount;
+        chunk.normalBase = normalCount;
+        positionCount += chunk.positions.size() / 3;
+        texCoordCount += chunk.texCoords.size() / 2;
+        normalCount += chunk.normals.size() / 3;
+        if (positionCount > static_cast<size_t>(INT32_MAX)) {
+            throw std::runtime_error(filename + ": OBJ file has too many vertices");
+        }
+
+        const RawCorner* face = chunk.corners.data();
+        for (uint32_t faceSize: chunk.faceSizes) {
+            polygon.resize(faceSize);
+            for (uint32_t i = 0; i < faceSize; ++i) {
+                if (!resolveCorner(face[i], chunk, positionCount, texCoordCount, normalCount, polygon[i])) {
+                    throw std::runtime_error(filename + ": OBJ face references an attribute that does not exist");
+                }
+            }
+            face += faceSize;
+            handler.onFace(polygon.data(), faceSize);
+        }
+
+        memmove(window.data(), window.data() + parseSize, filled - parseSize);
+        filled -= parseSize;
+        if (last) {
+            break;
+        }
+    }
+}
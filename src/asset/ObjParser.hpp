@@ -0,0 +1,97 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Zero-based attribute indices of one triangle corner; -1 when the attribute is absent
+struct ObjIndex {
+    int32_t position;
+    int32_t texCoord;
+    int32_t normal;
+};
+
+// A run of consecutive triangles that share their "o"/"g" name and "usemtl" material
+struct ObjGroup {
+    size_t firstCorner; // Into ObjData::corners
+    size_t cornerCount;
+    std::string name; // Last "o" or "g" name before the run, empty if there was none
+    int32_t material; // Into ObjData::materialNames, -1 before the first "usemtl"
+};
+
+struct ObjData {
+    std::vector<float> positions; // xyz per "v"
+    std::vector<float> texCoords; // uv per "vt"
+    std::vector<float> normals; // xyz per "vn"
+    std::vector<ObjIndex> corners; // Triangulated faces in file order, 3 corners per triangle
+    std::vector<ObjGroup> groups; // Cover corners in order, without empty runs
+    std::vector<std::string> materialNames; // "usemtl" names in order of first use
+    std::vector<std::string> materialLibraries; // "mtllib" file names, relative to the OBJ file
+};
+
+// One "newmtl" block of a .mtl file; unset values keep the defaults (no specular highlight)
+struct ObjMaterial {
+    std::string name;
+    float ambient[3] = {0.2f, 0.2f, 0.2f}; // Ka
+    float diffuse[3] = {0.8f, 0.8f, 0.8f}; // Kd
+    float specular[3] = {0.0f, 0.0f, 0.0f}; // Ks
+    float emissive[3] = {0.0f, 0.0f, 0.0f}; // Ke
+    float shininess = 1.0f; // Ns
+    float dissolve = 1.0f; // d, or 1 - Tr
+    std::string diffuseTexture; // map_Kd, relative to the .mtl file
+    std::string normalTexture; // norm, map_Bump or bump
+};
+
+class JobSystem;
+class VirtualFileSystem;
+
+struct ObjParseOptions {
+    unsigned threadCount = 0; // Chunks to split into; 0 = the job system's threads, or hardware concurrency
+    JobSystem* jobSystem = nullptr; // Parses the chunks as jobs; without one every chunk gets its own thread
+    size_t minChunkSize = 1 << 20; // Files are never split into chunks smaller than this
+};
+
+// Parses OBJ text in parallel: the buffer is split at line boundaries, each chunk is parsed on its own
+// thread (or job) and the per-chunk results are stitched into global arrays afterwards. Quads are split along
+// their shorter diagonal (as tinyobj does); larger polygons are fan-triangulated. "o"/"g" and "usemtl"
+// statements split the triangles into groups; material libraries are only listed, see parseMtlFile.
+// Throws std::runtime_error on malformed input.
+void parseObj(const char* text, size_t size, ObjData& outData, const ObjParseOptions& options = {});
+
+// Memory-maps the file (or opens it through fileSystem, see openFile) and runs parseObj over it
+void parseObjFile(const std::string& filename, ObjData& outData, const ObjParseOptions& options = {},
+                  const VirtualFileSystem* fileSystem = nullptr);
+
+// Appends the materials of a .mtl file. Texture map options ("-bm 1" etc.) are skipped; the last token
+// of a map line is taken as the file name. Throws std::runtime_error on malformed input.
+void parseMtl(const char* text, size_t size, std::vector<ObjMaterial>& outMaterials);
+
+void parseMtlFile(const std::string& filename, std::vector<ObjMaterial>& outMaterials,
+                  const VirtualFileSystem* fileSystem = nullptr);
+
+// Triangulates one polygon the way parseObj does and returns the number of corners written to out
+// ((cornerCount - 2) * 3). quadPositions holds the xyz of each corner and is only read for quads.
+size_t triangulateObjPolygon(const ObjIndex* polygon, uint32_t cornerCount, const float* const quadPositions[4],
+                             ObjIndex* out);
+
+// Receives the elements of an OBJ file in file order (streaming import)
+class ObjStreamHandler {
+public:
+    virtual ~ObjStreamHandler() = default;
+
+    virtual void onPosition(float x, float y, float z) = 0;
+
+    virtual void onTexCoord(float u, float v) = 0;
+
+    virtual void onNormal(float x, float y, float z) = 0;
+
+    // One polygon, not triangulated yet, with absolute zero-based indices that refer only to attributes
+    // already reported
+    virtual void onFace(const ObjIndex* corners, uint32_t cornerCount) = 0;
+};
+
+// Reads the file front to back through a buffer of windowSize bytes, so memory use does not depend on
+// the file size. Groups and materials are not reported. A line longer than the window is an error. Reads
+// from disk only: a source in a pack is already in memory, so it is imported with parseObjFile instead.
+// Throws std::runtime_error on read errors and malformed input.
+void readObjStream(const std::string& filename, ObjStreamHandler& handler, size_t windowSize = 4 << 20);
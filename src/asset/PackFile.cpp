@@ -0,0 +1,267 @@
+#include "PackFile.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "Hash.hpp"
+#include "Lz4.hpp"
+
+namespace {
+    uint64_t alignOffset(uint64_t offset, uint64_t alignment) {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    uint64_t hashTable(const PackEntry* entries, size_t entryCount, const char* strings, size_t stringsSize) {
+        return hashCombine(hash64(entries, entryCount * sizeof(PackEntry)), hash64(strings, stringsSize));
+    }
+}
+
+std::string normalizePackPath(const std::string& path) {
+    std::string generic = path;
+    std::replace(generic.begin(), generic.end(), '\\', '/');
+    std::string normal = std::filesystem::path(generic).lexically_normal().generic_string();
+    return normal == "." ? std::string() : normal;
+}
+
+PackFile::PackFile() {
+}
+
+PackFile::~PackFile() {
+}
+
+bool PackFile::open(const std::string& path) {
+    close();
+    if (!m_file.open(path) || m_file.size() < sizeof(PackHeader)) {
+        close();
+        return false;
+    }
+    const uint8_t* data = m_file.data();
+    const uint64_t fileSize = m_file.size();
+    const auto* header = reinterpret_cast<const PackHeader*>(data);
+    if (header->magic != kPackMagic || header->version != kPackVersion ||
+        header->tocOffset % alignof(PackEntry) != 0 || header->tocOffset > fileSize ||
+        uint64_t(header->entryCount) * sizeof(PackEntry) > fileSize - header->tocOffset ||
+        header->stringsOffset > fileSize || header->stringsSize > fileSize - header->stringsOffset ||
+        header->stringsSize == 0 || data[header->stringsOffset + header->stringsSize - 1] != '\0') {
+        close();
+        return false;
+    }
+    const auto* entries = reinterpret_cast<const PackEntry*>(data + header->tocOffset);
+    const char* strings = reinterpret_cast<const char*>(data + header->stringsOffset);
+    if (hashTable(entries, header->entryCount, strings, static_cast<size_t>(header->stringsSize)) !=
+        header->tocHash) {
+        close();
+        return false;
+    }
+    for (uint32_t i = 0; i < header->entryCount; ++i) {
+        const PackEntry& entry = entries[i];
+        const bool compressed = (entry.flags & kPackEntryCompressed) != 0;
+        if (entry.pathOffset >= header->stringsSize ||
+            entry.offset % kPackEntryAlignment != 0 || entry.offset < sizeof(PackHeader) ||
+            entry.storedSize > fileSize - std::min(entry.offset, fileSize) ||
+            (!compressed && entry.storedSize != entry.size) ||
+            (i > 0 && strcmp(strings + entries[i - 1].pathOffset, strings + entry.pathOffset) >= 0)) {
+            close();
+            return false;
+        }
+    }
+    m_header = header;
+    m_entries = entries;
+    m_strings = strings;
+    return true;
+}
+
+void PackFile::close() {
+    m_file.close();
+    m_header = nullptr;
+    m_entries = nullptr;
+    m_strings = nullptr;
+}
+
+const PackEntry* PackFile::find(const std::string& path) const {
+    if (!m_header) {
+        return nullptr;
+    }
+    const std::string normal = normalizePackPath(path);
+    const PackEntry* end = m_entries + m_header->entryCount;
+    const PackEntry* it = std::lower_bound(m_entries, end, normal,
+                                           [&](const PackEntry& entry, const std::string& key) {
+                                               return strcmp(m_strings + entry.pathOffset, key.c_str()) < 0;
+                                           });
+    if (it == end || normal != m_strings + it->pathOffset) {
+        return nullptr;
+    }
+    return it;
+}
+
+const uint8_t* PackFile::getStoredData(const PackEntry& entry) const {
+    if (entry.flags & kPackEntryCompressed) {
+        return nullptr;
+    }
+    return m_file.data() + entry.offset;
+}
+
+bool PackFile::read(const PackEntry& entry, std::vector<uint8_t>& outData) const {
+    const uint8_t* stored = m_file.data() + entry.offset;
+    if (!(entry.flags & kPackEntryCompressed)) {
+        outData.assign(stored, stored + entry.storedSize);
+        return true;
+    }
+    outData.resize(static_cast<size_t>(entry.size));
+    return lz4Decompress(stored, static_cast<size_t>(entry.storedSize), outData.data(), outData.size());
+}
+
+bool PackFile::verify(std::string* outError) const {
+    std::vector<uint8_t> contents;
+    for (size_t i = 0; i < getEntryCount(); ++i) {
+        const PackEntry& entry = m_entries[i];
+        const uint8_t* data = getStoredData(entry);
+        if (!data) {
+            if (!read(entry, contents)) {
+                if (outError) {
+                    *outError = std::string("Corrupt compressed data: ") + getEntryPath(entry);
+                }
+                return false;
+            }
+            data = contents.data();
+        }
+        if (hash64(data, static_cast<size_t>(entry.size)) != entry.contentHash) {
+            if (outError) {
+                *outError = std::string("Content hash mismatch: ") + getEntryPath(entry);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+PackWriter::~PackWriter() {
+    abort();
+}
+
+bool PackWriter::open(const std::string& path) {
+    abort();
+    m_path = path;
+    m_tempPath = path + ".tmp";
+    m_file = fopen(m_tempPath.c_str(), "wb");
+    if (!m_file) {
+        return false;
+    }
+    m_entries.clear();
+    m_paths.clear();
+    m_storedBytes = 0;
+    m_originalBytes = 0;
+    // The header is written last; entry data starts on the first aligned offset after it
+    m_offset = 0;
+    m_ok = true;
+    return pad();
+}
+
+bool PackWriter::pad() {
+    static const uint8_t zeros[kPackEntryAlignment] = {};
+    const uint64_t aligned = std::max<uint64_t>(alignOffset(m_offset, kPackEntryAlignment), kPackEntryAlignment);
+    if (m_ok && aligned > m_offset) {
+        m_ok = fwrite(zeros, 1, static_cast<size_t>(aligned - m_offset), m_file) == aligned - m_offset;
+    }
+    m_offset = aligned;
+    return m_ok;
+}
+
+bool PackWriter::add(const std::string& packPath, const void* data, size_t size, bool compress) {
+    const std::string path = normalizePackPath(packPath);
+    if (!m_ok || path.empty() || !m_paths.insert(path).second) {
+        return false;
+    }
+    PackEntry entry = {};
+    entry.offset = m_offset;
+    entry.size = size;
+    entry.contentHash = hash64(data, size);
+
+    const void* stored = data;
+    size_t storedSize = size;
+    std::vector<uint8_t> compressed;
+    if (compress && size > 0 && size < (size_t(1) << 32)) {
+        compressed.resize(lz4CompressBound(size));
+        const size_t compressedSize = lz4Compress(static_cast<const uint8_t*>(data), size, compressed.data(),
+                                                  compressed.size());
+        if (compressedSize > 0 && compressedSize <= size - size / 8) {
+            entry.flags |= kPackEntryCompressed;
+            stored = compressed.data();
+            storedSize = compressedSize;
+        }
+    }
+    entry.storedSize = storedSize;
+    m_ok = storedSize == 0 || fwrite(stored, 1, storedSize, m_file) == storedSize;
+    m_offset += storedSize;
+    m_storedBytes += storedSize;
+    m_originalBytes += size;
+    m_entries.emplace_back(path, entry);
+    return pad();
+}
+
+bool PackWriter::addFile(const std::string& packPath, const std::string& sourcePath, bool compress) {
+    MappedFile source;
+    if (source.open(sourcePath)) {
+        return add(packPath, source.data(), source.size(), compress);
+    }
+    std::error_code ec; // MappedFile does not map empty files
+    return std::filesystem::file_size(sourcePath, ec) == 0 && !ec && add(packPath, nullptr, 0, compress);
+}
+
+bool PackWriter::finish() {
+    if (!m_file) {
+        return false;
+    }
+    std::sort(m_entries.begin(), m_entries.end(),
+              [](const auto& a, const auto& b) { return strcmp(a.first.c_str(), b.first.c_str()) < 0; });
+    std::vector<PackEntry> table;
+    std::vector<char> strings;
+    table.reserve(m_entries.size());
+    for (auto& [path, entry] : m_entries) {
+        entry.pathOffset = static_cast<uint32_t>(strings.size());
+        strings.insert(strings.end(), path.begin(), path.end());
+        strings.push_back('\0');
+        table.push_back(entry);
+    }
+    if (strings.empty()) {
+        strings.push_back('\0'); // An empty pack still has a valid (empty) string table
+    }
+
+    PackHeader header = {};
+    header.magic = kPackMagic;
+    header.version = kPackVersion;
+    header.entryCount = static_cast<uint32_t>(table.size());
+    header.tocOffset = m_offset;
+    header.stringsOffset = m_offset + table.size() * sizeof(PackEntry);
+    header.stringsSize = strings.size();
+    header.tocHash = hashTable(table.data(), table.size(), strings.data(), strings.size());
+
+    bool ok = m_ok &&
+              (table.empty() || fwrite(table.data(), sizeof(PackEntry), table.size(), m_file) == table.size()) &&
+              fwrite(strings.data(), 1, strings.size(), m_file) == strings.size() &&
+              fseek(m_file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, m_file) == 1;
+    ok = (fclose(m_file) == 0) && ok;
+    m_file = nullptr;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(m_tempPath, m_path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(m_tempPath, ec);
+    }
+    m_ok = false;
+    return ok;
+}
+
+void PackWriter::abort() {
+    if (m_file) {
+        fclose(m_file);
+        m_file = nullptr;
+        std::error_code ec;
+        std::filesystem::remove(m_tempPath, ec);
+    }
+    m_ok = false;
+}
@@ -0,0 +1,142 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "MappedFile.hpp"
+
+// Pack archive (".pack"): many files in one, found through a table of contents sorted by path, so opening
+// an asset is a binary search in a mapping instead of a filesystem lookup and a read. Entry data starts on
+// a kPackEntryAlignment boundary: stored entries keep the alignment their own formats rely on (mesh cache
+// sections) and are used in place, while compressed entries (LZ4 block format) are decoded on open.
+// Layout: header, entry data, then the table of contents and its path strings.
+
+constexpr uint32_t kPackMagic = 0x4B505844; // "DXPK"
+constexpr uint32_t kPackVersion = 1;
+constexpr uint64_t kPackEntryAlignment = 4096;
+
+constexpr uint32_t kPackEntryCompressed = 1; // PackEntry::flags: the data is one LZ4 block
+
+struct PackHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t reserved;
+    uint64_t tocOffset; // PackEntry[entryCount], sorted by path (byte-wise)
+    uint64_t stringsOffset; // Null-terminated paths referenced by the entries
+    uint64_t stringsSize;
+    uint64_t tocHash; // hash64 of the table and the strings, so a damaged table is never searched
+};
+
+struct PackEntry {
+    uint32_t pathOffset; // Into the strings
+    uint32_t flags; // kPackEntryCompressed
+    uint64_t offset; // From the start of the pack, aligned to kPackEntryAlignment
+    uint64_t storedSize; // Bytes in the pack
+    uint64_t size; // Bytes once decompressed
+    uint64_t contentHash; // hash64 of the decompressed contents
+};
+
+// Paths inside a pack are relative, '/'-separated and lexically normal ("a/./b\\c" -> "a/b/c"), so any
+// spelling of a path the loaders use finds the entry
+std::string normalizePackPath(const std::string& path);
+
+class PackFile {
+public:
+    PackFile();
+
+    ~PackFile();
+
+    PackFile(const PackFile&) = delete;
+
+    PackFile& operator=(const PackFile&) = delete;
+
+    // Maps the pack and validates the header, the table hash, the sort order and every entry's bounds
+    bool open(const std::string& path);
+
+    void close();
+
+    bool isOpen() const {
+        return m_header != nullptr;
+    }
+
+    // Binary search over the sorted table; the path is normalized first. nullptr if there is no such entry.
+    const PackEntry* find(const std::string& path) const;
+
+    size_t getEntryCount() const {
+        return m_header ? m_header->entryCount : 0;
+    }
+
+    const PackEntry& getEntry(size_t index) const {
+        return m_entries[index];
+    }
+
+    const char* getEntryPath(const PackEntry& entry) const {
+        return m_strings + entry.pathOffset;
+    }
+
+    // Contents of a stored (uncompressed) entry inside the mapping, valid while the pack is open; nullptr
+    // for compressed entries
+    const uint8_t* getStoredData(const PackEntry& entry) const;
+
+    // Decompresses (or copies) an entry. Returns false if compressed data is corrupt.
+    bool read(const PackEntry& entry, std::vector<uint8_t>& outData) const;
+
+    // Reads every entry and checks it against its content hash
+    bool verify(std::string* outError = nullptr) const;
+
+private:
+    MappedFile m_file;
+    const PackHeader* m_header = nullptr;
+    const PackEntry* m_entries = nullptr;
+    const char* m_strings = nullptr;
+};
+
+// Writes a pack entry by entry (only one entry is in memory at a time); the table is sorted and written by
+// finish(). Like the cache writers, it writes a temporary file and renames it into place.
+class PackWriter {
+public:
+    ~PackWriter();
+
+    bool open(const std::string& path);
+
+    // Adds the contents under a pack path. With compress, the entry is stored LZ4-compressed when that saves
+    // at least 1/8 of its size (otherwise it is not worth losing the in-place view). Returns false if the
+    // path was already added or the write failed.
+    bool add(const std::string& packPath, const void* data, size_t size, bool compress);
+
+    // Same, reading the file at sourcePath
+    bool addFile(const std::string& packPath, const std::string& sourcePath, bool compress);
+
+    bool finish();
+
+    // Deletes the temporary file unless finish() succeeded
+    void abort();
+
+    size_t getEntryCount() const {
+        return m_entries.size();
+    }
+
+    uint64_t getStoredBytes() const {
+        return m_storedBytes;
+    }
+
+    uint64_t getOriginalBytes() const {
+        return m_originalBytes;
+    }
+
+private:
+    bool pad();
+
+    std::string m_path;
+    std::string m_tempPath;
+    FILE* m_file = nullptr;
+    uint64_t m_offset = 0;
+    std::vector<std::pair<std::string, PackEntry>> m_entries; // Path, entry (pathOffset set by finish)
+    std::unordered_set<std::string> m_paths;
+    uint64_t m_storedBytes = 0;
+    uint64_t m_originalBytes = 0;
+    bool m_ok = false;
+};
@@ -0,0 +1,135 @@
+#include "ShortIndices.hpp"
+
+#include <algorithm>
+
+namespace {
+    constexpr uint32_t kUnmarked = 0xFFFFFFFFu;
+
+    // Calls visit(index) for every index of the submesh: LOD0 and the coarser levels in lodIndices
+    template<typename Visit>
+    void forEachSubmeshIndex(MeshData& mesh, const Submesh& submesh, Visit&& visit) {
+        for (uint32_t i = 0; i < submesh.indexCount; ++i) {
+            visit(mesh.indices[submesh.indexOffset + i]);
+        }
+        for (uint32_t level = 1; level < submesh.lodCount; ++level) {
+            const MeshLod& lod = mesh.lods[submesh.lodOffset + level];
+            uint32_t* indices = mesh.lodIndices.data() + (lod.indexOffset - mesh.indices.size());
+            for (uint32_t i = 0; i < lod.indexCount; ++i) {
+                visit(indices[i]);
+            }
+        }
+    }
+}
+
+std::vector<uint32_t> splitIndexRuns(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                     size_t maxVertices) {
+    std::vector<uint32_t> runs;
+    std::vector<uint32_t> lastRun(vertexCount, kUnmarked); // Run that last referenced each vertex
+    uint32_t run = 0;
+    size_t runStart = 0;
+    size_t runVertices = 0;
+    auto addTriangle = [&](size_t first) {
+        size_t added = 0;
+        for (size_t k = first; k < first + 3; ++k) {
+            if (lastRun[indices[k]] != run) {
+                lastRun[indices[k]] = run;
+                added++;
+            }
+        }
+        return added;
+    };
+    for (size_t t = 0; t + 3 <= indexCount; t += 3) {
+        size_t added = addTriangle(t);
+        if (runVertices + added > maxVertices && t > runStart) {
+            // Start a new run with this triangle; the marks it left on the old run no longer matter
+            runs.push_back(static_cast<uint32_t>(t - runStart));
+            runStart = t;
+            runVertices = 0;
+            run++;
+            added = addTriangle(t);
+        }
+        runVertices += added;
+    }
+    if (indexCount > runStart) {
+        runs.push_back(static_cast<uint32_t>(indexCount - runStart));
+    }
+    return runs;
+}
+
+ptrdiff_t convertToShortIndices(MeshData& mesh, size_t vertexStride) {
+    if (mesh.indexSize == 2 || mesh.submeshes.empty()) {
+        return -1;
+    }
+    const size_t vertexCount = mesh.vertices.size();
+    const size_t totalIndexCount = mesh.indices.size() + mesh.lodIndices.size();
+
+    // Small meshes need no vertex ranges at all
+    if (vertexCount <= kShortIndexVertexLimit) {
+        bool fits = true;
+        for (const Submesh& submesh : mesh.submeshes) {
+            fits = fits && submesh.baseVertex == 0;
+        }
+        if (fits) {
+            mesh.indexSize = 2;
+            return 0;
+        }
+    }
+
+    // Vertices of every submesh, ascending so each range keeps the vertex buffer's (fetch or spatial) order
+    std::vector<std::vector<uint32_t>> submeshVertices(mesh.submeshes.size());
+    std::vector<uint32_t> mark(vertexCount, kUnmarked);
+    std::vector<uint8_t> referenced(vertexCount, 0);
+    size_t newVertexCount = 0;
+    size_t referencedCount = 0;
+    for (size_t s = 0; s < mesh.submeshes.size(); ++s) {
+        const Submesh& submesh = mesh.submeshes[s];
+        std::vector<uint32_t>& vertices = submeshVertices[s];
+        forEachSubmeshIndex(mesh, submesh, [&](uint32_t index) {
+            uint32_t vertex = submesh.baseVertex + index;
+            if (mark[vertex] != s) {
+                mark[vertex] = static_cast<uint32_t>(s);
+                vertices.push_back(vertex);
+            }
+        });
+        if (vertices.size() > kShortIndexVertexLimit) {
+            return -1; // Needs splitIndexRuns before the LODs and meshlets are built
+        }
+        std::sort(vertices.begin(), vertices.end());
+        for (uint32_t vertex : vertices) {
+            referencedCount += referenced[vertex] == 0;
+            referenced[vertex] = 1;
+        }
+        newVertexCount += vertices.size();
+    }
+    const size_t duplicated = newVertexCount - referencedCount;
+    if (duplicated * vertexStride >= totalIndexCount * (sizeof(uint32_t) - sizeof(uint16_t))) {
+        return -1;
+    }
+
+    // Copy each submesh's vertices into its own range and rebase its indices and meshlets onto it
+    std::vector<Vertex> vertices;
+    vertices.reserve(newVertexCount);
+    std::vector<uint32_t>& rangeIndex = mark; // Old vertex -> index in the current submesh's range
+    for (size_t s = 0; s < mesh.submeshes.size(); ++s) {
+        Submesh& submesh = mesh.submeshes[s];
+        const uint32_t oldBase = submesh.baseVertex;
+        const uint32_t base = static_cast<uint32_t>(vertices.size());
+        for (size_t i = 0; i < submeshVertices[s].size(); ++i) {
+            rangeIndex[submeshVertices[s][i]] = static_cast<uint32_t>(i);
+            vertices.push_back(mesh.vertices[submeshVertices[s][i]]);
+        }
+        forEachSubmeshIndex(mesh, submesh, [&](uint32_t& index) {
+            index = rangeIndex[oldBase + index];
+        });
+        for (uint32_t m = submesh.meshletOffset; m < submesh.meshletOffset + submesh.meshletCount; ++m) {
+            const Meshlet& meshlet = mesh.meshlets.meshlets[m];
+            for (uint32_t v = meshlet.vertexOffset; v < meshlet.vertexOffset + meshlet.vertexCount; ++v) {
+                mesh.meshlets.vertices[v] = base + rangeIndex[mesh.meshlets.vertices[v]];
+            }
+        }
+        submesh.baseVertex = base;
+    }
+    mesh.vertices.swap(vertices);
+    mesh.indexSize = 2;
+    return static_cast<ptrdiff_t>(duplicated);
+}
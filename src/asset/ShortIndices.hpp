@@ -0,0 +1,24 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MeshData.hpp"
+
+// 16-bit index buffers. A submesh can use 16-bit indices when the vertices it references (LOD0 and every
+// coarser level) fit in 65536 consecutive vertices starting at its baseVertex, so large meshes give each
+// submesh its own vertex range and oversized submeshes are split before that.
+
+constexpr size_t kShortIndexVertexLimit = 65536;
+
+// Splits a triangle list into consecutive runs that each reference at most maxVertices distinct vertices
+// (vertexCount bounds the index values). Returns the index count of every run; they add up to indexCount.
+std::vector<uint32_t> splitIndexRuns(const uint32_t* indices, size_t indexCount, size_t vertexCount,
+                                     size_t maxVertices = kShortIndexVertexLimit);
+
+// Switches the mesh to 16-bit indices if every submesh fits, and if the index memory saved outweighs the
+// vertices that must be duplicated (vertexStride bytes each) so submeshes sharing a vertex get disjoint
+// ranges. On success indices and LOD indices are rebased onto each submesh's baseVertex, meshlet vertices
+// follow the new vertex order and indexSize becomes 2. Returns the number of duplicated vertices, or -1
+// (with the mesh untouched) when the mesh keeps 32-bit indices.
+ptrdiff_t convertToShortIndices(MeshData& mesh, size_t vertexStride);
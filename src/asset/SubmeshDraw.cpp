@@ -0,0 +1,46 @@
+#include "SubmeshDraw.hpp"
+
+#include <algorithm>
+
+void buildSubmeshDraws(std::vector<SubmeshDraw>& draws, const Submesh* submeshes, size_t submeshCount,
+                       const MeshLod* lods, size_t lod) {
+    draws.clear();
+    for (size_t i = 0; i < submeshCount; ++i) {
+        const Submesh& submesh = submeshes[i];
+        SubmeshDraw draw = {submesh.materialIndex, static_cast<uint32_t>(i), submesh.indexOffset, submesh.indexCount,
+                            submesh.baseVertex};
+        if (submesh.lodCount > 0) {
+            const MeshLod& level = lods[submesh.lodOffset + std::min<size_t>(lod, submesh.lodCount - 1)];
+            draw.indexOffset = level.indexOffset;
+            draw.indexCount = level.indexCount;
+        }
+        if (draw.indexCount > 0) {
+            draws.push_back(draw);
+        }
+    }
+    std::sort(draws.begin(), draws.end(), [](const SubmeshDraw& a, const SubmeshDraw& b) {
+        return a.materialIndex != b.materialIndex ? a.materialIndex < b.materialIndex : a.indexOffset < b.indexOffset;
+    });
+}
+
+size_t mergeSubmeshDraws(SubmeshDraw* draws, size_t count) {
+    size_t merged = 0;
+    for (size_t i = 0; i < count; ++i) {
+        SubmeshDraw* last = merged > 0 ? &draws[merged - 1] : nullptr;
+        if (last && last->materialIndex == draws[i].materialIndex && last->baseVertex == draws[i].baseVertex &&
+            last->indexOffset + last->indexCount == draws[i].indexOffset) {
+            last->indexCount += draws[i].indexCount;
+        } else {
+            draws[merged++] = draws[i];
+        }
+    }
+    return merged;
+}
+
+size_t countMaterialChanges(const SubmeshDraw* draws, size_t count) {
+    size_t changes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        changes += i == 0 || draws[i].materialIndex != draws[i - 1].materialIndex;
+    }
+    return changes;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MeshData.hpp"
+
+// Material-sorted draw batching. The submeshes of one LOD become a list of indexed draws ordered by
+// material, so the per-material bindings change once per material instead of once per submesh, and
+// draws whose index ranges touch are merged.
+
+struct SubmeshDraw {
+    uint32_t materialIndex; // kNoMaterial for the default material
+    uint32_t submesh; // First submesh of the draw
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    uint32_t baseVertex;
+};
+
+// One draw per submesh at the given level (clamped to each submesh's chain), sorted by material and,
+// within a material, by index offset. Submeshes without levels draw their LOD0 range.
+void buildSubmeshDraws(std::vector<SubmeshDraw>& draws, const Submesh* submeshes, size_t submeshCount,
+                       const MeshLod* lods, size_t lod);
+
+// Merges neighbouring draws with the same material and base vertex whose index ranges are adjacent.
+// Returns the new count.
+size_t mergeSubmeshDraws(SubmeshDraw* draws, size_t count);
+
+// Material bindings needed to record the draws in order
+size_t countMaterialChanges(const SubmeshDraw* draws, size_t count);
@@ -0,0 +1,82 @@
+#include "TextureBatch.hpp"
+
+#include <algorithm>
+
+#include "core/JobSystem.hpp"
+
+TextureBatch::TextureBatch(JobSystem& jobSystem, size_t count, uint64_t memoryBudget, Decoder decode)
+    : m_jobSystem(jobSystem),
+      m_count(count),
+      m_memoryBudget(memoryBudget),
+      m_decode(std::move(decode)),
+      m_counters(new JobCounter[count]) {
+    startDecodes();
+}
+
+TextureBatch::~TextureBatch() {
+    for (size_t index : m_started) {
+        m_jobSystem.wait(m_counters[index]); // Decode jobs never throw: their errors are results
+    }
+}
+
+void TextureBatch::poll(std::vector<TextureBatchResult>& outFinished) {
+    std::vector<TextureBatchResult> finished;
+    {
+        std::lock_guard<std::mutex> lock(m_finishedMutex);
+        finished.swap(m_finished);
+    }
+    for (TextureBatchResult& result : finished) {
+        m_waitingBytes.fetch_sub(result.bytes, std::memory_order_relaxed);
+        m_started.erase(std::find(m_started.begin(), m_started.end(), result.index));
+        outFinished.push_back(std::move(result));
+    }
+    m_handedOverCount += finished.size();
+    startDecodes();
+}
+
+void TextureBatch::wait(std::vector<TextureBatchResult>& outFinished) {
+    bool anyFinished;
+    {
+        std::lock_guard<std::mutex> lock(m_finishedMutex);
+        anyFinished = !m_finished.empty();
+    }
+    // With none finished, every started texture is still decoding
+    if (!anyFinished && !m_started.empty()) {
+        m_jobSystem.wait(m_counters[m_started.front()]);
+    }
+    poll(outFinished);
+}
+
+void TextureBatch::startDecodes() {
+    const size_t maxDecodingCount = m_jobSystem.getThreadCount();
+    while (m_nextIndex < m_count) {
+        const size_t decodingCount = m_decodingCount.load(std::memory_order_acquire);
+        const uint64_t waitingBytes = m_waitingBytes.load(std::memory_order_relaxed);
+        const bool idle = decodingCount == 0 && waitingBytes == 0;
+        if (decodingCount >= maxDecodingCount || (waitingBytes >= m_memoryBudget && !idle)) {
+            break;
+        }
+        const size_t index = m_nextIndex++;
+        m_started.push_back(index);
+        m_decodingCount.fetch_add(1, std::memory_order_relaxed);
+        m_jobSystem.run(m_counters[index], [this, index]() {
+            TextureBatchResult result = {index, 0, nullptr};
+            try {
+                result.bytes = m_decode(index);
+            } catch (...) {
+                result.error = std::current_exception();
+            }
+            const uint64_t waitingBytes =
+                m_waitingBytes.fetch_add(result.bytes, std::memory_order_relaxed) + result.bytes;
+            uint64_t peakBytes = m_peakBytes.load(std::memory_order_relaxed);
+            while (waitingBytes > peakBytes &&
+                   !m_peakBytes.compare_exchange_weak(peakBytes, waitingBytes, std::memory_order_relaxed)) {
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_finishedMutex);
+                m_finished.push_back(std::move(result));
+            }
+            m_decodingCount.fetch_sub(1, std::memory_order_release);
+        });
+    }
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class JobCounter;
+class JobSystem;
+
+// Decodes a batch of textures in parallel on the job system and hands each one over as soon as it is done,
+// so the first uploads overlap the decoding of the rest. Memory is bounded by a budget on the decoded bytes
+// not yet handed over: a decode starts only while they are under it (or nothing else is in flight, so a
+// texture larger than the budget still loads), and at most one decode runs per job system thread. The
+// budget is thus exceeded by at most the textures already decoding when it was checked.
+// The batch does not know what a texture decodes to: decode(index) stores its result where the caller wants
+// it (e.g. a slot per file) and returns the bytes it holds.
+
+struct TextureBatchResult {
+    size_t index;
+    uint64_t bytes; // Returned by decode
+    std::exception_ptr error; // What decode threw, if it failed
+};
+
+class TextureBatch {
+public:
+    using Decoder = std::function<uint64_t(size_t index)>;
+
+    // Starts the first decodes right away
+    TextureBatch(JobSystem& jobSystem, size_t count, uint64_t memoryBudget, Decoder decode);
+
+    // Waits for the decodes still running; the others never start
+    ~TextureBatch();
+
+    TextureBatch(const TextureBatch&) = delete;
+
+    TextureBatch& operator=(const TextureBatch&) = delete;
+
+    // Appends the textures finished since the last call, in the order they finished (their bytes stop
+    // counting), then starts decodes as the budget allows. Never blocks, e.g. for a poll once per frame.
+    void poll(std::vector<TextureBatchResult>& outFinished);
+
+    // poll(), after waiting for the oldest running decode (executing jobs meanwhile) if none has finished
+    void wait(std::vector<TextureBatchResult>& outFinished);
+
+    // Every texture has been handed over
+    bool isDone() const {
+        return m_handedOverCount == m_count;
+    }
+
+    // Most decoded bytes waiting to be handed over at once, e.g. to tune the budget
+    uint64_t getPeakBytes() const {
+        return m_peakBytes.load(std::memory_order_relaxed);
+    }
+
+private:
+    void startDecodes();
+
+    JobSystem& m_jobSystem;
+    size_t m_count;
+    uint64_t m_memoryBudget;
+    Decoder m_decode;
+    std::unique_ptr<JobCounter[]> m_counters; // One per texture, so wait() can wait for a single decode
+    size_t m_nextIndex = 0; // Next texture to start
+    size_t m_handedOverCount = 0;
+    std::vector<size_t> m_started; // Started and not handed over yet, in start order
+
+    std::mutex m_finishedMutex; // Guards m_finished
+    std::vector<TextureBatchResult> m_finished; // Not handed over yet
+    std::atomic<size_t> m_decodingCount{0};
+    std::atomic<uint64_t> m_waitingBytes{0};
+    std::atomic<uint64_t> m_peakBytes{0};
+};
@@ -0,0 +1,525 @@
+#include "TextureContainer.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+#include "VirtualFileSystem.hpp"
+
+namespace {
+    // --- DDS ---
+
+    constexpr uint32_t kDdsMagic = 0x20534444; // "DDS "
+    constexpr uint32_t kDdsHeaderSize = 124;
+    constexpr uint32_t kDdsPixelFormatSize = 32;
+
+    constexpr uint32_t kDdsFlagCaps = 0x1;
+    constexpr uint32_t kDdsFlagHeight = 0x2;
+    constexpr uint32_t kDdsFlagWidth = 0x4;
+    constexpr uint32_t kDdsFlagPitch = 0x8;
+    constexpr uint32_t kDdsFlagPixelFormat = 0x1000;
+    constexpr uint32_t kDdsFlagMipMapCount = 0x20000;
+    constexpr uint32_t kDdsFlagLinearSize = 0x80000;
+    constexpr uint32_t kDdsFlagDepth = 0x800000;
+
+    constexpr uint32_t kDdsCapsComplex = 0x8;
+    constexpr uint32_t kDdsCapsTexture = 0x1000;
+    constexpr uint32_t kDdsCapsMipMap = 0x400000;
+    constexpr uint32_t kDdsCaps2CubeMap = 0x200;
+    constexpr uint32_t kDdsCaps2Volume = 0x200000;
+
+    constexpr uint32_t kDdsPixelAlpha = 0x1;
+    constexpr uint32_t kDdsPixelFourCC = 0x4;
+    constexpr uint32_t kDdsPixelRgb = 0x40;
+
+    constexpr uint32_t makeFourCC(char a, char b, char c, char d) {
+        return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) |
+               (uint32_t(uint8_t(d)) << 24);
+    }
+
+    constexpr uint32_t kDdsFourCCDx10 = makeFourCC('D', 'X', '1', '0');
+
+    constexpr uint32_t kDdsDimensionTexture2D = 3; // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+    constexpr uint32_t kDdsMiscTextureCube = 0x4;
+
+    struct DdsPixelFormat {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t fourCC;
+        uint32_t rgbBitCount;
+        uint32_t redMask;
+        uint32_t greenMask;
+        uint32_t blueMask;
+        uint32_t alphaMask;
+    };
+
+    struct DdsHeader {
+        uint32_t size;
+        uint32_t flags;
+        uint32_t height;
+        uint32_t width;
+        uint32_t pitchOrLinearSize;
+        uint32_t depth;
+        uint32_t mipMapCount;
+        uint32_t reserved1[11];
+        DdsPixelFormat pixelFormat;
+        uint32_t caps;
+        uint32_t caps2;
+        uint32_t caps3;
+        uint32_t caps4;
+        uint32_t reserved2;
+    };
+
+    struct DdsHeaderDx10 {
+        uint32_t dxgiFormat;
+        uint32_t resourceDimension;
+        uint32_t miscFlag;
+        uint32_t arraySize;
+        uint32_t miscFlags2;
+    };
+
+    static_assert(sizeof(DdsHeader) == kDdsHeaderSize, "DDS_HEADER layout");
+    static_assert(sizeof(DdsHeaderDx10) == 20, "DDS_HEADER_DXT10 layout");
+
+    // DXGI_FORMAT values
+    struct DxgiFormatMapping {
+        uint32_t dxgiFormat;
+        TextureFormat format;
+    };
+
+    constexpr DxgiFormatMapping kDxgiFormats[] = {
+        {28, TextureFormat::Rgba8}, // R8G8B8A8_UNORM
+        {29, TextureFormat::Rgba8}, // R8G8B8A8_UNORM_SRGB
+        {71, TextureFormat::Bc1}, // BC1_UNORM
+        {72, TextureFormat::Bc1}, // BC1_UNORM_SRGB
+        {77, TextureFormat::Bc3}, // BC3_UNORM
+        {78, TextureFormat::Bc3}, // BC3_UNORM_SRGB
+        {83, TextureFormat::Bc5}, // BC5_UNORM
+        {98, TextureFormat::Bc7}, // BC7_UNORM
+        {99, TextureFormat::Bc7}, // BC7_UNORM_SRGB
+    };
+
+    // --- KTX2 ---
+
+    constexpr uint8_t kKtx2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    struct Ktx2Header {
+        uint8_t identifier[12];
+        uint32_t vkFormat;
+        uint32_t typeSize;
+        uint32_t pixelWidth;
+        uint32_t pixelHeight;
+        uint32_t pixelDepth;
+        uint32_t layerCount;
+        uint32_t faceCount;
+        uint32_t levelCount;
+        uint32_t supercompressionScheme;
+        uint32_t dfdByteOffset;
+        uint32_t dfdByteLength;
+        uint32_t kvdByteOffset;
+        uint32_t kvdByteLength;
+        uint64_t sgdByteOffset;
+        uint64_t sgdByteLength;
+    };
+
+    struct Ktx2Level {
+        uint64_t byteOffset;
+        uint64_t byteLength;
+        uint64_t uncompressedByteLength;
+    };
+
+    static_assert(sizeof(Ktx2Header) == 80, "KTX2 header layout");
+    static_assert(sizeof(Ktx2Level) == 24, "KTX2 level index layout");
+
+    // VkFormat values, and the data format descriptor of each format this code writes
+    struct VkFormatMapping {
+        uint32_t vkFormat;
+        TextureFormat format;
+    };
+
+    constexpr VkFormatMapping kVkFormats[] = {
+        {37, TextureFormat::Rgba8}, // R8G8B8A8_UNORM
+        {43, TextureFormat::Rgba8}, // R8G8B8A8_SRGB
+        {131, TextureFormat::Bc1}, // BC1_RGB_UNORM_BLOCK
+        {132, TextureFormat::Bc1}, // BC1_RGB_SRGB_BLOCK
+        {133, TextureFormat::Bc1}, // BC1_RGBA_UNORM_BLOCK
+        {134, TextureFormat::Bc1}, // BC1_RGBA_SRGB_BLOCK
+        {137, TextureFormat::Bc3}, // BC3_UNORM_BLOCK
+        {138, TextureFormat::Bc3}, // BC3_SRGB_BLOCK
+        {141, TextureFormat::Bc5}, // BC5_UNORM_BLOCK
+        {145, TextureFormat::Bc7}, // BC7_UNORM_BLOCK
+        {146, TextureFormat::Bc7}, // BC7_SRGB_BLOCK
+    };
+
+    constexpr uint32_t kDfdModelRgbsda = 1;
+    constexpr uint32_t kDfdModelBc1a = 128;
+    constexpr uint32_t kDfdModelBc3 = 130;
+    constexpr uint32_t kDfdModelBc5 = 132;
+    constexpr uint32_t kDfdModelBc7 = 134;
+    constexpr uint32_t kDfdPrimariesBt709 = 1;
+    constexpr uint32_t kDfdTransferLinear = 1;
+
+    // --- Shared ---
+
+    [[noreturn]] void fail(const char* container, const std::string& name, const std::string& reason) {
+        throw std::runtime_error(std::string("Invalid ") + container + " file " + name + ": " + reason);
+    }
+
+    // Checks the size of a texture and points the view's levels at its tightly packed payload
+    void setLevels(const char* container, const std::string& name, const uint8_t* payload, size_t payloadSize,
+                   TextureContainerView& view) {
+        if (view.width == 0 || view.height == 0) {
+            fail(container, name, "empty texture");
+        }
+        if (view.mipCount > getMipCount(view.width, view.height)) {
+            fail(container, name, std::to_string(view.mipCount) + " mip levels for a texture of " +
+                                      std::to_string(view.width) + "x" + std::to_string(view.height));
+        }
+        if (isBlockCompressed(view.format) && (view.width % 4 != 0 || view.height % 4 != 0)) {
+            fail(container, name, "block-compressed textures must be a multiple of 4 texels wide and high");
+        }
+        if (payload) {
+            const size_t chainSize = getTextureChainSize(view.format, view.width, view.height, view.mipCount);
+            if (payloadSize < chainSize) {
+                fail(container, name, "truncated: " + std::to_string(payloadSize) + " bytes of texels instead of " +
+                                          std::to_string(chainSize));
+            }
+            view.levels.resize(view.mipCount);
+            for (uint32_t level = 0; level < view.mipCount; level++) {
+                view.levels[level] = payload + getTextureLevelOffset(view.format, view.width, view.height, level);
+            }
+        }
+    }
+
+    bool writeFile(const std::string& path, const std::vector<uint8_t>& header, const TextureImage& image,
+                   const std::vector<size_t>& levelOrder, size_t levelAlignment) {
+        const std::string tempPath = path + ".tmp";
+        FILE* file = fopen(tempPath.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        static const uint8_t zeros[16] = {};
+        bool ok = fwrite(header.data(), 1, header.size(), file) == header.size();
+        size_t position = header.size();
+        for (size_t level : levelOrder) {
+            const size_t padding = (levelAlignment - position % levelAlignment) % levelAlignment;
+            const size_t offset = getTextureLevelOffset(image.format, image.width, image.height,
+                                                        static_cast<uint32_t>(level));
+            const size_t size = getTextureLevelSize(image.format, getMipSize(image.width, static_cast<uint32_t>(level)),
+                                                    getMipSize(image.height, static_cast<uint32_t>(level)));
+            ok = ok && fwrite(zeros, 1, padding, file) == padding &&
+                 fwrite(image.pixels.data() + offset, 1, size, file) == size;
+            position += padding + size;
+        }
+        ok = (fclose(file) == 0) && ok;
+        std::error_code ec;
+        if (ok) {
+            std::filesystem::rename(tempPath, path, ec);
+            ok = !ec;
+        }
+        if (!ok) {
+            std::filesystem::remove(tempPath, ec);
+        }
+        return ok;
+    }
+
+    template <typename T>
+    void append(std::vector<uint8_t>& bytes, const T& value) {
+        const uint8_t* begin = reinterpret_cast<const uint8_t*>(&value);
+        bytes.insert(bytes.end(), begin, begin + sizeof(T));
+    }
+
+    bool isValidImage(const TextureImage& image) {
+        return image.width > 0 && image.height > 0 && image.mipCount > 0 &&
+               image.mipCount <= getMipCount(image.width, image.height) &&
+               image.pixels.size() >= getTextureChainSize(image.format, image.width, image.height, image.mipCount);
+    }
+}
+
+bool isTextureContainerFile(const std::string& filename) {
+    std::string extension = std::filesystem::path(filename).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".dds" || extension == ".ktx2";
+}
+
+void parseDdsFile(const uint8_t* data, size_t size, const std::string& name, TextureContainerView& outView) {
+    uint32_t magic = 0;
+    if (size >= 4) {
+        memcpy(&magic, data, 4);
+    }
+    if (magic != kDdsMagic) {
+        fail("DDS", name, "not a DDS file");
+    }
+    DdsHeader header;
+    if (size < 4 + sizeof(header)) {
+        fail("DDS", name, "truncated header");
+    }
+    memcpy(&header, data + 4, sizeof(header));
+    if (header.size != kDdsHeaderSize || header.pixelFormat.size != kDdsPixelFormatSize) {
+        fail("DDS", name, "invalid header size");
+    }
+    if ((header.caps2 & (kDdsCaps2CubeMap | kDdsCaps2Volume)) != 0 ||
+        ((header.flags & kDdsFlagDepth) != 0 && header.depth > 1)) {
+        fail("DDS", name, "only 2D textures are supported, not cube maps or volumes");
+    }
+    size_t payloadOffset = 4 + sizeof(header);
+
+    const DdsPixelFormat& pixelFormat = header.pixelFormat;
+    bool supported = true;
+    if ((pixelFormat.flags & kDdsPixelFourCC) != 0 && pixelFormat.fourCC == kDdsFourCCDx10) {
+        DdsHeaderDx10 dx10;
+        if (size < payloadOffset + sizeof(dx10)) {
+            fail("DDS", name, "truncated DX10 header");
+        }
+        memcpy(&dx10, data + payloadOffset, sizeof(dx10));
+        payloadOffset += sizeof(dx10);
+        if (dx10.resourceDimension != kDdsDimensionTexture2D || (dx10.miscFlag & kDdsMiscTextureCube) != 0 ||
+            dx10.arraySize > 1) {
+            fail("DDS", name, "only 2D textures are supported, not arrays, cube maps or volumes");
+        }
+        const auto found = std::find_if(std::begin(kDxgiFormats), std::end(kDxgiFormats),
+                                        [&](const DxgiFormatMapping& mapping) {
+                                            return mapping.dxgiFormat == dx10.dxgiFormat;
+                                        });
+        if (found == std::end(kDxgiFormats)) {
+            fail("DDS", name, "unsupported DXGI format " + std::to_string(dx10.dxgiFormat));
+        }
+        outView.format = found->format;
+    } else if ((pixelFormat.flags & kDdsPixelFourCC) != 0) {
+        if (pixelFormat.fourCC == makeFourCC('D', 'X', 'T', '1')) {
+            outView.format = TextureFormat::Bc1;
+        } else if (pixelFormat.fourCC == makeFourCC('D', 'X', 'T', '5')) {
+            outView.format = TextureFormat::Bc3;
+        } else if (pixelFormat.fourCC == makeFourCC('A', 'T', 'I', '2') ||
+                   pixelFormat.fourCC == makeFourCC('B', 'C', '5', 'U')) {
+            outView.format = TextureFormat::Bc5;
+        } else {
+            supported = false;
+        }
+    } else {
+        // Only the byte order of R8G8B8A8; others (e.g. B8G8R8A8) would need swizzling
+        supported = (pixelFormat.flags & (kDdsPixelRgb | kDdsPixelAlpha)) == (kDdsPixelRgb | kDdsPixelAlpha) &&
+                    pixelFormat.rgbBitCount == 32 && pixelFormat.redMask == 0x000000FF &&
+                    pixelFormat.greenMask == 0x0000FF00 && pixelFormat.blueMask == 0x00FF0000 &&
+                    pixelFormat.alphaMask == 0xFF000000;
+        outView.format = TextureFormat::Rgba8;
+    }
+    if (!supported) {
+        fail("DDS", name, "unsupported pixel format");
+    }
+
+    outView.width = header.width;
+    outView.height = header.height;
+    outView.mipCount = std::max(header.mipMapCount, 1u); // Some writers leave out kDdsFlagMipMapCount
+    setLevels("DDS", name, data + payloadOffset, size - payloadOffset, outView);
+}
+
+void parseKtx2File(const uint8_t* data, size_t size, const std::string& name, TextureContainerView& outView) {
+    if (size < sizeof(kKtx2Identifier) || memcmp(data, kKtx2Identifier, sizeof(kKtx2Identifier)) != 0) {
+        fail("KTX2", name, "not a KTX2 file");
+    }
+    Ktx2Header header;
+    if (size < sizeof(header)) {
+        fail("KTX2", name, "truncated header");
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.pixelDepth != 0 || header.layerCount > 1 || header.faceCount != 1) {
+        fail("KTX2", name, "only 2D textures are supported, not arrays, cube maps or volumes");
+    }
+    if (header.supercompressionScheme != 0) {
+        fail("KTX2", name, "supercompression scheme " + std::to_string(header.supercompressionScheme) +
+                               " is not supported");
+    }
+    const auto found = std::find_if(std::begin(kVkFormats), std::end(kVkFormats),
+                                    [&](const VkFormatMapping& mapping) {
+                                        return mapping.vkFormat == header.vkFormat;
+                                    });
+    if (found == std::end(kVkFormats)) {
+        fail("KTX2", name, "unsupported VkFormat " + std::to_string(header.vkFormat));
+    }
+    outView.format = found->format;
+    outView.width = header.pixelWidth;
+    outView.height = header.pixelHeight;
+    outView.mipCount = std::max(header.levelCount, 1u); // 0 asks the loader to generate mips: we keep level 0
+    setLevels("KTX2", name, nullptr, 0, outView);
+
+    // Every level has its own offset: writers usually store the smallest first
+    const size_t indexSize = sizeof(Ktx2Level) * outView.mipCount;
+    if (size < sizeof(header) + indexSize) {
+        fail("KTX2", name, "truncated level index");
+    }
+    outView.levels.resize(outView.mipCount);
+    for (uint32_t level = 0; level < outView.mipCount; level++) {
+        Ktx2Level entry;
+        memcpy(&entry, data + sizeof(header) + level * sizeof(Ktx2Level), sizeof(entry));
+        const size_t levelSize = getTextureLevelSize(outView.format, getMipSize(outView.width, level),
+                                                     getMipSize(outView.height, level));
+        if (entry.byteLength != levelSize || entry.uncompressedByteLength != levelSize) {
+            fail("KTX2", name, "level " + std::to_string(level) + " holds " + std::to_string(entry.byteLength) +
+                                   " bytes instead of " + std::to_string(levelSize));
+        }
+        if (entry.byteOffset > size || entry.byteLength > size - entry.byteOffset) {
+            fail("KTX2", name, "level " + std::to_string(level) + " is past the end of the file");
+        }
+        outView.levels[level] = data + entry.byteOffset;
+    }
+}
+
+void parseTextureContainer(const uint8_t* data, size_t size, const std::string& name,
+                           TextureContainerView& outView) {
+    if (size >= sizeof(kKtx2Identifier) && memcmp(data, kKtx2Identifier, sizeof(kKtx2Identifier)) == 0) {
+        parseKtx2File(data, size, name, outView);
+    } else {
+        parseDdsFile(data, size, name, outView);
+    }
+}
+
+TextureImage loadTextureContainer(const std::string& filename, const VirtualFileSystem* fileSystem) {
+    VirtualFile file;
+    if (!openFile(fileSystem, filename, file)) {
+        throw std::runtime_error("Failed to load texture file: " + filename);
+    }
+    TextureContainerView view;
+    parseTextureContainer(file.data(), file.size(), filename, view);
+    TextureImage image;
+    image.width = view.width;
+    image.height = view.height;
+    image.mipCount = view.mipCount;
+    image.format = view.format;
+    image.pixels.resize(getTextureChainSize(view.format, view.width, view.height, view.mipCount));
+    for (uint32_t level = 0; level < view.mipCount; level++) {
+        memcpy(image.pixels.data() + getTextureLevelOffset(view.format, view.width, view.height, level),
+               view.levels[level],
+               getTextureLevelSize(view.format, getMipSize(view.width, level), getMipSize(view.height, level)));
+    }
+    return image;
+}
+
+bool writeDdsFile(const std::string& path, const TextureImage& image) {
+    if (!isValidImage(image)) {
+        return false;
+    }
+    DdsHeader header = {};
+    header.size = kDdsHeaderSize;
+    header.flags = kDdsFlagCaps | kDdsFlagHeight | kDdsFlagWidth | kDdsFlagPixelFormat | kDdsFlagMipMapCount |
+                   (isBlockCompressed(image.format) ? kDdsFlagLinearSize : kDdsFlagPitch);
+    header.height = image.height;
+    header.width = image.width;
+    header.pitchOrLinearSize = static_cast<uint32_t>(
+        isBlockCompressed(image.format) ? getTextureLevelSize(image.format, image.width, image.height)
+                                        : getTextureRowPitch(image.format, image.width));
+    header.mipMapCount = image.mipCount;
+    header.pixelFormat.size = kDdsPixelFormatSize;
+    header.pixelFormat.flags = kDdsPixelFourCC;
+    header.pixelFormat.fourCC = kDdsFourCCDx10;
+    header.caps = kDdsCapsTexture | (image.mipCount > 1 ? kDdsCapsComplex | kDdsCapsMipMap : 0);
+
+    DdsHeaderDx10 dx10 = {};
+    dx10.dxgiFormat = std::find_if(std::begin(kDxgiFormats), std::end(kDxgiFormats),
+                                   [&](const DxgiFormatMapping& mapping) {
+                                       return mapping.format == image.format;
+                                   })->dxgiFormat;
+    dx10.resourceDimension = kDdsDimensionTexture2D;
+    dx10.arraySize = 1;
+
+    std::vector<uint8_t> bytes;
+    append(bytes, kDdsMagic);
+    append(bytes, header);
+    append(bytes, dx10);
+    std::vector<size_t> levelOrder(image.mipCount);
+    for (size_t level = 0; level < levelOrder.size(); level++) {
+        levelOrder[level] = level;
+    }
+    return writeFile(path, bytes, image, levelOrder, 1);
+}
+
+bool writeKtx2File(const std::string& path, const TextureImage& image) {
+    if (!isValidImage(image)) {
+        return false;
+    }
+    // Basic data format descriptor: one sample per channel of RGBA8, one or two 64/128-bit samples per block
+    struct Sample {
+        uint32_t bitOffset;
+        uint32_t bitLength;
+        uint32_t channel;
+        uint32_t upper;
+    };
+    std::vector<Sample> samples;
+    uint32_t model = kDfdModelRgbsda;
+    switch (image.format) {
+        case TextureFormat::Rgba8:
+            samples = {{0, 8, 0, 255}, {8, 8, 1, 255}, {16, 8, 2, 255}, {24, 8, 15, 255}};
+            break;
+        case TextureFormat::Bc1:
+            model = kDfdModelBc1a;
+            samples = {{0, 64, 0, UINT32_MAX}};
+            break;
+        case TextureFormat::Bc3:
+            model = kDfdModelBc3;
+            samples = {{0, 64, 15, UINT32_MAX}, {64, 64, 0, UINT32_MAX}}; // Alpha block, then color
+            break;
+        case TextureFormat::Bc5:
+            model = kDfdModelBc5;
+            samples = {{0, 64, 0, UINT32_MAX}, {64, 64, 1, UINT32_MAX}}; // Red, then green
+            break;
+        case TextureFormat::Bc7:
+            model = kDfdModelBc7;
+            samples = {{0, 128, 0, UINT32_MAX}};
+            break;
+    }
+    const uint32_t blockDimension = isBlockCompressed(image.format) ? 3 : 0; // 4x4 blocks, stored minus one
+    const uint32_t blockSize = static_cast<uint32_t>(getBlockSize(image.format));
+    std::vector<uint8_t> dfd;
+    append(dfd, static_cast<uint32_t>(4 + 24 + 16 * samples.size())); // dfdTotalSize
+    append(dfd, uint32_t(0)); // Khronos vendor, basic descriptor type
+    append(dfd, static_cast<uint32_t>(2 | ((24 + 16 * samples.size()) << 16))); // Version 2, block size
+    append(dfd, model | (kDfdPrimariesBt709 << 8) | (kDfdTransferLinear << 16));
+    append(dfd, blockDimension | (blockDimension << 8));
+    append(dfd, blockSize); // bytesPlane0
+    append(dfd, uint32_t(0));
+    for (const Sample& sample : samples) {
+        append(dfd, sample.bitOffset | ((sample.bitLength - 1) << 16) | (sample.channel << 24));
+        append(dfd, uint32_t(0)); // Sample position
+        append(dfd, uint32_t(0)); // Lower
+        append(dfd, sample.upper);
+    }
+
+    Ktx2Header header = {};
+    memcpy(header.identifier, kKtx2Identifier, sizeof(kKtx2Identifier));
+    header.vkFormat = std::find_if(std::begin(kVkFormats), std::end(kVkFormats), [&](const VkFormatMapping& mapping) {
+                          return mapping.format == image.format;
+                      })->vkFormat;
+    header.typeSize = 1;
+    header.pixelWidth = image.width;
+    header.pixelHeight = image.height;
+    header.faceCount = 1;
+    header.levelCount = image.mipCount;
+    header.dfdByteOffset = static_cast<uint32_t>(sizeof(Ktx2Header) + sizeof(Ktx2Level) * image.mipCount);
+    header.dfdByteLength = static_cast<uint32_t>(dfd.size());
+
+    // The smallest level first, each at a multiple of the block size (lcm with 4, as the format requires)
+    const size_t levelAlignment = std::max<size_t>(blockSize, 4);
+    std::vector<Ktx2Level> levels(image.mipCount);
+    std::vector<size_t> levelOrder;
+    size_t position = header.dfdByteOffset + dfd.size();
+    for (uint32_t level = image.mipCount; level-- > 0;) {
+        position = (position + levelAlignment - 1) / levelAlignment * levelAlignment;
+        const size_t size = getTextureLevelSize(image.format, getMipSize(image.width, level),
+                                                getMipSize(image.height, level));
+        levels[level] = {position, size, size};
+        levelOrder.push_back(level);
+        position += size;
+    }
+
+    std::vector<uint8_t> bytes;
+    append(bytes, header);
+    for (const Ktx2Level& level : levels) {
+        append(bytes, level);
+    }
+    bytes.insert(bytes.end(), dfd.begin(), dfd.end());
+    return writeFile(path, bytes, image, levelOrder, levelAlignment);
+}
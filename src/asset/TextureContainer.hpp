@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TextureImport.hpp"
+
+class VirtualFileSystem;
+
+// DDS and KTX2 containers of prebuilt textures: their mip chains and block-compressed payloads are used as
+// they are, with no decoding, filtering or encoding at load time. Only 2D textures in the TextureFormat
+// formats are supported, i.e. DDS with a DX10 header (or the legacy DXT1, DXT5, ATI2/BC5U and RGBA8 pixel
+// formats) and uncompressed KTX2 (no supercompression, e.g. Basis or Zstandard). The _SRGB variants of the
+// formats load like the UNORM ones, just as PNGs do: both renderers sample every texture as UNORM.
+
+// A parsed container: the levels point into the file's bytes, which must outlive the view
+struct TextureContainerView {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipCount = 0;
+    TextureFormat format = TextureFormat::Rgba8;
+    std::vector<const uint8_t*> levels; // getTextureLevelSize(format, level size) bytes each, tightly packed
+};
+
+// True for the ".dds" and ".ktx2" extensions, in any case
+bool isTextureContainerFile(const std::string& filename);
+
+// Parse a file already in memory. Throw std::runtime_error naming the file if it is malformed, truncated or
+// holds an unsupported kind of texture (volume, cube map, array or format).
+void parseDdsFile(const uint8_t* data, size_t size, const std::string& name, TextureContainerView& outView);
+
+void parseKtx2File(const uint8_t* data, size_t size, const std::string& name, TextureContainerView& outView);
+
+// Either of the above, by the file's signature
+void parseTextureContainer(const uint8_t* data, size_t size, const std::string& name,
+                           TextureContainerView& outView);
+
+// Reads a container through the file system (loose files when null) into an image ready to upload. Throws
+// std::runtime_error.
+TextureImage loadTextureContainer(const std::string& filename, const VirtualFileSystem* fileSystem = nullptr);
+
+// Write an image with all its levels, e.g. to precompute textures (see texcontainer convert). DDS files get
+// a DX10 header; KTX2 files a basic data format descriptor and no key/value data. Return false if the file
+// cannot be written.
+bool writeDdsFile(const std::string& path, const TextureImage& image);
+
+bool writeKtx2File(const std::string& path, const TextureImage& image);
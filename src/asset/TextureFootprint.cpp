@@ -0,0 +1,28 @@
+#include "TextureFootprint.hpp"
+
+#include "MipGenerator.hpp"
+
+namespace {
+    uint64_t alignUp(uint64_t value, uint64_t alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+uint64_t getCopyableFootprints(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount,
+                               TextureFootprint* footprints) {
+    const uint32_t blockSize = isBlockCompressed(format) ? 4 : 1;
+    uint64_t end = 0;
+    for (uint32_t level = 0; level < mipCount; level++) {
+        const uint32_t levelWidth = getMipSize(width, level);
+        const uint32_t levelHeight = getMipSize(height, level);
+        TextureFootprint& footprint = footprints[level];
+        footprint.offset = alignUp(end, kTexturePlacementAlignment);
+        footprint.width = static_cast<uint32_t>(alignUp(levelWidth, blockSize));
+        footprint.height = static_cast<uint32_t>(alignUp(levelHeight, blockSize));
+        footprint.rowSize = getTextureRowPitch(format, levelWidth);
+        footprint.rowPitch = static_cast<uint32_t>(alignUp(footprint.rowSize, kTexturePitchAlignment));
+        footprint.rowCount = getTextureRowCount(format, levelHeight);
+        end = footprint.offset + uint64_t(footprint.rowPitch) * (footprint.rowCount - 1) + footprint.rowSize;
+    }
+    return end;
+}
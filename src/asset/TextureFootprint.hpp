@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "BlockCompression.hpp"
+
+// Layout of a texture's levels in a D3D12 upload buffer, computed by the rules of
+// ID3D12Device::GetCopyableFootprints, so the upload path can be planned (and tested) without a device:
+// every row starts at a multiple of D3D12_TEXTURE_DATA_PITCH_ALIGNMENT, every level at a multiple of
+// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, and block-compressed levels count rows of 4x4 blocks.
+
+constexpr uint32_t kTexturePitchAlignment = 256; // D3D12_TEXTURE_DATA_PITCH_ALIGNMENT
+constexpr uint64_t kTexturePlacementAlignment = 512; // D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT
+
+// One level, like a D3D12_PLACED_SUBRESOURCE_FOOTPRINT plus the row count and size the device reports
+struct TextureFootprint {
+    uint64_t offset; // From the start of the buffer
+    uint32_t width; // Texels, padded to whole blocks
+    uint32_t height;
+    uint32_t rowPitch; // Bytes from one row of texels or blocks to the next
+    uint32_t rowCount;
+    uint64_t rowSize; // Bytes of texels in a row, without the padding
+};
+
+// Fills footprints[0 .. mipCount) for the levels of a 2D texture and returns the total bytes, which (like
+// GetCopyableFootprints) leaves out the padding after the last row
+uint64_t getCopyableFootprints(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount,
+                               TextureFootprint* footprints);
@@ -0,0 +1,311 @@
+#include "TextureImport.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#include "DerivedDataCache.hpp"
+#include "Hash.hpp"
+#include "TextureContainer.hpp"
+#include "VirtualFileSystem.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../libs/stb/stb_image.hpp"
+
+namespace {
+    // Bump whenever the import code changes its output so stale caches get rebuilt
+    constexpr uint64_t kTextureImportRevision = 3;
+
+    TextureFormat selectTextureFormat(const TextureImage& image, TextureCompression compression,
+                                      const std::string& filename) {
+        if (compression == TextureCompression::None) {
+            return TextureFormat::Rgba8;
+        }
+        if (image.width % 4 != 0 || image.height % 4 != 0) {
+            std::cerr << "Warning: " << filename << " is " << image.width << "x" << image.height
+                      << ", not a multiple of 4; it stays uncompressed" << std::endl;
+            return TextureFormat::Rgba8;
+        }
+        switch (compression) {
+            case TextureCompression::Bc1:
+                return TextureFormat::Bc1;
+            case TextureCompression::Bc3:
+                return TextureFormat::Bc3;
+            case TextureCompression::Bc5:
+                return TextureFormat::Bc5;
+            case TextureCompression::Bc7:
+                return TextureFormat::Bc7;
+            default:
+                break;
+        }
+        // Level 0 decides: filtering only averages alpha, so opaque images have opaque mips
+        const size_t texelCount = size_t(image.width) * image.height;
+        for (size_t i = 0; i < texelCount; i++) {
+            if (image.pixels[i * 4 + 3] != 255) {
+                return TextureFormat::Bc3;
+            }
+        }
+        return TextureFormat::Bc1;
+    }
+
+    // Maps a texture cache and validates it; its pixels follow the header in the file
+    bool openTextureCache(const std::string& path, TextureCacheHeader& outHeader, VirtualFile& outFile,
+                          const VirtualFileSystem* fileSystem) {
+        if (!openFile(fileSystem, path, outFile) || outFile.size() < sizeof(TextureCacheHeader)) {
+            return false;
+        }
+        memcpy(&outHeader, outFile.data(), sizeof(outHeader));
+        const uint8_t* pixels = outFile.data() + sizeof(TextureCacheHeader);
+        if (outHeader.magic != kTextureCacheMagic || outHeader.version != kTextureCacheVersion ||
+            outHeader.width == 0 || outHeader.height == 0 || outHeader.mipCount == 0 ||
+            outHeader.mipCount > getMipCount(outHeader.width, outHeader.height) ||
+            outHeader.format >= kTextureFormatCount) {
+            return false;
+        }
+        const TextureFormat format = static_cast<TextureFormat>(outHeader.format);
+        return (!isBlockCompressed(format) || (outHeader.width % 4 == 0 && outHeader.height % 4 == 0)) &&
+               outHeader.pixelsSize == outFile.size() - sizeof(TextureCacheHeader) &&
+               outHeader.pixelsSize ==
+                   getTextureChainSize(format, outHeader.width, outHeader.height, outHeader.mipCount) &&
+               hash64(pixels, static_cast<size_t>(outHeader.pixelsSize)) == outHeader.pixelsHash;
+    }
+
+    // A texture found by findTexture: its levels are in a cache or container file still open, or in an
+    // imported image
+    struct FoundTexture {
+        VirtualFile file;
+        TextureImage image; // Without pixels when they are in the file
+        std::vector<const uint8_t*> levels;
+        bool fromCache = false;
+    };
+
+    void setPackedLevels(FoundTexture& found, const uint8_t* pixels) {
+        const TextureImage& image = found.image;
+        found.levels.resize(image.mipCount);
+        for (uint32_t level = 0; level < image.mipCount; level++) {
+            found.levels[level] = pixels + getTextureLevelOffset(image.format, image.width, image.height, level);
+        }
+    }
+
+    bool findTextureCache(const std::string& path, TextureCacheHeader& outHeader, FoundTexture& found,
+                          const VirtualFileSystem* fileSystem) {
+        if (!openTextureCache(path, outHeader, found.file, fileSystem)) {
+            found.file.close();
+            return false;
+        }
+        found.image.width = outHeader.width;
+        found.image.height = outHeader.height;
+        found.image.mipCount = outHeader.mipCount;
+        found.image.format = static_cast<TextureFormat>(outHeader.format);
+        found.fromCache = true;
+        setPackedLevels(found, found.file.data() + sizeof(TextureCacheHeader));
+        return true;
+    }
+
+    // The lookup of loadTexture, which leaves cached and prebuilt levels in the mapped file
+    void findTexture(const std::string& filename, const TextureImportOptions& options, FoundTexture& found) {
+        // Prebuilt containers are used as they are, whatever the import options
+        if (isTextureContainerFile(filename)) {
+            if (!openFile(options.fileSystem, filename, found.file)) {
+                throw std::runtime_error("Failed to load texture file: " + filename);
+            }
+            TextureContainerView view;
+            parseTextureContainer(found.file.data(), found.file.size(), filename, view);
+            found.image.width = view.width;
+            found.image.height = view.height;
+            found.image.mipCount = view.mipCount;
+            found.image.format = view.format;
+            found.levels = std::move(view.levels);
+            return;
+        }
+
+        const std::string sidecarPath = filename + ".texcache";
+        const uint64_t optionsHash = hashTextureImportOptions(options);
+        TextureCacheHeader header = {};
+
+        // Packed assets ship their caches, so the pack is trusted without looking at the source on disk
+        const VirtualFileSystem* fileSystem = options.fileSystem;
+        if (options.useCache && fileSystem && fileSystem->isPacked(sidecarPath) &&
+            findTextureCache(sidecarPath, header, found, fileSystem) && header.optionsHash == optionsHash) {
+            return;
+        }
+        if (fileSystem && fileSystem->isPacked(filename)) {
+            found = FoundTexture();
+            found.image = importTextureFile(filename, options);
+            setPackedLevels(found, found.image.pixels.data());
+            return;
+        }
+        if (fileSystem && !fileSystem->exists(filename)) {
+            throw std::runtime_error("Failed to load texture file: " + filename); // Loose files are disabled
+        }
+
+        // The header is checked first, so a stale cache is never read in full
+        if (options.useCache && readTextureCacheHeader(sidecarPath, header) &&
+            textureCacheMatchesSource(header, filename, optionsHash) &&
+            findTextureCache(sidecarPath, header, found, nullptr)) {
+            return;
+        }
+
+        std::string cachePath = sidecarPath;
+        DerivedDataCache* derivedData = options.useCache ? options.derivedDataCache : nullptr;
+        SourceStamp stamp;
+        if (derivedData && querySourceStamp(filename, stamp, true)) {
+            const uint64_t key = makeDerivedDataKey("texture", kTextureCacheVersion, stamp.contentHash, optionsHash);
+            cachePath = derivedData->getEntryPath(key, ".texcache");
+            if (findTextureCache(cachePath, header, found, nullptr) && header.optionsHash == optionsHash &&
+                header.sourceHash == stamp.contentHash) {
+                derivedData->touch(cachePath);
+                return;
+            }
+        } else {
+            derivedData = nullptr; // Unreadable source: the import below reports it
+        }
+
+        found = FoundTexture();
+        found.image = importTextureFile(filename, options);
+        setPackedLevels(found, found.image.pixels.data());
+        if (options.useCache) {
+            if ((!derivedData && !querySourceStamp(filename, stamp, true)) ||
+                !writeTextureCache(cachePath, found.image, stamp, optionsHash)) {
+                std::cerr << "Warning: could not write texture cache " << cachePath << std::endl;
+            } else if (derivedData) {
+                derivedData->recordWrite(cachePath);
+            }
+        }
+    }
+}
+
+uint64_t hashTextureImportOptions(const TextureImportOptions& options) {
+    uint64_t hash = hashCombine(0, kTextureImportRevision);
+    hash = hashCombine(hash, options.generateMips ? 1 : 0);
+    if (options.generateMips) {
+        hash = hashCombine(hash, static_cast<uint64_t>(options.mips.filter));
+        hash = hashCombine(hash, options.mips.srgb ? 1 : 0);
+    }
+    hash = hashCombine(hash, static_cast<uint64_t>(options.compression));
+    if (options.compression != TextureCompression::None) {
+        hash = hashCombine(hash, static_cast<uint64_t>(options.compressionQuality));
+    }
+    return hash;
+}
+
+TextureImage importTextureFile(const std::string& filename, const TextureImportOptions& options) {
+    VirtualFile file;
+    if (!openFile(options.fileSystem, filename, file)) {
+        throw std::runtime_error("Failed to load texture file: " + filename);
+    }
+    int width, height, channels;
+    unsigned char* pixels = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height,
+                                                  &channels, STBI_rgb_alpha);
+    if (!pixels) {
+        throw std::runtime_error("Failed to decode texture file: " + filename);
+    }
+    TextureImage image;
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixels.assign(pixels, pixels + size_t(width) * size_t(height) * 4);
+    stbi_image_free(pixels);
+    if (options.generateMips) {
+        generateMips(image, options.mips, options.jobSystem);
+    }
+    compressTexture(image, selectTextureFormat(image, options.compression, filename), options.compressionQuality,
+                    options.jobSystem);
+    return image;
+}
+
+bool readTextureCacheHeader(const std::string& path, TextureCacheHeader& outHeader) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fread(&outHeader, sizeof(outHeader), 1, file) == 1;
+    fclose(file);
+    return ok && outHeader.magic == kTextureCacheMagic && outHeader.version == kTextureCacheVersion;
+}
+
+bool readTextureCache(const std::string& path, TextureCacheHeader& outHeader, TextureImage& outImage,
+                      const VirtualFileSystem* fileSystem) {
+    VirtualFile file;
+    if (!openTextureCache(path, outHeader, file, fileSystem)) {
+        return false;
+    }
+    const uint8_t* pixels = file.data() + sizeof(TextureCacheHeader);
+    outImage.width = outHeader.width;
+    outImage.height = outHeader.height;
+    outImage.mipCount = outHeader.mipCount;
+    outImage.format = static_cast<TextureFormat>(outHeader.format);
+    outImage.pixels.assign(pixels, pixels + outHeader.pixelsSize);
+    return true;
+}
+
+bool textureCacheMatchesSource(const TextureCacheHeader& header, const std::string& sourcePath,
+                               uint64_t optionsHash) {
+    return header.optionsHash == optionsHash &&
+           sourceMatchesStamp(sourcePath, header.sourceSize, header.sourceTimestamp, header.sourceHash);
+}
+
+bool writeTextureCache(const std::string& path, const TextureImage& image, const SourceStamp& source,
+                       uint64_t optionsHash) {
+    TextureCacheHeader header = {};
+    header.magic = kTextureCacheMagic;
+    header.version = kTextureCacheVersion;
+    header.width = image.width;
+    header.height = image.height;
+    header.mipCount = image.mipCount;
+    header.format = static_cast<uint32_t>(image.format);
+    header.sourceSize = source.size;
+    header.sourceTimestamp = source.timestamp;
+    header.sourceHash = source.contentHash;
+    header.optionsHash = optionsHash;
+    header.pixelsSize = image.pixels.size();
+    header.pixelsHash = hash64(image.pixels.data(), image.pixels.size());
+
+    const std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(image.pixels.data(), 1, image.pixels.size(), file) == image.pixels.size();
+    ok = (fclose(file) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) {
+        std::filesystem::rename(tempPath, path, ec);
+        ok = !ec;
+    }
+    if (!ok) {
+        std::filesystem::remove(tempPath, ec);
+    }
+    return ok;
+}
+
+void loadTexture(const std::string& filename, const TextureImportOptions& options, ImportedTexture& outTexture) {
+    FoundTexture found;
+    findTexture(filename, options, found);
+    outTexture.fromCache = found.fromCache;
+    outTexture.image = std::move(found.image);
+    if (!found.file.isOpen()) {
+        return;
+    }
+    // Cached and prebuilt levels are copied out of the file
+    TextureImage& image = outTexture.image;
+    image.pixels.resize(getTextureChainSize(image.format, image.width, image.height, image.mipCount));
+    for (uint32_t level = 0; level < image.mipCount; level++) {
+        memcpy(image.pixels.data() + getTextureLevelOffset(image.format, image.width, image.height, level),
+               found.levels[level],
+               getTextureLevelSize(image.format, getMipSize(image.width, level), getMipSize(image.height, level)));
+    }
+}
+
+bool loadTextureForUpload(const std::string& filename, const TextureImportOptions& options,
+                          const TextureUploadAllocator& allocate, TextureUploadLayout& outLayout) {
+    FoundTexture found;
+    findTexture(filename, options, found);
+    const TextureImage& image = found.image;
+    outLayout = getTextureUploadLayout(image.format, image.width, image.height, image.mipCount);
+    writeTextureLevels(outLayout, found.levels.data(), allocate(outLayout));
+    return found.fromCache;
+}
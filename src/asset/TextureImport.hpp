@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BlockCompression.hpp"
+#include "MeshCache.hpp"
+#include "MipGenerator.hpp"
+#include "TextureUpload.hpp"
+
+class DerivedDataCache;
+class JobSystem;
+class VirtualFileSystem;
+
+// Decoded pixels, e.g. produced on a worker thread and uploaded later
+struct TextureImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipCount = 1;
+    TextureFormat format = TextureFormat::Rgba8;
+    // The levels back to back from level 0 (see getTextureLevelOffset), rows of texels or blocks top to bottom
+    std::vector<uint8_t> pixels;
+};
+
+// Binary texture cache (".texcache"): a fixed header followed by the pixels, ready to upload as they are.
+// Stamped with the source like a mesh cache, so the runtime can use one written by assetc.
+constexpr uint32_t kTextureCacheMagic = 0x43545844; // "DXTC"
+constexpr uint32_t kTextureCacheVersion = 3;
+
+struct TextureCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    uint32_t format; // TextureFormat
+    uint64_t sourceSize; // SourceStamp of the source image
+    int64_t sourceTimestamp;
+    uint64_t sourceHash;
+    uint64_t optionsHash;
+    uint64_t pixelsSize; // Bytes following the header
+    uint64_t pixelsHash; // hash64 of the pixels, so a corrupted file is rejected
+};
+
+enum class TextureCompression : uint32_t {
+    None, // RGBA8
+    Auto, // BC1 for opaque images, BC3 when any texel has alpha
+    Bc1,
+    Bc3,
+    Bc5, // Red and green only, e.g. tangent-space normal maps
+    Bc7,
+};
+
+struct TextureImportOptions {
+    bool useCache = true; // Read/write "<source>.texcache" next to the source file
+    // Without a valid "<source>.texcache", looks the cache up here (keyed by the source contents and the
+    // options hash) and writes new caches here instead; not part of the options hash
+    DerivedDataCache* derivedDataCache = nullptr;
+    const VirtualFileSystem* fileSystem = nullptr; // Reads the cache and the source through mounted packs
+    bool generateMips = true; // Full mip chain, so distant surfaces neither alias nor thrash the texture cache
+    MipOptions mips;
+    // Block compression cuts the memory and bandwidth of a texture by 4-8x. Levels of 4x4 blocks need a
+    // level 0 whose size is a multiple of 4 (a D3D12 requirement); other images stay RGBA8.
+    TextureCompression compression = TextureCompression::Auto;
+    BlockQuality compressionQuality = BlockQuality::Normal;
+    JobSystem* jobSystem = nullptr; // Filters and compresses in parallel; not part of the options hash
+};
+
+// Hash of every option that changes the imported pixels; stored in the cache header
+uint64_t hashTextureImportOptions(const TextureImportOptions& options);
+
+// Decodes an image file (PNG, JPEG, TGA, BMP, ... through stb_image) to RGBA8 through options.fileSystem,
+// generates its mips and compresses them as the options ask. Throws std::runtime_error.
+TextureImage importTextureFile(const std::string& filename, const TextureImportOptions& options);
+
+// Reads only the header; false if the file is missing or not a texture cache of this version
+bool readTextureCacheHeader(const std::string& path, TextureCacheHeader& outHeader);
+
+// Reads a whole texture cache, checking its size and pixel hash
+bool readTextureCache(const std::string& path, TextureCacheHeader& outHeader, TextureImage& outImage,
+                      const VirtualFileSystem* fileSystem = nullptr);
+
+// True if the cache was built from this exact source with the same import options
+bool textureCacheMatchesSource(const TextureCacheHeader& header, const std::string& sourcePath,
+                               uint64_t optionsHash);
+
+// Writes to a temporary file next to the target and renames it into place
+bool writeTextureCache(const std::string& path, const TextureImage& image, const SourceStamp& source,
+                       uint64_t optionsHash);
+
+struct ImportedTexture {
+    TextureImage image;
+    bool fromCache = false;
+};
+
+// Loads a texture through its cache when it is valid (next to the source first, then in the derived-data
+// cache), otherwise decodes the source and (re)writes the cache. DDS and KTX2 files are read directly (see
+// loadTextureContainer). Throws std::runtime_error on failure. With a file system, packed caches and sources
+// are handled as by loadMesh.
+void loadTexture(const std::string& filename, const TextureImportOptions& options, ImportedTexture& outTexture);
+
+// loadTexture straight into upload memory: once the texture is found, allocate is called (once) and the levels
+// are written at the layout's row pitch, so cached and prebuilt levels go from the mapped file to the upload
+// buffer with no image in between. Imported textures are copied from the import's packed chain, which mip
+// filtering and block compression need anyway. Returns true if the texture came from a cache.
+bool loadTextureForUpload(const std::string& filename, const TextureImportOptions& options,
+                          const TextureUploadAllocator& allocate, TextureUploadLayout& outLayout);
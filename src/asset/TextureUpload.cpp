@@ -0,0 +1,33 @@
+#include "TextureUpload.hpp"
+
+#include <cstring>
+
+TextureUploadLayout getTextureUploadLayout(TextureFormat format, uint32_t width, uint32_t height,
+                                           uint32_t mipCount) {
+    TextureUploadLayout layout;
+    layout.width = width;
+    layout.height = height;
+    layout.mipCount = mipCount;
+    layout.format = format;
+    layout.footprints.resize(mipCount);
+    layout.size = getCopyableFootprints(format, width, height, mipCount, layout.footprints.data());
+    return layout;
+}
+
+void writeTextureLevel(const TextureFootprint& footprint, const uint8_t* level, uint8_t* uploadData) {
+    uint8_t* destination = uploadData + footprint.offset;
+    const size_t rowSize = static_cast<size_t>(footprint.rowSize);
+    if (footprint.rowPitch == rowSize) {
+        memcpy(destination, level, rowSize * footprint.rowCount); // Rows already a multiple of the alignment
+        return;
+    }
+    for (uint32_t row = 0; row < footprint.rowCount; row++) {
+        memcpy(destination + size_t(row) * footprint.rowPitch, level + row * rowSize, rowSize);
+    }
+}
+
+void writeTextureLevels(const TextureUploadLayout& layout, const uint8_t* const* levels, uint8_t* uploadData) {
+    for (uint32_t level = 0; level < layout.mipCount; level++) {
+        writeTextureLevel(layout.footprints[level], levels[level], uploadData);
+    }
+}
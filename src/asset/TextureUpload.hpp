@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "TextureFootprint.hpp"
+
+// Texture chains written straight into upload memory (e.g. a mapped D3D12 upload buffer) at the row pitch and
+// level placement the copy to the texture requires, so no packed copy of the chain is made on the way.
+
+// Where each level of a texture goes in upload memory
+struct TextureUploadLayout {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t mipCount = 0;
+    TextureFormat format = TextureFormat::Rgba8;
+    std::vector<TextureFootprint> footprints; // One per level
+    uint64_t size = 0; // Bytes of upload memory, as reported by getCopyableFootprints
+};
+
+TextureUploadLayout getTextureUploadLayout(TextureFormat format, uint32_t width, uint32_t height,
+                                           uint32_t mipCount);
+
+// Returns layout.size writable bytes for the texture (e.g. a mapped upload buffer) or throws
+// std::runtime_error. Called from the thread loading the texture.
+using TextureUploadAllocator = std::function<uint8_t*(const TextureUploadLayout& layout)>;
+
+// Copies the rows of a tightly packed level (rows of texels or blocks, getTextureRowPitch bytes each) to
+// their place in upload memory; the padding between rows is left as it is
+void writeTextureLevel(const TextureFootprint& footprint, const uint8_t* level, uint8_t* uploadData);
+
+// Every level of a chain, each given by a pointer to its packed rows
+void writeTextureLevels(const TextureUploadLayout& layout, const uint8_t* const* levels, uint8_t* uploadData);
@@ -0,0 +1,600 @@
+#include "VertexFormat.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+#include "MeshData.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VERTEX_FORMAT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+    inline float loadFloat(const uint8_t* p) {
+        float value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline void storeFloat(uint8_t* p, float value) {
+        memcpy(p, &value, sizeof(value));
+    }
+
+    inline uint16_t loadU16(const uint8_t* p) {
+        uint16_t value;
+        memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    inline void storeU16(uint8_t* p, uint16_t value) {
+        memcpy(p, &value, sizeof(value));
+    }
+
+    inline uint32_t floatBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline float bitsToFloat(uint32_t bits) {
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Round to nearest even, like cvtps2dq under the default MXCSR
+    inline int32_t roundToInt(float value) {
+        return static_cast<int32_t>(std::nearbyint(value));
+    }
+
+    inline uint16_t quantizeSnorm16(float value) {
+        value = std::min(std::max(value, -1.0f), 1.0f);
+        return static_cast<uint16_t>(static_cast<int16_t>(roundToInt(value * 32767.0f)));
+    }
+
+    inline float dequantizeSnorm16(uint16_t value) {
+        return std::max(static_cast<float>(static_cast<int16_t>(value)) * (1.0f / 32767.0f), -1.0f);
+    }
+
+    inline uint16_t quantizeUnorm16(float value) {
+        value = std::min(std::max(value, 0.0f), 1.0f);
+        return static_cast<uint16_t>(roundToInt(value * 65535.0f));
+    }
+
+    inline float dequantizeUnorm16(uint16_t value) {
+        return static_cast<float>(value) * (1.0f / 65535.0f);
+    }
+
+    // Round-to-nearest-even float -> half, same bit tricks as the SSE2 path
+    uint16_t floatToHalf(float value) {
+        uint32_t f = floatBits(value);
+        uint32_t sign = f & 0x80000000u;
+        f ^= sign;
+        uint32_t result;
+        if (f >= (127u + 16u) << 23) {
+            result = f > 0x7F800000u ? 0x7E00u : 0x7C00u; // NaN stays NaN, overflow goes to infinity
+        } else if (f < (127u - 14u) << 23) {
+            // Subnormal half: let the FPU round the mantissa by adding a magic value
+            const uint32_t magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+            result = floatBits(bitsToFloat(f) + bitsToFloat(magic)) - magic;
+        } else {
+            uint32_t mantissaOdd = (f >> 13) & 1u;
+            f += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFu;
+            f += mantissaOdd;
+            result = f >> 13;
+        }
+        return static_cast<uint16_t>(result | (sign >> 16));
+    }
+
+    float halfToFloat(uint16_t value) {
+        uint32_t exponentMantissa = value & 0x7FFFu;
+        uint32_t sign = static_cast<uint32_t>(value & 0x8000u) << 16;
+        uint32_t bits = floatBits(bitsToFloat(exponentMantissa << 13) * bitsToFloat((254u - 15u) << 23));
+        if (exponentMantissa > 0x7BFFu) {
+            bits |= 255u << 23;
+        }
+        return bitsToFloat(bits | sign);
+    }
+
+    void encodeOctahedralScalar(float x, float y, float z, uint16_t& u, uint16_t& v) {
+        float l1 = std::fabs(x) + std::fabs(y) + std::fabs(z);
+        float invL1 = l1 > 0.0f ? 1.0f / l1 : 0.0f;
+        float px = x * invL1;
+        float py = y * invL1;
+        if (z < 0.0f) {
+            float foldedX = (1.0f - std::fabs(py)) * (px >= 0.0f ? 1.0f : -1.0f);
+            float foldedY = (1.0f - std::fabs(px)) * (py >= 0.0f ? 1.0f : -1.0f);
+            px = foldedX;
+            py = foldedY;
+        }
+        u = quantizeSnorm16(px);
+        v = quantizeSnorm16(py);
+    }
+
+    void decodeOctahedralScalar(uint16_t u, uint16_t v, float& x, float& y, float& z) {
+        x = dequantizeSnorm16(u);
+        y = dequantizeSnorm16(v);
+        z = 1.0f - std::fabs(x) - std::fabs(y);
+        float t = std::max(-z, 0.0f);
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+        float invLength = 1.0f / std::sqrt(x * x + y * y + z * z);
+        x *= invLength;
+        y *= invLength;
+        z *= invLength;
+    }
+
+#if VERTEX_FORMAT_SSE2
+    inline __m128 gather4(const uint8_t* base, size_t stride) {
+        return _mm_setr_ps(loadFloat(base), loadFloat(base + stride), loadFloat(base + 2 * stride),
+                           loadFloat(base + 3 * stride));
+    }
+
+    inline void scatter4(uint8_t* base, size_t stride, __m128 value) {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, value);
+        for (int i = 0; i < 4; ++i) {
+            storeFloat(base + i * stride, lanes[i]);
+        }
+    }
+
+    inline __m128i gatherU16x4(const uint8_t* base, size_t stride) {
+        return _mm_setr_epi32(loadU16(base), loadU16(base + stride), loadU16(base + 2 * stride),
+                              loadU16(base + 3 * stride));
+    }
+
+    inline void scatterU16x4(uint8_t* base, size_t stride, __m128i value) {
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), value);
+        for (int i = 0; i < 4; ++i) {
+            storeU16(base + i * stride, static_cast<uint16_t>(lanes[i]));
+        }
+    }
+
+    inline __m128 select(__m128 mask, __m128 a, __m128 b) {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    inline __m128 absolute(__m128 value) {
+        return _mm_andnot_ps(_mm_set1_ps(-0.0f), value);
+    }
+
+    inline __m128i quantizeSnorm16(__m128 value) {
+        value = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(32767.0f)));
+    }
+
+    inline __m128 dequantizeSnorm16(__m128i value) {
+        __m128i signExtended = _mm_srai_epi32(_mm_slli_epi32(value, 16), 16);
+        return _mm_max_ps(_mm_mul_ps(_mm_cvtepi32_ps(signExtended), _mm_set1_ps(1.0f / 32767.0f)),
+                          _mm_set1_ps(-1.0f));
+    }
+
+    inline __m128i quantizeUnorm16(__m128 value) {
+        value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+        return _mm_cvtps_epi32(_mm_mul_ps(value, _mm_set1_ps(65535.0f)));
+    }
+
+    inline __m128 dequantizeUnorm16(__m128i value) {
+        return _mm_mul_ps(_mm_cvtepi32_ps(value), _mm_set1_ps(1.0f / 65535.0f));
+    }
+
+    __m128i floatToHalf(__m128 value) {
+        const __m128i f16Max = _mm_set1_epi32((127 + 16) << 23);
+        const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);
+        const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+        __m128 sign = _mm_and_ps(_mm_set1_ps(-0.0f), value);
+        __m128 absValue = _mm_xor_ps(value, sign);
+        __m128i absBits = _mm_castps_si128(absValue);
+        __m128 isNan = _mm_cmpunord_ps(absValue, absValue);
+        __m128i isRegular = _mm_cmpgt_epi32(f16Max, absBits);
+        __m128i infOrNan = _mm_or_si128(_mm_and_si128(_mm_castps_si128(isNan), _mm_set1_epi32(0x200)),
+                                        _mm_set1_epi32(0x7C00));
+        __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+
+        __m128 subnormalRounded = _mm_add_ps(absValue, _mm_castsi128_ps(subnormalMagic));
+        __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(subnormalRounded), subnormalMagic);
+
+        __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+        __m128i rounded = _mm_sub_epi32(_mm_add_epi32(absBits, normalBias), mantissaOdd);
+        __m128i normal = _mm_srli_epi32(rounded, 13);
+
+        __m128i finite = _mm_or_si128(_mm_and_si128(subnormal, isSubnormal), _mm_andnot_si128(isSubnormal, normal));
+        __m128i joined = _mm_or_si128(_mm_and_si128(finite, isRegular), _mm_andnot_si128(isRegular, infOrNan));
+        return _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+    }
+
+    __m128 halfToFloat(__m128i value) {
+        __m128i exponentMantissa = _mm_and_si128(value, _mm_set1_epi32(0x7FFF));
+        __m128i sign = _mm_slli_epi32(_mm_xor_si128(value, exponentMantissa), 16);
+        __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)),
+                                   _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+        __m128i wasInfNan = _mm_cmpgt_epi32(exponentMantissa, _mm_set1_epi32(0x7BFF));
+        __m128 infNanExponent = _mm_and_ps(_mm_castsi128_ps(wasInfNan), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+        return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infNanExponent));
+    }
+#endif
+}
+
+static_assert(sizeof(Vertex) == 48, "The default VertexFormat must match the Vertex struct");
+
+VertexQuantization computeVertexQuantization(const Vertex* vertices, size_t vertexCount, const VertexFormat& format) {
+    VertexQuantization quantization;
+    if (vertexCount == 0) {
+        return quantization;
+    }
+
+    if (format.position == PositionEncoding::Snorm16) {
+        glm::vec3 minBound = vertices[0].position;
+        glm::vec3 maxBound = vertices[0].position;
+        for (size_t i = 1; i < vertexCount; ++i) {
+            minBound = glm::min(minBound, vertices[i].position);
+            maxBound = glm::max(maxBound, vertices[i].position);
+        }
+        // Snorm spans [-1, 1]: center the AABB and scale by its half extent
+        glm::vec3 halfExtent = (maxBound - minBound) * 0.5f;
+        for (int axis = 0; axis < 3; ++axis) {
+            quantization.positionScale[axis] = halfExtent[axis] > 0.0f ? halfExtent[axis] : 1.0f;
+        }
+        quantization.positionOffset = (minBound + maxBound) * 0.5f;
+    }
+
+    if (format.texCoord == TexCoordEncoding::Unorm16) {
+        glm::vec2 minBound = vertices[0].texCoord;
+        glm::vec2 maxBound = vertices[0].texCoord;
+        for (size_t i = 1; i < vertexCount; ++i) {
+            minBound = glm::min(minBound, vertices[i].texCoord);
+            maxBound = glm::max(maxBound, vertices[i].texCoord);
+        }
+        glm::vec2 extent = maxBound - minBound;
+        for (int axis = 0; axis < 2; ++axis) {
+            quantization.texCoordScale[axis] = extent[axis] > 0.0f ? extent[axis] : 1.0f;
+        }
+        quantization.texCoordOffset = minBound;
+    }
+    return quantization;
+}
+
+void encodeVertices(void* destination, void* positionDestination, const Vertex* vertices, size_t vertexCount,
+                    const VertexFormat& format, const VertexQuantization& quantization) {
+    const VertexLayout layout = getVertexLayout(format);
+    auto* dst = static_cast<uint8_t*>(destination);
+    const auto* src = reinterpret_cast<const uint8_t*>(vertices);
+    memset(dst, 0, vertexCount * layout.stride);
+
+    uint8_t* positions = dst + layout.positionOffset;
+    size_t positionStride = layout.stride;
+    if (format.splitPositions) {
+        positions = static_cast<uint8_t*>(positionDestination) + layout.positionOffset;
+        positionStride = layout.positionStride;
+        memset(positionDestination, 0, vertexCount * layout.positionStride);
+    }
+    // The memsets also clear the unused snorm16 position w
+    if (format.position == PositionEncoding::Float32) {
+        for (size_t i = 0; i < vertexCount; ++i) {
+            memcpy(positions + i * positionStride, &vertices[i].position, 12);
+        }
+    } else {
+        encodeSnorm16x3(positions, positionStride, src + offsetof(Vertex, position), sizeof(Vertex), vertexCount,
+                        quantization.positionScale, quantization.positionOffset);
+    }
+
+    if (format.color) {
+        for (size_t i = 0; i < vertexCount; ++i) {
+            memcpy(dst + i * layout.stride + layout.colorOffset, &vertices[i].color, 16);
+        }
+    }
+
+    switch (format.texCoord) {
+        case TexCoordEncoding::Float32:
+            for (size_t i = 0; i < vertexCount; ++i) {
+                memcpy(dst + i * layout.stride + layout.texCoordOffset, &vertices[i].texCoord, 8);
+            }
+            break;
+        case TexCoordEncoding::Half:
+            encodeHalf2(dst + layout.texCoordOffset, layout.stride, src + offsetof(Vertex, texCoord), sizeof(Vertex),
+                        vertexCount);
+            break;
+        case TexCoordEncoding::Unorm16:
+            encodeUnorm16x2(dst + layout.texCoordOffset, layout.stride, src + offsetof(Vertex, texCoord),
+                            sizeof(Vertex), vertexCount, quantization.texCoordScale, quantization.texCoordOffset);
+            break;
+    }
+
+    if (format.normal == NormalEncoding::Float32) {
+        for (size_t i = 0; i < vertexCount; ++i) {
+            memcpy(dst + i * layout.stride + layout.normalOffset, &vertices[i].normal, 12);
+        }
+    } else {
+        encodeOctahedral16(dst + layout.normalOffset, layout.stride, src + offsetof(Vertex, normal), sizeof(Vertex),
+                           vertexCount);
+    }
+}
+
+void decodeVertices(Vertex* destination, const void* encoded, const void* encodedPositions, size_t vertexCount,
+                    const VertexFormat& format, const VertexQuantization& quantization) {
+    const VertexLayout layout = getVertexLayout(format);
+    const auto* src = static_cast<const uint8_t*>(encoded);
+    auto* dst = reinterpret_cast<uint8_t*>(destination);
+
+    const uint8_t* positions = format.splitPositions ? static_cast<const uint8_t*>(encodedPositions) : src;
+    const size_t positionStride = format.splitPositions ? layout.positionStride : layout.stride;
+    if (format.position == PositionEncoding::Float32) {
+        for (size_t i = 0; i < vertexCount; ++i) {
+            memcpy(&destination[i].position, positions + i * positionStride + layout.positionOffset, 12);
+        }
+    } else {
+        decodeSnorm16x3(dst + offsetof(Vertex, position), sizeof(Vertex), positions + layout.positionOffset,
+                        positionStride, vertexCount, quantization.positionScale, quantization.positionOffset);
+    }
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        if (format.color) {
+            memcpy(&destination[i].color, src + i * layout.stride + layout.colorOffset, 16);
+        } else {
+            destination[i].color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+        }
+    }
+
+    switch (format.texCoord) {
+        case TexCoordEncoding::Float32:
+            for (size_t i = 0; i < vertexCount; ++i) {
+                memcpy(&destination[i].texCoord, src + i * layout.stride + layout.texCoordOffset, 8);
+            }
+            break;
+        case TexCoordEncoding::Half:
+            decodeHalf2(dst + offsetof(Vertex, texCoord), sizeof(Vertex), src + layout.texCoordOffset, layout.stride,
+                        vertexCount);
+            break;
+        case TexCoordEncoding::Unorm16:
+            decodeUnorm16x2(dst + offsetof(Vertex, texCoord), sizeof(Vertex), src + layout.texCoordOffset,
+                            layout.stride, vertexCount, quantization.texCoordScale, quantization.texCoordOffset);
+            break;
+    }
+
+    if (format.normal == NormalEncoding::Float32) {
+        for (size_t i = 0; i < vertexCount; ++i) {
+            memcpy(&destination[i].normal, src + i * layout.stride + layout.normalOffset, 12);
+        }
+    } else {
+        decodeOctahedral16(dst + offsetof(Vertex, normal), sizeof(Vertex), src + layout.normalOffset, layout.stride,
+                           vertexCount);
+    }
+}
+
+std::vector<std::string> getVertexFormatShaderDefines(const VertexFormat& format) {
+    std::vector<std::string> defines;
+    if (format.position == PositionEncoding::Snorm16) {
+        defines.push_back("POSITION_SNORM16");
+    }
+    if (format.color) {
+        defines.push_back("VERTEX_COLOR");
+    }
+    if (format.texCoord == TexCoordEncoding::Half) {
+        defines.push_back("TEXCOORD_HALF");
+    } else if (format.texCoord == TexCoordEncoding::Unorm16) {
+        defines.push_back("TEXCOORD_UNORM16");
+    }
+    if (format.normal == NormalEncoding::Octahedral16) {
+        defines.push_back("NORMAL_OCT16");
+    }
+    if (format.splitPositions) {
+        defines.push_back("SPLIT_POSITIONS");
+    }
+    return defines;
+}
+
+void encodeSnorm16x3(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                     size_t count, const glm::vec3& scale, const glm::vec3& offset) {
+    const glm::vec3 invScale = 1.0f / scale;
+    size_t i = 0;
+#if VERTEX_FORMAT_SSE2
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        for (int axis = 0; axis < 3; ++axis) {
+            __m128 value = gather4(src + axis * 4, sourceStride);
+            value = _mm_mul_ps(_mm_sub_ps(value, _mm_set1_ps(offset[axis])), _mm_set1_ps(invScale[axis]));
+            scatterU16x4(dst + axis * 2, destinationStride, quantizeSnorm16(value));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        for (int axis = 0; axis < 3; ++axis) {
+            storeU16(dst + axis * 2, quantizeSnorm16((loadFloat(src + axis * 4) - offset[axis]) * invScale[axis]));
+        }
+    }
+}
+
+void decodeSnorm16x3(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                     size_t count, const glm::vec3& scale, const glm::vec3& offset) {
+    size_t i = 0;
+#if VERTEX_FORMAT_SSE2
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        for (int axis = 0; axis < 3; ++axis) {
+            __m128 value = dequantizeSnorm16(gatherU16x4(src + axis * 2, sourceStride));
+            value = _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(scale[axis])), _mm_set1_ps(offset[axis]));
+            scatter4(dst + axis * 4, destinationStride, value);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        for (int axis = 0; axis < 3; ++axis) {
+            storeFloat(dst + axis * 4, dequantizeSnorm16(loadU16(src + axis * 2)) * scale[axis] + offset[axis]);
+        }
+    }
+}
+
+void encodeOctahedral16(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                        size_t count) {
+    size_t i = 0;
+#if VERTEX_FORMAT_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        __m128 x = gather4(src, sourceStride);
+        __m128 y = gather4(src + 4, sourceStride);
+        __m128 z = gather4(src + 8, sourceStride);
+
+        __m128 l1 = _mm_add_ps(_mm_add_ps(absolute(x), absolute(y)), absolute(z));
+        __m128 invL1 = _mm_and_ps(_mm_cmpgt_ps(l1, zero), _mm_div_ps(one, l1));
+        __m128 px = _mm_mul_ps(x, invL1);
+        __m128 py = _mm_mul_ps(y, invL1);
+
+        // Fold the lower hemisphere over the diagonals
+        __m128 signX = select(_mm_cmpge_ps(px, zero), one, minusOne);
+        __m128 signY = select(_mm_cmpge_ps(py, zero), one, minusOne);
+        __m128 foldedX = _mm_mul_ps(_mm_sub_ps(one, absolute(py)), signX);
+        __m128 foldedY = _mm_mul_ps(_mm_sub_ps(one, absolute(px)), signY);
+        __m128 lower = _mm_cmplt_ps(z, zero);
+        px = select(lower, foldedX, px);
+        py = select(lower, foldedY, py);
+
+        scatterU16x4(dst, destinationStride, quantizeSnorm16(px));
+        scatterU16x4(dst + 2, destinationStride, quantizeSnorm16(py));
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        uint16_t u, v;
+        encodeOctahedralScalar(loadFloat(src), loadFloat(src + 4), loadFloat(src + 8), u, v);
+        storeU16(dst, u);
+        storeU16(dst + 2, v);
+    }
+}
+
+void decodeOctahedral16(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                        size_t count) {
+    size_t i = 0;
+#if VERTEX_FORMAT_SSE2
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        __m128 x = dequantizeSnorm16(gatherU16x4(src, sourceStride));
+        __m128 y = dequantizeSnorm16(gatherU16x4(src + 2, sourceStride));
+        __m128 z = _mm_sub_ps(_mm_sub_ps(one, absolute(x)), absolute(y));
+
+        __m128 t = _mm_max_ps(_mm_sub_ps(zero, z), zero);
+        __m128 negT = _mm_sub_ps(zero, t);
+        x = _mm_add_ps(x, select(_mm_cmpge_ps(x, zero), negT, t));
+        y = _mm_add_ps(y, select(_mm_cmpge_ps(y, zero), negT, t));
+
+        __m128 lengthSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        __m128 invLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSq));
+        scatter4(dst, destinationStride, _mm_mul_ps(x, invLength));
+        scatter4(dst + 4, destinationStride, _mm_mul_ps(y, invLength));
+        scatter4(dst + 8, destinationStride, _mm_mul_ps(z, invLength));
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        float x, y, z;
+        decodeOctahedralScalar(loadU16(src), loadU16(src + 2), x, y, z);
+        storeFloat(dst, x);
+        storeFloat(dst + 4, y);
+        storeFloat(dst + 8, z);
+    }
+}
+
+void encodeHalf2(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                 size_t count) {
+    size_t i = 0;
+#if VERTEX_FORMAT_SSE2
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        scatterU16x4(dst, destinationStride, floatToHalf(gather4(src, sourceStride)));
+        scatterU16x4(dst + 2, destinationStride, floatToHalf(gather4(src + 4, sourceStride)));
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        storeU16(dst, floatToHalf(loadFloat(src)));
+        storeU16(dst + 2, floatToHalf(loadFloat(src + 4)));
+    }
+}
+
+void decodeHalf2(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                 size_t count) {
+    size_t i = 0;
+#if VERTEX_FORMAT_SSE2
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        scatter4(dst, destinationStride, halfToFloat(gatherU16x4(src, sourceStride)));
+        scatter4(dst + 4, destinationStride, halfToFloat(gatherU16x4(src + 2, sourceStride)));
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        storeFloat(dst, halfToFloat(loadU16(src)));
+        storeFloat(dst + 4, halfToFloat(loadU16(src + 2)));
+    }
+}
+
+void encodeUnorm16x2(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                     size_t count, const glm::vec2& scale, const glm::vec2& offset) {
+    const glm::vec2 invScale = 1.0f / scale;
+    size_t i = 0;
+#if VERTEX_FORMAT_SSE2
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        for (int axis = 0; axis < 2; ++axis) {
+            __m128 value = gather4(src + axis * 4, sourceStride);
+            value = _mm_mul_ps(_mm_sub_ps(value, _mm_set1_ps(offset[axis])), _mm_set1_ps(invScale[axis]));
+            scatterU16x4(dst + axis * 2, destinationStride, quantizeUnorm16(value));
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        for (int axis = 0; axis < 2; ++axis) {
+            storeU16(dst + axis * 2, quantizeUnorm16((loadFloat(src + axis * 4) - offset[axis]) * invScale[axis]));
+        }
+    }
+}
+
+void decodeUnorm16x2(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                     size_t count, const glm::vec2& scale, const glm::vec2& offset) {
+    size_t i = 0;
+#if VERTEX_FORMAT_SSE2
+    for (; i + 4 <= count; i += 4) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        for (int axis = 0; axis < 2; ++axis) {
+            __m128 value = dequantizeUnorm16(gatherU16x4(src + axis * 2, sourceStride));
+            value = _mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(scale[axis])), _mm_set1_ps(offset[axis]));
+            scatter4(dst + axis * 4, destinationStride, value);
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        const uint8_t* src = source + i * sourceStride;
+        uint8_t* dst = destination + i * destinationStride;
+        for (int axis = 0; axis < 2; ++axis) {
+            storeFloat(dst + axis * 4, dequantizeUnorm16(loadU16(src + axis * 2)) * scale[axis] + offset[axis]);
+        }
+    }
+}
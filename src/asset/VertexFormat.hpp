@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+struct Vertex;
+
+// Vertex encodings selected at import time. All-float with color reproduces the interleaved Vertex
+// struct byte for byte (48 bytes); kCompactVertexFormat packs the same data into 16 bytes.
+// Attributes are always laid out in the order position, color, texCoord, normal. With splitPositions the
+// position moves to its own tightly packed stream, for passes that need nothing else (BLAS builds, depth).
+
+enum class PositionEncoding : uint8_t {
+    Float32 = 0, // float3
+    Snorm16 = 1, // snorm16 x4 relative to the mesh AABB (w unused), R16G16B16A16_SNORM is a DXR vertex format
+};
+
+enum class NormalEncoding : uint8_t {
+    Float32 = 0, // float3
+    Octahedral16 = 1, // snorm16 x2 octahedral map
+};
+
+enum class TexCoordEncoding : uint8_t {
+    Float32 = 0, // float2
+    Half = 1, // half x2, keeps wrapping UVs exact enough for tiling
+    Unorm16 = 2, // unorm16 x2 relative to the UV bounds
+};
+
+struct VertexFormat {
+    PositionEncoding position = PositionEncoding::Float32;
+    NormalEncoding normal = NormalEncoding::Float32;
+    TexCoordEncoding texCoord = TexCoordEncoding::Float32;
+    bool color = true; // Always white today; only kept for the legacy layout
+    bool splitPositions = false; // Separate position stream + attribute stream instead of one interleaved stream
+
+    bool operator==(const VertexFormat& other) const = default;
+};
+
+constexpr VertexFormat kCompactVertexFormat = {
+    PositionEncoding::Snorm16, NormalEncoding::Octahedral16, TexCoordEncoding::Half, false, false
+};
+
+constexpr uint32_t kNoVertexAttribute = 0xFFFFFFFFu;
+
+// Byte offsets of each attribute inside its stream (kNoVertexAttribute when absent). positionOffset is
+// relative to the position stream when it is split, everything else to the main (attribute) stream.
+struct VertexLayout {
+    uint32_t stride; // Main stream: interleaved vertex, or the attributes alone when positions are split
+    uint32_t positionStride; // Position stream, 0 when positions are interleaved
+    uint32_t positionOffset;
+    uint32_t colorOffset;
+    uint32_t texCoordOffset;
+    uint32_t normalOffset;
+};
+
+constexpr VertexLayout getVertexLayout(const VertexFormat& format) {
+    VertexLayout layout = {};
+    const uint32_t positionSize = format.position == PositionEncoding::Float32 ? 12 : 8;
+    uint32_t offset = 0;
+    layout.positionOffset = 0;
+    if (format.splitPositions) {
+        layout.positionStride = positionSize;
+    } else {
+        offset += positionSize;
+    }
+    layout.colorOffset = format.color ? offset : kNoVertexAttribute;
+    offset += format.color ? 16 : 0;
+    layout.texCoordOffset = offset;
+    offset += format.texCoord == TexCoordEncoding::Float32 ? 8 : 4;
+    layout.normalOffset = offset;
+    offset += format.normal == NormalEncoding::Float32 ? 12 : 4;
+    layout.stride = offset;
+    return layout;
+}
+
+// Per-mesh dequantization: decoded = encoded * scale + offset. Identity for the float encodings, so
+// shaders can apply it unconditionally.
+struct VertexQuantization {
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec2 texCoordScale = glm::vec2(1.0f);
+    glm::vec2 texCoordOffset = glm::vec2(0.0f);
+};
+
+// Position AABB and UV bounds of the mesh, mapped onto the snorm/unorm ranges of the chosen format
+VertexQuantization computeVertexQuantization(const Vertex* vertices, size_t vertexCount, const VertexFormat& format);
+
+// destination must hold vertexCount * layout.stride bytes and positionDestination vertexCount *
+// layout.positionStride bytes; positionDestination is unused (may be null) unless positions are split
+void encodeVertices(void* destination, void* positionDestination, const Vertex* vertices, size_t vertexCount,
+                    const VertexFormat& format, const VertexQuantization& quantization);
+
+// Inverse of encodeVertices; attributes missing from the format get the import defaults
+void decodeVertices(Vertex* destination, const void* encoded, const void* encodedPositions, size_t vertexCount,
+                    const VertexFormat& format, const VertexQuantization& quantization);
+
+// Preprocessor symbols (each defined to 1) that select the matching vertex decode in the shaders
+std::vector<std::string> getVertexFormatShaderDefines(const VertexFormat& format);
+
+// --- Attribute kernels ---
+// Strided in/out so they run directly on interleaved vertices. SSE2 four elements at a time where
+// available, scalar otherwise; both paths produce identical results.
+
+// (value - offset) / scale clamped to [-1, 1]; decodes to within scale / 65534 (half a step) of the clamped value
+void encodeSnorm16x3(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                     size_t count, const glm::vec3& scale, const glm::vec3& offset);
+
+void decodeSnorm16x3(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                     size_t count, const glm::vec3& scale, const glm::vec3& offset);
+
+// Normalizes on the way (a zero-length normal encodes as +Z); decodes to a unit vector within 1e-4 radians
+void encodeOctahedral16(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                        size_t count);
+
+void decodeOctahedral16(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                        size_t count);
+
+// Rounds to nearest even: within 2^-11 relative (2^-25 absolute for half subnormals); magnitudes from 65520
+// on become infinity, NaN stays NaN
+void encodeHalf2(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                 size_t count);
+
+void decodeHalf2(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                 size_t count);
+
+// (value - offset) / scale clamped to [0, 1]; decodes to within scale / 131070 (half a step) of the clamped value
+void encodeUnorm16x2(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                     size_t count, const glm::vec2& scale, const glm::vec2& offset);
+
+void decodeUnorm16x2(uint8_t* destination, size_t destinationStride, const uint8_t* source, size_t sourceStride,
+                     size_t count, const glm::vec2& scale, const glm::vec2& offset);
@@ -0,0 +1,175 @@
+#include "VertexWelder.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    inline uint64_t hashKey(const VertexKey& key) {
+        // Pack the triple and finish with the murmur3 64-bit finalizer for good bit dispersion
+        uint64_t xy = static_cast<uint64_t>(static_cast<uint32_t>(key.x)) |
+                      static_cast<uint64_t>(static_cast<uint32_t>(key.y)) << 32;
+        uint64_t h = xy * 0x9E3779B185EBCA87ull ^ static_cast<uint64_t>(static_cast<uint32_t>(key.z)) *
+                     0xC2B2AE3D27D4EB4Full;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    size_t nextPowerOfTwo(size_t value) {
+        size_t result = 16;
+        while (result < value) result <<= 1;
+        return result;
+    }
+
+    inline bool nearlyEqual(const glm::vec3& a, const glm::vec3& b, float epsilon) {
+        return std::fabs(a.x - b.x) <= epsilon && std::fabs(a.y - b.y) <= epsilon && std::fabs(a.z - b.z) <= epsilon;
+    }
+
+    inline bool nearlyEqual(const glm::vec2& a, const glm::vec2& b, float epsilon) {
+        return std::fabs(a.x - b.x) <= epsilon && std::fabs(a.y - b.y) <= epsilon;
+    }
+
+    inline int32_t cellCoordinate(float value, float inverseCellSize) {
+        return static_cast<int32_t>(std::floor(value * inverseCellSize));
+    }
+}
+
+VertexIndexTable::VertexIndexTable(size_t expectedKeys) {
+    // Keep the load factor at or below 0.5 for the expected key count
+    rehash(nextPowerOfTwo(expectedKeys * 2));
+}
+
+uint32_t VertexIndexTable::findOrInsert(const VertexKey& key, uint32_t newIndex, bool& inserted) {
+    if ((m_count + 1) * 4 > m_slots.size() * 3) {
+        rehash(m_slots.size() * 2); // Only reached if the caller underestimated expectedKeys
+    }
+    size_t slot = static_cast<size_t>(hashKey(key)) & m_mask;
+    while (true) {
+        Slot& entry = m_slots[slot];
+        if (entry.value == kNotFound) {
+            entry.key = key;
+            entry.value = newIndex;
+            ++m_count;
+            inserted = true;
+            return newIndex;
+        }
+        if (entry.key == key) {
+            inserted = false;
+            return entry.value;
+        }
+        slot = (slot + 1) & m_mask;
+    }
+}
+
+uint32_t VertexIndexTable::find(const VertexKey& key) const {
+    size_t slot = static_cast<size_t>(hashKey(key)) & m_mask;
+    while (true) {
+        const Slot& entry = m_slots[slot];
+        if (entry.value == kNotFound) {
+            return kNotFound;
+        }
+        if (entry.key == key) {
+            return entry.value;
+        }
+        slot = (slot + 1) & m_mask;
+    }
+}
+
+VertexIndexTable::ProbeStats VertexIndexTable::getProbeStats() const {
+    ProbeStats stats;
+    size_t totalLength = 0;
+    for (size_t slot = 0; slot < m_slots.size(); ++slot) {
+        if (m_slots[slot].value != kNotFound) {
+            const size_t length = ((slot - static_cast<size_t>(hashKey(m_slots[slot].key))) & m_mask) + 1;
+            totalLength += length;
+            stats.maxLength = std::max(stats.maxLength, length);
+        }
+    }
+    stats.averageLength = m_count ? double(totalLength) / double(m_count) : 0.0;
+    return stats;
+}
+
+void VertexIndexTable::clear() {
+    std::fill(m_slots.begin(), m_slots.end(), Slot{{0, 0, 0}, kNotFound});
+    m_count = 0;
+}
+
+void VertexIndexTable::rehash(size_t newCapacity) {
+    std::vector<Slot> oldSlots;
+    oldSlots.swap(m_slots);
+    m_slots.assign(newCapacity, Slot{{0, 0, 0}, kNotFound});
+    m_mask = newCapacity - 1;
+    m_count = 0;
+    for (const Slot& entry: oldSlots) {
+        if (entry.value != kNotFound) {
+            bool inserted;
+            findOrInsert(entry.key, entry.value, inserted);
+        }
+    }
+}
+
+size_t weldVertices(MeshData& mesh, const WeldOptions& options) {
+    if (options.positionEpsilon <= 0.0f || mesh.vertices.empty()) {
+        return 0;
+    }
+
+    // Representatives are bucketed in a grid with cell size == epsilon, so any vertex within epsilon of
+    // a representative lies in one of the 27 cells around its own cell.
+    const float inverseCellSize = 1.0f / options.positionEpsilon;
+    const size_t vertexCount = mesh.vertices.size();
+    VertexIndexTable cellHeads(vertexCount);
+    std::vector<uint32_t> nextInCell(vertexCount, VertexIndexTable::kNotFound);
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<Vertex> welded;
+    welded.reserve(vertexCount);
+
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const Vertex& vertex = mesh.vertices[i];
+        const VertexKey cell = {
+            cellCoordinate(vertex.position.x, inverseCellSize),
+            cellCoordinate(vertex.position.y, inverseCellSize),
+            cellCoordinate(vertex.position.z, inverseCellSize)
+        };
+
+        uint32_t match = VertexIndexTable::kNotFound;
+        for (int dz = -1; dz <= 1 && match == VertexIndexTable::kNotFound; ++dz) {
+            for (int dy = -1; dy <= 1 && match == VertexIndexTable::kNotFound; ++dy) {
+                for (int dx = -1; dx <= 1 && match == VertexIndexTable::kNotFound; ++dx) {
+                    uint32_t candidate = cellHeads.find({cell.x + dx, cell.y + dy, cell.z + dz});
+                    for (; candidate != VertexIndexTable::kNotFound; candidate = nextInCell[candidate]) {
+                        const Vertex& other = welded[candidate];
+                        if (nearlyEqual(vertex.position, other.position, options.positionEpsilon) &&
+                            nearlyEqual(vertex.normal, other.normal, options.normalEpsilon) &&
+                            nearlyEqual(vertex.texCoord, other.texCoord, options.texCoordEpsilon)) {
+                            match = candidate;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (match == VertexIndexTable::kNotFound) {
+            match = static_cast<uint32_t>(welded.size());
+            welded.push_back(vertex);
+            // Link the new representative into its cell's chain (right after the head)
+            bool inserted;
+            uint32_t head = cellHeads.findOrInsert(cell, match, inserted);
+            if (!inserted) {
+                nextInCell[match] = nextInCell[head];
+                nextInCell[head] = match;
+            }
+        }
+        remap[i] = match;
+    }
+
+    for (uint32_t& index: mesh.indices) {
+        index = remap[index];
+    }
+    size_t removed = vertexCount - welded.size();
+    mesh.vertices.swap(welded);
+    return removed;
+}
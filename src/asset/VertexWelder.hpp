@@ -0,0 +1,75 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MeshData.hpp"
+
+// Packed integer triple used as a key: OBJ (v, vt, vn) indices, or a quantized grid cell when welding
+struct VertexKey {
+    int32_t x;
+    int32_t y;
+    int32_t z;
+
+    bool operator==(const VertexKey& other) const {
+        return x == other.x && y == other.y && z == other.z;
+    }
+};
+
+// Flat open-addressing hash map from VertexKey to a 32-bit vertex index. Slots live in one contiguous
+// array (linear probing), so a lookup is a single probe sequence with no per-entry allocation.
+class VertexIndexTable {
+public:
+    // Presizes the table so expectedKeys insertions never trigger a rehash
+    explicit VertexIndexTable(size_t expectedKeys);
+
+    // Returns the index stored for key. If the key is new, stores newIndex, sets inserted and returns it.
+    uint32_t findOrInsert(const VertexKey& key, uint32_t newIndex, bool& inserted);
+
+    // Returns kNotFound if the key is absent
+    uint32_t find(const VertexKey& key) const;
+
+    // Removes every key but keeps the capacity
+    void clear();
+
+    size_t size() const {
+        return m_count;
+    }
+
+    size_t capacity() const {
+        return m_slots.size();
+    }
+
+    // Slots a find() of each stored key visits (1 when the key sits in its home slot), e.g. to judge the
+    // hash function and the load factor
+    struct ProbeStats {
+        double averageLength = 0.0;
+        size_t maxLength = 0;
+    };
+
+    ProbeStats getProbeStats() const;
+
+    static constexpr uint32_t kNotFound = 0xFFFFFFFFu;
+
+private:
+    struct Slot {
+        VertexKey key;
+        uint32_t value; // kNotFound marks an empty slot
+    };
+
+    std::vector<Slot> m_slots;
+    size_t m_mask = 0;
+    size_t m_count = 0;
+
+    void rehash(size_t newCapacity);
+};
+
+struct WeldOptions {
+    float positionEpsilon = 0.0f; // Max per-axis position distance; 0 disables welding
+    float normalEpsilon = 0.0f; // Max per-component normal difference
+    float texCoordEpsilon = 0.0f; // UV seams are kept unless UVs also match within this
+};
+
+// Merges vertices whose position, normal and UV are within the given tolerances, rewrites the
+// indices and drops the vertices that became unreferenced. Returns the number of vertices removed.
+size_t weldVertices(MeshData& mesh, const WeldOptions& options);
@@ -0,0 +1,121 @@
+#include "VirtualFileSystem.hpp"
+
+#include <filesystem>
+#include <utility>
+
+VirtualFile::VirtualFile() {
+}
+
+VirtualFile::~VirtualFile() {
+}
+
+VirtualFile::VirtualFile(VirtualFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+VirtualFile& VirtualFile::operator=(VirtualFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        // Moving the mapping and the vector keeps their memory where it is, so m_data stays valid
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_open, other.m_open);
+        std::swap(m_packed, other.m_packed);
+        std::swap(m_contentHash, other.m_contentHash);
+        m_mapping = std::move(other.m_mapping);
+        std::swap(m_storage, other.m_storage);
+    }
+    return *this;
+}
+
+bool VirtualFile::openLoose(const std::string& path) {
+    close();
+    if (m_mapping.open(path)) {
+        m_data = m_mapping.data();
+        m_size = m_mapping.size();
+        m_open = true;
+        return true;
+    }
+    std::error_code ec;
+    m_open = std::filesystem::is_regular_file(path, ec) && std::filesystem::file_size(path, ec) == 0 && !ec;
+    return m_open;
+}
+
+void VirtualFile::close() {
+    m_mapping.close();
+    m_storage.clear();
+    m_storage.shrink_to_fit();
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+    m_packed = false;
+    m_contentHash = 0;
+}
+
+VirtualFileSystem::VirtualFileSystem() {
+}
+
+VirtualFileSystem::~VirtualFileSystem() {
+}
+
+bool VirtualFileSystem::mount(const std::string& packPath) {
+    auto pack = std::make_unique<PackFile>();
+    if (!pack->open(packPath)) {
+        return false;
+    }
+    m_packs.push_back(std::move(pack));
+    return true;
+}
+
+void VirtualFileSystem::unmountAll() {
+    m_packs.clear();
+}
+
+const PackEntry* VirtualFileSystem::findPacked(const std::string& path) const {
+    return findEntry(path, nullptr);
+}
+
+const PackEntry* VirtualFileSystem::findEntry(const std::string& path, const PackFile** outPack) const {
+    for (auto it = m_packs.rbegin(); it != m_packs.rend(); ++it) {
+        if (const PackEntry* entry = (*it)->find(path)) {
+            if (outPack) {
+                *outPack = it->get();
+            }
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+bool VirtualFileSystem::open(const std::string& path, VirtualFile& outFile) const {
+    outFile.close();
+    const PackFile* pack = nullptr;
+    const PackEntry* entry = findEntry(path, &pack);
+    if (!entry) {
+        return m_looseFiles && outFile.openLoose(path);
+    }
+    if (const uint8_t* stored = pack->getStoredData(*entry)) {
+        outFile.m_data = stored;
+    } else if (pack->read(*entry, outFile.m_storage)) {
+        outFile.m_data = outFile.m_storage.data();
+    } else {
+        return false;
+    }
+    outFile.m_size = static_cast<size_t>(entry->size);
+    outFile.m_open = true;
+    outFile.m_packed = true;
+    outFile.m_contentHash = entry->contentHash;
+    return true;
+}
+
+bool VirtualFileSystem::exists(const std::string& path) const {
+    if (findPacked(path)) {
+        return true;
+    }
+    std::error_code ec;
+    return m_looseFiles && std::filesystem::is_regular_file(path, ec);
+}
+
+bool openFile(const VirtualFileSystem* fileSystem, const std::string& path, VirtualFile& outFile) {
+    return fileSystem ? fileSystem->open(path, outFile) : outFile.openLoose(path);
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "PackFile.hpp"
+
+// Contents of a file opened through a VirtualFileSystem: a view into a mounted pack for stored entries (no
+// copy), the decoded bytes for compressed entries, or a mapping of a loose file on disk
+class VirtualFile {
+public:
+    VirtualFile();
+
+    ~VirtualFile();
+
+    VirtualFile(const VirtualFile&) = delete;
+
+    VirtualFile& operator=(const VirtualFile&) = delete;
+
+    VirtualFile(VirtualFile&& other) noexcept;
+
+    VirtualFile& operator=(VirtualFile&& other) noexcept;
+
+    // Maps a file on disk, bypassing any pack. Unlike MappedFile, an empty file opens (with no data).
+    bool openLoose(const std::string& path);
+
+    void close();
+
+    bool isOpen() const {
+        return m_open;
+    }
+
+    const uint8_t* data() const {
+        return m_data;
+    }
+
+    size_t size() const {
+        return m_size;
+    }
+
+    // True if the contents came from a pack (then getContentHash() is known without reading them)
+    bool isPacked() const {
+        return m_packed;
+    }
+
+    // hash64 of the contents, recorded when the pack was written; 0 for loose files
+    uint64_t getContentHash() const {
+        return m_contentHash;
+    }
+
+private:
+    friend class VirtualFileSystem;
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    bool m_open = false;
+    bool m_packed = false;
+    uint64_t m_contentHash = 0;
+    MappedFile m_mapping; // Loose files
+    std::vector<uint8_t> m_storage; // Decompressed pack entries
+};
+
+// Files addressed by relative path, looked up in the mounted packs first (newest mount first) and then, if
+// enabled, on disk. Packs are mounted at startup before any loader runs; lookups are read-only afterwards,
+// so loader jobs may open files from any thread without locking.
+class VirtualFileSystem {
+public:
+    VirtualFileSystem();
+
+    ~VirtualFileSystem();
+
+    VirtualFileSystem(const VirtualFileSystem&) = delete;
+
+    VirtualFileSystem& operator=(const VirtualFileSystem&) = delete;
+
+    // Entries of a pack mounted later shadow those of earlier packs. Returns false if the pack is missing
+    // or invalid.
+    bool mount(const std::string& packPath);
+
+    void unmountAll();
+
+    size_t getMountCount() const {
+        return m_packs.size();
+    }
+
+    // Whether paths found in no pack fall back to files on disk (the default)
+    void setLooseFilesEnabled(bool enabled) {
+        m_looseFiles = enabled;
+    }
+
+    // Returns false if the file exists nowhere, or its pack entry is corrupt
+    bool open(const std::string& path, VirtualFile& outFile) const;
+
+    // The pack entry the path resolves to, or nullptr if it is not packed (loose files are not considered)
+    const PackEntry* findPacked(const std::string& path) const;
+
+    bool isPacked(const std::string& path) const {
+        return findPacked(path) != nullptr;
+    }
+
+    bool exists(const std::string& path) const;
+
+private:
+    const PackEntry* findEntry(const std::string& path, const PackFile** outPack) const;
+
+    std::vector<std::unique_ptr<PackFile>> m_packs; // In mount order
+    bool m_looseFiles = true;
+};
+
+// Opens through fileSystem when there is one, otherwise straight from disk; the loaders take an optional
+// file system and read every file through this
+bool openFile(const VirtualFileSystem* fileSystem, const std::string& path, VirtualFile& outFile);
@@ -0,0 +1,267 @@
+#include "FileWatcher.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::string joinPath(const std::string& directory, const std::string& name) {
+        return directory.empty() ? name : directory + "/" + name;
+    }
+}
+
+FileWatcher::FileWatcher() {
+}
+
+FileWatcher::~FileWatcher() {
+    close();
+}
+
+size_t FileWatcher::poll(std::vector<std::string>& outChangedPaths) {
+    if (!isOpen()) {
+        return 0;
+    }
+    readEvents();
+    const Clock::time_point settled = Clock::now() - m_settleTime;
+    const size_t first = outChangedPaths.size();
+    for (auto it = m_pendingChanges.begin(); it != m_pendingChanges.end();) {
+        if (it->second <= settled) {
+            outChangedPaths.push_back(it->first);
+            it = m_pendingChanges.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    std::sort(outChangedPaths.begin() + first, outChangedPaths.end());
+    return outChangedPaths.size() - first;
+}
+
+void FileWatcher::addChange(const std::string& path, Clock::time_point time) {
+    m_pendingChanges[path] = time; // Another write restarts the settle time
+}
+
+#if defined(_WIN32)
+
+namespace {
+    constexpr DWORD kNotifyBufferSize = 64 * 1024; // The limit for directories on network shares
+
+    std::string narrowUtf8(const WCHAR* text, int length) {
+        const int size = WideCharToMultiByte(CP_UTF8, 0, text, length, nullptr, 0, nullptr, nullptr);
+        std::string result(static_cast<size_t>(std::max(size, 0)), '\0');
+        WideCharToMultiByte(CP_UTF8, 0, text, length, result.data(), size, nullptr, nullptr);
+        return result;
+    }
+}
+
+bool FileWatcher::open(const std::string& directory, std::chrono::milliseconds settleTime) {
+    close();
+    HANDLE handle = CreateFileA(directory.c_str(), FILE_LIST_DIRECTORY,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                                FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    HANDLE event = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!event) {
+        CloseHandle(handle);
+        return false;
+    }
+    m_directoryHandle = handle;
+    m_event = event;
+    m_overlapped = std::make_unique<OVERLAPPED>();
+    m_overlapped->hEvent = event;
+    m_notifyBuffer.resize(kNotifyBufferSize / sizeof(uint32_t));
+    m_directory = directory;
+    m_settleTime = settleTime;
+    if (!issueRead()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FileWatcher::close() {
+    if (m_directoryHandle) {
+        if (m_readPending) {
+            // The buffer must outlive the read, so wait for the cancellation to complete
+            CancelIoEx(m_directoryHandle, m_overlapped.get());
+            DWORD bytes = 0;
+            GetOverlappedResult(m_directoryHandle, m_overlapped.get(), &bytes, TRUE);
+        }
+        CloseHandle(m_directoryHandle);
+    }
+    if (m_event) {
+        CloseHandle(m_event);
+    }
+    m_directoryHandle = nullptr;
+    m_event = nullptr;
+    m_overlapped.reset();
+    m_notifyBuffer.clear();
+    m_readPending = false;
+    m_pendingChanges.clear();
+    m_directory.clear();
+}
+
+bool FileWatcher::isOpen() const {
+    return m_directoryHandle != nullptr;
+}
+
+bool FileWatcher::issueRead() {
+    const DWORD filter = FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_SIZE;
+    m_readPending = ReadDirectoryChangesW(m_directoryHandle, m_notifyBuffer.data(), kNotifyBufferSize, TRUE,
+                                          filter, nullptr, m_overlapped.get(), nullptr) != FALSE;
+    return m_readPending;
+}
+
+void FileWatcher::readEvents() {
+    while (m_readPending) {
+        DWORD bytes = 0;
+        if (!GetOverlappedResult(m_directoryHandle, m_overlapped.get(), &bytes, FALSE)) {
+            if (GetLastError() != ERROR_IO_INCOMPLETE) {
+                std::cerr << "Warning: stopped watching " << m_directory << " for changes" << std::endl;
+                m_readPending = false;
+            }
+            return;
+        }
+        const Clock::time_point now = Clock::now();
+        if (bytes == 0) {
+            std::cerr << "Warning: too many changes in " << m_directory << ", some were missed" << std::endl;
+        }
+        const uint8_t* record = bytes > 0 ? reinterpret_cast<const uint8_t*>(m_notifyBuffer.data()) : nullptr;
+        while (record) {
+            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(record);
+            if (info->Action == FILE_ACTION_ADDED || info->Action == FILE_ACTION_MODIFIED ||
+                info->Action == FILE_ACTION_RENAMED_NEW_NAME) {
+                // Directories are reported as modified whenever their entries change
+                const std::wstring name(info->FileName, info->FileNameLength / sizeof(WCHAR));
+                std::error_code error;
+                if (!std::filesystem::is_directory(std::filesystem::path(m_directory) / name, error)) {
+                    std::string path = narrowUtf8(name.data(), static_cast<int>(name.size()));
+                    std::replace(path.begin(), path.end(), '\\', '/');
+                    addChange(path, now);
+                }
+            }
+            record = info->NextEntryOffset != 0 ? record + info->NextEntryOffset : nullptr;
+        }
+        issueRead(); // The records have been consumed, so the buffer can take the next batch
+    }
+}
+
+#else
+
+namespace {
+    constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+}
+
+bool FileWatcher::open(const std::string& directory, std::chrono::milliseconds settleTime) {
+    close();
+    std::error_code error;
+    if (!std::filesystem::is_directory(directory, error)) {
+        return false;
+    }
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0) {
+        return false;
+    }
+    m_directory = directory;
+    m_settleTime = settleTime;
+    addWatches("", false);
+    if (m_watchDirectories.empty()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void FileWatcher::close() {
+    if (m_fd >= 0) {
+        ::close(m_fd); // Removes every watch
+    }
+    m_fd = -1;
+    m_watchDirectories.clear();
+    m_pendingChanges.clear();
+    m_directory.clear();
+}
+
+bool FileWatcher::isOpen() const {
+    return m_fd >= 0;
+}
+
+void FileWatcher::addWatches(const std::string& relativeDirectory, bool reportFiles) {
+    // inotify is not recursive: every directory gets its own watch, including ones created later
+    const std::filesystem::path directory = relativeDirectory.empty()
+                                                ? std::filesystem::path(m_directory)
+                                                : std::filesystem::path(m_directory) / relativeDirectory;
+    const int watch = inotify_add_watch(m_fd, directory.c_str(), kWatchMask);
+    if (watch < 0) {
+        std::cerr << "Warning: cannot watch " << directory.string() << " for changes" << std::endl;
+        return;
+    }
+    m_watchDirectories[watch] = relativeDirectory;
+
+    std::error_code error;
+    const Clock::time_point now = Clock::now();
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error)) {
+        const std::string path = joinPath(relativeDirectory, it->path().filename().string());
+        if (it->is_symlink(error)) {
+            continue; // A link back up the tree would recurse forever
+        }
+        if (it->is_directory(error)) {
+            addWatches(path, reportFiles);
+        } else if (reportFiles) {
+            addChange(path, now); // Written before the new directory's watch existed
+        }
+    }
+}
+
+void FileWatcher::readEvents() {
+    alignas(inotify_event) char buffer[16 * (sizeof(inotify_event) + NAME_MAX + 1)];
+    while (true) {
+        const ssize_t bytes = read(m_fd, buffer, sizeof(buffer));
+        if (bytes <= 0) {
+            return; // EAGAIN: no more events
+        }
+        const Clock::time_point now = Clock::now();
+        for (const char* record = buffer; record < buffer + bytes;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(record);
+            record += sizeof(inotify_event) + event->len;
+            if (event->mask & IN_Q_OVERFLOW) {
+                std::cerr << "Warning: too many changes in " << m_directory << ", some were missed" << std::endl;
+                continue;
+            }
+            const auto directory = m_watchDirectories.find(event->wd);
+            if (directory == m_watchDirectories.end()) {
+                continue;
+            }
+            if (event->mask & IN_IGNORED) {
+                m_watchDirectories.erase(directory); // The directory was deleted or moved away
+                continue;
+            }
+            if (event->len == 0) {
+                continue;
+            }
+            const std::string path = joinPath(directory->second, event->name);
+            if (event->mask & IN_ISDIR) {
+                if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+                    addWatches(path, true);
+                }
+            } else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                addChange(path, now); // IN_CREATE alone: the file is still being written
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_WIN32)
+struct _OVERLAPPED;
+#endif
+
+// Reports the files changed under a directory and its subdirectories (inotify on Linux, ReadDirectoryChangesW
+// on Windows). Nothing blocks: the owner polls, e.g. once per frame. Editors often save in several writes or
+// write a temporary file and rename it over the original, so a path is only reported once it has been quiet
+// for the settle time, and once per burst of changes.
+class FileWatcher {
+public:
+    FileWatcher();
+
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Returns false if the directory does not exist or cannot be watched
+    bool open(const std::string& directory,
+              std::chrono::milliseconds settleTime = std::chrono::milliseconds(100));
+
+    void close();
+
+    bool isOpen() const;
+
+    const std::string& getDirectory() const {
+        return m_directory;
+    }
+
+    // Appends the files written, created or renamed into place that have settled, as paths relative to the
+    // directory with '/' separators, sorted. Deleted files and directories are not reported. Returns how
+    // many paths were appended.
+    size_t poll(std::vector<std::string>& outChangedPaths);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void addChange(const std::string& path, Clock::time_point time);
+
+    void readEvents();
+
+    std::string m_directory;
+    std::chrono::milliseconds m_settleTime{0};
+    std::unordered_map<std::string, Clock::time_point> m_pendingChanges; // Path -> time of its last change
+#if defined(_WIN32)
+    void* m_directoryHandle = nullptr;
+    void* m_event = nullptr;
+    std::unique_ptr<_OVERLAPPED> m_overlapped;
+    std::vector<uint32_t> m_notifyBuffer; // FILE_NOTIFY_INFORMATION records, which must be DWORD aligned
+    bool m_readPending = false;
+
+    bool issueRead();
+#else
+    int m_fd = -1;
+    std::unordered_map<int, std::string> m_watchDirectories; // inotify watch -> directory relative to the root
+
+    void addWatches(const std::string& relativeDirectory, bool reportFiles);
+#endif
+};
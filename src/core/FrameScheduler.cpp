@@ -0,0 +1,37 @@
+#include "FrameScheduler.hpp"
+
+#include <algorithm>
+
+size_t FrameScheduler::poll(uint64_t completedFenceValue) {
+    std::vector<std::coroutine_handle<>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto pending = std::stable_partition(m_waiters.begin(), m_waiters.end(), [&](const Waiter& waiter) {
+            return waiter.fenceValue > completedFenceValue;
+        });
+        for (auto it = pending; it != m_waiters.end(); ++it) {
+            ready.push_back(it->handle);
+        }
+        m_waiters.erase(pending, m_waiters.end());
+    }
+    // Resumed outside the lock: the coroutines may queue themselves again
+    for (std::coroutine_handle<> handle : ready) {
+        handle.resume();
+    }
+    return ready.size();
+}
+
+void FrameScheduler::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_waiters.clear();
+}
+
+size_t FrameScheduler::getWaitingCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_waiters.size();
+}
+
+void FrameScheduler::enqueue(uint64_t fenceValue, std::coroutine_handle<> handle) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_waiters.push_back({fenceValue, handle});
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// Resumes coroutines from the thread that polls it, normally the main thread once per frame: either at the
+// next poll (to get back to the thread that records command lists and allocates descriptors) or once a GPU
+// fence value has completed, so uploads are retired without draining the queue. The completed fence value
+// is passed to poll(), which keeps the scheduler independent of D3D12 (any monotonic counter works).
+class FrameScheduler {
+public:
+    class Awaiter {
+    public:
+        Awaiter(FrameScheduler& scheduler, uint64_t fenceValue) : m_scheduler(scheduler), m_fenceValue(fenceValue) {
+        }
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) const {
+            m_scheduler.enqueue(m_fenceValue, handle);
+        }
+
+        void await_resume() const noexcept {
+        }
+
+    private:
+        FrameScheduler& m_scheduler;
+        uint64_t m_fenceValue;
+    };
+
+    // co_await: resumes in the next poll() (may be awaited from any thread)
+    Awaiter nextPoll() {
+        return Awaiter(*this, 0);
+    }
+
+    // co_await: resumes in the first poll() whose completed fence value reaches fenceValue
+    Awaiter waitForFence(uint64_t fenceValue) {
+        return Awaiter(*this, fenceValue);
+    }
+
+    // Resumes every waiting coroutine whose fence value has completed, in the order they were queued.
+    // Coroutines that queue themselves again while being resumed wait for the next poll. Returns how many
+    // were resumed.
+    size_t poll(uint64_t completedFenceValue);
+
+    // Forgets the waiting coroutines without resuming them; their owners destroy them afterwards
+    void clear();
+
+    size_t getWaitingCount() const;
+
+private:
+    struct Waiter {
+        uint64_t fenceValue;
+        std::coroutine_handle<> handle;
+    };
+
+    void enqueue(uint64_t fenceValue, std::coroutine_handle<> handle);
+
+    mutable std::mutex m_mutex;
+    std::vector<Waiter> m_waiters;
+};
@@ -0,0 +1,236 @@
+#include "JobSystem.hpp"
+
+namespace {
+    // Chase-Lev deque with a fixed power-of-two capacity, using the C11 memory orderings of Lê et al. 2013.
+    // Only the owning worker pushes and pops at the bottom; any thread may steal from the top.
+    template<typename T>
+    class WorkStealingDeque {
+    public:
+        // Returns false when the deque is full
+        bool push(T* item) {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+            const int64_t top = m_top.load(std::memory_order_acquire);
+            if (bottom - top >= int64_t(kCapacity)) {
+                return false;
+            }
+            m_items[bottom & kMask].store(item, std::memory_order_relaxed);
+            m_bottom.store(bottom + 1, std::memory_order_release); // Publishes the item to thieves
+            return true;
+        }
+
+        T* pop() {
+            const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+            m_bottom.store(bottom, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = m_top.load(std::memory_order_relaxed);
+            if (top > bottom) {
+                m_bottom.store(bottom + 1, std::memory_order_relaxed); // Empty
+                return nullptr;
+            }
+            T* item = m_items[bottom & kMask].load(std::memory_order_relaxed);
+            if (top == bottom) {
+                // Last item: thieves may be taking it at the same time, the top CAS decides
+                if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst,
+                                                   std::memory_order_relaxed)) {
+                    item = nullptr;
+                }
+                m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        // Returns nullptr when the deque is empty or another thread won the race for the top item
+        T* steal() {
+            int64_t top = m_top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+            if (top >= bottom) {
+                return nullptr;
+            }
+            T* item = m_items[top & kMask].load(std::memory_order_relaxed);
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return nullptr;
+            }
+            return item;
+        }
+
+    private:
+        static constexpr size_t kCapacity = 4096;
+        static constexpr int64_t kMask = int64_t(kCapacity) - 1;
+
+        // Owner and thieves write different ends; keep them on separate cache lines
+        alignas(64) std::atomic<int64_t> m_top{0};
+        alignas(64) std::atomic<int64_t> m_bottom{0};
+        std::atomic<T*> m_items[kCapacity] = {};
+    };
+
+    // Rounds of searching before an idle worker goes to sleep
+    constexpr int kIdleSpinCount = 64;
+
+    // Worker identity of the current thread; other threads have no job system
+    thread_local const JobSystem* t_jobSystem = nullptr;
+    thread_local size_t t_workerIndex = 0;
+
+    // Jobs the current thread is executing, counting the ones it runs while waiting inside another
+    thread_local size_t t_jobDepth = 0;
+
+    // Per-thread xorshift state for picking steal victims
+    thread_local uint32_t t_randomState = 0;
+
+    uint32_t nextRandom() {
+        if (t_randomState == 0) {
+            t_randomState = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+        }
+        t_randomState ^= t_randomState << 13;
+        t_randomState ^= t_randomState >> 17;
+        t_randomState ^= t_randomState << 5;
+        return t_randomState;
+    }
+}
+
+struct JobSystem::Worker {
+    WorkStealingDeque<Job> deque;
+};
+
+JobSystem::JobSystem(unsigned workerCount) {
+    if (workerCount == 0) {
+        workerCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    }
+    m_workers.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) {
+        m_workers.push_back(std::make_unique<Worker>());
+    }
+    m_threads.reserve(workerCount);
+    for (unsigned i = 0; i < workerCount; ++i) {
+        m_threads.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_stopping.store(true, std::memory_order_release);
+    }
+    m_wakeCondition.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+    for (Job* job : m_sharedJobs) {
+        delete job;
+    }
+    for (const std::unique_ptr<Worker>& worker : m_workers) {
+        while (Job* job = worker->deque.pop()) {
+            delete job;
+        }
+    }
+}
+
+void JobSystem::run(JobCounter& counter, std::function<void()> job) {
+    counter.m_pending.fetch_add(1, std::memory_order_relaxed);
+    Job* queued = new Job{std::move(job), &counter};
+
+    // Counted before it is visible, so a worker that sees no queued jobs can safely sleep
+    m_queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+    if (t_jobSystem == this) {
+        if (!m_workers[t_workerIndex]->deque.push(queued)) {
+            m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            execute(queued); // Deque full: running it now only costs parallelism
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        m_sharedJobs.push_back(queued);
+        m_sharedJobCount.store(m_sharedJobs.size(), std::memory_order_relaxed);
+    }
+    if (m_sleepingWorkers.load(std::memory_order_seq_cst) > 0) {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_wakeCondition.notify_one();
+    }
+}
+
+void JobSystem::wait(JobCounter& counter) {
+    while (!counter.isDone()) {
+        if (Job* job = findJob()) {
+            execute(job);
+        } else {
+            std::this_thread::yield(); // The remaining jobs are running elsewhere
+        }
+    }
+    if (counter.m_failed.load(std::memory_order_relaxed)) {
+        std::exception_ptr exception = counter.m_exception;
+        counter.m_exception = nullptr; // The counter can be reused
+        counter.m_failed.store(false, std::memory_order_relaxed);
+        std::rethrow_exception(exception);
+    }
+}
+
+void JobSystem::workerLoop(size_t workerIndex) {
+    t_jobSystem = this;
+    t_workerIndex = workerIndex;
+    int idleRounds = 0;
+    while (!m_stopping.load(std::memory_order_acquire)) {
+        if (Job* job = findJob()) {
+            execute(job);
+            idleRounds = 0;
+            continue;
+        }
+        if (++idleRounds < kIdleSpinCount) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        m_wakeCondition.wait(lock, [this]() {
+            return m_queuedJobs.load(std::memory_order_seq_cst) > 0 || m_stopping.load(std::memory_order_relaxed);
+        });
+        m_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+        idleRounds = 0;
+    }
+}
+
+JobSystem::Job* JobSystem::findJob() {
+    const bool isWorker = t_jobSystem == this;
+    Job* job = isWorker ? m_workers[t_workerIndex]->deque.pop() : nullptr;
+    if (!job && m_sharedJobCount.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(m_sharedMutex);
+        if (!m_sharedJobs.empty()) {
+            // A thread waiting inside a job takes the newest job, usually its own child: in submission
+            // order it would start the siblings first, each nesting another wait on its stack
+            if (!isWorker && t_jobDepth > 0) {
+                job = m_sharedJobs.back();
+                m_sharedJobs.pop_back();
+            } else {
+                job = m_sharedJobs.front();
+                m_sharedJobs.pop_front();
+            }
+            m_sharedJobCount.store(m_sharedJobs.size(), std::memory_order_relaxed);
+        }
+    }
+    if (!job && !m_workers.empty()) {
+        // Start at a random victim so thieves spread over the workers
+        const size_t start = nextRandom() % m_workers.size();
+        for (size_t i = 0; i < m_workers.size() && !job; ++i) {
+            const size_t victim = (start + i) % m_workers.size();
+            if (!isWorker || victim != t_workerIndex) {
+                job = m_workers[victim]->deque.steal();
+            }
+        }
+    }
+    if (job) {
+        m_queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return job;
+}
+
+void JobSystem::execute(Job* job) {
+    t_jobDepth++;
+    try {
+        job->function();
+    } catch (...) {
+        job->counter->fail(std::current_exception());
+    }
+    t_jobDepth--;
+    JobCounter* counter = job->counter;
+    delete job;
+    counter->m_pending.fetch_sub(1, std::memory_order_acq_rel); // The counter may be gone after this
+}
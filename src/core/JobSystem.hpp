@@ -0,0 +1,158 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing job scheduler. Every worker owns a Chase-Lev deque: it pushes and pops jobs at the bottom
+// (LIFO, so nested work stays cache-hot) while idle workers steal the oldest jobs from the top. Threads
+// that are not workers (the main thread, loader threads) submit through a shared queue and help execute
+// jobs while they wait, so fork-join never blocks a thread that could be doing work.
+
+// Completion counter of a group of jobs: run() increments it and every finished job decrements it, so
+// a parent waits for all of its children (which may spawn their own) with JobSystem::wait. Must outlive
+// the jobs that reference it.
+class JobCounter {
+public:
+    JobCounter() = default;
+
+    JobCounter(const JobCounter&) = delete;
+
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool isDone() const {
+        return m_pending.load(std::memory_order_acquire) == 0;
+    }
+
+private:
+    friend class JobSystem;
+
+    // Keeps the first exception thrown by a job of the group; wait() rethrows it
+    void fail(std::exception_ptr exception) {
+        if (!m_failed.exchange(true, std::memory_order_relaxed)) {
+            m_exception = exception;
+        }
+    }
+
+    std::atomic<uint32_t> m_pending{0};
+    std::atomic<bool> m_failed{false};
+    std::exception_ptr m_exception;
+};
+
+class JobSystem {
+public:
+    // 0 workers = hardware concurrency - 1, since the thread that waits executes jobs as well
+    explicit JobSystem(unsigned workerCount = 0);
+
+    // Stops the workers; jobs still queued are dropped, so wait for every counter first
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Queues a job on the calling worker's deque (or the shared queue from other threads)
+    void run(JobCounter& counter, std::function<void()> job);
+
+    // Executes queued jobs until the counter reaches zero, then rethrows the first exception of the group
+    void wait(JobCounter& counter);
+
+    // Calls fn(begin, end) over subranges covering [0, count) and returns once all of them finished. The
+    // range is split in halves down to an adaptive grain: about kChunksPerThread chunks per thread, so idle
+    // threads always find something to steal, but never fewer than minGrain items per call.
+    template<typename Fn>
+    void parallelFor(size_t count, size_t minGrain, const Fn& fn);
+
+    unsigned getWorkerCount() const {
+        return static_cast<unsigned>(m_workers.size());
+    }
+
+    // Threads that execute jobs: the workers plus the waiting thread
+    unsigned getThreadCount() const {
+        return getWorkerCount() + 1;
+    }
+
+    static constexpr size_t kChunksPerThread = 8;
+
+private:
+    struct Job {
+        std::function<void()> function;
+        JobCounter* counter;
+    };
+
+    struct Worker;
+
+    template<typename Fn>
+    void splitRange(JobCounter& counter, size_t begin, size_t end, size_t grain, const Fn& fn);
+
+    void workerLoop(size_t workerIndex);
+
+    // Own deque first, then the shared queue, then the other workers' deques
+    Job* findJob();
+
+    void execute(Job* job);
+
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_sharedMutex; // Guards m_sharedJobs
+    // Submitted by threads that are not workers, run in submission order (newest first by a thread that is
+    // waiting inside a job)
+    std::deque<Job*> m_sharedJobs;
+    std::atomic<size_t> m_sharedJobCount{0};
+
+    // Idle workers sleep until a job is queued; m_queuedJobs counts jobs in any queue
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wakeCondition;
+    std::atomic<size_t> m_queuedJobs{0};
+    std::atomic<unsigned> m_sleepingWorkers{0};
+    std::atomic<bool> m_stopping{false};
+};
+
+// parallelFor on an optional job system: runs fn(0, count) on the calling thread without one
+template<typename Fn>
+void parallelFor(JobSystem* jobSystem, size_t count, size_t minGrain, const Fn& fn) {
+    if (jobSystem) {
+        jobSystem->parallelFor(count, minGrain, fn);
+    } else if (count > 0) {
+        fn(size_t(0), count);
+    }
+}
+
+template<typename Fn>
+void JobSystem::parallelFor(size_t count, size_t minGrain, const Fn& fn) {
+    if (count == 0) {
+        return;
+    }
+    const size_t grain = std::max({minGrain, size_t(1), count / (kChunksPerThread * getThreadCount())});
+    if (count <= grain) {
+        fn(size_t(0), count);
+        return;
+    }
+    JobCounter counter;
+    try {
+        splitRange(counter, 0, count, grain, fn);
+    } catch (...) {
+        counter.fail(std::current_exception()); // Queued halves still reference the counter
+    }
+    wait(counter);
+}
+
+template<typename Fn>
+void JobSystem::splitRange(JobCounter& counter, size_t begin, size_t end, size_t grain, const Fn& fn) {
+    // The upper half is queued and the lower half split further, so thieves take the largest pieces first
+    while (end - begin > grain) {
+        const size_t middle = begin + (end - begin) / 2;
+        run(counter, [this, &counter, middle, end, grain, &fn]() { splitRange(counter, middle, end, grain, fn); });
+        end = middle;
+    }
+    fn(begin, end);
+}
@@ -0,0 +1,23 @@
+#include "RetireQueue.hpp"
+
+#include <utility>
+
+void RetireQueue::retire(uint64_t fenceValue, std::shared_ptr<void> object) {
+    if (!object) {
+        return;
+    }
+    m_retired.push_back({fenceValue, std::move(object)});
+}
+
+size_t RetireQueue::release(uint64_t completedFenceValue) {
+    size_t released = 0;
+    while (released < m_retired.size() && m_retired[released].fenceValue <= completedFenceValue) {
+        ++released;
+    }
+    m_retired.erase(m_retired.begin(), m_retired.begin() + released);
+    return released;
+}
+
+void RetireQueue::clear() {
+    m_retired.clear();
+}
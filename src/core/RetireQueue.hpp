@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Keeps objects that submitted GPU work may still read (e.g. a mesh just replaced by a reload) alive until a
+// fence value has completed. Like FrameScheduler it only sees fence values, so any monotonic counter works.
+// Objects are expected in fence order; one retired with a lower value than the last waits for that one too.
+class RetireQueue {
+public:
+    void retire(uint64_t fenceValue, std::shared_ptr<void> object);
+
+    // Releases the objects whose fence value has completed, oldest first. Returns how many were released.
+    size_t release(uint64_t completedFenceValue);
+
+    void clear();
+
+    size_t size() const {
+        return m_retired.size();
+    }
+
+private:
+    struct Retired {
+        uint64_t fenceValue;
+        std::shared_ptr<void> object;
+    };
+
+    std::vector<Retired> m_retired; // In fence order
+};
@@ -0,0 +1,201 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+#include "JobSystem.hpp"
+
+// C++20 coroutine tasks. A Task is lazy: awaiting it starts it, and the awaiting coroutine continues when
+// it finishes, on whichever thread finished it (symmetric transfer, so long chains do not grow the stack).
+// The top-level task of a chain is started with start() and polled with isDone() by its owner, e.g. once
+// per frame, before taking the result. Destroying a Task destroys the coroutine frame, so a task must not
+// be destroyed while it is queued somewhere to be resumed.
+
+template<typename T = void>
+class Task;
+
+class TaskPromiseBase {
+public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        template<typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            TaskPromiseBase& promise = handle.promise();
+            std::coroutine_handle<> continuation = promise.m_continuation;
+            // A top-level owner may destroy the frame as soon as it sees m_done, so nothing touches it after
+            promise.m_done.store(true, std::memory_order_release);
+            return continuation ? continuation : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {
+        }
+    };
+
+    std::suspend_always initial_suspend() const noexcept {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept {
+        return {};
+    }
+
+    void unhandled_exception() noexcept {
+        m_exception = std::current_exception();
+    }
+
+protected:
+    template<typename>
+    friend class Task;
+
+    void rethrowIfFailed() const {
+        if (m_exception) {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+    std::coroutine_handle<> m_continuation; // Awaiting coroutine, empty for a top-level task
+    std::exception_ptr m_exception;
+    std::atomic<bool> m_done{false};
+};
+
+template<typename T>
+class TaskPromise : public TaskPromiseBase {
+public:
+    Task<T> get_return_object() noexcept;
+
+    template<typename U>
+    void return_value(U&& value) {
+        m_value.emplace(std::forward<U>(value));
+    }
+
+    T takeResult() {
+        rethrowIfFailed();
+        return std::move(*m_value);
+    }
+
+private:
+    std::optional<T> m_value;
+};
+
+template<>
+class TaskPromise<void> : public TaskPromiseBase {
+public:
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept {
+    }
+
+    void takeResult() const {
+        rethrowIfFailed();
+    }
+};
+
+template<typename T>
+class Task {
+public:
+    using promise_type = TaskPromise<T>;
+
+    struct Awaiter {
+        std::coroutine_handle<promise_type> handle;
+
+        bool await_ready() const noexcept {
+            return !handle;
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+            handle.promise().m_continuation = awaiting;
+            return handle; // Start the task; it resumes the awaiting coroutine when it finishes
+        }
+
+        T await_resume() {
+            return handle.promise().takeResult();
+        }
+    };
+
+    Task() = default;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {
+    }
+
+    ~Task() {
+        if (m_handle) {
+            m_handle.destroy();
+        }
+    }
+
+    Task(const Task&) = delete;
+
+    Task& operator=(const Task&) = delete;
+
+    Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, {})) {
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+
+    // Runs a top-level task on the calling thread until its first suspension
+    void start() {
+        if (m_handle) {
+            m_handle.resume();
+        }
+    }
+
+    bool isDone() const {
+        return !m_handle || m_handle.promise().m_done.load(std::memory_order_acquire);
+    }
+
+    // Result of a finished top-level task; rethrows the exception it ended with
+    T result() {
+        return m_handle.promise().takeResult();
+    }
+
+    Awaiter operator co_await() noexcept {
+        return Awaiter{m_handle};
+    }
+
+private:
+    std::coroutine_handle<promise_type> m_handle;
+};
+
+template<typename T>
+Task<T> TaskPromise<T>::get_return_object() noexcept {
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Awaitable that continues the coroutine as a job, e.g. to move file I/O and decoding off the main thread.
+// The counter covers the resumed part until the coroutine suspends again, so a shutdown can wait for it.
+struct ResumeOnJobSystem {
+    JobSystem& jobSystem;
+    JobCounter& counter;
+
+    bool await_ready() const noexcept {
+        return false;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle) const {
+        jobSystem.run(counter, [handle]() { handle.resume(); });
+    }
+
+    void await_resume() const noexcept {
+    }
+};
+
+inline ResumeOnJobSystem resumeOn(JobSystem& jobSystem, JobCounter& counter) {
+    return {jobSystem, counter};
+}
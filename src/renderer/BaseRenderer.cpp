@@ -1,5 +1,7 @@
 #include "BaseRenderer.hpp"
 
+#include <algorithm>
+
 #include "d3dx12_barriers.h"
 #include "d3dx12_core.h"
 #include "glm/gtc/type_ptr.hpp"
@@ -23,12 +25,13 @@ BaseRenderer::~BaseRenderer() {
 }
 
 void BaseRenderer::render(float deltaTime, Camera* camera, Mesh* mesh, Texture* texture) {
-    if (!camera || !mesh || !texture) {
-        return; // Need essential objects
+    if (!camera || !texture) {
+        return; // Need essential objects; without a mesh (still loading) the frame is only cleared
     }
 
     // --- Wait & Update CB Data ---
     waitForGpu();
+    m_retiredObjects.release(m_commandQueue->getFence()->GetCompletedValue());
     updateConstantBuffers(deltaTime, camera, mesh); 
 
     if (!m_commandManager->resetAllocator(m_currentFrameIndex)) {
@@ -72,6 +75,12 @@ void BaseRenderer::waitForGpu() {
     }
 }
 
+void BaseRenderer::retire(std::shared_ptr<void> object) {
+    if (object) {
+        m_retiredObjects.retire(m_commandQueue->signal(), std::move(object));
+    }
+}
+
 void BaseRenderer::moveToNextFrame() {
     const UINT64 currentFenceValue = m_commandQueue->signal();
     m_frameFenceValues[m_currentFrameIndex] = currentFenceValue;
@@ -95,21 +104,19 @@ bool BaseRenderer::createDescriptorHeaps() {
     const UINT totalDescriptors = numFrameLightCBVs + numMaterialCBVs + numTextureSRVs + 4; // +4 spare*/
     // Create CBV/SRV Heap
     // Need space for:
-    // Raster: k Light CBVs + 1 Material CBV + 1 Texture SRV = k+2
-    // DXR: 1 Camera CBV + 1 VB SRV + 1 IB SRV + 1 Output UAV = 4
-    // Total = k + 2 + 4 + spare = k + 6 + spare
+    // Raster: k Light CBVs + 1 Texture SRV = k+1 (materials are root CBVs)
+    // DXR: 1 Camera CBV + 1 VB SRV + 1 IB SRV + 1 Position SRV + 1 Output UAV = 5
+    // Total = k + 1 + 5 + spare = k + 6 + spare
     const UINT numFrameLightCBVs = m_numFramesInFlight;
-    const UINT numMaterialCBVs = 1;
     const UINT numTextureSRVs = 1;
     const UINT numDxrCameraCBVs = 1;
     const UINT numDxrObjectCBVs = 1;
     const UINT numDxrLightCBVs = 1;
-    const UINT numDxrMaterialCBVs = 1;
-    const UINT numDxrBufferSRVs = 2; // VB + IB
+    const UINT numDxrBufferSRVs = 3 * 2; // VB + IB + positions, twice: a new mesh's before the old ones retire
     const UINT numDxrOutputUAVs = 1;
-    const UINT totalDescriptors = numFrameLightCBVs + numMaterialCBVs + numTextureSRVs + numDxrObjectCBVs
+    const UINT totalDescriptors = numFrameLightCBVs + numTextureSRVs + numDxrObjectCBVs
                                   + numDxrCameraCBVs + numDxrBufferSRVs + numDxrOutputUAVs + numDxrLightCBVs +
-                                  numDxrMaterialCBVs + 4; // +4 spare
+                                  4; // +4 spare
     if (!m_srvHeap->create(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, totalDescriptors, true)) { // Shader visible
         OutputDebugStringW(L"Error: Failed to create SRV Heap.\n");
         return false;
@@ -190,30 +197,10 @@ bool BaseRenderer::createConstantBuffersAndViews() {
         device->CreateConstantBufferView(&cbvDesc, cpuHandle);
     }
 
-    m_materialCB = std::make_unique<Buffer>();
-    // Create in UPLOAD heap for potential updates, though likely static for now
-    if (!m_materialCB->create(device, sizeof(MaterialConstant), D3D12_HEAP_TYPE_UPLOAD,
-                              D3D12_RESOURCE_STATE_GENERIC_READ, true)) {
+    // Materials are bound as root CBVs, so they need no descriptors; start with just the default one
+    if (!updateMaterialBuffer(nullptr)) {
         return false;
     }
-    m_materialCB->getResource()->SetName(L"Material Constant Buffer");
-    // Update with initial material data
-    MaterialConstant materialConsts = {};
-    materialConsts.specularColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f); // White specular
-    materialConsts.specularPower = 32.0f; // Medium shininess
-    void* matMapped = m_materialCB->map();
-    if (matMapped) {
-        memcpy(matMapped, &materialConsts, sizeof(materialConsts));
-        m_materialCB->unmap(sizeof(materialConsts));
-    }
-
-    if (!m_srvHeap->allocateDescriptor(cpuHandle, gpuHandle)) {
-        return false;
-    }
-    D3D12_CONSTANT_BUFFER_VIEW_DESC matCbvDesc = {};
-    matCbvDesc.BufferLocation = m_materialCB->getGPUVirtualAddress();
-    matCbvDesc.SizeInBytes = static_cast<UINT>(m_materialCB->getAlignedSize());
-    device->CreateConstantBufferView(&matCbvDesc, cpuHandle);
 
     m_dxrCameraCB = std::make_unique<Buffer>();
     if (!m_dxrCameraCB->create(device, sizeof(DXRCameraConstants), D3D12_HEAP_TYPE_UPLOAD,
@@ -254,31 +241,6 @@ bool BaseRenderer::createConstantBuffersAndViews() {
     dxrLightCbvDesc.SizeInBytes = static_cast<UINT>(m_dxrLightCB->getAlignedSize());
     device->CreateConstantBufferView(&dxrLightCbvDesc, cpuHandle);
 
-    // 6. ***** NEW ***** DXR Material Constant Buffer & CBV
-    m_dxrMaterialCB = std::make_unique<Buffer>();
-    if (!m_dxrMaterialCB->create(device, sizeof(MaterialConstant), D3D12_HEAP_TYPE_UPLOAD,
-                                 D3D12_RESOURCE_STATE_GENERIC_READ, true))
-        return false;
-    m_dxrMaterialCB->getResource()->SetName(L"DXR Material CB");
-    // Update with initial DXR material data (can be same as raster)
-    MaterialConstant dxrMaterialConsts = {};
-    dxrMaterialConsts.specularColor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
-    dxrMaterialConsts.specularPower = 32.0f;
-    void* dxrMatMapped = m_dxrMaterialCB->map();
-    if (dxrMatMapped) {
-        memcpy(dxrMatMapped, &dxrMaterialConsts, sizeof(dxrMaterialConsts));
-        m_dxrMaterialCB->unmap(sizeof(dxrMaterialConsts));
-    } // Map, copy, unmap once
-    else {
-        m_dxrMaterialCB->map();
-    } // Re-map if initial map failed or was unmapped
-
-    if (!m_srvHeap->allocateDescriptor(cpuHandle, m_dxrMaterialCbvHandleGPU)) return false;
-    D3D12_CONSTANT_BUFFER_VIEW_DESC dxrMatCbvDesc = {};
-    dxrMatCbvDesc.BufferLocation = m_dxrMaterialCB->getGPUVirtualAddress();
-    dxrMatCbvDesc.SizeInBytes = static_cast<UINT>(m_dxrMaterialCB->getAlignedSize());
-    device->CreateConstantBufferView(&dxrMatCbvDesc, cpuHandle);
-
     m_perFrameObjectCBs.resize(m_numFramesInFlight);
     size_t bufferSize = (sizeof(ObjectConstant) + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~(
                             D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1);
@@ -305,6 +267,67 @@ void BaseRenderer::setupViewportAndScissor(UINT width, UINT height) {
     m_scissorRect = CD3DX12_RECT(0, 0, width, height);
 }
 
+bool BaseRenderer::updateMaterialBuffer(const Mesh* mesh) {
+    const uint64_t generation = mesh ? mesh->getGeneration() : 0;
+    if (m_materialCB && generation == m_materialGeneration) {
+        return true;
+    }
+    const size_t materialCount = mesh ? mesh->getMaterials().size() : 0;
+    const size_t slotSize = alignUp(sizeof(MaterialConstant), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    const size_t size = slotSize * (materialCount + 1);
+    if (!m_materialCB || m_materialCB->getSize() < size) {
+        if (m_materialCB) {
+            m_commandQueue->join(); // Frames in flight may still read the old buffer
+        }
+        m_materialCB = std::make_unique<Buffer>();
+        if (!m_materialCB->create(m_device->getDevice(), size, D3D12_HEAP_TYPE_UPLOAD,
+                                  D3D12_RESOURCE_STATE_GENERIC_READ, true)) {
+            m_materialCB.reset();
+            return false;
+        }
+        m_materialCB->getResource()->SetName(L"Material Constant Buffer");
+    } else {
+        m_commandQueue->join(); // Rewriting slots in place
+    }
+    uint8_t* mapped = static_cast<uint8_t*>(m_materialCB->map());
+    if (!mapped) {
+        return false;
+    }
+    MaterialConstant constant = makeMaterialConstant(nullptr);
+    memcpy(mapped, &constant, sizeof(constant));
+    for (size_t i = 0; i < materialCount; ++i) {
+        constant = makeMaterialConstant(&mesh->getMaterials()[i]);
+        memcpy(mapped + slotSize * (i + 1), &constant, sizeof(constant));
+    }
+    m_materialCB->unmap(size);
+    m_materialGeneration = generation;
+    m_materialCount = materialCount;
+    return true;
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS BaseRenderer::getMaterialAddress(uint32_t materialIndex) const {
+    const size_t slotSize = alignUp(sizeof(MaterialConstant), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+    size_t slot = 0;
+    if (materialIndex < m_materialCount) {
+        slot = size_t(materialIndex) + 1;
+    }
+    return m_materialCB->getGPUVirtualAddress() + slot * slotSize;
+}
+
+size_t BaseRenderer::selectLod(const Camera* camera, const Mesh* mesh) const {
+    if (!camera || !mesh || mesh->getLodCount() < 2) {
+        return 0;
+    }
+    const MeshBounds& bounds = mesh->getBounds();
+    // Largest axis scale, so neither the errors nor the bounding radius are underestimated
+    float scale = std::max({glm::length(glm::vec3(m_worldMatrix[0])), glm::length(glm::vec3(m_worldMatrix[1])),
+                            glm::length(glm::vec3(m_worldMatrix[2]))});
+    glm::vec3 center = glm::vec3(m_worldMatrix * glm::vec4(bounds.center, 1.0f));
+    float distance = glm::length(camera->getPosition() - center) - bounds.radius * scale;
+    return selectMeshLod(mesh->getLodErrors().data(), mesh->getLodCount(), std::max(distance, camera->getNearZ()),
+                         scale, camera->getFovY(), m_viewport.Height, m_lodPixelError);
+}
+
 void BaseRenderer::updateConstantBuffers(float deltaTime, Camera* camera, Mesh* mesh) {
     m_totalTime += deltaTime; // Approximate time update - better to pass deltaTime
 
@@ -327,9 +350,11 @@ void BaseRenderer::updateConstantBuffers(float deltaTime, Camera* camera, Mesh*
     Buffer* currentObjectCB = m_perFrameObjectCBs[m_currentFrameIndex].get();
     glm::mat4 viewProj = camera->getProjectionMatrix() * camera->getViewMatrix();
     glm::mat4 worldMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+    m_worldMatrix = worldMatrix;
     ObjectConstant objectConsts;
     objectConsts.worldMatrix = worldMatrix;
     objectConsts.mvpMatrix = viewProj * worldMatrix;
+    objectConsts.vertexDecode = makeVertexDecodeConstant(mesh ? mesh->getVertexQuantization() : VertexQuantization{});
     // Map, copy, unmap
     void* objectMappedData = currentObjectCB->map();
     if (objectMappedData) {
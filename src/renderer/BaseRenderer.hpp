@@ -7,15 +7,35 @@
 #include "PipelineStateObject.hpp"
 #include "SwapChain.hpp"
 #include "Texture.hpp"
+#include "core/RetireQueue.hpp"
 using Microsoft::WRL::ComPtr;
 
+class DerivedDataCache;
+class VirtualFileSystem;
+
 struct FrameConstant {
     glm::mat4 viewProjectMatrix;
 };
 
+// Vertex dequantization constants (see VertexQuantization), shared by the raster and DXR object constants
+struct VertexDecodeConstant {
+    glm::vec4 positionScale; // w unused
+    glm::vec4 positionOffset;
+    glm::vec4 texCoordScaleOffset; // xy = scale, zw = offset
+};
+
+inline VertexDecodeConstant makeVertexDecodeConstant(const VertexQuantization& quantization) {
+    VertexDecodeConstant constant;
+    constant.positionScale = glm::vec4(quantization.positionScale, 0.0f);
+    constant.positionOffset = glm::vec4(quantization.positionOffset, 0.0f);
+    constant.texCoordScaleOffset = glm::vec4(quantization.texCoordScale, quantization.texCoordOffset);
+    return constant;
+}
+
 struct ObjectConstant {
     glm::mat4 worldMatrix;
     glm::mat4 mvpMatrix;
+    VertexDecodeConstant vertexDecode;
 };
 
 struct LightConstant {
@@ -25,11 +45,31 @@ struct LightConstant {
     glm::vec3 cameraPosition;
 };
 
+// Packs like the HLSL cbuffer: float3 + float share one 16-byte register
 struct MaterialConstant {
+    glm::vec4 diffuseColor;
     glm::vec4 specularColor;
+    glm::vec3 emissiveColor;
     float specularPower;
 };
 
+// nullptr gives the default material used for meshes (or submeshes) without one
+inline MaterialConstant makeMaterialConstant(const MeshMaterial* material) {
+    MaterialConstant constant;
+    if (!material) {
+        constant.diffuseColor = glm::vec4(1.0f);
+        constant.specularColor = glm::vec4(1.0f);
+        constant.emissiveColor = glm::vec3(0.0f);
+        constant.specularPower = 32.0f;
+        return constant;
+    }
+    constant.diffuseColor = material->diffuseColor;
+    constant.specularColor = material->specularColor;
+    constant.emissiveColor = material->emissiveColor;
+    constant.specularPower = std::max(material->specularPower, 1.0f); // pow(x, 0) would light everything
+    return constant;
+}
+
 struct DXRCameraConstants {
     glm::mat4 inverseViewProjectMatrix;
     glm::vec3 position;
@@ -38,6 +78,7 @@ struct DXRCameraConstants {
 struct DXRObjectConstants {
     glm::mat4 worldMatrix;
     glm::mat4 invTransposeWorldMatrix; // For transforming normals
+    VertexDecodeConstant vertexDecode;
 };
 
 inline size_t AlignUp(size_t size, size_t alignment) {
@@ -111,10 +152,22 @@ public:
         return m_totalTime;
     }
 
+    // Compiled shaders are looked up here first; set before init()
+    void setDerivedDataCache(DerivedDataCache* derivedDataCache) {
+        m_derivedDataCache = derivedDataCache;
+    }
+
+    // Shader sources are read through this (packs first, then disk); set before init()
+    void setFileSystem(const VirtualFileSystem* fileSystem) {
+        m_fileSystem = fileSystem;
+    }
+
 protected:
     DX12Device* m_device = nullptr;
     CommandQueue* m_commandQueue = nullptr;
     SwapChain* m_swapChain = nullptr;
+    DerivedDataCache* m_derivedDataCache = nullptr;
+    const VirtualFileSystem* m_fileSystem = nullptr;
     UINT m_numFramesInFlight = 0;
 
     std::unique_ptr<CommandListManager> m_commandManager;
@@ -130,25 +183,29 @@ protected:
     D3D12_RECT m_scissorRect;
 
     float m_totalTime = 0.0f;
+    glm::mat4 m_worldMatrix = glm::mat4(1.0f); // Object -> world of the mesh, set by updateConstantBuffers
+    float m_lodPixelError = 1.0f; // Largest on-screen LOD error, in pixels, that selectLod accepts
+    RetireQueue m_retiredObjects; // Replaced GPU objects that frames in flight may still use, see retire()
 
 
     std::vector<std::unique_ptr<Buffer>> m_perFrameObjectCBs;
     std::vector<std::unique_ptr<Buffer>> m_perFrameLightCBs;
-    std::unique_ptr<Buffer> m_materialCB;
+    std::unique_ptr<Buffer> m_materialCB; // Slot 0: default material, slot i + 1: mesh material i
+    // Mesh::getGeneration of the mesh whose materials m_materialCB holds (0: only the default material),
+    // never its address: a reloaded mesh can be allocated where the retired one was
+    uint64_t m_materialGeneration = 0;
+    size_t m_materialCount = 0; // Mesh materials in m_materialCB after the default one
 
     std::vector<D3D12_GPU_DESCRIPTOR_HANDLE> m_frameLightCbvHandlesGPU;
-    D3D12_GPU_DESCRIPTOR_HANDLE m_materialCbvHandleGPU = {};
 
     std::unique_ptr<Buffer> m_dxrCameraCB; // Camera CB for raytracing
     std::unique_ptr<Buffer> m_dxrObjectCB;
     std::unique_ptr<Buffer> m_dxrLightCB; // Single buffer, updated per frame
-    std::unique_ptr<Buffer> m_dxrMaterialCB; // Single buffer, can be static
     D3D12_GPU_DESCRIPTOR_HANDLE m_dxrObjectCbvHandleGPU = {};
     D3D12_GPU_DESCRIPTOR_HANDLE m_dxrCameraCbvHandleGPU = {}; // GPU Handle for binding
     D3D12_GPU_DESCRIPTOR_HANDLE m_meshVertexBufferSrvHandleGPU = {}; // GPU Handle for binding VB SRV
     D3D12_GPU_DESCRIPTOR_HANDLE m_meshIndexBufferSrvHandleGPU = {}; // GPU Handle for binding IB SRV
     D3D12_GPU_DESCRIPTOR_HANDLE m_dxrLightCbvHandleGPU = {};
-    D3D12_GPU_DESCRIPTOR_HANDLE m_dxrMaterialCbvHandleGPU = {};
 
     bool createDescriptorHeaps();
 
@@ -158,6 +215,27 @@ protected:
 
     void setupViewportAndScissor(UINT width, UINT height);
 
+    // Refills m_materialCB with the mesh's materials (nullptr: only the default) when the mesh changes.
+    // Each material sits in its own 256-byte slot so draws bind it as a root CBV.
+    bool updateMaterialBuffer(const Mesh* mesh);
+
+    D3D12_GPU_VIRTUAL_ADDRESS getMaterialAddress(uint32_t materialIndex) const;
+
+    // Keeps an object the submitted frames may still use (e.g. a replaced acceleration structure) alive until
+    // the work submitted so far has executed. Released by render(), so the GPU is never waited for.
+    void retire(std::shared_ptr<void> object);
+
+    template<typename T>
+    void retire(ComPtr<T> object) {
+        if (object) {
+            retire(std::make_shared<ComPtr<T>>(std::move(object)));
+        }
+    }
+
+    // Coarsest LOD of the mesh whose error projects below m_lodPixelError, measured from the camera to
+    // the nearest point of the mesh bounding sphere. Uses m_worldMatrix, so call after updateConstantBuffers.
+    size_t selectLod(const Camera* camera, const Mesh* mesh) const;
+
     virtual void renderVariant(float deltaTime, Camera* camera, Mesh* mesh, Texture* texture, ID3D12GraphicsCommandList* commandList) = 0;
 
     virtual void updateConstantBuffers(float delta_time, Camera* camera, Mesh* mesh);
@@ -1,10 +1,13 @@
 #include "RenderRaster.hpp"
 
+#include <algorithm>
+
 #include "Shader.hpp"
 
 RenderRaster::RenderRaster() : BaseRenderer() {
     m_rootSignature = nullptr;
     m_pipelineState = nullptr;
+    m_depthPipelineState = nullptr;
 }
 
 RenderRaster::~RenderRaster() {
@@ -35,7 +38,7 @@ bool RenderRaster::init(DX12Device* pDevice, CommandQueue* pCommandQueue, SwapCh
     if (!createRootSignature()) {
         return false;
     }
-    if (!createPipelineStateObject()) {
+    if (!createPipelineStateObject(m_pipelineVertexFormat)) {
         return false;
     }
 
@@ -49,19 +52,27 @@ bool RenderRaster::init(DX12Device* pDevice, CommandQueue* pCommandQueue, SwapCh
 void RenderRaster::shutdown() {
 }
 
+bool RenderRaster::reloadShaders() {
+    if (!createPipelineStateObject(m_pipelineVertexFormat)) {
+        OutputDebugStringW(L"Error: Failed to reload SimpleShaders.hlsl, keeping the previous pipelines.\n");
+        return false;
+    }
+    return true;
+}
+
 bool RenderRaster::createRootSignature() {
     ID3D12Device* device = m_device->getDevice();
     m_rootSignature = std::make_unique<RootSignature>();
 
-    CD3DX12_DESCRIPTOR_RANGE1 ranges[3];
+    CD3DX12_DESCRIPTOR_RANGE1 ranges[2];
     ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0); // Tex@t0
     ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 2); // Light@b2
-    ranges[2].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 3); // Mat@b3
     CD3DX12_ROOT_PARAMETER1 rootParameters[4];
     rootParameters[0].InitAsConstantBufferView(0, 0); // Object@b0
     rootParameters[1].InitAsDescriptorTable(1, &ranges[0], D3D12_SHADER_VISIBILITY_PIXEL);
     rootParameters[2].InitAsDescriptorTable(1, &ranges[1], D3D12_SHADER_VISIBILITY_ALL);
-    rootParameters[3].InitAsDescriptorTable(1, &ranges[2], D3D12_SHADER_VISIBILITY_PIXEL);
+    // Mat@b3, a root CBV so switching materials between draws is a single root argument
+    rootParameters[3].InitAsConstantBufferView(3, 0, D3D12_ROOT_DESCRIPTOR_FLAG_NONE, D3D12_SHADER_VISIBILITY_PIXEL);
     CD3DX12_STATIC_SAMPLER_DESC sampler(0, D3D12_FILTER_MIN_MAG_MIP_LINEAR, D3D12_TEXTURE_ADDRESS_MODE_WRAP,
                                         D3D12_TEXTURE_ADDRESS_MODE_WRAP, D3D12_TEXTURE_ADDRESS_MODE_WRAP);
     CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
@@ -84,36 +95,26 @@ bool RenderRaster::createRootSignature() {
     return true;
 }
 
-bool RenderRaster::createPipelineStateObject() {
+bool RenderRaster::createPipelineStateObject(const VertexFormat& vertexFormat) {
     ID3D12Device* device = m_device->getDevice();
+    const std::vector<std::string> defines = getVertexFormatShaderDefines(vertexFormat);
     auto vertexShader = std::make_unique<Shader>();
-    if (!vertexShader->loadAndCompile(L"SimpleShaders.hlsl", "VSMain", "vs_5_1")) return false;
+    if (!vertexShader->loadAndCompile(L"SimpleShaders.hlsl", "VSMain", "vs_5_1", defines, m_derivedDataCache,
+                                      m_fileSystem)) {
+        return false;
+    }
     auto pixelShader = std::make_unique<Shader>();
-    if (!pixelShader->loadAndCompile(L"SimpleShaders.hlsl", "PSMain", "ps_5_1")) return false;
+    if (!pixelShader->loadAndCompile(L"SimpleShaders.hlsl", "PSMain", "ps_5_1", defines, m_derivedDataCache,
+                                     m_fileSystem)) {
+        return false;
+    }
 
 
     // Define Input Layout
-    D3D12_INPUT_ELEMENT_DESC inputElementDescs[] = {
-        {
-            "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, position),
-            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-        },
-        {
-            "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, offsetof(Vertex, color),
-            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-        },
-        {
-            "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, texCoord),
-            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-        },
-        {
-            "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, normal),
-            D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-        }
-    };
-    D3D12_INPUT_LAYOUT_DESC inputLayoutDesc = {inputElementDescs, _countof(inputElementDescs)};
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDescs = getInputElementDescs(vertexFormat);
+    D3D12_INPUT_LAYOUT_DESC inputLayoutDesc = {inputElementDescs.data(), static_cast<UINT>(inputElementDescs.size())};
 
-    m_pipelineState = std::make_unique<PipelineStateObject>();
+    auto pipelineState = std::make_unique<PipelineStateObject>();
     D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
     psoDesc.InputLayout = inputLayoutDesc;
     psoDesc.pRootSignature = m_rootSignature->getSignature(); // Use the NEW root signature
@@ -124,8 +125,11 @@ bool RenderRaster::createPipelineStateObject() {
     psoDesc.RasterizerState.FrontCounterClockwise = TRUE;
     psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
     psoDesc.DepthStencilState.DepthEnable = TRUE;
-    psoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
-    psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+    // After a prepass the depth buffer already holds the final depth; only shade the matching surface
+    psoDesc.DepthStencilState.DepthWriteMask = m_depthPrepass ? D3D12_DEPTH_WRITE_MASK_ZERO
+                                                              : D3D12_DEPTH_WRITE_MASK_ALL;
+    psoDesc.DepthStencilState.DepthFunc = m_depthPrepass ? D3D12_COMPARISON_FUNC_LESS_EQUAL
+                                                         : D3D12_COMPARISON_FUNC_LESS;
     psoDesc.DepthStencilState.StencilEnable = FALSE;
     psoDesc.SampleMask = UINT_MAX;
     psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
@@ -135,23 +139,53 @@ bool RenderRaster::createPipelineStateObject() {
     psoDesc.SampleDesc.Count = 1;
 
 
-    if (!m_pipelineState->create(device, psoDesc)) {
+    if (!pipelineState->create(device, psoDesc)) {
+        return false;
+    }
+    pipelineState->getPipeline()->SetName(L"Main PSO");
+
+    // Depth prepass: same rasterizer state, positions only, no pixel shader or color writes
+    auto depthVertexShader = std::make_unique<Shader>();
+    if (!depthVertexShader->loadAndCompile(L"SimpleShaders.hlsl", "VSDepth", "vs_5_1", defines,
+                                           m_derivedDataCache, m_fileSystem)) {
+        return false;
+    }
+    std::vector<D3D12_INPUT_ELEMENT_DESC> positionElementDescs = getInputElementDescs(vertexFormat, true);
+    psoDesc.InputLayout = {positionElementDescs.data(), static_cast<UINT>(positionElementDescs.size())};
+    psoDesc.VS = depthVertexShader->getBytecode();
+    psoDesc.PS = {};
+    psoDesc.BlendState.RenderTarget[0].RenderTargetWriteMask = 0;
+    psoDesc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+    psoDesc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+    auto depthPipelineState = std::make_unique<PipelineStateObject>();
+    if (!depthPipelineState->create(device, psoDesc)) {
         return false;
     }
-    m_pipelineState->getPipeline()->SetName(L"Main PSO");
+    depthPipelineState->getPipeline()->SetName(L"Depth Prepass PSO");
+
+    m_commandQueue->join(); // The old PSOs may still be referenced by frames in flight
+    m_pipelineState = std::move(pipelineState);
+    m_depthPipelineState = std::move(depthPipelineState);
+    m_pipelineVertexFormat = vertexFormat;
 
     return true;
 }
 
 void RenderRaster::renderVariant(float deltaTime, Camera* camera, Mesh* mesh, Texture* texture,
                                  ID3D12GraphicsCommandList* commandList) {
+    // Input layout and shader decode follow the mesh's vertex encoding
+    if (mesh && mesh->getVertexFormat() != m_pipelineVertexFormat) {
+        if (!createPipelineStateObject(mesh->getVertexFormat())) {
+            OutputDebugStringW(L"Error: Failed to rebuild PSO for mesh vertex format.\n");
+            return;
+        }
+    }
     // Set common descriptor heap (SRV/CBV heap)
     ID3D12DescriptorHeap* ppHeaps[] = {m_srvHeap->getHeapPointer()};
     commandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
     D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = m_swapChain->getCurrentBackBufferView();
     D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = m_dsvHandleCPU;
     commandList->SetGraphicsRootSignature(m_rootSignature->getSignature());
-    commandList->SetPipelineState(m_pipelineState->getPipeline());
     commandList->RSSetViewports(1, &m_viewport);
     commandList->RSSetScissorRects(1, &m_scissorRect);
     commandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
@@ -161,15 +195,45 @@ void RenderRaster::renderVariant(float deltaTime, Camera* camera, Mesh* mesh, Te
     commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
     commandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr); //
 
-    // Set IA Buffers using Mesh class
-    if (mesh) {
-        mesh->setupInputAssembler(commandList);
-    }
     // Set Root Arguments
     // Param 0: Root CBV (Object Data)
     D3D12_GPU_VIRTUAL_ADDRESS cbGpuAddress = m_perFrameObjectCBs[m_currentFrameIndex]->getGPUVirtualAddress();
     commandList->SetGraphicsRootConstantBufferView(0, cbGpuAddress); // Offset 0 for the single object
 
+    // Distant meshes draw a coarser LOD; meshlets only partition LOD0, so cluster culling applies there
+    const size_t lod = m_lodSelection ? selectLod(camera, mesh) : 0;
+
+    // Cluster culling: only meshlets inside the frustum with at least one potentially front-facing
+    // triangle are drawn (both passes)
+    const bool drawMeshlets = m_clusterCulling && lod == 0 && mesh && mesh->hasMeshlets();
+    if (drawMeshlets) {
+        const std::vector<MeshletBounds>& bounds = mesh->getMeshletBounds();
+        m_visibleMeshlets.resize(bounds.size());
+        MeshletCullView view = makeMeshletCullView(camera->getProjectionMatrix() * camera->getViewMatrix(),
+                                                   m_worldMatrix, camera->getPosition());
+        m_visibleMeshlets.resize(cullMeshlets(m_visibleMeshlets.data(), bounds.data(), bounds.size(), view));
+    }
+
+    // Depth prepass: only the position stream is bound, so it fetches a fraction of the vertex data.
+    // Materials do not matter here, so submeshes draw in index buffer order.
+    if (m_depthPrepass && mesh) {
+        commandList->SetPipelineState(m_depthPipelineState->getPipeline());
+        mesh->setupPositionInputAssembler(commandList);
+        if (drawMeshlets) {
+            for (const Submesh& submesh : mesh->getSubmeshes()) {
+                drawSubmeshMeshlets(commandList, mesh, submesh); // Base vertices differ per submesh
+            }
+        } else {
+            mesh->drawLod(commandList, lod);
+        }
+    }
+
+    // Set IA Buffers using Mesh class
+    commandList->SetPipelineState(m_pipelineState->getPipeline());
+    if (mesh) {
+        mesh->setupInputAssembler(commandList);
+    }
+
     // Param 1: Texture SRV Table
     if (texture && texture->getResource()) {
         texture->TransitionToState(commandList, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
@@ -184,14 +248,22 @@ void RenderRaster::renderVariant(float deltaTime, Camera* camera, Mesh* mesh, Te
     if (lightCbvHandle.ptr != 0) {
         commandList->SetGraphicsRootDescriptorTable(2, lightCbvHandle);
     }
-    UINT materialCbvIndex = SwapChain::kBackBufferCount; // Material CBV is after frame light CBVs
-    D3D12_GPU_DESCRIPTOR_HANDLE materialCbvHandle = CD3DX12_GPU_DESCRIPTOR_HANDLE(
-        m_srvHeap->getGPUHeapStart(), materialCbvIndex,
-        m_srvHeap->getDescriptorSize());
-    if (materialCbvHandle.ptr != 0) {
-        commandList->SetGraphicsRootDescriptorTable(3, materialCbvHandle);
-    }
 
+    // Param 3: Material root CBV. Draws are sorted by material, so it is rebound once per material.
+    if (!updateMaterialBuffer(mesh)) {
+        OutputDebugStringW(L"Error: Failed to update the material buffer.\n");
+        return;
+    }
+    if (!mesh) {
+        commandList->SetGraphicsRootConstantBufferView(3, getMaterialAddress(kNoMaterial));
+        return;
+    }
+    const std::vector<Submesh>& submeshes = mesh->getSubmeshes();
+    buildSubmeshDraws(m_submeshDraws, submeshes.data(), submeshes.size(), mesh->getLods().data(), lod);
+    if (!drawMeshlets) {
+        // Meshlet draws go submesh by submesh, so only whole LOD ranges are merged
+        m_submeshDraws.resize(mergeSubmeshDraws(m_submeshDraws.data(), m_submeshDraws.size()));
+    }
 
     for (UINT i = 0; i < 1; ++i) {
         D3D12_GPU_VIRTUAL_ADDRESS objectCbAddress =
@@ -201,8 +273,27 @@ void RenderRaster::renderVariant(float deltaTime, Camera* camera, Mesh* mesh, Te
         commandList->SetGraphicsRootConstantBufferView(0, objectCbAddress);
 
         // Draw using Mesh class
-        if (mesh) {
-            mesh->draw(commandList, 1); // Draw 1 instance
+        uint32_t boundMaterial = 0;
+        for (size_t d = 0; d < m_submeshDraws.size(); ++d) {
+            const SubmeshDraw& draw = m_submeshDraws[d];
+            if (d == 0 || draw.materialIndex != boundMaterial) {
+                commandList->SetGraphicsRootConstantBufferView(3, getMaterialAddress(draw.materialIndex));
+                boundMaterial = draw.materialIndex;
+            }
+            if (drawMeshlets) {
+                drawSubmeshMeshlets(commandList, mesh, submeshes[draw.submesh]);
+            } else {
+                mesh->drawIndices(commandList, draw.indexOffset, draw.indexCount, draw.baseVertex); // Draw 1 instance
+            }
         }
     }
 }
+
+void RenderRaster::drawSubmeshMeshlets(ID3D12GraphicsCommandList* commandList, const Mesh* mesh,
+                                       const Submesh& submesh) const {
+    // m_visibleMeshlets is ascending and every submesh owns a contiguous meshlet range
+    auto first = std::lower_bound(m_visibleMeshlets.begin(), m_visibleMeshlets.end(), submesh.meshletOffset);
+    auto last = std::lower_bound(first, m_visibleMeshlets.end(), submesh.meshletOffset + submesh.meshletCount);
+    mesh->drawMeshlets(commandList, m_visibleMeshlets.data() + (first - m_visibleMeshlets.begin()),
+                       size_t(last - first), submesh.baseVertex);
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "BaseRenderer.hpp"
+#include "asset/SubmeshDraw.hpp"
 #include "src/PipelineStateObject.hpp"
 #include "src/RootSignature.hpp"
 
@@ -14,13 +15,29 @@ public:
 
     void shutdown() override;
 
+    // Recompiles SimpleShaders.hlsl (e.g. after an edit) for the current vertex format. On failure the
+    // pipelines built before stay in use.
+    bool reloadShaders();
+
 private:
     std::unique_ptr<RootSignature> m_rootSignature;
     std::unique_ptr<PipelineStateObject> m_pipelineState;
+    std::unique_ptr<PipelineStateObject> m_depthPipelineState; // Depth prepass, reads the position stream only
+    bool m_depthPrepass = true; // Lay down depth first so the lighting PS runs once per visible pixel
+    bool m_clusterCulling = true; // CPU frustum + normal cone culling of the mesh's meshlets
+    bool m_lodSelection = true; // Draw the coarsest mesh LOD within m_lodPixelError
+    std::vector<uint32_t> m_visibleMeshlets; // Reused every frame
+    std::vector<SubmeshDraw> m_submeshDraws; // Material-sorted draw list, reused every frame
+    VertexFormat m_pipelineVertexFormat; // Vertex format the PSO's input layout and shaders were built for
 
     bool createRootSignature();
 
-    bool createPipelineStateObject();
+    // Builds the main PSO and the depth prepass PSO for this vertex format; they replace the current ones
+    // (after the frames in flight) only once both have been created
+    bool createPipelineStateObject(const VertexFormat& vertexFormat);
+
+    // Draws the visible meshlets of one submesh (meshletOffset..+meshletCount of m_visibleMeshlets)
+    void drawSubmeshMeshlets(ID3D12GraphicsCommandList* commandList, const Mesh* mesh, const Submesh& submesh) const;
 
     void renderVariant(float deltaTime, Camera* camera, Mesh* mesh, Texture* texture, ID3D12GraphicsCommandList* commandList) override;
 };
@@ -1,5 +1,6 @@
 #include "RenderRayTracing.hpp"
 
+#include <algorithm>
 #include <codecvt>
 #include <dxcapi.h>
 #include <locale>
@@ -7,7 +8,76 @@
 
 #include "d3dx12.h"
 #include <glm/gtc/type_ptr.hpp>
+#include "asset/DerivedDataCache.hpp"
+#include "asset/Hash.hpp"
+#include "asset/VirtualFileSystem.hpp"
 
+namespace {
+    // Bump whenever the DXR library compile changes its output so cached DXIL gets rebuilt
+    constexpr uint64_t kShaderCompileRevision = 1;
+
+    std::string narrowPath(const std::wstring& path) {
+        size_t convertedChars = 0;
+        char narrow[MAX_PATH];
+        wcstombs_s(&convertedChars, narrow, sizeof(narrow), path.c_str(), _TRUNCATE);
+        return narrow;
+    }
+
+    // Views of a replaced mesh, returned to the heap once retired (no frame in flight reads them anymore)
+    struct RetiredDescriptors {
+        std::shared_ptr<DescriptorHeap> heap;
+        std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> handles;
+
+        ~RetiredDescriptors() {
+            for (D3D12_CPU_DESCRIPTOR_HANDLE handle : handles) {
+                heap->freeDescriptor(handle);
+            }
+        }
+    };
+
+    // Resolves #include through the virtual file system. DXC passes the include already joined with the
+    // directory of the including file. Lives on the stack for one compile, so reference counting is a no-op.
+    class VirtualFileIncludeHandler : public IDxcIncludeHandler {
+    public:
+        VirtualFileIncludeHandler(const VirtualFileSystem* fileSystem, IDxcUtils* utils)
+            : m_fileSystem(fileSystem), m_utils(utils) {
+        }
+
+        HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR fileName, IDxcBlob** outSource) override {
+            VirtualFile file;
+            if (!m_fileSystem->open(narrowPath(fileName), file)) {
+                return E_FAIL;
+            }
+            ComPtr<IDxcBlobEncoding> blob;
+            HRESULT hr = m_utils->CreateBlob(file.data(), static_cast<UINT32>(file.size()), DXC_CP_ACP, &blob);
+            if (SUCCEEDED(hr)) {
+                *outSource = blob.Detach();
+            }
+            return hr;
+        }
+
+        HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override {
+            if (riid == __uuidof(IDxcIncludeHandler) || riid == __uuidof(IUnknown)) {
+                *object = this;
+                return S_OK;
+            }
+            *object = nullptr;
+            return E_NOINTERFACE;
+        }
+
+        ULONG STDMETHODCALLTYPE AddRef() override {
+            return 1;
+        }
+
+        ULONG STDMETHODCALLTYPE Release() override {
+            return 1;
+        }
+
+    private:
+        const VirtualFileSystem* m_fileSystem;
+        IDxcUtils* m_utils;
+    };
+}
 
 RenderRayTracing::RenderRayTracing() {
     for (UINT i = 0; i < SwapChain::kBackBufferCount; ++i) { // Use constant from SwapChain
@@ -60,10 +130,10 @@ bool RenderRayTracing::init(DX12Device* device, CommandQueue* commandQueue, Swap
     if (!createRootSignature()) {
         return false;
     }
-    if (!createStateObject(L"Raytracing.hlsl")) {
+    if (!createStateObject(L"Raytracing.hlsl", m_stateObjectVertexFormat)) {
         return false;
     }
-    if (!buildShaderBindingTable()) {
+    if (!buildShaderBindingTable(nullptr)) {
         return false;
     }
     ID3D12Device5* dxrDevice = nullptr;
@@ -72,15 +142,18 @@ bool RenderRayTracing::init(DX12Device* device, CommandQueue* commandQueue, Swap
         auto uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
         auto instanceDescBufferSize = sizeof(D3D12_RAYTRACING_INSTANCE_DESC); // Only one instance
         auto instanceDescBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(instanceDescBufferSize);
-        HRESULT hr = dxrDevice->CreateCommittedResource(
-            &uploadHeapProps, D3D12_HEAP_FLAG_NONE, &instanceDescBufferDesc,
-            D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_tlasBuffers.instanceDesc));
-        if (FAILED(hr)) {
-            OutputDebugStringW(L"Failed to create TLAS Instance Desc Buffer.\n");
-            dxrDevice->Release();
-            return false;
+        // One per frame in flight: the CPU writes the next frame's instance while the GPU builds from the others
+        for (UINT i = 0; i < m_numFramesInFlight; ++i) {
+            HRESULT hr = dxrDevice->CreateCommittedResource(
+                &uploadHeapProps, D3D12_HEAP_FLAG_NONE, &instanceDescBufferDesc,
+                D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_tlasInstanceDescs[i]));
+            if (FAILED(hr)) {
+                OutputDebugStringW(L"Failed to create TLAS Instance Desc Buffer.\n");
+                dxrDevice->Release();
+                return false;
+            }
+            m_tlasInstanceDescs[i]->SetName(L"TLAS Instance Descriptors");
         }
-        m_tlasBuffers.instanceDesc->SetName(L"TLAS Instance Descriptors");
         dxrDevice->Release();
     } else {
         return false;
@@ -114,8 +187,8 @@ void RenderRayTracing::renderVariant(float deltaTime, Camera* camera, Mesh* mesh
         OutputDebugStringW(L"DXR Error: m_shaderBindingTable is null.\n");
         resourcesReady = false;
     }
-    if (!m_tlasBuffers.result) { // Check the TLAS result buffer
-        OutputDebugStringW(L"DXR Error: m_tlas.pResult (TLAS result buffer) is null.\n");
+    if (m_tracedLod >= m_blasBuffers.size() || !m_blasBuffers[m_tracedLod].result) { // The frame builds the TLAS
+        OutputDebugStringW(L"DXR Error: no BLAS has been built for the mesh.\n");
         resourcesReady = false;
     }
     if (!m_outputTexture) {
@@ -146,6 +219,10 @@ void RenderRayTracing::renderVariant(float deltaTime, Camera* camera, Mesh* mesh
         OutputDebugStringW(L"DXR Error: m_meshIndexBufferSrvHandleGPU is null.\n");
         resourcesReady = false;
     }
+    if (m_meshPositionBufferSrvHandleGPU.ptr == 0) {
+        OutputDebugStringW(L"DXR Error: m_meshPositionBufferSrvHandleGPU is null.\n");
+        resourcesReady = false;
+    }
 
 
     if (!resourcesReady) {
@@ -197,7 +274,8 @@ void RenderRayTracing::renderVariant(float deltaTime, Camera* camera, Mesh* mesh
     commandList->SetComputeRootDescriptorTable(5, m_meshIndexBufferSrvHandleGPU); // Param 5: IB SRV Table (t3)
     commandList->SetComputeRootDescriptorTable(6, m_dxrObjectCbvHandleGPU); // Param 5: IB SRV Table (t3)
     commandList->SetComputeRootDescriptorTable(7, m_dxrLightCbvHandleGPU); // Param 7: DXR Light CBV (b3)
-    commandList->SetComputeRootDescriptorTable(8, m_dxrMaterialCbvHandleGPU); // Param 8: DXR Material CBV (b4)
+    commandList->SetComputeRootDescriptorTable(8, m_meshPositionBufferSrvHandleGPU); // Param 8: Position SRV (t4)
+    // Materials come from the hit group records (local root signature)
 
 
     D3D12_DISPATCH_RAYS_DESC rayDesc = {};
@@ -210,7 +288,7 @@ void RenderRayTracing::renderVariant(float deltaTime, Camera* camera, Mesh* mesh
     rayDesc.MissShaderTable.StrideInBytes = m_sbtEntrySize;
     UINT64 primaryHitGroupStart = AlignUp(primaryMissStart + m_sbtEntrySize * 2, tableAlignment);
     rayDesc.HitGroupTable.StartAddress = sbtBase + primaryHitGroupStart;
-    rayDesc.HitGroupTable.SizeInBytes = m_sbtEntrySize * 2;
+    rayDesc.HitGroupTable.SizeInBytes = UINT64(m_sbtEntrySize) * m_sbtHitGroupCount;
     rayDesc.HitGroupTable.StrideInBytes = m_sbtEntrySize;
     rayDesc.Width = m_swapChain->getWidth();
     rayDesc.Height = m_swapChain->getHeight();
@@ -254,60 +332,107 @@ void RenderRayTracing::renderVariant(float deltaTime, Camera* camera, Mesh* mesh
     }
 }
 
-bool RenderRayTracing::buildAccelerationStructures(Mesh* mesh) {
+Task<bool> RenderRayTracing::buildAccelerationStructures(Mesh* mesh, FrameScheduler& scheduler) {
     if (!m_rayTracingSupported || !mesh) {
-        return false;
+        co_return false;
     }
-    ID3D12Device5* device = nullptr;
-    HRESULT hr = m_device->getDevice()->QueryInterface(IID_PPV_ARGS(&device));
-    if (FAILED(hr)) {
-        return false;
+    // Hit shaders read the vertex buffer directly, so they must be compiled for the mesh's vertex format
+    if (mesh->getVertexFormat() != m_stateObjectVertexFormat) {
+        if (!createStateObject(L"Raytracing.hlsl", mesh->getVertexFormat())) {
+            OutputDebugStringW(L"Failed to rebuild DXR state object for mesh vertex format.\n");
+            co_return false;
+        }
     }
-
-    waitForGpu();
-    if (!m_commandManager->resetAllocator(m_currentFrameIndex)) {
-        OutputDebugStringW(L"Failed to reset allocator for AS build.\n");
-        device->Release();
-        return false;
+    // Hit records follow the mesh's submeshes, materials and LOD ranges
+    if (!buildShaderBindingTable(mesh)) {
+        OutputDebugStringW(L"Failed to build the shader binding table for the mesh.\n");
+        co_return false;
     }
-    if (!m_commandManager->resetCommandList(m_currentFrameIndex)) { // Reset without PSO
-        OutputDebugStringW(L"Failed to reset command list for AS build.\n");
-        device->Release();
-        return false;
+    // Not the frame's command list: its allocator belongs to a frame that may still be executing
+    BuildContext context;
+    if (!acquireBuildContext(context)) {
+        OutputDebugStringW(L"Failed to get a command list for the AS build.\n");
+        co_return false;
     }
 
-    ID3D12GraphicsCommandList5* commandList = nullptr;
-    m_commandManager->getCommandList()->QueryInterface(IID_PPV_ARGS(&commandList));
-    if (!commandList) {
-        device->Release();
-        return false;
+    // One BLAS per LOD, all built up front; switching levels at runtime only changes the TLAS instance
+    bool success = true;
+    for (AccelerationStructureBuffers& blas : m_blasBuffers) { // The TLAS of frames in flight references them
+        retire(std::move(blas.result));
+    }
+    m_blasBuffers.assign(mesh->getLodCount(), AccelerationStructureBuffers{});
+    m_tracedLod = 0;
+    for (size_t lod = 0; success && lod < m_blasBuffers.size(); ++lod) {
+        if (!buildBLAS(mesh, lod, context.commandList.Get())) {
+            success = false;
+        }
+    }
+    // The next frame builds the TLAS over the new BLAS, from the instance desc it writes for itself
+    m_tlasRebuild = true;
+    // Scratch memory is only needed until the build has executed
+    std::vector<ComPtr<ID3D12Resource>> scratch;
+    for (AccelerationStructureBuffers& blas : m_blasBuffers) {
+        scratch.push_back(std::move(blas.scratch));
     }
 
-    bool success = true;
-    if (!buildBLAS(mesh, commandList)) {
+    if (FAILED(context.commandList->Close())) {
         success = false;
     }
-    if (success && !buildTLAS(commandList)) {
+    if (!success) {
+        m_blasBuffers.clear(); // Never executed; frames clear instead of tracing a partial mesh
+        m_freeBuildContexts.push_back(std::move(context));
+        co_return false;
+    }
+    ID3D12CommandList* const commandLists[] = {context.commandList.Get()};
+    m_commandQueue->executeCommandLists(1, commandLists);
+    const UINT64 fenceValue = m_commandQueue->signal();
+    if (!createMeshBufferSRVs(mesh)) {
+        OutputDebugStringW(L"Failed to create Mesh Buffer SRVs during AS build phase.\n");
         success = false;
     }
 
-    hr = commandList->Close();
+    // Resumed by the scheduler's owner once the build has executed; frames keep being rendered meanwhile
+    co_await scheduler.waitForFence(fenceValue);
+    m_freeBuildContexts.push_back(std::move(context));
+    co_return success;
+}
+
+bool RenderRayTracing::acquireBuildContext(BuildContext& context) {
+    if (!m_freeBuildContexts.empty()) {
+        context = std::move(m_freeBuildContexts.back());
+        m_freeBuildContexts.pop_back();
+        return SUCCEEDED(context.allocator->Reset()) &&
+               SUCCEEDED(context.commandList->Reset(context.allocator.Get(), nullptr));
+    }
+    ID3D12Device* device = m_device->getDevice();
+    HRESULT hr = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&context.allocator));
     if (FAILED(hr)) {
-        success = false;
+        return false;
     }
-
-    if (success) {
-        ID3D12CommandList* const ppCommandLists[] = {commandList};
-        m_commandQueue->executeCommandLists(1, ppCommandLists);
-        m_commandQueue->join();
-        if (!createMeshBufferSRVs(mesh)) {
-            OutputDebugStringW(L"Failed to create Mesh Buffer SRVs during AS build phase.\n");
-            success = false; // Or handle differently
-        }
+    context.allocator->SetName(L"AS Build Allocator");
+    hr = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, context.allocator.Get(), nullptr,
+                                   IID_PPV_ARGS(&context.commandList));
+    if (FAILED(hr)) {
+        return false;
     }
+    context.commandList->SetName(L"AS Build Command List");
+    return true;
+}
 
-    commandList->Release();
-    return success;
+bool RenderRayTracing::reloadShaders(const Mesh* mesh) {
+    if (!m_rayTracingSupported) {
+        return false;
+    }
+    if (!createStateObject(L"Raytracing.hlsl", m_stateObjectVertexFormat)) {
+        OutputDebugStringW(L"Error: Failed to reload Raytracing.hlsl, keeping the previous state object.\n");
+        return false;
+    }
+    // Records hold shader identifiers, which belong to the state object
+    if (!buildShaderBindingTable(mesh)) {
+        OutputDebugStringW(L"Error: Failed to rebuild the shader binding table for the reloaded shaders.\n");
+        return false;
+    }
+    return true;
 }
 
 bool RenderRayTracing::checkRayTracingSupport() {
@@ -380,7 +505,9 @@ bool RenderRayTracing::createRootSignature() {
     // Param 3: Texture SRV Table (t1)
     // Param 4: VB SRV Table (t2)
     // Param 5: IB SRV Table (t3)
-    // Param 6: DXR Object CBV Table (b2)  <--- NEW
+    // Param 6: DXR Object CBV Table (b2)
+    // Param 7: DXR Light CBV Table (b3)
+    // Param 8: Position SRV Table (t4), for the texture LOD of split-position meshes
     CD3DX12_DESCRIPTOR_RANGE1 ranges[7];
     ranges[0].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0); // Output UAV @ u0
     ranges[1].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 1); // Camera CBV @ b1
@@ -388,7 +515,7 @@ bool RenderRayTracing::createRootSignature() {
     ranges[3].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2); // VB SRV @ t2
     ranges[4].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 3); // IB SRV @ t3
     ranges[5].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 2); // DXR Object CBV @ b2
-    ranges[6].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 3);
+    ranges[6].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 3); // DXR Light CBV @ b3
 
     CD3DX12_DESCRIPTOR_RANGE1 uavRange;
     uavRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0); // u0
@@ -404,8 +531,8 @@ bool RenderRayTracing::createRootSignature() {
     objCbRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 2); // b2
     CD3DX12_DESCRIPTOR_RANGE1 lightCbRange;
     lightCbRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 3); // b3
-    CD3DX12_DESCRIPTOR_RANGE1 matCbRange;
-    matCbRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, 1, 4); // b4
+    CD3DX12_DESCRIPTOR_RANGE1 positionSrRange;
+    positionSrRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 4); // t4
 
 
     CD3DX12_ROOT_PARAMETER1 rootParameters[9]; // 9 Parameters total
@@ -417,7 +544,7 @@ bool RenderRayTracing::createRootSignature() {
     rootParameters[5].InitAsDescriptorTable(1, &ibSrRange); // IB SRV
     rootParameters[6].InitAsDescriptorTable(1, &objCbRange); // DXR Object CBV
     rootParameters[7].InitAsDescriptorTable(1, &lightCbRange); // DXR Light CBV
-    rootParameters[8].InitAsDescriptorTable(1, &matCbRange); // DXR Material CBV
+    rootParameters[8].InitAsDescriptorTable(1, &positionSrRange); // Position SRV
 
     CD3DX12_STATIC_SAMPLER_DESC staticSampler(
         0, // shaderRegister (s0)
@@ -447,10 +574,28 @@ bool RenderRayTracing::createRootSignature() {
     }
     m_rootSignature->SetName(L"DXR Global Root Signature");
 
+    // Local root signature: the per-geometry index range and material, as root constants in the hit record
+    CD3DX12_ROOT_PARAMETER1 localParameters[1];
+    localParameters[0].InitAsConstants(sizeof(DXRGeometryConstants) / sizeof(uint32_t), 0, 1); // b0, space1
+    CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC localSignatureDesc;
+    localSignatureDesc.Init_1_1(_countof(localParameters), localParameters, 0, nullptr,
+                                D3D12_ROOT_SIGNATURE_FLAG_LOCAL_ROOT_SIGNATURE);
+    hr = D3DX12SerializeVersionedRootSignature(&localSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1_1,
+                                               &signatureBlob, &errorBlob);
+    if (FAILED(hr)) {
+        return false;
+    }
+    hr = device->CreateRootSignature(0, signatureBlob->GetBufferPointer(), signatureBlob->GetBufferSize(),
+                                     IID_PPV_ARGS(&m_localRootSignature));
+    if (FAILED(hr)) {
+        return false;
+    }
+    m_localRootSignature->SetName(L"DXR Hit Group Local Root Signature");
+
     return true;
 }
 
-bool RenderRayTracing::createStateObject(const std::wstring& shaderPath) {
+bool RenderRayTracing::createStateObject(const std::wstring& shaderPath, const VertexFormat& vertexFormat) {
     ID3D12Device5* dxrDevice = nullptr;
     m_device->getDevice()->QueryInterface(IID_PPV_ARGS(&dxrDevice));
     if (!dxrDevice) return false;
@@ -487,11 +632,22 @@ bool RenderRayTracing::createStateObject(const std::wstring& shaderPath) {
         dxrDevice->Release();
         return false;
     }
+    // With a file system the library and its includes come from a pack when it has them
+    VirtualFileIncludeHandler virtualFileIncludeHandler(m_fileSystem, dxcUtils.Get());
+    IDxcIncludeHandler* includeHandler = m_fileSystem ? &virtualFileIncludeHandler : dxcIncludeHandler.Get();
 
 
     // Load the shader source file
     ComPtr<IDxcBlobEncoding> sourceBlob;
-    hr = dxcUtils->LoadFile(shaderPath.c_str(), nullptr, &sourceBlob);
+    if (m_fileSystem) {
+        VirtualFile sourceFile;
+        hr = m_fileSystem->open(narrowPath(shaderPath), sourceFile)
+                 ? dxcUtils->CreateBlob(sourceFile.data(), static_cast<UINT32>(sourceFile.size()), DXC_CP_ACP,
+                                        &sourceBlob)
+                 : E_FAIL;
+    } else {
+        hr = dxcUtils->LoadFile(shaderPath.c_str(), nullptr, &sourceBlob);
+    }
     if (FAILED(hr)) {
         OutputDebugStringW((L"Error: Failed to load DXR shader file: " + shaderPath + L"\n").c_str());
         dxrDevice->Release();
@@ -503,58 +659,110 @@ bool RenderRayTracing::createStateObject(const std::wstring& shaderPath) {
     sourceBuffer.Size = sourceBlob->GetBufferSize();
     sourceBuffer.Encoding = DXC_CP_ACP;
 
-    // Compile the shader library
-    LPCWSTR args[] = {L"-E", L"", L"-T", L"lib_6_3", DXC_ARG_DEBUG, DXC_ARG_SKIP_OPTIMIZATIONS};
-    ComPtr<IDxcResult> compileResult;
-    hr = dxcCompiler->Compile(&sourceBuffer, args, _countof(args), dxcIncludeHandler.Get(),
-                              IID_PPV_ARGS(&compileResult));
-
-    // --- Enhanced Error Handling ---
-    bool compilationFailed = FAILED(hr); // Check initial Compile call result
-    HRESULT compileStatus = E_FAIL; // Assume failure initially
-    std::string dxcErrors = "";
-
-    if (SUCCEEDED(hr) && compileResult) { // Check if we got a result object
-        compileResult->GetStatus(&compileStatus); // Get the compilation status
-        compilationFailed = FAILED(compileStatus); // Update failure status
-
-        ComPtr<IDxcBlobUtf8> errorsBlob;
-        if (SUCCEEDED(compileResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errorsBlob), nullptr))) {
-            if (errorsBlob && errorsBlob->GetStringLength() > 0) {
-                dxcErrors = errorsBlob->GetStringPointer();
-                OutputDebugStringA("DXC Compilation Errors/Warnings:\n");
-                OutputDebugStringA(dxcErrors.c_str());
-                OutputDebugStringA("\n");
+    // Compile the shader library, selecting the vertex decode for the mesh's vertex format
+    std::vector<std::wstring> defines;
+    for (const std::string& define: getVertexFormatShaderDefines(vertexFormat)) {
+        defines.push_back(std::wstring(define.begin(), define.end()) + L"=1");
+    }
+    std::vector<LPCWSTR> args = {L"-E", L"", L"-T", L"lib_6_3", DXC_ARG_DEBUG, DXC_ARG_SKIP_OPTIMIZATIONS};
+    const size_t defineArgsStart = args.size();
+    for (const std::wstring& define: defines) {
+        args.push_back(L"-D");
+        args.push_back(define.c_str());
+    }
+
+    // The key covers the preprocessed source (so VertexDecode.hlsl edits miss) and every compiler argument
+    ComPtr<IDxcBlob> dxilBlob;
+    uint64_t cacheKey = 0;
+    ComPtr<IDxcCompiler> dxcPreprocessor;
+    if (m_derivedDataCache && SUCCEEDED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcPreprocessor)))) {
+        ComPtr<IDxcOperationResult> preprocessResult;
+        HRESULT preprocessStatus = E_FAIL;
+        ComPtr<IDxcBlob> preprocessed;
+        std::vector<LPCWSTR> defineArgs(args.begin() + defineArgsStart, args.end());
+        if (SUCCEEDED(dxcPreprocessor->Preprocess(sourceBlob.Get(), shaderPath.c_str(), defineArgs.data(),
+                                                  static_cast<UINT32>(defineArgs.size()), nullptr, 0,
+                                                  includeHandler, &preprocessResult)) &&
+            SUCCEEDED(preprocessResult->GetStatus(&preprocessStatus)) && SUCCEEDED(preprocessStatus) &&
+            SUCCEEDED(preprocessResult->GetResult(&preprocessed)) && preprocessed) {
+            uint64_t options = 0;
+            ComPtr<IDxcVersionInfo> versionInfo;
+            UINT32 major = 0;
+            UINT32 minor = 0;
+            if (SUCCEEDED(dxcCompiler.As(&versionInfo)) && SUCCEEDED(versionInfo->GetVersion(&major, &minor))) {
+                options = hashCombine(major, minor); // A compiler update rebuilds the library
+            }
+            for (LPCWSTR arg: args) {
+                options = hashCombine(options, hash64(arg, wcslen(arg) * sizeof(wchar_t)));
+            }
+            cacheKey = makeDerivedDataKey("shader-dxc", kShaderCompileRevision,
+                                          hash64(preprocessed->GetBufferPointer(), preprocessed->GetBufferSize()),
+                                          options);
+            std::vector<uint8_t> bytecode;
+            ComPtr<IDxcBlobEncoding> cachedBlob;
+            if (m_derivedDataCache->load(cacheKey, bytecode) && !bytecode.empty() &&
+                SUCCEEDED(dxcUtils->CreateBlob(bytecode.data(), static_cast<UINT32>(bytecode.size()), DXC_CP_ACP,
+                                               &cachedBlob))) {
+                dxilBlob = cachedBlob;
+                OutputDebugStringW((L"DXR shader library loaded from cache: " + shaderPath + L"\n").c_str());
             }
-        } else {
-            OutputDebugStringW(L"Warning: Failed to get DXC compilation errors blob.\n");
-        }
-    } else if (FAILED(hr)) {
-        OutputDebugStringW(L"Error: dxcCompiler->Compile() call failed directly.\n");
-    }
-
-    if (compilationFailed) {
-        OutputDebugStringW(L"Error: DXC Compilation Failed.\n");
-        // Display error message box
-        std::wstring errorMsg = L"DXC Shader Compilation Failed for: " + shaderPath +
-                                L"\n\nCheck Debug Output for details.";
-        if (!dxcErrors.empty()) {
-            // Convert narrow string error to wide string for MessageBoxW
-            std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
-            errorMsg += L"\n\nErrors:\n" + converter.from_bytes(dxcErrors);
         }
-        MessageBoxW(nullptr, errorMsg.c_str(), L"Shader Error", MB_OK | MB_ICONERROR);
-        dxrDevice->Release();
-        return false;
     }
-    // --- End Enhanced Error Handling ---
 
-    // Get the compiled DXIL blob
-    ComPtr<IDxcBlob> dxilBlob;
-    hr = compileResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&dxilBlob), nullptr);
-    if (FAILED(hr) || !dxilBlob) { /* ... error ... */
-        dxrDevice->Release();
-        return false;
+    if (!dxilBlob) {
+        ComPtr<IDxcResult> compileResult;
+        hr = dxcCompiler->Compile(&sourceBuffer, args.data(), static_cast<UINT32>(args.size()),
+                                  includeHandler, IID_PPV_ARGS(&compileResult));
+
+        // --- Enhanced Error Handling ---
+        bool compilationFailed = FAILED(hr); // Check initial Compile call result
+        HRESULT compileStatus = E_FAIL; // Assume failure initially
+        std::string dxcErrors = "";
+
+        if (SUCCEEDED(hr) && compileResult) { // Check if we got a result object
+            compileResult->GetStatus(&compileStatus); // Get the compilation status
+            compilationFailed = FAILED(compileStatus); // Update failure status
+
+            ComPtr<IDxcBlobUtf8> errorsBlob;
+            if (SUCCEEDED(compileResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&errorsBlob), nullptr))) {
+                if (errorsBlob && errorsBlob->GetStringLength() > 0) {
+                    dxcErrors = errorsBlob->GetStringPointer();
+                    OutputDebugStringA("DXC Compilation Errors/Warnings:\n");
+                    OutputDebugStringA(dxcErrors.c_str());
+                    OutputDebugStringA("\n");
+                }
+            } else {
+                OutputDebugStringW(L"Warning: Failed to get DXC compilation errors blob.\n");
+            }
+        } else if (FAILED(hr)) {
+            OutputDebugStringW(L"Error: dxcCompiler->Compile() call failed directly.\n");
+        }
+
+        if (compilationFailed) {
+            OutputDebugStringW(L"Error: DXC Compilation Failed.\n");
+            // Display error message box
+            std::wstring errorMsg = L"DXC Shader Compilation Failed for: " + shaderPath +
+                                    L"\n\nCheck Debug Output for details.";
+            if (!dxcErrors.empty()) {
+                // Convert narrow string error to wide string for MessageBoxW
+                std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+                errorMsg += L"\n\nErrors:\n" + converter.from_bytes(dxcErrors);
+            }
+            MessageBoxW(nullptr, errorMsg.c_str(), L"Shader Error", MB_OK | MB_ICONERROR);
+            dxrDevice->Release();
+            return false;
+        }
+        // --- End Enhanced Error Handling ---
+
+        // Get the compiled DXIL blob
+        hr = compileResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&dxilBlob), nullptr);
+        if (FAILED(hr) || !dxilBlob) { /* ... error ... */
+            dxrDevice->Release();
+            return false;
+        }
+        if (cacheKey != 0) {
+            m_derivedDataCache->store(cacheKey, dxilBlob->GetBufferPointer(), dxilBlob->GetBufferSize());
+        }
     }
 
     // --- Build the State Object ---
@@ -595,13 +803,21 @@ bool RenderRayTracing::createStateObject(const std::wstring& shaderPath) {
     auto globalRootSig = rtPipeline.CreateSubobject<CD3DX12_GLOBAL_ROOT_SIGNATURE_SUBOBJECT>();
     globalRootSig->SetRootSignature(m_rootSignature.Get());
 
+    // Local root signature for the primary hit group's geometry constants
+    auto localRootSig = rtPipeline.CreateSubobject<CD3DX12_LOCAL_ROOT_SIGNATURE_SUBOBJECT>();
+    localRootSig->SetRootSignature(m_localRootSignature.Get());
+    auto localRootSigAssociation = rtPipeline.CreateSubobject<CD3DX12_SUBOBJECT_TO_EXPORTS_ASSOCIATION_SUBOBJECT>();
+    localRootSigAssociation->SetSubobjectToAssociate(*localRootSig);
+    localRootSigAssociation->AddExport(L"HitGroup");
+
     // 5. Pipeline Config Subobject
     auto pipelineConfig = rtPipeline.CreateSubobject<CD3DX12_RAYTRACING_PIPELINE_CONFIG_SUBOBJECT>();
     UINT maxRecursionDepth = 2;
     pipelineConfig->Config(maxRecursionDepth);
 
     // 6. Create the State Object
-    hr = dxrDevice->CreateStateObject(rtPipeline, IID_PPV_ARGS(&m_stateObject));
+    ComPtr<ID3D12StateObject> stateObject;
+    hr = dxrDevice->CreateStateObject(rtPipeline, IID_PPV_ARGS(&stateObject));
     if (FAILED(hr)) {
         OutputDebugStringW(L"Error: Failed to create DXR State Object (RTPSO). HRESULT: ");
         OutputDebugStringW(std::to_wstring(hr).c_str());
@@ -610,13 +826,17 @@ bool RenderRayTracing::createStateObject(const std::wstring& shaderPath) {
         dxrDevice->Release();
         return false;
     }
-    m_stateObject->SetName(L"DXR State Object");
+    stateObject->SetName(L"DXR State Object");
+
+    retire(std::move(m_stateObject)); // Frames in flight may still trace with it
+    m_stateObject = stateObject;
+    m_stateObjectVertexFormat = vertexFormat;
 
     dxrDevice->Release();
     return true;
 }
 
-bool RenderRayTracing::buildShaderBindingTable() {
+bool RenderRayTracing::buildShaderBindingTable(const Mesh* mesh) {
     ID3D12Device* device = m_device->getDevice();
     if (!m_stateObject) {
         return false;
@@ -639,7 +859,9 @@ bool RenderRayTracing::buildShaderBindingTable() {
     }
 
     UINT shaderIdSize = D3D12_SHADER_IDENTIFIER_SIZE_IN_BYTES;
-    m_sbtEntrySize = AlignUp(shaderIdSize, D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
+    // Every record has room for the hit group's local root constants, so all tables share one stride
+    m_sbtEntrySize = AlignUp(shaderIdSize + sizeof(DXRGeometryConstants),
+                             D3D12_RAYTRACING_SHADER_RECORD_BYTE_ALIGNMENT);
     if (m_sbtEntrySize == 0) {
         return false;
     }
@@ -647,7 +869,9 @@ bool RenderRayTracing::buildShaderBindingTable() {
     UINT tableAlignment = D3D12_RAYTRACING_SHADER_TABLE_BYTE_ALIGNMENT; // 64 bytes
     UINT numRayGenEntries = 1;
     UINT numMissEntries = 2;
-    UINT numHitGroupEntries = 2;
+    UINT numLevels = mesh ? static_cast<UINT>(mesh->getLodCount()) : 1;
+    UINT numSubmeshes = mesh ? static_cast<UINT>(mesh->getSubmeshes().size()) : 1;
+    UINT numHitGroupEntries = numLevels * numSubmeshes * 2;
     UINT64 rayGenTableStart = 0;
     UINT64 missTableStart = AlignUp(rayGenTableStart + numRayGenEntries * m_sbtEntrySize, tableAlignment);
     UINT64 hitGroupTableStart = AlignUp(missTableStart + numMissEntries * m_sbtEntrySize, tableAlignment);
@@ -664,7 +888,7 @@ bool RenderRayTracing::buildShaderBindingTable() {
         (L"  RayGen Start: 0, Miss Start: " + std::to_wstring(missTableStart) + L", HitGroup Start: " +
          std::to_wstring(hitGroupTableStart) + L"\n").c_str());
 
-    m_shaderBindingTable.Reset();
+    retire(std::move(m_shaderBindingTable)); // Read by the DispatchRays of frames in flight
     auto uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
     auto sbtBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(sbtSize);
     hr = device->CreateCommittedResource(
@@ -688,41 +912,103 @@ bool RenderRayTracing::buildShaderBindingTable() {
     memcpy(pSBT + missTableStart, missId, shaderIdSize);
     memcpy(pSBT + missTableStart + (1 * m_sbtEntrySize), shadowMissId, shaderIdSize);
 
-    // Copy HitGroup ID (Offset by 2 entry sizes)
-    memcpy(pSBT + hitGroupTableStart, hitGroupId, shaderIdSize);
-    memcpy(pSBT + hitGroupTableStart + (1 * m_sbtEntrySize), shadowHitGroupId, shaderIdSize);
-    
+    // Copy HitGroup IDs: primary + shadow record for every submesh of every LOD
+    for (UINT level = 0; level < numLevels; ++level) {
+        for (UINT submeshIndex = 0; submeshIndex < numSubmeshes; ++submeshIndex) {
+            DXRGeometryConstants geometry = {};
+            geometry.indexSize = sizeof(uint32_t);
+            geometry.material = makeMaterialConstant(nullptr);
+            if (mesh) {
+                const Submesh& submesh = mesh->getSubmeshes()[submeshIndex];
+                geometry.firstIndex = mesh->getSubmeshLod(submesh, level).indexOffset;
+                geometry.baseVertex = submesh.baseVertex;
+                geometry.indexSize = mesh->getIndexSize();
+                if (submesh.materialIndex < mesh->getMaterials().size()) {
+                    geometry.material = makeMaterialConstant(&mesh->getMaterials()[submesh.materialIndex]);
+                }
+            }
+            UINT recordIndex = (level * numSubmeshes + submeshIndex) * 2;
+            UINT8* record = pSBT + hitGroupTableStart + recordIndex * m_sbtEntrySize;
+            memcpy(record, hitGroupId, shaderIdSize);
+            memcpy(record + shaderIdSize, &geometry, sizeof(geometry));
+            memcpy(record + m_sbtEntrySize, shadowHitGroupId, shaderIdSize);
+        }
+    }
+    m_sbtHitGroupCount = numHitGroupEntries;
+    m_sbtSubmeshCount = numSubmeshes;
+
     // Unmap the buffer
     m_shaderBindingTable->Unmap(0, nullptr);
 
     return true;
 }
 
-bool RenderRayTracing::buildBLAS(Mesh* mesh, ID3D12GraphicsCommandList5* commandList) {
+bool RenderRayTracing::buildBLAS(Mesh* mesh, size_t lod, ID3D12GraphicsCommandList5* commandList) {
     ID3D12Device5* device = nullptr;
     m_device->getDevice()->QueryInterface(IID_PPV_ARGS(&device));
     if (!device) {
         return false;
     }
 
-    D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
-    geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
-    geometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
-    geometryDesc.Triangles.Transform3x4 = 0; // No local transform within BLAS
-    geometryDesc.Triangles.IndexFormat = mesh->getIndexFormat();
-    geometryDesc.Triangles.VertexFormat = DXGI_FORMAT_R32G32B32_FLOAT; // Assuming position is float3
-    geometryDesc.Triangles.IndexCount = mesh->getIndexCount();
-    geometryDesc.Triangles.VertexCount = mesh->getVertexCount();
-    geometryDesc.Triangles.IndexBuffer = mesh->getIndexBufferGPUVirtualAddress();
-    geometryDesc.Triangles.VertexBuffer.StartAddress = mesh->getVertexBufferGPUVirtualAddress();
-    geometryDesc.Triangles.VertexBuffer.StrideInBytes = mesh->getVertexStride();
+    // Quantized positions are built into the BLAS through a 3x4 transform that applies the dequantization,
+    // so the acceleration structure (and the instance transform) stay in object space. All LODs share it.
+    D3D12_GPU_VIRTUAL_ADDRESS positionTransform = 0;
+    if (mesh->getVertexFormat().position != PositionEncoding::Float32) {
+        if (lod == 0 || !m_blasTransform) {
+            const VertexQuantization& quantization = mesh->getVertexQuantization();
+            float transform[3][4] = {
+                {quantization.positionScale.x, 0.0f, 0.0f, quantization.positionOffset.x},
+                {0.0f, quantization.positionScale.y, 0.0f, quantization.positionOffset.y},
+                {0.0f, 0.0f, quantization.positionScale.z, quantization.positionOffset.z},
+            };
+            retire(std::move(m_blasTransform)); // Read by builds that may still be executing
+            m_blasTransform = std::make_unique<Buffer>();
+            if (!m_blasTransform->create(device, sizeof(transform), D3D12_HEAP_TYPE_UPLOAD,
+                                         D3D12_RESOURCE_STATE_GENERIC_READ)) {
+                device->Release();
+                return false;
+            }
+            void* mapped = m_blasTransform->map();
+            if (!mapped) {
+                device->Release();
+                return false;
+            }
+            memcpy(mapped, transform, sizeof(transform));
+            m_blasTransform->unmap(sizeof(transform));
+            m_blasTransform->getResource()->SetName(L"BLAS Position Dequantization Transform");
+        }
+        positionTransform = m_blasTransform->getGPUVirtualAddress();
+    }
+
+    // One geometry per submesh, in submesh order: GeometryIndex() selects the submesh's hit record
+    std::vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometryDescs;
+    geometryDescs.reserve(mesh->getSubmeshes().size());
+    for (const Submesh& submesh : mesh->getSubmeshes()) {
+        D3D12_RAYTRACING_GEOMETRY_DESC geometryDesc = {};
+        geometryDesc.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+        geometryDesc.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+        geometryDesc.Triangles.Transform3x4 = positionTransform; // 0 unless positions are quantized
+        geometryDesc.Triangles.IndexFormat = mesh->getIndexFormat();
+        geometryDesc.Triangles.VertexFormat = getPositionFormat(mesh->getVertexFormat());
+        const MeshLod& level = mesh->getSubmeshLod(submesh, lod);
+        geometryDesc.Triangles.IndexCount = level.indexCount;
+        geometryDesc.Triangles.VertexCount = mesh->getVertexCount() - submesh.baseVertex;
+        geometryDesc.Triangles.IndexBuffer = mesh->getIndexBufferGPUVirtualAddress() +
+                                             UINT64(level.indexOffset) * mesh->getIndexSize();
+        // Only the position stream is read by the build; with split positions it is tightly packed. Indices
+        // are relative to the submesh's base vertex, so its vertices start there.
+        geometryDesc.Triangles.VertexBuffer.StartAddress = mesh->getPositionBufferGPUVirtualAddress() +
+                                                           UINT64(submesh.baseVertex) * mesh->getPositionStride();
+        geometryDesc.Triangles.VertexBuffer.StrideInBytes = mesh->getPositionStride();
+        geometryDescs.push_back(geometryDesc);
+    }
 
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS blasInputs = {};
     blasInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
     blasInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
-    blasInputs.NumDescs = 1;
+    blasInputs.NumDescs = static_cast<UINT>(geometryDescs.size());
     blasInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-    blasInputs.pGeometryDescs = &geometryDesc;
+    blasInputs.pGeometryDescs = geometryDescs.data();
 
     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO blasPrebuildInfo = {};
     device->GetRaytracingAccelerationStructurePrebuildInfo(&blasInputs, &blasPrebuildInfo);
@@ -730,46 +1016,47 @@ bool RenderRayTracing::buildBLAS(Mesh* mesh, ID3D12GraphicsCommandList5* command
         device->Release();
         return false; // Error or empty geometry
     }
-    m_blasBuffers.scratch.Reset();
-    m_blasBuffers.result.Reset();
+    AccelerationStructureBuffers& blas = m_blasBuffers[lod];
+    blas.scratch.Reset();
+    blas.result.Reset();
     auto defaultHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
     auto uavBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(blasPrebuildInfo.ScratchDataSizeInBytes,
                                                        D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
     HRESULT hr = device->CreateCommittedResource( // Use dxrDevice for consistency
         &defaultHeapProps, D3D12_HEAP_FLAG_NONE, &uavBufferDesc,
-        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&m_blasBuffers.scratch));
+        D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&blas.scratch));
     if (FAILED(hr)) {
         device->Release();
         return false;
     }
-    m_blasBuffers.scratch->SetName(L"BLAS Scratch Buffer");
+    blas.scratch->SetName(L"BLAS Scratch Buffer");
 
     uavBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(blasPrebuildInfo.ResultDataMaxSizeInBytes,
                                                   D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
     hr = device->CreateCommittedResource(
         &defaultHeapProps, D3D12_HEAP_FLAG_NONE, &uavBufferDesc,
-        D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, nullptr, IID_PPV_ARGS(&m_blasBuffers.result));
+        D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, nullptr, IID_PPV_ARGS(&blas.result));
     if (FAILED(hr)) {
         device->Release();
         return false;
     }
-    m_blasBuffers.result->SetName(L"BLAS Result Buffer");
+    blas.result->SetName(L"BLAS Result Buffer");
 
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC blasDesc = {};
     blasDesc.Inputs = blasInputs;
-    blasDesc.ScratchAccelerationStructureData = m_blasBuffers.scratch->GetGPUVirtualAddress();
-    blasDesc.DestAccelerationStructureData = m_blasBuffers.result->GetGPUVirtualAddress();
+    blasDesc.ScratchAccelerationStructureData = blas.scratch->GetGPUVirtualAddress();
+    blasDesc.DestAccelerationStructureData = blas.result->GetGPUVirtualAddress();
 
     commandList->BuildRaytracingAccelerationStructure(&blasDesc, 0, nullptr); // No update or instance data for BLAS
 
-    auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(m_blasBuffers.result.Get());
+    auto uavBarrier = CD3DX12_RESOURCE_BARRIER::UAV(blas.result.Get());
     commandList->ResourceBarrier(1, &uavBarrier);
     device->Release();
     return true;
 }
 
 bool RenderRayTracing::buildTLAS(ID3D12GraphicsCommandList5* commandList) {
-    if (!m_blasBuffers.result) {
+    if (m_tracedLod >= m_blasBuffers.size() || !m_blasBuffers[m_tracedLod].result) {
         return false;
     }
 
@@ -779,50 +1066,21 @@ bool RenderRayTracing::buildTLAS(ID3D12GraphicsCommandList5* commandList) {
         return false;
     }
 
-    D3D12_RAYTRACING_INSTANCE_DESC tlasInstanceDesc = {};
-    glm::mat4 transposedWorld = glm::transpose(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-    memcpy(tlasInstanceDesc.Transform, glm::value_ptr(transposedWorld), sizeof(tlasInstanceDesc.Transform));
-    tlasInstanceDesc.InstanceID = 0;
-    tlasInstanceDesc.InstanceMask = 1;
-    tlasInstanceDesc.AccelerationStructure = m_blasBuffers.result->GetGPUVirtualAddress();
-    tlasInstanceDesc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE; // Disable culling for now
-
-    /*
-    auto uploadHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-    auto instanceDescBufferSize = sizeof(tlasInstanceDesc);
-    auto instanceDescBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(instanceDescBufferSize);
-    HRESULT hr = device->CreateCommittedResource(
-        &uploadHeapProps, D3D12_HEAP_FLAG_NONE, &instanceDescBufferDesc,
-        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_tlasBuffers.instanceDesc));
-
-    if (FAILED(hr)) {
-        device->Release();
-        return false;
-    }
-    */
-    m_tlasBuffers.instanceDesc->SetName(L"TLAS Instance Buffer");
-
-    void* mappedData = nullptr;
-    HRESULT hr = m_tlasBuffers.instanceDesc->Map(0, nullptr, &mappedData);
-    if (FAILED(hr)) {
+    ID3D12Resource* instanceDescs = m_tlasInstanceDescs[m_currentFrameIndex].Get();
+    if (!instanceDescs) {
         device->Release();
         return false;
     }
-    memcpy(mappedData, &tlasInstanceDesc, sizeof(tlasInstanceDesc));
-    m_tlasBuffers.instanceDesc->Unmap(0, nullptr);
 
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS tlasInputs = {};
     tlasInputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
     tlasInputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE |
                        D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
-    bool performUpdate = m_tlasBuffers.result != nullptr;
-
-    if (performUpdate) { // If we have a previous TLAS, it's an update
-        tlasInputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
-    }
+    bool performUpdate = m_tlasBuffers.result != nullptr && !m_tlasRebuild;
+    m_tlasRebuild = false;
     tlasInputs.NumDescs = 1;
     tlasInputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
-    tlasInputs.InstanceDescs = m_tlasBuffers.instanceDesc->GetGPUVirtualAddress();
+    tlasInputs.InstanceDescs = instanceDescs->GetGPUVirtualAddress();
 
     D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO tlasPrebuildInfo = {};
     device->GetRaytracingAccelerationStructurePrebuildInfo(&tlasInputs, &tlasPrebuildInfo);
@@ -832,10 +1090,11 @@ bool RenderRayTracing::buildTLAS(ID3D12GraphicsCommandList5* commandList) {
     }
 
     if (!m_tlasBuffers.scratch || m_tlasBuffers.scratch->GetDesc().Width < tlasPrebuildInfo.ScratchDataSizeInBytes) {
+        retire(std::move(m_tlasBuffers.scratch));
         auto defaultHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
         auto uavBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(tlasPrebuildInfo.ScratchDataSizeInBytes,
                                                            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-        hr = device->CreateCommittedResource(
+        HRESULT hr = device->CreateCommittedResource(
             &defaultHeapProps, D3D12_HEAP_FLAG_NONE, &uavBufferDesc,
             D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&m_tlasBuffers.scratch));
         if (FAILED(hr)) {
@@ -845,16 +1104,16 @@ bool RenderRayTracing::buildTLAS(ID3D12GraphicsCommandList5* commandList) {
         m_tlasBuffers.scratch->SetName(L"TLAS Scratch Buffer");
     }
 
-    ComPtr<ID3D12Resource> previousTLASResult = m_tlasBuffers.result;
-    if (!performUpdate || !m_tlasBuffers.result ||
-        m_tlasBuffers.result->GetDesc().Width < tlasPrebuildInfo.ResultDataMaxSizeInBytes) {
-        m_tlasBuffers.result.Reset(); // Release if it's too small or doesn't exist
+    // A rebuild (the instance switched LOD) goes into the current buffer when it fits: ordered on the queue after
+    // the frames that trace it, and reallocating would free a buffer they still use
+    if (!m_tlasBuffers.result || m_tlasBuffers.result->GetDesc().Width < tlasPrebuildInfo.ResultDataMaxSizeInBytes) {
+        retire(std::move(m_tlasBuffers.result));
         auto defaultHeapProps = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
         auto uavBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(tlasPrebuildInfo.ResultDataMaxSizeInBytes,
                                                            D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-        hr = device->CreateCommittedResource(&defaultHeapProps, D3D12_HEAP_FLAG_NONE, &uavBufferDesc,
-                                             D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, nullptr,
-                                             IID_PPV_ARGS(&m_tlasBuffers.result));
+        HRESULT hr = device->CreateCommittedResource(&defaultHeapProps, D3D12_HEAP_FLAG_NONE, &uavBufferDesc,
+                                                     D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, nullptr,
+                                                     IID_PPV_ARGS(&m_tlasBuffers.result));
         if (FAILED(hr)) {
             device->Release();
             return false;
@@ -862,6 +1121,9 @@ bool RenderRayTracing::buildTLAS(ID3D12GraphicsCommandList5* commandList) {
         m_tlasBuffers.result->SetName(L"TLAS Result Buffer");
         performUpdate = false; // It's now an initial build into the new buffer
     }
+    if (performUpdate) { // If we have a previous TLAS, it's an update
+        tlasInputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+    }
 
     D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC tlasBuildDesc = {};
     tlasBuildDesc.Inputs = tlasInputs;
@@ -889,48 +1151,77 @@ bool RenderRayTracing::createMeshBufferSRVs(Mesh* mesh) {
         return false;
     }
 
-    // --- Heap Layout Plan (Indices) ---
-    // 0 to k-1: Per-Frame Light CBVs (Raster)
-    // k:        Material CBV (Raster)
-    // k+1:      DXR Camera CBV
-    // k+2:      Texture SRV
-    // k+3:      Mesh VB SRV  <--- Creating this
-    // k+4:      Mesh IB SRV  <--- Creating this
-    // k+5:      DXR Output UAV
-    UINT vbSrvIndex = m_numFramesInFlight + 1 + 1; // After Light CBVs, Mat CBV, DXR Cam CBV
-    UINT ibSrvIndex = vbSrvIndex + 1;
-
-    D3D12_CPU_DESCRIPTOR_HANDLE cpuHandle = {0};
-    D3D12_GPU_DESCRIPTOR_HANDLE gpuHandle = {0}; // Needed by AllocateDescriptor
+    // Every mesh gets views of its own: frames in flight may still read the previous mesh's, which are retired
+    // instead of being rewritten under them
+    if (m_meshVertexBufferSrvHandleCPU.ptr != 0) {
+        auto retired = std::make_shared<RetiredDescriptors>();
+        retired->heap = m_srvHeap;
+        retired->handles = {m_meshVertexBufferSrvHandleCPU, m_meshIndexBufferSrvHandleCPU,
+                            m_meshPositionBufferSrvHandleCPU};
+        retire(std::move(retired));
+        m_meshVertexBufferSrvHandleCPU = {0};
+        m_meshIndexBufferSrvHandleCPU = {0};
+        m_meshPositionBufferSrvHandleCPU = {0};
+        m_meshVertexBufferSrvHandleGPU = {0};
+        m_meshIndexBufferSrvHandleGPU = {0};
+        m_meshPositionBufferSrvHandleGPU = {0};
+    }
+    if (!m_srvHeap->allocateDescriptor(m_meshVertexBufferSrvHandleCPU, m_meshVertexBufferSrvHandleGPU)) {
+        return false;
+    }
+    if (!m_srvHeap->allocateDescriptor(m_meshIndexBufferSrvHandleCPU, m_meshIndexBufferSrvHandleGPU)) {
+        OutputDebugStringW(L"Error: Failed to allocate IB SRV descriptor.\n");
+        m_srvHeap->freeDescriptor(m_meshVertexBufferSrvHandleCPU);
+        m_meshVertexBufferSrvHandleCPU = {0};
+        m_meshVertexBufferSrvHandleGPU = {0};
+        return false;
+    }
+    if (!m_srvHeap->allocateDescriptor(m_meshPositionBufferSrvHandleCPU, m_meshPositionBufferSrvHandleGPU)) {
+        OutputDebugStringW(L"Error: Failed to allocate position SRV descriptor.\n");
+        m_srvHeap->freeDescriptor(m_meshIndexBufferSrvHandleCPU);
+        m_srvHeap->freeDescriptor(m_meshVertexBufferSrvHandleCPU);
+        m_meshIndexBufferSrvHandleCPU = {0};
+        m_meshVertexBufferSrvHandleCPU = {0};
+        m_meshIndexBufferSrvHandleGPU = {0};
+        m_meshVertexBufferSrvHandleGPU = {0};
+        return false;
+    }
 
     // 1. Create Vertex Buffer SRV
-    if (!m_srvHeap->allocateDescriptor(cpuHandle, gpuHandle)) return false; // Allocate slot k+3
-    m_meshVertexBufferSrvHandleGPU = gpuHandle; // Store GPU handle
     D3D12_SHADER_RESOURCE_VIEW_DESC vbSrvDesc = {};
     vbSrvDesc.Format = DXGI_FORMAT_UNKNOWN; // Structured buffer
     vbSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
     vbSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-    vbSrvDesc.Buffer.FirstElement = 0;
+    vbSrvDesc.Buffer.FirstElement = mesh->getVertexBufferOffset() / mesh->getVertexStride(); // Skips split positions
     vbSrvDesc.Buffer.NumElements = mesh->getVertexCount();
     vbSrvDesc.Buffer.StructureByteStride = mesh->getVertexStride();
     vbSrvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_NONE;
-    device->CreateShaderResourceView(mesh->getVertexBufferResource(), &vbSrvDesc, cpuHandle);
+    device->CreateShaderResourceView(mesh->getVertexBufferResource(), &vbSrvDesc, m_meshVertexBufferSrvHandleCPU);
 
     // 2. Create Index Buffer SRV
-    if (!m_srvHeap->allocateDescriptor(cpuHandle, gpuHandle)) {
-        OutputDebugStringW(L"Error: Failed to allocate IB SRV descriptor.\n");
-        return false;
-    }
-    m_meshIndexBufferSrvHandleGPU = gpuHandle; // Store GPU handle
     D3D12_SHADER_RESOURCE_VIEW_DESC ibSrvDesc = {};
     ibSrvDesc.Format = DXGI_FORMAT_R32_TYPELESS; // For ByteAddressBuffer
     ibSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
     ibSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
     ibSrvDesc.Buffer.FirstElement = 0;
-    ibSrvDesc.Buffer.NumElements = mesh->getIndexCount(); // Number of indices
+    // Every LOD, in 32-bit words (16-bit indices are padded to a whole word); the hit shader adds firstIndex
+    ibSrvDesc.Buffer.NumElements = (mesh->getTotalIndexCount() * mesh->getIndexSize() + 3) / 4;
     ibSrvDesc.Buffer.StructureByteStride = 0; // Not structured
     ibSrvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
-    device->CreateShaderResourceView(mesh->getIndexBufferResource(), &ibSrvDesc, cpuHandle);
+    device->CreateShaderResourceView(mesh->getIndexBufferResource(), &ibSrvDesc, m_meshIndexBufferSrvHandleCPU);
+
+    // 3. Create Position SRV: the position stream, or the interleaved vertices when positions are not split
+    ID3D12Resource* vertexResource = mesh->getVertexBufferResource();
+    D3D12_SHADER_RESOURCE_VIEW_DESC positionSrvDesc = {};
+    positionSrvDesc.Format = DXGI_FORMAT_R32_TYPELESS; // For ByteAddressBuffer
+    positionSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+    positionSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    positionSrvDesc.Buffer.FirstElement =
+        (mesh->getPositionBufferGPUVirtualAddress() - vertexResource->GetGPUVirtualAddress()) / 4;
+    positionSrvDesc.Buffer.NumElements = (mesh->getVertexCount() * mesh->getPositionStride() + 3) / 4;
+    positionSrvDesc.Buffer.StructureByteStride = 0;
+    positionSrvDesc.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
+    device->CreateShaderResourceView(vertexResource, &positionSrvDesc, m_meshPositionBufferSrvHandleCPU);
 
     return true;
 }
@@ -958,11 +1249,18 @@ void RenderRayTracing::updateConstantBuffers(float deltaTime, Camera* camera, Me
             m_dxrCameraCB->unmap(sizeof(DXRCameraConstants));
         }
     }
+    // Trace the coarsest LOD within the pixel error budget; a new level means a new BLAS for the instance
+    if (mesh && !m_blasBuffers.empty()) {
+        size_t lod = std::min(selectLod(camera, mesh), m_blasBuffers.size() - 1);
+        m_tlasRebuild = m_tlasRebuild || lod != m_tracedLod;
+        m_tracedLod = lod;
+    }
     if (m_rayTracingSupported && m_dxrObjectCB && mesh) { // Check pMesh too
         DXRObjectConstants dxrObjConsts = {};
         // Use the same world matrix as raster for consistency for now
         dxrObjConsts.worldMatrix = worldMatrix;
         dxrObjConsts.invTransposeWorldMatrix = glm::transpose(glm::inverse(glm::mat3(dxrObjConsts.worldMatrix)));
+        dxrObjConsts.vertexDecode = makeVertexDecodeConstant(mesh->getVertexQuantization());
         // For normals
 
         void* dxrObjMapped = m_dxrObjectCB->map();
@@ -971,21 +1269,24 @@ void RenderRayTracing::updateConstantBuffers(float deltaTime, Camera* camera, Me
             m_dxrObjectCB->unmap(sizeof(DXRObjectConstants));
         }
     }
-    if (m_rayTracingSupported && m_tlasBuffers.instanceDesc && m_blasBuffers.result
-    ) {
+    ID3D12Resource* instanceDescs = m_tlasInstanceDescs[m_currentFrameIndex].Get();
+    if (m_rayTracingSupported && instanceDescs && m_tracedLod < m_blasBuffers.size() &&
+        m_blasBuffers[m_tracedLod].result) {
         D3D12_RAYTRACING_INSTANCE_DESC instanceDesc = {};
         glm::mat4 transposedWorld = glm::transpose(worldMatrix); // DXR instance transform is row-major
         memcpy(instanceDesc.Transform, glm::value_ptr(transposedWorld), sizeof(instanceDesc.Transform));
         instanceDesc.InstanceMask = 1;
         instanceDesc.InstanceID = 0;
+        // Hit records of the traced LOD (see buildShaderBindingTable)
+        instanceDesc.InstanceContributionToHitGroupIndex = static_cast<UINT>(m_tracedLod) * m_sbtSubmeshCount * 2;
         instanceDesc.Flags = D3D12_RAYTRACING_INSTANCE_FLAG_TRIANGLE_CULL_DISABLE;
-        instanceDesc.AccelerationStructure = m_blasBuffers.result->GetGPUVirtualAddress();
+        instanceDesc.AccelerationStructure = m_blasBuffers[m_tracedLod].result->GetGPUVirtualAddress();
 
         void* pMappedData = nullptr;
-        HRESULT hr = m_tlasBuffers.instanceDesc->Map(0, nullptr, &pMappedData);
+        HRESULT hr = instanceDescs->Map(0, nullptr, &pMappedData);
         if (SUCCEEDED(hr) && pMappedData) {
             memcpy(pMappedData, &instanceDesc, sizeof(instanceDesc));
-            m_tlasBuffers.instanceDesc->Unmap(0, nullptr);
+            instanceDescs->Unmap(0, nullptr);
         } else {
             OutputDebugStringW(L"Error: Failed to map TLAS instance descriptor buffer for update.\n");
         }
@@ -1,12 +1,22 @@
 #pragma once
 #include "BaseRenderer.hpp"
+#include "core/FrameScheduler.hpp"
+#include "core/Task.hpp"
 
 struct AccelerationStructureBuffers {
     ComPtr<ID3D12Resource> scratch = nullptr; // Scratch memory for build
     ComPtr<ID3D12Resource> result = nullptr; // Stores final AS
-    ComPtr<ID3D12Resource> instanceDesc = nullptr; // Holds instance descs for TLAS build (Upload heap)
 };
 
+// Local root constants of a "HitGroup" record (GeometryConstants in Raytracing.hlsl): one record per
+// submesh and LOD, so each BLAS geometry finds its own index range and material
+struct DXRGeometryConstants {
+    uint32_t firstIndex; // Start of the submesh LOD in the index buffer; PrimitiveIndex() is relative to it
+    uint32_t baseVertex; // Added to the submesh's indices
+    uint32_t indexSize; // 2 or 4 bytes, from Mesh::getIndexFormat()
+    uint32_t padding;
+    MaterialConstant material;
+};
 
 class RenderRayTracing : public BaseRenderer {
 public:
@@ -21,20 +31,49 @@ public:
     void renderVariant(float deltaTime, Camera* camera, Mesh* mesh, Texture* texture,
                        ID3D12GraphicsCommandList* commandList) override;
 
-    bool buildAccelerationStructures(Mesh* mesh);
+    // Records the BLAS of every mesh LOD on a command list of its own and submits it without waiting for the GPU:
+    // frames rendered afterwards are queued behind the build, so they trace the new mesh right away. Completes
+    // through scheduler once the build has executed, which frees its scratch memory and command list. The
+    // structures, hit records and views it replaces are retired, never released under frames in flight.
+    Task<bool> buildAccelerationStructures(Mesh* mesh, FrameScheduler& scheduler);
+
+    // Recompiles Raytracing.hlsl (e.g. after an edit) into a new state object and rebuilds the shader binding
+    // table for the mesh the acceleration structures were built for (nullptr if none). The BLAS and TLAS are
+    // kept. On failure the state object built before stays in use.
+    bool reloadShaders(const Mesh* mesh);
 
 private:
-    AccelerationStructureBuffers m_blasBuffers;
+    // Command allocator and list of one acceleration structure build, reused once its fence has completed
+    struct BuildContext {
+        ComPtr<ID3D12CommandAllocator> allocator;
+        ComPtr<ID3D12GraphicsCommandList5> commandList;
+    };
+
+    std::vector<BuildContext> m_freeBuildContexts;
+    std::vector<AccelerationStructureBuffers> m_blasBuffers; // One per mesh LOD, one geometry per submesh
     AccelerationStructureBuffers m_tlasBuffers;
+    // Instance descs the TLAS build of each frame in flight reads (upload heap), written by updateConstantBuffers
+    ComPtr<ID3D12Resource> m_tlasInstanceDescs[SwapChain::kBackBufferCount];
+    size_t m_tracedLod = 0; // BLAS the TLAS instance references, picked per frame by screen-space error
+    bool m_tlasRebuild = false; // The instance switched BLAS: rebuild the TLAS instead of refitting it
     bool m_rayTracingSupported = false;
 
     ComPtr<ID3D12RootSignature> m_rootSignature;
+    ComPtr<ID3D12RootSignature> m_localRootSignature; // DXRGeometryConstants of the primary hit group
     ComPtr<ID3D12StateObject> m_stateObject;
     ComPtr<ID3D12Resource> m_outputTexture;
     D3D12_CPU_DESCRIPTOR_HANDLE m_outputUavCpuHandle = {}; // CPU Handle for UAV creation
     D3D12_GPU_DESCRIPTOR_HANDLE m_outputUavGpuHandle = {}; // GPU Handle for binding UAV
     ComPtr<ID3D12Resource> m_shaderBindingTable;
     UINT m_sbtEntrySize = 0;
+    UINT m_sbtHitGroupCount = 0; // LOD count x submesh count x 2 ray types
+    UINT m_sbtSubmeshCount = 1; // Hit records per ray type and LOD, the TLAS instance offset stride
+    VertexFormat m_stateObjectVertexFormat; // Vertex format the hit shaders were compiled for
+    std::unique_ptr<Buffer> m_blasTransform; // Dequantization 3x4 for snorm16 positions (upload heap)
+    D3D12_CPU_DESCRIPTOR_HANDLE m_meshVertexBufferSrvHandleCPU = {}; // Allocated for each mesh, see retire()
+    D3D12_CPU_DESCRIPTOR_HANDLE m_meshIndexBufferSrvHandleCPU = {};
+    D3D12_CPU_DESCRIPTOR_HANDLE m_meshPositionBufferSrvHandleCPU = {}; // Raw view of the positions (t4)
+    D3D12_GPU_DESCRIPTOR_HANDLE m_meshPositionBufferSrvHandleGPU = {};
 
     bool checkRayTracingSupport();
 
@@ -42,14 +81,21 @@ private:
 
     bool createRootSignature();
 
-    bool createStateObject(const std::wstring& shaderPath);
+    // The new state object replaces the current one only once it has been created; the current one is retired
+    bool createStateObject(const std::wstring& shaderPath, const VertexFormat& vertexFormat);
 
-    bool buildShaderBindingTable();
+    // Hit groups are laid out per LOD, then per submesh (the BLAS geometry index), then per ray type.
+    // Without a mesh there is a single default record pair.
+    bool buildShaderBindingTable(const Mesh* mesh);
 
-    bool buildBLAS(Mesh* mesh, ID3D12GraphicsCommandList5* commandList);
+    bool buildBLAS(Mesh* mesh, size_t lod, ID3D12GraphicsCommandList5* commandList);
 
+    // Refits the TLAS in place, or rebuilds it into the same result buffer when the instance switched BLAS.
+    // A buffer that has to grow is retired, never released while the frames in flight still trace it.
     bool buildTLAS(ID3D12GraphicsCommandList5* commandList);
 
+    bool acquireBuildContext(BuildContext& context);
+
     bool createMeshBufferSRVs(Mesh* mesh);
 
     void updateConstantBuffers(float deltaTime, Camera* camera, Mesh* mesh);
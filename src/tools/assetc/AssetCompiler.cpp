@@ -0,0 +1,198 @@
+#include "AssetCompiler.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+
+#include "asset/TextureContainer.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    std::string getLowerExtension(const std::string& path) {
+        std::string extension = std::filesystem::path(path).extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return extension;
+    }
+
+    std::string normalizePath(const std::string& path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    // Diffuse and normal maps of the mesh's materials; their paths are relative to the OBJ file
+    std::vector<std::string> getMaterialTextures(const std::string& source, const MeshView& mesh) {
+        const std::filesystem::path directory = std::filesystem::path(source).parent_path();
+        std::vector<std::string> textures;
+        for (size_t i = 0; i < mesh.materialCount; ++i) {
+            for (uint32_t offset : {mesh.materials[i].diffuseTextureOffset, mesh.materials[i].normalTextureOffset}) {
+                if (offset != 0 && offset < mesh.materialStringsSize) {
+                    textures.push_back(normalizePath((directory / (mesh.materialStrings + offset)).string()));
+                }
+            }
+        }
+        return textures;
+    }
+
+    void createOutputDirectory(const std::string& output) {
+        const std::filesystem::path directory = std::filesystem::path(output).parent_path();
+        std::error_code ec;
+        if (!directory.empty()) {
+            std::filesystem::create_directories(directory, ec);
+        }
+    }
+}
+
+AssetCompiler::AssetCompiler(const AssetCompilerOptions& options) : m_options(options) {
+    // The outputs are the cache: never read from or write to a derived-data cache as well
+    m_options.mesh.useCache = false;
+    m_options.mesh.derivedDataCache = nullptr;
+    m_options.texture.useCache = false;
+    m_options.texture.derivedDataCache = nullptr;
+}
+
+bool AssetCompiler::addSource(const std::string& path) {
+    const std::string extension = getLowerExtension(path);
+    if (extension == ".obj") {
+        addNode(AssetType::Mesh, path);
+        return true;
+    }
+    if (extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" ||
+        extension == ".bmp" || isTextureContainerFile(path)) {
+        addNode(AssetType::Texture, path);
+        return true;
+    }
+    return false;
+}
+
+bool AssetCompiler::build(JobSystem* jobSystem) {
+    bool ok = true;
+    size_t waveBegin = 0;
+    while (waveBegin < m_nodes.size()) {
+        const size_t waveEnd = m_nodes.size();
+        parallelFor(jobSystem, waveEnd - waveBegin, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                buildNode(m_nodes[waveBegin + i], jobSystem);
+            }
+        });
+
+        // Edges are added serially, so a texture shared by several meshes becomes a single node
+        for (size_t i = waveBegin; i < waveEnd; ++i) {
+            ok = ok && m_nodes[i].status != AssetStatus::Failed;
+            if (!m_options.followMaterials) {
+                continue;
+            }
+            for (size_t r = 0; r < m_nodes[i].referencedTextures.size(); ++r) {
+                const size_t reference = addNode(AssetType::Texture, m_nodes[i].referencedTextures[r]);
+                m_nodes[i].references.push_back(reference);
+            }
+        }
+        waveBegin = waveEnd;
+    }
+    return ok;
+}
+
+size_t AssetCompiler::addNode(AssetType type, const std::string& source) {
+    const std::string normalized = normalizePath(source);
+    auto it = m_nodeBySource.find(normalized);
+    if (it != m_nodeBySource.end()) {
+        return it->second;
+    }
+    AssetNode node;
+    node.type = type;
+    node.source = normalized;
+    // DDS and KTX2 textures are loaded as they are, so they are their own output
+    node.output = type == AssetType::Texture && isTextureContainerFile(normalized)
+                      ? normalized
+                      : getOutputPath(normalized, type == AssetType::Mesh ? ".meshcache" : ".texcache");
+    m_nodes.push_back(std::move(node));
+    m_nodeBySource[normalized] = m_nodes.size() - 1;
+    return m_nodes.size() - 1;
+}
+
+std::string AssetCompiler::getOutputPath(const std::string& source, const char* extension) const {
+    if (m_options.outputDirectory.empty()) {
+        return source + extension;
+    }
+    std::filesystem::path relative = std::filesystem::path(source).lexically_relative(m_options.sourceRoot);
+    if (relative.empty() || *relative.begin() == "..") {
+        relative = std::filesystem::path(source).filename(); // Outside the root: flattened
+    }
+    return normalizePath((std::filesystem::path(m_options.outputDirectory) / relative).string() + extension);
+}
+
+void AssetCompiler::buildNode(AssetNode& node, JobSystem* jobSystem) const {
+    const auto start = std::chrono::steady_clock::now();
+    try {
+        if (node.type == AssetType::Mesh) {
+            buildMesh(node, jobSystem);
+        } else {
+            buildTexture(node, jobSystem);
+        }
+    } catch (const std::exception& e) {
+        node.status = AssetStatus::Failed;
+        node.error = e.what();
+    }
+    node.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void AssetCompiler::buildMesh(AssetNode& node, JobSystem* jobSystem) const {
+    MeshImportOptions options = m_options.mesh;
+    options.jobSystem = jobSystem; // Nested: the per-submesh passes of a large mesh spread over the workers
+    const uint64_t optionsHash = hashImportOptions(options);
+
+    // Up to date when the stamps of the source and its material libraries still match
+    MeshCacheFile existing;
+    if (!m_options.force && existing.open(node.output) && existing.matchesSource(node.source, optionsHash)) {
+        node.referencedTextures = getMaterialTextures(node.source, existing.getView());
+        node.status = AssetStatus::UpToDate;
+        return;
+    }
+    existing.close();
+
+    createOutputDirectory(node.output);
+    SourceStamp stamp;
+    if (options.streaming) {
+        // Streamed meshes carry no materials, so there is nothing to follow
+        if (!querySourceStamp(node.source, stamp, false) ||
+            !writeStreamedMeshCache(node.source, node.output, options, stamp, optionsHash)) {
+            throw std::runtime_error("Failed to write " + node.output);
+        }
+    } else {
+        ImportedMesh imported;
+        importMesh(node.source, options, imported);
+        if (!querySourceStamp(node.source, stamp, true) ||
+            !writeMeshCache(node.output, imported.view, stamp, optionsHash, imported.data.dependencies,
+                            options.compressStreams)) {
+            throw std::runtime_error("Failed to write " + node.output);
+        }
+        node.referencedTextures = getMaterialTextures(node.source, imported.view);
+    }
+    node.status = AssetStatus::Built;
+}
+
+void AssetCompiler::buildTexture(AssetNode& node, JobSystem* jobSystem) const {
+    if (isTextureContainerFile(node.source)) {
+        loadTextureContainer(node.source); // Only checks that the runtime can read it
+        node.status = AssetStatus::UpToDate;
+        return;
+    }
+    TextureImportOptions options = m_options.texture;
+    options.jobSystem = jobSystem; // Nested, like the mesh passes: the rows of each mip level run in parallel
+    const uint64_t optionsHash = hashTextureImportOptions(options);
+    TextureCacheHeader header = {};
+    if (!m_options.force && readTextureCacheHeader(node.output, header) &&
+        textureCacheMatchesSource(header, node.source, optionsHash)) {
+        node.status = AssetStatus::UpToDate;
+        return;
+    }
+
+    const TextureImage image = importTextureFile(node.source, options);
+    createOutputDirectory(node.output);
+    SourceStamp stamp;
+    if (!querySourceStamp(node.source, stamp, true) || !writeTextureCache(node.output, image, stamp, optionsHash)) {
+        throw std::runtime_error("Failed to write " + node.output);
+    }
+    node.status = AssetStatus::Built;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "asset/MeshImport.hpp"
+#include "asset/TextureImport.hpp"
+
+class JobSystem;
+
+// Offline build of runtime-ready assets: meshes become ".meshcache" and textures ".texcache" files, the
+// formats (and source stamps) the runtime loaders already accept, so a prebuilt file next to its source is
+// mapped at startup instead of importing the source.
+struct AssetCompilerOptions {
+    std::string outputDirectory; // Empty: next to each source, where loadMesh/loadTexture look for caches
+    std::string sourceRoot = "."; // With an output directory, outputs mirror the source paths relative to this
+    MeshImportOptions mesh; // Must match the runtime's options, otherwise the runtime rebuilds the mesh
+    TextureImportOptions texture;
+    bool force = false; // Rebuild outputs that are up to date
+    bool followMaterials = true; // Also build the textures referenced by the meshes' materials
+};
+
+enum class AssetType {
+    Mesh,
+    Texture,
+};
+
+enum class AssetStatus {
+    Pending,
+    UpToDate,
+    Built,
+    Failed,
+};
+
+// One node of the build graph: a source, the output built from it and the nodes it references
+struct AssetNode {
+    AssetType type;
+    std::string source;
+    std::string output;
+    AssetStatus status = AssetStatus::Pending;
+    std::string error; // Set when the build failed
+    double milliseconds = 0.0;
+    std::vector<std::string> referencedTextures; // Material textures of a mesh, as paths
+    std::vector<size_t> references; // Node indices of referencedTextures, filled once they are added
+};
+
+class AssetCompiler {
+public:
+    explicit AssetCompiler(const AssetCompilerOptions& options);
+
+    // Adds a source by its extension: ".obj" meshes and ".png", ".jpg", ".jpeg", ".tga", ".bmp" textures, plus
+    // prebuilt ".dds" and ".ktx2" textures, which are only checked. Returns false for other files. Adding the
+    // same source twice adds one node.
+    bool addSource(const std::string& path);
+
+    // Builds the graph wave by wave: the nodes of a wave are independent and run in parallel on the job
+    // system (serially without one), and textures found in the meshes' materials form the next wave.
+    // Outputs whose stamps still match their inputs are skipped. Returns false if any node failed.
+    bool build(JobSystem* jobSystem);
+
+    const std::vector<AssetNode>& getNodes() const {
+        return m_nodes;
+    }
+
+private:
+    size_t addNode(AssetType type, const std::string& source);
+
+    std::string getOutputPath(const std::string& source, const char* extension) const;
+
+    void buildNode(AssetNode& node, JobSystem* jobSystem) const;
+
+    void buildMesh(AssetNode& node, JobSystem* jobSystem) const;
+
+    void buildTexture(AssetNode& node, JobSystem* jobSystem) const;
+
+    AssetCompilerOptions m_options;
+    std::vector<AssetNode> m_nodes;
+    std::unordered_map<std::string, size_t> m_nodeBySource; // Normalized source path -> node index
+};
@@ -0,0 +1,417 @@
+#include "Benchmarks.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "TestMeshes.hpp"
+#include "asset/DerivedDataCache.hpp"
+#include "asset/MeshCache.hpp"
+#include "asset/MeshImport.hpp"
+#include "asset/ObjParser.hpp"
+#include "asset/VertexWelder.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    struct BenchmarkOptions {
+        std::string source; // Generated when empty
+        int runs = 3;
+        unsigned threadCount = std::max(1u, std::thread::hardware_concurrency());
+        uint32_t gridSize = 0; // Of the generated mesh, 0 for the benchmark's default
+    };
+
+    // The mesh to measure: the one given, or a generated one in the temporary directory
+    std::string getBenchmarkSource(const BenchmarkOptions& options) {
+        if (!options.source.empty()) {
+            return options.source;
+        }
+        // Four groups of gridSize x gridSize vertices
+        const uint32_t gridSize = options.gridSize ? options.gridSize : 256;
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "assetc-bench";
+        std::filesystem::create_directories(directory);
+        const std::string path = (directory / ("grid" + std::to_string(gridSize) + ".obj")).string();
+        TestObjOptions objOptions;
+        objOptions.gridSize = gridSize;
+        objOptions.groupCount = 4;
+        objOptions.materialCount = 2;
+        if (!writeTestObj(path, objOptions)) {
+            throw std::runtime_error("Cannot write " + path);
+        }
+        return path;
+    }
+
+    // The runtime's mesh options (see the assetc usage)
+    MeshImportOptions getRuntimeOptions() {
+        MeshImportOptions options;
+        options.vertexFormat = kCompactVertexFormat;
+        options.vertexFormat.splitPositions = true;
+        return options;
+    }
+
+    // Copies the vertex and index streams of a decoded view into one upload-like buffer; returns milliseconds
+    double stageMesh(const MeshView& view, std::vector<uint8_t>& staging) {
+        const VertexLayout layout = getVertexLayout(view.vertexFormat);
+        const size_t sizes[] = {view.vertexCount * layout.stride, view.vertexCount * layout.positionStride,
+                                view.indexCount * view.indexSize, view.lodIndexCount * view.indexSize};
+        const void* streams[] = {view.vertices, view.positions, view.indices, view.lodIndices};
+        staging.resize(sizes[0] + sizes[1] + sizes[2] + sizes[3]);
+        const auto start = std::chrono::steady_clock::now();
+        size_t offset = 0;
+        for (size_t i = 0; i < 4; ++i) {
+            if (streams[i]) {
+                memcpy(staging.data() + offset, streams[i], sizes[i]);
+            }
+            offset += sizes[i];
+        }
+        return millisecondsSince(start);
+    }
+
+    // Cold import of the OBJ against the memory-mapped cache, raw and MeshCodec-compressed. Both read files
+    // that sit in the page cache after the first run; a cold disk adds its read time to each.
+    int benchmarkCache(const BenchmarkOptions& benchmarkOptions) {
+        const std::string source = getBenchmarkSource(benchmarkOptions);
+        JobSystem jobSystem(benchmarkOptions.threadCount - 1);
+        MeshImportOptions options = getRuntimeOptions();
+        options.jobSystem = &jobSystem;
+        const uint64_t optionsHash = hashImportOptions(options);
+
+        double importBest = 1e30;
+        std::unique_ptr<ImportedMesh> imported;
+        for (int run = 0; run < benchmarkOptions.runs; ++run) {
+            imported = std::make_unique<ImportedMesh>();
+            QuietImport quiet;
+            const auto start = std::chrono::steady_clock::now();
+            importMesh(source, options, *imported);
+            importBest = std::min(importBest, millisecondsSince(start));
+        }
+        SourceStamp stamp;
+        if (!querySourceStamp(source, stamp, true)) {
+            std::cerr << "Cannot read " << source << std::endl;
+            return 1;
+        }
+        printf("%s: %zu vertices, %zu triangles, %.1f MiB OBJ, %u threads\n", source.c_str(),
+               imported->view.vertexCount, imported->view.indexCount / 3, stamp.size / double(1 << 20),
+               jobSystem.getThreadCount());
+        printf("  cold OBJ import     %9.2f ms\n", importBest);
+
+        const std::string cache = source + ".bench.meshcache";
+        for (bool compressed : {false, true}) {
+            if (!writeMeshCache(cache, imported->view, stamp, optionsHash, imported->data.dependencies, compressed)) {
+                std::cerr << "Cannot write " << cache << std::endl;
+                return 1;
+            }
+            // What loadMesh does for a valid cache, then what the upload does: decode compressed streams and
+            // copy the vertices and indices out of the mapping (which pages them in)
+            double mapBest = 1e30;
+            double stageBest = 1e30;
+            std::vector<uint8_t> staging;
+            for (int run = 0; run < benchmarkOptions.runs; ++run) {
+                const auto start = std::chrono::steady_clock::now();
+                MeshCacheFile file;
+                if (!file.open(cache) || !file.matchesSource(source, optionsHash)) {
+                    std::cerr << "Cannot use " << cache << std::endl;
+                    return 1;
+                }
+                MeshView view = file.getView();
+                mapBest = std::min(mapBest, millisecondsSince(start));
+                const auto stageStart = std::chrono::steady_clock::now();
+                DecodedMeshStreams streams;
+                decodeMeshStreams(view, streams);
+                const double decode = millisecondsSince(stageStart);
+                stageBest = std::min(stageBest, decode + stageMesh(view, staging));
+            }
+            const double total = mapBest + stageBest;
+            printf("  %-19s %9.2f ms  (map %.2f ms + decode/copy %.2f ms, %.1f MiB)  %7.1fx\n",
+                   compressed ? "compressed cache" : "raw cache", total, mapBest, stageBest,
+                   std::filesystem::file_size(cache) / double(1 << 20), importBest / total);
+        }
+        std::error_code ec;
+        std::filesystem::remove(cache, ec);
+        return 0;
+    }
+
+    // loadMesh through the derived-data cache, as on a first start (import, then write the entry into an empty
+    // cache) and on later ones (hash the source, map the entry and check it), each until the mesh is ready to
+    // be uploaded
+    int benchmarkDerivedData(const BenchmarkOptions& benchmarkOptions) {
+        const std::string source = getBenchmarkSource(benchmarkOptions);
+        if (std::filesystem::exists(source + ".meshcache")) {
+            std::cerr << source << ".meshcache is used before the derived-data cache; remove it first" << std::endl;
+            return 1;
+        }
+        JobSystem jobSystem(benchmarkOptions.threadCount - 1);
+        MeshImportOptions options = getRuntimeOptions();
+        options.jobSystem = &jobSystem;
+        const std::string directory =
+            (std::filesystem::temp_directory_path() / "assetc-bench" / "derived-data").string();
+        const uint64_t maxSize = uint64_t(1) << 40;
+        std::error_code ec;
+
+        double coldBest = 1e30;
+        size_t entrySize = 0;
+        for (int run = 0; run < benchmarkOptions.runs; ++run) {
+            std::filesystem::remove_all(directory, ec);
+            DerivedDataCache derivedData;
+            if (!derivedData.open(directory, maxSize)) {
+                std::cerr << "Cannot open " << directory << std::endl;
+                return 1;
+            }
+            options.derivedDataCache = &derivedData;
+            ImportedMesh mesh;
+            QuietImport quiet;
+            const auto start = std::chrono::steady_clock::now();
+            loadMesh(source, options, mesh);
+            coldBest = std::min(coldBest, millisecondsSince(start));
+            entrySize = derivedData.getTotalSize();
+            if (mesh.fromCache || derivedData.getEntryCount() != 1) {
+                std::cerr << "Cold load did not write one entry" << std::endl;
+                return 1;
+            }
+        }
+
+        DerivedDataCache derivedData;
+        if (!derivedData.open(directory, maxSize)) {
+            std::cerr << "Cannot open " << directory << std::endl;
+            return 1;
+        }
+        options.derivedDataCache = &derivedData;
+        double warmBest = 1e30;
+        double stageBest = 1e30;
+        double hashBest = 1e30;
+        size_t vertexCount = 0;
+        size_t indexCount = 0;
+        std::vector<uint8_t> staging;
+        for (int run = 0; run < benchmarkOptions.runs; ++run) {
+            ImportedMesh mesh;
+            auto start = std::chrono::steady_clock::now();
+            loadMesh(source, options, mesh);
+            warmBest = std::min(warmBest, millisecondsSince(start));
+            if (!mesh.fromCache) {
+                std::cerr << "Warm load did not hit the entry" << std::endl;
+                return 1;
+            }
+            MeshView view = mesh.view;
+            start = std::chrono::steady_clock::now();
+            DecodedMeshStreams streams;
+            decodeMeshStreams(view, streams);
+            const double decode = millisecondsSince(start);
+            stageBest = std::min(stageBest, decode + stageMesh(view, staging));
+            vertexCount = view.vertexCount;
+            indexCount = view.indexCount;
+
+            // The part of the lookup that reads the whole source
+            SourceStamp stamp;
+            start = std::chrono::steady_clock::now();
+            querySourceStamp(source, stamp, true);
+            hashBest = std::min(hashBest, millisecondsSince(start));
+        }
+        std::filesystem::remove_all(directory, ec);
+
+        printf("%s: %zu vertices, %zu triangles, %.1f MiB OBJ, %.1f MiB entry, %u threads\n", source.c_str(),
+               vertexCount, indexCount / 3, std::filesystem::file_size(source) / double(1 << 20),
+               entrySize / double(1 << 20), jobSystem.getThreadCount());
+        printf("  cold: import, write entry %9.2f ms\n", coldBest);
+        const double warm = warmBest + stageBest;
+        printf("  warm: map entry           %9.2f ms  (lookup %.2f ms + decode/copy %.2f ms; source hash alone %.2f ms)"
+               "  %7.1fx\n", warm, warmBest, stageBest, hashBest, coldBest / warm);
+        return 0;
+    }
+
+    // The chunked OBJ parse alone at 1..n threads, as jobs
+    int benchmarkParse(const BenchmarkOptions& benchmarkOptions) {
+        const std::string source = getBenchmarkSource(benchmarkOptions);
+        const double megabytes = std::filesystem::file_size(source) / 1e6;
+        printf("%s: %.1f MB\n", source.c_str(), megabytes);
+        double singleThreaded = 0.0;
+        for (unsigned threadCount = 1; threadCount <= benchmarkOptions.threadCount; ++threadCount) {
+            JobSystem jobSystem(threadCount - 1);
+            ObjParseOptions options;
+            options.jobSystem = &jobSystem;
+            double best = 1e30;
+            size_t triangleCount = 0;
+            for (int run = 0; run < benchmarkOptions.runs; ++run) {
+                ObjData data;
+                const auto start = std::chrono::steady_clock::now();
+                parseObjFile(source, data, options);
+                best = std::min(best, millisecondsSince(start));
+                triangleCount = data.corners.size() / 3;
+            }
+            if (threadCount == 1) {
+                singleThreaded = best;
+            }
+            printf("  %2u threads: %9.1f ms  %7.1f MB/s  %5.2fx  (%zu triangles)\n", threadCount, best,
+                   megabytes / (best * 1e-3), singleThreaded / best, triangleCount);
+        }
+        return 0;
+    }
+
+    // Corner keys to deduplicate: the (v, vt, vn) triples of the OBJ, or of a generated grid mesh whose
+    // vertices are shared by six corners each (two triangles per cell), like a smooth OBJ surface
+    std::vector<VertexKey> getCornerKeys(const BenchmarkOptions& options) {
+        std::vector<VertexKey> keys;
+        if (!options.source.empty()) {
+            ObjData data;
+            parseObjFile(options.source, data);
+            keys.reserve(data.corners.size());
+            for (const ObjIndex& corner : data.corners) {
+                keys.push_back({corner.position, corner.texCoord, corner.normal});
+            }
+            return keys;
+        }
+        const int32_t n = static_cast<int32_t>(options.gridSize ? options.gridSize : 1024);
+        keys.reserve(size_t(n - 1) * size_t(n - 1) * 6);
+        for (int32_t y = 0; y + 1 < n; ++y) {
+            for (int32_t x = 0; x + 1 < n; ++x) {
+                const int32_t a = y * n + x;
+                for (int32_t vertex : {a, a + n, a + n + 1, a, a + n + 1, a + 1}) {
+                    keys.push_back({vertex, vertex, vertex});
+                }
+            }
+        }
+        return keys;
+    }
+
+    // Deduplicates the corners as importObjFile does; returns the best-of-n milliseconds
+    double timeDedup(const std::vector<VertexKey>& keys, size_t expectedKeys, int runs,
+                     VertexIndexTable::ProbeStats& outStats, size_t& outCapacity) {
+        double best = 1e30;
+        for (int run = 0; run < runs; ++run) {
+            const auto start = std::chrono::steady_clock::now();
+            VertexIndexTable table(expectedKeys);
+            for (const VertexKey& key : keys) {
+                bool inserted;
+                table.findOrInsert(key, static_cast<uint32_t>(table.size()), inserted);
+            }
+            best = std::min(best, millisecondsSince(start));
+            outStats = table.getProbeStats();
+            outCapacity = table.capacity();
+        }
+        return best;
+    }
+
+    // VertexIndexTable on a multi-million-corner dedup: presized as the importer does, presized for the unique
+    // keys, grown from empty, and probe lengths at the presized load (1/2) and at the rehash point (3/4)
+    int benchmarkWeld(const BenchmarkOptions& options) {
+        const std::vector<VertexKey> keys = getCornerKeys(options);
+        std::vector<VertexKey> uniqueKeys;
+        {
+            VertexIndexTable table(keys.size());
+            for (const VertexKey& key : keys) {
+                bool inserted;
+                table.findOrInsert(key, static_cast<uint32_t>(table.size()), inserted);
+                if (inserted) {
+                    uniqueKeys.push_back(key);
+                }
+            }
+        }
+        printf("%zu corners, %zu unique keys\n", keys.size(), uniqueKeys.size());
+        const struct {
+            const char* name;
+            size_t expectedKeys;
+        } presizes[] = {
+            {"presized from corners", keys.size()},
+            {"presized 2x unique", uniqueKeys.size()},
+            {"grown from empty", 0},
+        };
+        for (const auto& presize : presizes) {
+            VertexIndexTable::ProbeStats stats;
+            size_t capacity = 0;
+            const double milliseconds = timeDedup(keys, presize.expectedKeys, options.runs, stats, capacity);
+            printf("  %-22s %9.1f ms  %5.1f ns/corner  capacity %9zu  load %.2f  probes avg %.2f max %zu\n",
+                   presize.name, milliseconds, milliseconds * 1e6 / double(keys.size()), capacity,
+                   double(uniqueKeys.size()) / double(capacity), stats.averageLength, stats.maxLength);
+        }
+
+        // One table of fixed capacity filled with distinct keys up to half, then up to just below the 3/4 load
+        // where findOrInsert would rehash
+        size_t capacity = 16;
+        while (capacity * 2 * 3 / 4 <= uniqueKeys.size()) {
+            capacity *= 2;
+        }
+        if (capacity * 3 / 4 > uniqueKeys.size()) {
+            return 0;
+        }
+        VertexIndexTable table(capacity / 2);
+        size_t inserted = 0;
+        for (const auto& [name, fill] : {std::pair("1/2 (2x presize)", capacity / 2),
+                                         std::pair("3/4 (rehash point)", capacity * 3 / 4 - 1)}) {
+            const size_t first = inserted;
+            const auto start = std::chrono::steady_clock::now();
+            for (; inserted < fill; ++inserted) {
+                bool isNew;
+                table.findOrInsert(uniqueKeys[inserted], static_cast<uint32_t>(inserted), isNew);
+            }
+            const double insertNanoseconds = millisecondsSince(start) * 1e6 / double(fill - first);
+            const auto lookupStart = std::chrono::steady_clock::now();
+            uint64_t found = 0;
+            for (size_t i = 0; i < fill; ++i) {
+                found += table.find(uniqueKeys[i]);
+            }
+            const double lookupNanoseconds = millisecondsSince(lookupStart) * 1e6 / double(fill);
+            const VertexIndexTable::ProbeStats stats = table.getProbeStats();
+            printf("  filled to %-19s capacity %9zu  probes avg %.2f max %3zu  insert %5.1f ns  find %5.1f ns%s\n",
+                   name, table.capacity(), stats.averageLength, stats.maxLength, insertNanoseconds,
+                   lookupNanoseconds, found == uint64_t(fill) * (fill - 1) / 2 ? "" : "  (lookup mismatch)");
+        }
+        return 0;
+    }
+
+    struct Benchmark {
+        const char* name;
+        int (*run)(const BenchmarkOptions& options);
+    };
+
+    const Benchmark kBenchmarks[] = {
+        {"cache", benchmarkCache},
+        {"ddc", benchmarkDerivedData},
+        {"parse", benchmarkParse},
+        {"weld", benchmarkWeld},
+    };
+}
+
+int runBenchmark(int argc, char** argv) {
+    const Benchmark* benchmark = nullptr;
+    for (const Benchmark& candidate : kBenchmarks) {
+        benchmark = strcmp(argv[2], candidate.name) == 0 ? &candidate : benchmark;
+    }
+    if (!benchmark) {
+        std::cerr << "Unknown benchmark: " << argv[2] << std::endl;
+        return 2;
+    }
+    BenchmarkOptions options;
+    for (int i = 3; i < argc; ++i) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--runs") == 0 && hasValue) {
+            options.runs = std::max(1, atoi(argv[++i]));
+        } else if ((strcmp(argv[i], "-j") == 0 || strcmp(argv[i], "--threads") == 0) && hasValue) {
+            options.threadCount = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+        } else if (strcmp(argv[i], "--grid") == 0 && hasValue) {
+            options.gridSize = static_cast<uint32_t>(std::max(2, atoi(argv[++i])));
+        } else if (argv[i][0] != '-' && options.source.empty()) {
+            options.source = argv[i];
+        } else {
+            std::cerr << "Unknown benchmark option: " << argv[i] << std::endl;
+            return 2;
+        }
+    }
+    try {
+        return benchmark->run(options);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+}
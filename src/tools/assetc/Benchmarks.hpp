@@ -0,0 +1,5 @@
+#pragma once
+
+// "assetc bench <name> [<mesh.obj>] [options]": argv[2] names the benchmark. Without a mesh, a generated
+// one is used. Returns the process exit code.
+int runBenchmark(int argc, char** argv);
@@ -0,0 +1,1776 @@
+#include "Checks.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "TestMeshes.hpp"
+#include "asset/DerivedDataCache.hpp"
+#include "asset/MeshCache.hpp"
+#include "asset/MeshImport.hpp"
+#include "asset/MeshOptimizer.hpp"
+#include "asset/MeshSimplifier.hpp"
+#include "asset/Meshlet.hpp"
+#include "asset/ObjParser.hpp"
+#include "asset/ShortIndices.hpp"
+#include "asset/SubmeshDraw.hpp"
+#include "asset/VertexFormat.hpp"
+#include "core/JobSystem.hpp"
+
+#ifdef __linux__
+#include <malloc.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    struct CheckContext {
+        std::filesystem::path directory;
+        int failures = 0;
+
+        void expect(bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        }
+
+        std::string path(const char* name) const {
+            return (directory / name).string();
+        }
+    };
+
+    bool sameBytes(const void* a, const void* b, size_t size) {
+        return size == 0 || (a && b && memcmp(a, b, size) == 0);
+    }
+
+    // Name of the first section of the decoded views that differs, empty when they are equal
+    std::string compareMeshViews(const MeshView& a, const MeshView& b) {
+        const VertexLayout layout = getVertexLayout(a.vertexFormat);
+        if (!(a.vertexFormat == b.vertexFormat) || a.vertexCount != b.vertexCount ||
+            !sameBytes(&a.quantization, &b.quantization, sizeof(VertexQuantization))) {
+            return "vertex format";
+        }
+        if (!sameBytes(a.vertices, b.vertices, a.vertexCount * layout.stride)) {
+            return "vertices";
+        }
+        if (!sameBytes(a.positions, b.positions, a.vertexCount * layout.positionStride)) {
+            return "positions";
+        }
+        if (a.indexCount != b.indexCount || a.indexSize != b.indexSize ||
+            !sameBytes(a.indices, b.indices, a.indexCount * a.indexSize)) {
+            return "indices";
+        }
+        if (a.meshletCount != b.meshletCount || a.meshletVertexCount != b.meshletVertexCount ||
+            !sameBytes(a.meshlets, b.meshlets, a.meshletCount * sizeof(Meshlet)) ||
+            !sameBytes(a.meshletBounds, b.meshletBounds, a.meshletCount * sizeof(MeshletBounds)) ||
+            !sameBytes(a.meshletVertices, b.meshletVertices, a.meshletVertexCount * sizeof(uint32_t)) ||
+            !sameBytes(a.meshletTriangles, b.meshletTriangles, a.meshletCount ? a.indexCount : 0)) {
+            return "meshlets";
+        }
+        if (a.lodCount != b.lodCount || a.lodIndexCount != b.lodIndexCount ||
+            !sameBytes(a.lods, b.lods, a.lodCount * sizeof(MeshLod)) ||
+            !sameBytes(a.lodIndices, b.lodIndices, a.lodIndexCount * a.indexSize)) {
+            return "LODs";
+        }
+        if (a.submeshCount != b.submeshCount ||
+            !sameBytes(a.submeshes, b.submeshes, a.submeshCount * sizeof(Submesh))) {
+            return "submeshes";
+        }
+        if (a.materialCount != b.materialCount || a.materialStringsSize != b.materialStringsSize ||
+            !sameBytes(a.materials, b.materials, a.materialCount * sizeof(MeshMaterial)) ||
+            !sameBytes(a.materialStrings, b.materialStrings, a.materialStringsSize)) {
+            return "materials";
+        }
+        if (!sameBytes(&a.bounds, &b.bounds, sizeof(MeshBounds))) {
+            return "bounds";
+        }
+        return {};
+    }
+
+    bool copyTruncated(const std::string& from, const std::string& to, uint64_t size) {
+        std::error_code ec;
+        std::filesystem::copy_file(from, to, std::filesystem::copy_options::overwrite_existing, ec);
+        if (!ec) {
+            std::filesystem::resize_file(to, size, ec);
+        }
+        return !ec;
+    }
+
+    // Overwrites size bytes at offset
+    bool patchFile(const std::string& path, uint64_t offset, const void* data, size_t size) {
+        FILE* file = fopen(path.c_str(), "r+b");
+        if (!file) {
+            return false;
+        }
+        const bool ok = fseek(file, static_cast<long>(offset), SEEK_SET) == 0 && fwrite(data, 1, size, file) == size;
+        return (fclose(file) == 0) && ok;
+    }
+
+    void setWriteTime(const std::string& path, std::chrono::seconds change) {
+        std::error_code ec;
+        std::filesystem::last_write_time(path, std::filesystem::last_write_time(path, ec) + change, ec);
+    }
+
+    // Write a cache, map it again and compare every section; then the paths that must reject it
+    void checkMeshCache(CheckContext& context) {
+        const std::string source = context.path("cache.obj");
+        const std::string cache = context.path("cache.obj.meshcache");
+        TestObjOptions objOptions;
+        objOptions.gridSize = 40;
+        objOptions.groupCount = 5;
+        objOptions.materialCount = 3;
+        context.expect(writeTestObj(source, objOptions), "cannot write " + source);
+
+        struct Variant {
+            const char* name;
+            VertexFormat format;
+            bool splitPositions;
+            bool shortIndices;
+            bool compressStreams;
+        };
+        const Variant variants[] = {
+            {"float vertices", VertexFormat{}, false, true, false},
+            {"float vertices, compressed", VertexFormat{}, false, true, true},
+            {"compact split vertices, 32-bit indices", kCompactVertexFormat, true, false, false},
+            {"compact split vertices, compressed", kCompactVertexFormat, true, true, true},
+        };
+        for (const Variant& variant : variants) {
+            MeshImportOptions options;
+            options.vertexFormat = variant.format;
+            options.vertexFormat.splitPositions = variant.splitPositions;
+            options.shortIndices = variant.shortIndices;
+            const uint64_t optionsHash = hashImportOptions(options);
+            const std::string what = std::string(variant.name) + ": ";
+
+            ImportedMesh imported;
+            SourceStamp stamp;
+            {
+                QuietImport quiet;
+                importMesh(source, options, imported);
+            }
+            context.expect(querySourceStamp(source, stamp, true), what + "cannot stamp the source");
+            context.expect(imported.view.meshletCount > 0 && imported.view.lodCount > 0 &&
+                           imported.view.submeshCount == 5 && imported.view.materialCount == 3,
+                           what + "the import lacks sections to round-trip");
+            context.expect(writeMeshCache(cache, imported.view, stamp, optionsHash, imported.data.dependencies,
+                                          variant.compressStreams), what + "writeMeshCache failed");
+
+            MeshCacheFile file;
+            context.expect(file.open(cache), what + "cannot reopen the cache");
+            MeshView view = file.getView();
+            context.expect((view.compressedVertices.data != nullptr) == variant.compressStreams,
+                           what + "streams not stored as requested");
+            DecodedMeshStreams streams;
+            context.expect(decodeMeshStreams(view, streams), what + "cannot decode the streams");
+            const std::string difference = compareMeshViews(imported.view, view);
+            context.expect(difference.empty(), what + difference + " differ after the round trip");
+
+            context.expect(file.matchesSource(source, optionsHash), what + "fresh cache does not match its source");
+            context.expect(!file.matchesSource(source, optionsHash + 1), what + "matches other options");
+            context.expect(file.matchesContent(stamp.contentHash, optionsHash), what + "does not match by content");
+            context.expect(!file.matchesContent(stamp.contentHash ^ 1, optionsHash), what + "matches other content");
+            context.expect(!file.matchesContent(stamp.contentHash, optionsHash ^ 1),
+                           what + "matches other options by content");
+        }
+
+        // Stamps: a copy (new timestamp, same bytes) still matches through the content hash; edits do not
+        MeshImportOptions options;
+        const uint64_t optionsHash = hashImportOptions(options);
+        {
+            ImportedMesh imported;
+            QuietImport quiet;
+            importMesh(source, options, imported);
+            SourceStamp stamp;
+            querySourceStamp(source, stamp, true);
+            writeMeshCache(cache, imported.view, stamp, optionsHash, imported.data.dependencies, true);
+        }
+        MeshCacheFile file;
+        context.expect(file.open(cache), "cannot reopen the cache");
+        const std::string copy = context.path("cache-copy.obj");
+        std::error_code ec;
+        std::filesystem::copy_file(source, copy, std::filesystem::copy_options::overwrite_existing, ec);
+        setWriteTime(copy, std::chrono::seconds(10));
+        context.expect(file.matchesSource(copy, optionsHash), "touched copy with the same bytes does not match");
+        const char edit = '#';
+        context.expect(patchFile(copy, 0, &edit, 1) && !file.matchesSource(copy, optionsHash),
+                       "edited source of the same size matches");
+        std::filesystem::resize_file(copy, std::filesystem::file_size(source) + 1, ec);
+        context.expect(!file.matchesSource(copy, optionsHash), "grown source matches");
+        context.expect(!file.matchesSource(context.path("missing.obj"), optionsHash), "missing source matches");
+
+        // Sections and header cut short or damaged: open() must reject them before anything is read
+        const uint64_t cacheSize = std::filesystem::file_size(cache);
+        const MeshCacheHeader header = file.getHeader();
+        uint64_t lastSectionEnd = 0;
+        for (MeshCacheSectionType type : {MeshCacheSectionType::VertexFormat, MeshCacheSectionType::Bounds}) {
+            const MeshCacheSection* section = file.findSection(type);
+            context.expect(section != nullptr, "section missing");
+            lastSectionEnd = section ? std::max(lastSectionEnd, section->offset + section->size) : lastSectionEnd;
+        }
+        context.expect(lastSectionEnd == cacheSize, "cache does not end with its last section");
+        const uint64_t tableEnd = sizeof(MeshCacheHeader) + uint64_t(header.sectionCount) * sizeof(MeshCacheSection);
+        const std::string damaged = context.path("damaged.meshcache");
+        for (uint64_t size : {uint64_t(0), uint64_t(sizeof(MeshCacheHeader) - 1), uint64_t(sizeof(MeshCacheHeader)),
+                              tableEnd - 1, tableEnd + 1, cacheSize / 2, cacheSize - 1}) {
+            MeshCacheFile truncated;
+            context.expect(copyTruncated(cache, damaged, size) && !truncated.open(damaged),
+                           "cache truncated to " + std::to_string(size) + " bytes opens");
+        }
+        const uint32_t badVersion = kMeshCacheVersion + 1;
+        const uint32_t badMagic = kMeshCacheMagic ^ 1;
+        const uint64_t badOffset = kMeshCacheSectionAlignment + 1;
+        for (const auto& [offset, value] : {std::pair(offsetof(MeshCacheHeader, version), &badVersion),
+                                            std::pair(offsetof(MeshCacheHeader, magic), &badMagic)}) {
+            MeshCacheFile patched;
+            context.expect(copyTruncated(cache, damaged, cacheSize) && patchFile(damaged, offset, value, 4) &&
+                           !patched.open(damaged), "cache with a bad header opens");
+        }
+        {
+            MeshCacheFile patched;
+            context.expect(copyTruncated(cache, damaged, cacheSize) &&
+                           patchFile(damaged, sizeof(MeshCacheHeader) + offsetof(MeshCacheSection, offset),
+                                     &badOffset, sizeof(badOffset)) && !patched.open(damaged),
+                           "cache with a misaligned section opens");
+        }
+        file.close();
+
+        // loadMesh: imports and writes the cache, then maps it; other options or a changed material library
+        // rebuild it
+        std::filesystem::remove(cache, ec);
+        QuietImport quiet;
+        {
+            ImportedMesh first;
+            loadMesh(source, options, first);
+            ImportedMesh second;
+            loadMesh(source, options, second);
+            MeshView view = second.view;
+            DecodedMeshStreams streams;
+            context.expect(!first.fromCache && second.fromCache, "loadMesh did not reuse the cache it wrote");
+            context.expect(decodeMeshStreams(view, streams) && compareMeshViews(first.view, view).empty(),
+                           "loadMesh from the cache differs from the import");
+        }
+        MeshImportOptions otherOptions = options;
+        otherOptions.lods.pop_back();
+        {
+            ImportedMesh other;
+            loadMesh(source, otherOptions, other);
+            context.expect(!other.fromCache, "loadMesh used a cache built with other options");
+        }
+        setWriteTime(context.path("cache.mtl"), std::chrono::seconds(10));
+        ImportedMesh touched;
+        loadMesh(source, otherOptions, touched);
+        context.expect(!touched.fromCache, "loadMesh used a cache whose material library changed");
+    }
+
+    bool readFile(const std::string& path, std::string& outText) {
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
+            return false;
+        }
+        char buffer[1 << 16];
+        size_t read;
+        outText.clear();
+        while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            outText.append(buffer, read);
+        }
+        const bool ok = !ferror(file);
+        return (fclose(file) == 0) && ok;
+    }
+
+    // Name of the first part of the parse results that differs, empty when they are equal
+    std::string compareObjData(const ObjData& a, const ObjData& b) {
+        if (a.positions != b.positions || a.texCoords != b.texCoords || a.normals != b.normals) {
+            return "attributes";
+        }
+        if (a.corners.size() != b.corners.size() ||
+            !sameBytes(a.corners.data(), b.corners.data(), a.corners.size() * sizeof(ObjIndex))) {
+            return "corners";
+        }
+        if (a.groups.size() != b.groups.size()) {
+            return "group count";
+        }
+        for (size_t i = 0; i < a.groups.size(); ++i) {
+            const ObjGroup& x = a.groups[i];
+            const ObjGroup& y = b.groups[i];
+            if (x.firstCorner != y.firstCorner || x.cornerCount != y.cornerCount || x.name != y.name ||
+                x.material != y.material) {
+                return "group " + std::to_string(i);
+            }
+        }
+        if (a.materialNames != b.materialNames || a.materialLibraries != b.materialLibraries) {
+            return "materials";
+        }
+        return {};
+    }
+
+    // Chunked parses against the single-chunk parse, with chunk boundaries landing between every kind of line:
+    // relative indices into earlier chunks, quads and n-gons, group and material statements
+    void checkObjParser(CheckContext& context) {
+        JobSystem jobSystem(3);
+        for (TestObjFaces faces : {TestObjFaces::Triangles, TestObjFaces::Quads, TestObjFaces::Polygons}) {
+            const std::string what = faces == TestObjFaces::Triangles ? "triangles: "
+                                     : faces == TestObjFaces::Quads ? "quads: " : "polygons: ";
+            std::string absoluteText;
+            std::string relativeText;
+            TestObjOptions objOptions;
+            objOptions.gridSize = 12;
+            objOptions.groupCount = 3;
+            objOptions.materialCount = 2;
+            objOptions.faces = faces;
+            const std::string path = context.path("parse.obj");
+            context.expect(writeTestObj(path, objOptions) && readFile(path, absoluteText), "cannot write " + path);
+            objOptions.negativeIndices = true;
+            context.expect(writeTestObj(path, objOptions) && readFile(path, relativeText), "cannot write " + path);
+
+            ObjParseOptions single;
+            single.threadCount = 1;
+            ObjData reference;
+            parseObj(absoluteText.data(), absoluteText.size(), reference, single);
+            context.expect(reference.groups.size() == 3 && reference.materialNames.size() == 2 &&
+                           reference.corners.size() % 3 == 0 && !reference.corners.empty(),
+                           what + "unexpected reference parse");
+            ObjData relative;
+            parseObj(relativeText.data(), relativeText.size(), relative, single);
+            context.expect(compareObjData(reference, relative).empty(),
+                           what + "negative indices resolve differently from absolute ones");
+
+            // Up to one chunk per line pair, on threads and as jobs
+            for (const std::string* text : {&absoluteText, &relativeText}) {
+                for (unsigned chunkCount = 2; chunkCount <= 96; chunkCount += chunkCount < 24 ? 1 : 9) {
+                    for (JobSystem* jobs : {static_cast<JobSystem*>(nullptr), &jobSystem}) {
+                        ObjParseOptions chunked;
+                        chunked.threadCount = chunkCount;
+                        chunked.jobSystem = jobs;
+                        chunked.minChunkSize = 1;
+                        ObjData data;
+                        parseObj(text->data(), text->size(), data, chunked);
+                        const std::string difference = compareObjData(reference, data);
+                        context.expect(difference.empty(),
+                                       what + std::to_string(chunkCount) + " chunks" + (jobs ? " as jobs" : "") +
+                                       (text == &relativeText ? ", negative indices: " : ": ") + difference +
+                                       " differ from the single-chunk parse");
+                    }
+                }
+            }
+        }
+
+        // A relative index reaching before the first vertex fails however the file is split
+        const std::string invalid = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\nv 1 1 0\nf -1 -2 -5\n";
+        for (unsigned chunkCount = 1; chunkCount <= 6; ++chunkCount) {
+            ObjParseOptions chunked;
+            chunked.threadCount = chunkCount;
+            chunked.minChunkSize = 1;
+            ObjData data;
+            bool threw = false;
+            try {
+                parseObj(invalid.data(), invalid.size(), data, chunked);
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+            context.expect(threw, std::to_string(chunkCount) + " chunks: out-of-range relative index accepted");
+        }
+    }
+
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // Two triangles per cell of an n x n vertex grid, row by row
+    std::vector<uint32_t> makeGridIndices(uint32_t n) {
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y + 1 < n; ++y) {
+            for (uint32_t x = 0; x + 1 < n; ++x) {
+                const uint32_t a = y * n + x;
+                indices.insert(indices.end(), {a, a + n, a + n + 1, a, a + n + 1, a + 1});
+            }
+        }
+        return indices;
+    }
+
+    void shuffleTriangles(std::vector<uint32_t>& indices, uint32_t seed) {
+        for (size_t i = indices.size() / 3; i > 1; --i) {
+            const size_t j = nextRandom(seed) % i;
+            std::swap_ranges(indices.begin() + (i - 1) * 3, indices.begin() + i * 3, indices.begin() + j * 3);
+        }
+    }
+
+    // Triangles as a sorted list, each rotated to start at its smallest index (which keeps the winding)
+    std::vector<uint32_t> canonicalizeTriangles(const uint32_t* indices, size_t indexCount) {
+        std::vector<std::array<uint32_t, 3>> triangles(indexCount / 3);
+        for (size_t t = 0; t < triangles.size(); ++t) {
+            const uint32_t* triangle = indices + t * 3;
+            const size_t first = std::min_element(triangle, triangle + 3) - triangle;
+            triangles[t] = {triangle[first], triangle[(first + 1) % 3], triangle[(first + 2) % 3]};
+        }
+        std::sort(triangles.begin(), triangles.end());
+        std::vector<uint32_t> sorted;
+        for (const std::array<uint32_t, 3>& triangle : triangles) {
+            sorted.insert(sorted.end(), triangle.begin(), triangle.end());
+        }
+        return sorted;
+    }
+
+    // optimizeVertexCache keeps the triangle multiset (and every winding) and never raises the ACMR
+    void checkVertexCache(CheckContext& context) {
+        struct Input {
+            std::string name;
+            std::vector<uint32_t> indices;
+            size_t vertexCount;
+        };
+        std::vector<Input> inputs;
+        inputs.push_back({"grid", makeGridIndices(64), 64 * 64});
+        inputs.push_back({"shuffled grid", makeGridIndices(64), 64 * 64});
+        shuffleTriangles(inputs.back().indices, 7);
+        uint32_t seed = 11;
+        Input soup = {"random soup", {}, 500};
+        for (int i = 0; i < 3000 * 3; ++i) {
+            soup.indices.push_back(nextRandom(seed) % 500);
+        }
+        inputs.push_back(soup);
+        // Degenerate and repeated triangles, and vertices no triangle uses
+        Input degenerate = {"degenerate and repeated", makeGridIndices(16), 16 * 16 + 40};
+        for (uint32_t i = 0; i < 60; ++i) {
+            const uint32_t a = nextRandom(seed) % 256;
+            degenerate.indices.insert(degenerate.indices.end(), {a, a, (a + 1) % 256, 5, 6, 22});
+        }
+        shuffleTriangles(degenerate.indices, 3);
+        inputs.push_back(degenerate);
+        inputs.push_back({"one triangle", {2, 0, 1}, 3});
+        inputs.push_back({"empty", {}, 10});
+
+        for (const Input& input : inputs) {
+            for (unsigned cacheSize : {kDefaultVertexCacheSize, 32u}) {
+                const std::string what = input.name + ", cache " + std::to_string(cacheSize) + ": ";
+                std::vector<uint32_t> optimized(input.indices.size());
+                optimizeVertexCache(optimized.data(), input.indices.data(), input.indices.size(), input.vertexCount,
+                                    cacheSize);
+                std::vector<uint32_t> inPlace = input.indices;
+                optimizeVertexCache(inPlace.data(), inPlace.data(), inPlace.size(), input.vertexCount, cacheSize);
+                context.expect(inPlace == optimized, what + "in-place result differs");
+                context.expect(canonicalizeTriangles(optimized.data(), optimized.size()) ==
+                               canonicalizeTriangles(input.indices.data(), input.indices.size()),
+                               what + "triangles lost, duplicated or flipped");
+                const VertexCacheStats before =
+                    analyzeVertexCache(input.indices.data(), input.indices.size(), input.vertexCount, cacheSize);
+                const VertexCacheStats after =
+                    analyzeVertexCache(optimized.data(), optimized.size(), input.vertexCount, cacheSize);
+                context.expect(after.transformedVertices <= before.transformedVertices,
+                               what + "ACMR regressed from " + std::to_string(before.acmr) + " to " +
+                               std::to_string(after.acmr));
+            }
+        }
+
+        // What the import asks for: a shuffled grid must come out close to the ideal 0.5 misses per triangle
+        std::vector<uint32_t> indices = makeGridIndices(128);
+        shuffleTriangles(indices, 5);
+        optimizeVertexCache(indices.data(), indices.data(), indices.size(), 128 * 128);
+        const float acmr = analyzeVertexCache(indices.data(), indices.size(), 128 * 128).acmr;
+        context.expect(acmr < 0.7f, "shuffled grid ACMR " + std::to_string(acmr) + " after optimization");
+    }
+
+    // n x n vertices over the unit square, floatStride floats apart, lifted by a smooth bump so that collapses
+    // cost some error. With a crease the surface folds along column n / 2 instead (a hard-normal seam).
+    std::vector<float> makeBumpGrid(uint32_t n, size_t floatStride, bool crease) {
+        std::vector<float> positions(size_t(n) * n * floatStride, 0.0f);
+        for (uint32_t y = 0; y < n; ++y) {
+            for (uint32_t x = 0; x < n; ++x) {
+                const float u = float(x) / float(n - 1);
+                const float v = float(y) / float(n - 1);
+                float* p = &positions[(size_t(y) * n + x) * floatStride];
+                p[0] = u;
+                p[1] = v;
+                p[2] = crease ? std::fabs(u - 0.5f) * 0.5f + 0.02f * std::sin(v * 6.0f)
+                              : 0.1f * std::sin(u * 3.0f) * std::cos(v * 2.0f);
+            }
+        }
+        return positions;
+    }
+
+    // Splits the grid along column n / 2: the triangles right of it use copies of the seam vertices, appended
+    // after the grid, as a UV or normal seam does. outRight marks the vertices only the right side may use.
+    std::vector<uint32_t> splitGridSeam(uint32_t n, std::vector<float>& positions, size_t floatStride,
+                                        std::vector<uint8_t>& outRight) {
+        const uint32_t seam = n / 2;
+        outRight.assign(size_t(n) * n + n, 0);
+        for (uint32_t y = 0; y < n; ++y) {
+            const float* p = &positions[(size_t(y) * n + seam) * floatStride];
+            positions.insert(positions.end(), p, p + floatStride);
+            outRight[size_t(n) * n + y] = 1;
+            for (uint32_t x = seam + 1; x < n; ++x) {
+                outRight[size_t(y) * n + x] = 1;
+            }
+        }
+        std::vector<uint32_t> indices = makeGridIndices(n);
+        for (size_t t = 0; t < indices.size(); t += 3) {
+            const bool rightSide = outRight[indices[t]] || outRight[indices[t + 1]] || outRight[indices[t + 2]];
+            for (size_t k = 0; rightSide && k < 3; ++k) {
+                if (indices[t + k] % n == seam) {
+                    indices[t + k] = n * n + indices[t + k] / n;
+                }
+            }
+        }
+        return indices;
+    }
+
+    // Seam edges (both ends on column n / 2) each side's triangles use, by grid row: the two sides only stay
+    // stitched together if they simplified the seam identically
+    std::vector<std::array<uint32_t, 2>> getSeamEdges(const std::vector<uint32_t>& indices, uint32_t n,
+                                                      const std::vector<uint8_t>& right, bool rightSide) {
+        auto seamRow = [n](uint32_t v) {
+            return v >= n * n ? v - n * n : (v % n == n / 2 ? v / n : ~0u);
+        };
+        std::vector<std::array<uint32_t, 2>> edges;
+        for (size_t t = 0; t < indices.size(); t += 3) {
+            if ((right[indices[t]] || right[indices[t + 1]] || right[indices[t + 2]]) != rightSide) {
+                continue;
+            }
+            for (size_t k = 0; k < 3; ++k) {
+                const uint32_t a = seamRow(indices[t + k]);
+                const uint32_t b = seamRow(indices[t + (k + 1) % 3]);
+                if (a != ~0u && b != ~0u) {
+                    edges.push_back({std::min(a, b), std::max(a, b)});
+                }
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        return edges;
+    }
+
+    bool hasValidTriangles(const uint32_t* indices, size_t indexCount, size_t vertexCount) {
+        if (indexCount % 3 != 0) {
+            return false;
+        }
+        for (size_t t = 0; t < indexCount; t += 3) {
+            const uint32_t a = indices[t];
+            const uint32_t b = indices[t + 1];
+            const uint32_t c = indices[t + 2];
+            if (a >= vertexCount || b >= vertexCount || c >= vertexCount || a == b || b == c || a == c) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // simplifyMesh meets its index and error targets; LOD chains shrink with non-decreasing error within the
+    // level budgets; seam wedges never mix; selectMeshLod goes from LOD0 up close to the coarsest level far away
+    void checkLods(CheckContext& context) {
+        constexpr uint32_t n = 33;
+        constexpr size_t floatStride = 5; // Position + UV, so the position stride is not 12
+        constexpr size_t positionStride = floatStride * sizeof(float);
+        const std::vector<float> positions = makeBumpGrid(n, floatStride, false);
+        const std::vector<uint32_t> indices = makeGridIndices(n);
+        const size_t vertexCount = size_t(n) * n;
+
+        for (float ratio : {0.5f, 0.25f, 0.1f}) {
+            const std::string what = "ratio " + std::to_string(ratio) + ": ";
+            const size_t target = size_t(indices.size() * ratio) / 3 * 3;
+            std::vector<uint32_t> simplified(indices.size());
+            float error = -1.0f;
+            const size_t count = simplifyMesh(simplified.data(), indices.data(), indices.size(), positions.data(),
+                                              vertexCount, positionStride, target, 1.0f, &error);
+            context.expect(count > 0 && count <= target, what + std::to_string(count) + " indices for a target of " +
+                           std::to_string(target));
+            context.expect(error >= 0.0f && error <= 1.0f, what + "error " + std::to_string(error));
+            context.expect(hasValidTriangles(simplified.data(), count, vertexCount),
+                           what + "out-of-range or degenerate triangles");
+            std::vector<uint32_t> inPlace = indices;
+            const size_t inPlaceCount = simplifyMesh(inPlace.data(), inPlace.data(), inPlace.size(), positions.data(),
+                                                     vertexCount, positionStride, target, 1.0f);
+            context.expect(inPlaceCount == count && std::equal(simplified.begin(), simplified.begin() + count,
+                                                               inPlace.begin()), what + "in-place result differs");
+        }
+
+        // The error limit wins over the index target, and a tighter limit never removes more
+        size_t previousCount = 0;
+        for (float limit : {0.02f, 0.005f, 0.001f}) {
+            std::vector<uint32_t> simplified(indices.size());
+            float error = -1.0f;
+            const size_t count = simplifyMesh(simplified.data(), indices.data(), indices.size(), positions.data(),
+                                              vertexCount, positionStride, 0, limit, &error);
+            const std::string what = "error limit " + std::to_string(limit) + ": ";
+            context.expect(error >= 0.0f && error <= limit, what + "reached " + std::to_string(error));
+            context.expect(count > 0 && count < indices.size(), what + std::to_string(count) + " indices left");
+            context.expect(count >= previousCount, what + "removed more than a looser limit");
+            previousCount = count;
+        }
+
+        // The import's LOD chain: each level smaller, error non-decreasing and within its target
+        const MeshImportOptions importOptions;
+        const std::vector<MeshLodTarget>& targets = importOptions.lods;
+        std::vector<uint32_t> lodIndices;
+        const std::vector<MeshLod> lods = buildMeshLods(lodIndices, indices.data(), indices.size(), positions.data(),
+                                                        vertexCount, positionStride, targets.data(), targets.size());
+        context.expect(lods.size() >= 3, std::to_string(lods.size()) + " LODs built");
+        context.expect(!lods.empty() && lods[0].indexOffset == 0 && lods[0].indexCount == indices.size() &&
+                       lods[0].error == 0.0f, "LOD0 is not the input");
+        const float extent = 1.0f; // The bump grid spans the unit square
+        uint32_t nextOffset = static_cast<uint32_t>(indices.size());
+        for (size_t i = 1; i < lods.size(); ++i) {
+            const std::string what = "LOD" + std::to_string(i) + ": ";
+            context.expect(lods[i].indexOffset == nextOffset, what + "index range does not follow the previous one");
+            nextOffset += lods[i].indexCount;
+            context.expect(lods[i].indexCount < lods[i - 1].indexCount, what + "no fewer indices than its parent");
+            context.expect(lods[i].error >= lods[i - 1].error, what + "error below its parent's");
+            context.expect(lods[i].error <= targets[i - 1].maxError * extent * 1.001f,
+                           what + "error " + std::to_string(lods[i].error) + " over its target " +
+                           std::to_string(targets[i - 1].maxError));
+            const size_t first = lods[i].indexOffset - indices.size();
+            context.expect(first + lods[i].indexCount <= lodIndices.size() &&
+                           hasValidTriangles(lodIndices.data() + first, lods[i].indexCount, vertexCount),
+                           what + "out-of-range or degenerate triangles");
+        }
+        context.expect(nextOffset == indices.size() + lodIndices.size(), "LOD ranges do not cover lodIndices");
+
+        // Seams: no triangle may join wedges of the two sides, and both sides keep the same seam edges
+        for (bool crease : {false, true}) {
+            const std::string what = crease ? "normal seam: " : "UV seam: ";
+            std::vector<float> seamPositions = makeBumpGrid(n, floatStride, crease);
+            std::vector<uint8_t> right;
+            const std::vector<uint32_t> seamIndices = splitGridSeam(n, seamPositions, floatStride, right);
+            const size_t seamVertexCount = right.size();
+            std::vector<uint32_t> simplified(seamIndices.size());
+            const size_t count = simplifyMesh(simplified.data(), seamIndices.data(), seamIndices.size(),
+                                              seamPositions.data(), seamVertexCount, positionStride,
+                                              seamIndices.size() / 8 / 3 * 3, 1.0f);
+            simplified.resize(count);
+            context.expect(count > 0 && count * 4 <= seamIndices.size(), what + std::to_string(count) + " of " +
+                           std::to_string(seamIndices.size()) + " indices left");
+            size_t mixed = 0;
+            for (size_t t = 0; t < count; t += 3) {
+                const int rightCount = right[simplified[t]] + right[simplified[t + 1]] + right[simplified[t + 2]];
+                mixed += rightCount == 1 || rightCount == 2;
+            }
+            context.expect(mixed == 0, what + std::to_string(mixed) + " triangles collapsed across the seam");
+            const std::vector<std::array<uint32_t, 2>> leftEdges = getSeamEdges(simplified, n, right, false);
+            const std::vector<std::array<uint32_t, 2>> rightEdges = getSeamEdges(simplified, n, right, true);
+            context.expect(leftEdges == rightEdges, what + "the sides no longer share their seam edges");
+            context.expect(!leftEdges.empty() && leftEdges.size() < n - 1, what + std::to_string(leftEdges.size()) +
+                           " seam edges left: the seam was not simplified along itself");
+        }
+
+        // Selection: LOD0 up close, the coarsest level 50 bounding radii away, never finer further out
+        std::vector<float> errors;
+        for (const MeshLod& lod : lods) {
+            errors.push_back(lod.error);
+        }
+        const float radius = std::sqrt(3.0f) * 0.5f * extent;
+        const float fovY = 1.0472f; // 60 degrees
+        const float height = 1080.0f;
+        context.expect(selectMeshLod(errors.data(), errors.size(), 0.1f, 1.0f, fovY, height, 1.0f) == 0,
+                       "a finer level than LOD0 selected up close");
+        context.expect(selectMeshLod(errors.data(), errors.size(), 49.0f * radius, 1.0f, fovY, height, 1.0f) ==
+                       errors.size() - 1, "the coarsest level not selected 50 radii away");
+        size_t previous = 0;
+        bool monotonic = true;
+        for (float distance = 0.1f; distance < 100.0f; distance *= 1.25f) {
+            const size_t lod = selectMeshLod(errors.data(), errors.size(), distance, 1.0f, fovY, height, 1.0f);
+            monotonic = monotonic && lod >= previous;
+            previous = lod;
+            // Twice the scale at twice the distance projects the same
+            monotonic = monotonic &&
+                        selectMeshLod(errors.data(), errors.size(), distance * 2.0f, 2.0f, fovY, height, 1.0f) == lod;
+        }
+        context.expect(monotonic, "selection not monotonic in distance or not scale invariant");
+    }
+
+    using AttributeKernel = std::function<void(uint8_t* destination, size_t destinationStride, const uint8_t* source,
+                                               size_t sourceStride, size_t count)>;
+
+    // Runs the kernel over all elements at once (SIMD blocks plus a scalar tail) and one element per call (the
+    // scalar path alone) on buffers whose gaps between elements hold a marker. Returns false if the outputs
+    // differ or a gap was written; outDestination gets the first output.
+    bool runKernelBothWays(const AttributeKernel& kernel, const std::vector<uint8_t>& source, size_t sourceStride,
+                           size_t count, size_t elementSize, size_t destinationStride,
+                           std::vector<uint8_t>& outDestination) {
+        outDestination.assign(count * destinationStride + 1, 0xCD);
+        std::vector<uint8_t> single = outDestination;
+        kernel(outDestination.data(), destinationStride, source.data(), sourceStride, count);
+        for (size_t i = 0; i < count; ++i) {
+            kernel(single.data() + i * destinationStride, destinationStride, source.data() + i * sourceStride,
+                   sourceStride, 1);
+        }
+        bool gapsIntact = outDestination.back() == 0xCD;
+        for (size_t i = 0; i < count; ++i) {
+            for (size_t b = elementSize; b < destinationStride; ++b) {
+                gapsIntact = gapsIntact && outDestination[i * destinationStride + b] == 0xCD;
+            }
+        }
+        return gapsIntact && outDestination == single;
+    }
+
+    // Lays out elements of elementSize bytes at stride, gaps filled with a marker
+    std::vector<uint8_t> spreadElements(const void* elements, size_t count, size_t elementSize, size_t stride) {
+        std::vector<uint8_t> spread(count * stride + 1, 0xAB);
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(spread.data() + i * stride, static_cast<const uint8_t*>(elements) + i * elementSize, elementSize);
+        }
+        return spread;
+    }
+
+    float loadLane(const std::vector<uint8_t>& data, size_t offset) {
+        float value;
+        memcpy(&value, data.data() + offset, sizeof(value));
+        return value;
+    }
+
+    // Every attribute kernel on random and edge inputs, at counts and strides that are not multiples of the
+    // SIMD width: the SIMD blocks must match the scalar path bit for bit and the round trip must stay within
+    // the documented error
+    void checkVertexKernels(CheckContext& context) {
+        uint32_t seed = 17;
+        auto randomFloat = [&](float low, float high) {
+            return low + (high - low) * float(nextRandom(seed) & 0xFFFFFF) / float(0xFFFFFF);
+        };
+        const float infinity = std::numeric_limits<float>::infinity();
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+
+        struct KernelCase {
+            std::string name;
+            uint32_t components; // Floats per decoded element
+            uint32_t encodedSize; // Bytes per encoded element
+            AttributeKernel encode;
+            AttributeKernel decode;
+            std::vector<float> inputs; // components per element
+            std::function<bool(const float* input, const float* decoded)> withinError;
+        };
+        std::vector<KernelCase> cases;
+
+        const glm::vec3 snormScale(2.5f, 0.5f, 100.0f);
+        const glm::vec3 snormOffset(1.0f, -3.0f, 1000.0f);
+        KernelCase snorm = {"snorm16x3", 3, 8,
+            [&](uint8_t* d, size_t ds, const uint8_t* s, size_t ss, size_t n) {
+                encodeSnorm16x3(d, ds, s, ss, n, snormScale, snormOffset);
+            },
+            [&](uint8_t* d, size_t ds, const uint8_t* s, size_t ss, size_t n) {
+                decodeSnorm16x3(d, ds, s, ss, n, snormScale, snormOffset);
+            }, {}, nullptr};
+        for (float t : {-1.0f, 1.0f, 0.0f, -1.5f, 1.5f, 0.5f / 32767.0f, -0.99999f}) {
+            for (int axis = 0; axis < 3; ++axis) {
+                snorm.inputs.push_back(snormOffset[axis] + t * snormScale[axis]);
+            }
+        }
+        snorm.withinError = [&](const float* input, const float* decoded) {
+            bool ok = true;
+            for (int axis = 0; axis < 3; ++axis) {
+                const float low = snormOffset[axis] - snormScale[axis];
+                const float high = snormOffset[axis] + snormScale[axis];
+                const float clamped = std::min(std::max(input[axis], low), high);
+                const float tolerance = snormScale[axis] / 65534.0f + 4e-7f * (std::fabs(snormOffset[axis]) +
+                                                                               snormScale[axis]);
+                ok = ok && std::fabs(decoded[axis] - clamped) <= tolerance;
+            }
+            return ok;
+        };
+        for (int i = 0; i < 997; ++i) {
+            for (int axis = 0; axis < 3; ++axis) {
+                snorm.inputs.push_back(snormOffset[axis] + randomFloat(-1.2f, 1.2f) * snormScale[axis]);
+            }
+        }
+        cases.push_back(snorm);
+
+        KernelCase octahedral = {"octahedral16", 3, 4,
+            [](uint8_t* d, size_t ds, const uint8_t* s, size_t ss, size_t n) { encodeOctahedral16(d, ds, s, ss, n); },
+            [](uint8_t* d, size_t ds, const uint8_t* s, size_t ss, size_t n) { decodeOctahedral16(d, ds, s, ss, n); },
+            {1, 0, 0, -1, 0, 0, 0, 1, 0, 0, -1, 0, 0, 0, 1, 0, 0, -1, 0, 0, 0, -0.0f, -0.0f, -0.0f,
+             0.577f, -0.577f, -0.577f, 1e-30f, 0, -1e-30f, 3, 4, 0, -0.2f, 0.1f, -0.05f}, nullptr};
+        for (int i = 0; i < 997; ++i) {
+            octahedral.inputs.insert(octahedral.inputs.end(),
+                                     {randomFloat(-2, 2), randomFloat(-2, 2), randomFloat(-2, 2)});
+        }
+        octahedral.withinError = [](const float* input, const float* decoded) {
+            const glm::dvec3 d(decoded[0], decoded[1], decoded[2]);
+            const double l1 = std::fabs(input[0]) + std::fabs(input[1]) + std::fabs(input[2]);
+            if (std::fabs(glm::length(d) - 1.0) > 1e-6) {
+                return false;
+            }
+            if (l1 == 0.0) {
+                return d == glm::dvec3(0.0, 0.0, 1.0);
+            }
+            const glm::dvec3 n = glm::normalize(glm::dvec3(input[0], input[1], input[2]));
+            return glm::length(glm::cross(n, d)) <= 1e-4 && glm::dot(n, d) > 0.0; // sin of the angle
+        };
+        cases.push_back(octahedral);
+
+        KernelCase half = {"half2", 2, 4,
+            [](uint8_t* d, size_t ds, const uint8_t* s, size_t ss, size_t n) { encodeHalf2(d, ds, s, ss, n); },
+            [](uint8_t* d, size_t ds, const uint8_t* s, size_t ss, size_t n) { decodeHalf2(d, ds, s, ss, n); },
+            {0.0f, -0.0f, 1.0f, -1.0f, 65504.0f, -65519.0f, 65520.0f, -1e6f, infinity, -infinity, nan, -nan,
+             std::ldexp(1.0f, -24), -std::ldexp(1.0f, -25), std::ldexp(3.0f, -26), std::ldexp(1.0f, -14),
+             std::ldexp(1023.0f, -24), std::ldexp(1.0f, -30), 1.0f / 3.0f, 2049.0f, 4095.0f, -0.1f}, nullptr};
+        for (int i = 0; i < 997; ++i) {
+            half.inputs.push_back(randomFloat(-100.0f, 100.0f));
+            half.inputs.push_back(randomFloat(-1e-4f, 1e-4f));
+        }
+        half.withinError = [](const float* input, const float* decoded) {
+            for (int c = 0; c < 2; ++c) {
+                const float x = input[c];
+                const float y = decoded[c];
+                if (std::isnan(x)) {
+                    if (!std::isnan(y)) {
+                        return false;
+                    }
+                } else if (std::fabs(x) >= 65520.0f) {
+                    if (!std::isinf(y) || std::signbit(x) != std::signbit(y)) {
+                        return false;
+                    }
+                } else if (std::signbit(x) != std::signbit(y) ||
+                           std::fabs(y - x) > std::max(std::fabs(x) * std::ldexp(1.0f, -11), std::ldexp(1.0f, -25))) {
+                    return false;
+                }
+            }
+            return true;
+        };
+        cases.push_back(half);
+
+        const glm::vec2 unormScale(1.0f, 4.0f);
+        const glm::vec2 unormOffset(0.0f, -2.0f);
+        KernelCase unorm = {"unorm16x2", 2, 4,
+            [&](uint8_t* d, size_t ds, const uint8_t* s, size_t ss, size_t n) {
+                encodeUnorm16x2(d, ds, s, ss, n, unormScale, unormOffset);
+            },
+            [&](uint8_t* d, size_t ds, const uint8_t* s, size_t ss, size_t n) {
+                decodeUnorm16x2(d, ds, s, ss, n, unormScale, unormOffset);
+            },
+            {0.0f, -2.0f, 1.0f, 2.0f, -0.5f, -3.0f, 1.5f, 5.0f, 0.5f / 65535.0f, -1.9999f}, nullptr};
+        for (int i = 0; i < 997; ++i) {
+            unorm.inputs.push_back(randomFloat(-0.1f, 1.1f));
+            unorm.inputs.push_back(randomFloat(-2.2f, 2.2f));
+        }
+        unorm.withinError = [&](const float* input, const float* decoded) {
+            bool ok = true;
+            for (int axis = 0; axis < 2; ++axis) {
+                const float clamped = std::min(std::max(input[axis], unormOffset[axis]),
+                                               unormOffset[axis] + unormScale[axis]);
+                const float tolerance = unormScale[axis] / 131070.0f + 4e-7f * (std::fabs(unormOffset[axis]) +
+                                                                                unormScale[axis]);
+                ok = ok && std::fabs(decoded[axis] - clamped) <= tolerance;
+            }
+            return ok;
+        };
+        cases.push_back(unorm);
+
+        for (const KernelCase& kernel : cases) {
+            const size_t floatSize = kernel.components * sizeof(float);
+            const size_t elementCount = kernel.inputs.size() / kernel.components;
+            for (size_t count : {size_t(1), size_t(3), size_t(5), size_t(7), size_t(13), elementCount}) {
+                for (size_t padding : {size_t(0), size_t(1), size_t(6), size_t(37)}) {
+                    const std::string what = kernel.name + ", " + std::to_string(count) + " elements, stride +" +
+                                             std::to_string(padding) + ": ";
+                    const size_t floatStride = floatSize + padding;
+                    const size_t encodedStride = kernel.encodedSize + (padding * 3) % 11;
+                    const std::vector<uint8_t> source = spreadElements(kernel.inputs.data(), count, floatSize,
+                                                                       floatStride);
+                    std::vector<uint8_t> encoded;
+                    std::vector<uint8_t> decoded;
+                    context.expect(runKernelBothWays(kernel.encode, source, floatStride, count, kernel.encodedSize,
+                                                     encodedStride, encoded),
+                                   what + "encode differs from the scalar path or writes between elements");
+                    context.expect(runKernelBothWays(kernel.decode, encoded, encodedStride, count, floatSize,
+                                                     floatStride, decoded),
+                                   what + "decode differs from the scalar path or writes between elements");
+                    size_t outside = 0;
+                    for (size_t i = 0; i < count; ++i) {
+                        float values[3];
+                        for (uint32_t c = 0; c < kernel.components; ++c) {
+                            values[c] = loadLane(decoded, i * floatStride + c * sizeof(float));
+                        }
+                        outside += kernel.withinError(&kernel.inputs[i * kernel.components], values) ? 0 : 1;
+                    }
+                    context.expect(outside == 0, what + std::to_string(outside) + " round trips over the error bound");
+                }
+            }
+        }
+
+        // Every 16-bit code: decoding and encoding again gives the code back (NaN halves stay NaN, the snorm
+        // -32768 is the same value as -32767)
+        std::vector<uint16_t> codes(65536 * 3);
+        for (size_t i = 0; i < codes.size(); ++i) {
+            codes[i] = static_cast<uint16_t>(i / 3);
+        }
+        std::vector<uint8_t> values(65536 * 12);
+        std::vector<uint8_t> again(65536 * 6);
+        const uint8_t* codeBytes = reinterpret_cast<const uint8_t*>(codes.data());
+        const glm::vec3 identity3(1.0f);
+        const glm::vec2 identity2(1.0f);
+        decodeHalf2(values.data(), 8, codeBytes, 6, 65536);
+        encodeHalf2(again.data(), 6, values.data(), 8, 65536);
+        size_t halfMismatches = 0;
+        for (uint32_t code = 0; code < 65536; ++code) {
+            uint16_t roundTrip;
+            memcpy(&roundTrip, again.data() + code * 6, 2);
+            const bool isNan = (code & 0x7C00) == 0x7C00 && (code & 0x3FF) != 0;
+            halfMismatches += isNan ? ((roundTrip & 0x7C00) != 0x7C00 || (roundTrip & 0x3FF) == 0)
+                                    : roundTrip != code;
+        }
+        context.expect(halfMismatches == 0, std::to_string(halfMismatches) + " half codes do not round-trip");
+        decodeSnorm16x3(values.data(), 12, codeBytes, 6, 65536, identity3, glm::vec3(0.0f));
+        encodeSnorm16x3(again.data(), 6, values.data(), 12, 65536, identity3, glm::vec3(0.0f));
+        size_t snormMismatches = 0;
+        for (uint32_t code = 0; code < 65536; ++code) {
+            uint16_t roundTrip;
+            memcpy(&roundTrip, again.data() + code * 6, 2);
+            snormMismatches += roundTrip != (code == 0x8000 ? 0x8001 : code);
+        }
+        context.expect(snormMismatches == 0, std::to_string(snormMismatches) + " snorm16 codes do not round-trip");
+        decodeUnorm16x2(values.data(), 8, codeBytes, 6, 65536, identity2, glm::vec2(0.0f));
+        encodeUnorm16x2(again.data(), 6, values.data(), 8, 65536, identity2, glm::vec2(0.0f));
+        size_t unormMismatches = 0;
+        for (uint32_t code = 0; code < 65536; ++code) {
+            uint16_t roundTrip;
+            memcpy(&roundTrip, again.data() + code * 6, 2);
+            unormMismatches += roundTrip != code;
+        }
+        context.expect(unormMismatches == 0, std::to_string(unormMismatches) + " unorm16 codes do not round-trip");
+    }
+
+    // Every triangle lands in exactly one meshlet, within the vertex and triangle limits, and each meshlet's
+    // sphere, box and normal cone contain its triangles
+    void checkMeshlets(CheckContext& context) {
+        // Positions 5 floats apart, as between interleaved attributes
+        constexpr size_t kPositionFloats = 5;
+        struct Input {
+            std::string name;
+            std::vector<uint32_t> indices;
+            std::vector<float> positions;
+        };
+        auto gridPositions = [&](uint32_t n) {
+            std::vector<float> positions;
+            for (uint32_t y = 0; y < n; ++y) {
+                for (uint32_t x = 0; x < n; ++x) {
+                    const float height = std::sin(float(x) * 0.4f) * std::cos(float(y) * 0.3f) * 3.0f;
+                    positions.insert(positions.end(), {float(x), height, float(y), 0.0f, 0.0f});
+                }
+            }
+            return positions;
+        };
+        std::vector<Input> inputs;
+        inputs.push_back({"grid", makeGridIndices(48), gridPositions(48)});
+        inputs.push_back({"shuffled grid", makeGridIndices(48), gridPositions(48)});
+        shuffleTriangles(inputs.back().indices, 9);
+        uint32_t seed = 23;
+        Input soup = {"random soup", {}, {}};
+        for (int i = 0; i < 400; ++i) {
+            soup.positions.insert(soup.positions.end(), {float(nextRandom(seed) % 2001) * 0.01f - 10.0f,
+                                                         float(nextRandom(seed) % 2001) * 0.01f - 10.0f,
+                                                         float(nextRandom(seed) % 2001) * 0.01f - 10.0f, 0.0f, 0.0f});
+        }
+        for (int i = 0; i < 2000 * 3; ++i) {
+            soup.indices.push_back(nextRandom(seed) % 400);
+        }
+        inputs.push_back(soup);
+        // Degenerate (repeated vertex and zero area) and repeated triangles
+        Input degenerate = {"degenerate and repeated", makeGridIndices(16), gridPositions(16)};
+        for (uint32_t i = 0; i < 60; ++i) {
+            const uint32_t a = nextRandom(seed) % 255;
+            degenerate.indices.insert(degenerate.indices.end(), {a, a, a + 1, 5, 6, 7, 17, 18, 34});
+        }
+        shuffleTriangles(degenerate.indices, 4);
+        inputs.push_back(degenerate);
+        inputs.push_back({"one triangle", {2, 0, 1}, gridPositions(2)});
+
+        const size_t limits[][2] = {{kMeshletMaxVertices, kMeshletMaxTriangles}, {3, 1}, {16, 8}, {255, 124}};
+        for (const Input& input : inputs) {
+            const size_t vertexCount = input.positions.size() / kPositionFloats;
+            auto position = [&](uint32_t vertex) {
+                const float* p = &input.positions[vertex * kPositionFloats];
+                return glm::vec3(p[0], p[1], p[2]);
+            };
+            for (const auto& limit : limits) {
+                const std::string what = input.name + ", " + std::to_string(limit[0]) + "/" +
+                                         std::to_string(limit[1]) + ": ";
+                const MeshletData data = buildMeshlets(input.indices.data(), input.indices.size(),
+                                                       input.positions.data(), vertexCount,
+                                                       kPositionFloats * sizeof(float), limit[0], limit[1]);
+                context.expect(data.bounds.size() == data.meshlets.size(), what + "not one bounds per meshlet");
+                context.expect(data.triangles.size() == input.indices.size(), what + "triangle count changed");
+                if (data.bounds.size() != data.meshlets.size() || data.triangles.size() != input.indices.size()) {
+                    continue;
+                }
+
+                // Meshlets tile the vertex and triangle arrays in order, and every local vertex is used
+                size_t vertexOffset = 0;
+                size_t triangleOffset = 0;
+                size_t badLayout = 0;
+                size_t overLimit = 0;
+                size_t outsideBounds = 0;
+                size_t outsideCone = 0;
+                for (size_t m = 0; m < data.meshlets.size(); ++m) {
+                    const Meshlet& meshlet = data.meshlets[m];
+                    const MeshletBounds& bounds = data.bounds[m];
+                    badLayout += meshlet.vertexOffset != vertexOffset || meshlet.triangleOffset != triangleOffset ||
+                                 meshlet.triangleCount == 0;
+                    overLimit += meshlet.vertexCount > limit[0] || meshlet.triangleCount > limit[1];
+                    vertexOffset += meshlet.vertexCount;
+                    triangleOffset += meshlet.triangleCount;
+                    if (vertexOffset > data.vertices.size() || triangleOffset * 3 > data.triangles.size()) {
+                        badLayout++;
+                        break;
+                    }
+                    std::vector<uint8_t> used(meshlet.vertexCount, 0);
+                    for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+                        const uint8_t local = data.triangles[meshlet.triangleOffset * 3 + i];
+                        if (local >= meshlet.vertexCount) {
+                            badLayout++;
+                            break;
+                        }
+                        used[local] = 1;
+                    }
+                    badLayout += std::count(used.begin(), used.end(), 0);
+                    std::vector<uint32_t> vertices(data.vertices.begin() + meshlet.vertexOffset,
+                                                   data.vertices.begin() + vertexOffset);
+                    std::sort(vertices.begin(), vertices.end());
+                    badLayout += std::adjacent_find(vertices.begin(), vertices.end()) != vertices.end();
+
+                    const float sphereSlack = 1e-5f * (bounds.radius + glm::length(bounds.center)) + 1e-6f;
+                    for (uint32_t vertex : vertices) {
+                        const glm::vec3 p = position(vertex);
+                        outsideBounds += glm::length(p - bounds.center) > bounds.radius + sphereSlack ||
+                                         glm::any(glm::lessThan(p, bounds.aabbMin)) ||
+                                         glm::any(glm::greaterThan(p, bounds.aabbMax));
+                    }
+                    if (std::fabs(glm::length(bounds.coneAxis) - 1.0f) > 1e-5f) {
+                        outsideCone++;
+                    }
+                    for (uint32_t t = 0; t < meshlet.triangleCount && bounds.coneCutoff > -1.0f; ++t) {
+                        const uint8_t* triangle = &data.triangles[(meshlet.triangleOffset + t) * 3];
+                        const uint32_t* vertices = &data.vertices[meshlet.vertexOffset];
+                        const glm::vec3 p0 = position(vertices[triangle[0]]);
+                        const glm::vec3 n = glm::cross(position(vertices[triangle[1]]) - p0,
+                                                       position(vertices[triangle[2]]) - p0);
+                        if (glm::length(n) > 0.0f) {
+                            outsideCone += glm::dot(bounds.coneAxis, glm::normalize(n)) < bounds.coneCutoff - 1e-5f;
+                        }
+                    }
+                }
+                context.expect(badLayout == 0 && vertexOffset == data.vertices.size() &&
+                               triangleOffset * 3 == data.triangles.size(),
+                               what + "meshlets do not tile the vertex and triangle arrays");
+                context.expect(overLimit == 0, what + std::to_string(overLimit) + " meshlets over the limits");
+                context.expect(outsideBounds == 0,
+                               what + std::to_string(outsideBounds) + " vertices outside their meshlet's bounds");
+                context.expect(outsideCone == 0,
+                               what + std::to_string(outsideCone) + " triangles outside their meshlet's normal cone");
+
+                std::vector<uint32_t> written(input.indices.size());
+                writeMeshletIndices(written.data(), data);
+                context.expect(canonicalizeTriangles(written.data(), written.size()) ==
+                               canonicalizeTriangles(input.indices.data(), input.indices.size()),
+                               what + "triangles lost, duplicated or flipped");
+            }
+        }
+
+        const MeshletData empty = buildMeshlets(nullptr, 0, nullptr, 0, 12);
+        context.expect(empty.meshlets.empty() && empty.vertices.empty(), "empty mesh produced meshlets");
+    }
+
+    // Triangles as their three vertices' bytes, each rotated to start at its smallest vertex, in sorted order:
+    // equal for two imports that deduplicate or order vertices and triangles differently
+    std::vector<std::string> canonicalizeVertexTriangles(const Vertex* vertices, const uint32_t* indices,
+                                                         size_t indexCount) {
+        std::vector<std::string> triangles(indexCount / 3);
+        for (size_t t = 0; t < triangles.size(); ++t) {
+            std::string corners[3];
+            for (int k = 0; k < 3; ++k) {
+                corners[k].assign(reinterpret_cast<const char*>(&vertices[indices[t * 3 + k]]), sizeof(Vertex));
+            }
+            const size_t first = std::min_element(corners, corners + 3) - corners;
+            triangles[t] = corners[first] + corners[(first + 1) % 3] + corners[(first + 2) % 3];
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+
+    // Peak resident memory the streamed cache write adds to the process, in bytes, or 0 where it cannot be
+    // measured (only Linux can restart the high-water mark). Runs in a child process so nothing the checks
+    // allocated before counts; warmUpSource is a small OBJ written first to page in the code.
+    size_t measureStreamedWrite(const std::string& source, const std::string& warmUpSource,
+                                const std::string& cachePath, const MeshImportOptions& options,
+                                const SourceStamp& stamp, bool& outOk) {
+#ifdef __linux__
+        int channel[2];
+        if (pipe(channel) != 0) {
+            outOk = false;
+            return 0;
+        }
+        const pid_t child = fork();
+        if (child == 0) {
+            // Run once on a small source first, so the code and library pages the write touches are resident
+            // before the measurement. Then return the heap pages freed so far (the parent's too) and restart
+            // the high-water mark from what is left.
+            try {
+                QuietImport quiet;
+                writeStreamedMeshCache(warmUpSource, cachePath, options, stamp, 0);
+            } catch (const std::exception&) {
+            }
+#ifdef __GLIBC__
+            malloc_trim(0);
+#endif
+            if (FILE* clearRefs = fopen("/proc/self/clear_refs", "w")) {
+                fputs("5", clearRefs);
+                fclose(clearRefs);
+            }
+            rusage before = {};
+            getrusage(RUSAGE_SELF, &before);
+            bool ok = false;
+            try {
+                QuietImport quiet;
+                ok = writeStreamedMeshCache(source, cachePath, options, stamp, hashImportOptions(options));
+            } catch (const std::exception&) {
+            }
+            rusage after = {};
+            getrusage(RUSAGE_SELF, &after);
+            const uint64_t result[2] = {uint64_t(ok), uint64_t(after.ru_maxrss - before.ru_maxrss) * 1024};
+            const bool sent = write(channel[1], result, sizeof(result)) == ssize_t(sizeof(result));
+            _exit(sent ? 0 : 1);
+        }
+        close(channel[1]);
+        uint64_t result[2] = {};
+        const bool received = child > 0 && read(channel[0], result, sizeof(result)) == ssize_t(sizeof(result));
+        close(channel[0]);
+        int status = 0;
+        if (child > 0) {
+            waitpid(child, &status, 0);
+        }
+        outOk = received && result[0] != 0;
+        return static_cast<size_t>(result[1]);
+#else
+        static_cast<void>(warmUpSource);
+        QuietImport quiet;
+        outOk = writeStreamedMeshCache(source, cachePath, options, stamp, hashImportOptions(options));
+        return 0;
+#endif
+    }
+
+    // A source several times the streaming budget: the streamed write stays within the budget, and the
+    // streamed cache holds the same triangles as the in-memory import
+    void checkStreaming(CheckContext& context) {
+        const std::string source = context.path("streaming.obj");
+        TestObjOptions objOptions;
+        objOptions.gridSize = 300;
+        objOptions.groupCount = 2;
+        objOptions.faces = TestObjFaces::Polygons;
+        context.expect(writeTestObj(source, objOptions), "cannot write " + source);
+        SourceStamp stamp;
+        context.expect(querySourceStamp(source, stamp, false), "cannot stamp the source");
+        const std::string warmUpSource = context.path("streaming-small.obj");
+        objOptions.gridSize = 8;
+        context.expect(writeTestObj(warmUpSource, objOptions), "cannot write " + warmUpSource);
+
+        // Only the passes the streaming import has too
+        MeshImportOptions memoryOptions;
+        memoryOptions.buildMeshlets = false;
+        memoryOptions.lods.clear();
+        memoryOptions.shortIndices = false;
+
+        // Streamed writes first, while the heap holds nothing large that the measurement could reuse
+        const size_t budgets[] = {size_t(6) << 20, size_t(8) << 20};
+        std::vector<std::string> caches;
+        for (size_t budget : budgets) {
+            const std::string what = "budget " + std::to_string(budget >> 20) + " MiB: ";
+            context.expect(stamp.size > budget * 3, what + "source is not several times the budget");
+            MeshImportOptions options = memoryOptions;
+            options.streaming = true;
+            options.streamingMemoryBudget = budget;
+            caches.push_back(context.path("streaming.obj.meshcache") + std::to_string(budget >> 20));
+            bool written = false;
+            const size_t peak = measureStreamedWrite(source, warmUpSource, caches.back(), options, stamp, written);
+            context.expect(written, what + "writeStreamedMeshCache failed");
+            // The budget covers the importer; the cache writer adds a batch of rebased indices and file buffers
+            const size_t cap = budget + budget / 8;
+            context.expect(peak <= cap, what + "peak resident memory grew by " + std::to_string(peak >> 10) +
+                                        " KiB, over the " + std::to_string(cap >> 10) + " KiB cap");
+        }
+
+        MeshData expected;
+        {
+            QuietImport quiet;
+            expected = importObjFile(source, memoryOptions);
+        }
+        const std::vector<std::string> expectedTriangles =
+            canonicalizeVertexTriangles(expected.vertices.data(), expected.indices.data(), expected.indices.size());
+        for (size_t i = 0; i < caches.size(); ++i) {
+            const std::string what = "budget " + std::to_string(budgets[i] >> 20) + " MiB: ";
+            MeshImportOptions options = memoryOptions;
+            options.streaming = true;
+            options.streamingMemoryBudget = budgets[i];
+            MeshCacheFile file;
+            const bool opened = file.open(caches[i]);
+            context.expect(opened, what + "cannot open the streamed cache");
+            if (!opened) {
+                continue;
+            }
+            context.expect(file.matchesSource(source, hashImportOptions(options)), what + "cache does not match");
+            const MeshView view = file.getView();
+            context.expect(view.indexSize == 4 && view.vertexFormat == VertexFormat{} && view.vertices != nullptr,
+                           what + "streamed cache is not in the Vertex layout with 32-bit indices");
+            if (view.indexSize != 4 || view.vertices == nullptr) {
+                continue;
+            }
+            const Vertex* vertices = static_cast<const Vertex*>(view.vertices);
+            const uint32_t* indices = static_cast<const uint32_t*>(view.indices);
+            context.expect(std::all_of(indices, indices + view.indexCount,
+                                       [&](uint32_t index) { return index < view.vertexCount; }),
+                           what + "index out of range");
+            context.expect(canonicalizeVertexTriangles(vertices, indices, view.indexCount) == expectedTriangles,
+                           what + "triangles differ from the in-memory import");
+            context.expect(view.bounds.aabbMin == expected.bounds.aabbMin &&
+                           view.bounds.aabbMax == expected.bounds.aabbMax, what + "bounds differ");
+        }
+    }
+
+    // Index positions each draw covers, with its material and base vertex, in a canonical order
+    std::vector<std::array<uint32_t, 3>> expandDraws(const SubmeshDraw* draws, size_t count) {
+        std::vector<std::array<uint32_t, 3>> covered;
+        for (size_t i = 0; i < count; ++i) {
+            for (uint32_t index = 0; index < draws[i].indexCount; ++index) {
+                covered.push_back({draws[i].indexOffset + index, draws[i].materialIndex, draws[i].baseVertex});
+            }
+        }
+        std::sort(covered.begin(), covered.end());
+        return covered;
+    }
+
+    // One level's draws: a draw per non-empty submesh with its clamped level range, sorted by material then
+    // offset; merging keeps every index and leaves no adjacent pair it could still join; the material
+    // change count matches the draws
+    void checkLevelDraws(CheckContext& context, const std::string& what, const Submesh* submeshes,
+                         size_t submeshCount, const MeshLod* lods, size_t lod) {
+        std::vector<SubmeshDraw> draws;
+        buildSubmeshDraws(draws, submeshes, submeshCount, lods, lod);
+        size_t expectedCount = 0;
+        size_t wrongRanges = 0;
+        for (size_t i = 0; i < submeshCount; ++i) {
+            const Submesh& submesh = submeshes[i];
+            uint32_t offset = submesh.indexOffset;
+            uint32_t count = submesh.indexCount;
+            if (submesh.lodCount > 0) {
+                const MeshLod& level = lods[submesh.lodOffset + std::min<size_t>(lod, submesh.lodCount - 1)];
+                offset = level.indexOffset;
+                count = level.indexCount;
+            }
+            if (count == 0) {
+                continue;
+            }
+            expectedCount++;
+            const auto draw = std::find_if(draws.begin(), draws.end(),
+                                           [&](const SubmeshDraw& d) { return d.submesh == i; });
+            wrongRanges += draw == draws.end() || draw->indexOffset != offset || draw->indexCount != count ||
+                           draw->materialIndex != submesh.materialIndex || draw->baseVertex != submesh.baseVertex;
+        }
+        context.expect(draws.size() == expectedCount && wrongRanges == 0,
+                       what + "draws do not match the submesh ranges at this level");
+        context.expect(std::is_sorted(draws.begin(), draws.end(), [](const SubmeshDraw& a, const SubmeshDraw& b) {
+            return a.materialIndex != b.materialIndex ? a.materialIndex < b.materialIndex
+                                                      : a.indexOffset < b.indexOffset;
+        }), what + "draws not sorted by material and offset");
+
+        const std::vector<std::array<uint32_t, 3>> covered = expandDraws(draws.data(), draws.size());
+        std::vector<SubmeshDraw> merged = draws;
+        merged.resize(mergeSubmeshDraws(merged.data(), merged.size()));
+        context.expect(expandDraws(merged.data(), merged.size()) == covered,
+                       what + "merging changed the indices drawn");
+        size_t joinable = 0;
+        for (size_t i = 1; i < merged.size(); ++i) {
+            joinable += merged[i].materialIndex == merged[i - 1].materialIndex &&
+                        merged[i].baseVertex == merged[i - 1].baseVertex &&
+                        merged[i].indexOffset == merged[i - 1].indexOffset + merged[i - 1].indexCount;
+        }
+        context.expect(joinable == 0, what + std::to_string(joinable) + " adjacent draws left unmerged");
+
+        std::vector<uint32_t> materials;
+        for (const SubmeshDraw& draw : draws) {
+            materials.push_back(draw.materialIndex);
+        }
+        std::sort(materials.begin(), materials.end());
+        const size_t materialCount = std::unique(materials.begin(), materials.end()) - materials.begin();
+        context.expect(countMaterialChanges(draws.data(), draws.size()) == materialCount &&
+                       countMaterialChanges(merged.data(), merged.size()) == materialCount,
+                       what + "material changes are not one per material");
+    }
+
+    // Material-sorted draw batching on synthetic submeshes (any order, empty ones, uneven LOD chains, base
+    // vertices) and on an import, whose LOD and meshlet ranges must also tile the submeshes
+    void checkSubmeshDraws(CheckContext& context) {
+        uint32_t seed = 31;
+        for (int round = 0; round < 50; ++round) {
+            std::vector<Submesh> submeshes(nextRandom(seed) % 12);
+            std::vector<MeshLod> lods;
+            uint32_t indexOffset = 0;
+            for (Submesh& submesh : submeshes) {
+                submesh = {};
+                submesh.indexOffset = indexOffset;
+                submesh.indexCount = nextRandom(seed) % 5 == 0 ? 0 : (1 + nextRandom(seed) % 20) * 3;
+                indexOffset += submesh.indexCount;
+                const uint32_t material = nextRandom(seed) % 5;
+                submesh.materialIndex = material == 4 ? kNoMaterial : material;
+                submesh.baseVertex = nextRandom(seed) % 3 == 0 ? 65536 : 0;
+            }
+            // Levels after LOD0 follow all of LOD0, each submesh's chain in turn
+            uint32_t lodOffset = indexOffset;
+            for (Submesh& submesh : submeshes) {
+                submesh.lodOffset = static_cast<uint32_t>(lods.size());
+                submesh.lodCount = nextRandom(seed) % 4;
+                for (uint32_t level = 0; level < submesh.lodCount; ++level) {
+                    const uint32_t count = level == 0 ? submesh.indexCount : submesh.indexCount / (level + 1) / 3 * 3;
+                    lods.push_back({level == 0 ? submesh.indexOffset : lodOffset, count, float(level), 0});
+                    lodOffset += level == 0 ? 0 : count;
+                }
+            }
+            for (size_t lod = 0; lod < 5; ++lod) {
+                checkLevelDraws(context, "random " + std::to_string(round) + ", LOD " + std::to_string(lod) + ": ",
+                                submeshes.data(), submeshes.size(), lods.data(), lod);
+            }
+        }
+
+        // An import: groups alternate materials, so the submeshes sorted by material merge to one draw each
+        const std::string source = context.path("draws.obj");
+        TestObjOptions objOptions;
+        objOptions.gridSize = 24;
+        objOptions.groupCount = 7;
+        objOptions.materialCount = 3;
+        context.expect(writeTestObj(source, objOptions), "cannot write " + source);
+        MeshImportOptions options;
+        options.shortIndices = false;
+        MeshData mesh;
+        {
+            QuietImport quiet;
+            mesh = importObjFile(source, options);
+        }
+        const std::vector<Submesh>& submeshes = mesh.submeshes;
+        context.expect(submeshes.size() == 7 && !mesh.lods.empty() && !mesh.meshlets.meshlets.empty(),
+                       "import lacks submeshes, LODs or meshlets");
+        uint32_t indexOffset = 0;
+        size_t badRanges = 0;
+        std::vector<std::pair<uint32_t, uint32_t>> levelRanges;
+        for (const Submesh& submesh : submeshes) {
+            badRanges += submesh.indexOffset != indexOffset;
+            indexOffset = submesh.indexOffset + submesh.indexCount;
+            // LOD0 is the submesh range; coarser levels lie in the LOD indices, no larger than the level before
+            const MeshLod* chain = &mesh.lods[submesh.lodOffset];
+            badRanges += submesh.lodCount == 0 || chain[0].indexOffset != submesh.indexOffset ||
+                         chain[0].indexCount != submesh.indexCount;
+            for (uint32_t level = 1; level < submesh.lodCount; ++level) {
+                badRanges += chain[level].indexOffset < mesh.indices.size() ||
+                             chain[level].indexOffset + chain[level].indexCount >
+                             mesh.indices.size() + mesh.lodIndices.size() ||
+                             chain[level].indexCount > chain[level - 1].indexCount;
+                levelRanges.push_back({chain[level].indexOffset, chain[level].indexCount});
+            }
+            // The meshlets cover exactly the LOD0 triangles, in order
+            uint32_t triangle = submesh.indexOffset / 3;
+            for (uint32_t m = 0; m < submesh.meshletCount; ++m) {
+                const Meshlet& meshlet = mesh.meshlets.meshlets[submesh.meshletOffset + m];
+                badRanges += meshlet.triangleOffset != triangle;
+                triangle = meshlet.triangleOffset + meshlet.triangleCount;
+            }
+            badRanges += submesh.meshletCount == 0 || triangle * 3 != submesh.indexOffset + submesh.indexCount;
+        }
+        std::sort(levelRanges.begin(), levelRanges.end());
+        for (size_t i = 1; i < levelRanges.size(); ++i) {
+            badRanges += levelRanges[i].first < levelRanges[i - 1].first + levelRanges[i - 1].second;
+        }
+        context.expect(badRanges == 0 && indexOffset == mesh.indices.size(),
+                       "import: submesh, LOD or meshlet ranges do not tile the index buffer");
+        context.expect(std::is_sorted(submeshes.begin(), submeshes.end(), [](const Submesh& a, const Submesh& b) {
+            return a.materialIndex < b.materialIndex;
+        }), "import: submeshes not sorted by material");
+        for (size_t lod = 0; lod <= options.lods.size(); ++lod) {
+            checkLevelDraws(context, "import, LOD " + std::to_string(lod) + ": ", submeshes.data(), submeshes.size(),
+                            mesh.lods.data(), lod);
+        }
+        std::vector<SubmeshDraw> draws;
+        buildSubmeshDraws(draws, submeshes.data(), submeshes.size(), mesh.lods.data(), 0);
+        context.expect(mergeSubmeshDraws(draws.data(), draws.size()) == 3,
+                       "import: LOD0 does not merge to one draw per material");
+    }
+
+    size_t countDistinct(const uint32_t* indices, size_t count) {
+        std::vector<uint32_t> sorted(indices, indices + count);
+        std::sort(sorted.begin(), sorted.end());
+        return std::unique(sorted.begin(), sorted.end()) - sorted.begin();
+    }
+
+    // Index buffer of every submesh's LOD0 with the base vertices added
+    std::vector<uint32_t> getAbsoluteIndices(const MeshData& mesh) {
+        std::vector<uint32_t> indices;
+        for (const Submesh& submesh : mesh.submeshes) {
+            for (uint32_t i = 0; i < submesh.indexCount; ++i) {
+                indices.push_back(submesh.baseVertex + mesh.indices[submesh.indexOffset + i]);
+            }
+        }
+        return indices;
+    }
+
+    // A two-submesh mesh over vertexCount vertices: the first references [0, firstVertices), the second the
+    // last secondVertices, with three-vertex strips so every vertex is used. Each submesh has a coarser level.
+    MeshData makeRangeMesh(uint32_t vertexCount, uint32_t firstVertices, uint32_t secondVertices) {
+        MeshData mesh;
+        mesh.vertices.resize(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            mesh.vertices[v] = {};
+            mesh.vertices[v].position = glm::vec3(float(v), float(v % 7), 0.0f);
+        }
+        auto addStrip = [&](uint32_t first, uint32_t count) {
+            for (uint32_t v = first; v + 2 < first + count; ++v) {
+                mesh.indices.insert(mesh.indices.end(), {v, v + 1, v + 2});
+            }
+        };
+        Submesh submesh = {};
+        submesh.materialIndex = kNoMaterial;
+        addStrip(0, firstVertices);
+        submesh.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        mesh.submeshes.push_back(submesh);
+        submesh.indexOffset = submesh.indexCount;
+        addStrip(vertexCount - secondVertices, secondVertices);
+        submesh.indexCount = static_cast<uint32_t>(mesh.indices.size()) - submesh.indexOffset;
+        mesh.submeshes.push_back(submesh);
+        // Level 1: every other triangle of LOD0, in the LOD indices
+        for (size_t s = 0; s < 2; ++s) {
+            Submesh& target = mesh.submeshes[s];
+            target.lodOffset = static_cast<uint32_t>(mesh.lods.size());
+            target.lodCount = 2;
+            mesh.lods.push_back({target.indexOffset, target.indexCount, 0.0f, 0});
+            const uint32_t levelOffset = static_cast<uint32_t>(mesh.lodIndices.size());
+            for (uint32_t i = 0; i < target.indexCount; i += 6) {
+                mesh.lodIndices.insert(mesh.lodIndices.end(), &mesh.indices[target.indexOffset + i],
+                                       &mesh.indices[target.indexOffset + i + 3]);
+            }
+            mesh.lods.push_back({levelOffset, static_cast<uint32_t>(mesh.lodIndices.size()) - levelOffset, 1.0f, 0});
+        }
+        for (MeshLod& lod : mesh.lods) {
+            lod.indexOffset += lod.error > 0.0f ? static_cast<uint32_t>(mesh.indices.size()) : 0;
+        }
+        return mesh;
+    }
+
+    // Every LOD0 and coarser index of the converted mesh stays below the 16-bit limit and, with its submesh's
+    // base vertex added, names the same vertex as before the conversion
+    size_t countRebaseErrors(const MeshData& before, const MeshData& after) {
+        size_t errors = 0;
+        for (size_t s = 0; s < after.submeshes.size(); ++s) {
+            const Submesh& original = before.submeshes[s];
+            const Submesh& submesh = after.submeshes[s];
+            for (uint32_t level = 0; level < submesh.lodCount; ++level) {
+                const MeshLod& lod = after.lods[submesh.lodOffset + level];
+                for (uint32_t i = lod.indexOffset; i < lod.indexOffset + lod.indexCount; ++i) {
+                    const bool inLod0 = i < after.indices.size();
+                    const uint32_t index = inLod0 ? after.indices[i] : after.lodIndices[i - after.indices.size()];
+                    const uint32_t oldIndex = inLod0 ? before.indices[i] : before.lodIndices[i - before.indices.size()];
+                    errors += index >= kShortIndexVertexLimit || submesh.baseVertex + index >= after.vertices.size() ||
+                              !sameBytes(&after.vertices[submesh.baseVertex + index],
+                                         &before.vertices[original.baseVertex + oldIndex], sizeof(Vertex));
+                }
+            }
+        }
+        return errors;
+    }
+
+    // 16-bit indices: index runs split right at the vertex limit, conversion rebases every index (LODs too)
+    // onto per-submesh vertex ranges or leaves the mesh untouched, and an import needing several runs per
+    // submesh draws the same triangles as with 32-bit indices
+    void checkShortIndices(CheckContext& context) {
+        // Disjoint triangles over 65535 vertices, one adding the 65536th, then one that no longer fits
+        std::vector<uint32_t> indices;
+        for (uint32_t v = 0; v < 65535; ++v) {
+            indices.push_back(v);
+        }
+        indices.insert(indices.end(), {0, 1, 65535, 65536, 65537, 65538, 0, 65538, 65539});
+        std::vector<uint32_t> runs = splitIndexRuns(indices.data(), indices.size(), 65540);
+        context.expect(runs.size() == 2 && runs[0] == 65538 && runs[1] == 6,
+                       "run does not end at exactly 65536 vertices");
+        for (size_t maxVertices : {size_t(3), size_t(4), size_t(100), kShortIndexVertexLimit}) {
+            std::vector<uint32_t> grid = makeGridIndices(300);
+            shuffleTriangles(grid, 13);
+            const std::string what = "shuffled grid, " + std::to_string(maxVertices) + " vertices per run: ";
+            runs = splitIndexRuns(grid.data(), grid.size(), 300 * 300, maxVertices);
+            size_t offset = 0;
+            size_t bad = 0;
+            for (size_t r = 0; r < runs.size(); ++r) {
+                bad += runs[r] == 0 || runs[r] % 3 != 0 || countDistinct(&grid[offset], runs[r]) > maxVertices;
+                // Greedy: the next run's first triangle would not have fit
+                if (r + 1 < runs.size()) {
+                    bad += countDistinct(&grid[offset], runs[r] + 3) <= maxVertices;
+                }
+                offset += runs[r];
+            }
+            context.expect(bad == 0 && offset == grid.size(), what + "runs are not maximal runs within the limit");
+        }
+        context.expect(splitIndexRuns(nullptr, 0, 0).empty(), "empty index buffer has runs");
+
+        // Small mesh: no ranges needed
+        MeshData small = makeRangeMesh(1000, 600, 600);
+        MeshData converted = small;
+        context.expect(convertToShortIndices(converted, sizeof(Vertex)) == 0 && converted.indexSize == 2 &&
+                       converted.indices == small.indices && converted.lodIndices == small.lodIndices,
+                       "small mesh: not converted in place");
+
+        // Large mesh, overlapping submeshes: the shared vertices are duplicated, everything else is rebased
+        const uint32_t shared = 2000;
+        MeshData large = makeRangeMesh(120000 - shared, 60000, 60000);
+        converted = large;
+        const ptrdiff_t duplicated = convertToShortIndices(converted, sizeof(Vertex));
+        context.expect(duplicated == shared && converted.indexSize == 2 && converted.vertices.size() == 120000,
+                       "large mesh: expected " + std::to_string(shared) + " duplicated vertices, got " +
+                       std::to_string(duplicated));
+        if (duplicated == shared) {
+            const size_t errors = countRebaseErrors(large, converted);
+            context.expect(errors == 0, "large mesh: " + std::to_string(errors) + " indices do not re-expand");
+        }
+
+        // 32-bit fallbacks leave the mesh untouched: a submesh over the limit, or duplication costing more
+        // than the 16-bit indices save
+        MeshData oversized = makeRangeMesh(70000, 65537, 100);
+        converted = oversized;
+        context.expect(convertToShortIndices(converted, sizeof(Vertex)) == -1 && converted.indexSize == 4 &&
+                       converted.indices == oversized.indices && converted.vertices.size() == 70000,
+                       "submesh over the limit converted");
+        MeshData costly = makeRangeMesh(70000, 65000, 65000);
+        converted = costly;
+        context.expect(convertToShortIndices(converted, sizeof(Vertex)) == -1 && converted.indexSize == 4 &&
+                       converted.indices == costly.indices && converted.vertices.size() == 70000,
+                       "converted although duplicating 60000 vertices costs more than it saves");
+
+        // Import of a single-group 300 x 300 grid: 90000 vertices split into same-material submeshes
+        const std::string source = context.path("short.obj");
+        TestObjOptions objOptions;
+        objOptions.gridSize = 300;
+        objOptions.materialCount = 1;
+        context.expect(writeTestObj(source, objOptions), "cannot write " + source);
+        MeshImportOptions options;
+        MeshImportOptions wideOptions;
+        wideOptions.shortIndices = false;
+        MeshData shortMesh;
+        MeshData wideMesh;
+        {
+            QuietImport quiet;
+            shortMesh = importObjFile(source, options);
+            wideMesh = importObjFile(source, wideOptions);
+        }
+        context.expect(wideMesh.indexSize == 4 && wideMesh.submeshes.size() == 1, "32-bit import split or shrank");
+        context.expect(shortMesh.indexSize == 2 && shortMesh.submeshes.size() >= 2,
+                       "import did not split the grid into 16-bit submeshes");
+        size_t bad = 0;
+        for (const Submesh& submesh : shortMesh.submeshes) {
+            bad += submesh.materialIndex != 0;
+            for (uint32_t level = 0; level < submesh.lodCount; ++level) {
+                const MeshLod& lod = shortMesh.lods[submesh.lodOffset + level];
+                for (uint32_t i = lod.indexOffset; i < lod.indexOffset + lod.indexCount; ++i) {
+                    const uint32_t index = i < shortMesh.indices.size()
+                                               ? shortMesh.indices[i]
+                                               : shortMesh.lodIndices[i - shortMesh.indices.size()];
+                    bad += index >= kShortIndexVertexLimit || submesh.baseVertex + index >= shortMesh.vertices.size();
+                }
+            }
+            // Meshlet vertices are absolute and name the vertices the index buffer does
+            for (uint32_t m = submesh.meshletOffset; m < submesh.meshletOffset + submesh.meshletCount; ++m) {
+                const Meshlet& meshlet = shortMesh.meshlets.meshlets[m];
+                for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+                    const uint8_t local = shortMesh.meshlets.triangles[meshlet.triangleOffset * 3 + i];
+                    bad += shortMesh.meshlets.vertices[meshlet.vertexOffset + local] !=
+                           submesh.baseVertex + shortMesh.indices[meshlet.triangleOffset * 3 + i];
+                }
+            }
+        }
+        context.expect(bad == 0, "16-bit import: " + std::to_string(bad) + " bad indices or meshlet vertices");
+        const std::vector<uint32_t> shortIndices = getAbsoluteIndices(shortMesh);
+        const std::vector<uint32_t> wideIndices = getAbsoluteIndices(wideMesh);
+        context.expect(canonicalizeVertexTriangles(shortMesh.vertices.data(), shortIndices.data(),
+                                                   shortIndices.size()) ==
+                       canonicalizeVertexTriangles(wideMesh.vertices.data(), wideIndices.data(), wideIndices.size()),
+                       "16-bit import draws other triangles than the 32-bit one");
+    }
+
+    // Mesh entries of the derived-data cache: the second load maps the entry the first one wrote, while the
+    // source contents, every hashed option and the import revision each lead to another entry
+    void checkDerivedCache(CheckContext& context) {
+        const std::string source = context.path("derived.obj");
+        TestObjOptions objOptions;
+        objOptions.gridSize = 24;
+        objOptions.groupCount = 2;
+        objOptions.materialCount = 2;
+        context.expect(writeTestObj(source, objOptions), "cannot write " + source);
+        const std::string directory = context.path("derived-data");
+        std::error_code ec;
+        std::filesystem::remove_all(directory, ec);
+        DerivedDataCache derivedData;
+        context.expect(derivedData.open(directory, uint64_t(1) << 30), "cannot open " + directory);
+
+        MeshImportOptions base;
+        base.derivedDataCache = &derivedData;
+        const uint64_t baseHash = hashImportOptions(base);
+        QuietImport quiet;
+        // True if loadMesh mapped an entry instead of importing
+        auto loadsFromCache = [&](const MeshImportOptions& options) {
+            ImportedMesh mesh;
+            loadMesh(source, options, mesh);
+            return mesh.fromCache;
+        };
+
+        {
+            ImportedMesh cold;
+            loadMesh(source, base, cold);
+            ImportedMesh warm;
+            loadMesh(source, base, warm);
+            MeshView view = warm.view;
+            DecodedMeshStreams streams;
+            context.expect(!cold.fromCache && warm.fromCache && derivedData.getEntryCount() == 1,
+                           "second load does not map the entry the first one wrote");
+            context.expect(decodeMeshStreams(view, streams) && compareMeshViews(cold.view, view).empty(),
+                           "mapped entry differs from the import");
+            context.expect(!std::filesystem::exists(source + ".meshcache"), "cache written next to the source");
+        }
+
+        struct Variant {
+            const char* name;
+            std::function<void(MeshImportOptions&)> change;
+        };
+        const Variant hashed[] = {
+            {"weld.positionEpsilon", [](MeshImportOptions& o) { o.weld.positionEpsilon = 1e-4f; }},
+            {"weld.normalEpsilon", [](MeshImportOptions& o) { o.weld.normalEpsilon = 0.01f; }},
+            {"weld.texCoordEpsilon", [](MeshImportOptions& o) { o.weld.texCoordEpsilon = 0.01f; }},
+            {"optimizeVertexCache", [](MeshImportOptions& o) { o.optimizeVertexCache = false; }},
+            {"optimizeVertexFetch", [](MeshImportOptions& o) { o.optimizeVertexFetch = false; }},
+            {"spatialSortVertices", [](MeshImportOptions& o) { o.spatialSortVertices = true; }},
+            {"vertexFormat", [](MeshImportOptions& o) { o.vertexFormat = kCompactVertexFormat; }},
+            {"vertexFormat.texCoord", [](MeshImportOptions& o) { o.vertexFormat.texCoord = TexCoordEncoding::Half; }},
+            {"vertexFormat.color", [](MeshImportOptions& o) { o.vertexFormat.color = false; }},
+            {"vertexFormat.splitPositions", [](MeshImportOptions& o) { o.vertexFormat.splitPositions = true; }},
+            {"buildMeshlets", [](MeshImportOptions& o) { o.buildMeshlets = false; }},
+            {"lods (one fewer)", [](MeshImportOptions& o) { o.lods.pop_back(); }},
+            {"lods (indexRatio)", [](MeshImportOptions& o) { o.lods[0].indexRatio = 0.4f; }},
+            {"lods (maxError)", [](MeshImportOptions& o) { o.lods[0].maxError = 0.003f; }},
+            {"lods (none)", [](MeshImportOptions& o) { o.lods.clear(); }},
+            {"shortIndices", [](MeshImportOptions& o) { o.shortIndices = false; }},
+        };
+        std::vector<uint64_t> hashes = {baseHash};
+        for (const Variant& variant : hashed) {
+            MeshImportOptions options = base;
+            variant.change(options);
+            const uint64_t optionsHash = hashImportOptions(options);
+            const size_t entryCount = derivedData.getEntryCount();
+            const std::string what = std::string("changed ") + variant.name + ": ";
+            context.expect(std::find(hashes.begin(), hashes.end(), optionsHash) == hashes.end(),
+                           what + "options hash not changed");
+            hashes.push_back(optionsHash);
+            context.expect(!loadsFromCache(options) && derivedData.getEntryCount() == entryCount + 1,
+                           what + "load did not miss and write a new entry");
+            context.expect(loadsFromCache(options), what + "second load does not hit");
+        }
+        // Streamed imports bypass the cache, but their caches next to the source carry the same hash
+        MeshImportOptions streamed = base;
+        streamed.streaming = true;
+        const uint64_t streamedHash = hashImportOptions(streamed);
+        streamed.streamingMemoryBudget /= 2;
+        MeshImportOptions unstreamed = base;
+        unstreamed.streamingMemoryBudget /= 2;
+        context.expect(streamedHash != baseHash && hashImportOptions(streamed) != streamedHash &&
+                       hashImportOptions(unstreamed) == baseHash,
+                       "streaming and its budget (only when streaming) do not change the options hash");
+
+        // Options that leave the output alone share the entry
+        JobSystem jobSystem(1);
+        const Variant unhashed[] = {
+            {"parseThreadCount", [](MeshImportOptions& o) { o.parseThreadCount = 3; }},
+            {"jobSystem", [&](MeshImportOptions& o) { o.jobSystem = &jobSystem; }},
+            {"compressStreams", [](MeshImportOptions& o) { o.compressStreams = false; }},
+        };
+        const size_t entryCount = derivedData.getEntryCount();
+        for (const Variant& variant : unhashed) {
+            MeshImportOptions options = base;
+            variant.change(options);
+            context.expect(hashImportOptions(options) == baseHash && loadsFromCache(options),
+                           std::string("changed ") + variant.name + ": the entry is not shared");
+        }
+        context.expect(loadsFromCache(base) && derivedData.getEntryCount() == entryCount,
+                       "the first entry did not survive the others");
+
+        // Another import revision keys another entry, and the current entry does not match its hash
+        SourceStamp stamp;
+        context.expect(querySourceStamp(source, stamp, true), "cannot stamp " + source);
+        const std::string entry = derivedData.getEntryPath(
+            makeDerivedDataKey("mesh", kMeshCacheVersion, stamp.contentHash, baseHash), ".meshcache");
+        MeshCacheFile file;
+        context.expect(file.open(entry) && file.matchesContent(stamp.contentHash, baseHash),
+                       "entry not where loadMesh keys it");
+        for (uint64_t revision : {kMeshImportRevision - 1, kMeshImportRevision + 1}) {
+            const uint64_t optionsHash = hashImportOptions(base, revision);
+            const std::string other = derivedData.getEntryPath(
+                makeDerivedDataKey("mesh", kMeshCacheVersion, stamp.contentHash, optionsHash), ".meshcache");
+            context.expect(optionsHash != baseHash && other != entry && !std::filesystem::exists(other) &&
+                           !file.matchesContent(stamp.contentHash, optionsHash),
+                           "import revision " + std::to_string(revision) + " would reuse the entry");
+        }
+        file.close();
+
+        // Edited contents miss too
+        objOptions.gridSize = 25;
+        context.expect(writeTestObj(source, objOptions) && !loadsFromCache(base) &&
+                       derivedData.getEntryCount() == entryCount + 1, "edited source maps the old entry");
+    }
+
+    struct Check {
+        const char* name;
+        void (*run)(CheckContext& context);
+    };
+
+    const Check kChecks[] = {
+        {"meshcache", checkMeshCache},
+        {"objparser", checkObjParser},
+        {"vertexcache", checkVertexCache},
+        {"lods", checkLods},
+        {"vertexkernels", checkVertexKernels},
+        {"meshlets", checkMeshlets},
+        {"streaming", checkStreaming},
+        {"submeshdraws", checkSubmeshDraws},
+        {"shortindices", checkShortIndices},
+        {"derivedcache", checkDerivedCache},
+    };
+}
+
+int runChecks(const std::string& directory, const std::string& name) {
+    CheckContext context;
+    context.directory = directory;
+    std::error_code ec;
+    std::filesystem::create_directories(context.directory, ec);
+    if (ec) {
+        std::cerr << "Cannot create " << directory << std::endl;
+        return 1;
+    }
+    bool found = false;
+    for (const Check& check : kChecks) {
+        if (!name.empty() && name != check.name) {
+            continue;
+        }
+        found = true;
+        const int failures = context.failures;
+        try {
+            check.run(context);
+        } catch (const std::exception& e) {
+            context.expect(false, std::string(check.name) + " threw: " + e.what());
+        }
+        printf("%-14s%s\n", check.name, context.failures == failures ? "ok" : "FAILED");
+    }
+    if (!found) {
+        std::cerr << "Unknown check: " << name << std::endl;
+        return 2;
+    }
+    if (context.failures == 0) {
+        std::cout << "All mesh pipeline checks passed" << std::endl;
+    }
+    return context.failures == 0 ? 0 : 1;
+}
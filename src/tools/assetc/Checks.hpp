@@ -0,0 +1,6 @@
+#pragma once
+#include <string>
+
+// "assetc check": round-trip and invariant checks of the mesh pipeline on generated sources, whose files
+// are written under directory. With a name, only that check runs. Returns the process exit code.
+int runChecks(const std::string& directory, const std::string& name);
@@ -0,0 +1,285 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AssetCompiler.hpp"
+#include "Benchmarks.hpp"
+#include "Checks.hpp"
+#include "core/FileWatcher.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: assetc [options] <source>...\n"
+            "       assetc check [<directory>] [--only <name>]\n"
+            "       assetc bench <name> [<mesh.obj>] [--runs <n>] [-j <threads>] [--grid <n>]\n"
+            "Builds runtime-ready .meshcache (from .obj) and .texcache (from .png/.jpg/.tga/.bmp) files.\n"
+            "Prebuilt .dds/.ktx2 textures are checked and loaded as they are.\n"
+            "\n"
+            "  -o <dir>             Write outputs under <dir> (default: next to each source, where the\n"
+            "                       runtime looks for them)\n"
+            "  --root <dir>         With -o, mirror the source paths relative to <dir> (default: .)\n"
+            "  -j <threads>         Threads building assets (default: one per core)\n"
+            "  --force              Rebuild outputs that are up to date\n"
+            "  --watch              Keep running and rebuild the assets whose sources (or material\n"
+            "                       libraries) under --root change\n"
+            "  --no-materials       Do not build the textures referenced by mesh materials\n"
+            "  --compact-vertices   16-byte quantized vertices (kCompactVertexFormat)\n"
+            "  --split-positions    Separate position stream for depth-only passes and the BLAS\n"
+            "  --no-lods            No simplified LODs\n"
+            "  --no-meshlets        No meshlets\n"
+            "  --no-short-indices   Always 32-bit indices\n"
+            "  --streaming          Bounded-memory import (no welding, meshlets or LODs)\n"
+            "  --raw-streams        Store vertices and indices uncompressed (no MeshCodec)\n"
+            "  --no-mips            Textures without mip chains\n"
+            "  --mip-filter <name>  box, kaiser (default) or lanczos\n"
+            "  --texture-format <name>\n"
+            "                       none, auto (default: BC1, or BC3 with alpha), bc1, bc3, bc5 or bc7\n"
+            "  --texture-quality <name>\n"
+            "                       Block compression effort: fast, normal (default) or high\n"
+            "\n"
+            "Mesh options must match the runtime's, which are: --compact-vertices --split-positions\n"
+            "Texture options must match the runtime's, which are the defaults\n"
+            "\n"
+            "check: round-trip and invariant checks of the mesh pipeline on generated meshes, written to\n"
+            "       <directory> (default: assetc-check in the temporary directory). --only runs one of:\n"
+            "         meshcache     cache sections, stamp and options mismatches, truncated files\n"
+            "         objparser     chunked parses equal the single-chunk parse (negative indices, n-gons)\n"
+            "         vertexcache   triangle reordering keeps every triangle and never raises the ACMR\n"
+            "         lods          simplification meets its targets, errors grow per level, seams stay stitched,\n"
+            "                       selection goes from LOD0 up close to the coarsest level far away\n"
+            "         vertexkernels attribute kernels match the scalar path and stay within their error bounds\n"
+            "         meshlets      every triangle in one meshlet within the limits, inside its bounds and cone\n"
+            "         streaming     streamed cache equals the in-memory import; peak memory within the budget\n"
+            "         submeshdraws  material-sorted, merged draws per LOD; LOD and meshlet ranges tile the submeshes\n"
+            "         shortindices  runs split at 65536 vertices; rebased 16-bit indices name the same vertices\n"
+            "         derivedcache  derived-data cache hits; source contents, hashed options and revision miss\n"
+            "bench: best-of-n timings on the mesh (default: a generated one, 256 vertices per side or --grid):\n"
+            "         cache         cold OBJ import against the mapped raw and compressed caches\n"
+            "         ddc           loadMesh through an empty derived-data cache against a warm one\n"
+            "         parse         chunked OBJ parser at 1..-j threads\n"
+            "         weld          corner deduplication: table presizes and probe lengths at 1/2 and 3/4 load\n"
+            "                       (default: the corners of a generated 1024 x 1024 grid)\n";
+    }
+
+    const char* getStatusName(AssetStatus status) {
+        switch (status) {
+            case AssetStatus::UpToDate:
+                return "up to date";
+            case AssetStatus::Built:
+                return "built";
+            case AssetStatus::Failed:
+                return "FAILED";
+            default:
+                return "pending";
+        }
+    }
+
+    // Files whose changes can make an output stale; outputs written next to their sources land in the
+    // watched tree too and must not trigger another build
+    bool isSourceFile(const std::string& path) {
+        std::string extension = path.substr(std::min(path.size(), path.find_last_of('.')));
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        for (const char* sourceExtension : {".obj", ".mtl", ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".dds", ".ktx2"}) {
+            if (extension == sourceExtension) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Builds the graph and prints its nodes (only the ones rebuilt or failed unless printUpToDate). Returns
+    // false if any node failed.
+    bool buildAndPrint(AssetCompiler& compiler, JobSystem* jobSystem, bool printUpToDate) {
+        const bool ok = compiler.build(jobSystem);
+
+        size_t built = 0;
+        size_t upToDate = 0;
+        size_t failed = 0;
+        for (const AssetNode& node : compiler.getNodes()) {
+            built += node.status == AssetStatus::Built;
+            upToDate += node.status == AssetStatus::UpToDate;
+            failed += node.status == AssetStatus::Failed;
+            if (node.status == AssetStatus::UpToDate && !printUpToDate) {
+                continue;
+            }
+            printf("%-10s %s -> %s (%.1f ms)\n", getStatusName(node.status), node.source.c_str(),
+                   node.output.c_str(), node.milliseconds);
+            if (!node.error.empty()) {
+                printf("           %s\n", node.error.c_str());
+            }
+        }
+        printf("%zu built, %zu up to date, %zu failed\n", built, upToDate, failed);
+        fflush(stdout);
+        return ok;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "check") == 0) {
+        std::string directory = (std::filesystem::temp_directory_path() / "assetc-check").string();
+        std::string name;
+        for (int i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "--only") == 0 && i + 1 < argc) {
+                name = argv[++i];
+            } else if (argv[i][0] != '-') {
+                directory = argv[i];
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+        return runChecks(directory, name);
+    }
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) {
+        return runBenchmark(argc, argv);
+    }
+
+    AssetCompilerOptions options;
+    unsigned threadCount = 0;
+    bool watch = false;
+    std::vector<std::string> sources;
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(arg, "-o") == 0 && hasValue) {
+            options.outputDirectory = argv[++i];
+        } else if (strcmp(arg, "--root") == 0 && hasValue) {
+            options.sourceRoot = argv[++i];
+        } else if (strcmp(arg, "-j") == 0 && hasValue) {
+            threadCount = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+        } else if (strcmp(arg, "--force") == 0) {
+            options.force = true;
+        } else if (strcmp(arg, "--watch") == 0) {
+            watch = true;
+        } else if (strcmp(arg, "--no-materials") == 0) {
+            options.followMaterials = false;
+        } else if (strcmp(arg, "--compact-vertices") == 0) {
+            const bool splitPositions = options.mesh.vertexFormat.splitPositions;
+            options.mesh.vertexFormat = kCompactVertexFormat;
+            options.mesh.vertexFormat.splitPositions = splitPositions;
+        } else if (strcmp(arg, "--split-positions") == 0) {
+            options.mesh.vertexFormat.splitPositions = true;
+        } else if (strcmp(arg, "--no-lods") == 0) {
+            options.mesh.lods.clear();
+        } else if (strcmp(arg, "--no-meshlets") == 0) {
+            options.mesh.buildMeshlets = false;
+        } else if (strcmp(arg, "--no-short-indices") == 0) {
+            options.mesh.shortIndices = false;
+        } else if (strcmp(arg, "--streaming") == 0) {
+            options.mesh.streaming = true;
+        } else if (strcmp(arg, "--raw-streams") == 0) {
+            options.mesh.compressStreams = false;
+        } else if (strcmp(arg, "--no-mips") == 0) {
+            options.texture.generateMips = false;
+        } else if (strcmp(arg, "--mip-filter") == 0 && hasValue) {
+            const char* name = argv[++i];
+            if (strcmp(name, "box") == 0) {
+                options.texture.mips.filter = MipFilter::Box;
+            } else if (strcmp(name, "kaiser") == 0) {
+                options.texture.mips.filter = MipFilter::Kaiser;
+            } else if (strcmp(name, "lanczos") == 0) {
+                options.texture.mips.filter = MipFilter::Lanczos;
+            } else {
+                printUsage();
+                return 2;
+            }
+        } else if (strcmp(arg, "--texture-format") == 0 && hasValue) {
+            const char* name = argv[++i];
+            if (strcmp(name, "none") == 0) {
+                options.texture.compression = TextureCompression::None;
+            } else if (strcmp(name, "auto") == 0) {
+                options.texture.compression = TextureCompression::Auto;
+            } else if (strcmp(name, "bc1") == 0) {
+                options.texture.compression = TextureCompression::Bc1;
+            } else if (strcmp(name, "bc3") == 0) {
+                options.texture.compression = TextureCompression::Bc3;
+            } else if (strcmp(name, "bc5") == 0) {
+                options.texture.compression = TextureCompression::Bc5;
+            } else if (strcmp(name, "bc7") == 0) {
+                options.texture.compression = TextureCompression::Bc7;
+            } else {
+                printUsage();
+                return 2;
+            }
+        } else if (strcmp(arg, "--texture-quality") == 0 && hasValue) {
+            const char* name = argv[++i];
+            if (strcmp(name, "fast") == 0) {
+                options.texture.compressionQuality = BlockQuality::Fast;
+            } else if (strcmp(name, "normal") == 0) {
+                options.texture.compressionQuality = BlockQuality::Normal;
+            } else if (strcmp(name, "high") == 0) {
+                options.texture.compressionQuality = BlockQuality::High;
+            } else {
+                printUsage();
+                return 2;
+            }
+        } else if (arg[0] == '-') {
+            printUsage();
+            return 2;
+        } else {
+            sources.push_back(arg);
+        }
+    }
+    if (sources.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    AssetCompiler compiler(options);
+    for (const std::string& source : sources) {
+        if (!compiler.addSource(source)) {
+            std::cerr << "Unknown asset type: " << source << std::endl;
+            return 2;
+        }
+    }
+
+    // The calling thread helps, so -j N needs N - 1 workers; -j 1 builds on this thread alone
+    std::unique_ptr<JobSystem> jobSystem;
+    if (threadCount != 1) {
+        jobSystem = std::make_unique<JobSystem>(threadCount > 1 ? threadCount - 1 : 0);
+    }
+    const bool ok = buildAndPrint(compiler, jobSystem.get(), true);
+    if (!watch) {
+        return ok ? 0 : 1;
+    }
+
+    // Every change triggers a build of all the sources, but the stamps skip the outputs that are still
+    // current, so only the assets built from the changed files are processed again
+    FileWatcher watcher;
+    if (!watcher.open(options.sourceRoot)) {
+        std::cerr << "Cannot watch " << options.sourceRoot << " for changes" << std::endl;
+        return 1;
+    }
+    options.force = false;
+    printf("Watching %s for changes\n", options.sourceRoot.c_str());
+    fflush(stdout);
+    std::vector<std::string> changedPaths;
+    while (true) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        changedPaths.clear();
+        watcher.poll(changedPaths);
+        if (std::none_of(changedPaths.begin(), changedPaths.end(), isSourceFile)) {
+            continue;
+        }
+        for (const std::string& path : changedPaths) {
+            printf("changed    %s\n", path.c_str());
+        }
+        AssetCompiler rebuild(options);
+        for (const std::string& source : sources) {
+            rebuild.addSource(source);
+        }
+        buildAndPrint(rebuild, jobSystem.get(), false);
+    }
+}
@@ -0,0 +1,120 @@
+#include "TestMeshes.hpp"
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+    float getHeight(float x, float y) {
+        return 0.3f * std::sin(x * 0.37f) * std::cos(y * 0.23f) + 0.05f * std::sin(x * y * 0.01f);
+    }
+
+    // One face corner; each vertex has its own v, vt and vn line, so all three share the vertex number
+    void writeCorner(FILE* file, uint64_t vertex, uint64_t vertexCount, uint32_t face, bool negativeIndices) {
+        long long values[3];
+        for (uint32_t attribute = 0; attribute < 3; ++attribute) {
+            const bool relative = negativeIndices && ((face + attribute) % 4 != 0);
+            values[attribute] = relative ? static_cast<long long>(vertex) - static_cast<long long>(vertexCount)
+                                         : static_cast<long long>(vertex) + 1;
+        }
+        fprintf(file, " %lld/%lld/%lld", values[0], values[1], values[2]);
+    }
+}
+
+bool writeTestObj(const std::string& path, const TestObjOptions& options) {
+    const std::filesystem::path objPath(path);
+    const std::string library = objPath.stem().string() + ".mtl";
+    if (options.materialCount > 0) {
+        FILE* mtl = fopen((objPath.parent_path() / library).string().c_str(), "w");
+        if (!mtl) {
+            return false;
+        }
+        for (uint32_t i = 0; i < options.materialCount; ++i) {
+            fprintf(mtl, "newmtl material%u\nKd %.3f %.3f %.3f\nKs 0.5 0.5 0.5\nNs %u\nmap_Kd texture%u.png\n\n", i,
+                    0.2f + 0.6f * float(i % 3) / 2.0f, 0.5f, 0.8f - 0.6f * float(i % 5) / 4.0f, 8 + 8 * i, i);
+        }
+        if (fclose(mtl) != 0) {
+            return false;
+        }
+    }
+
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return false;
+    }
+    if (options.materialCount > 0) {
+        fprintf(file, "mtllib %s\n", library.c_str());
+    }
+    const uint32_t n = options.gridSize;
+    uint64_t vertexCount = 0;
+    uint32_t face = 0;
+    for (uint32_t group = 0; group < options.groupCount; ++group) {
+        fprintf(file, "g group%u\n", group);
+        if (options.materialCount > 0) {
+            fprintf(file, "usemtl material%u\n", group % options.materialCount);
+        }
+        const uint64_t groupBase = vertexCount;
+        const float originX = float(group) * float(n);
+        auto vertex = [&](uint32_t x, uint32_t y) {
+            return groupBase + uint64_t(y) * n + x;
+        };
+        for (uint32_t y = 0; y < n; ++y) {
+            for (uint32_t x = 0; x < n; ++x) {
+                const float px = originX + float(x);
+                const float py = float(y);
+                // Normal of the height field from its gradient (finite differences)
+                const float dx = getHeight(px + 0.5f, py) - getHeight(px - 0.5f, py);
+                const float dy = getHeight(px, py + 0.5f) - getHeight(px, py - 0.5f);
+                const float length = std::sqrt(dx * dx + dy * dy + 1.0f);
+                fprintf(file, "v %.5f %.5f %.5f\nvt %.5f %.5f\nvn %.5f %.5f %.5f\n", px, getHeight(px, py), py,
+                        float(x) / float(n - 1), float(y) / float(n - 1), -dx / length, 1.0f / length,
+                        -dy / length);
+            }
+            vertexCount += n;
+            if (y == 0) {
+                continue;
+            }
+            for (uint32_t x = 0; x + 1 < n;) {
+                const uint64_t a = vertex(x, y - 1);
+                const uint64_t b = vertex(x + 1, y - 1);
+                const uint64_t c = vertex(x + 1, y);
+                const uint64_t d = vertex(x, y);
+                uint32_t kind = options.faces == TestObjFaces::Triangles ? 0 : 1;
+                if (options.faces == TestObjFaces::Polygons) {
+                    kind = (x + y) % 3;
+                    kind = kind == 2 && x + 2 >= n ? 1 : kind;
+                }
+                if (kind == 0) {
+                    const uint64_t triangles[2][3] = {{a, d, c}, {a, c, b}};
+                    for (const auto& triangle : triangles) {
+                        fprintf(file, "f");
+                        for (uint64_t corner : triangle) {
+                            writeCorner(file, corner, vertexCount, face, options.negativeIndices);
+                        }
+                        fprintf(file, "\n");
+                        ++face;
+                    }
+                    x += 1;
+                } else if (kind == 1) {
+                    fprintf(file, "f");
+                    for (uint64_t corner : {a, d, c, b}) {
+                        writeCorner(file, corner, vertexCount, face, options.negativeIndices);
+                    }
+                    fprintf(file, "\n");
+                    ++face;
+                    x += 1;
+                } else {
+                    fprintf(file, "f");
+                    for (uint64_t corner : {a, d, c, vertex(x + 2, y), vertex(x + 2, y - 1), b}) {
+                        writeCorner(file, corner, vertexCount, face, options.negativeIndices);
+                    }
+                    fprintf(file, "\n");
+                    ++face;
+                    x += 2;
+                }
+            }
+        }
+    }
+    const bool ok = !ferror(file);
+    return (fclose(file) == 0) && ok;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+// Synthetic OBJ sources for assetc's checks and benchmarks. Each group is a height-field grid written row
+// by row (a row of v/vt/vn lines, then the faces joining it to the previous row), so faces and the
+// attributes they reference sit close together wherever the parser cuts the file into chunks.
+
+enum class TestObjFaces {
+    Triangles, // Two triangles per cell
+    Quads, // One quad per cell
+    Polygons, // Cycles through triangle pairs, quads and hexagons spanning two cells
+};
+
+struct TestObjOptions {
+    uint32_t gridSize = 32; // Vertices per side of each group's grid
+    uint32_t groupCount = 1; // "g" groups, side by side
+    uint32_t materialCount = 0; // Group i uses material i % materialCount of a generated .mtl; 0 for none
+    TestObjFaces faces = TestObjFaces::Quads;
+    // Relative face indices, mixed per attribute with absolute ones (so every combination of the three
+    // attributes appears)
+    bool negativeIndices = false;
+};
+
+// Writes the OBJ to path and, with materials, "<stem>.mtl" next to it. Returns false if a file cannot be
+// written.
+bool writeTestObj(const std::string& path, const TestObjOptions& options);
+
+// Silences std::cout while it lives: the importer reports every pass there, and the checks and benchmarks
+// only print their results
+class QuietImport {
+public:
+    QuietImport() : m_buffer(std::cout.rdbuf(nullptr)) {
+    }
+
+    ~QuietImport() {
+        std::cout.rdbuf(m_buffer);
+        std::cout.clear();
+    }
+
+    QuietImport(const QuietImport&) = delete;
+
+    QuietImport& operator=(const QuietImport&) = delete;
+
+private:
+    std::streambuf* m_buffer;
+};
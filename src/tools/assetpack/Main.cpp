@@ -0,0 +1,566 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "asset/Hash.hpp"
+#include "asset/Lz4.hpp"
+#include "asset/PackFile.hpp"
+#include "asset/VirtualFileSystem.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: assetpack create <output.pack> [options] <file or directory>...\n"
+            "       assetpack list <pack>\n"
+            "       assetpack verify <pack>\n"
+            "       assetpack bench <pack> [--root <dir>] [--runs <n>]\n"
+            "       assetpack check [<directory>]\n"
+            "\n"
+            "create: packs the files (directories recursively) under their path relative to the root, the\n"
+            "        path the runtime opens them by (e.g. \"mitsuba.obj.meshcache\", \"Raytracing.hlsl\")\n"
+            "  --root <dir>         Root the pack paths are relative to (default: .)\n"
+            "  --no-compress        Store every entry uncompressed (mapped in place at runtime)\n"
+            "bench:  opens and reads every entry, once as a loose file under the root and once through the\n"
+            "        pack, and reports the time each took (warm OS file cache)\n"
+            "check:  LZ4 edge cases and damaged blocks, a pack round trip with aligned entries, table lookups,\n"
+            "        in-place views of stored entries, damaged packs and the loose-file fallback, on files\n"
+            "        written to <directory> (default: assetpack-check in the temporary directory)\n";
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    int createPack(int argc, char** argv) {
+        if (argc < 4) {
+            printUsage();
+            return 2;
+        }
+        const std::string output = argv[2];
+        std::filesystem::path root = ".";
+        bool compress = true;
+        std::vector<std::filesystem::path> inputs;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+                root = argv[++i];
+            } else if (strcmp(argv[i], "--no-compress") == 0) {
+                compress = false;
+            } else if (argv[i][0] == '-') {
+                printUsage();
+                return 2;
+            } else {
+                inputs.push_back(argv[i]);
+            }
+        }
+
+        // Expanded and sorted first, so the data is laid out in path order like the table of contents
+        std::vector<std::filesystem::path> files;
+        for (const std::filesystem::path& input : inputs) {
+            std::error_code ec;
+            if (std::filesystem::is_directory(input, ec)) {
+                for (const auto& item : std::filesystem::recursive_directory_iterator(input, ec)) {
+                    if (item.is_regular_file()) {
+                        files.push_back(item.path());
+                    }
+                }
+            } else if (std::filesystem::is_regular_file(input, ec)) {
+                files.push_back(input);
+            } else {
+                std::cerr << "Not found: " << input.string() << std::endl;
+                return 1;
+            }
+        }
+        std::sort(files.begin(), files.end());
+
+        const auto start = std::chrono::steady_clock::now();
+        PackWriter writer;
+        if (!writer.open(output)) {
+            std::cerr << "Failed to create " << output << std::endl;
+            return 1;
+        }
+        for (const std::filesystem::path& file : files) {
+            const std::string packPath = normalizePackPath(file.lexically_relative(root).generic_string());
+            if (packPath.empty() || packPath.compare(0, 2, "..") == 0) {
+                std::cerr << "Outside the root: " << file.string() << std::endl;
+                return 1;
+            }
+            if (!writer.addFile(packPath, file.string(), compress)) {
+                std::cerr << "Failed to add " << file.string() << " as " << packPath << std::endl;
+                return 1;
+            }
+        }
+        if (!writer.finish()) {
+            std::cerr << "Failed to write " << output << std::endl;
+            return 1;
+        }
+        printf("%zu entries, %.1f MiB -> %.1f MiB stored (%.1f ms)\n", writer.getEntryCount(),
+               writer.getOriginalBytes() / 1048576.0, writer.getStoredBytes() / 1048576.0,
+               millisecondsSince(start));
+        return 0;
+    }
+
+    int listPack(const char* path) {
+        PackFile pack;
+        if (!pack.open(path)) {
+            std::cerr << "Not a valid pack: " << path << std::endl;
+            return 1;
+        }
+        for (size_t i = 0; i < pack.getEntryCount(); ++i) {
+            const PackEntry& entry = pack.getEntry(i);
+            printf("%12llu %12llu %s %s\n", static_cast<unsigned long long>(entry.size),
+                   static_cast<unsigned long long>(entry.storedSize),
+                   (entry.flags & kPackEntryCompressed) ? "lz4   " : "stored", pack.getEntryPath(entry));
+        }
+        return 0;
+    }
+
+    int verifyPack(const char* path) {
+        PackFile pack;
+        if (!pack.open(path)) {
+            std::cerr << "Not a valid pack: " << path << std::endl;
+            return 1;
+        }
+        std::string error;
+        if (!pack.verify(&error)) {
+            std::cerr << error << std::endl;
+            return 1;
+        }
+        printf("%zu entries OK\n", pack.getEntryCount());
+        return 0;
+    }
+
+    // Opens every file the way a loader does and reads all of its bytes; returns a checksum so the reads
+    // cannot be optimized away
+    uint64_t readAll(const VirtualFileSystem* fileSystem, const std::vector<std::string>& paths, bool& ok) {
+        uint64_t checksum = 0;
+        for (const std::string& path : paths) {
+            VirtualFile file;
+            if (!openFile(fileSystem, path, file)) {
+                std::cerr << "Failed to open " << path << std::endl;
+                ok = false;
+                continue;
+            }
+            checksum = hashCombine(checksum, hash64(file.data(), file.size()));
+        }
+        return checksum;
+    }
+
+    int benchmarkPack(int argc, char** argv) {
+        if (argc < 3) {
+            printUsage();
+            return 2;
+        }
+        const std::string packPath = argv[2];
+        std::filesystem::path root = ".";
+        int runs = 5;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--root") == 0 && i + 1 < argc) {
+                root = argv[++i];
+            } else if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+                runs = std::max(1, atoi(argv[++i]));
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+
+        std::vector<std::string> entryPaths;
+        uint64_t totalBytes = 0;
+        {
+            PackFile pack;
+            if (!pack.open(packPath)) {
+                std::cerr << "Not a valid pack: " << packPath << std::endl;
+                return 1;
+            }
+            for (size_t i = 0; i < pack.getEntryCount(); ++i) {
+                entryPaths.push_back(pack.getEntryPath(pack.getEntry(i)));
+                totalBytes += pack.getEntry(i).size;
+            }
+        }
+        std::vector<std::string> loosePaths;
+        for (const std::string& path : entryPaths) {
+            loosePaths.push_back((root / path).string());
+        }
+
+        // Best of several runs; each pack run includes mounting, as at startup
+        bool ok = true;
+        double looseBest = 1e30;
+        double packBest = 1e30;
+        uint64_t looseChecksum = 0;
+        uint64_t packChecksum = 0;
+        for (int run = 0; run < runs && ok; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            looseChecksum = readAll(nullptr, loosePaths, ok);
+            looseBest = std::min(looseBest, millisecondsSince(start));
+
+            start = std::chrono::steady_clock::now();
+            VirtualFileSystem fileSystem;
+            fileSystem.setLooseFilesEnabled(false);
+            if (!fileSystem.mount(packPath)) {
+                std::cerr << "Failed to mount " << packPath << std::endl;
+                return 1;
+            }
+            packChecksum = readAll(&fileSystem, entryPaths, ok);
+            packBest = std::min(packBest, millisecondsSince(start));
+        }
+        if (!ok) {
+            return 1;
+        }
+        if (looseChecksum != packChecksum) {
+            std::cerr << "The loose files differ from the pack" << std::endl;
+            return 1;
+        }
+        printf("%zu files, %.1f MiB\n", entryPaths.size(), totalBytes / 1048576.0);
+        printf("loose files: %8.2f ms\n", looseBest);
+        printf("pack:        %8.2f ms (%.2fx)\n", packBest, packBest > 0.0 ? looseBest / packBest : 0.0);
+        return 0;
+    }
+
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    std::vector<uint8_t> makeRandomBytes(size_t size, uint32_t seed) {
+        std::vector<uint8_t> bytes(size);
+        for (uint8_t& byte : bytes) {
+            byte = static_cast<uint8_t>(nextRandom(seed));
+        }
+        return bytes;
+    }
+
+    bool writeBytes(const std::filesystem::path& path, const std::vector<uint8_t>& bytes) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return static_cast<bool>(file);
+    }
+
+    bool readBytes(const std::filesystem::path& path, std::vector<uint8_t>& outBytes) {
+        std::ifstream file(path, std::ios::binary);
+        outBytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return static_cast<bool>(file) || file.eof();
+    }
+
+    // Decodes a copy of the block that is exactly its size into dstSize bytes followed by guard bytes, so a
+    // decoder writing past the output shows up as a changed guard (and one reading past the input under ASan)
+    bool decodeGuarded(const std::vector<uint8_t>& block, size_t blockSize, size_t dstSize,
+                       std::vector<uint8_t>& outData, bool& outGuardIntact) {
+        const std::vector<uint8_t> input(block.begin(), block.begin() + blockSize);
+        std::vector<uint8_t> output(dstSize + 64, 0xA5);
+        const bool decoded = lz4Decompress(input.data(), input.size(), output.data(), dstSize);
+        outGuardIntact = std::all_of(output.begin() + dstSize, output.end(), [](uint8_t b) { return b == 0xA5; });
+        outData.assign(output.begin(), output.begin() + dstSize);
+        return decoded;
+    }
+
+    void checkLz4(const std::function<void(bool, const std::string&)>& expect) {
+        struct Input {
+            std::string name;
+            std::vector<uint8_t> data;
+            size_t maxCompressedSize; // 0: anything up to lz4CompressBound
+        };
+        std::vector<Input> inputs;
+        inputs.push_back({"empty", {}, 1});
+        inputs.push_back({"one byte", {42}, 2});
+        inputs.push_back({"13 zeros", std::vector<uint8_t>(13, 0), 0}); // Just past the shortest matchable block
+        inputs.push_back({"incompressible", makeRandomBytes(100000, 1), 0});
+        inputs.push_back({"zeros", std::vector<uint8_t>(1 << 20, 0), (1 << 20) / 200});
+        std::vector<uint8_t> text;
+        const char* words[] = {"vertex ", "index ", "normal ", "meshlet ", "cache "};
+        for (uint32_t seed = 3; text.size() < 200000;) {
+            const char* word = words[nextRandom(seed) % 5];
+            text.insert(text.end(), word, word + strlen(word));
+        }
+        inputs.push_back({"words", text, text.size() / 2});
+        // Repeats 80 KiB apart only, out of reach of the 64 KiB window, so they must go out as literals
+        std::vector<uint8_t> farRepeat = makeRandomBytes(80 * 1024, 5);
+        farRepeat.insert(farRepeat.end(), farRepeat.begin(), farRepeat.end());
+        inputs.push_back({"repeat beyond the window", farRepeat, 0});
+        // Period-3 runs with random bytes scattered in, over more than one window
+        std::vector<uint8_t> runs(300000);
+        uint32_t seed = 9;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            runs[i] = nextRandom(seed) % 64 == 0 ? static_cast<uint8_t>(nextRandom(seed)) : uint8_t(i % 3);
+        }
+        inputs.push_back({"runs", runs, runs.size() / 4});
+
+        for (const Input& input : inputs) {
+            const std::string what = "lz4 " + input.name + ": ";
+            const size_t size = input.data.size();
+            std::vector<uint8_t> block(lz4CompressBound(size));
+            const size_t blockSize = lz4Compress(input.data.data(), size, block.data(), block.size());
+            expect(blockSize > 0 && blockSize <= lz4CompressBound(size), what + "compressed to " +
+                   std::to_string(blockSize) + " bytes");
+            if (blockSize == 0) {
+                continue;
+            }
+            expect(input.maxCompressedSize == 0 || blockSize <= input.maxCompressedSize,
+                   what + std::to_string(blockSize) + " bytes, expected at most " +
+                   std::to_string(input.maxCompressedSize));
+            std::vector<uint8_t> small(blockSize - 1);
+            expect(lz4Compress(input.data.data(), size, small.data(), small.size()) == 0,
+                   what + "claims to fit a buffer one byte too small");
+
+            std::vector<uint8_t> decoded;
+            bool guardIntact = false;
+            expect(decodeGuarded(block, blockSize, size, decoded, guardIntact) && guardIntact &&
+                   decoded == input.data, what + "round trip differs");
+            expect(!decodeGuarded(block, blockSize, size + 1, decoded, guardIntact) && guardIntact,
+                   what + "decoded into a larger output");
+            if (size > 0) {
+                expect(!decodeGuarded(block, blockSize, size - 1, decoded, guardIntact) && guardIntact,
+                       what + "decoded into a smaller output");
+            }
+
+            // Every truncation fails (large blocks: a spread of cut points), without touching the guard
+            const size_t step = std::max<size_t>(1, blockSize / 997);
+            bool truncationsRejected = true;
+            for (size_t cut = 0; cut < blockSize; cut += (cut < 64 ? 1 : step)) {
+                truncationsRejected = truncationsRejected && !decodeGuarded(block, cut, size, decoded, guardIntact) &&
+                                      guardIntact;
+            }
+            expect(truncationsRejected, what + "a truncated block decoded or overran the output");
+
+            // Damaged bytes may decode to garbage, but never outside the output
+            bool guardsIntact = true;
+            uint32_t damageSeed = 17;
+            for (int i = 0; i < 200; ++i) {
+                std::vector<uint8_t> damaged(block.begin(), block.begin() + blockSize);
+                damaged[nextRandom(damageSeed) % blockSize] ^= static_cast<uint8_t>(1 + nextRandom(damageSeed) % 255);
+                decodeGuarded(damaged, blockSize, size, decoded, guardIntact);
+                guardsIntact = guardsIntact && guardIntact;
+            }
+            expect(guardsIntact, what + "a damaged block wrote past the output");
+        }
+
+        // Hand-made malformed blocks
+        const std::pair<const char*, std::vector<uint8_t>> malformed[] = {
+            {"match before the output start", {0x10, 'a', 0x02, 0x00}},
+            {"zero offset", {0x10, 'a', 0x00, 0x00}},
+            {"literal length past the input", {0xF0, 0xFF, 0xFF}},
+            {"literals past the input", {0x50, 'a', 'b'}},
+            {"empty block", {}},
+        };
+        for (const auto& [name, block] : malformed) {
+            std::vector<uint8_t> decoded;
+            bool guardIntact = false;
+            expect(!decodeGuarded(block, block.size(), 16, decoded, guardIntact) && guardIntact,
+                   std::string("lz4 accepted a block with ") + name);
+        }
+    }
+
+    int check(const std::filesystem::path& directory) {
+        int failures = 0;
+        auto expect = [&](bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        };
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            std::cerr << "Cannot create " << directory.string() << std::endl;
+            return 1;
+        }
+
+        checkLz4(expect);
+
+        // Entries around the alignment, stored and compressed, and enough small ones for a real binary search
+        std::vector<std::pair<std::string, std::vector<uint8_t>>> files = {
+            {"empty.bin", {}},
+            {"one.bin", {7}},
+            {"page.bin", makeRandomBytes(4096, 21)},
+            {"page-plus-one.bin", std::vector<uint8_t>(4097, 'x')},
+            {"meshes/zeros.bin", std::vector<uint8_t>(300000, 0)},
+            {"meshes/random.bin", makeRandomBytes(100000, 22)},
+        };
+        for (int i = 0; i < 40; ++i) {
+            const std::string name = "shaders/file" + std::to_string(i * 7 % 40) + ".hlsl";
+            const std::string text = "// " + name + "\n";
+            files.push_back({name, std::vector<uint8_t>(text.begin(), text.end())});
+        }
+        const std::string packPath = (directory / "check.pack").string();
+        {
+            PackWriter writer;
+            bool added = writer.open(packPath);
+            for (const auto& [path, data] : files) {
+                added = added && writer.add(path, data.data(), data.size(), true);
+            }
+            expect(added, "pack entries not added");
+            expect(!writer.add("./meshes\\zeros.bin", "x", 1, true), "pack took the same path twice");
+            expect(writer.finish(), "pack not written");
+        }
+
+        PackFile pack;
+        expect(pack.open(packPath) && pack.getEntryCount() == files.size(), "pack does not open with every entry");
+        std::string error;
+        expect(pack.verify(&error), "pack verify: " + error);
+        for (const auto& [path, data] : files) {
+            const PackEntry* entry = pack.find(path);
+            if (!entry) {
+                expect(false, "pack lookup missed " + path);
+                continue;
+            }
+            expect(pack.getEntryPath(*entry) == path, "pack lookup of " + path + " found another entry");
+            expect(entry->offset % kPackEntryAlignment == 0, path + " not aligned to the entry alignment");
+            std::vector<uint8_t> contents;
+            expect(pack.read(*entry, contents) && contents == data, path + " reads back different contents");
+            const uint8_t* stored = pack.getStoredData(*entry);
+            if (!(entry->flags & kPackEntryCompressed)) {
+                expect(stored && reinterpret_cast<uintptr_t>(stored) % kPackEntryAlignment == 0 &&
+                       std::equal(data.begin(), data.end(), stored), path + " has no aligned in-place view");
+            }
+        }
+        const PackEntry* zeros = pack.find("meshes/zeros.bin");
+        const PackEntry* random = pack.find("meshes/random.bin");
+        expect(zeros && (zeros->flags & kPackEntryCompressed) && zeros->storedSize < 4096,
+               "repetitive entry not compressed");
+        expect(random && !(random->flags & kPackEntryCompressed), "incompressible entry compressed");
+        const PackEntry zerosEntry = zeros ? *zeros : PackEntry{};
+        const PackEntry randomEntry = random ? *random : PackEntry{};
+
+        // Lookups: other spellings of a path hit, neighbours of it in the sorted table miss
+        expect(pack.find("./meshes/../meshes\\zeros.bin") == zeros, "lookup does not normalize the path");
+        for (const char* miss : {"", "a", "zzz", "meshes", "meshes/zeros.bi", "meshes/zeros.bin2", "shaders/file",
+                                 "shaders/file40.hlsl", "Empty.bin"}) {
+            expect(pack.find(miss) == nullptr, std::string("lookup of \"") + miss + "\" hit an entry");
+        }
+
+        // Mounted: stored entries are views into the mapping, compressed ones decoded, anything else is loose
+        const std::filesystem::path loosePath = directory / "loose.txt";
+        const std::vector<uint8_t> looseBytes = {'l', 'o', 'o', 's', 'e'};
+        expect(writeBytes(loosePath, looseBytes) && writeBytes(directory / "loose-empty.txt", {}),
+               "loose files not written");
+        {
+            VirtualFileSystem fileSystem;
+            expect(fileSystem.mount(packPath), "pack does not mount");
+            VirtualFile first;
+            VirtualFile second;
+            expect(fileSystem.open("meshes/random.bin", first) && fileSystem.open("meshes/random.bin", second) &&
+                   first.isPacked() && first.data() == second.data() &&
+                   reinterpret_cast<uintptr_t>(first.data()) % kPackEntryAlignment == 0 &&
+                   first.size() == 100000 && first.getContentHash() == hash64(first.data(), first.size()),
+                   "stored entry is not an aligned view shared by every open");
+            VirtualFile compressed;
+            expect(fileSystem.open("meshes/zeros.bin", compressed) && compressed.isPacked() &&
+                   compressed.size() == 300000 &&
+                   std::all_of(compressed.data(), compressed.data() + compressed.size(),
+                               [](uint8_t b) { return b == 0; }), "compressed entry decodes differently");
+            VirtualFile empty;
+            expect(fileSystem.open("empty.bin", empty) && empty.isPacked() && empty.size() == 0,
+                   "empty entry does not open");
+
+            VirtualFile loose;
+            expect(fileSystem.open(loosePath.string(), loose) && !loose.isPacked() &&
+                   std::equal(looseBytes.begin(), looseBytes.end(), loose.data(), loose.data() + loose.size()),
+                   "loose file not found next to the pack");
+            VirtualFile looseEmpty;
+            expect(fileSystem.open((directory / "loose-empty.txt").string(), looseEmpty) && looseEmpty.size() == 0,
+                   "empty loose file does not open");
+            VirtualFile missing;
+            expect(!fileSystem.open((directory / "missing.txt").string(), missing) &&
+                   !fileSystem.exists((directory / "missing.txt").string()), "missing file opens");
+
+            // A pack mounted later shadows the earlier one; without loose files only packs are searched
+            const std::string overridePath = (directory / "override.pack").string();
+            PackWriter writer;
+            expect(writer.open(overridePath) && writer.add("one.bin", "new", 3, false) && writer.finish(),
+                   "override pack not written");
+            expect(fileSystem.mount(overridePath), "override pack does not mount");
+            VirtualFile shadowed;
+            expect(fileSystem.open("one.bin", shadowed) && shadowed.size() == 3, "later pack does not shadow");
+            fileSystem.setLooseFilesEnabled(false);
+            expect(!fileSystem.open(loosePath.string(), loose) && !fileSystem.exists(loosePath.string()),
+                   "loose file opens with loose files disabled");
+            expect(fileSystem.open("page.bin", loose), "packed file does not open with loose files disabled");
+        }
+        pack.close();
+
+        // Damaged packs: truncated or with a changed table never open; changed entry data fails verification
+        std::vector<uint8_t> packBytes;
+        expect(readBytes(packPath, packBytes) && packBytes.size() > sizeof(PackHeader), "pack not read back");
+        PackHeader header = {};
+        memcpy(&header, packBytes.data(), sizeof(header));
+        const std::string damagedPath = (directory / "damaged.pack").string();
+        auto opensDamaged = [&](const std::vector<uint8_t>& bytes) {
+            PackFile damaged;
+            return writeBytes(damagedPath, bytes) && damaged.open(damagedPath);
+        };
+        for (uint64_t size : {uint64_t(0), uint64_t(sizeof(PackHeader) - 1), uint64_t(sizeof(PackHeader)),
+                              header.tocOffset, header.stringsOffset, uint64_t(packBytes.size() - 1)}) {
+            std::vector<uint8_t> truncated(packBytes.begin(), packBytes.begin() + size);
+            expect(!opensDamaged(truncated), "pack truncated to " + std::to_string(size) + " bytes opens");
+        }
+        std::vector<uint8_t> damaged = packBytes;
+        damaged[0] ^= 1;
+        expect(!opensDamaged(damaged), "pack with a bad magic opens");
+        damaged = packBytes;
+        damaged[header.tocOffset + offsetof(PackEntry, size)] ^= 1;
+        expect(!opensDamaged(damaged), "pack with a changed table opens");
+        damaged = packBytes;
+        damaged[header.stringsOffset] ^= 1;
+        expect(!opensDamaged(damaged), "pack with a changed path opens");
+
+        if (random && zeros) {
+            damaged = packBytes;
+            damaged[randomEntry.offset + 500] ^= 1;
+            PackFile damagedPack;
+            expect(writeBytes(damagedPath, damaged) && damagedPack.open(damagedPath) && !damagedPack.verify(),
+                   "changed stored entry passes verification");
+            damagedPack.close();
+            damaged = packBytes;
+            std::fill(damaged.begin() + zerosEntry.offset, damaged.begin() + zerosEntry.offset + zerosEntry.storedSize,
+                      0xFF);
+            expect(writeBytes(damagedPath, damaged) && damagedPack.open(damagedPath) && !damagedPack.verify(),
+                   "corrupt compressed entry passes verification");
+            damagedPack.close();
+            VirtualFileSystem fileSystem;
+            VirtualFile file;
+            expect(fileSystem.mount(damagedPath) && !fileSystem.open("meshes/zeros.bin", file),
+                   "corrupt compressed entry opens");
+        }
+
+        if (failures == 0) {
+            std::cout << "All pack checks passed" << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && argc <= 3 && strcmp(argv[1], "check") == 0) {
+        return check(argc == 3 ? std::filesystem::path(argv[2])
+                               : std::filesystem::temp_directory_path() / "assetpack-check");
+    }
+    if (argc < 3) {
+        printUsage();
+        return 2;
+    }
+    if (strcmp(argv[1], "create") == 0) {
+        return createPack(argc, argv);
+    }
+    if (strcmp(argv[1], "list") == 0) {
+        return listPack(argv[2]);
+    }
+    if (strcmp(argv[1], "verify") == 0) {
+        return verifyPack(argv[2]);
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        return benchmarkPack(argc, argv);
+    }
+    printUsage();
+    return 2;
+}
@@ -0,0 +1,386 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asset/BlockCompression.hpp"
+#include "asset/TextureImport.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: bctool check\n"
+            "       bctool bench [--size <n>] [--runs <n>] [-j <threads>]\n"
+            "       bctool psnr <image>...\n"
+            "\n"
+            "check: round trips synthetic images (gradients, noise, a photo-like mix, alpha, normals) through\n"
+            "       every format and quality and checks the PSNR against fixed thresholds, plus exact constant\n"
+            "       blocks, partial edge blocks and identical serial and parallel output\n"
+            "bench: best-of-n encoding throughput of a <n> x <n> texture (default: 1024) per format and quality,\n"
+            "       on one thread and on the job system\n"
+            "psnr:  the PSNR of each format and quality on real images\n";
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const char* getFormatName(TextureFormat format) {
+        switch (format) {
+            case TextureFormat::Rgba8:
+                return "rgba8";
+            case TextureFormat::Bc1:
+                return "bc1";
+            case TextureFormat::Bc3:
+                return "bc3";
+            case TextureFormat::Bc5:
+                return "bc5";
+            case TextureFormat::Bc7:
+                return "bc7";
+        }
+        return "?";
+    }
+
+    const char* getQualityName(BlockQuality quality) {
+        switch (quality) {
+            case BlockQuality::Fast:
+                return "fast";
+            case BlockQuality::Normal:
+                return "normal";
+            case BlockQuality::High:
+                return "high";
+        }
+        return "?";
+    }
+
+    constexpr TextureFormat kFormats[] = {TextureFormat::Bc1, TextureFormat::Bc3, TextureFormat::Bc5,
+                                          TextureFormat::Bc7};
+    constexpr BlockQuality kQualities[] = {BlockQuality::Fast, BlockQuality::Normal, BlockQuality::High};
+
+    // Deterministic noise, so failures reproduce
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    struct TestImage {
+        std::string name;
+        uint32_t width;
+        uint32_t height;
+        std::vector<uint8_t> pixels;
+    };
+
+    template <typename Texel>
+    TestImage makeImage(const std::string& name, uint32_t width, uint32_t height, Texel texel) {
+        TestImage image = {name, width, height, std::vector<uint8_t>(size_t(width) * height * 4)};
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                texel(x, y, &image.pixels[(size_t(y) * width + x) * 4]);
+            }
+        }
+        return image;
+    }
+
+    uint8_t toUnorm(double value) {
+        return static_cast<uint8_t>(std::clamp(value, 0.0, 1.0) * 255.0 + 0.5);
+    }
+
+    std::vector<TestImage> makeTestImages() {
+        std::vector<TestImage> images;
+        images.push_back(makeImage("gradient", 128, 128, [](uint32_t x, uint32_t y, uint8_t* texel) {
+            texel[0] = static_cast<uint8_t>(x * 2);
+            texel[1] = static_cast<uint8_t>(y * 2);
+            texel[2] = static_cast<uint8_t>(255 - x - y);
+            texel[3] = 255;
+        }));
+        uint32_t seed = 17;
+        images.push_back(makeImage("noise", 64, 64, [&](uint32_t, uint32_t, uint8_t* texel) {
+            for (int c = 0; c < 3; c++) {
+                texel[c] = static_cast<uint8_t>(nextRandom(seed));
+            }
+            texel[3] = 255;
+        }));
+        // Smooth features of several scales, hue changes and a little grain, like a photograph or albedo map
+        images.push_back(makeImage("photo", 128, 128, [&](uint32_t x, uint32_t y, uint8_t* texel) {
+            const double u = x / 128.0;
+            const double v = y / 128.0;
+            const double grain = (nextRandom(seed) % 9) / 255.0 - 4.0 / 255.0;
+            texel[0] = toUnorm(0.5 + 0.3 * std::sin(u * 9.0 + v * 3.0) + 0.1 * std::sin(u * 40.0) + grain);
+            texel[1] = toUnorm(0.4 + 0.3 * std::cos(v * 7.0 - u * 2.0) + grain);
+            texel[2] = toUnorm(0.3 + 0.2 * std::sin((u + v) * 15.0) * std::cos(u * 5.0) + grain);
+            texel[3] = 255;
+        }));
+        images.push_back(makeImage("alpha", 128, 128, [](uint32_t x, uint32_t y, uint8_t* texel) {
+            texel[0] = static_cast<uint8_t>(x * 2);
+            texel[1] = 128;
+            texel[2] = static_cast<uint8_t>(y * 2);
+            texel[3] = static_cast<uint8_t>((x / 16 + y / 16) % 2 ? 255 : (x + y)); // Cut-out and smooth alpha
+        }));
+        // Tangent-space normals of a bumpy surface, for BC5
+        images.push_back(makeImage("normals", 128, 128, [](uint32_t x, uint32_t y, uint8_t* texel) {
+            const double dx = 0.6 * std::cos(x * 0.2) * std::sin(y * 0.13);
+            const double dy = 0.6 * std::sin(x * 0.2) * std::cos(y * 0.13);
+            const double length = std::sqrt(dx * dx + dy * dy + 1.0);
+            texel[0] = toUnorm(dx / length * 0.5 + 0.5);
+            texel[1] = toUnorm(dy / length * 0.5 + 0.5);
+            texel[2] = toUnorm(0.5 / length + 0.5);
+            texel[3] = 255;
+        }));
+        return images;
+    }
+
+    // PSNR of the channels the format stores: RGB for BC1, RGBA for BC3 and BC7, RG for BC5
+    double computePsnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, TextureFormat format) {
+        const int channelCount = format == TextureFormat::Bc1 ? 3 : (format == TextureFormat::Bc5 ? 2 : 4);
+        double sum = 0.0;
+        size_t count = 0;
+        for (size_t i = 0; i < a.size(); i += 4) {
+            for (int c = 0; c < channelCount; c++) {
+                const double d = double(a[i + c]) - b[i + c];
+                sum += d * d;
+                ++count;
+            }
+        }
+        if (sum == 0.0) {
+            return 99.0;
+        }
+        return 10.0 * std::log10(255.0 * 255.0 * count / sum);
+    }
+
+    double roundTrip(const std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, TextureFormat format,
+                     BlockQuality quality, JobSystem* jobSystem = nullptr) {
+        std::vector<uint8_t> blocks(getTextureLevelSize(format, width, height));
+        compressImage(pixels.data(), width, height, format, quality, blocks.data(), jobSystem);
+        std::vector<uint8_t> decoded(pixels.size());
+        decompressImage(blocks.data(), width, height, format, decoded.data());
+        return computePsnr(pixels, decoded, format);
+    }
+
+    // Lowest acceptable PSNR of each format and quality on each test image, with about 1 dB of margin
+    struct PsnrThreshold {
+        const char* image;
+        TextureFormat format;
+        double minimum[3]; // Fast, Normal, High
+    };
+
+    constexpr PsnrThreshold kThresholds[] = {
+        {"gradient", TextureFormat::Bc1, {40.5, 41.5, 41.5}},
+        {"gradient", TextureFormat::Bc7, {42.5, 46.0, 49.0}},
+        {"noise", TextureFormat::Bc1, {11.5, 12.5, 12.5}},
+        {"noise", TextureFormat::Bc7, {13.0, 14.0, 17.0}},
+        {"photo", TextureFormat::Bc1, {34.0, 36.0, 36.0}},
+        {"photo", TextureFormat::Bc7, {36.5, 39.5, 42.5}},
+        {"alpha", TextureFormat::Bc3, {42.0, 42.0, 42.0}},
+        {"alpha", TextureFormat::Bc7, {45.5, 45.5, 47.0}},
+        {"normals", TextureFormat::Bc5, {46.0, 46.0, 47.5}},
+    };
+
+    int check() {
+        int failures = 0;
+        auto expect = [&](bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        };
+
+        // Sizes of levels padded to whole blocks
+        expect(getBlockSize(TextureFormat::Bc1) == 8 && getBlockSize(TextureFormat::Bc7) == 16 &&
+               getBlockSize(TextureFormat::Rgba8) == 4, "block sizes");
+        expect(getTextureRowPitch(TextureFormat::Bc1, 5) == 16 && getTextureRowCount(TextureFormat::Bc1, 5) == 2 &&
+               getTextureRowPitch(TextureFormat::Rgba8, 5) == 20 && getTextureRowCount(TextureFormat::Rgba8, 5) == 5,
+               "row pitches");
+        // 8x8, 4x4, 2x2 and 1x1: the last two still take a whole block each
+        expect(getTextureChainSize(TextureFormat::Bc3, 8, 8, 4) == (4 + 1 + 1 + 1) * 16 &&
+               getTextureLevelOffset(TextureFormat::Bc3, 8, 8, 2) == 5 * 16, "chain sizes");
+
+        // Constant blocks, e.g. flat albedo, come back exactly, except for the rounding of the 565 interpolants
+        // in BC1/BC3 and of mode 6's p-bit, which every channel of a BC7 endpoint shares
+        uint32_t seed = 5;
+        for (int test = 0; test < 200; test++) {
+            const uint32_t color = nextRandom(seed);
+            std::vector<uint8_t> pixels;
+            for (int i = 0; i < 16; i++) {
+                pixels.insert(pixels.end(), {uint8_t(color), uint8_t(color >> 8), uint8_t(color >> 16),
+                                             uint8_t(test < 100 ? 255 : color >> 4)});
+            }
+            for (TextureFormat format : kFormats) {
+                for (BlockQuality quality : kQualities) {
+                    std::vector<uint8_t> blocks(getBlockSize(format));
+                    std::vector<uint8_t> decoded(64);
+                    compressImage(pixels.data(), 4, 4, format, quality, blocks.data());
+                    decompressImage(blocks.data(), 4, 4, format, decoded.data());
+                    int maxError = 0;
+                    for (int c = 0; c < 4; c++) {
+                        const bool stored = format == TextureFormat::Bc5 ? c < 2 :
+                                                (format != TextureFormat::Bc1 || c < 3);
+                        if (stored) {
+                            maxError = std::max(maxError, std::abs(decoded[c] - pixels[c]));
+                        }
+                    }
+                    const int tolerance = format == TextureFormat::Bc5 ? 0 : (format == TextureFormat::Bc7 ? 1 : 2);
+                    expect(maxError <= tolerance, std::string(getFormatName(format)) + " " +
+                                                      getQualityName(quality) + ": constant block off by " +
+                                                      std::to_string(maxError));
+                }
+            }
+        }
+
+        // PSNR of every format and quality on the synthetic images
+        const std::vector<TestImage> images = makeTestImages();
+        for (const PsnrThreshold& threshold : kThresholds) {
+            const auto image = std::find_if(images.begin(), images.end(), [&](const TestImage& candidate) {
+                return candidate.name == threshold.image;
+            });
+            double previous = 0.0;
+            for (BlockQuality quality : kQualities) {
+                const double psnr = roundTrip(image->pixels, image->width, image->height, threshold.format, quality);
+                const std::string what = std::string(threshold.image) + " " + getFormatName(threshold.format) + " " +
+                                         getQualityName(quality);
+                expect(psnr >= threshold.minimum[static_cast<int>(quality)],
+                       what + ": PSNR " + std::to_string(psnr) + " dB");
+                expect(psnr >= previous - 0.05, what + ": worse than the lower quality");
+                previous = psnr;
+            }
+        }
+
+        // Images whose size is not a multiple of 4 repeat their edge texels into the partial blocks
+        for (TextureFormat format : kFormats) {
+            const TestImage& photo = images[2];
+            std::vector<uint8_t> cropped;
+            for (uint32_t y = 0; y < 13; y++) {
+                const uint8_t* row = &photo.pixels[size_t(y) * photo.width * 4];
+                cropped.insert(cropped.end(), row, row + 7 * 4);
+            }
+            expect(roundTrip(cropped, 7, 13, format, BlockQuality::Normal) >= 30.0,
+                   std::string(getFormatName(format)) + ": partial blocks");
+        }
+
+        // The job system produces the same bytes as a single thread
+        JobSystem jobSystem;
+        for (TextureFormat format : kFormats) {
+            const TestImage& photo = images[2];
+            std::vector<uint8_t> serial(getTextureLevelSize(format, photo.width, photo.height));
+            std::vector<uint8_t> parallel(serial.size());
+            compressImage(photo.pixels.data(), photo.width, photo.height, format, BlockQuality::High, serial.data());
+            compressImage(photo.pixels.data(), photo.width, photo.height, format, BlockQuality::High,
+                          parallel.data(), &jobSystem);
+            expect(serial == parallel, std::string(getFormatName(format)) + ": parallel output differs");
+        }
+
+        // A whole chain compresses level by level, down to the 1x1 level in a block of its own
+        TextureImage texture;
+        texture.width = images[0].width;
+        texture.height = images[0].height;
+        texture.pixels = images[0].pixels;
+        generateMips(texture, MipOptions());
+        compressTexture(texture, TextureFormat::Bc1, BlockQuality::Normal, &jobSystem);
+        expect(texture.format == TextureFormat::Bc1 &&
+               texture.pixels.size() == getTextureChainSize(TextureFormat::Bc1, 128, 128, texture.mipCount),
+               "compressed chain size");
+
+        if (failures == 0) {
+            std::cout << "All block compression checks passed" << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    int benchmark(int argc, char** argv) {
+        uint32_t size = 1024;
+        int runs = 3;
+        unsigned threadCount = 0;
+        for (int i = 2; i < argc; ++i) {
+            const bool hasValue = i + 1 < argc;
+            if (strcmp(argv[i], "--size") == 0 && hasValue) {
+                size = static_cast<uint32_t>(std::max(4, atoi(argv[++i])));
+            } else if (strcmp(argv[i], "--runs") == 0 && hasValue) {
+                runs = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(argv[i], "-j") == 0 && hasValue) {
+                threadCount = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+
+        // The photo-like test image, tiled: encoders take longer on detail than on flat areas
+        const TestImage tile = makeTestImages()[2];
+        std::vector<uint8_t> pixels(size_t(size) * size * 4);
+        for (uint32_t y = 0; y < size; y++) {
+            for (uint32_t x = 0; x < size; x++) {
+                memcpy(&pixels[(size_t(y) * size + x) * 4],
+                       &tile.pixels[(size_t(y % tile.height) * tile.width + x % tile.width) * 4], 4);
+            }
+        }
+        auto jobSystem = std::make_unique<JobSystem>(threadCount > 0 ? threadCount - 1 : 0);
+        const double texels = double(size) * size;
+        printf("%u x %u, %u threads\n", size, size, jobSystem->getThreadCount());
+        for (TextureFormat format : kFormats) {
+            std::vector<uint8_t> blocks(getTextureLevelSize(format, size, size));
+            for (BlockQuality quality : kQualities) {
+                double serialBest = 1e30;
+                double parallelBest = 1e30;
+                for (int run = 0; run < runs; ++run) {
+                    auto start = std::chrono::steady_clock::now();
+                    compressImage(pixels.data(), size, size, format, quality, blocks.data());
+                    serialBest = std::min(serialBest, millisecondsSince(start));
+
+                    start = std::chrono::steady_clock::now();
+                    compressImage(pixels.data(), size, size, format, quality, blocks.data(), jobSystem.get());
+                    parallelBest = std::min(parallelBest, millisecondsSince(start));
+                }
+                printf("  %-3s %-6s 1 thread %9.2f ms (%7.2f Mtexel/s)   jobs %9.2f ms (%7.2f Mtexel/s, %.1fx)\n",
+                       getFormatName(format), getQualityName(quality), serialBest, texels / serialBest / 1e3,
+                       parallelBest, texels / parallelBest / 1e3, serialBest / parallelBest);
+            }
+        }
+        return 0;
+    }
+
+    int printPsnr(int argc, char** argv) {
+        TextureImportOptions options;
+        options.generateMips = false;
+        options.compression = TextureCompression::None;
+        JobSystem jobSystem;
+        for (int i = 2; i < argc; ++i) {
+            TextureImage image;
+            try {
+                image = importTextureFile(argv[i], options);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+            printf("%s (%u x %u)\n", argv[i], image.width, image.height);
+            for (TextureFormat format : kFormats) {
+                printf("  %-3s", getFormatName(format));
+                for (BlockQuality quality : kQualities) {
+                    printf("  %s %6.2f dB", getQualityName(quality),
+                           roundTrip(image.pixels, image.width, image.height, format, quality, &jobSystem));
+                }
+                printf("\n");
+            }
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "check") == 0 && argc == 2) {
+        return check();
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc, argv);
+    }
+    if (argc >= 3 && strcmp(argv[1], "psnr") == 0) {
+        return printPsnr(argc, argv);
+    }
+    printUsage();
+    return 2;
+}
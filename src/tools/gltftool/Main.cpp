@@ -0,0 +1,648 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "asset/GltfImport.hpp"
+#include "asset/MeshImport.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: gltftool convert <mesh.obj> <output.glb>\n"
+            "       gltftool info <file.glb | file.gltf>\n"
+            "       gltftool bench <mesh.obj> <mesh.glb> [--runs <n>]\n"
+            "       gltftool corpus <directory>\n"
+            "       gltftool check <directory>\n"
+            "\n"
+            "convert: imports the OBJ (LOD0 only) and writes it as a .glb in the Vertex layout, which loads\n"
+            "         without repacking\n"
+            "bench:   best-of-n load times of the same mesh as OBJ (full import, and parse + dedup only) and as\n"
+            "         glTF; each load also copies the vertices and indices once, as the upload does\n"
+            "corpus:  writes glTF files covering the supported layouts (interleaved, separate and quantized\n"
+            "         attributes, 8/16/32-bit and missing indices, external buffers, node hierarchies) and\n"
+            "         invalid files; check loads them and compares the result with the expected geometry\n";
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // --- Test corpus ---
+
+    constexpr int kUnsignedByte = 5121;
+    constexpr int kUnsignedShort = 5123;
+    constexpr int kUnsignedInt = 5125;
+    constexpr int kFloat = 5126;
+
+    // Unit cube, 4 vertices and 2 counter-clockwise triangles per face; colors are multiples of 1/255 so
+    // the 8-bit normalized variant is exact
+    void makeCube(std::vector<Vertex>& outVertices, std::vector<uint32_t>& outIndices) {
+        const glm::vec3 axes[6][3] = {
+            {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}}, {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+            {{0, 1, 0}, {0, 0, 1}, {1, 0, 0}}, {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+            {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}}, {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}},
+        };
+        const float corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+        outVertices.clear();
+        outIndices.clear();
+        for (uint32_t face = 0; face < 6; ++face) {
+            const uint32_t first = static_cast<uint32_t>(outVertices.size());
+            for (const auto& corner : corners) {
+                Vertex vertex;
+                vertex.position = axes[face][0] + axes[face][1] * corner[0] + axes[face][2] * corner[1];
+                vertex.normal = axes[face][0];
+                vertex.texCoord = glm::vec2((corner[0] + 1) * 0.5f, (corner[1] + 1) * 0.5f);
+                vertex.color = glm::vec4(face * 40 / 255.0f, 128 / 255.0f, 1.0f, 1.0f);
+                outVertices.push_back(vertex);
+            }
+            outIndices.insert(outIndices.end(), {first, first + 1, first + 2, first, first + 2, first + 3});
+        }
+    }
+
+    // Minimal glTF writer for the corpus: accumulates buffer views and accessors over one binary buffer
+    class GltfBuilder {
+    public:
+        // Appends the data as a buffer view, aligned to 4 bytes; returns its index
+        int addView(const void* data, size_t size, size_t stride = 0) {
+            m_binary.resize((m_binary.size() + 3) & ~size_t(3));
+            m_views += m_views.empty() ? "" : ",";
+            m_views += "{\"buffer\":0,\"byteOffset\":" + std::to_string(m_binary.size()) + ",\"byteLength\":" +
+                       std::to_string(size) + (stride ? ",\"byteStride\":" + std::to_string(stride) : "") + "}";
+            const uint8_t* bytes = static_cast<const uint8_t*>(data);
+            m_binary.insert(m_binary.end(), bytes, bytes + size);
+            return m_viewCount++;
+        }
+
+        int addAccessor(int view, size_t offset, int componentType, size_t count, const char* type,
+                        bool normalized = false, const std::string& extra = "") {
+            m_accessors += m_accessors.empty() ? "" : ",";
+            m_accessors += "{\"bufferView\":" + std::to_string(view) + ",\"byteOffset\":" + std::to_string(offset) +
+                           ",\"componentType\":" + std::to_string(componentType) + ",\"count\":" +
+                           std::to_string(count) + ",\"type\":\"" + type + "\"" +
+                           (normalized ? ",\"normalized\":true" : "") + extra + "}";
+            return m_accessorCount++;
+        }
+
+        // Writes a .glb, or a .gltf with the binary buffer in binaryName next to it. body holds the
+        // top-level members other than asset, buffers, bufferViews and accessors.
+        bool write(const std::filesystem::path& path, const std::string& body, const char* binaryName = nullptr) {
+            m_binary.resize((m_binary.size() + 3) & ~size_t(3));
+            std::string json = "{\"asset\":{\"version\":\"2.0\"},\"buffers\":[{\"byteLength\":" +
+                               std::to_string(m_binary.size()) +
+                               (binaryName ? std::string(",\"uri\":\"") + binaryName + "\"" : "") +
+                               "}],\"bufferViews\":[" + m_views + "],\"accessors\":[" + m_accessors + "]," + body +
+                               "}";
+            if (binaryName) {
+                return writeFile(path, json.data(), json.size()) &&
+                       writeFile(path.parent_path() / binaryName, m_binary.data(), m_binary.size());
+            }
+            json.resize((json.size() + 3) & ~size_t(3), ' ');
+            const uint32_t header[5] = {0x46546C67, 2, static_cast<uint32_t>(28 + json.size() + m_binary.size()),
+                                        static_cast<uint32_t>(json.size()), 0x4E4F534A};
+            const uint32_t binaryHeader[2] = {static_cast<uint32_t>(m_binary.size()), 0x004E4942};
+            std::vector<uint8_t> file(reinterpret_cast<const uint8_t*>(header),
+                                      reinterpret_cast<const uint8_t*>(header) + sizeof(header));
+            file.insert(file.end(), json.begin(), json.end());
+            file.insert(file.end(), reinterpret_cast<const uint8_t*>(binaryHeader),
+                        reinterpret_cast<const uint8_t*>(binaryHeader) + sizeof(binaryHeader));
+            file.insert(file.end(), m_binary.begin(), m_binary.end());
+            return writeFile(path, file.data(), file.size());
+        }
+
+    private:
+        static bool writeFile(const std::filesystem::path& path, const void* data, size_t size) {
+            FILE* file = fopen(path.string().c_str(), "wb");
+            if (!file) {
+                return false;
+            }
+            const bool ok = fwrite(data, 1, size, file) == size;
+            return fclose(file) == 0 && ok;
+        }
+
+        std::vector<uint8_t> m_binary;
+        std::string m_views;
+        std::string m_accessors;
+        int m_viewCount = 0;
+        int m_accessorCount = 0;
+    };
+
+    const char* kCubeMinMax = ",\"min\":[-1,-1,-1],\"max\":[1,1,1]";
+
+    template <typename T>
+    std::vector<T> narrow(const std::vector<uint32_t>& indices) {
+        return std::vector<T>(indices.begin(), indices.end());
+    }
+
+    // Adds the cube's attributes as separate, tightly packed float accessors; returns the POSITION accessor
+    // (NORMAL and TEXCOORD_0 follow it)
+    int addSeparateAttributes(GltfBuilder& builder, const std::vector<Vertex>& vertices) {
+        std::vector<glm::vec3> positions;
+        std::vector<glm::vec3> normals;
+        std::vector<glm::vec2> texCoords;
+        for (const Vertex& vertex : vertices) {
+            positions.push_back(vertex.position);
+            normals.push_back(vertex.normal);
+            texCoords.push_back(vertex.texCoord);
+        }
+        const int position = builder.addAccessor(builder.addView(positions.data(), positions.size() * 12), 0,
+                                                 kFloat, vertices.size(), "VEC3", false, kCubeMinMax);
+        builder.addAccessor(builder.addView(normals.data(), normals.size() * 12), 0, kFloat, vertices.size(), "VEC3");
+        builder.addAccessor(builder.addView(texCoords.data(), texCoords.size() * 8), 0, kFloat, vertices.size(),
+                            "VEC2");
+        return position;
+    }
+
+    std::string separateAttributes(int position) {
+        return "{\"POSITION\":" + std::to_string(position) + ",\"NORMAL\":" + std::to_string(position + 1) +
+               ",\"TEXCOORD_0\":" + std::to_string(position + 2) + "}";
+    }
+
+    const std::string kSingleMeshScene = "\"scene\":0,\"scenes\":[{\"nodes\":[0]}],\"nodes\":[{\"mesh\":0}]";
+
+    int writeCorpus(const std::filesystem::path& directory) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        makeCube(vertices, indices);
+        bool ok = true;
+
+        // Vertex layout with two materials, written by writeGlbFile: used in place
+        {
+            const std::vector<uint16_t> shortIndices = narrow<uint16_t>(indices);
+            Submesh submeshes[2] = {};
+            submeshes[0].indexCount = 18;
+            submeshes[0].materialIndex = 0;
+            submeshes[1].indexOffset = 18;
+            submeshes[1].indexCount = 18;
+            submeshes[1].materialIndex = 1;
+            MeshMaterial materials[2] = {};
+            materials[0].diffuseColor = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
+            materials[0].specularPower = 30.0f;
+            materials[1].diffuseColor = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+            materials[1].specularPower = 30.0f;
+            // Texture paths are relative to the working directory, like the ones OBJ materials produce
+            const std::string texture = (directory / "textures/blue image.png").generic_string();
+            std::vector<char> strings = {'\0', 'b', 'l', 'u', 'e', '\0'};
+            strings.insert(strings.end(), texture.begin(), texture.end());
+            strings.push_back('\0');
+            materials[1].nameOffset = 1;
+            materials[1].diffuseTextureOffset = 6;
+            MeshView view;
+            view.vertices = vertices.data();
+            view.vertexCount = vertices.size();
+            view.indices = shortIndices.data();
+            view.indexCount = shortIndices.size();
+            view.indexSize = 2;
+            view.submeshes = submeshes;
+            view.submeshCount = 2;
+            view.materials = materials;
+            view.materialCount = 2;
+            view.materialStrings = strings.data();
+            view.materialStringsSize = strings.size();
+            ok = writeGlbFile((directory / "interleaved.glb").string(), view, "cube") && ok;
+        }
+
+        // Separate float attributes (no colors) and 16-bit indices: vertices converted, indices in place
+        {
+            GltfBuilder builder;
+            const int position = addSeparateAttributes(builder, vertices);
+            const std::vector<uint16_t> shortIndices = narrow<uint16_t>(indices);
+            const int indexAccessor = builder.addAccessor(builder.addView(shortIndices.data(), shortIndices.size() * 2),
+                                                          0, kUnsignedShort, indices.size(), "SCALAR");
+            ok = builder.write(directory / "separate.glb",
+                               "\"meshes\":[{\"primitives\":[{\"attributes\":" + separateAttributes(position) +
+                               ",\"indices\":" + std::to_string(indexAccessor) + "}]}]," + kSingleMeshScene) && ok;
+        }
+
+        // Normalized 8/16-bit texture coordinates and colors, and 8-bit indices (widened to 16 bits)
+        {
+            struct QuantizedVertex {
+                float position[3];
+                uint16_t texCoord[2];
+                uint8_t color[4];
+            };
+            std::vector<QuantizedVertex> quantized;
+            for (const Vertex& vertex : vertices) {
+                QuantizedVertex q = {};
+                for (int c = 0; c < 3; ++c) {
+                    q.position[c] = vertex.position[c];
+                }
+                for (int c = 0; c < 2; ++c) {
+                    q.texCoord[c] = static_cast<uint16_t>(std::lround(vertex.texCoord[c] * 65535));
+                }
+                for (int c = 0; c < 4; ++c) {
+                    q.color[c] = static_cast<uint8_t>(std::lround(vertex.color[c] * 255));
+                }
+                quantized.push_back(q);
+            }
+            GltfBuilder builder;
+            const int view = builder.addView(quantized.data(), quantized.size() * sizeof(QuantizedVertex),
+                                             sizeof(QuantizedVertex));
+            const int position = builder.addAccessor(view, 0, kFloat, vertices.size(), "VEC3", false, kCubeMinMax);
+            const int texCoord = builder.addAccessor(view, offsetof(QuantizedVertex, texCoord), kUnsignedShort,
+                                                     vertices.size(), "VEC2", true);
+            const int color = builder.addAccessor(view, offsetof(QuantizedVertex, color), kUnsignedByte,
+                                                  vertices.size(), "VEC4", true);
+            std::vector<glm::vec3> normals;
+            for (const Vertex& vertex : vertices) {
+                normals.push_back(vertex.normal);
+            }
+            const int normal = builder.addAccessor(builder.addView(normals.data(), normals.size() * 12), 0, kFloat,
+                                                   vertices.size(), "VEC3");
+            const std::vector<uint8_t> byteIndices = narrow<uint8_t>(indices);
+            const int indexAccessor = builder.addAccessor(builder.addView(byteIndices.data(), byteIndices.size()), 0,
+                                                          kUnsignedByte, indices.size(), "SCALAR");
+            ok = builder.write(directory / "quantized.glb",
+                               "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":" +
+                               std::to_string(position) + ",\"NORMAL\":" + std::to_string(normal) +
+                               ",\"TEXCOORD_0\":" + std::to_string(texCoord) + ",\"COLOR_0\":" +
+                               std::to_string(color) + "},\"indices\":" + std::to_string(indexAccessor) + "}]}]," +
+                               kSingleMeshScene) && ok;
+        }
+
+        // Unindexed triangles without normals: indices generated and normals computed from the faces
+        {
+            std::vector<glm::vec3> positions;
+            std::vector<glm::vec2> texCoords;
+            for (uint32_t index : indices) {
+                positions.push_back(vertices[index].position);
+                texCoords.push_back(vertices[index].texCoord);
+            }
+            GltfBuilder builder;
+            const int position = builder.addAccessor(builder.addView(positions.data(), positions.size() * 12), 0,
+                                                     kFloat, positions.size(), "VEC3", false, kCubeMinMax);
+            const int texCoord = builder.addAccessor(builder.addView(texCoords.data(), texCoords.size() * 8), 0,
+                                                     kFloat, texCoords.size(), "VEC2");
+            ok = builder.write(directory / "unindexed.glb",
+                               "\"meshes\":[{\"primitives\":[{\"attributes\":{\"POSITION\":" +
+                               std::to_string(position) + ",\"TEXCOORD_0\":" + std::to_string(texCoord) + "}}]}]," +
+                               kSingleMeshScene) && ok;
+        }
+
+        // .gltf with an external buffer: two meshes, the second with two primitives sharing their vertices and
+        // 32-bit indices in separate views (copied), placed by a node hierarchy (TRS parent, matrix child)
+        {
+            GltfBuilder builder;
+            const int position = addSeparateAttributes(builder, vertices);
+            const int allIndices = builder.addAccessor(builder.addView(indices.data(), indices.size() * 4), 0,
+                                                       kUnsignedInt, indices.size(), "SCALAR");
+            const int firstHalf = builder.addAccessor(builder.addView(indices.data(), 18 * 4), 0, kUnsignedInt, 18,
+                                                      "SCALAR");
+            const int secondHalf = builder.addAccessor(builder.addView(indices.data() + 18, 18 * 4), 0, kUnsignedInt,
+                                                       18, "SCALAR");
+            const std::string attributes = separateAttributes(position);
+            ok = builder.write(directory / "scene.gltf",
+                               "\"materials\":[{\"name\":\"metal\",\"pbrMetallicRoughness\":{\"baseColorFactor\":"
+                               "[0.5,0.5,0.5,1],\"metallicFactor\":1,\"roughnessFactor\":0.5}}],"
+                               "\"meshes\":[{\"name\":\"whole\",\"primitives\":[{\"attributes\":" + attributes +
+                               ",\"indices\":" + std::to_string(allIndices) + "}]},{\"name\":\"halves\","
+                               "\"primitives\":[{\"attributes\":" + attributes + ",\"indices\":" +
+                               std::to_string(firstHalf) + ",\"material\":0},{\"attributes\":" + attributes +
+                               ",\"indices\":" + std::to_string(secondHalf) + "}]}],"
+                               "\"scene\":0,\"scenes\":[{\"nodes\":[0,2]}],\"nodes\":["
+                               "{\"translation\":[10,0,0],\"rotation\":[0,0.70710678,0,0.70710678],"
+                               "\"children\":[1],\"mesh\":0},"
+                               "{\"matrix\":[2,0,0,0,0,2,0,0,0,0,2,0,0,5,0,1],\"mesh\":1},"
+                               "{\"mesh\":1,\"scale\":[1,1,3]}]",
+                               "scene.bin") && ok;
+        }
+
+        // Invalid: an index past the last vertex, and a truncated binary chunk
+        {
+            std::vector<uint16_t> badIndices = narrow<uint16_t>(indices);
+            badIndices[7] = static_cast<uint16_t>(vertices.size());
+            GltfBuilder builder;
+            const int position = addSeparateAttributes(builder, vertices);
+            const int indexAccessor = builder.addAccessor(builder.addView(badIndices.data(), badIndices.size() * 2), 0,
+                                                          kUnsignedShort, badIndices.size(), "SCALAR");
+            ok = builder.write(directory / "invalid_index.glb",
+                               "\"meshes\":[{\"primitives\":[{\"attributes\":" + separateAttributes(position) +
+                               ",\"indices\":" + std::to_string(indexAccessor) + "}]}]," + kSingleMeshScene) && ok;
+            std::filesystem::copy_file(directory / "separate.glb", directory / "invalid_truncated.glb",
+                                       std::filesystem::copy_options::overwrite_existing, ec);
+            std::filesystem::resize_file(directory / "invalid_truncated.glb",
+                                         std::filesystem::file_size(directory / "separate.glb", ec) - 64, ec);
+            ok = ok && !ec;
+        }
+        if (!ok) {
+            std::cerr << "Failed to write the corpus to " << directory.string() << std::endl;
+            return 1;
+        }
+        printf("Corpus written to %s\n", directory.string().c_str());
+        return 0;
+    }
+
+    // Every triangle corner of the mesh, in submesh order, resolved to its vertex
+    std::vector<Vertex> expandTriangles(const GltfMesh& mesh) {
+        std::vector<Vertex> corners;
+        const MeshView& view = mesh.view;
+        const Vertex* vertices = static_cast<const Vertex*>(view.vertices);
+        for (size_t s = 0; s < view.submeshCount; ++s) {
+            const Submesh& submesh = view.submeshes[s];
+            for (size_t i = 0; i < submesh.indexCount; ++i) {
+                const uint8_t* index = static_cast<const uint8_t*>(view.indices) +
+                                       (submesh.indexOffset + i) * view.indexSize;
+                uint32_t value = 0;
+                memcpy(&value, index, view.indexSize); // Little-endian
+                corners.push_back(vertices[submesh.baseVertex + value]);
+            }
+        }
+        return corners;
+    }
+
+    bool nearlyEqual(const float* a, const float* b, int count, float tolerance) {
+        for (int i = 0; i < count; ++i) {
+            if (std::fabs(a[i] - b[i]) > tolerance) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool matchesCube(const GltfMesh& mesh, const std::vector<Vertex>& expected, bool hasColors, float tolerance) {
+        const std::vector<Vertex> corners = expandTriangles(mesh);
+        if (corners.size() != expected.size()) {
+            return false;
+        }
+        const glm::vec4 white(1.0f);
+        for (size_t i = 0; i < corners.size(); ++i) {
+            const Vertex& a = corners[i];
+            const Vertex& b = expected[i];
+            if (!nearlyEqual(&a.position.x, &b.position.x, 3, tolerance) ||
+                !nearlyEqual(&a.normal.x, &b.normal.x, 3, tolerance) ||
+                !nearlyEqual(&a.texCoord.x, &b.texCoord.x, 2, tolerance) ||
+                !nearlyEqual(&a.color.x, hasColors ? &b.color.x : &white.x, 4, tolerance)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    int checkCorpus(const std::filesystem::path& directory) {
+        std::vector<Vertex> vertices;
+        std::vector<uint32_t> indices;
+        makeCube(vertices, indices);
+        std::vector<Vertex> cube;
+        for (uint32_t index : indices) {
+            cube.push_back(vertices[index]);
+        }
+
+        int failures = 0;
+        auto check = [&](const char* file, bool condition, const char* what) {
+            if (!condition) {
+                std::cerr << file << ": " << what << std::endl;
+                ++failures;
+            }
+        };
+        auto load = [&](const char* file, GltfModel& model) {
+            try {
+                loadGltfFile((directory / file).string(), model);
+                return true;
+            } catch (const std::runtime_error& e) {
+                std::cerr << file << ": " << e.what() << std::endl;
+                ++failures;
+                return false;
+            }
+        };
+
+        GltfModel model;
+        if (load("interleaved.glb", model)) {
+            check("interleaved.glb", model.meshes.size() == 1 && model.instances.size() == 1, "mesh/node count");
+            const GltfMesh& mesh = model.meshes[0];
+            check("interleaved.glb", mesh.zeroCopyVertices && mesh.zeroCopyIndices, "not loaded in place");
+            check("interleaved.glb", mesh.view.indexSize == 2 && mesh.view.submeshCount == 2, "index size/submeshes");
+            check("interleaved.glb", matchesCube(mesh, cube, true, 0.0f), "geometry differs");
+            check("interleaved.glb", model.materials.size() == 2 && mesh.submeshes[1].materialIndex == 1 &&
+                  model.materials[1].diffuseColor == glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), "materials differ");
+            const std::string texture = &model.materialStrings[model.materials[1].diffuseTextureOffset];
+            check("interleaved.glb", texture == (directory / "textures/blue image.png").generic_string(),
+                  "texture path differs");
+        }
+        if (load("separate.glb", model)) {
+            const GltfMesh& mesh = model.meshes[0];
+            check("separate.glb", !mesh.zeroCopyVertices && mesh.zeroCopyIndices, "unexpected zero-copy state");
+            check("separate.glb", matchesCube(mesh, cube, false, 0.0f), "geometry differs");
+        }
+        if (load("quantized.glb", model)) {
+            const GltfMesh& mesh = model.meshes[0];
+            check("quantized.glb", !mesh.zeroCopyIndices && mesh.view.indexSize == 2, "8-bit indices not widened");
+            check("quantized.glb", matchesCube(mesh, cube, true, 1e-6f), "geometry differs");
+        }
+        if (load("unindexed.glb", model)) {
+            const GltfMesh& mesh = model.meshes[0];
+            check("unindexed.glb", mesh.view.indexCount == cube.size(), "indices not generated");
+            check("unindexed.glb", matchesCube(mesh, cube, false, 1e-6f), "geometry or generated normals differ");
+        }
+        if (load("scene.gltf", model)) {
+            check("scene.gltf", model.meshes.size() == 2 && model.instances.size() == 3, "mesh/instance count");
+            if (model.meshes.size() == 2 && model.instances.size() == 3) {
+                const GltfMesh& halves = model.meshes[1];
+                check("scene.gltf", matchesCube(model.meshes[0], cube, false, 0.0f), "mesh 0 geometry differs");
+                check("scene.gltf", matchesCube(halves, cube, false, 0.0f), "mesh 1 geometry differs");
+                check("scene.gltf", halves.submeshes.size() == 2 && halves.submeshes[0].materialIndex == 0 &&
+                      halves.submeshes[1].materialIndex == kNoMaterial && !halves.zeroCopyIndices &&
+                      halves.view.indexSize == 2, "mesh 1 submeshes differ");
+                // Node 1 is the child: translated by (10, 0, 0), turned 90 degrees about y, then scaled by 2 and
+                // moved up 5
+                const glm::vec4 origin = model.instances[1].transform * glm::vec4(0, 0, 0, 1);
+                const glm::vec4 x = model.instances[1].transform * glm::vec4(1, 0, 0, 0);
+                const float expectedOrigin[3] = {10, 5, 0};
+                const float expectedX[3] = {0, 0, -2};
+                check("scene.gltf", model.instances[1].meshIndex == 1 && model.instances[1].nodeIndex == 1 &&
+                      nearlyEqual(&origin.x, expectedOrigin, 3, 1e-5f) && nearlyEqual(&x.x, expectedX, 3, 1e-5f),
+                      "child transform differs");
+                check("scene.gltf", model.instances[2].transform[2][2] == 3.0f, "root scale differs");
+                check("scene.gltf", std::fabs(model.materials[0].specularColor.x - 0.5f) < 1e-6f,
+                      "metallic material differs");
+            }
+        }
+        for (const char* file : {"invalid_index.glb", "invalid_truncated.glb"}) {
+            bool threw = false;
+            try {
+                loadGltfFile((directory / file).string(), model);
+            } catch (const std::runtime_error&) {
+                threw = true;
+            }
+            check(file, threw, "loaded although invalid");
+        }
+        if (failures > 0) {
+            std::cerr << failures << " check(s) failed" << std::endl;
+            return 1;
+        }
+        printf("All corpus checks passed\n");
+        return 0;
+    }
+
+    // --- Tools ---
+
+    MeshImportOptions makeConvertOptions() {
+        MeshImportOptions options;
+        options.useCache = false;
+        options.lods.clear(); // A .glb only holds LOD0
+        return options;
+    }
+
+    int convert(const char* input, const char* output) {
+        ImportedMesh imported;
+        try {
+            importMesh(input, makeConvertOptions(), imported);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        const std::string name = std::filesystem::path(input).stem().string();
+        if (!writeGlbFile(output, imported.view, name)) {
+            std::cerr << "Failed to write " << output << std::endl;
+            return 1;
+        }
+        printf("%zu vertices, %zu indices, %zu submeshes -> %s\n", imported.view.vertexCount,
+               imported.view.indexCount, imported.view.submeshCount, output);
+        return 0;
+    }
+
+    int info(const char* path) {
+        GltfModel model;
+        try {
+            loadGltfFile(path, model);
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        for (size_t i = 0; i < model.meshes.size(); ++i) {
+            const GltfMesh& mesh = model.meshes[i];
+            printf("mesh %zu \"%s\": %zu vertices (%s), %zu x %u-byte indices (%s), %zu submeshes\n", i,
+                   mesh.name.c_str(), mesh.view.vertexCount, mesh.zeroCopyVertices ? "in place" : "converted",
+                   mesh.view.indexCount, mesh.view.indexSize, mesh.zeroCopyIndices ? "in place" : "copied",
+                   mesh.submeshes.size());
+        }
+        for (const GltfInstance& instance : model.instances) {
+            const glm::vec3 translation(instance.transform[3]);
+            printf("node %u: mesh %u at (%g, %g, %g)\n", instance.nodeIndex, instance.meshIndex, translation.x,
+                   translation.y, translation.z);
+        }
+        for (size_t i = 0; i < model.materials.size(); ++i) {
+            const MeshMaterial& material = model.materials[i];
+            printf("material %zu \"%s\": base color texture \"%s\"\n", i,
+                   &model.materialStrings[material.nameOffset], &model.materialStrings[material.diffuseTextureOffset]);
+        }
+        printf("%zu images\n", model.images.size());
+        return 0;
+    }
+
+    // Stands in for the upload: every byte the GPU would receive is copied once
+    size_t stageMesh(const MeshView& view, std::vector<uint8_t>& staging) {
+        const size_t vertexBytes = view.vertexCount * getVertexLayout(view.vertexFormat).stride;
+        const size_t indexBytes = view.indexCount * view.indexSize;
+        staging.resize(vertexBytes + indexBytes);
+        memcpy(staging.data(), view.vertices, vertexBytes);
+        memcpy(staging.data() + vertexBytes, view.indices, indexBytes);
+        return staging.size();
+    }
+
+    int benchmark(int argc, char** argv) {
+        if (argc < 4) {
+            printUsage();
+            return 2;
+        }
+        const std::string objPath = argv[2];
+        const std::string gltfPath = argv[3];
+        int runs = 5;
+        for (int i = 4; i < argc; ++i) {
+            if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+                runs = std::max(1, atoi(argv[++i]));
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+
+        MeshImportOptions fullImport;
+        fullImport.useCache = false;
+        MeshImportOptions minimalImport = makeConvertOptions();
+        minimalImport.optimizeVertexCache = false;
+        minimalImport.optimizeVertexFetch = false;
+        minimalImport.buildMeshlets = false;
+        minimalImport.shortIndices = false;
+
+        std::vector<uint8_t> staging;
+        double fullBest = 1e30;
+        double minimalBest = 1e30;
+        double gltfBest = 1e30;
+        size_t objBytes = 0;
+        size_t gltfBytes = 0;
+        bool zeroCopy = true;
+        try {
+            for (int run = 0; run < runs; ++run) {
+                auto start = std::chrono::steady_clock::now();
+                {
+                    ImportedMesh imported;
+                    importMesh(objPath, fullImport, imported);
+                    objBytes = stageMesh(imported.view, staging);
+                }
+                fullBest = std::min(fullBest, millisecondsSince(start));
+
+                start = std::chrono::steady_clock::now();
+                {
+                    ImportedMesh imported;
+                    importMesh(objPath, minimalImport, imported);
+                    stageMesh(imported.view, staging);
+                }
+                minimalBest = std::min(minimalBest, millisecondsSince(start));
+
+                start = std::chrono::steady_clock::now();
+                {
+                    GltfModel model;
+                    loadGltfFile(gltfPath, model);
+                    gltfBytes = 0;
+                    for (const GltfMesh& mesh : model.meshes) {
+                        gltfBytes += stageMesh(mesh.view, staging);
+                        zeroCopy = zeroCopy && mesh.zeroCopyVertices && mesh.zeroCopyIndices;
+                    }
+                }
+                gltfBest = std::min(gltfBest, millisecondsSince(start));
+            }
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        printf("obj (full import):      %9.2f ms  %.1f MiB\n", fullBest, objBytes / 1048576.0);
+        printf("obj (parse + dedup):    %9.2f ms\n", minimalBest);
+        printf("gltf (%s): %9.2f ms  %.1f MiB  (%.1fx faster than the full import)\n",
+               zeroCopy ? "in place " : "converted", gltfBest, gltfBytes / 1048576.0,
+               gltfBest > 0.0 ? fullBest / gltfBest : 0.0);
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printUsage();
+        return 2;
+    }
+    if (strcmp(argv[1], "convert") == 0 && argc == 4) {
+        return convert(argv[2], argv[3]);
+    }
+    if (strcmp(argv[1], "info") == 0) {
+        return info(argv[2]);
+    }
+    if (strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc, argv);
+    }
+    if (strcmp(argv[1], "corpus") == 0) {
+        return writeCorpus(argv[2]);
+    }
+    if (strcmp(argv[1], "check") == 0) {
+        return checkCorpus(argv[2]);
+    }
+    printUsage();
+    return 2;
+}
@@ -0,0 +1,489 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/FrameScheduler.hpp"
+#include "core/JobSystem.hpp"
+#include "core/RetireQueue.hpp"
+#include "core/Task.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: jobtool check\n"
+            "       jobtool bench [--threads <n>] [--depth <n>] [--runs <n>]\n"
+            "\n"
+            "check: runs millions of nested jobs (each waiting for its children from inside a job), jobs that wait\n"
+            "       on other threads' counters, deque overflow, nested parallelFor and failing jobs at 1, 2, 4\n"
+            "       and 8 threads, and checks that every job ran exactly once; then drives tasks through a\n"
+            "       FrameScheduler polled against a fake fence: waits completing out of order, loads hopping\n"
+            "       between workers and the polling thread, failures, clear() and objects retired in flight\n"
+            "bench: best-of-n time of a job tree (fan-out 8, --depth levels below the root, default 7: 2.4M\n"
+            "       jobs) and of the same number of flat jobs submitted from the main thread, at 1 to n\n"
+            "       threads (default: one per core)\n";
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    constexpr uint32_t kFanOut = 8;
+
+    // Jobs in a tree of the given depth below the root
+    size_t getTreeJobCount(unsigned depth) {
+        size_t count = 1;
+        size_t level = 1;
+        for (unsigned i = 0; i < depth; ++i) {
+            level *= kFanOut;
+            count += level;
+        }
+        return count;
+    }
+
+    // Node id runs, then queues its children (ids numbered level by level, as in a heap) on a counter of its
+    // own and waits for them, so every inner node waits from inside a job
+    void runTreeNode(JobSystem& jobSystem, size_t id, unsigned depth, std::atomic<uint8_t>* runs) {
+        if (runs) {
+            runs[id].fetch_add(1, std::memory_order_relaxed);
+        }
+        if (depth == 0) {
+            return;
+        }
+        JobCounter children;
+        for (uint32_t k = 0; k < kFanOut; ++k) {
+            const size_t child = id * kFanOut + 1 + k;
+            jobSystem.run(children, [&jobSystem, child, depth, runs]() {
+                runTreeNode(jobSystem, child, depth - 1, runs);
+            });
+        }
+        jobSystem.wait(children);
+    }
+
+    // Stands in for a GPU queue: signal() hands out the next fence value, completed is what has executed
+    struct FakeFence {
+        uint64_t signaled = 0;
+        uint64_t completed = 0;
+
+        uint64_t signal() {
+            return ++signaled;
+        }
+    };
+
+    Task<int> waitForFenceValue(FrameScheduler& scheduler, uint64_t fenceValue, int id, std::vector<int>& finished) {
+        co_await scheduler.waitForFence(fenceValue);
+        finished.push_back(id);
+        co_return id;
+    }
+
+    // Shaped like AssetLoader::submitUpload: records on the polling thread, then waits for its own fence value
+    Task<uint64_t> fakeUpload(FrameScheduler& scheduler, FakeFence& fence) {
+        co_await scheduler.nextPoll();
+        const uint64_t fenceValue = fence.signal();
+        co_await scheduler.waitForFence(fenceValue);
+        if (fence.completed < fenceValue) {
+            throw std::runtime_error("resumed before fence value " + std::to_string(fenceValue) + " completed");
+        }
+        co_return fenceValue;
+    }
+
+    // Shaped like AssetLoader::loadMesh: decodes as a job, then uploads
+    Task<uint64_t> fakeLoad(JobSystem& jobSystem, JobCounter& decodeJobs, FrameScheduler& scheduler, FakeFence& fence,
+                            int id) {
+        co_await resumeOn(jobSystem, decodeJobs);
+        if (id % 7 == 3) {
+            throw std::runtime_error("decode " + std::to_string(id));
+        }
+        co_return co_await fakeUpload(scheduler, fence);
+    }
+
+    // Awaits a chain of depth nested tasks, the innermost of which waits for the next poll
+    Task<size_t> nestTasks(FrameScheduler& scheduler, size_t depth) {
+        if (depth == 0) {
+            co_await scheduler.nextPoll();
+            co_return 0;
+        }
+        co_return 1 + co_await nestTasks(scheduler, depth - 1);
+    }
+
+    Task<void> waitForPolls(FrameScheduler& scheduler, int pollCount, int& resumed) {
+        for (int i = 0; i < pollCount; ++i) {
+            co_await scheduler.nextPoll();
+            ++resumed;
+        }
+    }
+
+    // Keeps token in its frame until the task is destroyed
+    Task<void> holdUntilFence(FrameScheduler& scheduler, uint64_t fenceValue, std::shared_ptr<int> token,
+                              bool& resumed) {
+        co_await scheduler.waitForFence(fenceValue);
+        resumed = *token != 0;
+    }
+
+    void checkTasks(const std::function<void(bool, const std::string&)>& expect) {
+        // Waits on fence values out of order complete in fence order, ties in the order they were queued
+        {
+            FrameScheduler scheduler;
+            const uint64_t fenceValues[] = {5, 2, 9, 2, 7, 1};
+            std::vector<int> finished;
+            std::vector<Task<int>> tasks;
+            for (int id = 0; id < 6; ++id) {
+                tasks.push_back(waitForFenceValue(scheduler, fenceValues[id], id, finished));
+                tasks.back().start();
+            }
+            bool ok = scheduler.getWaitingCount() == 6 && finished.empty();
+            ok = ok && scheduler.poll(0) == 0 && scheduler.poll(2) == 3 && finished == std::vector<int>{1, 3, 5};
+            ok = ok && !tasks[0].isDone() && tasks[1].isDone() && tasks[3].isDone() && tasks[5].isDone();
+            ok = ok && scheduler.poll(6) == 1 && scheduler.poll(6) == 0 && scheduler.poll(100) == 2;
+            ok = ok && finished == std::vector<int>{1, 3, 5, 0, 2, 4} && scheduler.getWaitingCount() == 0;
+            for (int id = 0; id < 6; ++id) {
+                ok = ok && tasks[id].isDone() && tasks[id].result() == id;
+            }
+            expect(ok, "tasks waiting on fence values out of order");
+        }
+
+        // A coroutine queuing itself again while resumed waits for the next poll
+        {
+            FrameScheduler scheduler;
+            int resumed = 0;
+            Task<void> task = waitForPolls(scheduler, 3, resumed);
+            task.start();
+            bool ok = true;
+            for (int poll = 1; poll <= 3; ++poll) {
+                ok = ok && scheduler.poll(0) == 1 && resumed == poll && task.isDone() == (poll == 3);
+            }
+            expect(ok && scheduler.poll(0) == 0, "coroutine queued again during a poll");
+        }
+
+        // 100000 nested tasks finish through one poll without growing the stack
+        {
+            FrameScheduler scheduler;
+            Task<size_t> task = nestTasks(scheduler, 100000);
+            task.start();
+            const bool queued = !task.isDone() && scheduler.getWaitingCount() == 1;
+            scheduler.poll(0);
+            expect(queued && task.isDone() && task.result() == 100000, "deep task chain");
+        }
+
+        // Loads decoded on the job system, recorded on the polling thread and completed by a fence that
+        // advances one value per frame, as an application frame loop drives AssetLoader::update()
+        for (unsigned threadCount : {1u, 4u}) {
+            JobSystem jobSystem(threadCount - 1);
+            JobCounter decodeJobs;
+            FrameScheduler scheduler;
+            FakeFence fence;
+            const int loadCount = 64;
+            std::vector<Task<uint64_t>> loads;
+            for (int id = 0; id < loadCount; ++id) {
+                loads.push_back(fakeLoad(jobSystem, decodeJobs, scheduler, fence, id));
+                loads.back().start();
+            }
+            int frames = 0;
+            auto allDone = [&]() {
+                return std::all_of(loads.begin(), loads.end(), [](const Task<uint64_t>& load) {
+                    return load.isDone();
+                });
+            };
+            for (; !allDone() && frames < 1000000; ++frames) {
+                if (threadCount == 1) {
+                    jobSystem.wait(decodeJobs); // Nobody else runs the decodes
+                } else {
+                    std::this_thread::yield();
+                }
+                scheduler.poll(fence.completed);
+                fence.completed = std::min(fence.signaled, fence.completed + 1);
+            }
+            jobSystem.wait(decodeJobs);
+            std::vector<uint64_t> fenceValues;
+            int failed = 0;
+            bool ok = allDone() && scheduler.getWaitingCount() == 0;
+            for (int id = 0; ok && id < loadCount; ++id) {
+                try {
+                    fenceValues.push_back(loads[id].result());
+                } catch (const std::runtime_error& error) {
+                    ok = strcmp(error.what(), ("decode " + std::to_string(id)).c_str()) == 0;
+                    ++failed;
+                }
+            }
+            std::sort(fenceValues.begin(), fenceValues.end());
+            ok = ok && failed == (loadCount + 3) / 7 && fence.signaled == uint64_t(loadCount - failed);
+            for (size_t i = 0; ok && i < fenceValues.size(); ++i) {
+                ok = fenceValues[i] == i + 1; // Each upload waited for its own fence value
+            }
+            expect(ok, std::to_string(threadCount) + " threads: loads completed through the scheduler after " +
+                   std::to_string(frames) + " frames");
+        }
+
+        // clear() forgets waiting coroutines without resuming them; destroying their tasks frees the frames
+        {
+            FrameScheduler scheduler;
+            std::shared_ptr<int> token = std::make_shared<int>(1);
+            bool resumed = false;
+            {
+                Task<void> task = holdUntilFence(scheduler, 3, token, resumed);
+                task.start();
+                scheduler.clear();
+                scheduler.poll(10);
+            }
+            expect(!resumed && token.use_count() == 1 && scheduler.getWaitingCount() == 0,
+                   "clear() resumed a coroutine or leaked its frame");
+        }
+
+        // Objects retired while the frames that read them are in flight live until their fence value has
+        // completed, while coroutines waiting on the same fence are resumed by the same frame
+        {
+            FrameScheduler scheduler;
+            RetireQueue retired;
+            FakeFence fence;
+            std::vector<std::weak_ptr<int>> objects;
+            std::vector<uint64_t> retiredAt;
+            std::vector<Task<void>> tasks;
+            bool resumed[8] = {};
+            bool ok = true;
+            for (int frame = 0; frame < 8; ++frame) {
+                // The frame reads a new object (e.g. a mesh reloaded this frame), which replaces the last one
+                std::shared_ptr<int> object = std::make_shared<int>(frame + 1);
+                objects.push_back(object);
+                fence.signal(); // This frame's work
+                const uint64_t fenceValue = fence.signal(); // AssetLoader::retire() signals after it
+                tasks.push_back(holdUntilFence(scheduler, fenceValue, std::make_shared<int>(1), resumed[frame]));
+                tasks.back().start();
+                retired.retire(fenceValue, std::move(object));
+                retiredAt.push_back(fenceValue);
+                // The GPU lags three values behind
+                fence.completed = fence.signaled > 3 ? fence.signaled - 3 : 0;
+                scheduler.poll(fence.completed);
+                retired.release(fence.completed);
+                for (int i = 0; i <= frame; ++i) {
+                    const bool complete = retiredAt[i] <= fence.completed;
+                    ok = ok && resumed[i] == complete && tasks[i].isDone() == complete;
+                    ok = ok && objects[i].expired() == complete;
+                }
+            }
+            ok = ok && retired.size() == 2 && scheduler.getWaitingCount() == 2;
+            // Retired out of order: the lower value waits for the one retired before it
+            std::shared_ptr<int> late = std::make_shared<int>(0);
+            std::weak_ptr<int> lateObject = late;
+            retired.retire(fence.completed, std::move(late));
+            ok = ok && retired.release(fence.completed) == 0 && !lateObject.expired();
+            fence.completed = fence.signaled;
+            scheduler.poll(fence.completed);
+            tasks.clear();
+            ok = ok && retired.release(fence.completed) == 3 && retired.size() == 0;
+            for (const std::weak_ptr<int>& object : objects) {
+                ok = ok && object.expired();
+            }
+            expect(ok && lateObject.expired(), "objects retired while frames are in flight");
+        }
+    }
+
+    int check() {
+        int failures = 0;
+        auto expect = [&](bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        };
+        auto countNotOnce = [](const std::atomic<uint8_t>* runs, size_t count) {
+            size_t notOnce = 0;
+            for (size_t i = 0; i < count; ++i) {
+                notOnce += runs[i].load(std::memory_order_relaxed) != 1;
+            }
+            return notOnce;
+        };
+
+        for (unsigned threadCount : {1u, 2u, 4u, 8u}) {
+            JobSystem jobSystem(threadCount - 1);
+            const std::string threads = std::to_string(threadCount) + " threads: ";
+
+            // 2.4M nested jobs: the root runs as a job too, so the main thread only waits
+            {
+                const unsigned depth = 7;
+                const size_t jobCount = getTreeJobCount(depth);
+                std::unique_ptr<std::atomic<uint8_t>[]> runs(new std::atomic<uint8_t>[jobCount]);
+                for (size_t i = 0; i < jobCount; ++i) {
+                    runs[i].store(0, std::memory_order_relaxed);
+                }
+                JobCounter root;
+                jobSystem.run(root, [&]() { runTreeNode(jobSystem, 0, depth, runs.get()); });
+                jobSystem.wait(root);
+                const size_t notOnce = countNotOnce(runs.get(), jobCount);
+                expect(root.isDone() && notOnce == 0, threads + std::to_string(notOnce) + " of " +
+                       std::to_string(jobCount) + " nested jobs did not run exactly once");
+            }
+
+            // Jobs waiting on a counter whose jobs sit in the shared queue (submitted by this thread), plus
+            // one job spawning more children than a worker deque holds
+            {
+                const size_t sharedCount = 2000;
+                const size_t overflowCount = 10000;
+                std::unique_ptr<std::atomic<uint8_t>[]> runs(new std::atomic<uint8_t>[sharedCount + overflowCount]);
+                for (size_t i = 0; i < sharedCount + overflowCount; ++i) {
+                    runs[i].store(0, std::memory_order_relaxed);
+                }
+                JobCounter shared;
+                JobCounter waiters;
+                std::atomic<int> sawDone{0};
+                for (size_t i = 0; i < sharedCount; ++i) {
+                    jobSystem.run(shared, [&runs, i]() { runs[i].fetch_add(1, std::memory_order_relaxed); });
+                    if (i % 100 == 0) {
+                        jobSystem.run(waiters, [&]() {
+                            jobSystem.wait(shared);
+                            sawDone += shared.isDone();
+                        });
+                    }
+                }
+                jobSystem.run(waiters, [&]() {
+                    JobCounter children;
+                    for (size_t i = 0; i < overflowCount; ++i) {
+                        jobSystem.run(children, [&runs, i]() {
+                            runs[sharedCount + i].fetch_add(1, std::memory_order_relaxed);
+                        });
+                    }
+                    jobSystem.wait(children);
+                });
+                jobSystem.wait(waiters);
+                jobSystem.wait(shared);
+                const size_t notOnce = countNotOnce(runs.get(), sharedCount + overflowCount);
+                expect(notOnce == 0 && sawDone == int(sharedCount / 100),
+                       threads + "waits across counters: " + std::to_string(notOnce) + " jobs not run once");
+            }
+
+            // parallelFor inside parallelFor covers every item once
+            {
+                const size_t outer = 300;
+                const size_t inner = 1000;
+                std::unique_ptr<std::atomic<uint8_t>[]> runs(new std::atomic<uint8_t>[outer * inner]);
+                for (size_t i = 0; i < outer * inner; ++i) {
+                    runs[i].store(0, std::memory_order_relaxed);
+                }
+                jobSystem.parallelFor(outer, 1, [&](size_t begin, size_t end) {
+                    for (size_t i = begin; i < end; ++i) {
+                        jobSystem.parallelFor(inner, 16, [&](size_t innerBegin, size_t innerEnd) {
+                            for (size_t j = innerBegin; j < innerEnd; ++j) {
+                                runs[i * inner + j].fetch_add(1, std::memory_order_relaxed);
+                            }
+                        });
+                    }
+                });
+                const size_t notOnce = countNotOnce(runs.get(), outer * inner);
+                expect(notOnce == 0, threads + "nested parallelFor: " + std::to_string(notOnce) +
+                       " items not covered once");
+            }
+
+            // A failing job: its siblings still run, the nested wait rethrows in the parent job, and the
+            // parent's failure reaches the main thread
+            {
+                std::atomic<int> ran{0};
+                bool parentCaught = false;
+                bool rethrown = false;
+                JobCounter root;
+                jobSystem.run(root, [&]() {
+                    JobCounter children;
+                    for (int i = 0; i < 64; ++i) {
+                        jobSystem.run(children, [&ran, i]() {
+                            ran++;
+                            if (i == 17) {
+                                throw std::runtime_error("job 17");
+                            }
+                        });
+                    }
+                    try {
+                        jobSystem.wait(children);
+                    } catch (const std::runtime_error&) {
+                        parentCaught = true;
+                    }
+                    throw std::runtime_error("parent");
+                });
+                try {
+                    jobSystem.wait(root);
+                } catch (const std::runtime_error& error) {
+                    rethrown = strcmp(error.what(), "parent") == 0;
+                }
+                expect(ran == 64 && parentCaught && rethrown, threads + "failing jobs not reported to their waiter");
+            }
+        }
+
+        checkTasks(expect);
+
+        if (failures == 0) {
+            std::cout << "All job system checks passed" << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    int benchmark(int argc, char** argv) {
+        unsigned maxThreadCount = std::max(1u, std::thread::hardware_concurrency());
+        unsigned depth = 7;
+        int runs = 3;
+        for (int i = 2; i < argc; ++i) {
+            const bool hasValue = i + 1 < argc;
+            if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+                maxThreadCount = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+            } else if (strcmp(argv[i], "--depth") == 0 && hasValue) {
+                depth = static_cast<unsigned>(std::clamp(atoi(argv[++i]), 1, 9));
+            } else if (strcmp(argv[i], "--runs") == 0 && hasValue) {
+                runs = std::max(1, atoi(argv[++i]));
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+
+        const size_t jobCount = getTreeJobCount(depth);
+        printf("%zu jobs per run (fan-out %u, depth %u), best of %d\n", jobCount, kFanOut, depth, runs);
+        double treeSingleThreaded = 0.0;
+        double flatSingleThreaded = 0.0;
+        for (unsigned threadCount = 1; threadCount <= maxThreadCount; ++threadCount) {
+            JobSystem jobSystem(threadCount - 1);
+            double tree = 1e30;
+            double flat = 1e30;
+            for (int run = 0; run < runs; ++run) {
+                auto start = std::chrono::steady_clock::now();
+                JobCounter root;
+                jobSystem.run(root, [&]() { runTreeNode(jobSystem, 0, depth, nullptr); });
+                jobSystem.wait(root);
+                tree = std::min(tree, millisecondsSince(start));
+
+                // Every job from the main thread, through the shared queue
+                std::atomic<size_t> sum{0};
+                start = std::chrono::steady_clock::now();
+                JobCounter counter;
+                for (size_t i = 0; i < jobCount; ++i) {
+                    jobSystem.run(counter, [&sum]() { sum.fetch_add(1, std::memory_order_relaxed); });
+                }
+                jobSystem.wait(counter);
+                flat = std::min(flat, millisecondsSince(start));
+            }
+            if (threadCount == 1) {
+                treeSingleThreaded = tree;
+                flatSingleThreaded = flat;
+            }
+            printf("  %2u threads: tree %8.1f ms %7.2f Mjobs/s %5.2fx   flat %8.1f ms %7.2f Mjobs/s %5.2fx\n",
+                   threadCount, tree, jobCount / (tree * 1e3), treeSingleThreaded / tree, flat,
+                   jobCount / (flat * 1e3), flatSingleThreaded / flat);
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc, argv);
+    }
+    if (argc == 2 && strcmp(argv[1], "check") == 0) {
+        return check();
+    }
+    printUsage();
+    return 2;
+}
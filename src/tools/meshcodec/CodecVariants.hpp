@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// MeshCodec compiled a second and third time into the meshcodec tool, for "meshcodec check" to compare the
+// library's decoders against byte for byte. Each namespace has the functions of asset/MeshCodec.hpp.
+
+// Without SIMD: the scalar group decoder and block reconstruction
+namespace ScalarMeshCodec {
+    std::vector<uint8_t> encodeVertexBuffer(const void* vertices, size_t vertexCount, size_t stride);
+    bool decodeVertexBuffer(void* dst, size_t vertexCount, size_t stride, const uint8_t* src, size_t srcSize);
+    std::vector<uint8_t> encodeIndexBuffer(const void* indices, size_t indexCount, size_t indexSize);
+    bool decodeIndexBuffer(void* dst, size_t indexCount, size_t indexSize, const uint8_t* src, size_t srcSize);
+}
+
+// With SSSE3 where the compiler supports it, so the pshufb escape expansion is checked even when the library
+// is built for SSE2 only
+namespace Ssse3MeshCodec {
+    std::vector<uint8_t> encodeVertexBuffer(const void* vertices, size_t vertexCount, size_t stride);
+    bool decodeVertexBuffer(void* dst, size_t vertexCount, size_t stride, const uint8_t* src, size_t srcSize);
+    std::vector<uint8_t> encodeIndexBuffer(const void* indices, size_t indexCount, size_t indexSize);
+    bool decodeIndexBuffer(void* dst, size_t indexCount, size_t indexSize, const uint8_t* src, size_t srcSize);
+}
+
+// Whether Ssse3MeshCodec was built with SSSE3 and this CPU can run it
+bool isSsse3MeshCodecAvailable();
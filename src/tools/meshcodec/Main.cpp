@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "CodecVariants.hpp"
+#include "asset/Lz4.hpp"
+#include "asset/MeshCodec.hpp"
+#include "asset/MeshImport.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: meshcodec [options] <mesh.obj | mesh.meshcache>...\n"
+            "       meshcodec check\n"
+            "Round-trips the vertex and index streams of each mesh through MeshCodec and reports their sizes\n"
+            "(plain, compressed, and with LZ4 on top as in a pack) and the encode and decode throughput.\n"
+            "Exits with 1 if a stream does not decode to the original bytes.\n"
+            "check: round-trips synthetic streams (empty, odd strides and counts, degenerate and scattered\n"
+            "triangles), rejects truncated and damaged ones without writing past the output, and compares the\n"
+            "SIMD decoders byte for byte with the scalar one.\n"
+            "\n"
+            "  --runs <n>           Timed runs per stream, the best is reported (default: 10)\n"
+            "  --compact-vertices   Import OBJ files with kCompactVertexFormat\n"
+            "  --split-positions    Import OBJ files with a separate position stream\n";
+    }
+
+    double secondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    size_t lz4Size(const uint8_t* data, size_t size) {
+        std::vector<uint8_t> compressed(lz4CompressBound(size));
+        const size_t compressedSize = lz4Compress(data, size, compressed.data(), compressed.size());
+        return compressedSize > 0 ? compressedSize : size;
+    }
+
+    // Encodes and decodes one stream runs times; returns false if the decoded bytes differ
+    bool roundTrip(const char* name, const void* data, size_t count, uint32_t elementStride, bool indexStream,
+                   int runs) {
+        if (!data || count == 0) {
+            return true;
+        }
+        const size_t size = count * elementStride;
+        std::vector<uint8_t> compressed;
+        std::vector<uint8_t> decoded(size);
+        double encodeBest = 1e30;
+        double decodeBest = 1e30;
+        bool ok = true;
+        for (int run = 0; run < runs && ok; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            compressed = indexStream ? encodeIndexBuffer(data, count, elementStride)
+                                     : encodeVertexBuffer(data, count, elementStride);
+            encodeBest = std::min(encodeBest, secondsSince(start));
+            if (compressed.empty()) {
+                std::cerr << name << ": cannot be compressed (element size " << elementStride << ")" << std::endl;
+                return false;
+            }
+
+            memset(decoded.data(), 0, decoded.size());
+            start = std::chrono::steady_clock::now();
+            ok = indexStream ? decodeIndexBuffer(decoded.data(), count, elementStride, compressed.data(),
+                                                 compressed.size())
+                             : decodeVertexBuffer(decoded.data(), count, elementStride, compressed.data(),
+                                                  compressed.size());
+            decodeBest = std::min(decodeBest, secondsSince(start));
+            ok = ok && memcmp(decoded.data(), data, size) == 0;
+        }
+        if (!ok) {
+            std::cerr << name << ": decoded stream differs from the original" << std::endl;
+            return false;
+        }
+        const size_t lz4Plain = lz4Size(static_cast<const uint8_t*>(data), size);
+        const size_t lz4Compressed = lz4Size(compressed.data(), compressed.size());
+        printf("  %-12s %10zu x %-3u %9.2f MiB  codec %5.1f%%  codec+lz4 %5.1f%%  lz4 %5.1f%%  "
+               "encode %6.0f MB/s  decode %6.2f GB/s\n",
+               name, count, elementStride, size / 1048576.0, 100.0 * compressed.size() / size,
+               100.0 * lz4Compressed / size, 100.0 * lz4Plain / size, size / encodeBest / 1e6,
+               size / decodeBest / 1e9);
+        return true;
+    }
+
+    // The library's codec and the copies of it in CodecVariants.hpp, built for other instruction sets
+    struct CodecVariant {
+        const char* name;
+        std::vector<uint8_t> (*encodeVertexBuffer)(const void*, size_t, size_t);
+        bool (*decodeVertexBuffer)(void*, size_t, size_t, const uint8_t*, size_t);
+        std::vector<uint8_t> (*encodeIndexBuffer)(const void*, size_t, size_t);
+        bool (*decodeIndexBuffer)(void*, size_t, size_t, const uint8_t*, size_t);
+    };
+
+    using DecodeFunction = bool (*)(void*, size_t, size_t, const uint8_t*, size_t);
+
+    std::vector<CodecVariant> getCodecVariants() {
+        std::vector<CodecVariant> variants = {
+            {"library", encodeVertexBuffer, decodeVertexBuffer, encodeIndexBuffer, decodeIndexBuffer},
+            {"scalar", ScalarMeshCodec::encodeVertexBuffer, ScalarMeshCodec::decodeVertexBuffer,
+             ScalarMeshCodec::encodeIndexBuffer, ScalarMeshCodec::decodeIndexBuffer},
+        };
+        if (isSsse3MeshCodecAvailable()) {
+            variants.push_back({"ssse3", Ssse3MeshCodec::encodeVertexBuffer, Ssse3MeshCodec::decodeVertexBuffer,
+                                Ssse3MeshCodec::encodeIndexBuffer, Ssse3MeshCodec::decodeIndexBuffer});
+        }
+        return variants;
+    }
+
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // Vertices whose bytes cover every group width: per 32-bit component one byte is random, one steps by at
+    // most 1, one by at most 6 and one is constant (which byte is which rotates across components). With spikes,
+    // the stepping bytes also need escapes. random makes every byte random, constant every byte the same.
+    enum class VertexPattern { Mixed, Spiky, Random, Constant };
+
+    std::vector<uint8_t> makeVertices(size_t vertexCount, size_t stride, VertexPattern pattern, uint32_t seed) {
+        std::vector<uint8_t> vertices(vertexCount * stride);
+        std::vector<uint8_t> last(stride, 0x3F);
+        for (size_t i = 0; i < vertexCount; ++i) {
+            for (size_t k = 0; k < stride; ++k) {
+                const size_t kind = (k + k / 4) % 4;
+                uint8_t value = last[k];
+                if (pattern == VertexPattern::Random || (pattern != VertexPattern::Constant && kind == 0)) {
+                    value = static_cast<uint8_t>(nextRandom(seed));
+                } else if (pattern == VertexPattern::Spiky && kind != 3 && nextRandom(seed) % 24 == 0) {
+                    value = static_cast<uint8_t>(value + 100 + nextRandom(seed) % 56);
+                } else if (pattern != VertexPattern::Constant && kind == 1) {
+                    value = static_cast<uint8_t>(value + nextRandom(seed) % 3 - 1);
+                } else if (pattern != VertexPattern::Constant && kind == 2) {
+                    value = static_cast<uint8_t>(value + nextRandom(seed) % 13 - 6);
+                }
+                vertices[i * stride + k] = value;
+                last[k] = value;
+            }
+        }
+        return vertices;
+    }
+
+    // Triangles a grid of width x height quads yields in row order, which mostly hit the edge FIFO
+    std::vector<uint32_t> makeGridIndices(uint32_t width, uint32_t height) {
+        std::vector<uint32_t> indices;
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint32_t v = y * (width + 1) + x;
+                indices.insert(indices.end(), {v, v + width + 1, v + 1, v + 1, v + width + 1, v + width + 2});
+            }
+        }
+        return indices;
+    }
+
+    std::vector<uint8_t> toIndexBytes(const std::vector<uint32_t>& indices, size_t indexSize) {
+        std::vector<uint8_t> bytes(indices.size() * indexSize);
+        for (size_t i = 0; i < indices.size(); ++i) {
+            if (indexSize == sizeof(uint16_t)) {
+                const auto index = static_cast<uint16_t>(indices[i]);
+                memcpy(bytes.data() + i * indexSize, &index, indexSize);
+            } else {
+                memcpy(bytes.data() + i * indexSize, &indices[i], indexSize);
+            }
+        }
+        return bytes;
+    }
+
+    // Decodes from a copy of the first srcSize bytes of the stream that is exactly that large, into a buffer
+    // followed by guard bytes: writing past the output changes the guard, reading past the input trips ASan
+    bool decodeGuarded(DecodeFunction decode, const std::vector<uint8_t>& stream, size_t srcSize, size_t count,
+                       size_t elementSize, std::vector<uint8_t>& outData, bool& outGuardIntact) {
+        const std::vector<uint8_t> input(stream.begin(), stream.begin() + srcSize);
+        const size_t size = count * elementSize;
+        std::vector<uint8_t> output(size + 64, 0xA5);
+        const bool decoded = decode(output.data(), count, elementSize, input.data(), input.size());
+        outGuardIntact = std::all_of(output.begin() + size, output.end(), [](uint8_t b) { return b == 0xA5; });
+        outData.assign(output.begin(), output.begin() + size);
+        return decoded;
+    }
+
+    int check() {
+        int failures = 0;
+        auto expect = [&](bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        };
+        const std::vector<CodecVariant> variants = getCodecVariants();
+
+        // Encodes with the library, checks every variant encodes the same bytes and decodes them back to data
+        auto checkStream = [&](const std::string& what, const std::vector<uint8_t>& data, size_t count,
+                               size_t elementSize, bool indexStream) {
+            const std::vector<uint8_t> stream = indexStream ? encodeIndexBuffer(data.data(), count, elementSize)
+                                                            : encodeVertexBuffer(data.data(), count, elementSize);
+            if (stream.empty()) {
+                expect(false, what + ": not encoded");
+                return stream;
+            }
+            for (const CodecVariant& variant : variants) {
+                const std::vector<uint8_t> encoded =
+                    indexStream ? variant.encodeIndexBuffer(data.data(), count, elementSize)
+                                : variant.encodeVertexBuffer(data.data(), count, elementSize);
+                expect(encoded == stream, what + ": " + variant.name + " encodes differently");
+                std::vector<uint8_t> decoded;
+                bool guardIntact = false;
+                const DecodeFunction decode = indexStream ? variant.decodeIndexBuffer : variant.decodeVertexBuffer;
+                expect(decodeGuarded(decode, stream, stream.size(), count, elementSize, decoded, guardIntact) &&
+                       guardIntact && decoded == data, what + ": " + variant.name + " decodes differently");
+            }
+            return stream;
+        };
+
+        // Truncations are rejected and damage never writes past the output; where the variants accept damaged
+        // data, they decode it to the same bytes
+        auto checkDamage = [&](const std::string& what, const std::vector<uint8_t>& stream, size_t count,
+                               size_t elementSize, bool indexStream, uint32_t seed) {
+            std::vector<uint8_t> decoded;
+            std::vector<uint8_t> reference;
+            bool guardIntact = false;
+            bool truncationsRejected = true;
+            const size_t step = std::max<size_t>(1, stream.size() / 500);
+            for (const CodecVariant& variant : variants) {
+                const DecodeFunction decode = indexStream ? variant.decodeIndexBuffer : variant.decodeVertexBuffer;
+                for (size_t cut = 0; cut < stream.size(); cut += (stream.size() - cut <= 64 ? 1 : step)) {
+                    truncationsRejected = truncationsRejected &&
+                        !decodeGuarded(decode, stream, cut, count, elementSize, decoded, guardIntact) && guardIntact;
+                }
+            }
+            expect(truncationsRejected, what + ": a truncated stream decoded or wrote past the output");
+
+            bool guardsIntact = true;
+            bool variantsAgree = true;
+            for (int i = 0; i < 300; ++i) {
+                std::vector<uint8_t> damaged = stream;
+                const int flips = 1 + static_cast<int>(nextRandom(seed) % 3);
+                for (int flip = 0; flip < flips; ++flip) {
+                    damaged[nextRandom(seed) % damaged.size()] ^= static_cast<uint8_t>(1 + nextRandom(seed) % 255);
+                }
+                bool referenceDecoded = false;
+                for (size_t v = 0; v < variants.size(); ++v) {
+                    const DecodeFunction decode =
+                        indexStream ? variants[v].decodeIndexBuffer : variants[v].decodeVertexBuffer;
+                    const bool decodedOk =
+                        decodeGuarded(decode, damaged, damaged.size(), count, elementSize, decoded, guardIntact);
+                    guardsIntact = guardsIntact && guardIntact;
+                    if (v == 0) {
+                        referenceDecoded = decodedOk;
+                        reference = decoded;
+                    } else {
+                        variantsAgree = variantsAgree && decodedOk == referenceDecoded &&
+                                        (!decodedOk || decoded == reference);
+                    }
+                }
+            }
+            expect(guardsIntact, what + ": a damaged stream wrote past the output");
+            expect(variantsAgree, what + ": variants disagree on a damaged stream");
+        };
+
+        // Vertices: strides that are multiples of 4 but not of 16, counts around the group size (16) and the
+        // block size, and an empty and a single vertex
+        const size_t strides[] = {4, 8, 12, 16, 20, 28, 36, 44, 52, 64, 100, 124, 252, 256};
+        for (size_t stride : strides) {
+            const size_t blockVertexCount = std::min<size_t>(256, (8192 / stride) & ~size_t(15));
+            const size_t counts[] = {0, 1, 2, 15, 16, 17, 31, 33, blockVertexCount - 1, blockVertexCount,
+                                     blockVertexCount + 1, blockVertexCount * 3 + 7, 1000};
+            for (size_t count : counts) {
+                for (VertexPattern pattern : {VertexPattern::Mixed, VertexPattern::Spiky, VertexPattern::Random,
+                                              VertexPattern::Constant}) {
+                    const uint32_t seed = static_cast<uint32_t>(stride * 7919 + count * 31 + size_t(pattern));
+                    const std::vector<uint8_t> vertices = makeVertices(count, stride, pattern, seed);
+                    checkStream("vertices " + std::to_string(count) + " x " + std::to_string(stride) + " pattern " +
+                                std::to_string(int(pattern)), vertices, count, stride, false);
+                }
+            }
+        }
+        const uint8_t oneVertex[kMaxVertexCodecStride + 4] = {};
+        for (size_t stride : {size_t(0), size_t(2), size_t(6), size_t(18), kMaxVertexCodecStride + 4}) {
+            std::vector<uint8_t> decoded(kMaxVertexCodecStride + 4);
+            const std::vector<uint8_t> stream = encodeVertexBuffer(oneVertex, 1, 4);
+            expect(encodeVertexBuffer(oneVertex, 1, stride).empty() &&
+                   !decodeVertexBuffer(decoded.data(), 1, stride, stream.data(), stream.size()),
+                   "vertex stride " + std::to_string(stride) + " accepted");
+        }
+        for (size_t stride : {size_t(12), size_t(36)}) {
+            const std::vector<uint8_t> vertices = makeVertices(300, stride, VertexPattern::Spiky, uint32_t(stride));
+            const std::vector<uint8_t> stream = encodeVertexBuffer(vertices.data(), 300, stride);
+            checkDamage("vertices 300 x " + std::to_string(stride), stream, 300, stride, false, uint32_t(stride));
+        }
+
+        // Indices: empty, single and degenerate triangles, triangle counts around the 4 rotations per byte,
+        // vertex reuse the FIFOs mostly hit and mostly miss, and explicit indices far apart
+        std::vector<std::pair<std::string, std::vector<uint32_t>>> indexLists = {
+            {"empty", {}},
+            {"one triangle", {0, 1, 2}},
+            {"one rotated triangle", {2, 0, 1}},
+            {"degenerate", {0, 0, 0, 0, 0, 1, 1, 0, 0, 2, 2, 2, 0, 1, 2, 0, 1, 2, 2, 1, 1}},
+            {"grid", makeGridIndices(40, 30)},
+        };
+        for (uint32_t triangles = 2; triangles <= 5; ++triangles) {
+            std::vector<uint32_t> strip;
+            for (uint32_t t = 0; t < triangles; ++t) {
+                strip.insert(strip.end(), {t, t + 1, t + 2});
+            }
+            indexLists.push_back({std::to_string(triangles) + " strip triangles", strip});
+        }
+        std::vector<uint32_t> scattered;
+        std::vector<uint32_t> nearMisses;
+        std::vector<uint32_t> farApart;
+        uint32_t seed = 77;
+        for (uint32_t t = 0; t < 2000; ++t) {
+            scattered.insert(scattered.end(), {nextRandom(seed) % 60000, nextRandom(seed) % 60000,
+                                               nextRandom(seed) % 60000});
+            // Reuses vertices of triangles 14 to 20 back, just out of reach of the FIFOs
+            const uint32_t back = t >= 20 ? 14 + nextRandom(seed) % 7 : 0;
+            nearMisses.insert(nearMisses.end(), {t * 3, t >= 20 ? (t - back) * 3 + 1 : t * 3 + 1, t * 3 + 2});
+            farApart.insert(farApart.end(), {t % 2 ? 65535u : 0u, t % 3 ? 0xFFFFFFFFu : 1u, 32768u + t});
+        }
+        indexLists.push_back({"scattered", scattered});
+        indexLists.push_back({"near misses", nearMisses});
+        indexLists.push_back({"far apart", farApart});
+        std::vector<uint32_t> reversed = makeGridIndices(20, 20);
+        std::reverse(reversed.begin(), reversed.end());
+        indexLists.push_back({"reversed grid", reversed});
+
+        for (size_t indexSize : {sizeof(uint16_t), sizeof(uint32_t)}) {
+            for (const auto& [name, indices] : indexLists) {
+                const std::string what = std::to_string(indexSize * 8) + "-bit indices " + name;
+                const std::vector<uint8_t> bytes = toIndexBytes(indices, indexSize);
+                const std::vector<uint8_t> stream = checkStream(what, bytes, indices.size(), indexSize, true);
+                if (!stream.empty() && !indices.empty()) {
+                    checkDamage(what, stream, indices.size(), indexSize, true, uint32_t(indices.size()));
+                }
+            }
+        }
+        const uint32_t triangle[4] = {0, 1, 2, 3};
+        const std::vector<uint8_t> triangleStream = encodeIndexBuffer(triangle, 3, sizeof(uint32_t));
+        uint32_t decodedIndices[4] = {};
+        expect(encodeIndexBuffer(triangle, 4, sizeof(uint32_t)).empty() &&
+               encodeIndexBuffer(triangle, 3, 1).empty() &&
+               !decodeIndexBuffer(decodedIndices, 4, sizeof(uint32_t), triangleStream.data(), triangleStream.size()) &&
+               !decodeIndexBuffer(decodedIndices, 3, 8, triangleStream.data(), triangleStream.size()),
+               "index count or size accepted");
+
+        if (failures == 0) {
+            std::cout << "All mesh codec checks passed (" << variants.size() << " decoders)" << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc == 2 && strcmp(argv[1], "check") == 0) {
+        return check();
+    }
+    MeshImportOptions options;
+    options.useCache = false;
+    int runs = 10;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+            runs = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--compact-vertices") == 0) {
+            const bool splitPositions = options.vertexFormat.splitPositions;
+            options.vertexFormat = kCompactVertexFormat;
+            options.vertexFormat.splitPositions = splitPositions;
+        } else if (strcmp(argv[i], "--split-positions") == 0) {
+            options.vertexFormat.splitPositions = true;
+        } else if (argv[i][0] == '-') {
+            printUsage();
+            return 2;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        printUsage();
+        return 2;
+    }
+
+    bool ok = true;
+    for (const std::string& file : files) {
+        ImportedMesh mesh;
+        DecodedMeshStreams decoded;
+        try {
+            if (file.size() > 10 && file.compare(file.size() - 10, 10, ".meshcache") == 0) {
+                if (!mesh.cache.open(file)) {
+                    throw std::runtime_error("Not a valid mesh cache: " + file);
+                }
+                mesh.view = mesh.cache.getView();
+                if (!decodeMeshStreams(mesh.view, decoded)) {
+                    throw std::runtime_error("Corrupt compressed stream in " + file);
+                }
+            } else {
+                importMesh(file, options, mesh);
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            ok = false;
+            continue;
+        }
+        const MeshView& view = mesh.view;
+        const VertexLayout layout = getVertexLayout(view.vertexFormat);
+        printf("%s\n", file.c_str());
+        ok = roundTrip("vertices", view.vertices, view.vertexCount, layout.stride, false, runs) && ok;
+        ok = roundTrip("positions", view.positions, view.vertexCount, layout.positionStride, false, runs) && ok;
+        ok = roundTrip("indices", view.indices, view.indexCount, view.indexSize, true, runs) && ok;
+        ok = roundTrip("lod indices", view.lodIndices, view.lodIndexCount, view.indexSize, true, runs) && ok;
+    }
+    return ok ? 0 : 1;
+}
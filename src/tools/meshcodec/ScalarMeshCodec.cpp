@@ -0,0 +1,14 @@
+#include "CodecVariants.hpp"
+
+// Everything MeshCodec.cpp includes, so none of it is included inside the namespace below
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#include "asset/MeshCodec.hpp"
+
+#define MESH_CODEC_NO_SIMD 1
+namespace ScalarMeshCodec {
+#include "asset/MeshCodec.cpp"
+}
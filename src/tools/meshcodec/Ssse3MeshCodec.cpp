@@ -0,0 +1,27 @@
+#include "CodecVariants.hpp"
+
+// Everything MeshCodec.cpp includes, so none of it is included inside the namespace below
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <tmmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#endif
+
+#include "asset/MeshCodec.hpp"
+
+// CMakeLists.txt adds -mssse3 for this file on GCC and Clang; elsewhere this is the library's own SIMD path
+namespace Ssse3MeshCodec {
+#include "asset/MeshCodec.cpp"
+}
+
+bool isSsse3MeshCodecAvailable() {
+#if defined(__SSSE3__) && (defined(__GNUC__) || defined(__clang__))
+    return __builtin_cpu_supports("ssse3");
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,318 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "asset/MipGenerator.hpp"
+#include "asset/TextureImport.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: mipgen check\n"
+            "       mipgen bench [--size <n>] [--runs <n>] [-j <threads>]\n"
+            "\n"
+            "check: golden tests of the mip filters: exact results on constant and checkerboard images (which\n"
+            "       show whether the filtering is gamma-correct), non-power-of-two chain sizes, wrapping edges,\n"
+            "       and every filter against a double-precision reference\n"
+            "bench: best-of-n time to generate the full chain of a <n> x <n> texture (default: 2048) with each\n"
+            "       filter, on one thread and on the job system\n";
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const char* getFilterName(MipFilter filter) {
+        switch (filter) {
+            case MipFilter::Box:
+                return "box";
+            case MipFilter::Kaiser:
+                return "kaiser";
+            case MipFilter::Lanczos:
+                return "lanczos";
+        }
+        return "?";
+    }
+
+    constexpr MipFilter kFilters[] = {MipFilter::Box, MipFilter::Kaiser, MipFilter::Lanczos};
+
+    // Deterministic noise, so failures reproduce
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    TextureImage makeImage(uint32_t width, uint32_t height, uint32_t seed) {
+        TextureImage image;
+        image.width = width;
+        image.height = height;
+        image.pixels.resize(size_t(width) * height * 4);
+        for (uint8_t& value : image.pixels) {
+            value = static_cast<uint8_t>(nextRandom(seed));
+        }
+        return image;
+    }
+
+    // --- Double-precision reference: the same definition of each filter, written for clarity ---
+
+    constexpr double kPi = 3.14159265358979323846;
+
+    double referenceKernel(MipFilter filter, double x) {
+        auto sinc = [](double v) {
+            return v == 0.0 ? 1.0 : std::sin(kPi * v) / (kPi * v);
+        };
+        auto besselI0 = [](double v) {
+            double sum = 0.0;
+            double factorial = 1.0;
+            for (int k = 0; k < 40; k++) {
+                factorial *= k > 0 ? k : 1;
+                sum += std::pow(v / 2.0, 2.0 * k) / (factorial * factorial);
+            }
+            return sum;
+        };
+        if (std::abs(x) >= 3.0) {
+            return 0.0;
+        }
+        if (filter == MipFilter::Kaiser) {
+            return sinc(x) * besselI0(4.0 * std::sqrt(1.0 - x * x / 9.0)) / besselI0(4.0);
+        }
+        return sinc(x) * sinc(x / 3.0);
+    }
+
+    // Weights of every parent texel for child i, wrapped and normalized
+    std::vector<double> referenceWeights(uint32_t srcSize, uint32_t dstSize, uint32_t i, MipFilter filter) {
+        std::vector<double> weights(srcSize, 0.0);
+        const double scale = double(srcSize) / dstSize;
+        if (srcSize == dstSize) {
+            weights[i] = 1.0;
+            return weights;
+        }
+        if (filter == MipFilter::Box) {
+            for (uint32_t j = 0; j < srcSize; j++) {
+                weights[j] = std::max(0.0, std::min((i + 1) * scale, j + 1.0) - std::max(i * scale, double(j)));
+            }
+        } else {
+            const double center = (i + 0.5) * scale;
+            for (int64_t j = int64_t(center - 3.0 * scale) - 1; j <= int64_t(center + 3.0 * scale) + 1; j++) {
+                const int64_t wrapped = ((j % int64_t(srcSize)) + srcSize) % srcSize;
+                weights[wrapped] += referenceKernel(filter, (j + 0.5 - center) / scale);
+            }
+        }
+        double sum = 0.0;
+        for (double weight : weights) {
+            sum += weight;
+        }
+        for (double& weight : weights) {
+            weight /= sum;
+        }
+        return weights;
+    }
+
+    std::vector<float> referenceResample(const std::vector<float>& src, uint32_t srcWidth, uint32_t srcHeight,
+                                         uint32_t dstWidth, uint32_t dstHeight, MipFilter filter) {
+        std::vector<float> dst(size_t(dstWidth) * dstHeight * 4);
+        for (uint32_t y = 0; y < dstHeight; y++) {
+            const std::vector<double> wy = referenceWeights(srcHeight, dstHeight, y, filter);
+            for (uint32_t x = 0; x < dstWidth; x++) {
+                const std::vector<double> wx = referenceWeights(srcWidth, dstWidth, x, filter);
+                for (int c = 0; c < 4; c++) {
+                    double sum = 0.0;
+                    for (uint32_t sy = 0; sy < srcHeight; sy++) {
+                        for (uint32_t sx = 0; sx < srcWidth; sx++) {
+                            sum += wy[sy] * wx[sx] * src[(size_t(sy) * srcWidth + sx) * 4 + c];
+                        }
+                    }
+                    dst[(size_t(y) * dstWidth + x) * 4 + c] = static_cast<float>(sum);
+                }
+            }
+        }
+        return dst;
+    }
+
+    // --- Golden tests ---
+
+    int check() {
+        int failures = 0;
+        auto expect = [&](bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        };
+        auto levelPixels = [](const TextureImage& image, uint32_t level) {
+            return image.pixels.data() + getMipOffset(image.width, image.height, level);
+        };
+
+        // Chain sizes, with odd and non-square dimensions
+        expect(getMipCount(1, 1) == 1 && getMipCount(2, 1) == 2 && getMipCount(4096, 1) == 13 &&
+               getMipCount(37, 23) == 6 && getMipCount(1024, 1024) == 11, "mip counts");
+        expect(getMipSize(37, 1) == 18 && getMipSize(37, 3) == 4 && getMipSize(23, 4) == 1 && getMipSize(23, 9) == 1,
+               "mip sizes");
+        expect(getMipChainSize(3, 2, 2) == (3 * 2 + 1 * 1) * 4, "chain size");
+
+        for (MipFilter filter : kFilters) {
+            const std::string name = getFilterName(filter);
+            for (bool srgb : {true, false}) {
+                const std::string variant = name + (srgb ? " srgb" : " linear");
+                MipOptions options;
+                options.filter = filter;
+                options.srgb = srgb;
+
+                // A constant image stays exactly constant at every level, whatever the reduction ratio
+                TextureImage constant;
+                constant.width = 37;
+                constant.height = 23;
+                for (size_t i = 0; i < size_t(37) * 23; i++) {
+                    constant.pixels.insert(constant.pixels.end(), {200, 1, 77, 130});
+                }
+                generateMips(constant, options);
+                bool same = constant.mipCount == 6 && constant.pixels.size() == getMipChainSize(37, 23, 6);
+                for (size_t i = 0; same && i < constant.pixels.size(); i += 4) {
+                    same = memcmp(&constant.pixels[i], constant.pixels.data(), 4) == 0;
+                }
+                expect(same, variant + ": constant image");
+
+                // A black and white checkerboard averages to half the light: 188 in sRGB, 128 in linear.
+                // Alpha is always linear.
+                TextureImage checker;
+                checker.width = 64;
+                checker.height = 64;
+                for (uint32_t y = 0; y < 64; y++) {
+                    for (uint32_t x = 0; x < 64; x++) {
+                        const uint8_t value = ((x ^ y) & 1) ? 255 : 0;
+                        checker.pixels.insert(checker.pixels.end(), {value, value, value, value});
+                    }
+                }
+                generateMips(checker, options);
+                const uint8_t* level1 = levelPixels(checker, 1);
+                const int expected = srgb ? 188 : 128;
+                bool gray = true;
+                for (size_t i = 0; i < size_t(32) * 32 * 4; i++) {
+                    const int tolerance = filter == MipFilter::Box ? 0 : 2; // Sinc taps do not balance exactly
+                    gray = gray && std::abs(level1[i] - ((i & 3) == 3 ? 128 : expected)) <= tolerance;
+                }
+                expect(gray, variant + ": checkerboard");
+                const uint8_t* last = levelPixels(checker, checker.mipCount - 1);
+                expect(std::abs(last[0] - expected) <= 1 && std::abs(last[3] - 128) <= 1, variant + ": 1x1 level");
+
+                // Edges wrap: shifting a tiling image by a whole texel of level 3 shifts that level by one
+                TextureImage image = makeImage(64, 64, 7);
+                TextureImage shifted = image;
+                for (uint32_t y = 0; y < 64; y++) {
+                    for (uint32_t x = 0; x < 64; x++) {
+                        memcpy(&shifted.pixels[(size_t(y) * 64 + (x + 8) % 64) * 4],
+                               &image.pixels[(size_t(y) * 64 + x) * 4], 4);
+                    }
+                }
+                generateMips(image, options);
+                generateMips(shifted, options);
+                bool wrapped = true;
+                for (uint32_t y = 0; y < 8; y++) {
+                    for (uint32_t x = 0; x < 8; x++) {
+                        wrapped = wrapped && memcmp(levelPixels(shifted, 3) + (y * 8 + (x + 1) % 8) * 4,
+                                                    levelPixels(image, 3) + (y * 8 + x) * 4, 4) == 0;
+                    }
+                }
+                expect(wrapped, variant + ": wrapping edges");
+            }
+
+            // The SIMD filter matches the double-precision reference for 2:1, odd and 1-texel reductions
+            const uint32_t sizes[][4] = {{16, 16, 8, 8}, {37, 23, 18, 11}, {5, 3, 2, 1}, {9, 1, 4, 1}, {1, 7, 1, 3}};
+            for (const auto& size : sizes) {
+                std::vector<float> src(size_t(size[0]) * size[1] * 4);
+                uint32_t seed = size[0] * 131 + size[1];
+                for (float& value : src) {
+                    value = nextRandom(seed) / float(1u << 24);
+                }
+                std::vector<float> dst(size_t(size[2]) * size[3] * 4);
+                resampleImage(src.data(), size[0], size[1], dst.data(), size[2], size[3], filter);
+                const std::vector<float> reference = referenceResample(src, size[0], size[1], size[2], size[3],
+                                                                       filter);
+                float maxError = 0.0f;
+                for (size_t i = 0; i < dst.size(); i++) {
+                    maxError = std::max(maxError, std::abs(dst[i] - reference[i]));
+                }
+                expect(maxError < 1e-5f, name + ": " + std::to_string(size[0]) + "x" + std::to_string(size[1]) +
+                                             " -> " + std::to_string(size[2]) + "x" + std::to_string(size[3]) +
+                                             " differs from the reference by " + std::to_string(maxError));
+            }
+        }
+
+        // The job system produces the same bytes as a single thread
+        JobSystem jobSystem;
+        TextureImage serial = makeImage(301, 257, 3);
+        TextureImage parallel = serial;
+        generateMips(serial, MipOptions());
+        generateMips(parallel, MipOptions(), &jobSystem);
+        expect(serial.pixels == parallel.pixels, "parallel chain differs from the serial one");
+
+        if (failures == 0) {
+            std::cout << "All mip generation checks passed" << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    int benchmark(int argc, char** argv) {
+        uint32_t size = 2048;
+        int runs = 5;
+        unsigned threadCount = 0;
+        for (int i = 2; i < argc; ++i) {
+            const bool hasValue = i + 1 < argc;
+            if (strcmp(argv[i], "--size") == 0 && hasValue) {
+                size = static_cast<uint32_t>(std::max(1, atoi(argv[++i])));
+            } else if (strcmp(argv[i], "--runs") == 0 && hasValue) {
+                runs = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(argv[i], "-j") == 0 && hasValue) {
+                threadCount = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+
+        const TextureImage source = makeImage(size, size, 1);
+        auto jobSystem = std::make_unique<JobSystem>(threadCount > 0 ? threadCount - 1 : 0);
+        const double texels = double(size) * size;
+        printf("%u x %u, %u mips, %u threads\n", size, size, getMipCount(size, size), jobSystem->getThreadCount());
+        for (MipFilter filter : kFilters) {
+            MipOptions options;
+            options.filter = filter;
+            double serialBest = 1e30;
+            double parallelBest = 1e30;
+            for (int run = 0; run < runs; ++run) {
+                TextureImage image = source;
+                auto start = std::chrono::steady_clock::now();
+                generateMips(image, options);
+                serialBest = std::min(serialBest, millisecondsSince(start));
+
+                image = source;
+                start = std::chrono::steady_clock::now();
+                generateMips(image, options, jobSystem.get());
+                parallelBest = std::min(parallelBest, millisecondsSince(start));
+            }
+            printf("  %-8s 1 thread %9.2f ms (%6.1f Mtexel/s)   jobs %9.2f ms (%6.1f Mtexel/s, %.1fx)\n",
+                   getFilterName(filter), serialBest, texels / serialBest / 1e3, parallelBest,
+                   texels / parallelBest / 1e3, serialBest / parallelBest);
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 2 && strcmp(argv[1], "check") == 0 && argc == 2) {
+        return check();
+    }
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc, argv);
+    }
+    printUsage();
+    return 2;
+}
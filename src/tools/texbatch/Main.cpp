@@ -0,0 +1,260 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asset/TextureBatch.hpp"
+#include "asset/TextureContainer.hpp"
+#include "asset/TextureImport.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: texbatch bench <directory> [--threads <n>] [--budget <MiB>] [--runs <n>] [--cached]\n"
+            "       texbatch check\n"
+            "\n"
+            "bench: decodes every image in the directory (.png, .jpg, .tga, .bmp, .dds, .ktx2) as one batch at 1 to\n"
+            "       n threads (default: one per core) and reports the best-of-n time and peak decoded bytes\n"
+            "       waiting to be handed over. Imports from the source unless --cached, which reads the\n"
+            "       .texcache files (written by the first run).\n"
+            "check: runs batches of fake decoders and checks hand-over, the memory budget, the thread cap and\n"
+            "       failures\n";
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    bool isImageFile(const std::filesystem::path& path) {
+        std::string extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(tolower(c)); });
+        return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" ||
+               extension == ".bmp" || extension == ".dds" || extension == ".ktx2";
+    }
+
+    // Keeps the highest value stored
+    void storeMax(std::atomic<int>& maximum, int value) {
+        int current = maximum.load();
+        while (value > current && !maximum.compare_exchange_weak(current, value)) {
+        }
+    }
+
+    int check() {
+        int failures = 0;
+        auto expect = [&](bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        };
+
+        // Fake decodes sleep, so they overlap on any machine
+        struct Probe {
+            std::atomic<int> decoding{0};
+            std::atomic<int> maxDecoding{0};
+            std::atomic<int> started{0};
+            std::atomic<int> finished{0};
+        };
+        auto makeDecoder = [](Probe& probe, uint64_t bytes, int sleepMilliseconds) {
+            return [&probe, bytes, sleepMilliseconds](size_t index) -> uint64_t {
+                probe.started++;
+                storeMax(probe.maxDecoding, ++probe.decoding);
+                std::this_thread::sleep_for(std::chrono::milliseconds(sleepMilliseconds));
+                probe.decoding--;
+                probe.finished++;
+                if (index % 5 == 3) {
+                    throw std::runtime_error("decode " + std::to_string(index));
+                }
+                return bytes;
+            };
+        };
+
+        for (unsigned threadCount : {1u, 4u}) {
+            JobSystem jobSystem(threadCount - 1);
+            const std::string threads = std::to_string(threadCount) + " threads: ";
+
+            // Every texture handed over once, failures as results
+            {
+                Probe probe;
+                TextureBatch batch(jobSystem, 20, uint64_t(1) << 30, makeDecoder(probe, 100, 2));
+                std::vector<int> handedOver(20);
+                std::vector<TextureBatchResult> finished;
+                while (!batch.isDone()) {
+                    batch.wait(finished);
+                }
+                bool errorsMatch = true;
+                for (const TextureBatchResult& result : finished) {
+                    handedOver[result.index]++;
+                    errorsMatch = errorsMatch && (result.error != nullptr) == (result.index % 5 == 3) &&
+                                  result.bytes == (result.error ? 0 : 100);
+                }
+                expect(finished.size() == 20 && std::count(handedOver.begin(), handedOver.end(), 1) == 20,
+                       threads + "each texture handed over once");
+                expect(errorsMatch, threads + "failures reported with their texture");
+                expect(probe.maxDecoding <= int(threadCount), threads + "more decodes than threads");
+            }
+
+            // Budget: nothing starts while the waiting bytes are over it
+            {
+                Probe probe;
+                TextureBatch batch(jobSystem, 12, 250, makeDecoder(probe, 100, 2));
+                std::vector<TextureBatchResult> finished;
+                while (!batch.isDone()) {
+                    batch.wait(finished);
+                    std::this_thread::sleep_for(std::chrono::milliseconds(5)); // A slow upload stage
+                }
+                expect(batch.getPeakBytes() <= 250 + uint64_t(threadCount) * 100,
+                       threads + "peak of " + std::to_string(batch.getPeakBytes()) + " bytes over the budget");
+            }
+            {
+                Probe probe;
+                TextureBatch batch(jobSystem, 6, 0, makeDecoder(probe, 100, 2));
+                std::vector<TextureBatchResult> finished;
+                while (!batch.isDone()) {
+                    batch.wait(finished);
+                }
+                expect(probe.maxDecoding == 1 && batch.getPeakBytes() == 100 && finished.size() == 6,
+                       threads + "a budget of 0 decodes one texture at a time");
+            }
+
+            // Destroying a batch waits for its running decodes and starts no others
+            {
+                Probe probe;
+                {
+                    TextureBatch batch(jobSystem, 50, uint64_t(1) << 30, makeDecoder(probe, 1, 10));
+                    std::vector<TextureBatchResult> finished;
+                    batch.wait(finished);
+                }
+                const int started = probe.started;
+                expect(started == probe.finished && started < 50, threads + "destroyed batch left decodes");
+            }
+        }
+
+        // Hand-over in completion order: a slow first texture does not hold the others back
+        {
+            JobSystem jobSystem(3);
+            std::atomic<int> order{0};
+            std::vector<int> finishOrder(4);
+            TextureBatch batch(jobSystem, 4, uint64_t(1) << 30, [&](size_t index) -> uint64_t {
+                std::this_thread::sleep_for(std::chrono::milliseconds(index == 0 ? 200 : 5));
+                finishOrder[index] = order++;
+                return 1;
+            });
+            std::vector<TextureBatchResult> finished;
+            while (!batch.isDone()) {
+                batch.poll(finished);
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            expect(finished.size() == 4 && finished.back().index == 0 && finishOrder[0] == 3,
+                   "hand-over not in completion order");
+        }
+
+        if (failures == 0) {
+            std::cout << "All texture batch checks passed" << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    int benchmark(int argc, char** argv) {
+        unsigned maxThreadCount = std::max(1u, std::thread::hardware_concurrency());
+        uint64_t budget = uint64_t(256) << 20;
+        int runs = 3;
+        bool cached = false;
+        for (int i = 3; i < argc; ++i) {
+            const bool hasValue = i + 1 < argc;
+            if (strcmp(argv[i], "--threads") == 0 && hasValue) {
+                maxThreadCount = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+            } else if (strcmp(argv[i], "--budget") == 0 && hasValue) {
+                budget = uint64_t(std::max(0, atoi(argv[++i]))) << 20;
+            } else if (strcmp(argv[i], "--runs") == 0 && hasValue) {
+                runs = std::max(1, atoi(argv[++i]));
+            } else if (strcmp(argv[i], "--cached") == 0) {
+                cached = true;
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+
+        std::vector<std::string> files;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(argv[2], ec)) {
+            if (entry.is_regular_file() && isImageFile(entry.path())) {
+                files.push_back(entry.path().string());
+            }
+        }
+        std::sort(files.begin(), files.end());
+        if (files.empty()) {
+            std::cerr << "No images in " << argv[2] << std::endl;
+            return 1;
+        }
+
+        // Each texture decodes on one thread: the batch is the parallelism
+        TextureImportOptions options;
+        options.useCache = cached;
+        printf("%zu textures, budget %llu MiB, %s\n", files.size(), static_cast<unsigned long long>(budget >> 20),
+               cached ? "from .texcache" : "imported from the sources");
+        double singleThreaded = 0.0;
+        for (unsigned threadCount = 1; threadCount <= maxThreadCount; ++threadCount) {
+            JobSystem jobSystem(threadCount - 1);
+            double best = 1e30;
+            uint64_t peakBytes = 0;
+            uint64_t totalBytes = 0;
+            int failedCount = 0;
+            for (int run = 0; run < runs; ++run) {
+                std::vector<TextureImage> images(files.size());
+                const auto start = std::chrono::steady_clock::now();
+                TextureBatch batch(jobSystem, files.size(), budget, [&](size_t index) -> uint64_t {
+                    ImportedTexture imported;
+                    loadTexture(files[index], options, imported);
+                    images[index] = std::move(imported.image);
+                    return images[index].pixels.size();
+                });
+                std::vector<TextureBatchResult> finished;
+                totalBytes = 0;
+                failedCount = 0;
+                while (!batch.isDone()) {
+                    finished.clear();
+                    batch.wait(finished);
+                    // The upload stage: takes the pixels and frees them
+                    for (const TextureBatchResult& result : finished) {
+                        failedCount += result.error ? 1 : 0;
+                        totalBytes += result.bytes;
+                        images[result.index] = TextureImage();
+                    }
+                }
+                best = std::min(best, millisecondsSince(start));
+                peakBytes = std::max(peakBytes, batch.getPeakBytes());
+            }
+            if (threadCount == 1) {
+                singleThreaded = best;
+            }
+            printf("  %2u threads: %9.1f ms  %7.1f MB/s decoded  %5.2fx  peak %6.1f MiB waiting%s\n", threadCount,
+                   best, totalBytes / (best * 1e3), singleThreaded / best, peakBytes / double(1 << 20),
+                   failedCount ? (", " + std::to_string(failedCount) + " failed").c_str() : "");
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc, argv);
+    }
+    if (argc == 2 && strcmp(argv[1], "check") == 0) {
+        return check();
+    }
+    printUsage();
+    return 2;
+}
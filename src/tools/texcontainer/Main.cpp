@@ -0,0 +1,551 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "asset/BlockCompression.hpp"
+#include "asset/TextureContainer.hpp"
+#include "asset/TextureFootprint.hpp"
+#include "asset/TextureImport.hpp"
+#include "core/JobSystem.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: texcontainer convert <image> <output.dds | output.ktx2> [--format <name>] [--quality <name>]\n"
+            "                            [--no-mips]\n"
+            "       texcontainer info <file.dds | file.ktx2>...\n"
+            "       texcontainer bench <image> [--runs <n>]\n"
+            "       texcontainer check <directory>\n"
+            "\n"
+            "convert: imports the image like assetc (mips, then block compression: --format rgba8, auto\n"
+            "         (default), bc1, bc3, bc5 or bc7; --quality fast, normal (default) or high) and writes it\n"
+            "bench:   best-of-n load times of the same texture decoded from the image (stb_image alone, and\n"
+            "         with mips and compression), read from a .texcache, and parsed from .dds and .ktx2\n"
+            "check:   writes DDS and KTX2 files of every format into <directory> and checks that they parse\n"
+            "         back to the same texels, that malformed and unsupported files are rejected, and that\n"
+            "         getCopyableFootprints follows the D3D12 upload layout rules\n";
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const char* getFormatName(TextureFormat format) {
+        switch (format) {
+            case TextureFormat::Rgba8:
+                return "rgba8";
+            case TextureFormat::Bc1:
+                return "bc1";
+            case TextureFormat::Bc3:
+                return "bc3";
+            case TextureFormat::Bc5:
+                return "bc5";
+            case TextureFormat::Bc7:
+                return "bc7";
+        }
+        return "?";
+    }
+
+    bool hasExtension(const std::string& path, const char* extension) {
+        return std::filesystem::path(path).extension() == extension;
+    }
+
+    bool writeContainer(const std::string& path, const TextureImage& image) {
+        return hasExtension(path, ".ktx2") ? writeKtx2File(path, image) : writeDdsFile(path, image);
+    }
+
+    int convert(int argc, char** argv) {
+        TextureImportOptions options;
+        options.useCache = false;
+        for (int i = 4; i < argc; ++i) {
+            const bool hasValue = i + 1 < argc;
+            if (strcmp(argv[i], "--format") == 0 && hasValue) {
+                const char* name = argv[++i];
+                if (strcmp(name, "rgba8") == 0) {
+                    options.compression = TextureCompression::None;
+                } else if (strcmp(name, "auto") == 0) {
+                    options.compression = TextureCompression::Auto;
+                } else if (strcmp(name, "bc1") == 0) {
+                    options.compression = TextureCompression::Bc1;
+                } else if (strcmp(name, "bc3") == 0) {
+                    options.compression = TextureCompression::Bc3;
+                } else if (strcmp(name, "bc5") == 0) {
+                    options.compression = TextureCompression::Bc5;
+                } else if (strcmp(name, "bc7") == 0) {
+                    options.compression = TextureCompression::Bc7;
+                } else {
+                    printUsage();
+                    return 2;
+                }
+            } else if (strcmp(argv[i], "--quality") == 0 && hasValue) {
+                const char* name = argv[++i];
+                if (strcmp(name, "fast") == 0) {
+                    options.compressionQuality = BlockQuality::Fast;
+                } else if (strcmp(name, "normal") == 0) {
+                    options.compressionQuality = BlockQuality::Normal;
+                } else if (strcmp(name, "high") == 0) {
+                    options.compressionQuality = BlockQuality::High;
+                } else {
+                    printUsage();
+                    return 2;
+                }
+            } else if (strcmp(argv[i], "--no-mips") == 0) {
+                options.generateMips = false;
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+        const std::string output = argv[3];
+        if (!hasExtension(output, ".dds") && !hasExtension(output, ".ktx2")) {
+            printUsage();
+            return 2;
+        }
+        JobSystem jobSystem;
+        options.jobSystem = &jobSystem;
+        TextureImage image;
+        try {
+            image = importTextureFile(argv[2], options);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        if (!writeContainer(output, image)) {
+            std::cerr << "Failed to write " << output << std::endl;
+            return 1;
+        }
+        printf("%s: %u x %u, %u mips, %s, %zu bytes\n", output.c_str(), image.width, image.height, image.mipCount,
+               getFormatName(image.format), image.pixels.size());
+        return 0;
+    }
+
+    int info(int argc, char** argv) {
+        int result = 0;
+        for (int i = 2; i < argc; ++i) {
+            try {
+                const TextureImage image = loadTextureContainer(argv[i]);
+                printf("%s: %u x %u, %u mips, %s, %zu bytes of texels\n", argv[i], image.width, image.height,
+                       image.mipCount, getFormatName(image.format), image.pixels.size());
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << std::endl;
+                result = 1;
+            }
+        }
+        return result;
+    }
+
+    int benchmark(int argc, char** argv) {
+        int runs = 5;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+                runs = std::max(1, atoi(argv[++i]));
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+        const std::string source = argv[2];
+        TextureImportOptions options;
+        options.useCache = false;
+        TextureImportOptions decodeOnly = options;
+        decodeOnly.generateMips = false;
+        decodeOnly.compression = TextureCompression::None;
+
+        // The containers hold what a full import produces, so every path ends with the same texture
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "texcontainer-bench";
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        const std::string ddsPath = (directory / "texture.dds").string();
+        const std::string ktx2Path = (directory / "texture.ktx2").string();
+        const std::string cachePath = (directory / "texture.texcache").string();
+        TextureImage image;
+        try {
+            image = importTextureFile(source, options);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        SourceStamp stamp;
+        if (!writeDdsFile(ddsPath, image) || !writeKtx2File(ktx2Path, image) ||
+            !querySourceStamp(source, stamp, true) ||
+            !writeTextureCache(cachePath, image, stamp, hashTextureImportOptions(options))) {
+            std::cerr << "Failed to write the test files under " << directory.string() << std::endl;
+            return 1;
+        }
+        printf("%s: %u x %u, %u mips, %s, %zu bytes\n", source.c_str(), image.width, image.height, image.mipCount,
+               getFormatName(image.format), image.pixels.size());
+
+        auto measure = [&](const char* name, const std::function<TextureImage()>& load) {
+            double best = 1e30;
+            for (int run = 0; run < runs; ++run) {
+                const auto start = std::chrono::steady_clock::now();
+                const TextureImage loaded = load();
+                best = std::min(best, millisecondsSince(start));
+            }
+            printf("  %-28s %9.2f ms\n", name, best);
+        };
+        measure("stb_image decode", [&] {
+            return importTextureFile(source, decodeOnly);
+        });
+        measure("decode + mips + compression", [&] {
+            return importTextureFile(source, options);
+        });
+        measure(".texcache", [&] {
+            TextureCacheHeader header;
+            TextureImage loaded;
+            if (!readTextureCache(cachePath, header, loaded)) {
+                throw std::runtime_error("Failed to read " + cachePath);
+            }
+            return loaded;
+        });
+        measure(".dds", [&] {
+            return loadTextureContainer(ddsPath);
+        });
+        measure(".ktx2", [&] {
+            return loadTextureContainer(ktx2Path);
+        });
+        return 0;
+    }
+
+    // --- Test suite ---
+
+    // Deterministic noise, so failures reproduce
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    // Random texels are as good as encoded blocks: containers never look inside the payload
+    TextureImage makeImage(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount, uint32_t seed) {
+        TextureImage image;
+        image.width = width;
+        image.height = height;
+        image.mipCount = mipCount;
+        image.format = format;
+        image.pixels.resize(getTextureChainSize(format, width, height, mipCount));
+        for (uint8_t& value : image.pixels) {
+            value = static_cast<uint8_t>(nextRandom(seed));
+        }
+        return image;
+    }
+
+    std::vector<uint8_t> readFile(const std::string& path) {
+        std::vector<uint8_t> bytes;
+        FILE* file = fopen(path.c_str(), "rb");
+        if (!file) {
+            return bytes;
+        }
+        uint8_t buffer[65536];
+        size_t count;
+        while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            bytes.insert(bytes.end(), buffer, buffer + count);
+        }
+        fclose(file);
+        return bytes;
+    }
+
+    void patch32(std::vector<uint8_t>& bytes, size_t offset, uint32_t value) {
+        memcpy(bytes.data() + offset, &value, sizeof(value));
+    }
+
+    void patch64(std::vector<uint8_t>& bytes, size_t offset, uint64_t value) {
+        memcpy(bytes.data() + offset, &value, sizeof(value));
+    }
+
+    // Byte offsets in the files: DDS header fields follow the 4-byte magic, the DX10 header follows them
+    constexpr size_t kDdsFlags = 8;
+    constexpr size_t kDdsWidth = 16;
+    constexpr size_t kDdsMipMapCount = 28;
+    constexpr size_t kDdsPixelFlags = 80;
+    constexpr size_t kDdsFourCC = 84;
+    constexpr size_t kDdsCaps2 = 112;
+    constexpr size_t kDdsDxgiFormat = 128;
+    constexpr size_t kDdsDimension = 132;
+    constexpr size_t kDdsMiscFlag = 136;
+    constexpr size_t kDdsArraySize = 140;
+    constexpr size_t kDdsPayload = 148;
+    constexpr size_t kKtx2VkFormat = 12;
+    constexpr size_t kKtx2PixelDepth = 28;
+    constexpr size_t kKtx2LayerCount = 32;
+    constexpr size_t kKtx2FaceCount = 36;
+    constexpr size_t kKtx2LevelCount = 40;
+    constexpr size_t kKtx2Supercompression = 44;
+    constexpr size_t kKtx2LevelIndex = 80;
+
+    bool sameImage(const TextureImage& a, const TextureImage& b) {
+        return a.width == b.width && a.height == b.height && a.mipCount == b.mipCount && a.format == b.format &&
+               a.pixels == b.pixels;
+    }
+
+    // A legacy DDS (no DX10 header) of the same texels as a DX10 one
+    std::vector<uint8_t> makeLegacyDds(const std::vector<uint8_t>& dx10, uint32_t pixelFlags, uint32_t fourCC,
+                                       const uint32_t masks[5]) {
+        if (dx10.size() < kDdsPayload) {
+            return {};
+        }
+        std::vector<uint8_t> legacy(dx10.begin(), dx10.begin() + 128);
+        legacy.insert(legacy.end(), dx10.begin() + kDdsPayload, dx10.end());
+        patch32(legacy, kDdsPixelFlags, pixelFlags);
+        patch32(legacy, kDdsFourCC, fourCC);
+        for (int i = 0; i < 5; i++) {
+            patch32(legacy, kDdsFourCC + 4 + i * 4, masks ? masks[i] : 0);
+        }
+        return legacy;
+    }
+
+    int check(const std::filesystem::path& directory) {
+        int failures = 0;
+        auto expect = [&](bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        };
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+
+        // --- Upload footprints, against values worked out by hand from the D3D12 rules ---
+        TextureFootprint footprints[16];
+        expect(getCopyableFootprints(TextureFormat::Rgba8, 1, 1, 1, footprints) == 4 &&
+               footprints[0].rowPitch == 256 && footprints[0].rowSize == 4 && footprints[0].rowCount == 1,
+               "footprint of a 1x1 texture: 256-byte pitch, and no padding after the last row");
+        expect(getCopyableFootprints(TextureFormat::Rgba8, 100, 50, 1, footprints) == 512 * 49 + 400 &&
+               footprints[0].rowPitch == 512 && footprints[0].rowSize == 400, "footprint of a 100x50 texture");
+        // 256x256: levels 0-2 end on multiples of 512, level 3 (32 rows of 128 bytes at a 256 pitch) does not
+        const uint64_t total = getCopyableFootprints(TextureFormat::Rgba8, 256, 256, 9, footprints);
+        expect(footprints[1].offset == 262144 && footprints[2].offset == 327680 && footprints[3].offset == 344064 &&
+               footprints[3].rowPitch == 256 && footprints[4].offset == 352256 && footprints[5].offset == 356352 &&
+               footprints[8].offset == 359936 && total == 359936 + 4, "placement of a 256x256 chain");
+        // BC1 8x8: 2x2 blocks, then 1 block per level, the footprint padded to 4x4 texels
+        expect(getCopyableFootprints(TextureFormat::Bc1, 8, 8, 4, footprints) == 1536 + 8 &&
+               footprints[0].rowCount == 2 && footprints[0].rowSize == 16 && footprints[0].rowPitch == 256 &&
+               footprints[1].offset == 512 && footprints[2].offset == 1024 && footprints[2].width == 4 &&
+               footprints[2].height == 4 && footprints[3].offset == 1536 && footprints[3].rowCount == 1,
+               "footprints of a BC1 8x8 chain");
+        getCopyableFootprints(TextureFormat::Bc7, 4096, 2048, 1, footprints);
+        expect(footprints[0].rowSize == 16384 && footprints[0].rowPitch == 16384 && footprints[0].rowCount == 512,
+               "footprint of a BC7 4096x2048 level");
+        getCopyableFootprints(TextureFormat::Bc3, 20, 12, 3, footprints);
+        expect(footprints[0].rowSize == 80 && footprints[0].rowCount == 3 && footprints[1].width == 12 &&
+               footprints[1].height == 8 && footprints[1].rowSize == 48 && footprints[2].rowCount == 1,
+               "footprints of a BC3 20x12 chain");
+
+        // --- Round trips of every format, container and chain shape ---
+        const TextureFormat formats[] = {TextureFormat::Rgba8, TextureFormat::Bc1, TextureFormat::Bc3,
+                                         TextureFormat::Bc5, TextureFormat::Bc7};
+        const uint32_t shapes[][3] = {{64, 32, 7}, {20, 12, 5}, {8, 8, 1}, {12, 4, 2}};
+        uint32_t seed = 1;
+        for (TextureFormat format : formats) {
+            for (const auto& shape : shapes) {
+                const TextureImage image = makeImage(format, shape[0], shape[1], shape[2], seed++);
+                for (const char* extension : {".dds", ".ktx2"}) {
+                    const std::string name = std::string(getFormatName(format)) + "_" + std::to_string(shape[0]) +
+                                             "x" + std::to_string(shape[1]) + extension;
+                    const std::string path = (directory / name).string();
+                    try {
+                        expect(writeContainer(path, image), name + ": write");
+                        expect(sameImage(loadTextureContainer(path), image), name + ": round trip");
+                        ImportedTexture imported; // The runtime's entry point reads containers as they are
+                        loadTexture(path, TextureImportOptions(), imported);
+                        expect(sameImage(imported.image, image), name + ": loadTexture");
+                    } catch (const std::exception& e) {
+                        expect(false, name + ": " + e.what());
+                    }
+                }
+            }
+        }
+
+        // --- DDS variants and malformed files, derived from a valid BC1 64x32 chain ---
+        const std::vector<uint8_t> dds = readFile((directory / "bc1_64x32.dds").string());
+        auto parsesDds = [&](const std::vector<uint8_t>& bytes, TextureContainerView& view) {
+            try {
+                parseDdsFile(bytes.data(), bytes.size(), "test.dds", view);
+                return true;
+            } catch (const std::runtime_error&) {
+                return false;
+            }
+        };
+        auto expectDdsRejected = [&](std::vector<uint8_t> bytes, const std::string& what) {
+            TextureContainerView view;
+            expect(!parsesDds(bytes, view), "DDS " + what + " accepted");
+        };
+        expect(dds.size() == kDdsPayload + getTextureChainSize(TextureFormat::Bc1, 64, 32, 7), "DDS file size");
+        if (dds.size() > kDdsPayload) {
+            TextureContainerView view;
+            const uint32_t rgbaMasks[5] = {32, 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000};
+            const uint32_t bgraMasks[5] = {32, 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000};
+            std::vector<uint8_t> legacy = makeLegacyDds(dds, 0x4, 0x31545844, nullptr); // "DXT1"
+            expect(parsesDds(legacy, view) && view.format == TextureFormat::Bc1 && view.mipCount == 7 &&
+                   memcmp(view.levels[0], dds.data() + kDdsPayload, 256) == 0, "legacy DXT1 DDS");
+            const std::vector<uint8_t> bc5 = readFile((directory / "bc5_64x32.dds").string());
+            legacy = makeLegacyDds(bc5, 0x4, 0x32495441, nullptr); // "ATI2"
+            expect(parsesDds(legacy, view) && view.format == TextureFormat::Bc5, "legacy ATI2 DDS");
+            const std::vector<uint8_t> rgba8 = readFile((directory / "rgba8_64x32.dds").string());
+            legacy = makeLegacyDds(rgba8, 0x41, 0, rgbaMasks);
+            expect(parsesDds(legacy, view) && view.format == TextureFormat::Rgba8, "legacy R8G8B8A8 DDS");
+            expectDdsRejected(makeLegacyDds(rgba8, 0x41, 0, bgraMasks), "with B8G8R8A8 texels");
+            expectDdsRejected(makeLegacyDds(dds, 0x4, 0x33545844, nullptr), "with DXT3 blocks");
+
+            std::vector<uint8_t> bytes = dds;
+            patch32(bytes, kDdsDxgiFormat, 72); // BC1_UNORM_SRGB
+            expect(parsesDds(bytes, view) && view.format == TextureFormat::Bc1, "DDS in an sRGB format");
+            bytes = dds;
+            patch32(bytes, kDdsMipMapCount, 0);
+            patch32(bytes, kDdsFlags, 0x1007); // Neither the count nor its flag: a single level
+            expect(parsesDds(bytes, view) && view.mipCount == 1, "DDS without a mip count");
+            bytes = dds;
+            bytes.resize(kDdsPayload + 64 * 32 / 2); // Level 0 only
+            patch32(bytes, kDdsMipMapCount, 1);
+            expect(parsesDds(bytes, view) && view.mipCount == 1 && view.levels.size() == 1, "DDS of one level");
+
+            bytes = dds;
+            bytes[0] = 'X';
+            expectDdsRejected(bytes, "with a bad magic");
+            expectDdsRejected(std::vector<uint8_t>(dds.begin(), dds.begin() + 100), "with a truncated header");
+            expectDdsRejected(std::vector<uint8_t>(dds.begin(), dds.begin() + 140), "with a truncated DX10 header");
+            expectDdsRejected(std::vector<uint8_t>(dds.begin(), dds.end() - 1), "with truncated texels");
+            bytes = dds;
+            patch32(bytes, 4, 0);
+            expectDdsRejected(bytes, "with a bad header size");
+            bytes = dds;
+            patch32(bytes, kDdsCaps2, 0x200 | 0xFC00);
+            expectDdsRejected(bytes, "cube map");
+            bytes = dds;
+            patch32(bytes, kDdsMiscFlag, 0x4);
+            expectDdsRejected(bytes, "DX10 cube map");
+            bytes = dds;
+            patch32(bytes, kDdsArraySize, 2);
+            expectDdsRejected(bytes, "array");
+            bytes = dds;
+            patch32(bytes, kDdsDimension, 4);
+            expectDdsRejected(bytes, "volume");
+            bytes = dds;
+            patch32(bytes, kDdsDxgiFormat, 10); // R16G16B16A16_FLOAT
+            expectDdsRejected(bytes, "in an unsupported format");
+            bytes = dds;
+            patch32(bytes, kDdsMipMapCount, 8);
+            expectDdsRejected(bytes, "with too many mips");
+            bytes = dds;
+            patch32(bytes, kDdsWidth, 62);
+            expectDdsRejected(bytes, "with BC blocks and a width that is not a multiple of 4");
+        }
+        expectDdsRejected({}, "of no bytes");
+
+        // --- KTX2 variants and malformed files, derived from a valid BC7 64x32 chain ---
+        const std::vector<uint8_t> ktx2 = readFile((directory / "bc7_64x32.ktx2").string());
+        auto parsesKtx2 = [&](const std::vector<uint8_t>& bytes, TextureContainerView& view) {
+            try {
+                parseKtx2File(bytes.data(), bytes.size(), "test.ktx2", view);
+                return true;
+            } catch (const std::runtime_error&) {
+                return false;
+            }
+        };
+        auto expectKtx2Rejected = [&](std::vector<uint8_t> bytes, const std::string& what) {
+            TextureContainerView view;
+            expect(!parsesKtx2(bytes, view), "KTX2 " + what + " accepted");
+        };
+        expect(ktx2.size() > kKtx2LevelIndex + 7 * 24, "KTX2 file size");
+        if (ktx2.size() > kKtx2LevelIndex + 7 * 24) {
+            TextureContainerView view;
+            // The writer stores the smallest level first, as the specification recommends
+            uint64_t level0Offset;
+            uint64_t level6Offset;
+            memcpy(&level0Offset, ktx2.data() + kKtx2LevelIndex, 8);
+            memcpy(&level6Offset, ktx2.data() + kKtx2LevelIndex + 6 * 24, 8);
+            expect(level6Offset < level0Offset && level0Offset % 16 == 0 &&
+                   level0Offset + 64 * 32 == ktx2.size(), "KTX2 level order and alignment");
+
+            std::vector<uint8_t> bytes = ktx2;
+            patch32(bytes, kKtx2VkFormat, 146); // BC7_SRGB_BLOCK
+            expect(parsesKtx2(bytes, view) && view.format == TextureFormat::Bc7, "KTX2 in an sRGB format");
+            bytes = ktx2;
+            patch32(bytes, kKtx2LevelCount, 0);
+            expect(parsesKtx2(bytes, view) && view.mipCount == 1 &&
+                   view.levels[0] == bytes.data() + level0Offset, "KTX2 with a level count of 0");
+            bytes = ktx2;
+            patch32(bytes, kKtx2LayerCount, 1);
+            expect(parsesKtx2(bytes, view), "KTX2 with a layer count of 1");
+
+            bytes = ktx2;
+            bytes[1] = 'X';
+            expectKtx2Rejected(bytes, "with a bad identifier");
+            expectKtx2Rejected(std::vector<uint8_t>(ktx2.begin(), ktx2.begin() + 60), "with a truncated header");
+            expectKtx2Rejected(std::vector<uint8_t>(ktx2.begin(), ktx2.begin() + 120), "with a truncated index");
+            expectKtx2Rejected(std::vector<uint8_t>(ktx2.begin(), ktx2.end() - 1), "with truncated texels");
+            bytes = ktx2;
+            patch32(bytes, kKtx2Supercompression, 2); // Zstandard
+            expectKtx2Rejected(bytes, "with supercompression");
+            bytes = ktx2;
+            patch32(bytes, kKtx2FaceCount, 6);
+            expectKtx2Rejected(bytes, "cube map");
+            bytes = ktx2;
+            patch32(bytes, kKtx2LayerCount, 2);
+            expectKtx2Rejected(bytes, "array");
+            bytes = ktx2;
+            patch32(bytes, kKtx2PixelDepth, 4);
+            expectKtx2Rejected(bytes, "volume");
+            bytes = ktx2;
+            patch32(bytes, kKtx2VkFormat, 109); // R32G32B32A32_SFLOAT
+            expectKtx2Rejected(bytes, "in an unsupported format");
+            bytes = ktx2;
+            patch32(bytes, kKtx2LevelCount, 8);
+            expectKtx2Rejected(bytes, "with too many mips");
+            bytes = ktx2;
+            patch64(bytes, kKtx2LevelIndex, ktx2.size());
+            expectKtx2Rejected(bytes, "with a level past the end");
+            bytes = ktx2;
+            patch64(bytes, kKtx2LevelIndex + 8, 64 * 32 / 2);
+            expectKtx2Rejected(bytes, "with a level of the wrong size");
+        }
+        expectKtx2Rejected({}, "of no bytes");
+
+        // Either parser through the signature, and the file name in the error
+        if (!dds.empty() && !ktx2.empty()) {
+            TextureContainerView view;
+            parseTextureContainer(ktx2.data(), ktx2.size(), "a.ktx2", view);
+            expect(view.format == TextureFormat::Bc7, "parseTextureContainer on KTX2");
+            parseTextureContainer(dds.data(), dds.size(), "a.dds", view);
+            expect(view.format == TextureFormat::Bc1 && view.levels[0] == dds.data() + kDdsPayload,
+                   "parseTextureContainer on DDS");
+        }
+        try {
+            loadTextureContainer((directory / "missing.dds").string());
+            expect(false, "missing file accepted");
+        } catch (const std::runtime_error& e) {
+            expect(strstr(e.what(), "missing.dds") != nullptr, "error without the file name");
+        }
+        expect(isTextureContainerFile("a/B.DDS") && isTextureContainerFile("c.ktx2") &&
+               !isTextureContainerFile("d.ktx") && !isTextureContainerFile("dds"), "container extensions");
+
+        if (failures == 0) {
+            std::cout << "All texture container checks passed" << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc >= 4 && strcmp(argv[1], "convert") == 0) {
+        return convert(argc, argv);
+    }
+    if (argc >= 3 && strcmp(argv[1], "info") == 0) {
+        return info(argc, argv);
+    }
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc, argv);
+    }
+    if (argc == 3 && strcmp(argv[1], "check") == 0) {
+        return check(argv[2]);
+    }
+    printUsage();
+    return 2;
+}
@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "asset/TextureContainer.hpp"
+#include "asset/TextureImport.hpp"
+#include "asset/TextureUpload.hpp"
+
+namespace {
+    void printUsage() {
+        std::cerr <<
+            "Usage: texupload check <directory>\n"
+            "       texupload bench <image> [--runs <n>]\n"
+            "\n"
+            "check: loads textures of every format into a fake upload region with loadTextureForUpload and checks\n"
+            "       each row against the packed chain, the padding left untouched, and a single allocation\n"
+            "bench: best-of-n times and CPU image bytes of loading the texture (through its .texcache, and as a\n"
+            "       .dds) into upload memory via a packed image (the UpdateSubresources path) and directly\n";
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    constexpr uint8_t kPadding = 0xCD;
+
+    // Stands in for a mapped upload buffer: allocated once per load, padding filled with a marker
+    struct FakeUploadRegion {
+        std::vector<uint8_t> bytes;
+        int allocationCount = 0;
+
+        TextureUploadAllocator allocator() {
+            return [this](const TextureUploadLayout& layout) {
+                ++allocationCount;
+                bytes.assign(static_cast<size_t>(layout.size), kPadding);
+                return bytes.data();
+            };
+        }
+    };
+
+    std::vector<const uint8_t*> getLevels(const TextureImage& image) {
+        std::vector<const uint8_t*> levels(image.mipCount);
+        for (uint32_t level = 0; level < image.mipCount; level++) {
+            levels[level] = image.pixels.data() + getTextureLevelOffset(image.format, image.width, image.height, level);
+        }
+        return levels;
+    }
+
+    // Every row in place, every padding byte untouched
+    bool matchesImage(const std::vector<uint8_t>& region, const TextureUploadLayout& layout,
+                      const TextureImage& image) {
+        if (layout.width != image.width || layout.height != image.height || layout.mipCount != image.mipCount ||
+            layout.format != image.format || region.size() != layout.size) {
+            return false;
+        }
+        std::vector<bool> written(region.size());
+        const std::vector<const uint8_t*> levels = getLevels(image);
+        for (uint32_t level = 0; level < layout.mipCount; level++) {
+            const TextureFootprint& footprint = layout.footprints[level];
+            for (uint32_t row = 0; row < footprint.rowCount; row++) {
+                const size_t offset = footprint.offset + size_t(row) * footprint.rowPitch;
+                if (offset + footprint.rowSize > region.size() ||
+                    memcmp(region.data() + offset, levels[level] + row * footprint.rowSize, footprint.rowSize) != 0) {
+                    return false;
+                }
+                std::fill(written.begin() + offset, written.begin() + offset + footprint.rowSize, true);
+            }
+        }
+        for (size_t i = 0; i < region.size(); i++) {
+            if (!written[i] && region[i] != kPadding) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Deterministic noise, so failures reproduce
+    uint32_t nextRandom(uint32_t& state) {
+        state = state * 1664525u + 1013904223u;
+        return state >> 8;
+    }
+
+    TextureImage makeImage(TextureFormat format, uint32_t width, uint32_t height, uint32_t mipCount, uint32_t seed) {
+        TextureImage image;
+        image.width = width;
+        image.height = height;
+        image.mipCount = mipCount;
+        image.format = format;
+        image.pixels.resize(getTextureChainSize(format, width, height, mipCount));
+        for (uint8_t& value : image.pixels) {
+            value = static_cast<uint8_t>(nextRandom(seed));
+        }
+        return image;
+    }
+
+    // Uncompressed 32-bit TGA, top row first, so the import path has a source stb_image decodes
+    bool writeTga(const std::string& path, uint32_t width, uint32_t height, uint32_t seed) {
+        uint8_t header[18] = {};
+        header[2] = 2; // Uncompressed true color
+        header[12] = static_cast<uint8_t>(width);
+        header[13] = static_cast<uint8_t>(width >> 8);
+        header[14] = static_cast<uint8_t>(height);
+        header[15] = static_cast<uint8_t>(height >> 8);
+        header[16] = 32;
+        header[17] = 0x28; // 8 alpha bits, top-left origin
+        std::vector<uint8_t> pixels(size_t(width) * height * 4);
+        for (uint8_t& value : pixels) {
+            value = static_cast<uint8_t>(nextRandom(seed));
+        }
+        FILE* file = fopen(path.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        bool ok = fwrite(header, sizeof(header), 1, file) == 1 &&
+                  fwrite(pixels.data(), 1, pixels.size(), file) == pixels.size();
+        return (fclose(file) == 0) && ok;
+    }
+
+    int check(const std::filesystem::path& directory) {
+        int failures = 0;
+        auto expect = [&](bool condition, const std::string& what) {
+            if (!condition) {
+                std::cerr << "FAILED: " << what << std::endl;
+                ++failures;
+            }
+        };
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+
+        // --- The row-pitch writer on its own ---
+        const TextureFormat formats[] = {TextureFormat::Rgba8, TextureFormat::Bc1, TextureFormat::Bc3,
+                                         TextureFormat::Bc5, TextureFormat::Bc7};
+        const uint32_t shapes[][3] = {{64, 32, 7}, {100, 52, 4}, {20, 12, 5}, {8, 8, 1}, {256, 4, 9}};
+        uint32_t seed = 1;
+        for (TextureFormat format : formats) {
+            for (const auto& shape : shapes) {
+                const TextureImage image = makeImage(format, shape[0], shape[1], shape[2], seed++);
+                const TextureUploadLayout layout = getTextureUploadLayout(format, shape[0], shape[1], shape[2]);
+                std::vector<TextureFootprint> footprints(shape[2]);
+                const uint64_t size = getCopyableFootprints(format, shape[0], shape[1], shape[2], footprints.data());
+                expect(layout.size == size && layout.footprints.size() == shape[2] &&
+                       layout.footprints.back().offset == footprints.back().offset,
+                       "layout of " + std::to_string(shape[0]) + "x" + std::to_string(shape[1]));
+                std::vector<uint8_t> region(static_cast<size_t>(layout.size), kPadding);
+                writeTextureLevels(layout, getLevels(image).data(), region.data());
+                expect(matchesImage(region, layout, image),
+                       "writeTextureLevels of " + std::to_string(shape[0]) + "x" + std::to_string(shape[1]));
+            }
+        }
+
+        // --- Prebuilt containers, straight from the mapped file ---
+        std::string containerPath;
+        for (TextureFormat format : formats) {
+            const TextureImage image = makeImage(format, 100, 52, 7, seed++);
+            for (const char* extension : {".dds", ".ktx2"}) {
+                const std::string path = (directory / ("texture" + std::to_string(seed) + extension)).string();
+                const bool written = extension[1] == 'd' ? writeDdsFile(path, image) : writeKtx2File(path, image);
+                expect(written, path + ": write");
+                containerPath = path;
+                FakeUploadRegion region;
+                TextureUploadLayout layout;
+                try {
+                    expect(!loadTextureForUpload(path, TextureImportOptions(), region.allocator(), layout),
+                           path + ": reported as a cache");
+                    expect(region.allocationCount == 1 && matchesImage(region.bytes, layout, image), path);
+                } catch (const std::exception& e) {
+                    expect(false, path + ": " + e.what());
+                }
+            }
+        }
+
+        // --- Imported, then read back from the cache the import wrote ---
+        for (TextureCompression compression : {TextureCompression::None, TextureCompression::Auto}) {
+            const std::string source = (directory / ("source" + std::to_string(seed) + ".tga")).string();
+            std::filesystem::remove(source + ".texcache", ec);
+            expect(writeTga(source, 96, 40, seed++), source + ": write");
+            TextureImportOptions options;
+            options.compression = compression;
+            try {
+                ImportedTexture expected;
+                TextureImportOptions uncached = options;
+                uncached.useCache = false;
+                loadTexture(source, uncached, expected);
+                FakeUploadRegion imported;
+                TextureUploadLayout layout;
+                expect(!loadTextureForUpload(source, options, imported.allocator(), layout) &&
+                       imported.allocationCount == 1 && matchesImage(imported.bytes, layout, expected.image),
+                       source + ": import");
+                FakeUploadRegion cached;
+                expect(loadTextureForUpload(source, options, cached.allocator(), layout) &&
+                       cached.allocationCount == 1 && matchesImage(cached.bytes, layout, expected.image),
+                       source + ": from the cache");
+                ImportedTexture viaImage; // The packed path reads the same cache
+                loadTexture(source, options, viaImage);
+                expect(viaImage.fromCache && viaImage.image.pixels == expected.image.pixels,
+                       source + ": loadTexture from the cache");
+            } catch (const std::exception& e) {
+                expect(false, source + ": " + e.what());
+            }
+        }
+
+        // --- Failures allocate nothing, and an allocator's exception reaches the caller ---
+        const std::string bad = (directory / "bad.dds").string();
+        FILE* file = fopen(bad.c_str(), "wb");
+        if (file) {
+            fputs("not a texture", file);
+            fclose(file);
+        }
+        for (const std::string& path : {bad, (directory / "missing.png").string()}) {
+            FakeUploadRegion region;
+            TextureUploadLayout layout;
+            try {
+                loadTextureForUpload(path, TextureImportOptions(), region.allocator(), layout);
+                expect(false, path + ": accepted");
+            } catch (const std::runtime_error&) {
+                expect(region.allocationCount == 0, path + ": allocated before failing");
+            }
+        }
+        try {
+            TextureUploadLayout layout;
+            loadTextureForUpload(containerPath, TextureImportOptions(),
+                                 [](const TextureUploadLayout&) -> uint8_t* {
+                                     throw std::runtime_error("out of upload memory");
+                                 }, layout);
+            expect(false, "allocator failure ignored");
+        } catch (const std::runtime_error& e) {
+            expect(strcmp(e.what(), "out of upload memory") == 0, "allocator failure replaced");
+        }
+
+        if (failures == 0) {
+            std::cout << "All texture upload checks passed" << std::endl;
+        }
+        return failures == 0 ? 0 : 1;
+    }
+
+    int benchmark(int argc, char** argv) {
+        int runs = 5;
+        for (int i = 3; i < argc; ++i) {
+            if (strcmp(argv[i], "--runs") == 0 && i + 1 < argc) {
+                runs = std::max(1, atoi(argv[++i]));
+            } else {
+                printUsage();
+                return 2;
+            }
+        }
+        // A copy of the image in a scratch directory gets the sidecar cache
+        const std::filesystem::path directory = std::filesystem::temp_directory_path() / "texupload-bench";
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        const std::filesystem::path source(argv[2]);
+        const std::string imagePath = (directory / source.filename()).string();
+        const std::string ddsPath = (directory / "texture.dds").string();
+        std::filesystem::copy_file(source, imagePath, std::filesystem::copy_options::overwrite_existing, ec);
+        if (ec) {
+            std::cerr << "Failed to copy " << source.string() << " to " << directory.string() << std::endl;
+            return 1;
+        }
+        TextureImportOptions options;
+        ImportedTexture imported;
+        try {
+            loadTexture(imagePath, options, imported); // Writes the cache the runs below read
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        const TextureImage& image = imported.image;
+        if (!writeDdsFile(ddsPath, image)) {
+            std::cerr << "Failed to write " << ddsPath << std::endl;
+            return 1;
+        }
+        const TextureUploadLayout layout = getTextureUploadLayout(image.format, image.width, image.height,
+                                                                  image.mipCount);
+        printf("%s: %u x %u, %u mips, %zu bytes packed, %llu bytes of upload memory\n", source.string().c_str(),
+               image.width, image.height, image.mipCount, image.pixels.size(),
+               static_cast<unsigned long long>(layout.size));
+
+        // The upload memory is allocated and touched once, like a buffer from an upload heap
+        std::vector<uint8_t> uploadMemory(static_cast<size_t>(layout.size), 0);
+        TextureUploadAllocator allocate = [&](const TextureUploadLayout&) {
+            return uploadMemory.data();
+        };
+        for (const std::string& path : {imagePath, ddsPath}) {
+            double viaImage = 1e30;
+            double direct = 1e30;
+            size_t imageBytes = 0;
+            for (int run = 0; run < runs; ++run) {
+                auto start = std::chrono::steady_clock::now();
+                ImportedTexture loaded;
+                loadTexture(path, options, loaded);
+                writeTextureLevels(layout, getLevels(loaded.image).data(), uploadMemory.data());
+                viaImage = std::min(viaImage, millisecondsSince(start));
+                imageBytes = loaded.image.pixels.size();
+
+                start = std::chrono::steady_clock::now();
+                TextureUploadLayout directLayout;
+                loadTextureForUpload(path, options, allocate, directLayout);
+                direct = std::min(direct, millisecondsSince(start));
+            }
+            const char* name = path == ddsPath ? ".dds" : ".texcache";
+            printf("  %-9s via image  %8.2f ms  %10zu bytes of CPU image\n", name, viaImage, imageBytes);
+            printf("  %-9s direct     %8.2f ms  %10d bytes of CPU image\n", name, direct, 0);
+        }
+        return 0;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "check") == 0) {
+        return check(argv[2]);
+    }
+    if (argc >= 3 && strcmp(argv[1], "bench") == 0) {
+        return benchmark(argc, argv);
+    }
+    printUsage();
+    return 2;
+}